@@ -0,0 +1,119 @@
+
+#include "crypto_engine.h"
+#include "openssl_file_suite.h"
+#include "openssl_suite.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ Compare the throughput of the stdio, memory mapped and pipelined implementations of file encryption and decryption
+ 
+ usage: bench_file_suite [max size in MB] [directory]
+ 
+ Files from 1MB up to the max size (default 256MB) are encrypted and decrypted in powers of 2
+ */
+
+#define BENCH_MB (1024ULL * 1024ULL)
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool bench_write_random_file(const char *path, uint64_t size)
+{
+    FILE *handle = fopen(path, "wb");
+    
+    if (!handle) {
+        return false;
+    }
+    
+    wickr_buffer_t *chunk = openssl_crypto_random(BENCH_MB);
+    bool result = chunk != NULL;
+    
+    for (uint64_t written = 0; result && written < size; written += BENCH_MB) {
+        result = fwrite(chunk->bytes, 1, chunk->length, handle) == chunk->length;
+    }
+    
+    wickr_buffer_destroy(&chunk);
+    fclose(handle);
+    
+    return result;
+}
+
+static double bench_rate(uint64_t size, double seconds)
+{
+    return seconds > 0 ? (double)size / BENCH_MB / seconds : 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t max_size_mb = argc > 1 ? strtoull(argv[1], NULL, 10) : 256;
+    const char *directory = argc > 2 ? argv[2] : ".";
+    
+    char plain_path[1024];
+    char cipher_path[1024];
+    char decrypted_path[1024];
+    
+    snprintf(plain_path, sizeof(plain_path), "%s/bench_file_suite.data", directory);
+    snprintf(cipher_path, sizeof(cipher_path), "%s/bench_file_suite.enc", directory);
+    snprintf(decrypted_path, sizeof(decrypted_path), "%s/bench_file_suite.dec", directory);
+    
+    const wickr_crypto_engine_t engine = wickr_crypto_engine_get_default();
+    wickr_cipher_key_t *key = engine.wickr_crypto_engine_cipher_key_random(CIPHER_AES256_GCM);
+    uint64_t default_threshold = openssl_aes256_file_get_mmap_threshold();
+    openssl_file_pipeline_config_t default_pipeline = openssl_aes256_file_get_pipeline_config();
+    openssl_file_pipeline_config_t pipeline = default_pipeline;
+    
+    printf("%10s %16s %16s %16s %16s %16s %16s\n", "size (MB)", "stdio enc MB/s", "mmap enc MB/s", "pipe enc MB/s",
+           "stdio dec MB/s", "mmap dec MB/s", "pipe dec MB/s");
+    
+    for (uint64_t size_mb = 1; size_mb <= max_size_mb; size_mb *= 2) {
+        uint64_t size = size_mb * BENCH_MB;
+        double rates[6] = { 0 };
+        
+        if (!bench_write_random_file(plain_path, size)) {
+            fprintf(stderr, "failed to write %llu MB test file\n", (unsigned long long)size_mb);
+            break;
+        }
+        
+        /* 0 is stdio, 1 is memory mapped and 2 is pipelined */
+        for (int mode = 0; mode < 3; mode++) {
+            pipeline.enabled = mode == 2;
+            openssl_aes256_file_set_pipeline_config(pipeline);
+            openssl_aes256_file_set_mmap_threshold(mode == 1 ? 0 : UINT64_MAX);
+            
+            double start = bench_now();
+            bool encrypted = engine.wickr_crypto_engine_encrypt_file(key, plain_path, cipher_path);
+            double middle = bench_now();
+            bool decrypted = encrypted && engine.wickr_crypto_engine_decrypt_file(key, cipher_path, decrypted_path, true);
+            double end = bench_now();
+            
+            if (!encrypted || !decrypted) {
+                fprintf(stderr, "file operation failed for %llu MB\n", (unsigned long long)size_mb);
+            }
+            
+            rates[mode] = bench_rate(size, middle - start);
+            rates[3 + mode] = bench_rate(size, end - middle);
+            
+            remove(cipher_path);
+            remove(decrypted_path);
+        }
+        
+        printf("%10llu %16.1f %16.1f %16.1f %16.1f %16.1f %16.1f\n", (unsigned long long)size_mb,
+               rates[0], rates[1], rates[2], rates[3], rates[4], rates[5]);
+        
+        remove(plain_path);
+    }
+    
+    openssl_aes256_file_set_mmap_threshold(default_threshold);
+    openssl_aes256_file_set_pipeline_config(default_pipeline);
+    wickr_cipher_key_destroy(&key);
+    
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "crypto_engine.h"
+#include "openssl_file_suite.h"
+#include "openssl_suite.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ Compare the throughput of the plain SHA512 file digest with the SHA512 tree digest using different thread counts
+ 
+ usage: bench_tree_digest [size in MB] [directory]
+ 
+ A single file of the given size (default 512MB) is hashed. It is hashed once before timing so that it is in the page cache
+ */
+
+#define BENCH_MB (1024ULL * 1024ULL)
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static double bench_digest_file(const char *path, wickr_digest_t mode, uint64_t size)
+{
+    const wickr_crypto_engine_t engine = wickr_crypto_engine_get_default();
+    FILE *handle = fopen(path, "rb");
+    
+    if (!handle) {
+        return 0;
+    }
+    
+    double start = bench_now();
+    wickr_buffer_t *digest = engine.wickr_crypto_engine_digest_file(handle, mode);
+    double end = bench_now();
+    
+    fclose(handle);
+    
+    if (!digest) {
+        fprintf(stderr, "digest failed\n");
+        return 0;
+    }
+    
+    wickr_buffer_destroy(&digest);
+    
+    return end > start ? (double)size / BENCH_MB / (end - start) : 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t size_mb = argc > 1 ? strtoull(argv[1], NULL, 10) : 512;
+    const char *directory = argc > 2 ? argv[2] : ".";
+    uint64_t size = size_mb * BENCH_MB;
+    
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/bench_tree_digest.data", directory);
+    
+    FILE *handle = fopen(path, "wb");
+    wickr_buffer_t *chunk = openssl_crypto_random(BENCH_MB);
+    
+    for (uint64_t written = 0; handle && chunk && written < size; written += BENCH_MB) {
+        fwrite(chunk->bytes, 1, chunk->length, handle);
+    }
+    
+    wickr_buffer_destroy(&chunk);
+    
+    if (!handle) {
+        fprintf(stderr, "failed to write test file\n");
+        return 1;
+    }
+    
+    fclose(handle);
+    
+    uint32_t default_threads = openssl_sha2_tree_get_thread_count();
+    uint32_t thread_counts[] = { 1, 2, 4, 8 };
+    
+    bench_digest_file(path, DIGEST_SHA_512, size);
+    printf("%-24s %10.1f MB/s\n", "sha512", bench_digest_file(path, DIGEST_SHA_512, size));
+    
+    for (int i = 0; i < sizeof(thread_counts) / sizeof(uint32_t); i++) {
+        char label[64];
+        snprintf(label, sizeof(label), "sha512 tree %u threads", thread_counts[i]);
+        
+        openssl_sha2_tree_set_thread_count(thread_counts[i]);
+        printf("%-24s %10.1f MB/s\n", label, bench_digest_file(path, DIGEST_SHA_512_TREE, size));
+    }
+    
+    openssl_sha2_tree_set_thread_count(default_threads);
+    remove(path);
+    
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ Compare the throughput of wickr_secure_zero with the volatile byte loop it replaced in wickr_free_zero
+ 
+ usage: bench_zeroize [MB per size]
+ 
+ Each buffer size is cleared repeatedly until the given amount of memory (default 1024MB) has been zeroed
+ */
+
+#define BENCH_MB (1024ULL * 1024ULL)
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* The implementation of wickr_free_zero before wickr_secure_zero, for comparison */
+static void bench_zero_byte_loop(void *buf, size_t len)
+{
+    volatile unsigned char *volatile volatile_buf = (volatile unsigned char * volatile) buf;
+    size_t i = 0;
+    
+    while (i < len) {
+        volatile_buf[i++] = 0;
+    }
+}
+
+static double bench_zero(void (*zero_func)(void *, size_t), uint8_t *buf, size_t len, uint64_t total)
+{
+    uint64_t iterations = total / len;
+    
+    if (iterations == 0) {
+        iterations = 1;
+    }
+    
+    double start = bench_now();
+    
+    for (uint64_t i = 0; i < iterations; i++) {
+        zero_func(buf, len);
+    }
+    
+    double end = bench_now();
+    
+    return end > start ? (double)(iterations * len) / BENCH_MB / (end - start) : 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t total_mb = argc > 1 ? strtoull(argv[1], NULL, 10) : 1024;
+    uint64_t total = total_mb * BENCH_MB;
+    
+    size_t sizes[] = { 32, 4096, 16 * BENCH_MB };
+    const char *labels[] = { "32 B", "4 KB", "16 MB" };
+    
+    uint8_t *buf = malloc(16 * BENCH_MB);
+    
+    if (!buf) {
+        fprintf(stderr, "failed to allocate test buffer\n");
+        return 1;
+    }
+    
+    memset(buf, 0xaa, 16 * BENCH_MB);
+    
+    printf("%-8s %18s %18s\n", "size", "byte loop", "wickr_secure_zero");
+    
+    for (int i = 0; i < sizeof(sizes) / sizeof(size_t); i++) {
+        double byte_loop = bench_zero(bench_zero_byte_loop, buf, sizes[i], total);
+        double secure_zero = bench_zero(wickr_secure_zero, buf, sizes[i], total);
+        
+        printf("%-8s %13.1f MB/s %13.1f MB/s\n", labels[i], byte_loop, secure_zero);
+    }
+    
+    free(buf);
+    
+    return 0;
+}
@@ -19,6 +19,18 @@ void   wickr__proto__handshake_v1__response__init
   static const Wickr__Proto__HandshakeV1__Response init_value = WICKR__PROTO__HANDSHAKE_V1__RESPONSE__INIT;
   *message = init_value;
 }
+void   wickr__proto__handshake_v1__resume_seed__init
+                     (Wickr__Proto__HandshakeV1__ResumeSeed         *message)
+{
+  static const Wickr__Proto__HandshakeV1__ResumeSeed init_value = WICKR__PROTO__HANDSHAKE_V1__RESUME_SEED__INIT;
+  *message = init_value;
+}
+void   wickr__proto__handshake_v1__resume_response__init
+                     (Wickr__Proto__HandshakeV1__ResumeResponse         *message)
+{
+  static const Wickr__Proto__HandshakeV1__ResumeResponse init_value = WICKR__PROTO__HANDSHAKE_V1__RESUME_RESPONSE__INIT;
+  *message = init_value;
+}
 void   wickr__proto__handshake_v1__init
                      (Wickr__Proto__HandshakeV1         *message)
 {
@@ -109,6 +121,51 @@ void   wickr__proto__handshake_v1_response_data__free_unpacked
   assert(message->base.descriptor == &wickr__proto__handshake_v1_response_data__descriptor);
   protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
 }
+void   wickr__proto__transport_resumption_ticket__init
+                     (Wickr__Proto__TransportResumptionTicket         *message)
+{
+  static const Wickr__Proto__TransportResumptionTicket init_value = WICKR__PROTO__TRANSPORT_RESUMPTION_TICKET__INIT;
+  *message = init_value;
+}
+size_t wickr__proto__transport_resumption_ticket__get_packed_size
+                     (const Wickr__Proto__TransportResumptionTicket *message)
+{
+  assert(message->base.descriptor == &wickr__proto__transport_resumption_ticket__descriptor);
+  return protobuf_c_message_get_packed_size ((const ProtobufCMessage*)(message));
+}
+size_t wickr__proto__transport_resumption_ticket__pack
+                     (const Wickr__Proto__TransportResumptionTicket *message,
+                      uint8_t       *out)
+{
+  assert(message->base.descriptor == &wickr__proto__transport_resumption_ticket__descriptor);
+  return protobuf_c_message_pack ((const ProtobufCMessage*)message, out);
+}
+size_t wickr__proto__transport_resumption_ticket__pack_to_buffer
+                     (const Wickr__Proto__TransportResumptionTicket *message,
+                      ProtobufCBuffer *buffer)
+{
+  assert(message->base.descriptor == &wickr__proto__transport_resumption_ticket__descriptor);
+  return protobuf_c_message_pack_to_buffer ((const ProtobufCMessage*)message, buffer);
+}
+Wickr__Proto__TransportResumptionTicket *
+       wickr__proto__transport_resumption_ticket__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data)
+{
+  return (Wickr__Proto__TransportResumptionTicket *)
+     protobuf_c_message_unpack (&wickr__proto__transport_resumption_ticket__descriptor,
+                                allocator, len, data);
+}
+void   wickr__proto__transport_resumption_ticket__free_unpacked
+                     (Wickr__Proto__TransportResumptionTicket *message,
+                      ProtobufCAllocator *allocator)
+{
+  if(!message)
+    return;
+  assert(message->base.descriptor == &wickr__proto__transport_resumption_ticket__descriptor);
+  protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
+}
 void   wickr__proto__transport_root_key__init
                      (Wickr__Proto__TransportRootKey         *message)
 {
@@ -327,7 +384,109 @@ const ProtobufCMessageDescriptor wickr__proto__handshake_v1__response__descripto
   (ProtobufCMessageInit) wickr__proto__handshake_v1__response__init,
   NULL,NULL,NULL    /* reserved[123] */
 };
-static const ProtobufCFieldDescriptor wickr__proto__handshake_v1__field_descriptors[2] =
+static const ProtobufCFieldDescriptor wickr__proto__handshake_v1__resume_seed__field_descriptors[2] =
+{
+  {
+    "ticket",
+    1,
+    PROTOBUF_C_LABEL_OPTIONAL,
+    PROTOBUF_C_TYPE_BYTES,
+    offsetof(Wickr__Proto__HandshakeV1__ResumeSeed, has_ticket),
+    offsetof(Wickr__Proto__HandshakeV1__ResumeSeed, ticket),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "nonce",
+    2,
+    PROTOBUF_C_LABEL_OPTIONAL,
+    PROTOBUF_C_TYPE_BYTES,
+    offsetof(Wickr__Proto__HandshakeV1__ResumeSeed, has_nonce),
+    offsetof(Wickr__Proto__HandshakeV1__ResumeSeed, nonce),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+};
+static const unsigned wickr__proto__handshake_v1__resume_seed__field_indices_by_name[] = {
+  1,   /* field[1] = nonce */
+  0,   /* field[0] = ticket */
+};
+static const ProtobufCIntRange wickr__proto__handshake_v1__resume_seed__number_ranges[1 + 1] =
+{
+  { 1, 0 },
+  { 0, 2 }
+};
+const ProtobufCMessageDescriptor wickr__proto__handshake_v1__resume_seed__descriptor =
+{
+  PROTOBUF_C__MESSAGE_DESCRIPTOR_MAGIC,
+  "wickr.proto.HandshakeV1.ResumeSeed",
+  "ResumeSeed",
+  "Wickr__Proto__HandshakeV1__ResumeSeed",
+  "wickr.proto",
+  sizeof(Wickr__Proto__HandshakeV1__ResumeSeed),
+  2,
+  wickr__proto__handshake_v1__resume_seed__field_descriptors,
+  wickr__proto__handshake_v1__resume_seed__field_indices_by_name,
+  1,  wickr__proto__handshake_v1__resume_seed__number_ranges,
+  (ProtobufCMessageInit) wickr__proto__handshake_v1__resume_seed__init,
+  NULL,NULL,NULL    /* reserved[123] */
+};
+static const ProtobufCFieldDescriptor wickr__proto__handshake_v1__resume_response__field_descriptors[2] =
+{
+  {
+    "accepted",
+    1,
+    PROTOBUF_C_LABEL_OPTIONAL,
+    PROTOBUF_C_TYPE_BOOL,
+    offsetof(Wickr__Proto__HandshakeV1__ResumeResponse, has_accepted),
+    offsetof(Wickr__Proto__HandshakeV1__ResumeResponse, accepted),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "nonce",
+    2,
+    PROTOBUF_C_LABEL_OPTIONAL,
+    PROTOBUF_C_TYPE_BYTES,
+    offsetof(Wickr__Proto__HandshakeV1__ResumeResponse, has_nonce),
+    offsetof(Wickr__Proto__HandshakeV1__ResumeResponse, nonce),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+};
+static const unsigned wickr__proto__handshake_v1__resume_response__field_indices_by_name[] = {
+  0,   /* field[0] = accepted */
+  1,   /* field[1] = nonce */
+};
+static const ProtobufCIntRange wickr__proto__handshake_v1__resume_response__number_ranges[1 + 1] =
+{
+  { 1, 0 },
+  { 0, 2 }
+};
+const ProtobufCMessageDescriptor wickr__proto__handshake_v1__resume_response__descriptor =
+{
+  PROTOBUF_C__MESSAGE_DESCRIPTOR_MAGIC,
+  "wickr.proto.HandshakeV1.ResumeResponse",
+  "ResumeResponse",
+  "Wickr__Proto__HandshakeV1__ResumeResponse",
+  "wickr.proto",
+  sizeof(Wickr__Proto__HandshakeV1__ResumeResponse),
+  2,
+  wickr__proto__handshake_v1__resume_response__field_descriptors,
+  wickr__proto__handshake_v1__resume_response__field_indices_by_name,
+  1,  wickr__proto__handshake_v1__resume_response__number_ranges,
+  (ProtobufCMessageInit) wickr__proto__handshake_v1__resume_response__init,
+  NULL,NULL,NULL    /* reserved[123] */
+};
+static const ProtobufCFieldDescriptor wickr__proto__handshake_v1__field_descriptors[4] =
 {
   {
     "seed",
@@ -353,15 +512,41 @@ static const ProtobufCFieldDescriptor wickr__proto__handshake_v1__field_descript
     0 | PROTOBUF_C_FIELD_FLAG_ONEOF,             /* flags */
     0,NULL,NULL    /* reserved1,reserved2, etc */
   },
+  {
+    "resume_seed",
+    4,
+    PROTOBUF_C_LABEL_OPTIONAL,
+    PROTOBUF_C_TYPE_MESSAGE,
+    offsetof(Wickr__Proto__HandshakeV1, payload_case),
+    offsetof(Wickr__Proto__HandshakeV1, resume_seed),
+    &wickr__proto__handshake_v1__resume_seed__descriptor,
+    NULL,
+    0 | PROTOBUF_C_FIELD_FLAG_ONEOF,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "resume_response",
+    5,
+    PROTOBUF_C_LABEL_OPTIONAL,
+    PROTOBUF_C_TYPE_MESSAGE,
+    offsetof(Wickr__Proto__HandshakeV1, payload_case),
+    offsetof(Wickr__Proto__HandshakeV1, resume_response),
+    &wickr__proto__handshake_v1__resume_response__descriptor,
+    NULL,
+    0 | PROTOBUF_C_FIELD_FLAG_ONEOF,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
 };
 static const unsigned wickr__proto__handshake_v1__field_indices_by_name[] = {
   1,   /* field[1] = response */
+  3,   /* field[3] = resume_response */
+  2,   /* field[2] = resume_seed */
   0,   /* field[0] = seed */
 };
 static const ProtobufCIntRange wickr__proto__handshake_v1__number_ranges[1 + 1] =
 {
   { 2, 0 },
-  { 0, 2 }
+  { 0, 4 }
 };
 const ProtobufCMessageDescriptor wickr__proto__handshake_v1__descriptor =
 {
@@ -371,14 +556,14 @@ const ProtobufCMessageDescriptor wickr__proto__handshake_v1__descriptor =
   "Wickr__Proto__HandshakeV1",
   "wickr.proto",
   sizeof(Wickr__Proto__HandshakeV1),
-  2,
+  4,
   wickr__proto__handshake_v1__field_descriptors,
   wickr__proto__handshake_v1__field_indices_by_name,
   1,  wickr__proto__handshake_v1__number_ranges,
   (ProtobufCMessageInit) wickr__proto__handshake_v1__init,
   NULL,NULL,NULL    /* reserved[123] */
 };
-static const ProtobufCFieldDescriptor wickr__proto__handshake_v1_response_data__field_descriptors[1] =
+static const ProtobufCFieldDescriptor wickr__proto__handshake_v1_response_data__field_descriptors[2] =
 {
   {
     "root_key",
@@ -392,14 +577,27 @@ static const ProtobufCFieldDescriptor wickr__proto__handshake_v1_response_data__
     0,             /* flags */
     0,NULL,NULL    /* reserved1,reserved2, etc */
   },
+  {
+    "resumption_ticket",
+    2,
+    PROTOBUF_C_LABEL_OPTIONAL,
+    PROTOBUF_C_TYPE_BYTES,
+    offsetof(Wickr__Proto__HandshakeV1ResponseData, has_resumption_ticket),
+    offsetof(Wickr__Proto__HandshakeV1ResponseData, resumption_ticket),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
 };
 static const unsigned wickr__proto__handshake_v1_response_data__field_indices_by_name[] = {
+  1,   /* field[1] = resumption_ticket */
   0,   /* field[0] = root_key */
 };
 static const ProtobufCIntRange wickr__proto__handshake_v1_response_data__number_ranges[1 + 1] =
 {
   { 1, 0 },
-  { 0, 1 }
+  { 0, 2 }
 };
 const ProtobufCMessageDescriptor wickr__proto__handshake_v1_response_data__descriptor =
 {
@@ -409,13 +607,77 @@ const ProtobufCMessageDescriptor wickr__proto__handshake_v1_response_data__descr
   "Wickr__Proto__HandshakeV1ResponseData",
   "wickr.proto",
   sizeof(Wickr__Proto__HandshakeV1ResponseData),
-  1,
+  2,
   wickr__proto__handshake_v1_response_data__field_descriptors,
   wickr__proto__handshake_v1_response_data__field_indices_by_name,
   1,  wickr__proto__handshake_v1_response_data__number_ranges,
   (ProtobufCMessageInit) wickr__proto__handshake_v1_response_data__init,
   NULL,NULL,NULL    /* reserved[123] */
 };
+static const ProtobufCFieldDescriptor wickr__proto__transport_resumption_ticket__field_descriptors[3] =
+{
+  {
+    "root_key",
+    1,
+    PROTOBUF_C_LABEL_OPTIONAL,
+    PROTOBUF_C_TYPE_MESSAGE,
+    0,   /* quantifier_offset */
+    offsetof(Wickr__Proto__TransportResumptionTicket, root_key),
+    &wickr__proto__transport_root_key__descriptor,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "expiration",
+    2,
+    PROTOBUF_C_LABEL_OPTIONAL,
+    PROTOBUF_C_TYPE_UINT64,
+    offsetof(Wickr__Proto__TransportResumptionTicket, has_expiration),
+    offsetof(Wickr__Proto__TransportResumptionTicket, expiration),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "id_chain",
+    3,
+    PROTOBUF_C_LABEL_OPTIONAL,
+    PROTOBUF_C_TYPE_MESSAGE,
+    0,   /* quantifier_offset */
+    offsetof(Wickr__Proto__TransportResumptionTicket, id_chain),
+    &wickr__proto__identity_chain__descriptor,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+};
+static const unsigned wickr__proto__transport_resumption_ticket__field_indices_by_name[] = {
+  1,   /* field[1] = expiration */
+  2,   /* field[2] = id_chain */
+  0,   /* field[0] = root_key */
+};
+static const ProtobufCIntRange wickr__proto__transport_resumption_ticket__number_ranges[1 + 1] =
+{
+  { 1, 0 },
+  { 0, 3 }
+};
+const ProtobufCMessageDescriptor wickr__proto__transport_resumption_ticket__descriptor =
+{
+  PROTOBUF_C__MESSAGE_DESCRIPTOR_MAGIC,
+  "wickr.proto.TransportResumptionTicket",
+  "TransportResumptionTicket",
+  "Wickr__Proto__TransportResumptionTicket",
+  "wickr.proto",
+  sizeof(Wickr__Proto__TransportResumptionTicket),
+  3,
+  wickr__proto__transport_resumption_ticket__field_descriptors,
+  wickr__proto__transport_resumption_ticket__field_indices_by_name,
+  1,  wickr__proto__transport_resumption_ticket__number_ranges,
+  (ProtobufCMessageInit) wickr__proto__transport_resumption_ticket__init,
+  NULL,NULL,NULL    /* reserved[123] */
+};
 static const ProtobufCFieldDescriptor wickr__proto__transport_root_key__field_descriptors[4] =
 {
   {
@@ -19,7 +19,10 @@ PROTOBUF_C__BEGIN_DECLS
 typedef struct _Wickr__Proto__HandshakeV1 Wickr__Proto__HandshakeV1;
 typedef struct _Wickr__Proto__HandshakeV1__Seed Wickr__Proto__HandshakeV1__Seed;
 typedef struct _Wickr__Proto__HandshakeV1__Response Wickr__Proto__HandshakeV1__Response;
+typedef struct _Wickr__Proto__HandshakeV1__ResumeSeed Wickr__Proto__HandshakeV1__ResumeSeed;
+typedef struct _Wickr__Proto__HandshakeV1__ResumeResponse Wickr__Proto__HandshakeV1__ResumeResponse;
 typedef struct _Wickr__Proto__HandshakeV1ResponseData Wickr__Proto__HandshakeV1ResponseData;
+typedef struct _Wickr__Proto__TransportResumptionTicket Wickr__Proto__TransportResumptionTicket;
 typedef struct _Wickr__Proto__TransportRootKey Wickr__Proto__TransportRootKey;
 typedef struct _Wickr__Proto__StreamKey Wickr__Proto__StreamKey;
 
@@ -57,10 +60,38 @@ struct  _Wickr__Proto__HandshakeV1__Response
     , 0, {0,NULL}, 0, {0,NULL}, NULL }
 
 
+struct  _Wickr__Proto__HandshakeV1__ResumeSeed
+{
+  ProtobufCMessage base;
+  protobuf_c_boolean has_ticket;
+  ProtobufCBinaryData ticket;
+  protobuf_c_boolean has_nonce;
+  ProtobufCBinaryData nonce;
+};
+#define WICKR__PROTO__HANDSHAKE_V1__RESUME_SEED__INIT \
+ { PROTOBUF_C_MESSAGE_INIT (&wickr__proto__handshake_v1__resume_seed__descriptor) \
+    , 0, {0,NULL}, 0, {0,NULL} }
+
+
+struct  _Wickr__Proto__HandshakeV1__ResumeResponse
+{
+  ProtobufCMessage base;
+  protobuf_c_boolean has_accepted;
+  protobuf_c_boolean accepted;
+  protobuf_c_boolean has_nonce;
+  ProtobufCBinaryData nonce;
+};
+#define WICKR__PROTO__HANDSHAKE_V1__RESUME_RESPONSE__INIT \
+ { PROTOBUF_C_MESSAGE_INIT (&wickr__proto__handshake_v1__resume_response__descriptor) \
+    , 0, 0, 0, {0,NULL} }
+
+
 typedef enum {
   WICKR__PROTO__HANDSHAKE_V1__PAYLOAD__NOT_SET = 0,
   WICKR__PROTO__HANDSHAKE_V1__PAYLOAD_SEED = 2,
-  WICKR__PROTO__HANDSHAKE_V1__PAYLOAD_RESPONSE = 3
+  WICKR__PROTO__HANDSHAKE_V1__PAYLOAD_RESPONSE = 3,
+  WICKR__PROTO__HANDSHAKE_V1__PAYLOAD_RESUME_SEED = 4,
+  WICKR__PROTO__HANDSHAKE_V1__PAYLOAD_RESUME_RESPONSE = 5
     PROTOBUF_C__FORCE_ENUM_TO_BE_INT_SIZE(WICKR__PROTO__HANDSHAKE_V1__PAYLOAD)
 } Wickr__Proto__HandshakeV1__PayloadCase;
 
@@ -71,6 +102,8 @@ struct  _Wickr__Proto__HandshakeV1
   union {
     Wickr__Proto__HandshakeV1__Seed *seed;
     Wickr__Proto__HandshakeV1__Response *response;
+    Wickr__Proto__HandshakeV1__ResumeSeed *resume_seed;
+    Wickr__Proto__HandshakeV1__ResumeResponse *resume_response;
   };
 };
 #define WICKR__PROTO__HANDSHAKE_V1__INIT \
@@ -82,10 +115,25 @@ struct  _Wickr__Proto__HandshakeV1ResponseData
 {
   ProtobufCMessage base;
   Wickr__Proto__TransportRootKey *root_key;
+  protobuf_c_boolean has_resumption_ticket;
+  ProtobufCBinaryData resumption_ticket;
 };
 #define WICKR__PROTO__HANDSHAKE_V1_RESPONSE_DATA__INIT \
  { PROTOBUF_C_MESSAGE_INIT (&wickr__proto__handshake_v1_response_data__descriptor) \
-    , NULL }
+    , NULL, 0, {0,NULL} }
+
+
+struct  _Wickr__Proto__TransportResumptionTicket
+{
+  ProtobufCMessage base;
+  Wickr__Proto__TransportRootKey *root_key;
+  protobuf_c_boolean has_expiration;
+  uint64_t expiration;
+  Wickr__Proto__IdentityChain *id_chain;
+};
+#define WICKR__PROTO__TRANSPORT_RESUMPTION_TICKET__INIT \
+ { PROTOBUF_C_MESSAGE_INIT (&wickr__proto__transport_resumption_ticket__descriptor) \
+    , NULL, 0, 0, NULL }
 
 
 struct  _Wickr__Proto__TransportRootKey
@@ -128,6 +176,12 @@ void   wickr__proto__handshake_v1__seed__init
 /* Wickr__Proto__HandshakeV1__Response methods */
 void   wickr__proto__handshake_v1__response__init
                      (Wickr__Proto__HandshakeV1__Response         *message);
+/* Wickr__Proto__HandshakeV1__ResumeSeed methods */
+void   wickr__proto__handshake_v1__resume_seed__init
+                     (Wickr__Proto__HandshakeV1__ResumeSeed         *message);
+/* Wickr__Proto__HandshakeV1__ResumeResponse methods */
+void   wickr__proto__handshake_v1__resume_response__init
+                     (Wickr__Proto__HandshakeV1__ResumeResponse         *message);
 /* Wickr__Proto__HandshakeV1 methods */
 void   wickr__proto__handshake_v1__init
                      (Wickr__Proto__HandshakeV1         *message);
@@ -166,6 +220,25 @@ Wickr__Proto__HandshakeV1ResponseData *
 void   wickr__proto__handshake_v1_response_data__free_unpacked
                      (Wickr__Proto__HandshakeV1ResponseData *message,
                       ProtobufCAllocator *allocator);
+/* Wickr__Proto__TransportResumptionTicket methods */
+void   wickr__proto__transport_resumption_ticket__init
+                     (Wickr__Proto__TransportResumptionTicket         *message);
+size_t wickr__proto__transport_resumption_ticket__get_packed_size
+                     (const Wickr__Proto__TransportResumptionTicket   *message);
+size_t wickr__proto__transport_resumption_ticket__pack
+                     (const Wickr__Proto__TransportResumptionTicket   *message,
+                      uint8_t             *out);
+size_t wickr__proto__transport_resumption_ticket__pack_to_buffer
+                     (const Wickr__Proto__TransportResumptionTicket   *message,
+                      ProtobufCBuffer     *buffer);
+Wickr__Proto__TransportResumptionTicket *
+       wickr__proto__transport_resumption_ticket__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data);
+void   wickr__proto__transport_resumption_ticket__free_unpacked
+                     (Wickr__Proto__TransportResumptionTicket *message,
+                      ProtobufCAllocator *allocator);
 /* Wickr__Proto__TransportRootKey methods */
 void   wickr__proto__transport_root_key__init
                      (Wickr__Proto__TransportRootKey         *message);
@@ -212,12 +285,21 @@ typedef void (*Wickr__Proto__HandshakeV1__Seed_Closure)
 typedef void (*Wickr__Proto__HandshakeV1__Response_Closure)
                  (const Wickr__Proto__HandshakeV1__Response *message,
                   void *closure_data);
+typedef void (*Wickr__Proto__HandshakeV1__ResumeSeed_Closure)
+                 (const Wickr__Proto__HandshakeV1__ResumeSeed *message,
+                  void *closure_data);
+typedef void (*Wickr__Proto__HandshakeV1__ResumeResponse_Closure)
+                 (const Wickr__Proto__HandshakeV1__ResumeResponse *message,
+                  void *closure_data);
 typedef void (*Wickr__Proto__HandshakeV1_Closure)
                  (const Wickr__Proto__HandshakeV1 *message,
                   void *closure_data);
 typedef void (*Wickr__Proto__HandshakeV1ResponseData_Closure)
                  (const Wickr__Proto__HandshakeV1ResponseData *message,
                   void *closure_data);
+typedef void (*Wickr__Proto__TransportResumptionTicket_Closure)
+                 (const Wickr__Proto__TransportResumptionTicket *message,
+                  void *closure_data);
 typedef void (*Wickr__Proto__TransportRootKey_Closure)
                  (const Wickr__Proto__TransportRootKey *message,
                   void *closure_data);
@@ -233,7 +315,10 @@ typedef void (*Wickr__Proto__StreamKey_Closure)
 extern const ProtobufCMessageDescriptor wickr__proto__handshake_v1__descriptor;
 extern const ProtobufCMessageDescriptor wickr__proto__handshake_v1__seed__descriptor;
 extern const ProtobufCMessageDescriptor wickr__proto__handshake_v1__response__descriptor;
+extern const ProtobufCMessageDescriptor wickr__proto__handshake_v1__resume_seed__descriptor;
+extern const ProtobufCMessageDescriptor wickr__proto__handshake_v1__resume_response__descriptor;
 extern const ProtobufCMessageDescriptor wickr__proto__handshake_v1_response_data__descriptor;
+extern const ProtobufCMessageDescriptor wickr__proto__transport_resumption_ticket__descriptor;
 extern const ProtobufCMessageDescriptor wickr__proto__transport_root_key__descriptor;
 extern const ProtobufCMessageDescriptor wickr__proto__stream_key__descriptor;
 
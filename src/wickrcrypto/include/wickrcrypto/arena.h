@@ -0,0 +1,154 @@
+/*
+ * Copyright © 2012-2020 Wickr Inc.  All rights reserved.
+ *
+ * This code is being released for EDUCATIONAL, ACADEMIC, AND CODE REVIEW PURPOSES
+ * ONLY.  COMMERCIAL USE OF THE CODE IS EXPRESSLY PROHIBITED.  For additional details,
+ * please see LICENSE
+ *
+ * THE CODE IS MADE AVAILABLE "AS-IS" AND WITHOUT ANY EXPRESS OR
+ * IMPLIED GUARANTEES AS TO FITNESS, MERCHANTABILITY, NON-
+ * INFRINGEMENT OR OTHERWISE. IT IS NOT BEING PROVIDED IN TRADE BUT ON
+ * A VOLUNTARY BASIS ON BEHALF OF THE AUTHOR’S PART FOR THE BENEFIT
+ * OF THE LICENSEE AND IS NOT MADE AVAILABLE FOR CONSUMER USE OR ANY
+ * OTHER USE OUTSIDE THE TERMS OF THIS LICENSE. ANYONE ACCESSING THE
+ * CODE SHOULD HAVE THE REQUISITE EXPERTISE TO SECURE THEIR SYSTEM
+ * AND DEVICES AND TO ACCESS AND USE THE CODE FOR REVIEW PURPOSES
+ * ONLY. LICENSEE BEARS THE RISK OF ACCESSING AND USING THE CODE. IN
+ * PARTICULAR, AUTHOR BEARS NO LIABILITY FOR ANY INTERFERENCE WITH OR
+ * ADVERSE EFFECT THAT MAY OCCUR AS A RESULT OF THE LICENSEE
+ * ACCESSING AND/OR USING THE CODE ON LICENSEE’S SYSTEM.
+ */
+
+#ifndef arena_h
+#define arena_h
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ @addtogroup wickr_arena wickr_arena
+ */
+
+/**
+ 
+ @ingroup wickr_arena
+ 
+ Region allocator for the temporary allocations of a library call
+ 
+ While an arena scope is open on a thread, wickr_alloc and wickr_alloc_zero on that thread are served from the arena by bumping
+ a pointer, and wickr_free of arena memory does nothing. Closing the scope zeroes everything the arena handed out and makes it
+ available for the next scope, so a call such as 'wickr_ctx_encode_packet' costs a handful of block allocations rather than
+ hundreds of small ones.
+ 
+ The results of 'wickr_ctx_encode_packet', 'wickr_ctx_parse_packet', 'wickr_ctx_parse_packet_no_decode' and
+ 'wickr_ctx_decode_packet' are allocated outside of the arena, so they remain valid after the scope is closed and are destroyed
+ normally. Anything else allocated inside the scope is released when the scope closes. Allocations made by other threads,
+ including threads started by the library, are not affected. Memory from an arena must be freed on the thread that holds the scope
+ */
+struct wickr_arena;
+typedef struct wickr_arena wickr_arena_t;
+
+/* The block size used when 0 is passed to 'wickr_arena_create' */
+#define WICKR_ARENA_DEFAULT_BLOCK_SIZE 16384
+
+/**
+ 
+ @ingroup wickr_arena
+ 
+ Create an arena
+ 
+ @param block_size the number of bytes to reserve at a time, or 0 for WICKR_ARENA_DEFAULT_BLOCK_SIZE. Allocations larger than a
+ block get a block of their own
+ @return a newly allocated arena, or NULL if allocation fails
+ */
+wickr_arena_t *wickr_arena_create(size_t block_size);
+
+/**
+ 
+ @ingroup wickr_arena
+ 
+ Open an arena scope on the calling thread
+ 
+ Scopes may be nested with different arenas, in which case allocations come from the innermost one
+ 
+ @param arena the arena to serve allocations from
+ @return true if the scope was opened, false if 'arena' already has an open scope
+ */
+bool wickr_arena_begin(wickr_arena_t *arena);
+
+/**
+ 
+ @ingroup wickr_arena
+ 
+ Close the innermost arena scope of the calling thread, zeroing and releasing everything it allocated
+ 
+ The first block of the arena is kept for the next scope and any additional blocks are freed
+ 
+ @param arena the arena whose scope should be closed
+ @return true if the scope was closed, false if 'arena' is not the innermost open scope of the calling thread
+ */
+bool wickr_arena_end(wickr_arena_t *arena);
+
+/**
+ 
+ @ingroup wickr_arena
+ 
+ Temporarily allocate normally on the calling thread while an arena scope is open
+ 
+ This is used to build results that must outlive the scope. Arena memory can still be freed while the scope is suspended
+ 
+ @return the arena that was serving allocations, to be passed to 'wickr_arena_resume'. NULL if no scope is open or it is already suspended
+ */
+wickr_arena_t *wickr_arena_suspend(void);
+
+/**
+ 
+ @ingroup wickr_arena
+ 
+ Resume serving allocations from an arena suspended by 'wickr_arena_suspend'
+ 
+ @param arena the value returned by 'wickr_arena_suspend'. Passing NULL does nothing
+ */
+void wickr_arena_resume(wickr_arena_t *arena);
+
+/**
+ 
+ @ingroup wickr_arena
+ 
+ Determine if allocations on the calling thread are currently served from an arena
+ 
+ @return true if an arena scope is open and not suspended on the calling thread
+ */
+bool wickr_arena_is_active(void);
+
+/**
+ 
+ @ingroup wickr_arena
+ 
+ Get the number of bytes handed out by an arena during its current scope, useful for choosing a block size
+ 
+ @param arena the arena to inspect
+ @return the number of bytes allocated from 'arena', including alignment padding
+ */
+size_t wickr_arena_get_used(const wickr_arena_t *arena);
+
+/**
+ 
+ @ingroup wickr_arena
+ 
+ Destroy an arena
+ 
+ @param arena a pointer to the arena to destroy. It must not have an open scope
+ */
+void wickr_arena_destroy(wickr_arena_t **arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* arena_h */
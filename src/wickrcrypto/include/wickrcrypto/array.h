@@ -37,6 +37,17 @@ typedef struct wickr_array wickr_array_t;
 typedef void *(*wickr_array_copy_func)(void*);
 typedef void (*wickr_array_destroy_func)(void**);
 
+/**
+ @ingroup wickr_array
+ 
+ Compare two items of an array
+ 
+ For arrays created with 'wickr_array_new' the arguments are the item pointers stored in the array, which may be NULL if an index was never set. For arrays created with 'wickr_array_new_inline' the arguments point to the item storage inside the array
+ 
+ @return a negative value if 'a' orders before 'b', 0 if they are equal, and a positive value if 'a' orders after 'b'
+ */
+typedef int (*wickr_array_compare_func)(const void *a, const void *b);
+
 /**
  @ingroup wickr_array
  
@@ -54,12 +65,26 @@ wickr_array_t *wickr_array_new(uint32_t item_count,
                                wickr_array_destroy_func item_destroy_func);
 
 
+/**
+ @ingroup wickr_array
+ 
+ Create a new array that stores its items by value
+ 
+ Items are held contiguously inside the array rather than as separately allocated objects, which suits small fixed size structures that own no other memory. Setting or pushing an item copies 'item_size' bytes from it into the array, and the storage is zeroed when it is released
+ 
+ @param item_count number of zeroed items the array will start with
+ @param item_type an integer that will designate the type of item the array will hold
+ @param item_size the size in bytes of each item
+ @return a newly allocated array or NULL if 'item_size' is 0 or allocation fails
+ */
+wickr_array_t *wickr_array_new_inline(uint32_t item_count, uint8_t item_type, size_t item_size);
+
 /**
  @ingroup wickr_array 
  
  Fetch the size of the array
  
- Note that null values in the array, or uninitialized values in the array will still be counted. The size of the array remains static after it has been created with wickr_array_new. Increasing or decreasing the size of the array is not yet supported
+ Note that null values in the array, or uninitialized values in the array will still be counted. The size of the array is the item count it was created with, adjusted by calls to 'wickr_array_push' and 'wickr_array_remove'
 
  @param array an array to get the item count of
  @return the number of items contained in the array
@@ -80,6 +105,16 @@ uint32_t wickr_array_get_item_count(const wickr_array_t *array);
 bool wickr_array_set_item(wickr_array_t *array, uint32_t index, void *item, bool copy);
 
 
+/**
+ @ingroup wickr_array
+ 
+ Fetch the number of items the array can hold before its storage needs to grow
+ 
+ @param array an array to get the capacity of
+ @return the capacity of the array, which is never less than its item count
+ */
+uint32_t wickr_array_get_capacity(const wickr_array_t *array);
+
 /**
  
  @ingroup wickr_array
@@ -88,7 +123,7 @@ bool wickr_array_set_item(wickr_array_t *array, uint32_t index, void *item, bool
 
  @param array the array from which an item will be fetched
  @param index the position in the array the item will be fetched from
- @param copy if true, a deep copy will be made and returned instead of the item stored in the array
+ @param copy if true, a deep copy will be made and returned instead of the item stored in the array. A copy of an item from an array created with 'wickr_array_new_inline' must be released with 'wickr_free'
  @return the item in the array at position 'index'. NULL is returned if the index is not within the bounds of the array, if the item at position 'index' is NULL because it was never set with 'wickr_array_set_item', or because copy was true and the copy operation failed
  */
 void *wickr_array_fetch_item(const wickr_array_t *array, uint32_t index, bool copy);
@@ -105,6 +140,69 @@ void *wickr_array_fetch_item(const wickr_array_t *array, uint32_t index, bool co
  */
 wickr_array_t *wickr_array_copy(const wickr_array_t *array, bool deep_copy);
 
+/**
+ @ingroup wickr_array
+ 
+ Grow the storage of an array so that it can hold at least 'capacity' items without reallocating
+ 
+ The item count of the array does not change. Item pointers fetched from an array created with 'wickr_array_new_inline' are invalidated when its storage grows
+ 
+ @param array the array to reserve space in
+ @param capacity the number of items the array should be able to hold
+ @return true if the array can hold 'capacity' items, false if allocation fails
+ */
+bool wickr_array_reserve(wickr_array_t *array, uint32_t capacity);
+
+/**
+ @ingroup wickr_array
+ 
+ Append an item to the end of an array, growing its storage if needed
+ 
+ @param array the array to append to
+ @param item the item to append. NULL is allowed and leaves the new index unset
+ @param copy if true, a deep copy of the item will be appended. Items of an array created with 'wickr_array_new_inline' are always copied
+ @return true if the item was appended, false if growing the array or copying the item fails
+ */
+bool wickr_array_push(wickr_array_t *array, void *item, bool copy);
+
+/**
+ @ingroup wickr_array
+ 
+ Remove an item from an array, moving the items that follow it down by one index
+ 
+ @param array the array to remove an item from
+ @param index the position of the item to remove
+ @param destroy_item if true, the destroy function of the array will be called on the removed item
+ @return true if the index was within the bounds of the array
+ */
+bool wickr_array_remove(wickr_array_t *array, uint32_t index, bool destroy_item);
+
+/**
+ @ingroup wickr_array
+ 
+ Sort the items of an array
+ 
+ The sort is stable, so items that compare as equal keep their relative order
+ 
+ @param array the array to sort
+ @param compare the function used to order items
+ @return true if the array was sorted, false if allocating scratch space fails
+ */
+bool wickr_array_sort(wickr_array_t *array, wickr_array_compare_func compare);
+
+/**
+ @ingroup wickr_array
+ 
+ Find an item in an array that is sorted with respect to 'compare' using a binary search
+ 
+ @param array the sorted array to search
+ @param key the value to search for. It is passed to 'compare' as the first argument, with an item of the array as the second
+ @param compare the function used to order the array
+ @param index_out set to the index of a matching item if one is found. May be NULL
+ @return true if a matching item was found
+ */
+bool wickr_array_search(const wickr_array_t *array, const void *key, wickr_array_compare_func compare, uint32_t *index_out);
+
 /**
  Free an array
  
@@ -137,6 +137,43 @@ wickr_buffer_t *wickr_buffer_copy(const wickr_buffer_t *source);
  */
 wickr_buffer_t *wickr_buffer_copy_section(const wickr_buffer_t *source, size_t start, size_t len);
 
+/**
+ 
+ @ingroup wickr_buffer
+ 
+ @brief Creates a zeroed empty buffer on the secure heap, for holding key material
+ 
+ See wickr_secure_alloc. The buffer is destroyed normally
+ 
+ @param len the number of bytes the buffer should hold.
+ @return a newly allocated buffer holding len bytes set to 0, or NULL if allocation fails or len is 0.
+ */
+wickr_buffer_t *wickr_buffer_create_empty_secure(size_t len);
+
+/**
+ 
+ @ingroup wickr_buffer
+ 
+ @brief Copy a buffer onto the secure heap, for holding key material
+
+ @param source the buffer to copy
+ @return a newly allocated buffer on the secure heap containing a copy of the bytes held in source
+ */
+wickr_buffer_t *wickr_buffer_copy_secure(const wickr_buffer_t *source);
+
+/**
+ 
+ @ingroup wickr_buffer
+ 
+ @brief Create a buffer on the secure heap using a subsection of another buffer, for holding key material
+
+ @param source the buffer to copy bytes out of
+ @param start the offset to start the copy process. Must be within the bounds 0 to source->length - 1
+ @param len the number of bytes to copy out of 'source'. start + len must be less than source->length
+ @return a newly allocated buffer on the secure heap containing the bytes within the range of start to start + len. NULL if the range is out of bounds
+ */
+wickr_buffer_t *wickr_buffer_copy_section_secure(const wickr_buffer_t *source, size_t start, size_t len);
+
 /**
  
  @ingroup wickr_buffer
@@ -192,13 +229,118 @@ wickr_buffer_t *wickr_buffer_concat_multi(wickr_buffer_t **buffers, uint8_t n_bu
 bool wickr_buffer_is_equal(const wickr_buffer_t *b1,
                            const wickr_buffer_t *b2,
                            wickr_buffer_compare_func compare_func);
+
+/**
+ 
+ @ingroup wickr_buffer
+ 
+ @brief Create a non-owning view of a subsection of a buffer, without allocating or copying
+ 
+ The view points into the bytes of 'source', so it is only valid while 'source' is, and must not be destroyed
+ 
+ @param source the buffer to view
+ @param start the offset of the view within 'source'
+ @param len the number of bytes in the view. start + len must not exceed source->length
+ @param view_out the location to write the view to
+ @return true if the range is within 'source' and 'view_out' was written
+ */
+bool wickr_buffer_view(const wickr_buffer_t *source, size_t start, size_t len, wickr_buffer_t *view_out);
+
+/**
+ 
+ @ingroup wickr_buffer
+ 
+ @brief Create a reference counted buffer by copying bytes
+ 
+ A shared buffer can be passed to 'wickr_buffer_share' to get another buffer holding the same bytes without copying them. The
+ bytes are released when the last buffer sharing them is destroyed. Shared buffers are otherwise used like any other buffer, but
+ their bytes must not be written to while they are shared, see 'wickr_buffer_make_unique'
+ 
+ @param bytes a valid pointer to bytes of at least size len
+ @param len the number of bytes the buffer should hold
+ @return a newly allocated shared buffer holding len bytes copied from bytes, or NULL if allocation fails or len is 0
+ */
+wickr_buffer_t *wickr_buffer_create_shared(const uint8_t *bytes, size_t len);
+
+/**
+ 
+ @ingroup wickr_buffer
+ 
+ @brief Create an empty reference counted buffer
+ 
+ The bytes in the output are uninitialized, and may be written to until the buffer is first shared
+ 
+ @param len the number of bytes the buffer should hold
+ @return a newly allocated shared buffer holding len bytes, or NULL if allocation fails or len is 0
+ */
+wickr_buffer_t *wickr_buffer_create_empty_shared(size_t len);
+
+/**
+ 
+ @ingroup wickr_buffer
+ 
+ @brief Get a buffer holding the same bytes as a buffer allocated by one of the wickr_buffer functions
+ 
+ If 'source' is a shared buffer this takes a reference to its bytes in constant time. Otherwise the bytes of 'source' are copied
+ into a new shared buffer, so the result can be shared in constant time from then on. 'source' must not be a stack allocated
+ buffer or a view, but its bytes and length may have been narrowed since it was created
+ 
+ @param source the buffer to share
+ @return a newly allocated shared buffer holding the bytes of 'source'. It is destroyed independently of 'source'
+ */
+wickr_buffer_t *wickr_buffer_share(const wickr_buffer_t *source);
+
+/**
+ 
+ @ingroup wickr_buffer
+ 
+ @brief Get a buffer holding a subsection of a buffer allocated by one of the wickr_buffer functions
+ 
+ Like 'wickr_buffer_share', this takes a reference in constant time if 'source' is a shared buffer, and 'source' must not be a stack
+ allocated buffer or a view
+ 
+ @param source the buffer to share a subsection of
+ @param start the offset of the subsection within 'source'
+ @param len the number of bytes in the subsection. start + len must not exceed source->length
+ @return a newly allocated shared buffer holding the bytes within the range of start to start + len, or NULL if the range is out of bounds
+ */
+wickr_buffer_t *wickr_buffer_share_section(const wickr_buffer_t *source, size_t start, size_t len);
+
+/**
+ 
+ @ingroup wickr_buffer
+ 
+ @brief Determine if the bytes of a buffer allocated by one of the wickr_buffer functions are shared with another buffer
+ 
+ 'buffer' must not be a stack allocated buffer or a view
+ 
+ @param buffer the buffer to check
+ @return true if 'buffer' is a shared buffer and at least one other buffer references its bytes
+ */
+bool wickr_buffer_is_shared(const wickr_buffer_t *buffer);
+
+/**
+ 
+ @ingroup wickr_buffer
+ 
+ @brief Make sure a buffer allocated by one of the wickr_buffer functions can be written to without affecting other buffers
+ 
+ This is the copy in copy-on-write. If the bytes of '*buffer' are shared, they are copied into a new buffer that replaces
+ '*buffer', and the reference to the shared bytes is released. Otherwise '*buffer' is left as is
+ 
+ @param buffer a pointer to the buffer to make writable
+ @return true if '*buffer' can be written to, false if the copy could not be allocated. '*buffer' is unchanged on failure
+ */
+bool wickr_buffer_make_unique(wickr_buffer_t **buffer);
+
 /**
  
  @ingroup wickr_buffer
  
  @brief Destroy a buffer
 
- NOTE: This function does not modify the contents of buffer and simply calls free to deallocate the memory held. To zero out memory before deallocation use 'wickr_buffer_destroy_zero'
+ NOTE: This function does not modify the contents of buffer and simply calls free to deallocate the memory held. To zero out memory before deallocation use 'wickr_buffer_destroy_zero'. The bytes of a shared buffer are
+ released when the last buffer sharing them is destroyed
  
  @param buffer the buffer to destroy
  */
@@ -211,10 +353,64 @@ void wickr_buffer_destroy(wickr_buffer_t **buffer);
  
  @brief Zero-then-deallocate a buffer
 
+ If the bytes of 'buffer' are shared, they are zeroed when the last buffer sharing them is destroyed
+
  @param buffer the buffer to zero out and then destroy
  */
 void wickr_buffer_destroy_zero(wickr_buffer_t **buffer);
 
+/**
+ 
+ @ingroup wickr_buffer
+ 
+ @struct wickr_buffer_cache_stats
+ 
+ @brief Counters for the small buffer cache of a thread
+ 
+ Buffers of up to 160 bytes are recycled through a cache on each thread, so the IVs, tags, keys, digests and signatures created
+ for every packet do not each cost a trip to malloc. Recycled buffers are zeroed as they are returned to the cache. The cache is
+ only used while no allocator has been set with 'wickr_set_allocator' and no arena scope is active, and it is compiled out if the
+ library is built with WICKR_DISABLE_BUFFER_CACHE
+ 
+ @var wickr_buffer_cache_stats::hits
+ the number of buffers that were served from the cache
+ @var wickr_buffer_cache_stats::misses
+ the number of buffers small enough for the cache that had to be allocated because the cache was empty
+ @var wickr_buffer_cache_stats::recycled
+ the number of destroyed buffers that were returned to the cache
+ @var wickr_buffer_cache_stats::evictions
+ the number of destroyed buffers that were freed because the cache for their size was full
+ */
+struct wickr_buffer_cache_stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t recycled;
+    uint64_t evictions;
+};
+
+typedef struct wickr_buffer_cache_stats wickr_buffer_cache_stats_t;
+
+/**
+ 
+ @ingroup wickr_buffer
+ 
+ @brief Get the small buffer cache counters of the calling thread
+ 
+ @param stats_out the location to write the counters to
+ @return true if 'stats_out' was written
+ */
+bool wickr_buffer_cache_get_stats(wickr_buffer_cache_stats_t *stats_out);
+
+/**
+ 
+ @ingroup wickr_buffer
+ 
+ @brief Free every buffer held by the small buffer cache of the calling thread
+ 
+ Caches are flushed automatically when their thread exits
+ */
+void wickr_buffer_cache_flush(void);
+
 #ifdef __cplusplus
 }
 #endif
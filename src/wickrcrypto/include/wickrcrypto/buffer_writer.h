@@ -0,0 +1,219 @@
+/*
+ * Copyright © 2012-2020 Wickr Inc.  All rights reserved.
+ *
+ * This code is being released for EDUCATIONAL, ACADEMIC, AND CODE REVIEW PURPOSES
+ * ONLY.  COMMERCIAL USE OF THE CODE IS EXPRESSLY PROHIBITED.  For additional details,
+ * please see LICENSE
+ *
+ * THE CODE IS MADE AVAILABLE "AS-IS" AND WITHOUT ANY EXPRESS OR
+ * IMPLIED GUARANTEES AS TO FITNESS, MERCHANTABILITY, NON-
+ * INFRINGEMENT OR OTHERWISE. IT IS NOT BEING PROVIDED IN TRADE BUT ON
+ * A VOLUNTARY BASIS ON BEHALF OF THE AUTHOR’S PART FOR THE BENEFIT
+ * OF THE LICENSEE AND IS NOT MADE AVAILABLE FOR CONSUMER USE OR ANY
+ * OTHER USE OUTSIDE THE TERMS OF THIS LICENSE. ANYONE ACCESSING THE
+ * CODE SHOULD HAVE THE REQUISITE EXPERTISE TO SECURE THEIR SYSTEM
+ * AND DEVICES AND TO ACCESS AND USE THE CODE FOR REVIEW PURPOSES
+ * ONLY. LICENSEE BEARS THE RISK OF ACCESSING AND USING THE CODE. IN
+ * PARTICULAR, AUTHOR BEARS NO LIABILITY FOR ANY INTERFERENCE WITH OR
+ * ADVERSE EFFECT THAT MAY OCCUR AS A RESULT OF THE LICENSEE
+ * ACCESSING AND/OR USING THE CODE ON LICENSEE’S SYSTEM.
+ */
+
+
+#ifndef buffer_writer_h
+#define buffer_writer_h
+
+#include "buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ @addtogroup wickr_buffer_writer wickr_buffer_writer
+ */
+
+/**
+ 
+ @ingroup wickr_buffer_writer
+ 
+ @struct wickr_buffer_writer
+ 
+ @brief Sequential writer that builds a buffer out of several pieces with a single allocation
+ 
+ A writer either grows its own storage and hands it over as a buffer with 'wickr_buffer_writer_finish', or fills a caller
+ provided buffer of fixed size. Errors are sticky: once an append fails every later append fails as well, so a sequence of
+ appends can be checked once when the writer is finished. A writer lives on the stack and is set up with one of the init functions
+ 
+ @var wickr_buffer_writer::buffer
+ the buffer being written to
+ @var wickr_buffer_writer::length
+ the number of bytes written so far
+ @var wickr_buffer_writer::is_fixed
+ true if 'buffer' belongs to the caller and can not grow
+ @var wickr_buffer_writer::has_failed
+ true if an append or reservation has failed
+ */
+struct wickr_buffer_writer {
+    wickr_buffer_t *buffer;
+    size_t length;
+    bool is_fixed;
+    bool has_failed;
+};
+
+typedef struct wickr_buffer_writer wickr_buffer_writer_t;
+
+/**
+ 
+ @ingroup wickr_buffer_writer
+ 
+ @brief Initialize a writer that grows its own storage
+ 
+ @param writer the writer to initialize
+ @param capacity the number of bytes to reserve up front. When the final size is known passing it here means the result is built
+ without any intermediate copies. 0 defers allocation to the first append
+ @return true if the initial capacity could be reserved. On failure 'writer' is left in the failed state
+ */
+bool wickr_buffer_writer_init(wickr_buffer_writer_t *writer, size_t capacity);
+
+/**
+ 
+ @ingroup wickr_buffer_writer
+ 
+ @brief Initialize a writer that fills a caller provided buffer
+ 
+ Appends that do not fit in the remaining length of 'destination' fail
+ 
+ @param writer the writer to initialize
+ @param destination the buffer to write into, starting at its first byte. It must remain valid while the writer is used
+ */
+void wickr_buffer_writer_init_fixed(wickr_buffer_writer_t *writer, wickr_buffer_t *destination);
+
+/**
+ 
+ @ingroup wickr_buffer_writer
+ 
+ @brief Make sure a number of bytes can be appended without growing the storage again
+ 
+ @param writer the writer to reserve space in
+ @param len the number of additional bytes to reserve
+ @return true if 'len' more bytes can be appended
+ */
+bool wickr_buffer_writer_reserve(wickr_buffer_writer_t *writer, size_t len);
+
+/**
+ 
+ @ingroup wickr_buffer_writer
+ 
+ @brief Append bytes
+ 
+ @param writer the writer to append to
+ @param bytes a valid pointer to at least 'len' bytes
+ @param len the number of bytes to append
+ @return true if the bytes were appended
+ */
+bool wickr_buffer_writer_append(wickr_buffer_writer_t *writer, const uint8_t *bytes, size_t len);
+
+/**
+ 
+ @ingroup wickr_buffer_writer
+ 
+ @brief Append the contents of a buffer
+ 
+ @param writer the writer to append to
+ @param buffer the buffer to append. A NULL buffer is an error
+ @return true if the contents of 'buffer' were appended
+ */
+bool wickr_buffer_writer_append_buffer(wickr_buffer_writer_t *writer, const wickr_buffer_t *buffer);
+
+/**
+ 
+ @ingroup wickr_buffer_writer
+ 
+ @brief Append a single byte
+ 
+ @param writer the writer to append to
+ @param value the byte to append
+ @return true if 'value' was appended
+ */
+bool wickr_buffer_writer_append_u8(wickr_buffer_writer_t *writer, uint8_t value);
+
+/**
+ 
+ @ingroup wickr_buffer_writer
+ 
+ @brief Append a 64bit value as 8 little endian bytes
+ 
+ @param writer the writer to append to
+ @param value the value to append
+ @return true if 'value' was appended
+ */
+bool wickr_buffer_writer_append_u64le(wickr_buffer_writer_t *writer, uint64_t value);
+
+/* A 64bit value requires at most 10 bytes as a base 128 varint */
+#define BUFFER_WRITER_VARINT_MAX_LEN 10
+
+/**
+ 
+ @ingroup wickr_buffer_writer
+ 
+ @brief Append a value as a base 128 varint, the variable length integer encoding used by protocol buffers
+ 
+ @param writer the writer to append to
+ @param value the value to append
+ @return true if 'value' was appended
+ */
+bool wickr_buffer_writer_append_varint(wickr_buffer_writer_t *writer, uint64_t value);
+
+/**
+ 
+ @ingroup wickr_buffer_writer
+ 
+ @brief Get the number of bytes 'wickr_buffer_writer_append_varint' appends for a value
+ 
+ @param value the value to measure
+ @return the encoded size of 'value', between 1 and BUFFER_WRITER_VARINT_MAX_LEN bytes
+ */
+size_t wickr_buffer_writer_varint_size(uint64_t value);
+
+/**
+ 
+ @ingroup wickr_buffer_writer
+ 
+ @brief Take the result of a writer initialized with 'wickr_buffer_writer_init'
+ 
+ The writer is released either way, and must be initialized again before it is reused
+ 
+ @param writer the writer to finish
+ @return a buffer holding everything that was appended, or NULL if any append failed, nothing was appended, or 'writer' is a fixed writer
+ */
+wickr_buffer_t *wickr_buffer_writer_finish(wickr_buffer_writer_t *writer);
+
+/**
+ 
+ @ingroup wickr_buffer_writer
+ 
+ @brief Complete a writer initialized with 'wickr_buffer_writer_init_fixed'
+ 
+ @param writer the writer to finish
+ @return the number of bytes written to the destination buffer, or 0 if any append failed
+ */
+size_t wickr_buffer_writer_finish_fixed(wickr_buffer_writer_t *writer);
+
+/**
+ 
+ @ingroup wickr_buffer_writer
+ 
+ @brief Abandon a writer, zeroing and releasing any storage it owns
+ 
+ Use this on error paths that return before 'wickr_buffer_writer_finish'. It has no effect on the destination of a fixed writer
+ 
+ @param writer the writer to release
+ */
+void wickr_buffer_writer_release(wickr_buffer_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* buffer_writer_h */
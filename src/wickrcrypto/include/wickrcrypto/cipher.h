@@ -24,6 +24,7 @@
 
 #include <stdlib.h>
 #include "buffer.h"
+#include "buffer_writer.h"
 #include "kdf.h"
 
 #ifdef __cplusplus
@@ -103,6 +104,21 @@ struct wickr_cipher_result {
 
 typedef struct wickr_cipher_result wickr_cipher_result_t;
 
+/**
+ 
+ @ingroup wickr_cipher
+ 
+ @struct wickr_cipher_stream
+ 
+ @brief Opaque state of an incremental cipher operation
+ 
+ The contents of this structure are defined by the crypto engine that created it, and it should only be operated
+ on using the cipher stream functions of that same engine. The cipher result returned when an encryption stream is
+ finalized has no cipher text, so serializing it produces only the header of the wire format. That header followed by
+ the output of each update in order is identical to serializing a cipher result of the whole input
+ */
+typedef struct wickr_cipher_stream wickr_cipher_stream_t;
+
 /**
  
  @ingroup wickr_cipher
@@ -161,6 +177,32 @@ bool wickr_cipher_result_is_valid(const wickr_cipher_result_t *result);
  */
 wickr_buffer_t *wickr_cipher_result_serialize(const wickr_cipher_result_t *result);
 
+/**
+ 
+ @ingroup wickr_cipher
+ 
+ Get the size of a serialized cipher result without serializing it
+
+ @param result the cipher result to measure
+ @return the number of bytes 'wickr_cipher_result_serialize' produces for 'result', or 0 if 'result' is not valid
+ */
+size_t wickr_cipher_result_serialized_size(const wickr_cipher_result_t *result);
+
+/**
+ 
+ @ingroup wickr_cipher
+ 
+ Serialize a cipher result into a writer, in the same format as 'wickr_cipher_result_serialize'
+ 
+ Combined with 'wickr_cipher_result_serialized_size' this places a cipher result inside a larger structure, such as a
+ protocol buffer bytes field, without an intermediate buffer
+
+ @param result the cipher result to serialize
+ @param writer the writer to append the serialized cipher result to
+ @return true if the whole cipher result was appended
+ */
+bool wickr_cipher_result_serialize_into(const wickr_cipher_result_t *result, wickr_buffer_writer_t *writer);
+
 /**
  
  @ingroup wickr_cipher
@@ -173,6 +215,32 @@ wickr_buffer_t *wickr_cipher_result_serialize(const wickr_cipher_result_t *resul
  */
 wickr_cipher_result_t *wickr_cipher_result_from_buffer(const wickr_buffer_t *buffer);
 
+/**
+ 
+ @ingroup wickr_cipher
+ 
+ Serialize a cipher result without its cipher id. This is useful when the cipher is already known to both
+ parties, such as within an established transport session
+ 
+ @param result the cipher result to serialize
+ @return a buffer containing bytes representing the cipher result in the following format:
+    | IV | AUTH_TAG (IF REQUIRED) | CIPHER_TEXT |
+ */
+wickr_buffer_t *wickr_cipher_result_serialize_compact(const wickr_cipher_result_t *result);
+
+/**
+ 
+ @ingroup wickr_cipher
+ 
+ Create a cipher result from a buffer created by 'wickr_cipher_result_serialize_compact'
+ 
+ @param buffer a buffer created by 'wickr_cipher_result_serialize_compact'
+ @param cipher the cipher that was used to create the serialized cipher result
+ @return cipher result parsed from 'buffer'. This function makes a copy of all bytes as it is parsing,
+ so the resulting cipher result owns its properties. Returns NULL on parsing failure
+ */
+wickr_cipher_result_t *wickr_cipher_result_from_compact_buffer(const wickr_buffer_t *buffer, wickr_cipher_t cipher);
+
 /**
  
  @ingroup wickr_cipher
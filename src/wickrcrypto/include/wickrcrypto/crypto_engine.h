@@ -284,6 +284,177 @@ struct wickr_crypto_engine {
      */
     wickr_kdf_result_t *(*wickr_crypto_kdf_meta)(const wickr_kdf_meta_t *existing_meta,
                                                  const wickr_buffer_t *passphrase);
+    
+    /**
+     @ingroup wickr_crypto_engine
+     
+     Begin an incremental digest operation
+     
+     @param mode the mode of the hash
+     @return a newly allocated digest context or NULL if 'mode' is not supported
+     */
+    wickr_digest_ctx_t *(*wickr_crypto_engine_digest_ctx_create)(wickr_digest_t mode);
+    
+    /**
+     @ingroup wickr_crypto_engine
+     
+     Add data to an incremental digest operation
+     
+     @param ctx the digest context to update
+     @param buffer the data to add to the digest
+     @return true if the digest context could be updated
+     */
+    bool (*wickr_crypto_engine_digest_ctx_update)(wickr_digest_ctx_t *ctx,
+                                                  const wickr_buffer_t *buffer);
+    
+    /**
+     @ingroup wickr_crypto_engine
+     
+     Calculate the hash of all data that has been added to a digest context so far. The context is not modified,
+     so more data can be added to it after this call
+     
+     @param ctx the digest context to calculate the hash of
+     @return a buffer containing the hash or NULL if the hashing operation fails
+     */
+    wickr_buffer_t *(*wickr_crypto_engine_digest_ctx_final)(const wickr_digest_ctx_t *ctx);
+    
+    /**
+     @ingroup wickr_crypto_engine
+     
+     Copy a digest context
+     
+     @param ctx the digest context to copy
+     @return a newly allocated digest context holding the same state as 'ctx'
+     */
+    wickr_digest_ctx_t *(*wickr_crypto_engine_digest_ctx_copy)(const wickr_digest_ctx_t *ctx);
+    
+    /**
+     @ingroup wickr_crypto_engine
+     
+     Destroy a digest context
+     
+     @param ctx a pointer to the digest context to destroy. Will set the value of 'ctx' to NULL
+     */
+    void (*wickr_crypto_engine_digest_ctx_destroy)(wickr_digest_ctx_t **ctx);
+    
+    /**
+     @ingroup wickr_crypto_engine
+     
+     Begin an incremental encryption, for data that is not available in one buffer
+     
+     @param aad additional data to authenticate with the ciphertext (only works with authenticated ciphers)
+     @param key the key to use for encryption
+     @param iv an initialization vector to use with the cipher mode, or NULL if one should be chosen at random
+     @return a newly allocated cipher stream or NULL if the cipher mode is not supported
+     */
+    wickr_cipher_stream_t *(*wickr_crypto_engine_cipher_stream_encrypt_init)(const wickr_buffer_t *aad,
+                                                                             const wickr_cipher_key_t *key,
+                                                                             const wickr_buffer_t *iv);
+    
+    /**
+     @ingroup wickr_crypto_engine
+     
+     Begin an incremental decryption, for data that is not available in one buffer
+     
+     @param header a cipher result containing the iv and auth tag of the ciphertext to decrypt. Its cipher text is ignored
+     @param aad additional data to authenticate with the ciphertext (only works with authenticated ciphers)
+     @param key the key to use to attempt to decrypt the ciphertext
+     @param only_auth_ciphers if true, only authenticated ciphers may be used for decryption
+     @return a newly allocated cipher stream or NULL if the cipher mode is not supported
+     */
+    wickr_cipher_stream_t *(*wickr_crypto_engine_cipher_stream_decrypt_init)(const wickr_cipher_result_t *header,
+                                                                             const wickr_buffer_t *aad,
+                                                                             const wickr_cipher_key_t *key,
+                                                                             bool only_auth_ciphers);
+    
+    /**
+     @ingroup wickr_crypto_engine
+     
+     Encrypt or decrypt the next part of the input of a cipher stream. Decrypted output is not authenticated until
+     'wickr_crypto_engine_cipher_stream_decrypt_final' succeeds
+     
+     @param stream the cipher stream to update
+     @param input the next part of the plaintext or ciphertext
+     @return a buffer containing the next part of the output, or NULL if the stream has been finalized or the cipher fails
+     */
+    wickr_buffer_t *(*wickr_crypto_engine_cipher_stream_update)(wickr_cipher_stream_t *stream,
+                                                                const wickr_buffer_t *input);
+    
+    /**
+     @ingroup wickr_crypto_engine
+     
+     Finish an incremental encryption
+     
+     The auth tag is only known at this point, but it is serialized ahead of the cipher text. Writers must leave room for the
+     serialized header and fill it in afterwards, so output to a destination that can't seek has to be held back until the stream
+     is finished. A stream can encrypt more than MAX_BUFFER_SIZE bytes, but the serialized output is then too large for
+     'wickr_cipher_result_from_buffer' and can only be read back with a decryption stream
+     
+     @param stream the encryption stream to finish
+     @return a cipher result containing the iv and auth tag of the stream with no cipher text, or NULL if the stream can't be finalized
+     */
+    wickr_cipher_result_t *(*wickr_crypto_engine_cipher_stream_encrypt_final)(wickr_cipher_stream_t *stream);
+    
+    /**
+     @ingroup wickr_crypto_engine
+     
+     Finish an incremental decryption
+     
+     @param stream the decryption stream to finish
+     @return true if all of the ciphertext passed to the stream is authentic
+     */
+    bool (*wickr_crypto_engine_cipher_stream_decrypt_final)(wickr_cipher_stream_t *stream);
+    
+    /**
+     @ingroup wickr_crypto_engine
+     
+     Destroy a cipher stream
+     
+     @param stream a pointer to the cipher stream to destroy. Will set the value of 'stream' to NULL
+     */
+    void (*wickr_crypto_engine_cipher_stream_destroy)(wickr_cipher_stream_t **stream);
+    
+    /**
+     @ingroup wickr_crypto_engine
+     
+     Encrypt a file, and calculate digests of the plaintext and ciphertext in the same pass over the data
+     
+     @param key the key to use for encryption
+     @param sourceFilePath the file to encrypt
+     @param destinationFilePath a file that should contain the encrypted data
+     @param digest_mode the digest to calculate
+     @param plaintext_digest set to the digest of the plaintext on success, or NULL if it isn't needed
+     @param ciphertext_digest set to the digest of the encrypted file on success, or NULL if it isn't needed
+     @return true if encryption succeeds, and the requested digests were calculated
+     */
+    bool (*wickr_crypto_engine_encrypt_file_digest)(const wickr_cipher_key_t *key,
+                                                    const char *sourceFilePath,
+                                                    const char *destinationFilePath,
+                                                    wickr_digest_t digest_mode,
+                                                    wickr_buffer_t **plaintext_digest,
+                                                    wickr_buffer_t **ciphertext_digest);
+    
+    /**
+     @ingroup wickr_crypto_engine
+     
+     Decrypt a file, and calculate digests of the ciphertext and plaintext in the same pass over the data
+     
+     @param key the key to use for decryption
+     @param sourceFilePath the encrypted file to decrypt
+     @param destinationFilePath the file to write the decrypted data to
+     @param only_auth_ciphers if true, only authenticated ciphers may be used for decryption
+     @param digest_mode the digest to calculate
+     @param plaintext_digest set to the digest of the decrypted data on success, or NULL if it isn't needed
+     @param ciphertext_digest set to the digest of the encrypted file on success, or NULL if it isn't needed
+     @return true if decryption succeeds, and the requested digests were calculated
+     */
+    bool (*wickr_crypto_engine_decrypt_file_digest)(const wickr_cipher_key_t *key,
+                                                    const char *sourceFilePath,
+                                                    const char *destinationFilePath,
+                                                    bool only_auth_ciphers,
+                                                    wickr_digest_t digest_mode,
+                                                    wickr_buffer_t **plaintext_digest,
+                                                    wickr_buffer_t **ciphertext_digest);
 };
 
 typedef struct wickr_crypto_engine wickr_crypto_engine_t;
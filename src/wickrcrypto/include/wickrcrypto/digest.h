@@ -29,8 +29,8 @@
 extern "C" {
 #endif
 
-typedef enum { DIGEST_SHA2 } wickr_digest_type;
-typedef enum { DIGEST_ID_SHA256 = 1, DIGEST_ID_SHA384, DIGEST_ID_SHA512 } wickr_digest_id;
+typedef enum { DIGEST_SHA2, DIGEST_SHA2_TREE } wickr_digest_type;
+typedef enum { DIGEST_ID_SHA256 = 1, DIGEST_ID_SHA384, DIGEST_ID_SHA512, DIGEST_ID_SHA256_TREE, DIGEST_ID_SHA512_TREE } wickr_digest_id;
 
 /**
  @addtogroup wickr_digest
@@ -67,6 +67,30 @@ static const wickr_digest_t DIGEST_SHA_256 = { DIGEST_SHA2, DIGEST_ID_SHA256, SH
 static const wickr_digest_t DIGEST_SHA_384 = { DIGEST_SHA2, DIGEST_ID_SHA384, SHA384_DIGEST_SIZE };
 static const wickr_digest_t DIGEST_SHA_512 = { DIGEST_SHA2, DIGEST_ID_SHA512, SHA512_DIGEST_SIZE };
 
+/*
+ Tree digests split their input into leaves of DIGEST_TREE_LEAF_SIZE bytes (the last leaf may be shorter, and empty input is
+ a single empty leaf). Each leaf is hashed as H(0x00 | leaf), and each pair of nodes on a level as H(0x01 | left | right).
+ A node without a pair is promoted to the next level unchanged. The output is the root of the tree, which is not the same as
+ the plain SHA2 digest of the input. Leaves can be hashed in parallel, and a single leaf can be verified against the root
+ */
+#define DIGEST_TREE_LEAF_SIZE (1024 * 1024)
+
+static const wickr_digest_t DIGEST_SHA_256_TREE = { DIGEST_SHA2_TREE, DIGEST_ID_SHA256_TREE, SHA256_DIGEST_SIZE };
+static const wickr_digest_t DIGEST_SHA_512_TREE = { DIGEST_SHA2_TREE, DIGEST_ID_SHA512_TREE, SHA512_DIGEST_SIZE };
+
+/**
+ 
+ @ingroup wickr_digest
+ 
+ @struct wickr_digest_ctx
+ 
+ @brief Opaque state of an incremental digest operation
+ 
+ The contents of this structure are defined by the crypto engine that created it, and it should only be operated
+ on using the digest context functions of that same engine
+ */
+typedef struct wickr_digest_ctx wickr_digest_ctx_t;
+
 /**
  
  @ingroup wickr_digest
@@ -104,7 +104,8 @@ wickr_ecdsa_result_t *wickr_ecdsa_result_create_from_buffer(const wickr_buffer_t
  Copy an ECDSA result
 
  @param source the ECDSA result to copy
- @return a newly allocated ECDSA result holding a deep copy of the properties of 'source'
+ @return a newly allocated ECDSA result holding a copy of the properties of 'source'. The signature bytes may be shared with 'source'
+ rather than copied (see 'wickr_buffer_share'), so they must be treated as read only unless 'wickr_buffer_make_unique' is called first
  */
 wickr_ecdsa_result_t *wickr_ecdsa_result_copy(const wickr_ecdsa_result_t *source);
 
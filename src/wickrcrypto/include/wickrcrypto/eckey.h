@@ -119,7 +119,8 @@ wickr_ec_key_t *wickr_ec_key_create(wickr_ec_curve_t curve, wickr_buffer_t *pub_
  Copy an EC Key
  
  @param source the EC key to copy
- @return a newly allocated EC key holding a deep copy of the properties of 'source'
+ @return a newly allocated EC key holding a copy of the properties of 'source'. The public key bytes may be shared with 'source' rather
+ than copied (see 'wickr_buffer_share'), so they must be treated as read only unless 'wickr_buffer_make_unique' is called first
  */
 wickr_ec_key_t *wickr_ec_key_copy(const wickr_ec_key_t *source);
 
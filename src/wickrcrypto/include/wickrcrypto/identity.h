@@ -169,7 +169,9 @@ wickr_identity_t *wickr_node_identity_gen(const wickr_crypto_engine_t *engine, c
  Copy an identity
  
  @param source the identity to copy
- @return a newly allocated identity holding a deep copy of the properties of 'source'
+ @return a newly allocated identity holding a copy of the properties of 'source'. The identifier, public key and signature bytes
+ may be shared with 'source' rather than copied (see 'wickr_buffer_share'), so they must be treated as read only unless
+ 'wickr_buffer_make_unique' is called first
  */
 wickr_identity_t *wickr_identity_copy(const wickr_identity_t *source);
 
@@ -293,7 +295,8 @@ wickr_identity_chain_t *wickr_identity_chain_create(wickr_identity_t *root, wick
  Copy an identity chain
  
  @param source the identity chain to copy
- @return a newly allocated identity chain holding a deep copy of the properties of 'source'
+ @return a newly allocated identity chain holding a copy of the properties of 'source'. Bytes may be shared with 'source' as described
+ for 'wickr_identity_copy'
  */
 wickr_identity_chain_t *wickr_identity_chain_copy(const wickr_identity_chain_t *source);
 
@@ -40,13 +40,13 @@ extern "C" {
  
  KDF Algorithm ID
  
- Define the base algorithm a particular kdf function uses. Scrypt, Bcrypt, and HKDF are currently supported.
+ Define the base algorithm a particular kdf function uses. Scrypt, Bcrypt, Argon2id and HKDF are currently supported.
  The preferred default is to use scrypt, with a minimum of n = 2^17
  
  */
-typedef enum { KDF_BCRYPT, KDF_SCRYPT, KDF_HMAC_SHA2 } wickr_kdf_algo_id;
+typedef enum { KDF_BCRYPT, KDF_SCRYPT, KDF_HMAC_SHA2, KDF_ARGON2ID } wickr_kdf_algo_id;
 
-typedef enum { KDF_ID_SCRYPT_17 = 1, KDF_ID_SCRYPT_18, KDF_ID_SCRYPT_19, KDF_ID_SCRYPT_20, KDF_ID_BCRYPT_15, KDF_ID_HKDF_SHA256, KDF_ID_HKDF_SHA384, KDF_ID_HKDF_SHA512 } wickr_kdf_id;
+typedef enum { KDF_ID_SCRYPT_17 = 1, KDF_ID_SCRYPT_18, KDF_ID_SCRYPT_19, KDF_ID_SCRYPT_20, KDF_ID_BCRYPT_15, KDF_ID_HKDF_SHA256, KDF_ID_HKDF_SHA384, KDF_ID_HKDF_SHA512, KDF_ID_SCRYPT_17_P4, KDF_ID_SCRYPT_18_P4, KDF_ID_ARGON2ID_16, KDF_ID_ARGON2ID_18, KDF_ID_ARGON2ID_20 } wickr_kdf_id;
 
 /**
  
@@ -94,6 +94,32 @@ typedef struct wickr_kdf_algo wickr_kdf_algo_t;
 #define SCRYPT_2_19_COST 1247233
 #define SCRYPT_2_20_COST 1312769
 
+/*
+ Scrypt with 4 parallel lanes (p = 4). Each lane uses the same amount of memory as the p = 1 mode with the same N, and lanes are
+ computed on separate threads, so these modes are 4 times the work of their p = 1 counterparts for roughly the same latency on
+ a machine with 4 or more cores
+ */
+#define SCRYPT_2_17_P4_COST 1116164
+#define SCRYPT_2_18_P4_COST 1181700
+
+/**
+ 
+ @ingroup wickr_kdf
+ 
+ Argon2id Cost
+ 
+ Argon2id parameters are packed into a single uint32 in the same layout as the scrypt cost. The high 16 bits hold log2 of the
+ memory cost in KiB, the next 8 bits hold the number of passes (t) and the low 8 bits hold the number of lanes (p). Lanes are
+ filled on separate threads
+ 
+ */
+#define ARGON2ID_2_16_COST 1049348 /* 64 MiB, t = 3, p = 4 */
+#define ARGON2ID_2_18_COST 1180164 /* 256 MiB, t = 2, p = 4 */
+#define ARGON2ID_2_20_COST 1310980 /* 1 GiB, t = 1, p = 4 */
+
+#define ARGON2ID_OUTPUT_SIZE 32
+#define ARGON2ID_SALT_SIZE 16
+
 /* Truncate the output size of scrypt to give us 32byte values we can use as a cipher key */
 #define SCRYPT_OUTPUT_SIZE 32
 
@@ -109,6 +135,13 @@ static const wickr_kdf_algo_t KDF_SCRYPT_2_17 = { KDF_SCRYPT, KDF_ID_SCRYPT_17,
 static const wickr_kdf_algo_t KDF_SCRYPT_2_18 = { KDF_SCRYPT, KDF_ID_SCRYPT_18, SCRYPT_SALT_SIZE, SCRYPT_OUTPUT_SIZE, SCRYPT_2_18_COST };
 static const wickr_kdf_algo_t KDF_SCRYPT_2_19 = { KDF_SCRYPT, KDF_ID_SCRYPT_19, SCRYPT_SALT_SIZE, SCRYPT_OUTPUT_SIZE, SCRYPT_2_19_COST };
 static const wickr_kdf_algo_t KDF_SCRYPT_2_20 = { KDF_SCRYPT, KDF_ID_SCRYPT_20, SCRYPT_SALT_SIZE, SCRYPT_OUTPUT_SIZE, SCRYPT_2_20_COST };
+static const wickr_kdf_algo_t KDF_SCRYPT_2_17_P4 = { KDF_SCRYPT, KDF_ID_SCRYPT_17_P4, SCRYPT_SALT_SIZE, SCRYPT_OUTPUT_SIZE, SCRYPT_2_17_P4_COST };
+static const wickr_kdf_algo_t KDF_SCRYPT_2_18_P4 = { KDF_SCRYPT, KDF_ID_SCRYPT_18_P4, SCRYPT_SALT_SIZE, SCRYPT_OUTPUT_SIZE, SCRYPT_2_18_P4_COST };
+
+/* ARGON2ID Mode Definitions */
+static const wickr_kdf_algo_t KDF_ARGON2ID_2_16 = { KDF_ARGON2ID, KDF_ID_ARGON2ID_16, ARGON2ID_SALT_SIZE, ARGON2ID_OUTPUT_SIZE, ARGON2ID_2_16_COST };
+static const wickr_kdf_algo_t KDF_ARGON2ID_2_18 = { KDF_ARGON2ID, KDF_ID_ARGON2ID_18, ARGON2ID_SALT_SIZE, ARGON2ID_OUTPUT_SIZE, ARGON2ID_2_18_COST };
+static const wickr_kdf_algo_t KDF_ARGON2ID_2_20 = { KDF_ARGON2ID, KDF_ID_ARGON2ID_20, ARGON2ID_SALT_SIZE, ARGON2ID_OUTPUT_SIZE, ARGON2ID_2_20_COST };
 
 /* BCRYPT Mode Definitions */
 static const wickr_kdf_algo_t KDF_BCRYPT_15 = { KDF_BCRYPT, KDF_ID_BCRYPT_15, BCRYPT_SALT_SIZE, BCRYPT_HASH_SIZE, BCRYPT_15_COST };
@@ -297,6 +330,24 @@ wickr_kdf_result_t *wickr_perform_kdf_meta(const wickr_kdf_meta_t *existing_meta
  */
 const wickr_kdf_algo_t *wickr_hkdf_algo_for_digest(wickr_digest_t digest);
 
+/**
+ 
+ @ingroup wickr_kdf
+ 
+ Find the strongest passphrase KDF mode that runs on the current machine within a latency and memory budget
+ 
+ The scrypt and Argon2id modes are benchmarked with a random passphrase in order of increasing memory multiplied by passes.
+ Modes that need more than 'max_memory' bytes of working memory are skipped and every other mode is run once. Modes that run
+ their lanes in parallel may finish sooner than weaker modes, so the strongest mode that took no longer than 'target_ms' is
+ chosen rather than stopping at the first mode over budget. Calibration takes about as long as all the modes that fit in memory
+ combined, so the result should be computed once per device and stored rather than recalculated for each operation
+ 
+ @param target_ms the longest a single execution of the KDF should take in milliseconds
+ @param max_memory the largest amount of working memory in bytes a single execution of the KDF may use
+ @return the strongest mode that meets both budgets, or NULL if no mode does
+ */
+const wickr_kdf_algo_t *wickr_kdf_calibrate(uint32_t target_ms, uint64_t max_memory);
+
 #ifdef __cplusplus
 }
 #endif
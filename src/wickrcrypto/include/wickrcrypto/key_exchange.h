@@ -122,6 +122,19 @@ wickr_exchange_array_t *wickr_exchange_array_new(uint32_t exchange_count);
  */
 bool wickr_exchange_array_set_item(wickr_exchange_array_t *array, uint32_t index, wickr_key_exchange_t *exchange);
 
+/**
+ @ingroup wickr_key_exchange
+ 
+ Append a key exchange to the end of a key exchange array, growing the array if needed
+ 
+ NOTE: Calling this function does not make a copy of 'exchange', the array simply takes ownership of it
+ 
+ @param array the array to append 'exchange' to
+ @param exchange the exchange to append
+ @return true if the append succeeds, false if the array could not grow
+ */
+bool wickr_exchange_array_push(wickr_exchange_array_t *array, wickr_key_exchange_t *exchange);
+
 /**
  @ingroup wickr_key_exchange
  
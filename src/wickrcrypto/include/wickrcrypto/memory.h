@@ -23,6 +23,8 @@
 #define memory_h
 
 #include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -65,6 +67,20 @@ void *wickr_alloc_zero(size_t len);
  */
 void wickr_free(void *buf);
 
+/**
+ 
+ @ingroup memory_functions
+ 
+ Fill memory with 0s in a way that the compiler can not remove, even if the memory is never read again
+ 
+ Uses memset_s, memset_explicit, SecureZeroMemory or explicit_bzero when the platform provides one, and otherwise a memset that
+ is followed by a compiler barrier
+
+ @param buf the memory to fill with 0s
+ @param len the number of bytes to fill with 0s
+ */
+void wickr_secure_zero(void *buf, size_t len);
+
 /**
  
  @ingroup memory_functions
@@ -76,6 +92,201 @@ void wickr_free(void *buf);
  */
 void wickr_free_zero(void *buf, size_t len);
 
+/**
+ 
+ @ingroup memory_functions
+ 
+ Allocation function used by a custom allocator
+ 
+ @param len the number of bytes to allocate, always greater than 0
+ @param user the user context of the allocator
+ @return a pointer to 'len' bytes of newly allocated memory, or NULL if the allocation fails
+ */
+typedef void *(*wickr_alloc_func)(size_t len, void *user);
+
+/**
+ 
+ @ingroup memory_functions
+ 
+ Free function used by a custom allocator
+ 
+ @param buf memory previously returned by the same allocator, never NULL
+ @param user the user context of the allocator
+ */
+typedef void (*wickr_free_func)(void *buf, void *user);
+
+/**
+ 
+ @ingroup memory_functions
+ @struct wickr_allocator
+ 
+ @brief A set of functions used for all memory allocated through wickr_alloc, wickr_alloc_zero, wickr_free and wickr_free_zero
+ 
+ @var wickr_allocator::alloc
+ function to allocate memory, required
+ @var wickr_allocator::alloc_zero
+ function to allocate zeroed memory. If NULL, memory from 'alloc' is filled with 0s instead
+ @var wickr_allocator::free
+ function to free memory allocated by 'alloc' or 'alloc_zero', required
+ @var wickr_allocator::user
+ context passed to each function of the allocator
+ */
+struct wickr_allocator {
+    wickr_alloc_func alloc;
+    wickr_alloc_func alloc_zero;
+    wickr_free_func free;
+    void *user;
+};
+
+typedef struct wickr_allocator wickr_allocator_t;
+
+/**
+ 
+ @ingroup memory_functions
+ 
+ Replace the allocator used by the library
+ 
+ Memory must be freed by the allocator that allocated it, so the allocator should be set before any other library function is
+ called and should not be changed while memory from the previous allocator is still live. This function is not thread safe
+ 
+ @param allocator the allocator to use, or NULL to restore the system allocator (malloc, calloc and free)
+ @return true if the allocator was set, false if 'allocator' is missing a required function
+ */
+bool wickr_set_allocator(const wickr_allocator_t *allocator);
+
+/**
+ 
+ @ingroup memory_functions
+ 
+ Get the allocator currently used by the library
+ 
+ @return the current allocator. This is useful for wrapping the current allocator with another one
+ */
+wickr_allocator_t wickr_get_allocator(void);
+
+/* The number of tags tracked by the instrumented allocator */
+#define WICKR_MEMORY_TAG_COUNT 32
+
+/* Allocations are attributed to this tag unless the calling thread sets another one */
+#define WICKR_MEMORY_TAG_DEFAULT 0
+
+/**
+ 
+ @ingroup memory_functions
+ 
+ Set the tag that allocations made by the calling thread are attributed to
+ 
+ Tags let an instrumented allocator account for memory per subsystem or call site. The library never sets a tag itself, so
+ choosing which calls are attributed to which subsystem is left to the caller. A typical use is to set a tag before calling into a
+ part of the library, such as the wickr_ctx packet functions or a transport context, and to restore the previous tag afterwards.
+ Tags outside of 0..WICKR_MEMORY_TAG_COUNT - 1 are accounted under WICKR_MEMORY_TAG_DEFAULT
+ 
+ @param tag the tag to attribute allocations from this thread to
+ @return the tag that was previously set for this thread
+ */
+uint32_t wickr_memory_tag_set(uint32_t tag);
+
+/**
+ 
+ @ingroup memory_functions
+ 
+ Get the tag that allocations made by the calling thread are attributed to
+ 
+ @return the current tag of the calling thread
+ */
+uint32_t wickr_memory_tag_get(void);
+
+/**
+ 
+ @ingroup memory_functions
+ @struct wickr_memory_stats
+ 
+ @brief Allocation statistics for a single tag of an instrumented allocator
+ 
+ @var wickr_memory_stats::live_bytes
+ the number of requested bytes that are currently allocated
+ @var wickr_memory_stats::live_allocations
+ the number of allocations that have not been freed
+ @var wickr_memory_stats::peak_bytes
+ the highest value of 'live_bytes' since the allocator was created or its peaks were reset
+ @var wickr_memory_stats::peak_allocations
+ the highest value of 'live_allocations' since the allocator was created or its peaks were reset
+ @var wickr_memory_stats::total_allocations
+ the number of allocations made since the allocator was created
+ */
+struct wickr_memory_stats {
+    uint64_t live_bytes;
+    uint64_t live_allocations;
+    uint64_t peak_bytes;
+    uint64_t peak_allocations;
+    uint64_t total_allocations;
+};
+
+typedef struct wickr_memory_stats wickr_memory_stats_t;
+
+struct wickr_instrumented_allocator;
+typedef struct wickr_instrumented_allocator wickr_instrumented_allocator_t;
+
+/**
+ 
+ @ingroup memory_functions
+ 
+ Create an allocator that tracks live and peak usage per tag on top of another allocator
+ 
+ Each allocation carries a small header recording its size and tag, so memory from the instrumented allocator can only be freed
+ by it. Statistics are protected by a lock and may be read while other threads allocate
+ 
+ @param backing the allocator that performs the underlying allocations, or NULL to use the system allocator. It is copied
+ @return a newly allocated instrumented allocator, or NULL if 'backing' is missing a required function
+ */
+wickr_instrumented_allocator_t *wickr_instrumented_allocator_create(const wickr_allocator_t *backing);
+
+/**
+ 
+ @ingroup memory_functions
+ 
+ Get the allocator functions of an instrumented allocator, to be passed to 'wickr_set_allocator'
+ 
+ @param allocator the instrumented allocator
+ @return allocator functions that account their allocations in 'allocator'
+ */
+wickr_allocator_t wickr_instrumented_allocator_get_hooks(wickr_instrumented_allocator_t *allocator);
+
+/**
+ 
+ @ingroup memory_functions
+ 
+ Get the statistics an instrumented allocator recorded for a tag
+ 
+ @param allocator the instrumented allocator
+ @param tag the tag to get statistics for
+ @param stats_out the location to write the statistics to
+ @return true if the statistics were written, false if 'tag' is out of range
+ */
+bool wickr_instrumented_allocator_get_stats(wickr_instrumented_allocator_t *allocator, uint32_t tag, wickr_memory_stats_t *stats_out);
+
+/**
+ 
+ @ingroup memory_functions
+ 
+ Reset the peak values of every tag to the current live values
+ 
+ @param allocator the instrumented allocator
+ */
+void wickr_instrumented_allocator_reset_peaks(wickr_instrumented_allocator_t *allocator);
+
+/**
+ 
+ @ingroup memory_functions
+ 
+ Destroy an instrumented allocator
+ 
+ The allocator must no longer be installed with 'wickr_set_allocator', and all memory allocated through it must have been freed
+ 
+ @param allocator a pointer to the instrumented allocator to destroy
+ */
+void wickr_instrumented_allocator_destroy(wickr_instrumented_allocator_t **allocator);
+
 #ifdef __cplusplus
 }
 #endif
@@ -129,7 +129,9 @@ bool wickr_node_rotate_keypair(wickr_node_t *node, wickr_ephemeral_keypair_t *ne
  Copy an node
  
  @param source the node to copy
- @return a newly allocated node holding a deep copy of the properties of 'source'
+ @return a newly allocated node holding a copy of the properties of 'source'. The device id and identity chain bytes may be shared with
+ 'source' rather than copied (see 'wickr_buffer_share'), so they must be treated as read only unless 'wickr_buffer_make_unique' is
+ called first
  */
 wickr_node_t *wickr_node_copy(const wickr_node_t *source);
 
@@ -184,6 +186,20 @@ wickr_node_array_t *wickr_node_array_new(uint32_t node_count);
  */
 bool wickr_node_array_set_item(wickr_array_t *array, uint32_t index, wickr_node_t *node);
 
+/**
+ 
+ @ingroup wickr_node
+ 
+ Append a node to the end of the node array, growing the array if needed
+
+ NOTE: 'node' is not copied into the array, ownership is simply transferred to the array
+ 
+ @param array the array to append a node to
+ @param node the node to append
+ @return true if the append succeeds, false if the array could not grow
+ */
+bool wickr_node_array_push(wickr_node_array_t *array, wickr_node_t *node);
+
 /**
  
  @ingroup wickr_node
@@ -205,7 +221,7 @@ wickr_node_t *wickr_node_array_fetch_item(const wickr_array_t *array, uint32_t i
  Make a deep copy of a node array
 
  @param array the array to copy
- @return a newly allocated wickr_node_array that contains a copy of each element from 'array'
+ @return a newly allocated wickr_node_array that contains a copy of each element from 'array', made with 'wickr_node_copy'
  */
 wickr_node_array_t *wickr_node_array_copy(const wickr_node_array_t *array);
     
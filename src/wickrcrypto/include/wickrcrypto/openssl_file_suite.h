@@ -25,6 +25,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "buffer.h"
+#include "cipher.h"
+#include "digest.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,12 +35,76 @@ extern "C" {
 
 /**  @addtogroup openssl_file_encryption File Encryption With OpenSSL */
 
+/* Files of at least this size are processed using memory maps where they are supported */
+#define OPENSSL_FILE_MMAP_DEFAULT_THRESHOLD (4 * 1024 * 1024)
+
+/* The number of bytes passed to the cipher at a time when processing memory mapped files */
+#define OPENSSL_FILE_MMAP_CHUNK_SIZE (16 * 1024 * 1024)
+
+#define OPENSSL_FILE_PIPELINE_DEFAULT_CHUNK_SIZE (1024 * 1024)
+#define OPENSSL_FILE_PIPELINE_DEFAULT_BUFFER_COUNT 3
+#define OPENSSL_FILE_PIPELINE_MIN_BUFFER_COUNT 2
+#define OPENSSL_FILE_PIPELINE_MAX_BUFFER_COUNT 16
+
+/**
+ @ingroup openssl_file_encryption
+ 
+ @struct openssl_file_pipeline_config
+ 
+ @brief Configuration of the pipelined mode of 'openssl_aes256_file_encrypt' and 'openssl_aes256_file_decrypt'
+ 
+ In pipelined mode, a reader thread, the calling thread running the cipher, and a writer thread work on a ring of buffers,
+ so that disk reads, the cipher and disk writes overlap. The output is identical to the other implementations
+ 
+ @var openssl_file_pipeline_config::enabled
+ if true, the pipelined mode is used for all files instead of memory maps or stdio
+ @var openssl_file_pipeline_config::chunk_size
+ the size in bytes of each buffer in the ring, up to INT_MAX
+ @var openssl_file_pipeline_config::buffer_count
+ the number of buffers in the ring, between OPENSSL_FILE_PIPELINE_MIN_BUFFER_COUNT and OPENSSL_FILE_PIPELINE_MAX_BUFFER_COUNT
+ */
+struct openssl_file_pipeline_config {
+    bool enabled;
+    size_t chunk_size;
+    uint32_t buffer_count;
+};
+
+typedef struct openssl_file_pipeline_config openssl_file_pipeline_config_t;
+
+/*
+ Segmented file format (version 1)
+ 
+ magic (4) | version (1) | cipher id (1) | segment size (4) | plaintext length (8) | file nonce (iv_len) | segment 0 | ... | segment n
+ 
+ All integers are big endian. Each segment is the ciphertext of up to 'segment size' bytes of plaintext followed by an auth tag.
+ The nonce of a segment is the file nonce with the big endian segment index xored into its last 8 bytes. Each segment authenticates
+ the header and its own index as additional data, so the header and the number of segments are authenticated by every segment
+ */
+#define OPENSSL_FILE_SEGMENTED_MAGIC "WSEG"
+#define OPENSSL_FILE_SEGMENTED_MAGIC_LEN 4
+#define OPENSSL_FILE_SEGMENTED_VERSION 1
+#define OPENSSL_FILE_SEGMENTED_HEADER_FIXED_LEN 18
+#define OPENSSL_FILE_SEGMENTED_HEADER_MAX_LEN 64
+
+#define OPENSSL_FILE_SEGMENTED_DEFAULT_SEGMENT_SIZE (64 * 1024)
+#define OPENSSL_FILE_SEGMENTED_MIN_SEGMENT_SIZE 1024
+#define OPENSSL_FILE_SEGMENTED_MAX_SEGMENT_SIZE (16 * 1024 * 1024)
+#define OPENSSL_FILE_SEGMENTED_MAX_LENGTH (1ULL << 48)
+
+#define OPENSSL_FILE_SEGMENTED_DEFAULT_THREADS 4
+#define OPENSSL_FILE_SEGMENTED_MAX_THREADS 64
+
+#define OPENSSL_TREE_DIGEST_DEFAULT_THREADS 4
+#define OPENSSL_TREE_DIGEST_MAX_THREADS 64
+
 /**
  @ingroup openssl_file_encryption
  
  Encrypt a file to another file
  
  Utilizes a small amount of stack memory to encrypt a large file. This function is byte-format compatible with standard memory-based AES functions from this library.
+ On platforms that support it, files at or above the threshold set by 'openssl_aes256_file_set_mmap_threshold' are memory mapped instead of read with stdio.
+ The reads, encryption and writes are overlapped on separate threads if enabled with 'openssl_aes256_file_set_pipeline_config'.
 
  @param key the cipher key to use for the encryption operation
  @param sourceFilePath the path to the source file to encrypt
@@ -54,6 +120,8 @@ bool openssl_aes256_file_encrypt(const wickr_cipher_key_t *key, const char *sour
  Decrypt a file to another file
  
  Utilizes a small amount of stack memory to decrypt a large file. This function is byte-format compatible with standard memory-based AES functions from this library.
+ Files in the segmented file format are detected and decrypted using 'openssl_aes256_file_decrypt_segmented'.
+ Memory maps and the pipelined mode are used in the same way as 'openssl_aes256_file_encrypt'.
 
  @param key the cipher key to use for the decryption operation
  @param sourceFilePath the path to the source file to decrypt
@@ -63,6 +131,268 @@ bool openssl_aes256_file_encrypt(const wickr_cipher_key_t *key, const char *sour
  */
 bool openssl_aes256_file_decrypt(const wickr_cipher_key_t *key, const char *sourceFilePath, const char *destinationFilePath, bool only_auth_ciphers);
 
+/**
+ @ingroup openssl_file_encryption
+ 
+ Encrypt a file to another file, and calculate digests of the plaintext and ciphertext in the same pass over the data
+ 
+ The output is identical to 'openssl_aes256_file_encrypt'. Files below the memory map threshold are processed in the pipelined mode.
+ The ciphertext digest covers the whole encrypted file, which starts with a header that contains the auth tag. A tree digest holds
+ its first leaf until the header is known, but the other digests can't, so their ciphertext digest is calculated by reading the
+ encrypted file back before it is moved into place
+
+ @param key the cipher key to use for the encryption operation
+ @param sourceFilePath the path to the source file to encrypt
+ @param destinationFilePath the location to save the encrypted file
+ @param digest_mode the digest to calculate, any SHA2 or tree digest
+ @param plaintext_digest set to the digest of the contents of 'sourceFilePath' on success, or NULL if it isn't needed
+ @param ciphertext_digest set to the digest of the contents of 'destinationFilePath' on success, or NULL if it isn't needed
+ @return true if the encryption succeeds and the requested digests were calculated. At least one digest must be requested
+ */
+bool openssl_aes256_file_encrypt_digest(const wickr_cipher_key_t *key,
+                                        const char *sourceFilePath,
+                                        const char *destinationFilePath,
+                                        wickr_digest_t digest_mode,
+                                        wickr_buffer_t **plaintext_digest,
+                                        wickr_buffer_t **ciphertext_digest);
+
+/**
+ @ingroup openssl_file_encryption
+ 
+ Decrypt a file to another file, and calculate digests of the ciphertext and plaintext in the same pass over the data
+ 
+ Files in the segmented file format are not supported, since their segments are processed independently
+
+ @param key the cipher key to use for the decryption operation
+ @param sourceFilePath the path to the source file to decrypt
+ @param destinationFilePath the location to save the decrypted file
+ @param only_auth_ciphers if true, only authenticated ciphers may be used for decryption
+ @param digest_mode the digest to calculate, any SHA2 or tree digest
+ @param plaintext_digest set to the digest of the contents of 'destinationFilePath' on success, or NULL if it isn't needed
+ @param ciphertext_digest set to the digest of the contents of 'sourceFilePath' on success, or NULL if it isn't needed
+ @return true if the decryption succeeds and the requested digests were calculated. At least one digest must be requested
+ */
+bool openssl_aes256_file_decrypt_digest(const wickr_cipher_key_t *key,
+                                        const char *sourceFilePath,
+                                        const char *destinationFilePath,
+                                        bool only_auth_ciphers,
+                                        wickr_digest_t digest_mode,
+                                        wickr_buffer_t **plaintext_digest,
+                                        wickr_buffer_t **ciphertext_digest);
+
+/**
+ @ingroup openssl_file_encryption
+ 
+ Set the minimum source file size for which 'openssl_aes256_file_encrypt' and 'openssl_aes256_file_decrypt' use memory maps
+ 
+ Memory maps are only used on platforms that support them, and the stdio implementation is used if a file can't be mapped.
+ This setting is global, and should be configured before any file operations are started
+ 
+ @param threshold the minimum file size in bytes. The default is OPENSSL_FILE_MMAP_DEFAULT_THRESHOLD. Pass UINT64_MAX to always use stdio
+ */
+void openssl_aes256_file_set_mmap_threshold(uint64_t threshold);
+
+/**
+ @ingroup openssl_file_encryption
+ 
+ Get the minimum source file size for which memory maps are used
+ 
+ @return the threshold set by 'openssl_aes256_file_set_mmap_threshold'
+ */
+uint64_t openssl_aes256_file_get_mmap_threshold(void);
+
+/**
+ @ingroup openssl_file_encryption
+ 
+ Configure the pipelined mode of 'openssl_aes256_file_encrypt' and 'openssl_aes256_file_decrypt'
+ 
+ This setting is global, and also applies to the file functions of the default crypto engine. It should be configured before
+ any file operations are started. The pipelined mode is disabled by default
+ 
+ @param config the pipeline configuration to use
+ @return true if the configuration is valid and was applied
+ */
+bool openssl_aes256_file_set_pipeline_config(openssl_file_pipeline_config_t config);
+
+/**
+ @ingroup openssl_file_encryption
+ 
+ Get the current configuration of the pipelined mode
+ 
+ @return the configuration set by 'openssl_aes256_file_set_pipeline_config'
+ */
+openssl_file_pipeline_config_t openssl_aes256_file_get_pipeline_config(void);
+
+/**
+ @ingroup openssl_file_encryption
+ 
+ Encrypt a file to another file using the segmented file format
+ 
+ The file is split into fixed size segments that are each encrypted and authenticated independently, which allows the work to be
+ split across multiple threads, and allows ranges of the file to be decrypted with 'openssl_aes256_file_decrypt_range'.
+ Only authenticated ciphers are supported
+
+ @param key the cipher key to use for the encryption operation
+ @param sourceFilePath the path to the source file to encrypt
+ @param destinationFilePath the location to save the encrypted file
+ @param segment_size the number of plaintext bytes in each segment, between OPENSSL_FILE_SEGMENTED_MIN_SEGMENT_SIZE and OPENSSL_FILE_SEGMENTED_MAX_SEGMENT_SIZE
+ @param thread_count the number of threads to split the work across, including the calling thread. Values of 0 are treated as 1
+ @return true if the encryption succeeds, false if the paths are inaccessible, the parameters are invalid, or the encryption operation fails
+ */
+bool openssl_aes256_file_encrypt_segmented(const wickr_cipher_key_t *key,
+                                           const char *sourceFilePath,
+                                           const char *destinationFilePath,
+                                           uint32_t segment_size,
+                                           uint32_t thread_count);
+
+/**
+ @ingroup openssl_file_encryption
+ 
+ Decrypt a file in the segmented file format to another file
+ 
+ Every segment is authenticated before the decrypted file is moved to 'destinationFilePath', so no output is produced for a file
+ that has been modified, truncated or extended
+
+ @param key the cipher key to use for the decryption operation
+ @param sourceFilePath the path to the source file to decrypt
+ @param destinationFilePath the location to save the decrypted file
+ @param thread_count the number of threads to split the work across, including the calling thread. Values of 0 are treated as 1
+ @return true if the decryption succeeds, false if the paths are inaccessible, the file is not in the segmented format, or any segment fails to authenticate
+ */
+bool openssl_aes256_file_decrypt_segmented(const wickr_cipher_key_t *key,
+                                           const char *sourceFilePath,
+                                           const char *destinationFilePath,
+                                           uint32_t thread_count);
+
+/**
+ @ingroup openssl_file_encryption
+ 
+ Decrypt a range of bytes from a file in the segmented file format
+ 
+ Only the segments that contain the range are read and authenticated, which makes this suitable for streaming playback and seeking
+ within large files. Modifications to other segments of the file are not detected
+
+ @param key the cipher key to use for the decryption operation
+ @param sourceFilePath the path to the encrypted file
+ @param offset the offset into the plaintext of the first byte to decrypt
+ @param length the number of plaintext bytes to decrypt. Ranges that extend past the end of the file are truncated to the end of the file
+ @return a buffer containing the plaintext of the range, or NULL if the file can't be read, 'offset' is past the end of the file, or a segment fails to authenticate
+ */
+wickr_buffer_t *openssl_aes256_file_decrypt_range(const wickr_cipher_key_t *key,
+                                                  const char *sourceFilePath,
+                                                  uint64_t offset,
+                                                  uint64_t length);
+
+/**
+ @ingroup openssl_file_encryption
+ 
+ Read the plaintext length of a file in the segmented file format
+ 
+ The length is read from the header of the file and is not authenticated until a segment of the file is decrypted
+
+ @param sourceFilePath the path to the encrypted file
+ @param length set to the length of the plaintext of the file on success
+ @return true if the file is in the segmented file format and its header is valid
+ */
+bool openssl_aes256_file_segmented_length(const char *sourceFilePath, uint64_t *length);
+
+/**  @addtogroup openssl_tree_digest Tree Digests With OpenSSL */
+
+/**
+ @ingroup openssl_tree_digest
+ 
+ Calculate the tree digest of a buffer
+ 
+ See DIGEST_TREE_LEAF_SIZE for the structure of the tree. The leaves are hashed in parallel using the number of threads set by
+ 'openssl_sha2_tree_set_thread_count'
+
+ @param buffer the buffer to hash
+ @param mode the tree digest to use, DIGEST_SHA_256_TREE or DIGEST_SHA_512_TREE
+ @return the root of the tree, or NULL if 'mode' is not a tree digest
+ */
+wickr_buffer_t *openssl_sha2_tree(const wickr_buffer_t *buffer, wickr_digest_t mode);
+
+/**
+ @ingroup openssl_tree_digest
+ 
+ Calculate the tree digest of a file
+ 
+ The file is hashed from its current position to its end. On platforms that support it, regular files larger than a single leaf
+ are memory mapped, otherwise leaves are read with stdio in batches and each batch is hashed in parallel
+
+ @param in_file the file to hash
+ @param mode the tree digest to use, DIGEST_SHA_256_TREE or DIGEST_SHA_512_TREE
+ @return the root of the tree, or NULL if the file can't be read or 'mode' is not a tree digest
+ */
+wickr_buffer_t *openssl_sha2_tree_file(FILE *in_file, wickr_digest_t mode);
+
+/**
+ @ingroup openssl_tree_digest
+ 
+ Calculate the leaf hashes of the tree digest of a file
+ 
+ The leaf hashes can be distributed along with the file so that a receiver can verify each leaf sized chunk of the file with
+ 'openssl_sha2_tree_verify_chunk' as it is downloaded, instead of waiting for the whole file
+
+ @param in_file the file to hash, from its current position to its end
+ @param mode the tree digest to use, DIGEST_SHA_256_TREE or DIGEST_SHA_512_TREE
+ @return the leaf hashes concatenated in order, each 'mode.size' bytes long, or NULL if the file can't be read or 'mode' is not a tree digest
+ */
+wickr_buffer_t *openssl_sha2_tree_file_leaves(FILE *in_file, wickr_digest_t mode);
+
+/**
+ @ingroup openssl_tree_digest
+ 
+ Calculate the root of a tree digest from its leaf hashes
+
+ @param leaves the leaf hashes concatenated in order, as returned by 'openssl_sha2_tree_file_leaves'
+ @param mode the tree digest that was used to create 'leaves'
+ @return the root of the tree, or NULL if the length of 'leaves' is not a multiple of 'mode.size' or 'mode' is not a tree digest
+ */
+wickr_buffer_t *openssl_sha2_tree_root(const wickr_buffer_t *leaves, wickr_digest_t mode);
+
+/**
+ @ingroup openssl_tree_digest
+ 
+ Verify a single leaf sized chunk of data against a trusted tree digest
+ 
+ 'leaves' is checked against 'root' on every call. Callers verifying many chunks of the same file can check the leaves once
+ with 'openssl_sha2_tree_root' and compare the hashes of later chunks to them directly
+
+ @param chunk the chunk of data at leaf 'index'. It must be DIGEST_TREE_LEAF_SIZE bytes long unless it is the last leaf
+ @param index the index of the leaf that 'chunk' represents
+ @param leaves the leaf hashes of the whole input, which do not need to be trusted
+ @param root the trusted root of the tree
+ @param mode the tree digest that was used to create 'root'
+ @return true if 'leaves' match 'root' and 'chunk' matches the leaf at 'index'
+ */
+bool openssl_sha2_tree_verify_chunk(const wickr_buffer_t *chunk,
+                                    uint64_t index,
+                                    const wickr_buffer_t *leaves,
+                                    const wickr_buffer_t *root,
+                                    wickr_digest_t mode);
+
+/**
+ @ingroup openssl_tree_digest
+ 
+ Set the number of threads used to hash the leaves of tree digests
+ 
+ This setting is global, and also applies to the digest functions of the default crypto engine. It should be configured before
+ any digests are started
+
+ @param thread_count the number of threads, including the calling thread. Values are limited to between 1 and OPENSSL_TREE_DIGEST_MAX_THREADS
+ */
+void openssl_sha2_tree_set_thread_count(uint32_t thread_count);
+
+/**
+ @ingroup openssl_tree_digest
+ 
+ Get the number of threads used to hash the leaves of tree digests
+ 
+ @return the thread count set by 'openssl_sha2_tree_set_thread_count'. The default is OPENSSL_TREE_DIGEST_DEFAULT_THREADS
+ */
+uint32_t openssl_sha2_tree_get_thread_count(void);
+
 #ifdef __cplusplus
 }
 #endif
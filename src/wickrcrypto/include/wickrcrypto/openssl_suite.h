@@ -93,11 +93,90 @@ wickr_buffer_t *openssl_aes256_decrypt(const wickr_cipher_result_t *cipher_resul
                                        const wickr_cipher_key_t *key,
                                        bool only_auth_ciphers);
 
+/**
+ @ingroup openssl_crypto
+ 
+ Begin an incremental AES256 encryption
+ Currently supports AES256-GCM and AES256-CTR cipher modes
+ 
+ NOTE: IV is randomly chosen using 'openssl_crypto_random' if one is not provided
+ 
+ @param aad additional data to authenticate with the ciphertext (only works with authenticated ciphers)
+ @param key the cipher key to use for encryption
+ @param iv an initialization vector to use with the cipher mode, or NULL if one should be chosen at random
+ @return a newly allocated cipher stream or NULL if the cipher mode is not supported
+ */
+wickr_cipher_stream_t *openssl_aes256_stream_encrypt_init(const wickr_buffer_t *aad,
+                                                          const wickr_cipher_key_t *key,
+                                                          const wickr_buffer_t *iv);
+
+/**
+ @ingroup openssl_crypto
+ 
+ Begin an incremental AES256 decryption
+ Currently supports AES256-GCM and AES256-CTR cipher modes
+ 
+ @param header a cipher result containing the iv and auth tag of the ciphertext to decrypt, such as one parsed from the header of a serialized cipher result. Its cipher text is ignored
+ @param aad additional data to authenticate with the ciphertext (only works with authenticated ciphers)
+ @param key the key to use to attempt to decrypt the ciphertext
+ @param only_auth_ciphers if true, only authenticated ciphers may be used for decryption
+ @return a newly allocated cipher stream or NULL if the cipher mode is not supported
+ */
+wickr_cipher_stream_t *openssl_aes256_stream_decrypt_init(const wickr_cipher_result_t *header,
+                                                          const wickr_buffer_t *aad,
+                                                          const wickr_cipher_key_t *key,
+                                                          bool only_auth_ciphers);
+
+/**
+ @ingroup openssl_crypto
+ 
+ Encrypt or decrypt the next part of the input of a cipher stream
+ 
+ NOTE: Decrypted output is not authenticated until 'openssl_aes256_stream_decrypt_final' succeeds
+ 
+ @param stream the cipher stream to update
+ @param input the next part of the plaintext or ciphertext
+ @return a buffer the same length as 'input' containing the next part of the output, or NULL if the stream has been finalized or the cipher fails
+ */
+wickr_buffer_t *openssl_aes256_stream_update(wickr_cipher_stream_t *stream, const wickr_buffer_t *input);
+
+/**
+ @ingroup openssl_crypto
+ 
+ Finish an incremental encryption
+ 
+ NOTE: The auth tag is serialized ahead of the cipher text, so output written to a destination that can't seek must be held back
+ until this is called. Output above MAX_BUFFER_SIZE can't be parsed with 'wickr_cipher_result_from_buffer', only by a decryption stream
+ 
+ @param stream the encryption stream to finish. No further updates can be made to it
+ @return a cipher result containing the iv and auth tag of the stream with no cipher text, or NULL if the stream is not an encryption stream or has already been finalized
+ */
+wickr_cipher_result_t *openssl_aes256_stream_encrypt_final(wickr_cipher_stream_t *stream);
+
+/**
+ @ingroup openssl_crypto
+ 
+ Finish an incremental decryption
+ 
+ @param stream the decryption stream to finish. No further updates can be made to it
+ @return true if the auth tag of the stream is valid for all of the ciphertext that was passed to it. Always true for unauthenticated ciphers
+ */
+bool openssl_aes256_stream_decrypt_final(wickr_cipher_stream_t *stream);
+
+/**
+ @ingroup openssl_crypto
+ 
+ Destroy a cipher stream
+ 
+ @param stream a pointer to the cipher stream to destroy. Will set the value of 'stream' to NULL
+ */
+void openssl_aes256_stream_destroy(wickr_cipher_stream_t **stream);
+
 /**
  @ingroup openssl_crypto
  
  Calculate a SHA2 hash of a buffer using an optional salt value
- Supported modes of SHA2 are SHA256, SHA384 and SHA512
+ Supported modes of SHA2 are SHA256, SHA384 and SHA512. The tree digests are calculated with 'openssl_sha2_tree', and don't support a salt
  
  @param buffer the buffer to hash
  @param salt a salt value to concatenate to buffer before taking the hash. The input to the SHA2 function will be SHA2(buffer || salt)
@@ -218,10 +297,29 @@ wickr_buffer_t *openssl_hkdf(const wickr_buffer_t *input_key_material,
                              const wickr_buffer_t *info,
                              wickr_digest_t hash_mode);
 
+/**
+ @ingroup openssl_crypto
+ 
+ Derive a key with PBKDF2 using HMAC as the pseudorandom function
+
+ @param passphrase the passphrase to derive a key from
+ @param salt a salt value to provide to PBKDF2, may be empty
+ @param iterations the number of iterations to perform, must be at least 1
+ @param hash_mode the digest to use for HMAC
+ @param output_len the number of bytes to derive
+ @return a buffer of 'output_len' bytes containing the derived key. NULL on failure
+ */
+wickr_buffer_t *openssl_pbkdf2(const wickr_buffer_t *passphrase,
+                               const wickr_buffer_t *salt,
+                               uint32_t iterations,
+                               wickr_digest_t hash_mode,
+                               size_t output_len);
+
 /**
  @ingroup openssl_crypto
  
  Calculate the SHA2 hash of a file
+ The tree digests are calculated in parallel with 'openssl_sha2_tree_file'
 
  @param in_file a file to take the hash of it's contents
  @param mode the mode to use for calculating the hash
@@ -229,6 +327,56 @@ wickr_buffer_t *openssl_hkdf(const wickr_buffer_t *input_key_material,
  */
 wickr_buffer_t *openssl_sha2_file(FILE *in_file, wickr_digest_t mode);
 
+/**
+ @ingroup openssl_crypto
+ 
+ Begin an incremental SHA2 operation
+ 
+ @param mode the mode of SHA2 to use for hashing
+ @return a newly allocated digest context or NULL if 'mode' is not supported
+ */
+wickr_digest_ctx_t *openssl_sha2_ctx_create(wickr_digest_t mode);
+
+/**
+ @ingroup openssl_crypto
+ 
+ Add data to an incremental SHA2 operation
+ 
+ @param ctx the digest context to update
+ @param buffer the data to add to the digest
+ @return true if the digest context could be updated
+ */
+bool openssl_sha2_ctx_update(wickr_digest_ctx_t *ctx, const wickr_buffer_t *buffer);
+
+/**
+ @ingroup openssl_crypto
+ 
+ Calculate the SHA2 hash of all data added to 'ctx' so far without modifying 'ctx'
+ 
+ @param ctx the digest context to calculate the hash of
+ @return a buffer containing the output of the chosen SHA2 mode or NULL if the hashing operation fails
+ */
+wickr_buffer_t *openssl_sha2_ctx_final(const wickr_digest_ctx_t *ctx);
+
+/**
+ @ingroup openssl_crypto
+ 
+ Copy an incremental SHA2 context
+ 
+ @param ctx the digest context to copy
+ @return a newly allocated digest context holding the same state as 'ctx'
+ */
+wickr_digest_ctx_t *openssl_sha2_ctx_copy(const wickr_digest_ctx_t *ctx);
+
+/**
+ @ingroup openssl_crypto
+ 
+ Destroy an incremental SHA2 context
+ 
+ @param ctx a pointer to the digest context to destroy. Will set the value of 'ctx' to NULL
+ */
+void openssl_sha2_ctx_destroy(wickr_digest_ctx_t **ctx);
+
 /**
  @ingroup openssl_crypto
  
@@ -40,6 +40,18 @@ extern "C" {
  */
 wickr_buffer_t *wickr_buffer_from_protobytes(ProtobufCBinaryData buffer);
     
+/**
+ 
+ @ingroup wickr_buffer
+ 
+ Create a shared wickr buffer from a protocol buffer binary data structure. Use this for immutable data that is copied often,
+ see wickr_buffer_create_shared
+ 
+ @param buffer the protocol buffer binary data to create the wickr_buffer from
+ @return a shared wickr_buffer containing the contents of 'buffer' or NULL
+ */
+wickr_buffer_t *wickr_buffer_shared_from_protobytes(ProtobufCBinaryData buffer);
+    
 /**
  @ingroup wickr_buffer
 
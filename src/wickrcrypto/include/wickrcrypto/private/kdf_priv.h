@@ -0,0 +1,67 @@
+/*
+* Copyright © 2012-2020 Wickr Inc.  All rights reserved.
+*
+* This code is being released for EDUCATIONAL, ACADEMIC, AND CODE REVIEW PURPOSES
+* ONLY.  COMMERCIAL USE OF THE CODE IS EXPRESSLY PROHIBITED.  For additional details,
+* please see LICENSE
+*
+* THE CODE IS MADE AVAILABLE "AS-IS" AND WITHOUT ANY EXPRESS OR
+* IMPLIED GUARANTEES AS TO FITNESS, MERCHANTABILITY, NON-
+* INFRINGEMENT OR OTHERWISE. IT IS NOT BEING PROVIDED IN TRADE BUT ON
+* A VOLUNTARY BASIS ON BEHALF OF THE AUTHOR’S PART FOR THE BENEFIT
+* OF THE LICENSEE AND IS NOT MADE AVAILABLE FOR CONSUMER USE OR ANY
+* OTHER USE OUTSIDE THE TERMS OF THIS LICENSE. ANYONE ACCESSING THE
+* CODE SHOULD HAVE THE REQUISITE EXPERTISE TO SECURE THEIR SYSTEM
+* AND DEVICES AND TO ACCESS AND USE THE CODE FOR REVIEW PURPOSES
+* ONLY. LICENSEE BEARS THE RISK OF ACCESSING AND USING THE CODE. IN
+* PARTICULAR, AUTHOR BEARS NO LIABILITY FOR ANY INTERFERENCE WITH OR
+* ADVERSE EFFECT THAT MAY OCCUR AS A RESULT OF THE LICENSEE
+* ACCESSING AND/OR USING THE CODE ON LICENSEE’S SYSTEM.
+*/
+
+#ifndef kdf_priv_h
+#define kdf_priv_h
+
+#include "kdf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The upper bound on the number of threads used to compute scrypt lanes */
+#define SCRYPT_PARALLEL_MAX_THREADS 64
+
+/*
+ Compute scrypt with the lanes (the 'p' parameter) of the function spread across up to 'max_threads' threads. The output is
+ identical to a serial scrypt implementation with the same parameters. Passing 0 for 'max_threads' uses one thread per lane,
+ limited by the number of online processors. Each thread holds 128 * r * N bytes of working memory while it runs
+ */
+wickr_buffer_t *wickr_scrypt_parallel(const wickr_buffer_t *passphrase,
+                                      const wickr_buffer_t *salt,
+                                      uint64_t N,
+                                      uint32_t r,
+                                      uint32_t p,
+                                      uint32_t max_threads,
+                                      size_t output_len);
+
+/* The upper bound on the number of threads used to fill argon2 lanes */
+#define ARGON2_PARALLEL_MAX_THREADS 64
+
+/*
+ Compute Argon2id (RFC 9106, version 0x13) with 'm_cost' KiB of memory, 't_cost' passes and 'lanes' lanes. The lanes of each
+ slice are filled on up to 'max_threads' threads, and passing 0 for 'max_threads' uses one thread per lane limited by the number
+ of online processors. The output does not depend on the number of threads
+ */
+wickr_buffer_t *wickr_argon2id(const wickr_buffer_t *passphrase,
+                               const wickr_buffer_t *salt,
+                               uint32_t m_cost,
+                               uint32_t t_cost,
+                               uint32_t lanes,
+                               uint32_t max_threads,
+                               size_t output_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* kdf_priv_h */
@@ -0,0 +1,55 @@
+/*
+* Copyright © 2012-2020 Wickr Inc.  All rights reserved.
+*
+* This code is being released for EDUCATIONAL, ACADEMIC, AND CODE REVIEW PURPOSES
+* ONLY.  COMMERCIAL USE OF THE CODE IS EXPRESSLY PROHIBITED.  For additional details,
+* please see LICENSE
+*
+* THE CODE IS MADE AVAILABLE "AS-IS" AND WITHOUT ANY EXPRESS OR
+* IMPLIED GUARANTEES AS TO FITNESS, MERCHANTABILITY, NON-
+* INFRINGEMENT OR OTHERWISE. IT IS NOT BEING PROVIDED IN TRADE BUT ON
+* A VOLUNTARY BASIS ON BEHALF OF THE AUTHOR’S PART FOR THE BENEFIT
+* OF THE LICENSEE AND IS NOT MADE AVAILABLE FOR CONSUMER USE OR ANY
+* OTHER USE OUTSIDE THE TERMS OF THIS LICENSE. ANYONE ACCESSING THE
+* CODE SHOULD HAVE THE REQUISITE EXPERTISE TO SECURE THEIR SYSTEM
+* AND DEVICES AND TO ACCESS AND USE THE CODE FOR REVIEW PURPOSES
+* ONLY. LICENSEE BEARS THE RISK OF ACCESSING AND USING THE CODE. IN
+* PARTICULAR, AUTHOR BEARS NO LIABILITY FOR ANY INTERFERENCE WITH OR
+* ADVERSE EFFECT THAT MAY OCCUR AS A RESULT OF THE LICENSEE
+* ACCESSING AND/OR USING THE CODE ON LICENSEE’S SYSTEM.
+*/
+
+#ifndef memory_priv_h
+#define memory_priv_h
+
+#include "memory.h"
+#include "arena.h"
+#include "secure_heap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef _WIN32
+#define WICKR_THREAD_LOCAL __declspec(thread)
+#else
+#define WICKR_THREAD_LOCAL __thread
+#endif
+
+/* Determine if allocations currently go straight to malloc and free rather than to hooks set with wickr_set_allocator */
+bool wickr_allocator_is_system(void);
+
+/* Allocate from the active arena of the calling thread. Returns NULL if no arena is active so the caller can fall back */
+void *wickr_arena_alloc_active(size_t len, bool zero);
+
+/* Determine if 'buf' was allocated from an arena with an open scope on the calling thread */
+bool wickr_arena_owns(const void *buf);
+
+/* Zero a chunk of the secure heap and return it to the free list of its size class. 'buf' must satisfy wickr_secure_heap_owns */
+void wickr_secure_heap_free(void *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* memory_priv_h */
@@ -0,0 +1,96 @@
+/*
+ * Copyright © 2012-2020 Wickr Inc.  All rights reserved.
+ *
+ * This code is being released for EDUCATIONAL, ACADEMIC, AND CODE REVIEW PURPOSES
+ * ONLY.  COMMERCIAL USE OF THE CODE IS EXPRESSLY PROHIBITED.  For additional details,
+ * please see LICENSE
+ *
+ * THE CODE IS MADE AVAILABLE "AS-IS" AND WITHOUT ANY EXPRESS OR
+ * IMPLIED GUARANTEES AS TO FITNESS, MERCHANTABILITY, NON-
+ * INFRINGEMENT OR OTHERWISE. IT IS NOT BEING PROVIDED IN TRADE BUT ON
+ * A VOLUNTARY BASIS ON BEHALF OF THE AUTHOR’S PART FOR THE BENEFIT
+ * OF THE LICENSEE AND IS NOT MADE AVAILABLE FOR CONSUMER USE OR ANY
+ * OTHER USE OUTSIDE THE TERMS OF THIS LICENSE. ANYONE ACCESSING THE
+ * CODE SHOULD HAVE THE REQUISITE EXPERTISE TO SECURE THEIR SYSTEM
+ * AND DEVICES AND TO ACCESS AND USE THE CODE FOR REVIEW PURPOSES
+ * ONLY. LICENSEE BEARS THE RISK OF ACCESSING AND USING THE CODE. IN
+ * PARTICULAR, AUTHOR BEARS NO LIABILITY FOR ANY INTERFERENCE WITH OR
+ * ADVERSE EFFECT THAT MAY OCCUR AS A RESULT OF THE LICENSEE
+ * ACCESSING AND/OR USING THE CODE ON LICENSEE’S SYSTEM.
+ */
+
+#ifndef proto_arena_priv_h
+#define proto_arena_priv_h
+
+#include <protobuf-c/protobuf-c.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bytes available on the stack before a proto arena starts allocating blocks */
+#define WICKR_PROTO_ARENA_STACK_SIZE 1024
+
+/* Size of each block a proto arena allocates once its stack space is used up */
+#define WICKR_PROTO_ARENA_BLOCK_SIZE 4096
+
+struct wickr_proto_arena_block;
+
+/**
+ @ingroup wickr_arena
+ @struct wickr_proto_arena
+ @brief A protobuf-c allocator that serves the allocations of an unpack from a bump region
+ 
+ Passing 'allocator' to a protobuf-c unpack function places the unpacked message, its nested messages and its bytes fields in
+ the arena. Individual frees are ignored, and the whole message is zeroed and released at once by 'wickr_proto_arena_release',
+ which replaces the call to the matching free_unpacked function. Small messages fit in the inline stack space, larger ones
+ spill over into blocks from wickr_alloc.
+ 
+ A proto arena refers to itself once it is initialized, so it must not be copied. Data borrowed from an unpacked message is only
+ valid until the arena is released
+ 
+ @var wickr_proto_arena::allocator
+ the protobuf-c allocator to pass to unpack functions
+ @var wickr_proto_arena::blocks
+ blocks allocated after the stack space ran out, most recent first
+ @var wickr_proto_arena::stack_used
+ the number of bytes of 'stack' that have been handed out
+ @var wickr_proto_arena::stack
+ inline space used before any blocks are allocated
+ */
+struct wickr_proto_arena {
+    ProtobufCAllocator allocator;
+    struct wickr_proto_arena_block *blocks;
+    size_t stack_used;
+    uint8_t stack[WICKR_PROTO_ARENA_STACK_SIZE];
+};
+
+typedef struct wickr_proto_arena wickr_proto_arena_t;
+
+/**
+ @ingroup wickr_arena
+ 
+ Prepare a proto arena for use
+ 
+ @param arena the arena to initialize, usually a local variable of the function performing the unpack
+ */
+void wickr_proto_arena_init(wickr_proto_arena_t *arena);
+
+/**
+ @ingroup wickr_arena
+ 
+ Zero and free everything allocated from a proto arena
+ 
+ The arena is left empty and may be used for another unpack
+ 
+ @param arena the arena to release
+ */
+void wickr_proto_arena_release(wickr_proto_arena_t *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* proto_arena_priv_h */
@@ -0,0 +1,197 @@
+/*
+ * Copyright © 2012-2020 Wickr Inc.  All rights reserved.
+ *
+ * This code is being released for EDUCATIONAL, ACADEMIC, AND CODE REVIEW PURPOSES
+ * ONLY.  COMMERCIAL USE OF THE CODE IS EXPRESSLY PROHIBITED.  For additional details,
+ * please see LICENSE
+ *
+ * THE CODE IS MADE AVAILABLE "AS-IS" AND WITHOUT ANY EXPRESS OR
+ * IMPLIED GUARANTEES AS TO FITNESS, MERCHANTABILITY, NON-
+ * INFRINGEMENT OR OTHERWISE. IT IS NOT BEING PROVIDED IN TRADE BUT ON
+ * A VOLUNTARY BASIS ON BEHALF OF THE AUTHOR’S PART FOR THE BENEFIT
+ * OF THE LICENSEE AND IS NOT MADE AVAILABLE FOR CONSUMER USE OR ANY
+ * OTHER USE OUTSIDE THE TERMS OF THIS LICENSE. ANYONE ACCESSING THE
+ * CODE SHOULD HAVE THE REQUISITE EXPERTISE TO SECURE THEIR SYSTEM
+ * AND DEVICES AND TO ACCESS AND USE THE CODE FOR REVIEW PURPOSES
+ * ONLY. LICENSEE BEARS THE RISK OF ACCESSING AND USING THE CODE. IN
+ * PARTICULAR, AUTHOR BEARS NO LIABILITY FOR ANY INTERFERENCE WITH OR
+ * ADVERSE EFFECT THAT MAY OCCUR AS A RESULT OF THE LICENSEE
+ * ACCESSING AND/OR USING THE CODE ON LICENSEE’S SYSTEM.
+ */
+
+#ifndef threads_priv_h
+#define threads_priv_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include "Windows.h"
+#else
+#include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ Minimal threading primitives shared by the library. They map onto pthreads everywhere except Windows, where slim reader /
+ writer locks, condition variables, one time initialization and fiber local storage are used instead
+ */
+
+#ifdef _WIN32
+
+typedef SRWLOCK wickr_mutex_t;
+typedef CONDITION_VARIABLE wickr_cond_t;
+typedef HANDLE wickr_thread_t;
+typedef INIT_ONCE wickr_once_t;
+typedef DWORD wickr_thread_key_t;
+
+#define WICKR_MUTEX_INITIALIZER SRWLOCK_INIT
+#define WICKR_COND_INITIALIZER CONDITION_VARIABLE_INIT
+#define WICKR_ONCE_INIT INIT_ONCE_STATIC_INIT
+
+/* Calling convention of thread key destructors, which are run as fiber local storage callbacks on Windows */
+#define WICKR_THREAD_KEY_CALLBACK NTAPI
+
+static inline bool wickr_mutex_init(wickr_mutex_t *mutex)
+{
+    InitializeSRWLock(mutex);
+    return true;
+}
+
+static inline void wickr_mutex_destroy(wickr_mutex_t *mutex)
+{
+    (void)mutex;
+}
+
+static inline void wickr_mutex_lock(wickr_mutex_t *mutex)
+{
+    AcquireSRWLockExclusive(mutex);
+}
+
+static inline void wickr_mutex_unlock(wickr_mutex_t *mutex)
+{
+    ReleaseSRWLockExclusive(mutex);
+}
+
+static inline bool wickr_cond_init(wickr_cond_t *cond)
+{
+    InitializeConditionVariable(cond);
+    return true;
+}
+
+static inline void wickr_cond_destroy(wickr_cond_t *cond)
+{
+    (void)cond;
+}
+
+static inline void wickr_cond_wait(wickr_cond_t *cond, wickr_mutex_t *mutex)
+{
+    SleepConditionVariableSRW(cond, mutex, INFINITE, 0);
+}
+
+static inline void wickr_cond_signal(wickr_cond_t *cond)
+{
+    WakeConditionVariable(cond);
+}
+
+static inline void wickr_cond_broadcast(wickr_cond_t *cond)
+{
+    WakeAllConditionVariable(cond);
+}
+
+#else
+
+typedef pthread_mutex_t wickr_mutex_t;
+typedef pthread_cond_t wickr_cond_t;
+typedef pthread_t wickr_thread_t;
+typedef pthread_once_t wickr_once_t;
+typedef pthread_key_t wickr_thread_key_t;
+
+#define WICKR_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+#define WICKR_COND_INITIALIZER PTHREAD_COND_INITIALIZER
+#define WICKR_ONCE_INIT PTHREAD_ONCE_INIT
+
+#define WICKR_THREAD_KEY_CALLBACK
+
+static inline bool wickr_mutex_init(wickr_mutex_t *mutex)
+{
+    return pthread_mutex_init(mutex, NULL) == 0;
+}
+
+static inline void wickr_mutex_destroy(wickr_mutex_t *mutex)
+{
+    pthread_mutex_destroy(mutex);
+}
+
+static inline void wickr_mutex_lock(wickr_mutex_t *mutex)
+{
+    pthread_mutex_lock(mutex);
+}
+
+static inline void wickr_mutex_unlock(wickr_mutex_t *mutex)
+{
+    pthread_mutex_unlock(mutex);
+}
+
+static inline bool wickr_cond_init(wickr_cond_t *cond)
+{
+    return pthread_cond_init(cond, NULL) == 0;
+}
+
+static inline void wickr_cond_destroy(wickr_cond_t *cond)
+{
+    pthread_cond_destroy(cond);
+}
+
+static inline void wickr_cond_wait(wickr_cond_t *cond, wickr_mutex_t *mutex)
+{
+    pthread_cond_wait(cond, mutex);
+}
+
+static inline void wickr_cond_signal(wickr_cond_t *cond)
+{
+    pthread_cond_signal(cond);
+}
+
+static inline void wickr_cond_broadcast(wickr_cond_t *cond)
+{
+    pthread_cond_broadcast(cond);
+}
+
+#endif
+
+typedef void *(*wickr_thread_func)(void *arg);
+typedef void (WICKR_THREAD_KEY_CALLBACK *wickr_thread_key_destructor)(void *value);
+
+/* Start a thread running 'func' with 'arg'. The thread must later be passed to wickr_thread_join or wickr_thread_detach */
+bool wickr_thread_create(wickr_thread_t *thread, wickr_thread_func func, void *arg);
+
+/* Wait for a thread started with wickr_thread_create to finish and release it */
+void wickr_thread_join(wickr_thread_t thread);
+
+/* Release a thread started with wickr_thread_create without waiting for it to finish */
+void wickr_thread_detach(wickr_thread_t thread);
+
+/* The number of processors currently online, or 1 if it can't be determined */
+uint32_t wickr_thread_cpu_count(void);
+
+/* Nanoseconds elapsed on a monotonic clock since an unspecified starting point, or 0 if the clock can't be read */
+uint64_t wickr_clock_monotonic_ns(void);
+
+/* Run 'init_func' exactly once for 'once', blocking other callers until it has completed */
+void wickr_once(wickr_once_t *once, void (*init_func)(void));
+
+/* Create a key whose 'destructor' is run with the calling thread's non NULL value when that thread exits */
+bool wickr_thread_key_create(wickr_thread_key_t *key, wickr_thread_key_destructor destructor);
+
+/* Set the value of 'key' for the calling thread */
+bool wickr_thread_key_set(wickr_thread_key_t key, void *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* threads_priv_h */
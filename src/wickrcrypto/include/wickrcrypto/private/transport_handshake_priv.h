@@ -25,23 +25,40 @@
 #include "stream.pb-c.h"
 #include "private/transport_priv.h"
 #include "transport_root_key.h"
+#include "transport_resumption.h"
+#include "private/transport_stats_priv.h"
 
 struct wickr_transport_handshake_t {
     wickr_crypto_engine_t engine;
     wickr_identity_chain_t *local_identity;
     wickr_identity_chain_t *remote_identity;
-    wickr_array_t *packet_list;
+    wickr_digest_ctx_t *transcript;
+    uint8_t transcript_len;
+    wickr_buffer_t *local_identity_data;
     wickr_transport_handshake_identity_callback identity_callback;
     wickr_transport_handshake_status status;
     wickr_ec_key_t *local_ephemeral_key;
     wickr_transport_root_key_t *root_key;
     wickr_transport_packet_t *pending_identity_verify_packet;
+    wickr_cipher_key_t *ticket_key;
+    wickr_transport_resumption_t *resumption;
+    wickr_buffer_t *resumption_ticket;
     bool is_initiator;
     uint8_t protocol_version;
+    uint64_t local_flags;
+    uint64_t remote_flags;
     uint32_t evo_count;
     void *user;
+    wickr_transport_stats_t *stats;
+#ifdef WICKR_TRANSPORT_STATS_TIMING
+    uint64_t start_time_ns;
+#endif
 };
 
+void wickr_transport_handshake_set_local_identity_data(wickr_transport_handshake_t *handshake,
+                                                       wickr_buffer_t *local_identity_data);
+void wickr_transport_handshake_set_stats(wickr_transport_handshake_t *handshake, wickr_transport_stats_t *stats);
+
 Wickr__Proto__HandshakeV1__Seed *wickr_proto_handshake_seed_create(const wickr_identity_chain_t *id_chain,
                                                                    const wickr_buffer_t *ephemeral_pub_key,
                                                                    bool needs_remote_identity);
@@ -50,18 +67,28 @@ Wickr__Proto__HandshakeV1__Response *wickr_proto_handshake_response_create(const
                                                                            const wickr_buffer_t *encrypted_response_data,
                                                                            const wickr_identity_chain_t *identity_chain);
 void wickr_proto_handshake_response_free(Wickr__Proto__HandshakeV1__Response *response);
+Wickr__Proto__HandshakeV1__ResumeSeed *wickr_proto_handshake_resume_seed_create(const wickr_buffer_t *ticket,
+                                                                                 const wickr_buffer_t *nonce);
+void wickr_proto_handshake_resume_seed_free(Wickr__Proto__HandshakeV1__ResumeSeed *resume_seed);
+Wickr__Proto__HandshakeV1__ResumeResponse *wickr_proto_handshake_resume_response_create(bool accepted,
+                                                                                         const wickr_buffer_t *nonce);
+void wickr_proto_handshake_resume_response_free(Wickr__Proto__HandshakeV1__ResumeResponse *resume_response);
 Wickr__Proto__HandshakeV1 *wickr_proto_handshake_create_with_seed(Wickr__Proto__HandshakeV1__Seed *seed);
 Wickr__Proto__HandshakeV1 *wickr_proto_handshake_create_with_response(Wickr__Proto__HandshakeV1__Response *response);
+Wickr__Proto__HandshakeV1 *wickr_proto_handshake_create_with_resume_seed(Wickr__Proto__HandshakeV1__ResumeSeed *resume_seed);
+Wickr__Proto__HandshakeV1 *wickr_proto_handshake_create_with_resume_response(Wickr__Proto__HandshakeV1__ResumeResponse *resume_response);
 void wickr_proto_handshake_free(Wickr__Proto__HandshakeV1 *handshake);
 wickr_buffer_t *wickr_proto_handshake_serialize(const Wickr__Proto__HandshakeV1 *handshake);
-Wickr__Proto__HandshakeV1 *wickr_proto_handshake_from_buffer(const wickr_buffer_t *buffer);
-Wickr__Proto__HandshakeV1 *wickr_proto_handshake_from_packet(const wickr_transport_packet_t *packet);
+Wickr__Proto__HandshakeV1 *wickr_proto_handshake_from_buffer(const wickr_buffer_t *buffer, ProtobufCAllocator *allocator);
+Wickr__Proto__HandshakeV1 *wickr_proto_handshake_from_packet(const wickr_transport_packet_t *packet, ProtobufCAllocator *allocator);
 wickr_transport_packet_t *wickr_proto_handshake_to_packet(const Wickr__Proto__HandshakeV1 *handshake);
 
-Wickr__Proto__HandshakeV1ResponseData *wickr_proto_handshake_response_data_create(const wickr_transport_root_key_t *root_key);
+Wickr__Proto__HandshakeV1ResponseData *wickr_proto_handshake_response_data_create(const wickr_transport_root_key_t *root_key,
+                                                                                   const wickr_buffer_t *resumption_ticket);
 
 wickr_buffer_t *wickr_proto_handshake_response_data_serialize(const Wickr__Proto__HandshakeV1ResponseData *data);
-Wickr__Proto__HandshakeV1ResponseData *wickr_proto_handshake_response_data_from_buffer(const wickr_buffer_t *buffer);
+Wickr__Proto__HandshakeV1ResponseData *wickr_proto_handshake_response_data_from_buffer(const wickr_buffer_t *buffer,
+                                                                                        ProtobufCAllocator *allocator);
 void wickr_proto_handshake_response_data_free(Wickr__Proto__HandshakeV1ResponseData *data);
 
 #endif /* transport_handshake_priv */
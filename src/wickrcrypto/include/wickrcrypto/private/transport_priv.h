@@ -25,12 +25,14 @@
 #include "transport_ctx.h"
 #include "transport_handshake.h"
 #include "transport_error.h"
+#include "transport_stats.h"
 
 struct wickr_transport_ctx {
     wickr_crypto_engine_t engine;
     wickr_stream_ctx_t *rx_stream;
     wickr_stream_ctx_t *tx_stream;
     wickr_identity_chain_t *local_identity;
+    wickr_buffer_t *local_identity_data;
     wickr_identity_chain_t *remote_identity;
     wickr_transport_status status;
     uint32_t evo_count;
@@ -38,6 +40,11 @@ struct wickr_transport_ctx {
     void *user;
     wickr_transport_handshake_t *pending_handshake;
     wickr_transport_error err;
+    wickr_cipher_key_t *ticket_key;
+    wickr_transport_resumption_t *resumption;
+    wickr_transport_stats_t stats;
+    uint64_t handshake_flags;
+    uint64_t session_flags;
 };
 
 #endif /* transport_priv_h */
@@ -0,0 +1,45 @@
+/*
+* Copyright © 2012-2020 Wickr Inc.  All rights reserved.
+*
+* This code is being released for EDUCATIONAL, ACADEMIC, AND CODE REVIEW PURPOSES
+* ONLY.  COMMERCIAL USE OF THE CODE IS EXPRESSLY PROHIBITED.  For additional details,
+* please see LICENSE
+*
+* THE CODE IS MADE AVAILABLE "AS-IS" AND WITHOUT ANY EXPRESS OR
+* IMPLIED GUARANTEES AS TO FITNESS, MERCHANTABILITY, NON-
+* INFRINGEMENT OR OTHERWISE. IT IS NOT BEING PROVIDED IN TRADE BUT ON
+* A VOLUNTARY BASIS ON BEHALF OF THE AUTHOR’S PART FOR THE BENEFIT
+* OF THE LICENSEE AND IS NOT MADE AVAILABLE FOR CONSUMER USE OR ANY
+* OTHER USE OUTSIDE THE TERMS OF THIS LICENSE. ANYONE ACCESSING THE
+* CODE SHOULD HAVE THE REQUISITE EXPERTISE TO SECURE THEIR SYSTEM
+* AND DEVICES AND TO ACCESS AND USE THE CODE FOR REVIEW PURPOSES
+* ONLY. LICENSEE BEARS THE RISK OF ACCESSING AND USING THE CODE. IN
+* PARTICULAR, AUTHOR BEARS NO LIABILITY FOR ANY INTERFERENCE WITH OR
+* ADVERSE EFFECT THAT MAY OCCUR AS A RESULT OF THE LICENSEE
+* ACCESSING AND/OR USING THE CODE ON LICENSEE’S SYSTEM.
+*/
+
+#ifndef transport_stats_priv_h
+#define transport_stats_priv_h
+
+#include "transport_stats.h"
+
+/* Timing instrumentation compiles away entirely unless WICKR_TRANSPORT_STATS_TIMING is defined */
+#ifdef WICKR_TRANSPORT_STATS_TIMING
+
+#include "private/threads_priv.h"
+
+void wickr_transport_histogram_record(wickr_transport_histogram_t *histogram, uint64_t duration_ns);
+
+#define TRANSPORT_STATS_TIMER_START(timer) uint64_t timer = wickr_clock_monotonic_ns()
+#define TRANSPORT_STATS_TIMER_RECORD(histogram, timer) \
+    wickr_transport_histogram_record(histogram, wickr_clock_monotonic_ns() - (timer))
+
+#else
+
+#define TRANSPORT_STATS_TIMER_START(timer)
+#define TRANSPORT_STATS_TIMER_RECORD(histogram, timer)
+
+#endif
+
+#endif /* transport_stats_priv_h */
@@ -233,7 +233,9 @@ wickr_buffer_t *wickr_packet_serialize(const wickr_packet_t *packet);
  Copy a packet
  
  @param source the packet to copy
- @return a newly allocated packet holding a deep copy of the properties of 'source'
+ @return a newly allocated packet holding a copy of the properties of 'source'. The content and signature bytes may be shared with
+ 'source' rather than copied (see 'wickr_buffer_share'), so they must be treated as read only unless 'wickr_buffer_make_unique' is
+ called first
  */
 wickr_packet_t *wickr_packet_copy(const wickr_packet_t *source);
 
@@ -0,0 +1,129 @@
+/*
+ * Copyright © 2012-2020 Wickr Inc.  All rights reserved.
+ *
+ * This code is being released for EDUCATIONAL, ACADEMIC, AND CODE REVIEW PURPOSES
+ * ONLY.  COMMERCIAL USE OF THE CODE IS EXPRESSLY PROHIBITED.  For additional details,
+ * please see LICENSE
+ *
+ * THE CODE IS MADE AVAILABLE "AS-IS" AND WITHOUT ANY EXPRESS OR
+ * IMPLIED GUARANTEES AS TO FITNESS, MERCHANTABILITY, NON-
+ * INFRINGEMENT OR OTHERWISE. IT IS NOT BEING PROVIDED IN TRADE BUT ON
+ * A VOLUNTARY BASIS ON BEHALF OF THE AUTHOR’S PART FOR THE BENEFIT
+ * OF THE LICENSEE AND IS NOT MADE AVAILABLE FOR CONSUMER USE OR ANY
+ * OTHER USE OUTSIDE THE TERMS OF THIS LICENSE. ANYONE ACCESSING THE
+ * CODE SHOULD HAVE THE REQUISITE EXPERTISE TO SECURE THEIR SYSTEM
+ * AND DEVICES AND TO ACCESS AND USE THE CODE FOR REVIEW PURPOSES
+ * ONLY. LICENSEE BEARS THE RISK OF ACCESSING AND USING THE CODE. IN
+ * PARTICULAR, AUTHOR BEARS NO LIABILITY FOR ANY INTERFERENCE WITH OR
+ * ADVERSE EFFECT THAT MAY OCCUR AS A RESULT OF THE LICENSEE
+ * ACCESSING AND/OR USING THE CODE ON LICENSEE’S SYSTEM.
+ */
+
+#ifndef secure_heap_h
+#define secure_heap_h
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ @addtogroup wickr_secure_heap wickr_secure_heap
+ */
+
+/**
+ 
+ @ingroup wickr_secure_heap
+ 
+ Dedicated heap for key material
+ 
+ The secure heap is a single range of address space reserved the first time it is used. Pages are committed from it in small
+ regions that are locked into memory so they are never written to swap, excluded from core dumps where the platform allows it,
+ and separated from each other by inaccessible guard pages. Each region serves a single size class, so key bytes are never
+ adjacent to unrelated data. Freed chunks are zeroed and kept on a free list for their size class, so creating and destroying
+ keys does not make system calls once the heap is warm.
+ 
+ Memory from the secure heap is released with wickr_free or wickr_free_zero like any other library allocation.
+ */
+
+/* The amount of address space reserved for the secure heap. It can be overridden at build time */
+#ifndef WICKR_SECURE_HEAP_SIZE
+#define WICKR_SECURE_HEAP_SIZE (1024 * 1024)
+#endif
+
+/* The largest allocation served by the secure heap. Larger requests are allocated with wickr_alloc_zero */
+#define WICKR_SECURE_HEAP_MAX_ALLOC 2048
+
+/**
+ 
+ @ingroup wickr_secure_heap
+ @struct wickr_secure_heap_stats
+ 
+ @brief Usage of the secure heap
+ 
+ @var wickr_secure_heap_stats::reserved_bytes
+ the amount of address space reserved for the heap, 0 if it could not be reserved
+ @var wickr_secure_heap_stats::committed_bytes
+ the number of bytes of the reservation that are backed by memory
+ @var wickr_secure_heap_stats::live_bytes
+ the number of bytes in chunks that are currently allocated, including rounding up to the size class
+ @var wickr_secure_heap_stats::live_allocations
+ the number of chunks that are currently allocated
+ @var wickr_secure_heap_stats::fallback_allocations
+ the number of requests that were allocated with wickr_alloc_zero because they were too large or the heap was exhausted
+ @var wickr_secure_heap_stats::is_locked
+ true if every committed page is locked in memory. Locking fails if it would exceed the memory lock limit of the process
+ */
+struct wickr_secure_heap_stats {
+    size_t reserved_bytes;
+    size_t committed_bytes;
+    size_t live_bytes;
+    size_t live_allocations;
+    uint64_t fallback_allocations;
+    bool is_locked;
+};
+
+typedef struct wickr_secure_heap_stats wickr_secure_heap_stats_t;
+
+/**
+ 
+ @ingroup wickr_secure_heap
+ 
+ Allocate zeroed memory for key material from the secure heap
+ 
+ @param len the number of bytes to allocate
+ @return a pointer to 'len' bytes of zeroed memory, or NULL if 'len' is 0 or allocation fails. If the secure heap cannot serve
+ the request, the memory comes from wickr_alloc_zero instead
+ */
+void *wickr_secure_alloc(size_t len);
+
+/**
+ 
+ @ingroup wickr_secure_heap
+ 
+ Determine if memory was allocated from the secure heap
+ 
+ @param buf a pointer returned by a library allocation function
+ @return true if 'buf' is a chunk of the secure heap
+ */
+bool wickr_secure_heap_owns(const void *buf);
+
+/**
+ 
+ @ingroup wickr_secure_heap
+ 
+ Get the current usage of the secure heap
+ 
+ @param stats_out the location to write the usage to
+ @return true if 'stats_out' was written
+ */
+bool wickr_secure_heap_get_stats(wickr_secure_heap_stats_t *stats_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* secure_heap_h */
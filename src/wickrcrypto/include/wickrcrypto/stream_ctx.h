@@ -63,6 +63,8 @@ typedef enum { STREAM_DIRECTION_ENCODE, STREAM_DIRECTION_DECODE } wickr_stream_d
  the direction of this stream context. direction can either be encoding or decoding
  @var wickr_stream_ctx::ref_count
  current reference count of the stream
+ @var wickr_stream_ctx::evolution_count
+ the number of times the stream key has evolved since the stream context was created
  */
 struct wickr_stream_ctx {
     wickr_crypto_engine_t engine;
@@ -71,6 +73,7 @@ struct wickr_stream_ctx {
     uint64_t last_seq;
     wickr_stream_direction direction;
     size_t ref_count;
+    uint64_t evolution_count;
 };
 
 typedef struct wickr_stream_ctx wickr_stream_ctx_t;
@@ -26,6 +26,8 @@
 #include "node.h"
 #include "stream_ctx.h"
 #include "transport_error.h"
+#include "transport_resumption.h"
+#include "transport_stats.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -241,6 +243,73 @@ void wickr_transport_ctx_set_user_ctx(wickr_transport_ctx_t *ctx, void *user);
  @return the most recent error inside the transport context
  */
 wickr_transport_error wickr_transport_ctx_get_last_error(const wickr_transport_ctx_t *ctx);
+
+/**
+ @ingroup wickr_transport_ctx
+ 
+ Get a snapshot of the statistics collected by a transport context
+ 
+ @param ctx the context to get statistics for
+ @return a copy of the counters maintained by 'ctx', or zeroed statistics if 'ctx' is NULL. Timing histograms are only included
+ if the library was built with WICKR_TRANSPORT_STATS_TIMING
+ */
+wickr_transport_stats_t wickr_transport_ctx_get_stats(const wickr_transport_ctx_t *ctx);
+
+/**
+ @ingroup wickr_transport_ctx
+ 
+ Set the key used to issue and open session resumption tickets when this context responds to a handshake.
+ The same key should be shared by every context that is expected to accept tickets issued by the others. Rotating the key
+ regularly bounds how long a leaked ticket key is useful, at the cost of sending every initiator holding an older ticket back to
+ a full handshake. See 'wickr_transport_resumption' for the lifetime of tickets
+ 
+ @param ctx the transport context to set the ticket key of
+ @param ticket_key a cipher key to encrypt resumption tickets with, or NULL to disable resumption. Ownership is transferred to `ctx`
+ */
+void wickr_transport_ctx_set_ticket_key(wickr_transport_ctx_t *ctx, wickr_cipher_key_t *ticket_key);
+
+/**
+ @ingroup wickr_transport_ctx
+ 
+ Set cached resumption information that will be presented to the remote party when calling `wickr_transport_ctx_start`.
+ If the remote party rejects it, the context will fall back to a full handshake
+ 
+ @param ctx the transport context to set the resumption information of
+ @param resumption resumption information obtained from `wickr_transport_ctx_get_resumption` on a previous context. Ownership is transferred to `ctx`
+ */
+void wickr_transport_ctx_set_resumption(wickr_transport_ctx_t *ctx, wickr_transport_resumption_t *resumption);
+
+/**
+ @ingroup wickr_transport_ctx
+ 
+ Get the resumption information learned from the most recent handshake, which can be cached to resume a session later
+ 
+ @param ctx the transport context to get the resumption information of
+ @return the resumption information of `ctx` or NULL if the remote party has not issued a resumption ticket
+ */
+const wickr_transport_resumption_t *wickr_transport_ctx_get_resumption(const wickr_transport_ctx_t *ctx);
+
+/**
+ @ingroup wickr_transport_ctx
+ 
+ Advertise support for compact data packets during the handshake. Compact packets encode their sequence number as a varint
+ and omit the cipher id from their body, which saves 8 or more bytes per packet. They are only used if both parties enable them.
+ This must be called before the handshake begins
+ 
+ @param ctx the transport context to configure
+ @param enabled true if compact data packets should be negotiated
+ */
+void wickr_transport_ctx_set_compact_packets(wickr_transport_ctx_t *ctx, bool enabled);
+
+/**
+ @ingroup wickr_transport_ctx
+ 
+ Determine if the current session of a transport context uses compact data packets
+ 
+ @param ctx the transport context to check
+ @return true if the most recent handshake negotiated compact data packets
+ */
+bool wickr_transport_ctx_uses_compact_packets(const wickr_transport_ctx_t *ctx);
     
 #ifdef __cplusplus
 }
@@ -25,6 +25,7 @@
 #include "identity.h"
 #include "stream_key.h"
 #include "transport_packet.h"
+#include "transport_resumption.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,6 +35,9 @@ extern "C" {
  @addtogroup wickr_transport_handshake
  */
 
+/* Handshake flag advertising support for TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT_COMPACT data packets */
+#define TRANSPORT_HANDSHAKE_FLAG_COMPACT_PACKETS 0x1ULL
+
 struct wickr_transport_handshake_res_t;
 typedef struct wickr_transport_handshake_res_t wickr_transport_handshake_res_t;
 
@@ -116,6 +120,26 @@ Get a pointer to the handshake result's remote key
 */
 const wickr_stream_key_t *wickr_transport_handshake_res_get_remote_key(const wickr_transport_handshake_res_t *res);
 
+/**
+@ingroup wickr_transport_handshake
+
+Get a pointer to the handshake result's resumption information
+
+@param res the transport handshake to get the resumption information of
+@return a reference to the handshake result's resumption information, or NULL if the remote party did not issue a resumption ticket
+*/
+const wickr_transport_resumption_t *wickr_transport_handshake_res_get_resumption(const wickr_transport_handshake_res_t *res);
+
+/**
+@ingroup wickr_transport_handshake
+
+Get the flags that were negotiated by the handshake
+
+@param res the transport handshake result to get the flags of
+@return the flags that were advertised by both parties of the handshake
+*/
+uint64_t wickr_transport_handshake_res_get_flags(const wickr_transport_handshake_res_t *res);
+
 /**
 @ingroup wickr_transport_handshake
 @struct wickr_transport_handshake
@@ -126,6 +150,9 @@ The transport handshake manages a 2-way handshake that is used to establish a se
 In an exchange between Alice and Bob, the first packet sent by Alice contains an ephemeral public key along with identity information and is signed by Alice's identity chain.
 After receiving and validating the packet from Alice, Bob uses the ephemeral public key to encrypt a randomly chosen root key for the handshake and sends the resulting ciphertext back to Alice
 along with his own identity chain data (if requested). Once both sides are aware of the chosen root key, they may both finalize the handshake to derive their respective rx / tx keys for data transmission.
+If Bob has a ticket key set, he will also issue Alice an encrypted resumption ticket. Alice can present the ticket in a later handshake along with a random nonce,
+and if Bob can still open it he responds with his own nonce. Both sides then finalize using a resumption key derived from the original root key, skipping the ECDH exchange and signatures.
+If Bob rejects the ticket Alice will transparently fall back to a full handshake.
 This struct is only used within the `wickr_transport_ctx` and is not used for the Wickr Messaging Protocol itself.
 */
 
@@ -273,6 +300,39 @@ const void *wickr_transport_handshake_get_user_data(const wickr_transport_handsh
 */
 void wickr_transport_set_user_data(wickr_transport_handshake_t *handshake, void *user);
 
+/**
+ @ingroup wickr_transport_handshake
+ 
+ Set the key a responding handshake uses to issue and open resumption tickets. Without a ticket key no tickets
+ will be issued and all resumption attempts will be rejected
+ 
+ @param handshake the handshake to set the ticket key of
+ @param ticket_key the key to encrypt resumption tickets with. Ownership is transferred to `handshake`
+ */
+void wickr_transport_handshake_set_ticket_key(wickr_transport_handshake_t *handshake, wickr_cipher_key_t *ticket_key);
+
+/**
+ @ingroup wickr_transport_handshake
+ 
+ Set cached resumption information to use when starting a handshake. This must be called before `wickr_transport_handshake_start`
+ 
+ @param handshake the handshake to set the resumption information of
+ @param resumption resumption information from a previous handshake result. Ownership is transferred to `handshake`
+ */
+void wickr_transport_handshake_set_resumption(wickr_transport_handshake_t *handshake, wickr_transport_resumption_t *resumption);
+
+/**
+ @ingroup wickr_transport_handshake
+ 
+ Set the flags to advertise in the metadata of each handshake packet. A flag is only in effect once the handshake completes
+ if both parties advertised it. Flags are authenticated by the handshake transcript. This must be called before
+ `wickr_transport_handshake_start` or `wickr_transport_handshake_process`
+ 
+ @param handshake the handshake to set the flags of
+ @param flags a combination of TRANSPORT_HANDSHAKE_FLAG values
+ */
+void wickr_transport_handshake_set_flags(wickr_transport_handshake_t *handshake, uint64_t flags);
+
 #ifdef __cplusplus
 }
 #endif
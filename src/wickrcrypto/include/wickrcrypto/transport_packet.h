@@ -35,7 +35,8 @@ extern "C" {
 
 typedef enum {
     TRANSPORT_PAYLOAD_TYPE_HANDSHAKE, /* Payload is a handshake control packet */
-    TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT /* Payload contains encrypted application data */
+    TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT, /* Payload contains encrypted application data */
+    TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT_COMPACT /* Payload contains encrypted application data without a cipher id, and the sequence number is varint encoded */
 } wickr_transport_packet_payload_type;
 
 typedef enum {
@@ -76,7 +77,8 @@ typedef struct wickr_transport_handshake_meta wickr_transport_handshake_meta_t;
 @brief Metadata specifically for user data packets within a transport
 
 @var wickr_transport_data_meta::sequence_number
-the sequence number within the transport that is associated with this packet
+the sequence number within the transport that is associated with this packet. Serialized as a fixed 8 byte value for
+TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT packets, and as a little endian base 128 varint for TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT_COMPACT packets
 
 */
 struct wickr_transport_data_meta {
@@ -137,6 +139,20 @@ void wickr_transport_packet_meta_initialize_data(wickr_transport_packet_meta_t *
                                                  uint64_t sequence_number,
                                                  wickr_transport_packet_mac_type mac_type);
 
+/**
+ @ingroup wickr_transport_packet_meta
+ 
+ Initialize packet metadata for a compact data packet. Compact packets encode their sequence number as a varint,
+ and their body omits the cipher id because the cipher is implied by the session the packet belongs to
+ 
+ @param meta_out a pointer to initialize for the data metadata
+ @param sequence_number the sequence number of this packet within the current stream of data
+ @param mac_type the type of mac or signature to be used to authenticate the body data of the packet
+ */
+void wickr_transport_packet_meta_initialize_compact_data(wickr_transport_packet_meta_t *meta_out,
+                                                         uint64_t sequence_number,
+                                                         wickr_transport_packet_mac_type mac_type);
+
 /**
  @ingroup wickr_transport_packet_meta
  
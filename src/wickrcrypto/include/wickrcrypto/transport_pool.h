@@ -0,0 +1,252 @@
+/*
+* Copyright © 2012-2020 Wickr Inc.  All rights reserved.
+*
+* This code is being released for EDUCATIONAL, ACADEMIC, AND CODE REVIEW PURPOSES
+* ONLY.  COMMERCIAL USE OF THE CODE IS EXPRESSLY PROHIBITED.  For additional details,
+* please see LICENSE
+*
+* THE CODE IS MADE AVAILABLE "AS-IS" AND WITHOUT ANY EXPRESS OR
+* IMPLIED GUARANTEES AS TO FITNESS, MERCHANTABILITY, NON-
+* INFRINGEMENT OR OTHERWISE. IT IS NOT BEING PROVIDED IN TRADE BUT ON
+* A VOLUNTARY BASIS ON BEHALF OF THE AUTHOR’S PART FOR THE BENEFIT
+* OF THE LICENSEE AND IS NOT MADE AVAILABLE FOR CONSUMER USE OR ANY
+* OTHER USE OUTSIDE THE TERMS OF THIS LICENSE. ANYONE ACCESSING THE
+* CODE SHOULD HAVE THE REQUISITE EXPERTISE TO SECURE THEIR SYSTEM
+* AND DEVICES AND TO ACCESS AND USE THE CODE FOR REVIEW PURPOSES
+* ONLY. LICENSEE BEARS THE RISK OF ACCESSING AND USING THE CODE. IN
+* PARTICULAR, AUTHOR BEARS NO LIABILITY FOR ANY INTERFERENCE WITH OR
+* ADVERSE EFFECT THAT MAY OCCUR AS A RESULT OF THE LICENSEE
+* ACCESSING AND/OR USING THE CODE ON LICENSEE’S SYSTEM.
+*/
+
+#ifndef transport_pool_h
+#define transport_pool_h
+
+#include "transport_ctx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+@addtogroup wickr_transport_pool
+*/
+
+/* The maximum number of worker threads a transport pool can be created with */
+#define TRANSPORT_POOL_MAX_WORKERS 64
+
+/**
+ @ingroup wickr_transport_pool
+ @struct wickr_transport_pool
+ 
+ @brief A collection of transport contexts identified by a 64bit connection id that share a pool of worker threads
+ 
+ Handshake processing, encoding and decoding of packets are performed by the worker threads. Work submitted for a single
+ connection is always processed in the order it was submitted, and never by more than one worker at a time. Work for different
+ connections is processed in parallel. All connections are created from a template transport context, so that the local identity,
+ evolution count and ticket key are shared by every connection in the pool
+ */
+struct wickr_transport_pool;
+typedef struct wickr_transport_pool wickr_transport_pool_t;
+
+/* Function callbacks to handle sending / receiving / errors for a connection within the pool. These are called from worker threads */
+typedef void (*wickr_transport_pool_tx_func)(const wickr_transport_pool_t *pool, uint64_t connection_id, wickr_buffer_t *data, void *user);
+typedef void (*wickr_transport_pool_rx_func)(const wickr_transport_pool_t *pool, uint64_t connection_id, wickr_buffer_t *data, void *user);
+typedef void (*wickr_transport_pool_state_change_func)(const wickr_transport_pool_t *pool, uint64_t connection_id,
+                                                       wickr_transport_status status, void *user);
+typedef bool (*wickr_transport_pool_validate_identity_func)(const wickr_transport_pool_t *pool, uint64_t connection_id,
+                                                            wickr_identity_chain_t *identity, void *user);
+
+/**
+ @ingroup wickr_transport_pool
+ 
+ @struct wickr_transport_pool_callbacks
+ 
+ @brief callbacks to notify the user of events within the connections of a transport pool. Callbacks may be called concurrently by
+ different worker threads for different connections, but never concurrently for the same connection. Callbacks must not call
+ 'wickr_transport_pool_flush' or 'wickr_transport_pool_destroy' on the pool that called them
+ 
+ @var wickr_transport_pool_callbacks::tx
+ Called when data is ready to be sent to the remote end of a connection. Ownership of 'data' is transferred to the callback
+ @var wickr_transport_pool_callbacks::rx
+ Called when a buffer passed to 'wickr_transport_pool_process_rx_buffer' is decoded. Ownership of 'data' is transferred to the callback
+ @var wickr_transport_pool_callbacks::on_state
+ Called whenever the state of a connection is updated
+ @var wickr_transport_pool_callbacks::on_identity_verify
+ Called when a connection needs to decide upon the validity of an inbound identity. Ownership of 'identity' is transferred to the callback.
+ Return true to accept the identity. If this callback is NULL, identities that were not pinned when adding a connection are rejected
+ */
+struct wickr_transport_pool_callbacks {
+    wickr_transport_pool_tx_func tx;
+    wickr_transport_pool_rx_func rx;
+    wickr_transport_pool_state_change_func on_state;
+    wickr_transport_pool_validate_identity_func on_identity_verify;
+};
+
+typedef struct wickr_transport_pool_callbacks wickr_transport_pool_callbacks_t;
+
+/**
+ @ingroup wickr_transport_pool
+ 
+ @struct wickr_transport_pool_stats
+ 
+ @brief A snapshot of aggregate statistics across all connections of a transport pool
+ 
+ @var wickr_transport_pool_stats::connection_count
+ the number of connections currently in the pool
+ @var wickr_transport_pool_stats::active_count
+ the number of connections currently in the TRANSPORT_STATUS_ACTIVE state
+ @var wickr_transport_pool_stats::pending_count
+ the number of submitted operations that have not finished processing
+ @var wickr_transport_pool_stats::handshakes_completed
+ the number of connections that have reached the TRANSPORT_STATUS_ACTIVE state
+ @var wickr_transport_pool_stats::errors
+ the number of connections that have reached the TRANSPORT_STATUS_ERROR state
+ @var wickr_transport_pool_stats::rx_packets
+ the number of decoded packets passed to the rx callback
+ @var wickr_transport_pool_stats::rx_bytes
+ the number of decoded bytes passed to the rx callback
+ @var wickr_transport_pool_stats::tx_packets
+ the number of packets passed to the tx callback, including handshake packets
+ @var wickr_transport_pool_stats::tx_bytes
+ the number of bytes passed to the tx callback, including handshake packets
+ @var wickr_transport_pool_stats::rx_dropped
+ the number of buffers submitted for a connection id that is not in the pool
+ */
+struct wickr_transport_pool_stats {
+    uint64_t connection_count;
+    uint64_t active_count;
+    uint64_t pending_count;
+    uint64_t handshakes_completed;
+    uint64_t errors;
+    uint64_t rx_packets;
+    uint64_t rx_bytes;
+    uint64_t tx_packets;
+    uint64_t tx_bytes;
+    uint64_t rx_dropped;
+};
+
+typedef struct wickr_transport_pool_stats wickr_transport_pool_stats_t;
+
+/**
+ @ingroup wickr_transport_pool
+ 
+ Create a transport pool
+ 
+ @param ctx_template a transport context in the TRANSPORT_STATUS_NONE state to copy for each new connection. The callbacks and
+ user context of the template are replaced by the pool
+ @param worker_count the number of worker threads to create, between 1 and TRANSPORT_POOL_MAX_WORKERS
+ @param callbacks callbacks to notify the user of events within the connections of the pool
+ @param user a pointer to be held and passed to all callbacks
+ @return a newly allocated transport pool, or NULL if the template is not valid or the worker threads can't be started
+ */
+wickr_transport_pool_t *wickr_transport_pool_create(const wickr_transport_ctx_t *ctx_template,
+                                                    uint32_t worker_count,
+                                                    wickr_transport_pool_callbacks_t callbacks,
+                                                    void *user);
+
+/**
+ @ingroup wickr_transport_pool
+ 
+ Destroy a transport pool. Work that has already been submitted is completed before the worker threads exit
+ 
+ @param pool a pointer to the transport pool to destroy. All connections of '*pool' will also be destroyed
+ */
+void wickr_transport_pool_destroy(wickr_transport_pool_t **pool);
+
+/**
+ @ingroup wickr_transport_pool
+ 
+ Add a connection to the pool
+ 
+ @param pool the pool to add a connection to
+ @param connection_id a unique identifier for the connection
+ @param remote_identity the identity of the remote end of the connection to pin, or NULL if it should be verified with the
+ 'on_identity_verify' callback. Ownership is transferred to the pool if the connection is added
+ @return true if the connection was added, false if 'connection_id' is already in use or the connection could not be created
+ */
+bool wickr_transport_pool_add_connection(wickr_transport_pool_t *pool,
+                                         uint64_t connection_id,
+                                         wickr_identity_chain_t *remote_identity);
+
+/**
+ @ingroup wickr_transport_pool
+ 
+ Remove a connection from the pool. Work that is pending for the connection is discarded
+ 
+ @param pool the pool to remove a connection from
+ @param connection_id the identifier of the connection to remove
+ @return true if the connection was found and removed
+ */
+bool wickr_transport_pool_remove_connection(wickr_transport_pool_t *pool, uint64_t connection_id);
+
+/**
+ @ingroup wickr_transport_pool
+ 
+ Queue the start of a handshake on a connection, see 'wickr_transport_ctx_start'
+ 
+ @param pool the pool that contains the connection
+ @param connection_id the identifier of the connection to start
+ @return true if the work was queued
+ */
+bool wickr_transport_pool_start(wickr_transport_pool_t *pool, uint64_t connection_id);
+
+/**
+ @ingroup wickr_transport_pool
+ 
+ Queue a buffer to be encoded and sent to the remote end of a connection, see 'wickr_transport_ctx_process_tx_buffer'
+ 
+ @param pool the pool that contains the connection
+ @param connection_id the identifier of the connection to send the buffer on
+ @param buffer the buffer to encode. It is copied before this function returns
+ @return true if the work was queued
+ */
+bool wickr_transport_pool_process_tx_buffer(wickr_transport_pool_t *pool, uint64_t connection_id, const wickr_buffer_t *buffer);
+
+/**
+ @ingroup wickr_transport_pool
+ 
+ Queue a buffer that was received from the remote end of a connection, see 'wickr_transport_ctx_process_rx_buffer'
+ 
+ @param pool the pool that contains the connection
+ @param connection_id the identifier of the connection the buffer was received on
+ @param buffer the buffer to process. It is copied before this function returns
+ @return true if the work was queued, false if 'connection_id' is not in the pool
+ */
+bool wickr_transport_pool_process_rx_buffer(wickr_transport_pool_t *pool, uint64_t connection_id, const wickr_buffer_t *buffer);
+
+/**
+ @ingroup wickr_transport_pool
+ 
+ Block until all work that has been submitted to the pool has finished processing
+ 
+ @param pool the pool to wait on
+ */
+void wickr_transport_pool_flush(wickr_transport_pool_t *pool);
+
+/**
+ @ingroup wickr_transport_pool
+ 
+ Get the current status of a connection
+ 
+ @param pool the pool that contains the connection
+ @param connection_id the identifier of the connection
+ @return the status of the connection after its most recently completed work, or TRANSPORT_STATUS_ERROR if 'connection_id' is not in the pool
+ */
+wickr_transport_status wickr_transport_pool_get_status(const wickr_transport_pool_t *pool, uint64_t connection_id);
+
+/**
+ @ingroup wickr_transport_pool
+ 
+ Get a snapshot of aggregate statistics for the pool
+ 
+ @param pool the pool to get statistics for
+ @return statistics across all connections of 'pool'
+ */
+wickr_transport_pool_stats_t wickr_transport_pool_get_stats(const wickr_transport_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* transport_pool_h */
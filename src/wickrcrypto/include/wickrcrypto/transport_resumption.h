@@ -0,0 +1,103 @@
+/*
+* Copyright © 2012-2020 Wickr Inc.  All rights reserved.
+*
+* This code is being released for EDUCATIONAL, ACADEMIC, AND CODE REVIEW PURPOSES
+* ONLY.  COMMERCIAL USE OF THE CODE IS EXPRESSLY PROHIBITED.  For additional details,
+* please see LICENSE
+*
+* THE CODE IS MADE AVAILABLE "AS-IS" AND WITHOUT ANY EXPRESS OR
+* IMPLIED GUARANTEES AS TO FITNESS, MERCHANTABILITY, NON-
+* INFRINGEMENT OR OTHERWISE. IT IS NOT BEING PROVIDED IN TRADE BUT ON
+* A VOLUNTARY BASIS ON BEHALF OF THE AUTHOR’S PART FOR THE BENEFIT
+* OF THE LICENSEE AND IS NOT MADE AVAILABLE FOR CONSUMER USE OR ANY
+* OTHER USE OUTSIDE THE TERMS OF THIS LICENSE. ANYONE ACCESSING THE
+* CODE SHOULD HAVE THE REQUISITE EXPERTISE TO SECURE THEIR SYSTEM
+* AND DEVICES AND TO ACCESS AND USE THE CODE FOR REVIEW PURPOSES
+* ONLY. LICENSEE BEARS THE RISK OF ACCESSING AND USING THE CODE. IN
+* PARTICULAR, AUTHOR BEARS NO LIABILITY FOR ANY INTERFERENCE WITH OR
+* ADVERSE EFFECT THAT MAY OCCUR AS A RESULT OF THE LICENSEE
+* ACCESSING AND/OR USING THE CODE ON LICENSEE’S SYSTEM.
+*/
+
+#ifndef transport_resumption_h
+#define transport_resumption_h
+
+#include "buffer.h"
+#include "transport_root_key.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+@addtogroup wickr_transport_resumption
+*/
+
+/* The amount of time in seconds that a resumption ticket issued by a transport handshake remains valid */
+#define TRANSPORT_RESUMPTION_TICKET_LIFETIME 86400
+
+/* The size of the random nonce each party contributes to a resumed handshake */
+#define TRANSPORT_RESUMPTION_NONCE_LEN 32
+
+/**
+ @ingroup wickr_transport_resumption
+ 
+ @struct wickr_transport_resumption
+ @brief Session resumption state that a transport handshake initiator can cache after a successful full handshake.
+ Presenting the ticket to the same responder allows a new session to be established without an ECDH exchange or signatures,
+ as long as the responder can still open the ticket with its ticket key
+ 
+ Tickets are not single use. The responder keeps no record of the tickets it accepts and a resumed session is not issued a new
+ ticket, so one ticket and its resumption root key can be used for any number of sessions until the ticket expires,
+ TRANSPORT_RESUMPTION_TICKET_LIFETIME seconds after the full handshake that issued it. Each resumed session mixes new nonces from
+ both parties into its keys, but anyone who learns the resumption root key or the ticket key can derive the keys of every session
+ resumed with the ticket. Ticket keys carry no identifier, so replacing a ticket key invalidates all of the tickets it issued
+ 
+ @var wickr_transport_resumption::ticket
+ an opaque ticket issued by the responder. It is encrypted with a key that only the responder knows
+ @var wickr_transport_resumption::root_key
+ the resumption root key that the ticket was issued for, derived from the root key of the original handshake
+ */
+struct wickr_transport_resumption {
+    wickr_buffer_t *ticket;
+    wickr_transport_root_key_t *root_key;
+};
+
+typedef struct wickr_transport_resumption wickr_transport_resumption_t;
+
+/**
+ @ingroup wickr_transport_resumption
+ 
+ Create a transport resumption from components
+ 
+ @param ticket the opaque ticket issued by the responder
+ @param root_key the resumption root key that `ticket` was issued for
+ @return a newly allocated transport resumption taking ownership of `ticket` and `root_key` or NULL if allocation fails
+ */
+wickr_transport_resumption_t *wickr_transport_resumption_create(wickr_buffer_t *ticket,
+                                                                wickr_transport_root_key_t *root_key);
+
+/**
+ @ingroup wickr_transport_resumption
+ 
+ Copy a transport resumption
+ 
+ @param resumption the transport resumption to copy
+ @return a newly allocated transport resumption holding a deep copy of the properties of `resumption`
+ */
+wickr_transport_resumption_t *wickr_transport_resumption_copy(const wickr_transport_resumption_t *resumption);
+
+/**
+ @ingroup wickr_transport_resumption
+ 
+ Destroy a transport resumption
+ 
+ @param resumption a pointer to the transport resumption to destroy. All properties of `*resumption` will also be destroyed
+ */
+void wickr_transport_resumption_destroy(wickr_transport_resumption_t **resumption);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* transport_resumption_h */
@@ -127,6 +127,20 @@ wickr_stream_key_t *wickr_transport_root_key_to_stream_key(const wickr_transport
                                                            const wickr_buffer_t *stream_id,
                                                            wickr_stream_direction direction);
 
+/**
+ @ingroup wickr_transport_root_key
+ 
+ Derive a resumption root key from a transport root key. The resulting key is used to resume a transport
+ session without repeating the ECDH portion of the handshake. It uses the same cipher and evolution
+ parameters as `root_key`, but a secret derived with HKDF so that it can not be used to recover `root_key`
+ 
+ @param root_key the transport root key to derive a resumption root key from
+ @param engine a pointer to a crypto engine that supports HKDF functionality
+ @return a newly allocated transport root key or NULL if derivation fails
+ */
+wickr_transport_root_key_t *wickr_transport_root_key_derive_resumption(const wickr_transport_root_key_t *root_key,
+                                                                       const wickr_crypto_engine_t *engine);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,157 @@
+/*
+* Copyright © 2012-2020 Wickr Inc.  All rights reserved.
+*
+* This code is being released for EDUCATIONAL, ACADEMIC, AND CODE REVIEW PURPOSES
+* ONLY.  COMMERCIAL USE OF THE CODE IS EXPRESSLY PROHIBITED.  For additional details,
+* please see LICENSE
+*
+* THE CODE IS MADE AVAILABLE "AS-IS" AND WITHOUT ANY EXPRESS OR
+* IMPLIED GUARANTEES AS TO FITNESS, MERCHANTABILITY, NON-
+* INFRINGEMENT OR OTHERWISE. IT IS NOT BEING PROVIDED IN TRADE BUT ON
+* A VOLUNTARY BASIS ON BEHALF OF THE AUTHOR’S PART FOR THE BENEFIT
+* OF THE LICENSEE AND IS NOT MADE AVAILABLE FOR CONSUMER USE OR ANY
+* OTHER USE OUTSIDE THE TERMS OF THIS LICENSE. ANYONE ACCESSING THE
+* CODE SHOULD HAVE THE REQUISITE EXPERTISE TO SECURE THEIR SYSTEM
+* AND DEVICES AND TO ACCESS AND USE THE CODE FOR REVIEW PURPOSES
+* ONLY. LICENSEE BEARS THE RISK OF ACCESSING AND USING THE CODE. IN
+* PARTICULAR, AUTHOR BEARS NO LIABILITY FOR ANY INTERFERENCE WITH OR
+* ADVERSE EFFECT THAT MAY OCCUR AS A RESULT OF THE LICENSEE
+* ACCESSING AND/OR USING THE CODE ON LICENSEE’S SYSTEM.
+*/
+
+#ifndef transport_stats_h
+#define transport_stats_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+@addtogroup wickr_transport_stats
+*/
+
+#ifdef WICKR_TRANSPORT_STATS_TIMING
+
+/* Number of buckets in a timing histogram. Bucket n counts samples in the range [2^n, 2^(n+1)) nanoseconds */
+#define TRANSPORT_STATS_HISTOGRAM_BUCKETS 40
+
+/**
+ @ingroup wickr_transport_stats
+ 
+ @struct wickr_transport_histogram
+ 
+ @brief A log2 bucketed histogram of durations measured in nanoseconds.
+ Only available when the library is built with WICKR_TRANSPORT_STATS_TIMING
+ 
+ @var wickr_transport_histogram::count
+ the number of samples recorded
+ @var wickr_transport_histogram::total_ns
+ the sum of all recorded samples
+ @var wickr_transport_histogram::min_ns
+ the smallest recorded sample, 0 if no samples have been recorded
+ @var wickr_transport_histogram::max_ns
+ the largest recorded sample
+ @var wickr_transport_histogram::buckets
+ sample counts, bucket n holds samples with a duration in the range [2^n, 2^(n+1)) nanoseconds. Samples
+ of 0ns are counted in bucket 0, and samples beyond the last bucket are counted in the last bucket
+ */
+struct wickr_transport_histogram {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint64_t buckets[TRANSPORT_STATS_HISTOGRAM_BUCKETS];
+};
+
+typedef struct wickr_transport_histogram wickr_transport_histogram_t;
+
+#endif
+
+/**
+ @ingroup wickr_transport_stats
+ 
+ @struct wickr_transport_stats
+ 
+ @brief A snapshot of monotonic counters describing the lifetime of a transport context
+ 
+ @var wickr_transport_stats::tx_packets
+ the number of encrypted packets passed to the tx callback
+ @var wickr_transport_stats::tx_bytes
+ the number of plaintext bytes that were encrypted into tx packets
+ @var wickr_transport_stats::tx_wire_bytes
+ the number of bytes passed to the tx callback, including handshake packets
+ @var wickr_transport_stats::rx_packets
+ the number of packets that were successfully decrypted and passed to the rx callback
+ @var wickr_transport_stats::rx_bytes
+ the number of plaintext bytes passed to the rx callback
+ @var wickr_transport_stats::rx_wire_bytes
+ the number of bytes received by the transport, including handshake packets and packets that failed to decode
+ @var wickr_transport_stats::handshake_tx_packets
+ the number of handshake packets passed to the tx callback
+ @var wickr_transport_stats::handshake_rx_packets
+ the number of handshake packets received
+ @var wickr_transport_stats::tx_encode_failures
+ the number of outbound buffers that could not be encrypted
+ @var wickr_transport_stats::rx_parse_failures
+ the number of inbound buffers that could not be parsed as a packet or cipher result
+ @var wickr_transport_stats::rx_mac_type_failures
+ the number of inbound packets rejected because they did not use an authenticated cipher
+ @var wickr_transport_stats::rx_sequence_failures
+ the number of inbound packets rejected because their sequence number was not greater than the last one received
+ @var wickr_transport_stats::rx_decrypt_failures
+ the number of inbound packets that failed authentication or decryption
+ @var wickr_transport_stats::tx_evolutions
+ the number of key evolutions performed by the tx stream
+ @var wickr_transport_stats::rx_evolutions
+ the number of key evolutions performed by the rx stream
+ @var wickr_transport_stats::handshakes_started
+ the number of handshakes that were created by the transport
+ @var wickr_transport_stats::handshakes_completed
+ the number of handshakes that finished and produced stream keys
+ @var wickr_transport_stats::handshakes_resumed
+ the number of handshakes that were completed using a resumption ticket instead of a key exchange
+ @var wickr_transport_stats::handshakes_failed
+ the number of handshakes that failed
+ @var wickr_transport_stats::handshake_time
+ time from the creation of a handshake until it completes. Only available with WICKR_TRANSPORT_STATS_TIMING
+ @var wickr_transport_stats::tx_packet_time
+ time spent encrypting and serializing each tx packet. Only available with WICKR_TRANSPORT_STATS_TIMING
+ @var wickr_transport_stats::rx_packet_time
+ time spent parsing and decrypting each rx packet. Only available with WICKR_TRANSPORT_STATS_TIMING
+ */
+struct wickr_transport_stats {
+    uint64_t tx_packets;
+    uint64_t tx_bytes;
+    uint64_t tx_wire_bytes;
+    uint64_t rx_packets;
+    uint64_t rx_bytes;
+    uint64_t rx_wire_bytes;
+    uint64_t handshake_tx_packets;
+    uint64_t handshake_rx_packets;
+    uint64_t tx_encode_failures;
+    uint64_t rx_parse_failures;
+    uint64_t rx_mac_type_failures;
+    uint64_t rx_sequence_failures;
+    uint64_t rx_decrypt_failures;
+    uint64_t tx_evolutions;
+    uint64_t rx_evolutions;
+    uint64_t handshakes_started;
+    uint64_t handshakes_completed;
+    uint64_t handshakes_resumed;
+    uint64_t handshakes_failed;
+#ifdef WICKR_TRANSPORT_STATS_TIMING
+    wickr_transport_histogram_t handshake_time;
+    wickr_transport_histogram_t tx_packet_time;
+    wickr_transport_histogram_t rx_packet_time;
+#endif
+};
+
+typedef struct wickr_transport_stats wickr_transport_stats_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* transport_stats_h */
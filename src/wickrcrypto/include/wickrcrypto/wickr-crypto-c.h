@@ -22,8 +22,11 @@
 #ifndef wickr_crypto_c_h
 #define wickr_crypto_c_h
 
+#include "arena.h"
+#include "secure_heap.h"
 #include "array.h"
 #include "buffer.h"
+#include "buffer_writer.h"
 #include "cipher.h"
 #include "crypto_engine.h"
 #include "devinfo.h"
@@ -42,10 +45,13 @@
 #include "storage.h"
 #include "util.h"
 #include "wickr_ctx.h"
+#include "wickr_ctx_async.h"
 #include "stream_ctx.h"
 #include "transport_ctx.h"
 #include "transport_handshake.h"
 #include "transport_packet.h"
+#include "transport_pool.h"
+#include "transport_resumption.h"
 #include "transport_root_key.h"
 
 #endif /* wickr_crypto_c_h */
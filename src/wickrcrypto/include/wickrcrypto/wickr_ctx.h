@@ -343,6 +343,20 @@ wickr_ctx_t *wickr_ctx_create_from_buffer(const wickr_crypto_engine_t engine,
  @return bytes representing an scrypt encrypted context
  */
 wickr_buffer_t *wickr_ctx_export(const wickr_ctx_t *ctx, const wickr_buffer_t *passphrase);
+
+/**
+ @ingroup wickr_ctx
+ 
+ Serialize and encrypt a context with a passphrase using a specific KDF mode
+ 
+ The chosen mode is recorded in the output, so 'wickr_ctx_import' does not need to know which mode was used
+ 
+ @param ctx the context to serialize and encrypt
+ @param algo the KDF mode to derive the encryption key with, for example the result of 'wickr_kdf_calibrate'. Must be a scrypt or Argon2id mode
+ @param passphrase the password to use for locking the exported data, can be a string or bytes
+ @return bytes representing a context encrypted with a key derived by 'algo'
+ */
+wickr_buffer_t *wickr_ctx_export_with_kdf(const wickr_ctx_t *ctx, wickr_kdf_algo_t algo, const wickr_buffer_t *passphrase);
     
 /**
  @ingroup wickr_ctx
@@ -373,6 +387,17 @@ wickr_ctx_t *wickr_ctx_import(const wickr_crypto_engine_t engine,
  */
 wickr_buffer_t *wickr_ctx_export_storage_keys(const wickr_ctx_t *ctx, const wickr_buffer_t *passphrase);
 
+/**
+ @ingroup wickr_ctx
+ Exports storage keys for a context using a specific KDF mode + CIPHER function
+ 
+ @param ctx the context to export storage keys from
+ @param algo the KDF mode to derive the encryption key with. Must be a scrypt or Argon2id mode
+ @param passphrase the passphrase to use as input to a KDF that will generated a key to protect storage keys
+ @return a buffer containing exported storage keys that can be imported with 'wickr_ctx_import_storage_keys'
+ */
+wickr_buffer_t *wickr_ctx_export_storage_keys_with_kdf(const wickr_ctx_t *ctx, wickr_kdf_algo_t algo, const wickr_buffer_t *passphrase);
+
 /**
  @ingroup wickr_ctx
  Import storage keys exported with 'wickr_ctx_export_storage_keys'
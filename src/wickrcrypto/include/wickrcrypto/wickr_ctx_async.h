@@ -0,0 +1,277 @@
+/*
+ * Copyright © 2012-2020 Wickr Inc.  All rights reserved.
+ *
+ * This code is being released for EDUCATIONAL, ACADEMIC, AND CODE REVIEW PURPOSES
+ * ONLY.  COMMERCIAL USE OF THE CODE IS EXPRESSLY PROHIBITED.  For additional details,
+ * please see LICENSE
+ *
+ * THE CODE IS MADE AVAILABLE "AS-IS" AND WITHOUT ANY EXPRESS OR
+ * IMPLIED GUARANTEES AS TO FITNESS, MERCHANTABILITY, NON-
+ * INFRINGEMENT OR OTHERWISE. IT IS NOT BEING PROVIDED IN TRADE BUT ON
+ * A VOLUNTARY BASIS ON BEHALF OF THE AUTHOR’S PART FOR THE BENEFIT
+ * OF THE LICENSEE AND IS NOT MADE AVAILABLE FOR CONSUMER USE OR ANY
+ * OTHER USE OUTSIDE THE TERMS OF THIS LICENSE. ANYONE ACCESSING THE
+ * CODE SHOULD HAVE THE REQUISITE EXPERTISE TO SECURE THEIR SYSTEM
+ * AND DEVICES AND TO ACCESS AND USE THE CODE FOR REVIEW PURPOSES
+ * ONLY. LICENSEE BEARS THE RISK OF ACCESSING AND USING THE CODE. IN
+ * PARTICULAR, AUTHOR BEARS NO LIABILITY FOR ANY INTERFERENCE WITH OR
+ * ADVERSE EFFECT THAT MAY OCCUR AS A RESULT OF THE LICENSEE
+ * ACCESSING AND/OR USING THE CODE ON LICENSEE’S SYSTEM.
+ */
+
+#ifndef wickr_ctx_async_h
+#define wickr_ctx_async_h
+
+#include "wickr_ctx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ @addtogroup wickr_ctx_async wickr_ctx_async
+ */
+
+/**
+ @ingroup wickr_ctx_async
+
+ @enum wickr_async_status
+
+ @brief The state of an asynchronous context operation
+
+ @var wickr_async_status::ASYNC_STATUS_PENDING
+ The operation has been submitted to its executor but has not started
+ @var wickr_async_status::ASYNC_STATUS_RUNNING
+ The operation is currently performing its KDF work
+ @var wickr_async_status::ASYNC_STATUS_SUCCESS
+ The operation finished and produced a result
+ @var wickr_async_status::ASYNC_STATUS_FAILED
+ The operation finished without producing a result, for example because of an incorrect passphrase
+ @var wickr_async_status::ASYNC_STATUS_CANCELLED
+ The operation was cancelled before it could deliver a result
+ */
+typedef enum {
+    ASYNC_STATUS_PENDING,
+    ASYNC_STATUS_RUNNING,
+    ASYNC_STATUS_SUCCESS,
+    ASYNC_STATUS_FAILED,
+    ASYNC_STATUS_CANCELLED
+} wickr_async_status;
+
+/**
+ @ingroup wickr_ctx_async
+ @struct wickr_async_op
+
+ @brief A handle to a context operation that runs off of the calling thread
+
+ Passphrase based context operations run scrypt / bcrypt, which can take hundreds of milliseconds and a large amount of memory.
+ The async variants copy their inputs, hand the work to an executor and return immediately with a handle that can be used to
+ cancel, wait for, or collect the result of the operation. The handle is reference counted internally, so it is safe to destroy it
+ at any time, even while the operation is still running
+ */
+struct wickr_async_op;
+typedef struct wickr_async_op wickr_async_op_t;
+
+/* A unit of work handed to an executor. It must be invoked exactly once */
+typedef void (*wickr_async_work_func)(void *work);
+
+/* Schedule 'func(work)' to run. Return false if the work could not be scheduled, in which case it must never be invoked */
+typedef bool (*wickr_async_submit_func)(wickr_async_work_func func, void *work, void *user);
+
+/**
+ @ingroup wickr_ctx_async
+
+ @struct wickr_async_executor
+
+ @brief A caller supplied executor for asynchronous operations, such as a platform thread pool or dispatch queue. Passing NULL in
+ place of an executor runs operations on a single worker thread owned by the library, which processes operations in the order
+ they were submitted
+
+ @var wickr_async_executor::submit
+ function that schedules work to run on another thread
+ @var wickr_async_executor::user
+ a pointer to be passed to 'submit'
+ */
+struct wickr_async_executor {
+    wickr_async_submit_func submit;
+    void *user;
+};
+
+typedef struct wickr_async_executor wickr_async_executor_t;
+
+/*
+ Completion callbacks. They are called exactly once per operation on the thread that ran the operation, including when an operation
+ fails or is cancelled. Ownership of 'result' is transferred to the callback, and it is NULL unless status is ASYNC_STATUS_SUCCESS
+ */
+typedef void (*wickr_ctx_async_buffer_func)(wickr_async_status status, wickr_buffer_t *result, void *user);
+typedef void (*wickr_ctx_async_ctx_func)(wickr_async_status status, wickr_ctx_t *result, void *user);
+typedef void (*wickr_ctx_async_gen_func)(wickr_async_status status, wickr_ctx_gen_result_t *result, void *user);
+
+/**
+ @ingroup wickr_ctx_async
+
+ Asynchronous variant of 'wickr_ctx_export'
+
+ @param ctx the context to export. It is copied, so it may be destroyed once this function returns
+ @param passphrase the passphrase to protect the export with. It is copied
+ @param executor the executor to run the operation on, or NULL to use the internal worker thread
+ @param on_complete called with the exported context when the operation finishes. If NULL, the result is held by the operation
+ and can be collected with 'wickr_async_op_take_buffer'
+ @param user a pointer to be passed to 'on_complete'
+ @return a handle to the operation, or NULL if the inputs are invalid or the operation could not be submitted. In the failure
+ case 'on_complete' will never be called
+ */
+wickr_async_op_t *wickr_ctx_export_async(const wickr_ctx_t *ctx,
+                                         const wickr_buffer_t *passphrase,
+                                         const wickr_async_executor_t *executor,
+                                         wickr_ctx_async_buffer_func on_complete,
+                                         void *user);
+
+/**
+ @ingroup wickr_ctx_async
+
+ Asynchronous variant of 'wickr_ctx_import'
+
+ @param engine a crypto engine
+ @param dev_info device information for the imported context. Unlike 'wickr_ctx_import' it is copied, so ownership stays with
+ the caller
+ @param exported the output of 'wickr_ctx_export' or 'wickr_ctx_export_async'. It is copied
+ @param passphrase the passphrase that was used for the export. It is copied
+ @param executor the executor to run the operation on, or NULL to use the internal worker thread
+ @param on_complete called with the imported context when the operation finishes. If NULL, the result is held by the operation
+ and can be collected with 'wickr_async_op_take_ctx'
+ @param user a pointer to be passed to 'on_complete'
+ @return a handle to the operation, or NULL if the inputs are invalid or the operation could not be submitted
+ */
+wickr_async_op_t *wickr_ctx_import_async(const wickr_crypto_engine_t engine,
+                                         const wickr_dev_info_t *dev_info,
+                                         const wickr_buffer_t *exported,
+                                         const wickr_buffer_t *passphrase,
+                                         const wickr_async_executor_t *executor,
+                                         wickr_ctx_async_ctx_func on_complete,
+                                         void *user);
+
+/**
+ @ingroup wickr_ctx_async
+
+ Asynchronous variant of 'wickr_ctx_export_storage_keys'
+
+ @param ctx the context to export storage keys from. It is copied
+ @param passphrase the passphrase to protect the export with. It is copied
+ @param executor the executor to run the operation on, or NULL to use the internal worker thread
+ @param on_complete called with the exported storage keys when the operation finishes. If NULL, the result is held by the
+ operation and can be collected with 'wickr_async_op_take_buffer'
+ @param user a pointer to be passed to 'on_complete'
+ @return a handle to the operation, or NULL if the inputs are invalid or the operation could not be submitted
+ */
+wickr_async_op_t *wickr_ctx_export_storage_keys_async(const wickr_ctx_t *ctx,
+                                                      const wickr_buffer_t *passphrase,
+                                                      const wickr_async_executor_t *executor,
+                                                      wickr_ctx_async_buffer_func on_complete,
+                                                      void *user);
+
+/**
+ @ingroup wickr_ctx_async
+
+ Asynchronous variant of 'wickr_ctx_gen_with_passphrase'. All buffer and device info inputs are copied
+
+ @param engine a crypto engine
+ @param dev_info the device information to use for the generated context
+ @param exported_recovery_key the output of 'wickr_ctx_gen_export_recovery_key_passphrase'
+ @param passphrase the passphrase used to export the recovery key
+ @param recovery_data the output of 'wickr_ctx_gen_result_make_recovery'
+ @param identifier the unique identifier of the user
+ @param executor the executor to run the operation on, or NULL to use the internal worker thread
+ @param on_complete called with the generation result when the operation finishes. If NULL, the result is held by the operation
+ and can be collected with 'wickr_async_op_take_gen_result'
+ @param user a pointer to be passed to 'on_complete'
+ @return a handle to the operation, or NULL if the inputs are invalid or the operation could not be submitted
+ */
+wickr_async_op_t *wickr_ctx_gen_with_passphrase_async(const wickr_crypto_engine_t engine,
+                                                      const wickr_dev_info_t *dev_info,
+                                                      const wickr_buffer_t *exported_recovery_key,
+                                                      const wickr_buffer_t *passphrase,
+                                                      const wickr_buffer_t *recovery_data,
+                                                      const wickr_buffer_t *identifier,
+                                                      const wickr_async_executor_t *executor,
+                                                      wickr_ctx_async_gen_func on_complete,
+                                                      void *user);
+
+/**
+ @ingroup wickr_ctx_async
+
+ Cancel an operation. An operation that has not started is skipped entirely. The KDF of an operation that is already running
+ can't be interrupted, so it runs to completion and its result is destroyed instead of being delivered. In both cases the
+ completion callback is called with ASYNC_STATUS_CANCELLED
+
+ @param op the operation to cancel
+ @return true if the operation was cancelled, false if it had already produced its final status
+ */
+bool wickr_async_op_cancel(wickr_async_op_t *op);
+
+/**
+ @ingroup wickr_ctx_async
+
+ Block until an operation has finished and its completion callback, if any, has returned. This must not be called from the
+ completion callback, or from the executor thread when using an executor that runs work serially
+
+ @param op the operation to wait for
+ @return the final status of the operation
+ */
+wickr_async_status wickr_async_op_wait(wickr_async_op_t *op);
+
+/**
+ @ingroup wickr_ctx_async
+
+ Get the current status of an operation
+
+ @param op the operation to check
+ @return the status of the operation at the time of the call
+ */
+wickr_async_status wickr_async_op_get_status(const wickr_async_op_t *op);
+
+/**
+ @ingroup wickr_ctx_async
+
+ Collect the result of a finished operation that was created without a completion callback. Each result can only be taken once
+
+ @param op an export or storage key export operation
+ @return the exported buffer, or NULL if the operation has not succeeded, is of a different type, or the result was already taken
+ */
+wickr_buffer_t *wickr_async_op_take_buffer(wickr_async_op_t *op);
+
+/**
+ @ingroup wickr_ctx_async
+
+ Collect the result of a finished import operation that was created without a completion callback
+
+ @param op an import operation
+ @return the imported context, or NULL if the operation has not succeeded, is of a different type, or the result was already taken
+ */
+wickr_ctx_t *wickr_async_op_take_ctx(wickr_async_op_t *op);
+
+/**
+ @ingroup wickr_ctx_async
+
+ Collect the result of a finished passphrase generation operation that was created without a completion callback
+
+ @param op a passphrase generation operation
+ @return the generation result, or NULL if the operation has not succeeded, is of a different type, or the result was already taken
+ */
+wickr_ctx_gen_result_t *wickr_async_op_take_gen_result(wickr_async_op_t *op);
+
+/**
+ @ingroup wickr_ctx_async
+
+ Release the caller's handle to an operation. This does not cancel the operation, which will still finish and call its
+ completion callback. Any result that was not taken is destroyed once the operation finishes
+
+ @param op a pointer to the operation handle to release
+ */
+void wickr_async_op_destroy(wickr_async_op_t **op);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* wickr_ctx_async_h */
@@ -0,0 +1,266 @@
+
+#include "arena.h"
+#include "private/memory_priv.h"
+
+#include <string.h>
+
+/* Arena allocations are aligned the same way as malloc on 64bit platforms */
+#define ARENA_ALIGNMENT 16
+#define ARENA_ALIGN(len) (((len) + (ARENA_ALIGNMENT - 1)) & ~((size_t)ARENA_ALIGNMENT - 1))
+
+typedef struct wickr_arena_block {
+    struct wickr_arena_block *next;
+    size_t size;
+    size_t used;
+} wickr_arena_block_t;
+
+#define ARENA_BLOCK_HEADER_SIZE ARENA_ALIGN(sizeof(wickr_arena_block_t))
+#define ARENA_BLOCK_DATA(block) ((uint8_t *)(block) + ARENA_BLOCK_HEADER_SIZE)
+
+struct wickr_arena {
+    wickr_allocator_t allocator;
+    wickr_arena_block_t *blocks;
+    size_t block_size;
+    size_t used;
+    bool is_open;
+    bool is_suspended;
+    struct wickr_arena *previous;
+};
+
+/* The innermost open arena scope of the calling thread. Outer scopes are linked through 'previous' */
+static WICKR_THREAD_LOCAL wickr_arena_t *__wickr_arena_top = NULL;
+
+wickr_arena_t *wickr_arena_create(size_t block_size)
+{
+    if (block_size == 0) {
+        block_size = WICKR_ARENA_DEFAULT_BLOCK_SIZE;
+    }
+    
+    if (block_size > SIZE_MAX - ARENA_BLOCK_HEADER_SIZE - ARENA_ALIGNMENT) {
+        return NULL;
+    }
+    
+    /* The arena and its blocks come straight from the allocator so they never land inside another arena */
+    wickr_allocator_t allocator = wickr_get_allocator();
+    wickr_arena_t *arena = allocator.alloc(sizeof(wickr_arena_t), allocator.user);
+    
+    if (!arena) {
+        return NULL;
+    }
+    
+    memset(arena, 0, sizeof(wickr_arena_t));
+    arena->allocator = allocator;
+    arena->block_size = ARENA_ALIGN(block_size);
+    
+    return arena;
+}
+
+static wickr_arena_block_t *__wickr_arena_block_create(wickr_arena_t *arena, size_t size)
+{
+    wickr_arena_block_t *block = arena->allocator.alloc(ARENA_BLOCK_HEADER_SIZE + size, arena->allocator.user);
+    
+    if (!block) {
+        return NULL;
+    }
+    
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    
+    return block;
+}
+
+static void *__wickr_arena_alloc(wickr_arena_t *arena, size_t len)
+{
+    if (len > SIZE_MAX - ARENA_BLOCK_HEADER_SIZE - ARENA_ALIGNMENT) {
+        return NULL;
+    }
+    
+    size_t aligned_len = ARENA_ALIGN(len);
+    wickr_arena_block_t *head = arena->blocks;
+    
+    if (head && head->size - head->used >= aligned_len) {
+        void *buf = ARENA_BLOCK_DATA(head) + head->used;
+        head->used += aligned_len;
+        arena->used += aligned_len;
+        return buf;
+    }
+    
+    /* Oversized allocations get a block of their own behind the current block, so the current block keeps serving small ones */
+    if (aligned_len > arena->block_size) {
+        wickr_arena_block_t *block = __wickr_arena_block_create(arena, aligned_len);
+    
+        if (!block) {
+            return NULL;
+        }
+    
+        block->used = aligned_len;
+        arena->used += aligned_len;
+    
+        if (head) {
+            block->next = head->next;
+            head->next = block;
+        }
+        else {
+            arena->blocks = block;
+        }
+    
+        return ARENA_BLOCK_DATA(block);
+    }
+    
+    wickr_arena_block_t *block = __wickr_arena_block_create(arena, arena->block_size);
+    
+    if (!block) {
+        return NULL;
+    }
+    
+    block->next = head;
+    block->used = aligned_len;
+    arena->blocks = block;
+    arena->used += aligned_len;
+    
+    return ARENA_BLOCK_DATA(block);
+}
+
+void *wickr_arena_alloc_active(size_t len, bool zero)
+{
+    wickr_arena_t *arena = __wickr_arena_top;
+    
+    if (!arena || arena->is_suspended) {
+        return NULL;
+    }
+    
+    void *buf = __wickr_arena_alloc(arena, len);
+    
+    /* Blocks are zeroed when a scope ends, but a block may be reused within the scope it was allocated in */
+    if (buf && zero) {
+        memset(buf, 0, len);
+    }
+    
+    return buf;
+}
+
+bool wickr_arena_owns(const void *buf)
+{
+    for (wickr_arena_t *arena = __wickr_arena_top; arena; arena = arena->previous) {
+        for (wickr_arena_block_t *block = arena->blocks; block; block = block->next) {
+            const uint8_t *data = ARENA_BLOCK_DATA(block);
+    
+            if ((const uint8_t *)buf >= data && (const uint8_t *)buf < data + block->size) {
+                return true;
+            }
+        }
+    }
+    
+    return false;
+}
+
+bool wickr_arena_begin(wickr_arena_t *arena)
+{
+    if (!arena || arena->is_open) {
+        return false;
+    }
+    
+    arena->is_open = true;
+    arena->is_suspended = false;
+    arena->previous = __wickr_arena_top;
+    __wickr_arena_top = arena;
+    
+    return true;
+}
+
+static void __wickr_arena_release(wickr_arena_t *arena)
+{
+    wickr_arena_block_t *kept = NULL;
+    wickr_arena_block_t *block = arena->blocks;
+    
+    while (block) {
+        wickr_arena_block_t *next = block->next;
+        wickr_secure_zero(ARENA_BLOCK_DATA(block), block->used);
+    
+        /* Keep one regular block around so the next scope does not need to allocate */
+        if (!kept && block->size == arena->block_size) {
+            kept = block;
+            kept->used = 0;
+            kept->next = NULL;
+        }
+        else {
+            arena->allocator.free(block, arena->allocator.user);
+        }
+    
+        block = next;
+    }
+    
+    arena->blocks = kept;
+    arena->used = 0;
+}
+
+bool wickr_arena_end(wickr_arena_t *arena)
+{
+    if (!arena || __wickr_arena_top != arena) {
+        return false;
+    }
+    
+    __wickr_arena_top = arena->previous;
+    arena->previous = NULL;
+    arena->is_open = false;
+    arena->is_suspended = false;
+    
+    __wickr_arena_release(arena);
+    
+    return true;
+}
+
+wickr_arena_t *wickr_arena_suspend(void)
+{
+    wickr_arena_t *arena = __wickr_arena_top;
+    
+    if (!arena || arena->is_suspended) {
+        return NULL;
+    }
+    
+    arena->is_suspended = true;
+    
+    return arena;
+}
+
+void wickr_arena_resume(wickr_arena_t *arena)
+{
+    if (!arena) {
+        return;
+    }
+    
+    arena->is_suspended = false;
+}
+
+bool wickr_arena_is_active(void)
+{
+    return __wickr_arena_top && !__wickr_arena_top->is_suspended;
+}
+
+size_t wickr_arena_get_used(const wickr_arena_t *arena)
+{
+    if (!arena) {
+        return 0;
+    }
+    
+    return arena->used;
+}
+
+void wickr_arena_destroy(wickr_arena_t **arena)
+{
+    if (!arena || !*arena || (*arena)->is_open) {
+        return;
+    }
+    
+    __wickr_arena_release(*arena);
+    
+    wickr_allocator_t allocator = (*arena)->allocator;
+    
+    if ((*arena)->blocks) {
+        allocator.free((*arena)->blocks, allocator.user);
+    }
+    
+    allocator.free(*arena, allocator.user);
+    *arena = NULL;
+}
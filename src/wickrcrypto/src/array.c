@@ -2,9 +2,16 @@
 #include "array.h"
 #include "memory.h"
 
+#include <string.h>
+
+/* Arrays that grow through wickr_array_push start with room for this many items and double from there */
+#define ARRAY_MIN_CAPACITY 4
+
 struct wickr_array {
     uint32_t size;
     uint8_t item_type;
+    bool is_inline;
+    size_t item_size;
     void * (*item_copy_func) (void *);
     void (*item_destroy_func)(void **);
     wickr_buffer_t *item_store;
@@ -12,19 +19,21 @@ struct wickr_array {
 
 typedef struct wickr_array_item wickr_array_item_t;
 
-wickr_array_t *wickr_array_new(uint32_t item_count,
-                               uint8_t item_type,
-                               wickr_array_copy_func item_copy_func,
-                               wickr_array_destroy_func item_destroy_func)
+static wickr_array_t *__wickr_array_create(uint32_t item_count,
+                                           uint8_t item_type,
+                                           size_t item_size,
+                                           bool is_inline,
+                                           wickr_array_copy_func item_copy_func,
+                                           wickr_array_destroy_func item_destroy_func)
 {
-    if (!item_copy_func || !item_destroy_func) {
+    if (item_count != 0 && item_size > SIZE_MAX / item_count) {
         return NULL;
     }
     
     wickr_buffer_t *item_store = NULL;
     
     if (item_count != 0) {
-        item_store = wickr_buffer_create_empty_zero(sizeof(uintptr_t) * item_count);
+        item_store = wickr_buffer_create_empty_zero(item_size * item_count);
         
         if (!item_store) {
             return NULL;
@@ -40,6 +49,8 @@ wickr_array_t *wickr_array_new(uint32_t item_count,
     
     new_array->size = item_count;
     new_array->item_type = item_type;
+    new_array->is_inline = is_inline;
+    new_array->item_size = item_size;
     new_array->item_store = item_store;
     new_array->item_copy_func = item_copy_func;
     new_array->item_destroy_func = item_destroy_func;
@@ -47,6 +58,27 @@ wickr_array_t *wickr_array_new(uint32_t item_count,
     return new_array;
 }
 
+wickr_array_t *wickr_array_new(uint32_t item_count,
+                               uint8_t item_type,
+                               wickr_array_copy_func item_copy_func,
+                               wickr_array_destroy_func item_destroy_func)
+{
+    if (!item_copy_func || !item_destroy_func) {
+        return NULL;
+    }
+    
+    return __wickr_array_create(item_count, item_type, sizeof(uintptr_t), false, item_copy_func, item_destroy_func);
+}
+
+wickr_array_t *wickr_array_new_inline(uint32_t item_count, uint8_t item_type, size_t item_size)
+{
+    if (item_size == 0) {
+        return NULL;
+    }
+    
+    return __wickr_array_create(item_count, item_type, item_size, true, NULL, NULL);
+}
+
 uint32_t wickr_array_get_item_count(const wickr_array_t *array)
 {
     if (!array) {
@@ -56,6 +88,15 @@ uint32_t wickr_array_get_item_count(const wickr_array_t *array)
     return array->size;
 }
 
+uint32_t wickr_array_get_capacity(const wickr_array_t *array)
+{
+    if (!array || !array->item_store) {
+        return 0;
+    }
+    
+    return (uint32_t)(array->item_store->length / array->item_size);
+}
+
 static bool __wickr_array_index_in_bounds(const wickr_array_t *array, uint32_t index)
 {
     if (!array || array->size <= index) {
@@ -65,19 +106,55 @@ static bool __wickr_array_index_in_bounds(const wickr_array_t *array, uint32_t i
     return true;
 }
 
+static uint8_t *__wickr_array_slot(const wickr_array_t *array, uint32_t index)
+{
+    return array->item_store->bytes + (size_t)index * array->item_size;
+}
+
+/* The item a slot holds, which is the slot itself for inline arrays and the pointer stored in it otherwise */
+static void *__wickr_array_slot_item(const wickr_array_t *array, uint8_t *slot)
+{
+    if (array->is_inline) {
+        return slot;
+    }
+    
+    uintptr_t item;
+    memcpy(&item, slot, sizeof(uintptr_t));
+    return (void *)item;
+}
+
 static void *__wickr_array_pointer_to_index(const wickr_array_t *array, uint32_t index)
 {
     if (!__wickr_array_index_in_bounds(array, index)) {
         return NULL;
     }
-    uintptr_t *item_list = (uintptr_t *)array->item_store->bytes;
-    return (void *)(item_list[index]);
+    
+    return __wickr_array_slot_item(array, __wickr_array_slot(array, index));
 }
 
-bool wickr_array_set_item(wickr_array_t *array, uint32_t index, void *item, bool copy)
+static void __wickr_array_destroy_item(const wickr_array_t *array, uint32_t index)
 {
-    if (!__wickr_array_index_in_bounds(array, index)) {
-        return false;
+    if (array->is_inline) {
+        return;
+    }
+    
+    void *one_item = __wickr_array_pointer_to_index(array, index);
+    
+    if (one_item) {
+        array->item_destroy_func(&one_item);
+    }
+}
+
+static bool __wickr_array_write_item(wickr_array_t *array, uint32_t index, void *item, bool copy)
+{
+    if (array->is_inline) {
+        if (item) {
+            memmove(__wickr_array_slot(array, index), item, array->item_size);
+        }
+        else {
+            wickr_secure_zero(__wickr_array_slot(array, index), array->item_size);
+        }
+        return true;
     }
     
     void *item_to_write = NULL;
@@ -90,14 +167,29 @@ bool wickr_array_set_item(wickr_array_t *array, uint32_t index, void *item, bool
         }
     }
     
-    void *one_item = __wickr_array_pointer_to_index(array, index);
+    uintptr_t ptr_to_write = (uintptr_t)item_to_write;
+    memcpy(__wickr_array_slot(array, index), &ptr_to_write, sizeof(uintptr_t));
+    
+    return true;
+}
+
+bool wickr_array_set_item(wickr_array_t *array, uint32_t index, void *item, bool copy)
+{
+    if (!__wickr_array_index_in_bounds(array, index)) {
+        return false;
+    }
+    
+    void *one_item = array->is_inline ? NULL : __wickr_array_pointer_to_index(array, index);
+    
+    if (!__wickr_array_write_item(array, index, item, copy)) {
+        return false;
+    }
     
     if (one_item && copy) {
         array->item_destroy_func(&one_item);
     }
     
-	uintptr_t ptr_to_write = (uintptr_t)item_to_write;
-    return wickr_buffer_modify_section(array->item_store, (uint8_t *)&ptr_to_write, index * sizeof(uintptr_t), sizeof(uintptr_t));
+    return true;
 }
 
 void *wickr_array_fetch_item(const wickr_array_t *array, uint32_t index, bool copy)
@@ -108,12 +200,211 @@ void *wickr_array_fetch_item(const wickr_array_t *array, uint32_t index, bool co
         return NULL;
     }
     
-    if (copy) {
-        return array->item_copy_func(item);
+    if (!copy) {
+        return item;
     }
     
-    return item;
+    if (array->is_inline) {
+        void *item_copy = wickr_alloc(array->item_size);
     
+        if (item_copy) {
+            memcpy(item_copy, item, array->item_size);
+        }
+    
+        return item_copy;
+    }
+    
+    return array->item_copy_func(item);
+}
+
+bool wickr_array_reserve(wickr_array_t *array, uint32_t capacity)
+{
+    if (!array) {
+        return false;
+    }
+    
+    if (capacity <= wickr_array_get_capacity(array)) {
+        return true;
+    }
+    
+    if (array->item_size > SIZE_MAX / capacity) {
+        return false;
+    }
+    
+    wickr_buffer_t *item_store = wickr_buffer_create_empty_zero(array->item_size * capacity);
+    
+    if (!item_store) {
+        return false;
+    }
+    
+    if (array->size != 0) {
+        memcpy(item_store->bytes, array->item_store->bytes, (size_t)array->size * array->item_size);
+    }
+    
+    /* Inline items may be key material, so their old storage is zeroed on the way out */
+    if (array->is_inline) {
+        wickr_buffer_destroy_zero(&array->item_store);
+    }
+    else {
+        wickr_buffer_destroy(&array->item_store);
+    }
+    
+    array->item_store = item_store;
+    
+    return true;
+}
+
+bool wickr_array_push(wickr_array_t *array, void *item, bool copy)
+{
+    if (!array || array->size == UINT32_MAX) {
+        return false;
+    }
+    
+    uint32_t capacity = wickr_array_get_capacity(array);
+    
+    if (array->size == capacity) {
+        uint32_t new_capacity = capacity > UINT32_MAX / 2 ? UINT32_MAX : capacity * 2;
+    
+        if (new_capacity < ARRAY_MIN_CAPACITY) {
+            new_capacity = ARRAY_MIN_CAPACITY;
+        }
+    
+        if (!wickr_array_reserve(array, new_capacity)) {
+            return false;
+        }
+    }
+    
+    if (!__wickr_array_write_item(array, array->size, item, copy)) {
+        return false;
+    }
+    
+    array->size++;
+    
+    return true;
+}
+
+bool wickr_array_remove(wickr_array_t *array, uint32_t index, bool destroy_item)
+{
+    if (!__wickr_array_index_in_bounds(array, index)) {
+        return false;
+    }
+    
+    if (destroy_item) {
+        __wickr_array_destroy_item(array, index);
+    }
+    
+    size_t trailing_len = (size_t)(array->size - index - 1) * array->item_size;
+    memmove(__wickr_array_slot(array, index), __wickr_array_slot(array, index + 1), trailing_len);
+    
+    array->size--;
+    wickr_secure_zero(__wickr_array_slot(array, array->size), array->item_size);
+    
+    return true;
+}
+
+static void __wickr_array_merge(const wickr_array_t *array,
+                                uint8_t *scratch,
+                                uint32_t start,
+                                uint32_t middle,
+                                uint32_t end,
+                                wickr_array_compare_func compare)
+{
+    size_t item_size = array->item_size;
+    uint32_t left = start;
+    uint32_t right = middle;
+    uint8_t *out = scratch;
+    
+    while (left < middle && right < end) {
+        uint8_t *left_slot = __wickr_array_slot(array, left);
+        uint8_t *right_slot = __wickr_array_slot(array, right);
+    
+        /* Taking from the left on ties keeps the sort stable */
+        if (compare(__wickr_array_slot_item(array, right_slot), __wickr_array_slot_item(array, left_slot)) < 0) {
+            memcpy(out, right_slot, item_size);
+            right++;
+        }
+        else {
+            memcpy(out, left_slot, item_size);
+            left++;
+        }
+        out += item_size;
+    }
+    
+    if (left < middle) {
+        memcpy(out, __wickr_array_slot(array, left), (size_t)(middle - left) * item_size);
+        out += (size_t)(middle - left) * item_size;
+    }
+    
+    if (right < end) {
+        memcpy(out, __wickr_array_slot(array, right), (size_t)(end - right) * item_size);
+    }
+    
+    memcpy(__wickr_array_slot(array, start), scratch, (size_t)(end - start) * item_size);
+}
+
+bool wickr_array_sort(wickr_array_t *array, wickr_array_compare_func compare)
+{
+    if (!array || !compare) {
+        return false;
+    }
+    
+    if (array->size < 2) {
+        return true;
+    }
+    
+    wickr_buffer_t *scratch = wickr_buffer_create_empty((size_t)array->size * array->item_size);
+    
+    if (!scratch) {
+        return false;
+    }
+    
+    /* Bottom up merge sort, so sorting needs no recursion and keeps equal items in their original order */
+    for (uint64_t width = 1; width < array->size; width *= 2) {
+        for (uint64_t start = 0; start + width < array->size; start += 2 * width) {
+            uint64_t end = start + 2 * width < array->size ? start + 2 * width : array->size;
+            __wickr_array_merge(array, scratch->bytes, (uint32_t)start, (uint32_t)(start + width), (uint32_t)end, compare);
+        }
+    }
+    
+    if (array->is_inline) {
+        wickr_buffer_destroy_zero(&scratch);
+    }
+    else {
+        wickr_buffer_destroy(&scratch);
+    }
+    
+    return true;
+}
+
+bool wickr_array_search(const wickr_array_t *array, const void *key, wickr_array_compare_func compare, uint32_t *index_out)
+{
+    if (!array || !compare) {
+        return false;
+    }
+    
+    uint32_t low = 0;
+    uint32_t high = array->size;
+    
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        int result = compare(key, __wickr_array_pointer_to_index(array, middle));
+    
+        if (result == 0) {
+            if (index_out) {
+                *index_out = middle;
+            }
+            return true;
+        }
+    
+        if (result < 0) {
+            high = middle;
+        }
+        else {
+            low = middle + 1;
+        }
+    }
+    
+    return false;
 }
 
 wickr_array_t *wickr_array_copy(const wickr_array_t *array, bool deep_copy)
@@ -122,7 +413,12 @@ wickr_array_t *wickr_array_copy(const wickr_array_t *array, bool deep_copy)
         return NULL;
     }
     
-    wickr_array_t *copy_array = wickr_array_new(array->size, array->item_type, array->item_copy_func, array->item_destroy_func);
+    wickr_array_t *copy_array = __wickr_array_create(array->size, array->item_type, array->item_size, array->is_inline,
+                                                     array->item_copy_func, array->item_destroy_func);
+    
+    if (!copy_array) {
+        return NULL;
+    }
     
     for (unsigned int i = 0; i < array->size; i++) {
         void *one_item = __wickr_array_pointer_to_index(array, i);
@@ -144,16 +440,18 @@ void wickr_array_destroy(wickr_array_t **array, bool destroy_items)
     
     if (destroy_items) {
         for (unsigned int i = 0; i < (*array)->size; i++) {
-            void *one_item = __wickr_array_pointer_to_index(*array, i);
-            if (one_item) {
-                (*array)->item_destroy_func(&one_item);
-            }
-           
+            __wickr_array_destroy_item(*array, i);
         }
     }
     
-    wickr_buffer_destroy(&(*array)->item_store);
-    free(*array);
+    if ((*array)->is_inline) {
+        wickr_buffer_destroy_zero(&(*array)->item_store);
+    }
+    else {
+        wickr_buffer_destroy(&(*array)->item_store);
+    }
+    
+    wickr_free(*array);
     *array = NULL;
     
 }
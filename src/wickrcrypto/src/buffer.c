@@ -1,8 +1,272 @@
 
 #include "buffer.h"
 #include "memory.h"
+#include "secure_heap.h"
+#include "private/memory_priv.h"
+#include "private/threads_priv.h"
 #include <string.h>
 
+#ifdef _WIN32
+#include "Windows.h"
+#define WICKR_ATOMIC_INCREMENT(value) InterlockedIncrement(value)
+#define WICKR_ATOMIC_DECREMENT(value) InterlockedDecrement(value)
+#define WICKR_ATOMIC_LOAD(value) InterlockedCompareExchange(value, 0, 0)
+#else
+#define WICKR_ATOMIC_INCREMENT(value) __atomic_add_fetch(value, 1, __ATOMIC_RELAXED)
+#define WICKR_ATOMIC_DECREMENT(value) __atomic_sub_fetch(value, 1, __ATOMIC_ACQ_REL)
+#define WICKR_ATOMIC_LOAD(value) __atomic_load_n(value, __ATOMIC_ACQUIRE)
+#endif
+
+/*
+ Every buffer allocated by this file is directly followed by a tag recording which kind of buffer it is, so destroy and share
+ never have to infer it from where the bytes point. Callers are free to move 'bytes' or shorten 'length' of any buffer
+ */
+#define BUFFER_TAG_MAGIC 0x57425546
+
+typedef enum {
+    BUFFER_KIND_UNTAGGED,
+    BUFFER_KIND_OWNED,
+    BUFFER_KIND_SHARED,
+    BUFFER_KIND_CACHED
+} wickr_buffer_kind;
+
+typedef struct wickr_buffer_tag {
+    uint32_t magic;
+    uint32_t kind;
+} wickr_buffer_tag_t;
+
+/*
+ An owned buffer is a single allocation holding the buffer, its tag, the number of bytes allocated for it and then its bytes. The
+ capacity is kept because 'length' may have been shortened since, and destroy_zero must still zero every byte
+ */
+typedef struct wickr_buffer_owned {
+    wickr_buffer_t buffer;
+    wickr_buffer_tag_t tag;
+    size_t capacity;
+} wickr_buffer_owned_t;
+
+/* A shared buffer is a small handle whose bytes point into a separately allocated, reference counted storage block */
+typedef struct wickr_buffer_storage {
+    long ref_count;
+    long zero_on_release;
+    size_t length;
+} wickr_buffer_storage_t;
+
+typedef struct wickr_buffer_shared {
+    wickr_buffer_t buffer;
+    wickr_buffer_tag_t tag;
+    wickr_buffer_storage_t *storage;
+} wickr_buffer_shared_t;
+
+/*
+ A cached buffer keeps its size class between its tag and its bytes, so it is recycled into the right class even if its length
+ was changed after it was created
+ */
+typedef struct wickr_buffer_cached {
+    wickr_buffer_t buffer;
+    wickr_buffer_tag_t tag;
+    size_t size_class;
+    struct wickr_buffer_cached *next;
+} wickr_buffer_cached_t;
+
+static void __wickr_buffer_tag(wickr_buffer_tag_t *tag, wickr_buffer_kind kind)
+{
+    tag->magic = BUFFER_TAG_MAGIC;
+    tag->kind = kind;
+}
+
+/*
+ Only valid for buffers allocated by this file. A stack buffer or a view has no tag, and reading one would read past the end of
+ it, which is why the functions that call this document that they don't accept those
+ */
+static wickr_buffer_kind __wickr_buffer_get_kind(const wickr_buffer_t *buffer)
+{
+    const wickr_buffer_tag_t *tag = &((const wickr_buffer_owned_t *)buffer)->tag;
+    
+    if (tag->magic != BUFFER_TAG_MAGIC) {
+        return BUFFER_KIND_UNTAGGED;
+    }
+    
+    return (wickr_buffer_kind)tag->kind;
+}
+
+#ifndef WICKR_DISABLE_BUFFER_CACHE
+
+/* Sized for IVs and tags, keys, digests, and P-521 public keys and signatures */
+static const size_t __wickr_buffer_cache_class_sizes[] = { 16, 32, 64, 160 };
+
+#define BUFFER_CACHE_CLASS_COUNT (sizeof(__wickr_buffer_cache_class_sizes) / sizeof(size_t))
+#define BUFFER_CACHE_MAX_ENTRIES 32
+
+typedef struct wickr_buffer_cache {
+    wickr_buffer_cached_t *free_lists[BUFFER_CACHE_CLASS_COUNT];
+    uint32_t counts[BUFFER_CACHE_CLASS_COUNT];
+    wickr_buffer_cache_stats_t stats;
+    bool is_registered;
+} wickr_buffer_cache_t;
+
+static WICKR_THREAD_LOCAL wickr_buffer_cache_t __wickr_buffer_cache;
+
+/* The key exists only so that the cache of each thread is flushed when the thread exits */
+static wickr_thread_key_t __wickr_buffer_cache_key;
+static wickr_once_t __wickr_buffer_cache_once = WICKR_ONCE_INIT;
+static bool __wickr_buffer_cache_has_key = false;
+
+static void __wickr_buffer_cache_flush(wickr_buffer_cache_t *cache)
+{
+    for (size_t size_class = 0; size_class < BUFFER_CACHE_CLASS_COUNT; size_class++) {
+        wickr_buffer_cached_t *cached = cache->free_lists[size_class];
+        
+        while (cached) {
+            wickr_buffer_cached_t *next = cached->next;
+            free(cached);
+            cached = next;
+        }
+        
+        cache->free_lists[size_class] = NULL;
+        cache->counts[size_class] = 0;
+    }
+}
+
+static void WICKR_THREAD_KEY_CALLBACK __wickr_buffer_cache_thread_exit(void *cache)
+{
+    __wickr_buffer_cache_flush(cache);
+    ((wickr_buffer_cache_t *)cache)->is_registered = false;
+}
+
+static void __wickr_buffer_cache_key_init(void)
+{
+    __wickr_buffer_cache_has_key = wickr_thread_key_create(&__wickr_buffer_cache_key, __wickr_buffer_cache_thread_exit);
+}
+
+static bool __wickr_buffer_cache_register(wickr_buffer_cache_t *cache)
+{
+    wickr_once(&__wickr_buffer_cache_once, __wickr_buffer_cache_key_init);
+    
+    if (!__wickr_buffer_cache_has_key || !wickr_thread_key_set(__wickr_buffer_cache_key, cache)) {
+        return false;
+    }
+    
+    cache->is_registered = true;
+    
+    return true;
+}
+
+/*
+ Cached buffers come straight from the system so they can be freed on any thread at any time. Hooks set with wickr_set_allocator
+ and arena scopes expect to see every allocation, so the cache steps aside while either is in use
+ */
+static wickr_buffer_t *__wickr_buffer_cache_create(size_t len)
+{
+    if (len == 0 || !wickr_allocator_is_system() || wickr_arena_is_active()) {
+        return NULL;
+    }
+    
+    size_t size_class = 0;
+    
+    while (size_class < BUFFER_CACHE_CLASS_COUNT && len > __wickr_buffer_cache_class_sizes[size_class]) {
+        size_class++;
+    }
+    
+    if (size_class == BUFFER_CACHE_CLASS_COUNT) {
+        return NULL;
+    }
+    
+    wickr_buffer_cache_t *cache = &__wickr_buffer_cache;
+    wickr_buffer_cached_t *cached = cache->free_lists[size_class];
+    
+    /* Buffers in the cache were zeroed when they were returned, so they satisfy both create_empty and create_empty_zero */
+    if (cached) {
+        cache->free_lists[size_class] = cached->next;
+        cache->counts[size_class]--;
+        cache->stats.hits++;
+    }
+    else {
+        cached = calloc(1, sizeof(wickr_buffer_cached_t) + __wickr_buffer_cache_class_sizes[size_class]);
+        
+        if (!cached) {
+            return NULL;
+        }
+        
+        __wickr_buffer_tag(&cached->tag, BUFFER_KIND_CACHED);
+        cached->size_class = size_class;
+        cache->stats.misses++;
+    }
+    
+    cached->next = NULL;
+    cached->buffer.bytes = (uint8_t *)(cached + 1);
+    cached->buffer.length = len;
+    
+    return &cached->buffer;
+}
+
+static void __wickr_buffer_cache_release(wickr_buffer_t *buffer)
+{
+    wickr_buffer_cache_t *cache = &__wickr_buffer_cache;
+    wickr_buffer_cached_t *cached = (wickr_buffer_cached_t *)buffer;
+    size_t size_class = cached->size_class;
+    
+    wickr_secure_zero(cached + 1, __wickr_buffer_cache_class_sizes[size_class]);
+    
+    if (cache->counts[size_class] >= BUFFER_CACHE_MAX_ENTRIES ||
+        (!cache->is_registered && !__wickr_buffer_cache_register(cache))) {
+        cache->stats.evictions++;
+        free(cached);
+        return;
+    }
+    
+    cached->next = cache->free_lists[size_class];
+    cache->free_lists[size_class] = cached;
+    cache->counts[size_class]++;
+    cache->stats.recycled++;
+}
+
+bool wickr_buffer_cache_get_stats(wickr_buffer_cache_stats_t *stats_out)
+{
+    if (!stats_out) {
+        return false;
+    }
+    
+    *stats_out = __wickr_buffer_cache.stats;
+    
+    return true;
+}
+
+void wickr_buffer_cache_flush(void)
+{
+    __wickr_buffer_cache_flush(&__wickr_buffer_cache);
+}
+
+#else
+
+static wickr_buffer_t *__wickr_buffer_cache_create(size_t len)
+{
+    return NULL;
+}
+
+static void __wickr_buffer_cache_release(wickr_buffer_t *buffer)
+{
+    /* Cached buffers are never created when the cache is compiled out */
+    abort();
+}
+
+bool wickr_buffer_cache_get_stats(wickr_buffer_cache_stats_t *stats_out)
+{
+    if (!stats_out) {
+        return false;
+    }
+    
+    memset(stats_out, 0, sizeof(wickr_buffer_cache_stats_t));
+    
+    return true;
+}
+
+void wickr_buffer_cache_flush(void)
+{
+}
+
+#endif /* WICKR_DISABLE_BUFFER_CACHE */
+
 static bool __validate_buffer_range(const wickr_buffer_t *buffer, size_t start, size_t len)
 {
     if (!buffer) {
@@ -30,27 +294,39 @@ static wickr_buffer_t *__wickr_buffer_create_empty(size_t len, void *(*alloc_fun
         return NULL;
     }
     
-    uint8_t *bytes = alloc_func(len + sizeof(wickr_buffer_t));
+    wickr_buffer_owned_t *owned = alloc_func(len + sizeof(wickr_buffer_owned_t));
     
-    if (!bytes) {
+    if (!owned) {
         return NULL;
     }
     
-    wickr_buffer_t *new_buffer = (wickr_buffer_t *)bytes;
+    __wickr_buffer_tag(&owned->tag, BUFFER_KIND_OWNED);
+    owned->capacity = len;
+    owned->buffer.bytes = (uint8_t *)(owned + 1);
+    owned->buffer.length = len;
     
-    new_buffer->bytes = (uint8_t *)(new_buffer + 1);
-    new_buffer->length = len;
-    
-    return new_buffer;
+    return &owned->buffer;
 }
 
 wickr_buffer_t *wickr_buffer_create_empty(size_t len)
 {
+    wickr_buffer_t *cached_buffer = __wickr_buffer_cache_create(len);
+    
+    if (cached_buffer) {
+        return cached_buffer;
+    }
+    
     return __wickr_buffer_create_empty(len, wickr_alloc);
 }
 
 wickr_buffer_t *wickr_buffer_create_empty_zero(size_t len)
 {
+    wickr_buffer_t *cached_buffer = __wickr_buffer_cache_create(len);
+    
+    if (cached_buffer) {
+        return cached_buffer;
+    }
+    
     return __wickr_buffer_create_empty(len, wickr_alloc_zero);
 }
 
@@ -92,6 +368,197 @@ wickr_buffer_t *wickr_buffer_copy_section(const wickr_buffer_t *source, size_t s
     return wickr_buffer_create(source->bytes + start, len);
 }
 
+wickr_buffer_t *wickr_buffer_create_empty_secure(size_t len)
+{
+    return __wickr_buffer_create_empty(len, wickr_secure_alloc);
+}
+
+wickr_buffer_t *wickr_buffer_copy_secure(const wickr_buffer_t *source)
+{
+    if (!source) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *new_buffer = wickr_buffer_create_empty_secure(source->length);
+    
+    if (!new_buffer) {
+        return NULL;
+    }
+    
+    memcpy(new_buffer->bytes, source->bytes, source->length);
+    
+    return new_buffer;
+}
+
+wickr_buffer_t *wickr_buffer_copy_section_secure(const wickr_buffer_t *source, size_t start, size_t len)
+{
+    if (!__validate_buffer_range(source, start, len)) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *new_buffer = wickr_buffer_create_empty_secure(len);
+    
+    if (!new_buffer) {
+        return NULL;
+    }
+    
+    memcpy(new_buffer->bytes, source->bytes + start, len);
+    
+    return new_buffer;
+}
+
+static wickr_buffer_t *__wickr_buffer_shared_create(wickr_buffer_storage_t *storage, uint8_t *bytes, size_t len)
+{
+    wickr_buffer_shared_t *shared = wickr_alloc(sizeof(wickr_buffer_shared_t));
+    
+    if (!shared) {
+        return NULL;
+    }
+    
+    __wickr_buffer_tag(&shared->tag, BUFFER_KIND_SHARED);
+    shared->buffer.length = len;
+    shared->buffer.bytes = bytes;
+    shared->storage = storage;
+    
+    return &shared->buffer;
+}
+
+static void __wickr_buffer_storage_release(wickr_buffer_storage_t *storage)
+{
+    if (WICKR_ATOMIC_DECREMENT(&storage->ref_count) != 0) {
+        return;
+    }
+    
+    if (WICKR_ATOMIC_LOAD(&storage->zero_on_release)) {
+        wickr_free_zero(storage, sizeof(wickr_buffer_storage_t) + storage->length);
+    }
+    else {
+        wickr_free(storage);
+    }
+}
+
+wickr_buffer_t *wickr_buffer_create_empty_shared(size_t len)
+{
+    if (len > MAX_BUFFER_SIZE || len == 0) {
+        return NULL;
+    }
+    
+    wickr_buffer_storage_t *storage = wickr_alloc(sizeof(wickr_buffer_storage_t) + len);
+    
+    if (!storage) {
+        return NULL;
+    }
+    
+    storage->ref_count = 1;
+    storage->zero_on_release = 0;
+    storage->length = len;
+    
+    wickr_buffer_t *new_buffer = __wickr_buffer_shared_create(storage, (uint8_t *)(storage + 1), len);
+    
+    if (!new_buffer) {
+        wickr_free(storage);
+    }
+    
+    return new_buffer;
+}
+
+wickr_buffer_t *wickr_buffer_create_shared(const uint8_t *bytes, size_t len)
+{
+    if (!bytes) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *new_buffer = wickr_buffer_create_empty_shared(len);
+    
+    if (!new_buffer) {
+        return NULL;
+    }
+    
+    memcpy(new_buffer->bytes, bytes, len);
+    
+    return new_buffer;
+}
+
+wickr_buffer_t *wickr_buffer_share_section(const wickr_buffer_t *source, size_t start, size_t len)
+{
+    if (!__validate_buffer_range(source, start, len)) {
+        return NULL;
+    }
+    
+    if (__wickr_buffer_get_kind(source) != BUFFER_KIND_SHARED) {
+        return wickr_buffer_create_shared(source->bytes + start, len);
+    }
+    
+    wickr_buffer_storage_t *storage = ((const wickr_buffer_shared_t *)source)->storage;
+    
+    /* Storage allocated in an arena scope is released when the scope ends, so a reference that may outlive it gets a copy */
+    if (wickr_arena_owns(storage)) {
+        return wickr_buffer_create_shared(source->bytes + start, len);
+    }
+    
+    WICKR_ATOMIC_INCREMENT(&storage->ref_count);
+    
+    wickr_buffer_t *new_buffer = __wickr_buffer_shared_create(storage, source->bytes + start, len);
+    
+    if (!new_buffer) {
+        __wickr_buffer_storage_release(storage);
+    }
+    
+    return new_buffer;
+}
+
+wickr_buffer_t *wickr_buffer_share(const wickr_buffer_t *source)
+{
+    if (!source) {
+        return NULL;
+    }
+    
+    return wickr_buffer_share_section(source, 0, source->length);
+}
+
+bool wickr_buffer_is_shared(const wickr_buffer_t *buffer)
+{
+    if (!buffer || __wickr_buffer_get_kind(buffer) != BUFFER_KIND_SHARED) {
+        return false;
+    }
+    
+    return WICKR_ATOMIC_LOAD(&((const wickr_buffer_shared_t *)buffer)->storage->ref_count) > 1;
+}
+
+bool wickr_buffer_make_unique(wickr_buffer_t **buffer)
+{
+    if (!buffer || !*buffer) {
+        return false;
+    }
+    
+    if (!wickr_buffer_is_shared(*buffer)) {
+        return true;
+    }
+    
+    wickr_buffer_t *unique_buffer = wickr_buffer_copy(*buffer);
+    
+    if (!unique_buffer) {
+        return false;
+    }
+    
+    wickr_buffer_destroy(buffer);
+    *buffer = unique_buffer;
+    
+    return true;
+}
+
+bool wickr_buffer_view(const wickr_buffer_t *source, size_t start, size_t len, wickr_buffer_t *view_out)
+{
+    if (!view_out || !__validate_buffer_range(source, start, len)) {
+        return false;
+    }
+    
+    view_out->bytes = source->bytes + start;
+    view_out->length = len;
+    
+    return true;
+}
+
 wickr_buffer_t *wickr_buffer_concat(const wickr_buffer_t *buffer1, const wickr_buffer_t *buffer2)
 {
     if (!buffer1 || !buffer2) {
@@ -211,7 +678,28 @@ void wickr_buffer_destroy_zero(wickr_buffer_t **buffer)
         return;
     }
     
-    wickr_free_zero(*buffer, (*buffer)->length);
+    switch (__wickr_buffer_get_kind(*buffer)) {
+        case BUFFER_KIND_SHARED:
+        {
+            wickr_buffer_shared_t *shared = (wickr_buffer_shared_t *)*buffer;
+            WICKR_ATOMIC_INCREMENT(&shared->storage->zero_on_release);
+            __wickr_buffer_storage_release(shared->storage);
+            wickr_free(shared);
+            break;
+        }
+        case BUFFER_KIND_CACHED:
+            /* Cached buffers are always zeroed when they are released */
+            __wickr_buffer_cache_release(*buffer);
+            break;
+        case BUFFER_KIND_OWNED:
+            wickr_free_zero(*buffer, sizeof(wickr_buffer_owned_t) + ((wickr_buffer_owned_t *)*buffer)->capacity);
+            break;
+        default:
+            wickr_secure_zero((*buffer)->bytes, (*buffer)->length);
+            wickr_free(*buffer);
+            break;
+    }
+    
     *buffer = NULL;
 }
 
@@ -221,6 +709,21 @@ void wickr_buffer_destroy(wickr_buffer_t **buffer)
         return;
     }
     
-    wickr_free(*buffer);
+    switch (__wickr_buffer_get_kind(*buffer)) {
+        case BUFFER_KIND_SHARED:
+        {
+            wickr_buffer_shared_t *shared = (wickr_buffer_shared_t *)*buffer;
+            __wickr_buffer_storage_release(shared->storage);
+            wickr_free(shared);
+            break;
+        }
+        case BUFFER_KIND_CACHED:
+            __wickr_buffer_cache_release(*buffer);
+            break;
+        default:
+            wickr_free(*buffer);
+            break;
+    }
+    
     *buffer = NULL;
 }
@@ -8,6 +8,11 @@ wickr_buffer_t *wickr_buffer_from_protobytes(ProtobufCBinaryData buffer)
     return wickr_buffer_create(buffer.data, buffer.len);
 }
 
+wickr_buffer_t *wickr_buffer_shared_from_protobytes(ProtobufCBinaryData buffer)
+{
+    return wickr_buffer_create_shared(buffer.data, buffer.len);
+}
+
 bool wickr_buffer_to_protobytes(ProtobufCBinaryData *proto_bin, const wickr_buffer_t *buffer)
 {
     if (!proto_bin || !buffer) {
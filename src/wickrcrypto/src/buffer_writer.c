@@ -0,0 +1,235 @@
+
+#include "buffer_writer.h"
+#include "memory.h"
+#include <string.h>
+
+/* The smallest storage a growable writer allocates, so short sequences of small appends do not reallocate each time */
+#define BUFFER_WRITER_MIN_CAPACITY 64
+
+static void __wickr_buffer_writer_fail(wickr_buffer_writer_t *writer)
+{
+    wickr_buffer_writer_release(writer);
+    writer->has_failed = true;
+}
+
+static size_t __wickr_buffer_writer_capacity(const wickr_buffer_writer_t *writer)
+{
+    return writer->buffer ? writer->buffer->length : 0;
+}
+
+static bool __wickr_buffer_writer_grow(wickr_buffer_writer_t *writer, size_t required, bool is_exact)
+{
+    size_t new_capacity = required;
+    
+    /* Growth on append doubles the capacity, so a long run of appends copies each byte a constant number of times */
+    if (!is_exact) {
+        size_t capacity = __wickr_buffer_writer_capacity(writer);
+        new_capacity = capacity < BUFFER_WRITER_MIN_CAPACITY ? BUFFER_WRITER_MIN_CAPACITY : capacity;
+    
+        while (new_capacity < required && new_capacity <= MAX_BUFFER_SIZE / 2) {
+            new_capacity *= 2;
+        }
+    
+        if (new_capacity < required) {
+            new_capacity = required;
+        }
+    }
+    
+    wickr_buffer_t *new_buffer = wickr_buffer_create_empty(new_capacity);
+    
+    if (!new_buffer) {
+        return false;
+    }
+    
+    if (writer->buffer) {
+        memcpy(new_buffer->bytes, writer->buffer->bytes, writer->length);
+        wickr_secure_zero(writer->buffer->bytes, writer->length);
+        wickr_buffer_destroy(&writer->buffer);
+    }
+    
+    writer->buffer = new_buffer;
+    
+    return true;
+}
+
+bool wickr_buffer_writer_init(wickr_buffer_writer_t *writer, size_t capacity)
+{
+    if (!writer) {
+        return false;
+    }
+    
+    writer->buffer = NULL;
+    writer->length = 0;
+    writer->is_fixed = false;
+    writer->has_failed = false;
+    
+    if (capacity == 0) {
+        return true;
+    }
+    
+    return wickr_buffer_writer_reserve(writer, capacity);
+}
+
+void wickr_buffer_writer_init_fixed(wickr_buffer_writer_t *writer, wickr_buffer_t *destination)
+{
+    if (!writer) {
+        return;
+    }
+    
+    writer->buffer = destination;
+    writer->length = 0;
+    writer->is_fixed = true;
+    writer->has_failed = !destination;
+}
+
+static bool __wickr_buffer_writer_ensure(wickr_buffer_writer_t *writer, size_t len, bool is_exact)
+{
+    if (!writer || writer->has_failed) {
+        return false;
+    }
+    
+    if (len > MAX_BUFFER_SIZE - writer->length) {
+        __wickr_buffer_writer_fail(writer);
+        return false;
+    }
+    
+    size_t required = writer->length + len;
+    
+    if (required <= __wickr_buffer_writer_capacity(writer)) {
+        return true;
+    }
+    
+    if (writer->is_fixed || !__wickr_buffer_writer_grow(writer, required, is_exact)) {
+        __wickr_buffer_writer_fail(writer);
+        return false;
+    }
+    
+    return true;
+}
+
+bool wickr_buffer_writer_reserve(wickr_buffer_writer_t *writer, size_t len)
+{
+    return __wickr_buffer_writer_ensure(writer, len, true);
+}
+
+bool wickr_buffer_writer_append(wickr_buffer_writer_t *writer, const uint8_t *bytes, size_t len)
+{
+    if (!writer) {
+        return false;
+    }
+    
+    if (!bytes && len > 0) {
+        __wickr_buffer_writer_fail(writer);
+        return false;
+    }
+    
+    if (!__wickr_buffer_writer_ensure(writer, len, false)) {
+        return false;
+    }
+    
+    if (len > 0) {
+        memcpy(writer->buffer->bytes + writer->length, bytes, len);
+        writer->length += len;
+    }
+    
+    return true;
+}
+
+bool wickr_buffer_writer_append_buffer(wickr_buffer_writer_t *writer, const wickr_buffer_t *buffer)
+{
+    if (!buffer) {
+        if (writer) {
+            __wickr_buffer_writer_fail(writer);
+        }
+        return false;
+    }
+    
+    return wickr_buffer_writer_append(writer, buffer->bytes, buffer->length);
+}
+
+bool wickr_buffer_writer_append_u8(wickr_buffer_writer_t *writer, uint8_t value)
+{
+    return wickr_buffer_writer_append(writer, &value, sizeof(uint8_t));
+}
+
+bool wickr_buffer_writer_append_u64le(wickr_buffer_writer_t *writer, uint64_t value)
+{
+    uint8_t bytes[sizeof(uint64_t)];
+    
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+        bytes[i] = (uint8_t)(value >> (8 * i));
+    }
+    
+    return wickr_buffer_writer_append(writer, bytes, sizeof(bytes));
+}
+
+bool wickr_buffer_writer_append_varint(wickr_buffer_writer_t *writer, uint64_t value)
+{
+    uint8_t bytes[BUFFER_WRITER_VARINT_MAX_LEN];
+    size_t len = 0;
+    
+    while (value >= 0x80) {
+        bytes[len++] = (uint8_t)(value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    
+    bytes[len++] = (uint8_t)value;
+    
+    return wickr_buffer_writer_append(writer, bytes, len);
+}
+
+size_t wickr_buffer_writer_varint_size(uint64_t value)
+{
+    size_t len = 1;
+    
+    while (value >= 0x80) {
+        value >>= 7;
+        len++;
+    }
+    
+    return len;
+}
+
+wickr_buffer_t *wickr_buffer_writer_finish(wickr_buffer_writer_t *writer)
+{
+    if (!writer || writer->is_fixed) {
+        return NULL;
+    }
+    
+    if (writer->has_failed || writer->length == 0) {
+        wickr_buffer_writer_release(writer);
+        return NULL;
+    }
+    
+    /* Unused capacity stays at the end of the allocation, so the storage is handed over as is */
+    wickr_buffer_t *result = writer->buffer;
+    result->length = writer->length;
+    
+    writer->buffer = NULL;
+    writer->length = 0;
+    
+    return result;
+}
+
+size_t wickr_buffer_writer_finish_fixed(wickr_buffer_writer_t *writer)
+{
+    if (!writer || !writer->is_fixed || writer->has_failed) {
+        return 0;
+    }
+    
+    return writer->length;
+}
+
+void wickr_buffer_writer_release(wickr_buffer_writer_t *writer)
+{
+    if (!writer) {
+        return;
+    }
+    
+    if (!writer->is_fixed && writer->buffer) {
+        wickr_secure_zero(writer->buffer->bytes, writer->length);
+        wickr_buffer_destroy(&writer->buffer);
+    }
+    
+    writer->length = 0;
+}
@@ -1,5 +1,6 @@
 
 #include "cipher.h"
+#include "buffer_writer.h"
 #include "memory.h"
 
 const wickr_cipher_t *wickr_cipher_find(uint8_t cipher_id) {
@@ -90,45 +91,99 @@ bool wickr_cipher_result_is_valid(const wickr_cipher_result_t *result)
     return true;
 }
 
-wickr_buffer_t *wickr_cipher_result_serialize(const wickr_cipher_result_t *result)
+static size_t __wickr_cipher_result_serialized_size(const wickr_cipher_result_t *result, bool include_mode)
 {
     if (!result || !wickr_cipher_result_is_valid(result)) {
-        return NULL;
+        return 0;
     }
     
-    uint8_t mode_int = (uint8_t)result->cipher.cipher_id;
-    wickr_buffer_t mode_buffer = { sizeof(uint8_t), &mode_int };
+    const wickr_buffer_t *auth_tag = result->cipher.is_authenticated ? result->auth_tag : NULL;
+    
+    /* File headers are serialized without cipher text */
+    size_t total_len = (include_mode ? sizeof(uint8_t) : 0) + result->iv->length;
+    total_len += auth_tag ? auth_tag->length : 0;
+    total_len += result->cipher_text ? result->cipher_text->length : 0;
     
-    if (!result->cipher.is_authenticated) {
-        wickr_buffer_t *components[] = { &mode_buffer, result->iv, result->cipher_text };
-        return wickr_buffer_concat_multi(components, BUFFER_ARRAY_LEN(components));
+    return total_len;
+}
+
+static bool __wickr_cipher_result_write(const wickr_cipher_result_t *result, bool include_mode, wickr_buffer_writer_t *writer)
+{
+    if (!result || !writer || !wickr_cipher_result_is_valid(result)) {
+        return false;
     }
     
-    wickr_buffer_t *components[] = { &mode_buffer, result->iv, result->auth_tag, result->cipher_text };
-    return wickr_buffer_concat_multi(components, BUFFER_ARRAY_LEN(components));
+    const wickr_buffer_t *auth_tag = result->cipher.is_authenticated ? result->auth_tag : NULL;
+    
+    if (include_mode) {
+        wickr_buffer_writer_append_u8(writer, (uint8_t)result->cipher.cipher_id);
+    }
+    
+    wickr_buffer_writer_append_buffer(writer, result->iv);
+    
+    if (auth_tag) {
+        wickr_buffer_writer_append_buffer(writer, auth_tag);
+    }
+    
+    if (result->cipher_text) {
+        wickr_buffer_writer_append_buffer(writer, result->cipher_text);
+    }
+    
+    return !writer->has_failed;
 }
 
-wickr_cipher_result_t *wickr_cipher_result_from_buffer(const wickr_buffer_t *buffer)
+static wickr_buffer_t *__wickr_cipher_result_serialize(const wickr_cipher_result_t *result, bool include_mode)
 {
-    if (!buffer) {
+    size_t total_len = __wickr_cipher_result_serialized_size(result, include_mode);
+    
+    if (total_len == 0) {
         return NULL;
     }
     
-    const wickr_cipher_t *mode = wickr_cipher_find(buffer->bytes[0]);
+    wickr_buffer_writer_t writer;
+    wickr_buffer_writer_init(&writer, total_len);
     
-    if (!mode) {
+    if (!__wickr_cipher_result_write(result, include_mode, &writer)) {
+        wickr_buffer_writer_release(&writer);
         return NULL;
     }
     
-    size_t required_size = sizeof(uint8_t) + mode->iv_len + mode->auth_tag_len;
+    return wickr_buffer_writer_finish(&writer);
+}
+
+wickr_buffer_t *wickr_cipher_result_serialize(const wickr_cipher_result_t *result)
+{
+    return __wickr_cipher_result_serialize(result, true);
+}
+
+size_t wickr_cipher_result_serialized_size(const wickr_cipher_result_t *result)
+{
+    return __wickr_cipher_result_serialized_size(result, true);
+}
+
+bool wickr_cipher_result_serialize_into(const wickr_cipher_result_t *result, wickr_buffer_writer_t *writer)
+{
+    return __wickr_cipher_result_write(result, true, writer);
+}
+
+wickr_buffer_t *wickr_cipher_result_serialize_compact(const wickr_cipher_result_t *result)
+{
+    return __wickr_cipher_result_serialize(result, false);
+}
+
+static wickr_cipher_result_t *__wickr_cipher_result_from_buffer_at(const wickr_buffer_t *buffer,
+                                                                   const wickr_cipher_t *mode,
+                                                                   size_t start_pos)
+{
+    size_t required_size = start_pos + mode->iv_len + mode->auth_tag_len;
     
     if (buffer->length < required_size) {
         return NULL;
     }
     
-    size_t buffer_pos = sizeof(uint8_t);
+    size_t buffer_pos = start_pos;
     
-    wickr_buffer_t *iv = wickr_buffer_copy_section(buffer, sizeof(uint8_t), mode->iv_len);
+    wickr_buffer_t *iv = wickr_buffer_copy_section(buffer, start_pos, mode->iv_len);
     buffer_pos += mode->iv_len;
     
     if (!iv) {
@@ -138,7 +193,7 @@ wickr_cipher_result_t *wickr_cipher_result_from_buffer(const wickr_buffer_t *buf
     wickr_buffer_t *auth_tag = NULL;
     
     if (mode->is_authenticated) {
-        auth_tag = wickr_buffer_copy_section(buffer, sizeof(uint8_t) + mode->iv_len, mode->auth_tag_len);
+        auth_tag = wickr_buffer_copy_section(buffer, start_pos + mode->iv_len, mode->auth_tag_len);
         if (!auth_tag) {
             wickr_buffer_destroy(&iv);
             return NULL;
@@ -163,6 +218,37 @@ wickr_cipher_result_t *wickr_cipher_result_from_buffer(const wickr_buffer_t *buf
     return wickr_cipher_result_create(*mode, iv, cipher_text, auth_tag);
 }
 
+wickr_cipher_result_t *wickr_cipher_result_from_buffer(const wickr_buffer_t *buffer)
+{
+    if (!buffer) {
+        return NULL;
+    }
+    
+    const wickr_cipher_t *mode = wickr_cipher_find(buffer->bytes[0]);
+    
+    if (!mode) {
+        return NULL;
+    }
+    
+    return __wickr_cipher_result_from_buffer_at(buffer, mode, sizeof(uint8_t));
+}
+
+wickr_cipher_result_t *wickr_cipher_result_from_compact_buffer(const wickr_buffer_t *buffer, wickr_cipher_t cipher)
+{
+    if (!buffer) {
+        return NULL;
+    }
+    
+    /* Make sure the implied cipher is one we support */
+    const wickr_cipher_t *mode = wickr_cipher_find(cipher.cipher_id);
+    
+    if (!mode) {
+        return NULL;
+    }
+    
+    return __wickr_cipher_result_from_buffer_at(buffer, mode, 0);
+}
+
 wickr_cipher_key_t *wickr_cipher_key_create(wickr_cipher_t cipher, wickr_buffer_t *key_data)
 {
     if (!key_data || key_data->length != cipher.key_len) {
@@ -182,7 +268,7 @@ wickr_cipher_key_t *wickr_cipher_key_copy(const wickr_cipher_key_t *key)
         return NULL;
     }
     
-    wickr_buffer_t *key_data_copy = wickr_buffer_copy(key->key_data);
+    wickr_buffer_t *key_data_copy = wickr_buffer_copy_secure(key->key_data);
     
     if (!key_data_copy) {
         return NULL;
@@ -214,13 +300,24 @@ wickr_buffer_t *wickr_cipher_key_serialize(const wickr_cipher_key_t *key)
         return NULL;
     }
     
-    uint8_t wickr_cipher_id = (uint8_t)key->cipher.cipher_id;
+    /* The serialized key is key material, so it is built in the secure heap rather than with a growable writer */
+    wickr_buffer_t *serialized = wickr_buffer_create_empty_secure(sizeof(uint8_t) + key->key_data->length);
+    
+    if (!serialized) {
+        return NULL;
+    }
+    
+    wickr_buffer_writer_t writer;
+    wickr_buffer_writer_init_fixed(&writer, serialized);
+    wickr_buffer_writer_append_u8(&writer, (uint8_t)key->cipher.cipher_id);
+    wickr_buffer_writer_append_buffer(&writer, key->key_data);
     
-    wickr_buffer_t cipher_id_buffer;
-    cipher_id_buffer.length = sizeof(uint8_t);
-    cipher_id_buffer.bytes = &wickr_cipher_id;
+    if (wickr_buffer_writer_finish_fixed(&writer) != serialized->length) {
+        wickr_buffer_destroy_zero(&serialized);
+        return NULL;
+    }
     
-    return wickr_buffer_concat(&cipher_id_buffer, key->key_data);
+    return serialized;
 }
 
 wickr_cipher_key_t *wickr_cipher_key_from_buffer(const wickr_buffer_t *buffer)
@@ -235,7 +332,7 @@ wickr_cipher_key_t *wickr_cipher_key_from_buffer(const wickr_buffer_t *buffer)
         return NULL;
     }
     
-    wickr_buffer_t *key_buffer = wickr_buffer_copy_section(buffer, sizeof(uint8_t), cipher->key_len);
+    wickr_buffer_t *key_buffer = wickr_buffer_copy_section_secure(buffer, sizeof(uint8_t), cipher->key_len);
     
     if (!key_buffer) {
         return NULL;
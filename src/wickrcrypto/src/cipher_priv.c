@@ -1,6 +1,7 @@
 
 #include "private/cipher_priv.h"
 #include "private/buffer_priv.h"
+#include "memory.h"
 
 wickr_cipher_key_t *wickr_cipher_key_from_protobytes(ProtobufCBinaryData buffer)
 {
@@ -46,14 +47,33 @@ bool wickr_cipher_result_to_protobytes(ProtobufCBinaryData *proto_bin, const wic
         return false;
     }
     
-    wickr_buffer_t *serialized = wickr_cipher_result_serialize(cipher_result);
+    size_t serialized_len = wickr_cipher_result_serialized_size(cipher_result);
     
-    if (!serialized) {
+    if (serialized_len == 0) {
         return false;
     }
     
-    bool res = wickr_buffer_to_protobytes(proto_bin, serialized);
-    wickr_buffer_destroy_zero(&serialized);
+    wickr_buffer_t serialized = {
+        .bytes = wickr_alloc(serialized_len),
+        .length = serialized_len
+    };
     
-    return res;
+    if (!serialized.bytes) {
+        return false;
+    }
+    
+    /* The cipher result is written straight into the bytes field */
+    wickr_buffer_writer_t writer;
+    wickr_buffer_writer_init_fixed(&writer, &serialized);
+    wickr_cipher_result_serialize_into(cipher_result, &writer);
+    
+    if (wickr_buffer_writer_finish_fixed(&writer) != serialized_len) {
+        wickr_free_zero(serialized.bytes, serialized_len);
+        return false;
+    }
+    
+    proto_bin->data = serialized.bytes;
+    proto_bin->len = serialized_len;
+    
+    return true;
 }
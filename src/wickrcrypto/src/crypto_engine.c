@@ -35,7 +35,20 @@ const wickr_crypto_engine_t wickr_crypto_engine_get_default()
         openssl_hmac_create,
         openssl_hmac_verify,
         wickr_perform_kdf,
-        wickr_perform_kdf_meta
+        wickr_perform_kdf_meta,
+        openssl_sha2_ctx_create,
+        openssl_sha2_ctx_update,
+        openssl_sha2_ctx_final,
+        openssl_sha2_ctx_copy,
+        openssl_sha2_ctx_destroy,
+        openssl_aes256_stream_encrypt_init,
+        openssl_aes256_stream_decrypt_init,
+        openssl_aes256_stream_update,
+        openssl_aes256_stream_encrypt_final,
+        openssl_aes256_stream_decrypt_final,
+        openssl_aes256_stream_destroy,
+        openssl_aes256_file_encrypt_digest,
+        openssl_aes256_file_decrypt_digest
     };
     
     return default_engine;
@@ -51,7 +64,7 @@ static wickr_cipher_key_t *__wickr_cipher_key_from_kdf(wickr_kdf_result_t *kdf_r
         return NULL;
     }
     
-    wickr_buffer_t *key_buffer = wickr_buffer_copy(kdf_result->hash);
+    wickr_buffer_t *key_buffer = wickr_buffer_copy_secure(kdf_result->hash);
     
     if (!key_buffer) {
         return NULL;
@@ -73,7 +86,7 @@ wickr_buffer_t *wickr_crypto_engine_kdf_cipher(const wickr_crypto_engine_t *engi
     }
     
     /* Don't allow bcrypt, HKDF or unauthenticated ciphers for this operation, not supported */
-    if (algo.algo_id != KDF_SCRYPT || !cipher.is_authenticated || algo.output_size != cipher.key_len) {
+    if ((algo.algo_id != KDF_SCRYPT && algo.algo_id != KDF_ARGON2ID) || !cipher.is_authenticated || algo.output_size != cipher.key_len) {
         return NULL;
     }
     
@@ -143,8 +156,11 @@ wickr_buffer_t *wickr_crypto_engine_kdf_decipher(const wickr_crypto_engine_t *en
     }
     
     wickr_buffer_t cipher_text;
-    cipher_text.bytes = input_buffer->bytes + kdf_meta_size;
-    cipher_text.length = input_buffer->length - kdf_meta_size;
+    
+    if (!wickr_buffer_view(input_buffer, kdf_meta_size, input_buffer->length - kdf_meta_size, &cipher_text)) {
+        wickr_kdf_result_destroy(&kdf_result);
+        return NULL;
+    }
     
     wickr_cipher_result_t *cipher_result = wickr_cipher_result_from_buffer(&cipher_text);
     
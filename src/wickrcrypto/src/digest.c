@@ -10,6 +10,10 @@ const wickr_digest_t *wickr_digest_find_with_id(uint8_t digest_id)
             return &DIGEST_SHA_384;
         case DIGEST_ID_SHA512:
             return &DIGEST_SHA_512;
+        case DIGEST_ID_SHA256_TREE:
+            return &DIGEST_SHA_256_TREE;
+        case DIGEST_ID_SHA512_TREE:
+            return &DIGEST_SHA_512_TREE;
         default:
             return NULL;
     }
@@ -113,7 +113,7 @@ static wickr_cipher_key_t *__wickr_ecdh_cipher_ctx_gen_cipher_key(const wickr_ec
         return NULL;
     }
     
-    wickr_buffer_t *key_data = wickr_buffer_copy(kdf_result->hash);
+    wickr_buffer_t *key_data = wickr_buffer_copy_secure(kdf_result->hash);
     wickr_kdf_result_destroy(&kdf_result);
     wickr_buffer_destroy_zero(&shared_secret);
     
@@ -39,7 +39,7 @@ wickr_ecdsa_result_t *wickr_ecdsa_result_create_from_buffer(const wickr_buffer_t
     }
     
     size_t start_loc = ECDSA_HEADER_SIZE + padding_size;
-    wickr_buffer_t *key_data = wickr_buffer_copy_section(buffer, start_loc, buffer->length - start_loc);
+    wickr_buffer_t *key_data = wickr_buffer_create_shared(buffer->bytes + start_loc, buffer->length - start_loc);
     
     if (!key_data) {
         return NULL;
@@ -82,7 +82,7 @@ wickr_ecdsa_result_t *wickr_ecdsa_result_copy(const wickr_ecdsa_result_t *source
         return NULL;
     }
     
-    wickr_buffer_t *sig_data_copy = wickr_buffer_copy(source->sig_data);
+    wickr_buffer_t *sig_data_copy = wickr_buffer_share(source->sig_data);
     
     return wickr_ecdsa_result_create(source->curve, source->digest_mode, sig_data_copy);
 }
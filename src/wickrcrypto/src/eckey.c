@@ -23,7 +23,7 @@ wickr_ec_key_t *wickr_ec_key_copy(const wickr_ec_key_t *source)
         return NULL;
     }
     
-    wickr_buffer_t *pub_key_copy = wickr_buffer_copy(source->pub_data);
+    wickr_buffer_t *pub_key_copy = wickr_buffer_share(source->pub_data);
     
     if (!pub_key_copy) {
         return NULL;
@@ -32,7 +32,7 @@ wickr_ec_key_t *wickr_ec_key_copy(const wickr_ec_key_t *source)
     wickr_buffer_t *pri_key_copy = NULL;
     
     if (source->pri_data) {
-        pri_key_copy = wickr_buffer_copy(source->pri_data);
+        pri_key_copy = wickr_buffer_copy_secure(source->pri_data);
         
         if (!pri_key_copy) {
             wickr_buffer_destroy(&pub_key_copy);
@@ -2,6 +2,7 @@
 #include "ephemeral_keypair.h"
 #include "private/ephemeral_keypair_priv.h"
 #include "memory.h"
+#include "private/proto_arena_priv.h"
 
 wickr_ephemeral_keypair_t *wickr_ephemeral_keypair_create(uint64_t identifier, wickr_ec_key_t *ec_key, wickr_ecdsa_result_t *signature)
 {
@@ -135,14 +136,18 @@ wickr_ephemeral_keypair_t *wickr_ephemeral_keypair_create_from_buffer(const wick
         return NULL;
     }
     
-    Wickr__Proto__EphemeralKeypair *proto_keypair = wickr__proto__ephemeral_keypair__unpack(NULL, buffer->length, buffer->bytes);
+    wickr_proto_arena_t proto_arena;
+    wickr_proto_arena_init(&proto_arena);
+    
+    Wickr__Proto__EphemeralKeypair *proto_keypair = wickr__proto__ephemeral_keypair__unpack(&proto_arena.allocator, buffer->length, buffer->bytes);
     
     if (!proto_keypair) {
+        wickr_proto_arena_release(&proto_arena);
         return NULL;
     }
     
     wickr_ephemeral_keypair_t *return_keypair = wickr_ephemeral_keypair_create_from_proto(proto_keypair, engine);
-    wickr__proto__ephemeral_keypair__free_unpacked(proto_keypair, NULL);
+    wickr_proto_arena_release(&proto_arena);
     
     return return_keypair;
 }
@@ -2,6 +2,7 @@
 #include "identity.h"
 #include "private/identity_priv.h"
 #include "memory.h"
+#include "private/proto_arena_priv.h"
 
 wickr_identity_t *wickr_identity_create(wickr_identity_type type, wickr_buffer_t *identifier, wickr_ec_key_t *sig_key, wickr_ecdsa_result_t *signature)
 {
@@ -51,7 +52,7 @@ wickr_identity_t *wickr_node_identity_gen(const wickr_crypto_engine_t *engine, c
         return NULL;
     }
     
-    wickr_buffer_t *node_identifier = identifier ? wickr_buffer_copy(identifier) : engine->wickr_crypto_engine_crypto_random(IDENTIFIER_LEN);
+    wickr_buffer_t *node_identifier = identifier ? wickr_buffer_create_shared(identifier->bytes, identifier->length) : engine->wickr_crypto_engine_crypto_random(IDENTIFIER_LEN);
     
     if (!node_identifier) {
         wickr_ec_key_destroy(&node_sig_key);
@@ -76,7 +77,7 @@ wickr_identity_t *wickr_identity_copy(const wickr_identity_t *source)
         return NULL;
     }
     
-    wickr_buffer_t *identifier_copy = wickr_buffer_copy(source->identifier);
+    wickr_buffer_t *identifier_copy = wickr_buffer_share(source->identifier);
     
     if (!identifier_copy) {
         return NULL;
@@ -148,14 +149,18 @@ wickr_identity_t *wickr_identity_create_from_buffer(const wickr_buffer_t *buffer
         return NULL;
     }
     
-    Wickr__Proto__Identity *proto_identity = wickr__proto__identity__unpack(NULL, buffer->length, buffer->bytes);
+    wickr_proto_arena_t proto_arena;
+    wickr_proto_arena_init(&proto_arena);
+    
+    Wickr__Proto__Identity *proto_identity = wickr__proto__identity__unpack(&proto_arena.allocator, buffer->length, buffer->bytes);
     
     if (!proto_identity) {
+        wickr_proto_arena_release(&proto_arena);
         return NULL;
     }
     
     wickr_identity_t *return_identity = wickr_identity_create_from_proto(proto_identity, engine);
-    wickr__proto__identity__free_unpacked(proto_identity, NULL);
+    wickr_proto_arena_release(&proto_arena);
     
     return return_identity;
 }
@@ -338,14 +343,18 @@ wickr_identity_chain_t *wickr_identity_chain_create_from_buffer(const wickr_buff
         return NULL;
     }
     
-    Wickr__Proto__IdentityChain *proto_identity = wickr__proto__identity_chain__unpack(NULL, buffer->length, buffer->bytes);
+    wickr_proto_arena_t proto_arena;
+    wickr_proto_arena_init(&proto_arena);
+    
+    Wickr__Proto__IdentityChain *proto_identity = wickr__proto__identity_chain__unpack(&proto_arena.allocator, buffer->length, buffer->bytes);
     
     if (!proto_identity) {
+        wickr_proto_arena_release(&proto_arena);
         return NULL;
     }
     
     wickr_identity_chain_t *return_chain = wickr_identity_chain_create_from_proto(proto_identity, engine);
-    wickr__proto__identity_chain__free_unpacked(proto_identity, NULL);
+    wickr_proto_arena_release(&proto_arena);
     
     return return_chain;
 }
@@ -110,7 +110,7 @@ wickr_identity_t *wickr_identity_create_from_proto(const Wickr__Proto__Identity
         return NULL;
     }
     
-    wickr_buffer_t *id_buffer = wickr_buffer_from_protobytes(proto_identity->identifier);
+    wickr_buffer_t *id_buffer = wickr_buffer_shared_from_protobytes(proto_identity->identifier);
     
     if (!id_buffer) {
         return NULL;
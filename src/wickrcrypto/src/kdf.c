@@ -1,5 +1,7 @@
 
 #include "kdf.h"
+#include "private/kdf_priv.h"
+#include "private/threads_priv.h"
 #include "libscrypt.h"
 #include "crypt_blowfish.h"
 #include "memory.h"
@@ -25,6 +27,16 @@ static const wickr_kdf_algo_t *__find_dkf_algo_with_id(uint8_t algo_id)
             return &KDF_SCRYPT_2_19;
         case KDF_ID_SCRYPT_20:
             return &KDF_SCRYPT_2_20;
+        case KDF_ID_SCRYPT_17_P4:
+            return &KDF_SCRYPT_2_17_P4;
+        case KDF_ID_SCRYPT_18_P4:
+            return &KDF_SCRYPT_2_18_P4;
+        case KDF_ID_ARGON2ID_16:
+            return &KDF_ARGON2ID_2_16;
+        case KDF_ID_ARGON2ID_18:
+            return &KDF_ARGON2ID_2_18;
+        case KDF_ID_ARGON2ID_20:
+            return &KDF_ARGON2ID_2_20;
         default: return NULL;
     }
 }
@@ -315,12 +327,6 @@ static wickr_buffer_t *__scrypt_generate_hash(const wickr_kdf_meta_t *meta, cons
         return NULL;
     }
     
-    wickr_buffer_t *hash_buffer = wickr_buffer_create_empty(meta->algo.output_size);
-    
-    if (!hash_buffer) {
-        return NULL;
-    }
-    
     uint64_t N;
     uint8_t r,p;
     
@@ -329,6 +335,17 @@ static wickr_buffer_t *__scrypt_generate_hash(const wickr_kdf_meta_t *meta, cons
     N = meta->algo.cost >> 16;
     N = (uint64_t)1 << N;
     
+    /* Modes with more than one lane compute their lanes in parallel. Single lane modes stay on libscrypt */
+    if (p > 1) {
+        return wickr_scrypt_parallel(passphrase, meta->salt, N, r, p, 0, meta->algo.output_size);
+    }
+    
+    wickr_buffer_t *hash_buffer = wickr_buffer_create_empty(meta->algo.output_size);
+    
+    if (!hash_buffer) {
+        return NULL;
+    }
+    
     if (0 != libscrypt_scrypt(passphrase->bytes, passphrase->length, meta->salt->bytes, meta->salt->length, N, r, p, hash_buffer->bytes, hash_buffer->length)) {
         wickr_buffer_destroy(&hash_buffer);
         return NULL;
@@ -337,6 +354,27 @@ static wickr_buffer_t *__scrypt_generate_hash(const wickr_kdf_meta_t *meta, cons
     return hash_buffer;
 }
 
+static wickr_buffer_t *__argon2id_generate_hash(const wickr_kdf_meta_t *meta, const wickr_buffer_t *passphrase)
+{
+    if (!meta || meta->algo.algo_id != KDF_ARGON2ID) {
+        return NULL;
+    }
+    
+    uint32_t m_cost, t_cost, lanes;
+    
+    lanes = meta->algo.cost & 0xff;
+    t_cost = (meta->algo.cost >> 8) & 0xff;
+    m_cost = meta->algo.cost >> 16;
+    
+    if (m_cost >= 32) {
+        return NULL;
+    }
+    
+    m_cost = (uint32_t)1 << m_cost;
+    
+    return wickr_argon2id(passphrase, meta->salt, m_cost, t_cost, lanes, 0, meta->algo.output_size);
+}
+
 static wickr_buffer_t *__hkdf_generate_hash(const wickr_kdf_meta_t *meta, const wickr_buffer_t *passphrase)
 {
     if (!meta || meta->algo.algo_id != KDF_HMAC_SHA2) {
@@ -370,6 +408,7 @@ static wickr_buffer_t *__kdf_algo_generate_salt(wickr_kdf_algo_t algo)
 {
     switch (algo.algo_id) {
         case KDF_SCRYPT:
+        case KDF_ARGON2ID:
         case KDF_HMAC_SHA2:
             return __openssl_generate_salt(algo.salt_size);
         case KDF_BCRYPT:
@@ -390,6 +429,8 @@ static wickr_buffer_t *__kdf_algo_hash(const wickr_kdf_meta_t *meta, const wickr
             return __scrypt_generate_hash(meta, passphrase);
         case KDF_BCRYPT:
             return __bcrypt_generate_hash(meta, passphrase);
+        case KDF_ARGON2ID:
+            return __argon2id_generate_hash(meta, passphrase);
         case KDF_HMAC_SHA2:
             return __hkdf_generate_hash(meta, passphrase);
         default:
@@ -455,3 +496,75 @@ const wickr_kdf_algo_t *wickr_hkdf_algo_for_digest(wickr_digest_t digest)
             return NULL;
     }
 }
+
+/* Passphrase KDF modes considered by calibration, ordered by memory multiplied by the number of passes over it */
+static const wickr_kdf_algo_t *__kdf_calibration_modes[] = {
+    &KDF_ARGON2ID_2_16,
+    &KDF_SCRYPT_2_17,
+    &KDF_SCRYPT_2_18,
+    &KDF_ARGON2ID_2_18,
+    &KDF_SCRYPT_2_17_P4,
+    &KDF_SCRYPT_2_19,
+    &KDF_ARGON2ID_2_20,
+    &KDF_SCRYPT_2_18_P4,
+    &KDF_SCRYPT_2_20
+};
+
+static uint64_t __kdf_algo_memory_usage(const wickr_kdf_algo_t *algo)
+{
+    switch (algo->algo_id) {
+        case KDF_SCRYPT:
+        {
+            /* Each lane holds 128 * r * N bytes, and every lane may be running at once */
+            uint64_t p = algo->cost & 0xff;
+            uint64_t r = (algo->cost >> 8) & 0xff;
+            uint64_t N = (uint64_t)1 << (algo->cost >> 16);
+            return 128 * r * N * p;
+        }
+        case KDF_ARGON2ID:
+            return (uint64_t)1024 << (algo->cost >> 16);
+        default:
+            return 0;
+    }
+}
+
+const wickr_kdf_algo_t *wickr_kdf_calibrate(uint32_t target_ms, uint64_t max_memory)
+{
+    wickr_buffer_t *passphrase = __openssl_generate_salt(SCRYPT_SALT_SIZE);
+    
+    if (!passphrase) {
+        return NULL;
+    }
+    
+    const wickr_kdf_algo_t *strongest = NULL;
+    
+    for (size_t i = 0; i < sizeof(__kdf_calibration_modes) / sizeof(__kdf_calibration_modes[0]); i++) {
+        const wickr_kdf_algo_t *algo = __kdf_calibration_modes[i];
+        
+        if (__kdf_algo_memory_usage(algo) > max_memory) {
+            continue;
+        }
+        
+        uint64_t start = wickr_clock_monotonic_ns();
+        wickr_kdf_result_t *result = wickr_perform_kdf(*algo, passphrase);
+        uint64_t elapsed_ms = (wickr_clock_monotonic_ns() - start) / 1000000;
+        
+        if (!result) {
+            continue;
+        }
+        
+        wickr_kdf_result_destroy(&result);
+        
+        /*
+         Modes that run their lanes in parallel can finish sooner than weaker modes earlier in the list, so every mode is
+         measured rather than stopping at the first one over budget
+         */
+        if (elapsed_ms <= target_ms) {
+            strongest = algo;
+        }
+    }
+    
+    wickr_buffer_destroy_zero(&passphrase);
+    
+    return strongest;
+}
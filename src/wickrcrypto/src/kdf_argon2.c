@@ -0,0 +1,660 @@
+
+#include "private/kdf_priv.h"
+#include "memory.h"
+#include "private/threads_priv.h"
+
+#include <string.h>
+
+#define ARGON2_VERSION 0x13
+#define ARGON2_TYPE_ID 2
+
+#define ARGON2_BLOCK_SIZE 1024
+#define ARGON2_QWORDS_IN_BLOCK (ARGON2_BLOCK_SIZE / 8)
+#define ARGON2_ADDRESSES_IN_BLOCK 128
+#define ARGON2_SYNC_POINTS 4
+#define ARGON2_PREHASH_DIGEST_LENGTH 64
+#define ARGON2_PREHASH_SEED_LENGTH (ARGON2_PREHASH_DIGEST_LENGTH + 8)
+
+#define ARGON2_MIN_SALT_LENGTH 8
+#define ARGON2_MIN_OUTPUT_LENGTH 4
+#define ARGON2_MAX_LANES 0xFFFFFF
+
+#define BLAKE2B_BLOCK_BYTES 128
+#define BLAKE2B_OUT_BYTES 64
+
+#define ARGON2_ROTR64(w, c) (((w) >> (c)) | ((w) << (64 - (c))))
+
+static uint64_t __argon2_le64dec(const uint8_t *p)
+{
+    uint64_t w = 0;
+    
+    for (int i = 7; i >= 0; i--) {
+        w = (w << 8) | p[i];
+    }
+    
+    return w;
+}
+
+static void __argon2_le64enc(uint8_t *p, uint64_t w)
+{
+    for (int i = 0; i < 8; i++) {
+        p[i] = (uint8_t)(w >> (8 * i));
+    }
+}
+
+static void __argon2_le32enc(uint8_t *p, uint32_t w)
+{
+    p[0] = w & 0xff;
+    p[1] = (w >> 8) & 0xff;
+    p[2] = (w >> 16) & 0xff;
+    p[3] = (w >> 24) & 0xff;
+}
+
+/* BLAKE2b as defined in RFC 7693, unkeyed with a variable output length as required by Argon2 */
+
+static const uint64_t __blake2b_iv[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+static const uint8_t __blake2b_sigma[12][16] = {
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+    { 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+    {  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+    {  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+    {  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+    { 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+    { 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+    {  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+    { 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 },
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 }
+};
+
+typedef struct wickr_blake2b {
+    uint64_t h[8];
+    uint64_t t;
+    uint8_t buf[BLAKE2B_BLOCK_BYTES];
+    size_t buf_len;
+    size_t out_len;
+} wickr_blake2b_t;
+
+#define BLAKE2B_G(a, b, c, d, x, y)             \
+    do {                                        \
+        a = a + b + (x);                        \
+        d = ARGON2_ROTR64(d ^ a, 32);           \
+        c = c + d;                              \
+        b = ARGON2_ROTR64(b ^ c, 24);           \
+        a = a + b + (y);                        \
+        d = ARGON2_ROTR64(d ^ a, 16);           \
+        c = c + d;                              \
+        b = ARGON2_ROTR64(b ^ c, 63);           \
+    } while (0)
+
+static void __blake2b_compress(wickr_blake2b_t *ctx, const uint8_t *block, bool is_last)
+{
+    uint64_t m[16];
+    uint64_t v[16];
+    
+    for (int i = 0; i < 16; i++) {
+        m[i] = __argon2_le64dec(&block[i * 8]);
+    }
+    
+    for (int i = 0; i < 8; i++) {
+        v[i] = ctx->h[i];
+        v[i + 8] = __blake2b_iv[i];
+    }
+    
+    v[12] ^= ctx->t;
+    
+    if (is_last) {
+        v[14] = ~v[14];
+    }
+    
+    for (int r = 0; r < 12; r++) {
+        const uint8_t *s = __blake2b_sigma[r];
+        BLAKE2B_G(v[0], v[4], v[ 8], v[12], m[s[ 0]], m[s[ 1]]);
+        BLAKE2B_G(v[1], v[5], v[ 9], v[13], m[s[ 2]], m[s[ 3]]);
+        BLAKE2B_G(v[2], v[6], v[10], v[14], m[s[ 4]], m[s[ 5]]);
+        BLAKE2B_G(v[3], v[7], v[11], v[15], m[s[ 6]], m[s[ 7]]);
+        BLAKE2B_G(v[0], v[5], v[10], v[15], m[s[ 8]], m[s[ 9]]);
+        BLAKE2B_G(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+        BLAKE2B_G(v[2], v[7], v[ 8], v[13], m[s[12]], m[s[13]]);
+        BLAKE2B_G(v[3], v[4], v[ 9], v[14], m[s[14]], m[s[15]]);
+    }
+    
+    for (int i = 0; i < 8; i++) {
+        ctx->h[i] ^= v[i] ^ v[i + 8];
+    }
+}
+
+static void __blake2b_init(wickr_blake2b_t *ctx, size_t out_len)
+{
+    memcpy(ctx->h, __blake2b_iv, sizeof(ctx->h));
+    ctx->h[0] ^= 0x01010000 ^ (uint64_t)out_len;
+    ctx->t = 0;
+    ctx->buf_len = 0;
+    ctx->out_len = out_len;
+}
+
+static void __blake2b_update(wickr_blake2b_t *ctx, const uint8_t *in, size_t in_len)
+{
+    while (in_len > 0) {
+        /* The final block must be compressed with the last block flag, so a full buffer is only flushed once more input arrives */
+        if (ctx->buf_len == BLAKE2B_BLOCK_BYTES) {
+            ctx->t += BLAKE2B_BLOCK_BYTES;
+            __blake2b_compress(ctx, ctx->buf, false);
+            ctx->buf_len = 0;
+        }
+    
+        size_t n = BLAKE2B_BLOCK_BYTES - ctx->buf_len;
+    
+        if (n > in_len) {
+            n = in_len;
+        }
+    
+        memcpy(&ctx->buf[ctx->buf_len], in, n);
+        ctx->buf_len += n;
+        in += n;
+        in_len -= n;
+    }
+}
+
+static void __blake2b_final(wickr_blake2b_t *ctx, uint8_t *out)
+{
+    uint8_t digest[BLAKE2B_OUT_BYTES];
+    
+    ctx->t += ctx->buf_len;
+    memset(&ctx->buf[ctx->buf_len], 0, BLAKE2B_BLOCK_BYTES - ctx->buf_len);
+    __blake2b_compress(ctx, ctx->buf, true);
+    
+    for (int i = 0; i < 8; i++) {
+        __argon2_le64enc(&digest[i * 8], ctx->h[i]);
+    }
+    
+    memcpy(out, digest, ctx->out_len);
+    
+    wickr_secure_zero(digest, sizeof(digest));
+    wickr_secure_zero(ctx, sizeof(wickr_blake2b_t));
+}
+
+static void __blake2b_update_le32(wickr_blake2b_t *ctx, uint32_t value)
+{
+    uint8_t encoded[4];
+    __argon2_le32enc(encoded, value);
+    __blake2b_update(ctx, encoded, sizeof(encoded));
+}
+
+/* Variable length hash function H' from RFC 9106 section 3.3 */
+static void __argon2_hash_long(uint8_t *out, size_t out_len, const uint8_t *in, size_t in_len)
+{
+    wickr_blake2b_t ctx;
+    
+    if (out_len <= BLAKE2B_OUT_BYTES) {
+        __blake2b_init(&ctx, out_len);
+        __blake2b_update_le32(&ctx, (uint32_t)out_len);
+        __blake2b_update(&ctx, in, in_len);
+        __blake2b_final(&ctx, out);
+        return;
+    }
+    
+    uint8_t v[BLAKE2B_OUT_BYTES];
+    
+    __blake2b_init(&ctx, BLAKE2B_OUT_BYTES);
+    __blake2b_update_le32(&ctx, (uint32_t)out_len);
+    __blake2b_update(&ctx, in, in_len);
+    __blake2b_final(&ctx, v);
+    
+    /* Each intermediate digest contributes its first half to the output, and the last one is sized to fill what is left */
+    memcpy(out, v, BLAKE2B_OUT_BYTES / 2);
+    out += BLAKE2B_OUT_BYTES / 2;
+    size_t remaining = out_len - BLAKE2B_OUT_BYTES / 2;
+    
+    while (remaining > BLAKE2B_OUT_BYTES) {
+        __blake2b_init(&ctx, BLAKE2B_OUT_BYTES);
+        __blake2b_update(&ctx, v, BLAKE2B_OUT_BYTES);
+        __blake2b_final(&ctx, v);
+    
+        memcpy(out, v, BLAKE2B_OUT_BYTES / 2);
+        out += BLAKE2B_OUT_BYTES / 2;
+        remaining -= BLAKE2B_OUT_BYTES / 2;
+    }
+    
+    __blake2b_init(&ctx, remaining);
+    __blake2b_update(&ctx, v, BLAKE2B_OUT_BYTES);
+    __blake2b_final(&ctx, out);
+    
+    wickr_secure_zero(v, sizeof(v));
+}
+
+typedef struct wickr_argon2_block {
+    uint64_t v[ARGON2_QWORDS_IN_BLOCK];
+} wickr_argon2_block_t;
+
+/* The BLAKE2b round function with the addition replaced by the multiplication hardened BlaMka function */
+static uint64_t __argon2_blamka(uint64_t x, uint64_t y)
+{
+    return x + y + 2 * (uint64_t)(uint32_t)x * (uint32_t)y;
+}
+
+#define ARGON2_GB(a, b, c, d)                   \
+    do {                                        \
+        a = __argon2_blamka(a, b);              \
+        d = ARGON2_ROTR64(d ^ a, 32);           \
+        c = __argon2_blamka(c, d);              \
+        b = ARGON2_ROTR64(b ^ c, 24);           \
+        a = __argon2_blamka(a, b);              \
+        d = ARGON2_ROTR64(d ^ a, 16);           \
+        c = __argon2_blamka(c, d);              \
+        b = ARGON2_ROTR64(b ^ c, 63);           \
+    } while (0)
+
+#define ARGON2_ROUND(v0, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15) \
+    do {                                        \
+        ARGON2_GB(v0, v4, v8, v12);             \
+        ARGON2_GB(v1, v5, v9, v13);             \
+        ARGON2_GB(v2, v6, v10, v14);            \
+        ARGON2_GB(v3, v7, v11, v15);            \
+        ARGON2_GB(v0, v5, v10, v15);            \
+        ARGON2_GB(v1, v6, v11, v12);            \
+        ARGON2_GB(v2, v7, v8, v13);             \
+        ARGON2_GB(v3, v4, v9, v14);             \
+    } while (0)
+
+/* Compression function G, writing G(prev, ref) into 'next'. Passes after the first XOR the result into the existing block */
+static void __argon2_fill_block(const wickr_argon2_block_t *prev, const wickr_argon2_block_t *ref, wickr_argon2_block_t *next, bool with_xor)
+{
+    wickr_argon2_block_t R;
+    wickr_argon2_block_t T;
+    
+    for (int i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++) {
+        R.v[i] = prev->v[i] ^ ref->v[i];
+        T.v[i] = with_xor ? R.v[i] ^ next->v[i] : R.v[i];
+    }
+    
+    /* Rows of 16 words */
+    for (int i = 0; i < 8; i++) {
+        uint64_t *r = &R.v[16 * i];
+        ARGON2_ROUND(r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7],
+                     r[8], r[9], r[10], r[11], r[12], r[13], r[14], r[15]);
+    }
+    
+    /* Columns of 8 word pairs */
+    for (int i = 0; i < 8; i++) {
+        uint64_t *c = &R.v[2 * i];
+        ARGON2_ROUND(c[0], c[1], c[16], c[17], c[32], c[33], c[48], c[49],
+                     c[64], c[65], c[80], c[81], c[96], c[97], c[112], c[113]);
+    }
+    
+    for (int i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++) {
+        next->v[i] = T.v[i] ^ R.v[i];
+    }
+}
+
+typedef struct wickr_argon2_instance {
+    wickr_argon2_block_t *memory;
+    uint32_t passes;
+    uint32_t lanes;
+    uint32_t memory_blocks;
+    uint32_t segment_length;
+    uint32_t lane_length;
+} wickr_argon2_instance_t;
+
+static void __argon2_next_addresses(wickr_argon2_block_t *address_block, wickr_argon2_block_t *input_block)
+{
+    wickr_argon2_block_t zero_block;
+    memset(&zero_block, 0, sizeof(zero_block));
+    
+    input_block->v[6]++;
+    __argon2_fill_block(&zero_block, input_block, address_block, false);
+    __argon2_fill_block(&zero_block, address_block, address_block, false);
+}
+
+/* Map a pseudo random value onto the set of blocks that may be referenced from the current position (RFC 9106 section 3.4.2) */
+static uint32_t __argon2_index_alpha(const wickr_argon2_instance_t *instance, uint32_t pass, uint32_t slice, uint32_t index,
+                                     uint32_t pseudo_rand, bool same_lane)
+{
+    uint32_t reference_area_size;
+    
+    if (pass == 0) {
+        if (slice == 0) {
+            reference_area_size = index - 1;
+        }
+        else if (same_lane) {
+            reference_area_size = slice * instance->segment_length + index - 1;
+        }
+        else {
+            reference_area_size = slice * instance->segment_length + (index == 0 ? -1 : 0);
+        }
+    }
+    else {
+        if (same_lane) {
+            reference_area_size = instance->lane_length - instance->segment_length + index - 1;
+        }
+        else {
+            reference_area_size = instance->lane_length - instance->segment_length + (index == 0 ? -1 : 0);
+        }
+    }
+    
+    uint64_t relative_position = pseudo_rand;
+    relative_position = (relative_position * relative_position) >> 32;
+    relative_position = reference_area_size - 1 - ((reference_area_size * relative_position) >> 32);
+    
+    uint32_t start_position = 0;
+    
+    if (pass != 0 && slice != ARGON2_SYNC_POINTS - 1) {
+        start_position = (slice + 1) * instance->segment_length;
+    }
+    
+    return (uint32_t)((start_position + relative_position) % instance->lane_length);
+}
+
+static void __argon2_fill_segment(const wickr_argon2_instance_t *instance, uint32_t pass, uint32_t lane, uint32_t slice)
+{
+    /* Argon2id uses data independent addressing for the first half of the first pass, and data dependent addressing after that */
+    bool data_independent = pass == 0 && slice < ARGON2_SYNC_POINTS / 2;
+    
+    wickr_argon2_block_t address_block;
+    wickr_argon2_block_t input_block;
+    
+    if (data_independent) {
+        memset(&input_block, 0, sizeof(input_block));
+        input_block.v[0] = pass;
+        input_block.v[1] = lane;
+        input_block.v[2] = slice;
+        input_block.v[3] = instance->memory_blocks;
+        input_block.v[4] = instance->passes;
+        input_block.v[5] = ARGON2_TYPE_ID;
+    }
+    
+    uint32_t starting_index = 0;
+    
+    /* The first two blocks of each lane are filled from the pre-hash */
+    if (pass == 0 && slice == 0) {
+        starting_index = 2;
+    
+        if (data_independent) {
+            __argon2_next_addresses(&address_block, &input_block);
+        }
+    }
+    
+    uint32_t curr_offset = lane * instance->lane_length + slice * instance->segment_length + starting_index;
+    uint32_t prev_offset = curr_offset % instance->lane_length == 0 ? curr_offset + instance->lane_length - 1 : curr_offset - 1;
+    
+    for (uint32_t i = starting_index; i < instance->segment_length; i++, curr_offset++, prev_offset++) {
+        if (curr_offset % instance->lane_length == 1) {
+            prev_offset = curr_offset - 1;
+        }
+    
+        uint64_t pseudo_rand;
+    
+        if (data_independent) {
+            if (i % ARGON2_ADDRESSES_IN_BLOCK == 0) {
+                __argon2_next_addresses(&address_block, &input_block);
+            }
+            pseudo_rand = address_block.v[i % ARGON2_ADDRESSES_IN_BLOCK];
+        }
+        else {
+            pseudo_rand = instance->memory[prev_offset].v[0];
+        }
+    
+        uint32_t ref_lane = (uint32_t)((pseudo_rand >> 32) % instance->lanes);
+    
+        if (pass == 0 && slice == 0) {
+            ref_lane = lane;
+        }
+    
+        uint32_t ref_index = __argon2_index_alpha(instance, pass, slice, i, (uint32_t)pseudo_rand, ref_lane == lane);
+    
+        __argon2_fill_block(&instance->memory[prev_offset],
+                            &instance->memory[(size_t)instance->lane_length * ref_lane + ref_index],
+                            &instance->memory[curr_offset],
+                            pass != 0);
+    }
+}
+
+typedef struct wickr_argon2_job {
+    const wickr_argon2_instance_t *instance;
+    uint32_t pass;
+    uint32_t slice;
+    uint32_t first_lane;
+    uint32_t end_lane;
+} wickr_argon2_job_t;
+
+static void *__argon2_job_run(void *arg)
+{
+    wickr_argon2_job_t *job = arg;
+    
+    for (uint32_t lane = job->first_lane; lane < job->end_lane; lane++) {
+        __argon2_fill_segment(job->instance, job->pass, lane, job->slice);
+    }
+    
+    return NULL;
+}
+
+static uint32_t __argon2_thread_count(uint32_t lanes, uint32_t max_threads)
+{
+    uint32_t thread_count = max_threads;
+    
+    if (thread_count == 0) {
+        thread_count = wickr_thread_cpu_count();
+    }
+    
+    if (thread_count > ARGON2_PARALLEL_MAX_THREADS) {
+        thread_count = ARGON2_PARALLEL_MAX_THREADS;
+    }
+    
+    if (thread_count > lanes) {
+        thread_count = lanes;
+    }
+    
+    return thread_count;
+}
+
+static void __argon2_fill_memory(const wickr_argon2_instance_t *instance, uint32_t max_threads)
+{
+    uint32_t thread_count = __argon2_thread_count(instance->lanes, max_threads);
+    
+    wickr_argon2_job_t jobs[ARGON2_PARALLEL_MAX_THREADS];
+    wickr_thread_t threads[ARGON2_PARALLEL_MAX_THREADS];
+    bool is_started[ARGON2_PARALLEL_MAX_THREADS];
+    
+    uint32_t per_job = instance->lanes / thread_count;
+    uint32_t remainder = instance->lanes % thread_count;
+    uint32_t next_lane = 0;
+    
+    for (uint32_t i = 0; i < thread_count; i++) {
+        uint32_t lane_count = per_job + (i < remainder ? 1 : 0);
+    
+        jobs[i].instance = instance;
+        jobs[i].first_lane = next_lane;
+        jobs[i].end_lane = next_lane + lane_count;
+    
+        next_lane += lane_count;
+    }
+    
+    /*
+     Segments in the same slice only reference blocks of other lanes from earlier slices, so the lanes of a slice are filled
+     in parallel and every thread is joined before the next slice begins
+     */
+    for (uint32_t pass = 0; pass < instance->passes; pass++) {
+        for (uint32_t slice = 0; slice < ARGON2_SYNC_POINTS; slice++) {
+            for (uint32_t i = 0; i < thread_count; i++) {
+                jobs[i].pass = pass;
+                jobs[i].slice = slice;
+            }
+    
+            for (uint32_t i = 1; i < thread_count; i++) {
+                is_started[i] = wickr_thread_create(&threads[i], __argon2_job_run, &jobs[i]);
+            }
+    
+            __argon2_job_run(&jobs[0]);
+    
+            for (uint32_t i = 1; i < thread_count; i++) {
+                if (is_started[i]) {
+                    wickr_thread_join(threads[i]);
+                }
+                else {
+                    __argon2_job_run(&jobs[i]);
+                }
+            }
+        }
+    }
+}
+
+static void __argon2_initial_hash(uint8_t *out,
+                                  const wickr_buffer_t *passphrase,
+                                  const wickr_buffer_t *salt,
+                                  uint32_t m_cost,
+                                  uint32_t t_cost,
+                                  uint32_t lanes,
+                                  size_t output_len)
+{
+    wickr_blake2b_t ctx;
+    __blake2b_init(&ctx, ARGON2_PREHASH_DIGEST_LENGTH);
+    
+    __blake2b_update_le32(&ctx, lanes);
+    __blake2b_update_le32(&ctx, (uint32_t)output_len);
+    __blake2b_update_le32(&ctx, m_cost);
+    __blake2b_update_le32(&ctx, t_cost);
+    __blake2b_update_le32(&ctx, ARGON2_VERSION);
+    __blake2b_update_le32(&ctx, ARGON2_TYPE_ID);
+    
+    __blake2b_update_le32(&ctx, (uint32_t)passphrase->length);
+    __blake2b_update(&ctx, passphrase->bytes, passphrase->length);
+    
+    __blake2b_update_le32(&ctx, (uint32_t)salt->length);
+    __blake2b_update(&ctx, salt->bytes, salt->length);
+    
+    /* No secret key or associated data */
+    __blake2b_update_le32(&ctx, 0);
+    __blake2b_update_le32(&ctx, 0);
+    
+    __blake2b_final(&ctx, out);
+}
+
+static void __argon2_load_block(wickr_argon2_block_t *block, const uint8_t *bytes)
+{
+    for (int i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++) {
+        block->v[i] = __argon2_le64dec(&bytes[i * 8]);
+    }
+}
+
+static void __argon2_store_block(uint8_t *bytes, const wickr_argon2_block_t *block)
+{
+    for (int i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++) {
+        __argon2_le64enc(&bytes[i * 8], block->v[i]);
+    }
+}
+
+static bool __argon2_params_valid(const wickr_buffer_t *passphrase,
+                                  const wickr_buffer_t *salt,
+                                  uint32_t m_cost,
+                                  uint32_t t_cost,
+                                  uint32_t lanes,
+                                  size_t output_len)
+{
+    if (!passphrase || !salt) {
+        return false;
+    }
+    
+    if (lanes == 0 || lanes > ARGON2_MAX_LANES || t_cost == 0) {
+        return false;
+    }
+    
+    /* At least 8 blocks per lane are required so each segment holds at least 2 blocks */
+    if (m_cost < 8 * lanes) {
+        return false;
+    }
+    
+    if (salt->length < ARGON2_MIN_SALT_LENGTH || salt->length > UINT32_MAX || passphrase->length > UINT32_MAX) {
+        return false;
+    }
+    
+    if (output_len < ARGON2_MIN_OUTPUT_LENGTH || output_len > UINT32_MAX) {
+        return false;
+    }
+    
+#if SIZE_MAX <= UINT32_MAX
+    /* Only 32bit platforms can be asked for more memory than they can address */
+    if ((uint64_t)m_cost > SIZE_MAX / ARGON2_BLOCK_SIZE) {
+        return false;
+    }
+#endif
+    
+    return true;
+}
+
+wickr_buffer_t *wickr_argon2id(const wickr_buffer_t *passphrase,
+                               const wickr_buffer_t *salt,
+                               uint32_t m_cost,
+                               uint32_t t_cost,
+                               uint32_t lanes,
+                               uint32_t max_threads,
+                               size_t output_len)
+{
+    if (!__argon2_params_valid(passphrase, salt, m_cost, t_cost, lanes, output_len)) {
+        return NULL;
+    }
+    
+    wickr_argon2_instance_t instance;
+    instance.passes = t_cost;
+    instance.lanes = lanes;
+    instance.segment_length = m_cost / (lanes * ARGON2_SYNC_POINTS);
+    instance.lane_length = instance.segment_length * ARGON2_SYNC_POINTS;
+    instance.memory_blocks = instance.lane_length * lanes;
+    
+    size_t memory_len = (size_t)instance.memory_blocks * sizeof(wickr_argon2_block_t);
+    instance.memory = wickr_alloc(memory_len);
+    
+    if (!instance.memory) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *hash = wickr_buffer_create_empty(output_len);
+    
+    if (!hash) {
+        wickr_free(instance.memory);
+        return NULL;
+    }
+    
+    uint8_t seed[ARGON2_PREHASH_SEED_LENGTH];
+    uint8_t block_bytes[ARGON2_BLOCK_SIZE];
+    
+    __argon2_initial_hash(seed, passphrase, salt, m_cost, t_cost, lanes, output_len);
+    
+    for (uint32_t lane = 0; lane < lanes; lane++) {
+        __argon2_le32enc(&seed[ARGON2_PREHASH_DIGEST_LENGTH + 4], lane);
+    
+        for (uint32_t i = 0; i < 2; i++) {
+            __argon2_le32enc(&seed[ARGON2_PREHASH_DIGEST_LENGTH], i);
+            __argon2_hash_long(block_bytes, ARGON2_BLOCK_SIZE, seed, ARGON2_PREHASH_SEED_LENGTH);
+            __argon2_load_block(&instance.memory[(size_t)lane * instance.lane_length + i], block_bytes);
+        }
+    }
+    
+    __argon2_fill_memory(&instance, max_threads);
+    
+    /* The final block is the XOR of the last block of each lane */
+    wickr_argon2_block_t final_block = instance.memory[instance.lane_length - 1];
+    
+    for (uint32_t lane = 1; lane < lanes; lane++) {
+        const wickr_argon2_block_t *last = &instance.memory[(size_t)lane * instance.lane_length + instance.lane_length - 1];
+    
+        for (int i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++) {
+            final_block.v[i] ^= last->v[i];
+        }
+    }
+    
+    __argon2_store_block(block_bytes, &final_block);
+    __argon2_hash_long(hash->bytes, output_len, block_bytes, ARGON2_BLOCK_SIZE);
+    
+    /* The working memory is derived from the passphrase */
+    wickr_secure_zero(seed, sizeof(seed));
+    wickr_secure_zero(block_bytes, sizeof(block_bytes));
+    wickr_secure_zero(&final_block, sizeof(final_block));
+    wickr_free_zero(instance.memory, memory_len);
+    
+    return hash;
+}
@@ -0,0 +1,271 @@
+
+#include "private/kdf_priv.h"
+#include "openssl_suite.h"
+#include "memory.h"
+#include "private/threads_priv.h"
+
+#include <string.h>
+
+/* Each scrypt block is 128 * r bytes, or 32 * r 32bit words */
+#define SCRYPT_BLOCK_WORDS(r) ((size_t)32 * (r))
+#define SCRYPT_BLOCK_BYTES(r) ((size_t)128 * (r))
+
+#define SCRYPT_ROTL(a, b) (((a) << (b)) | ((a) >> (32 - (b))))
+
+static uint32_t __scrypt_le32dec(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void __scrypt_le32enc(uint8_t *p, uint32_t x)
+{
+    p[0] = x & 0xff;
+    p[1] = (x >> 8) & 0xff;
+    p[2] = (x >> 16) & 0xff;
+    p[3] = (x >> 24) & 0xff;
+}
+
+/* Salsa20/8 core as defined in RFC 7914 section 3 */
+static void __scrypt_salsa20_8(uint32_t B[16])
+{
+    uint32_t x[16];
+    memcpy(x, B, sizeof(x));
+    
+    for (int i = 0; i < 8; i += 2) {
+        /* Operate on columns */
+        x[ 4] ^= SCRYPT_ROTL(x[ 0] + x[12],  7);  x[ 8] ^= SCRYPT_ROTL(x[ 4] + x[ 0],  9);
+        x[12] ^= SCRYPT_ROTL(x[ 8] + x[ 4], 13);  x[ 0] ^= SCRYPT_ROTL(x[12] + x[ 8], 18);
+        x[ 9] ^= SCRYPT_ROTL(x[ 5] + x[ 1],  7);  x[13] ^= SCRYPT_ROTL(x[ 9] + x[ 5],  9);
+        x[ 1] ^= SCRYPT_ROTL(x[13] + x[ 9], 13);  x[ 5] ^= SCRYPT_ROTL(x[ 1] + x[13], 18);
+        x[14] ^= SCRYPT_ROTL(x[10] + x[ 6],  7);  x[ 2] ^= SCRYPT_ROTL(x[14] + x[10],  9);
+        x[ 6] ^= SCRYPT_ROTL(x[ 2] + x[14], 13);  x[10] ^= SCRYPT_ROTL(x[ 6] + x[ 2], 18);
+        x[ 3] ^= SCRYPT_ROTL(x[15] + x[11],  7);  x[ 7] ^= SCRYPT_ROTL(x[ 3] + x[15],  9);
+        x[11] ^= SCRYPT_ROTL(x[ 7] + x[ 3], 13);  x[15] ^= SCRYPT_ROTL(x[11] + x[ 7], 18);
+    
+        /* Operate on rows */
+        x[ 1] ^= SCRYPT_ROTL(x[ 0] + x[ 3],  7);  x[ 2] ^= SCRYPT_ROTL(x[ 1] + x[ 0],  9);
+        x[ 3] ^= SCRYPT_ROTL(x[ 2] + x[ 1], 13);  x[ 0] ^= SCRYPT_ROTL(x[ 3] + x[ 2], 18);
+        x[ 6] ^= SCRYPT_ROTL(x[ 5] + x[ 4],  7);  x[ 7] ^= SCRYPT_ROTL(x[ 6] + x[ 5],  9);
+        x[ 4] ^= SCRYPT_ROTL(x[ 7] + x[ 6], 13);  x[ 5] ^= SCRYPT_ROTL(x[ 4] + x[ 7], 18);
+        x[11] ^= SCRYPT_ROTL(x[10] + x[ 9],  7);  x[ 8] ^= SCRYPT_ROTL(x[11] + x[10],  9);
+        x[ 9] ^= SCRYPT_ROTL(x[ 8] + x[11], 13);  x[10] ^= SCRYPT_ROTL(x[ 9] + x[ 8], 18);
+        x[12] ^= SCRYPT_ROTL(x[15] + x[14],  7);  x[13] ^= SCRYPT_ROTL(x[12] + x[15],  9);
+        x[14] ^= SCRYPT_ROTL(x[13] + x[12], 13);  x[15] ^= SCRYPT_ROTL(x[14] + x[13], 18);
+    }
+    
+    for (int i = 0; i < 16; i++) {
+        B[i] += x[i];
+    }
+}
+
+/* scryptBlockMix, writing the shuffled output of 'B' into 'Y' */
+static void __scrypt_blockmix(const uint32_t *B, uint32_t *Y, uint32_t r)
+{
+    uint32_t X[16];
+    memcpy(X, &B[(2 * r - 1) * 16], sizeof(X));
+    
+    for (size_t i = 0; i < 2 * r; i++) {
+        for (int k = 0; k < 16; k++) {
+            X[k] ^= B[i * 16 + k];
+        }
+    
+        __scrypt_salsa20_8(X);
+    
+        /* Even blocks form the first half of the output and odd blocks the second half */
+        memcpy(&Y[((i & 1) * r + i / 2) * 16], X, sizeof(X));
+    }
+}
+
+static uint64_t __scrypt_integerify(const uint32_t *B, uint32_t r)
+{
+    const uint32_t *X = &B[(2 * r - 1) * 16];
+    return ((uint64_t)X[1] << 32) | X[0];
+}
+
+static void __scrypt_block_xor(uint32_t *dst, const uint32_t *src, size_t words)
+{
+    for (size_t i = 0; i < words; i++) {
+        dst[i] ^= src[i];
+    }
+}
+
+/* scryptROMix on a single lane 'B' in place. 'V' holds N blocks and 'XY' holds 2 blocks of scratch space */
+static void __scrypt_romix(uint8_t *B, uint32_t r, uint64_t N, uint32_t *V, uint32_t *XY)
+{
+    size_t words = SCRYPT_BLOCK_WORDS(r);
+    uint32_t *X = XY;
+    uint32_t *Y = XY + words;
+    
+    for (size_t k = 0; k < words; k++) {
+        X[k] = __scrypt_le32dec(&B[k * 4]);
+    }
+    
+    /* N is a power of 2 greater than 1, so both loops can alternate between X and Y without copying */
+    for (uint64_t i = 0; i < N; i += 2) {
+        memcpy(&V[i * words], X, SCRYPT_BLOCK_BYTES(r));
+        __scrypt_blockmix(X, Y, r);
+        memcpy(&V[(i + 1) * words], Y, SCRYPT_BLOCK_BYTES(r));
+        __scrypt_blockmix(Y, X, r);
+    }
+    
+    for (uint64_t i = 0; i < N; i += 2) {
+        uint64_t j = __scrypt_integerify(X, r) & (N - 1);
+        __scrypt_block_xor(X, &V[j * words], words);
+        __scrypt_blockmix(X, Y, r);
+    
+        j = __scrypt_integerify(Y, r) & (N - 1);
+        __scrypt_block_xor(Y, &V[j * words], words);
+        __scrypt_blockmix(Y, X, r);
+    }
+    
+    for (size_t k = 0; k < words; k++) {
+        __scrypt_le32enc(&B[k * 4], X[k]);
+    }
+}
+
+typedef struct wickr_scrypt_job {
+    uint8_t *B;
+    uint32_t r;
+    uint64_t N;
+    uint32_t first_lane;
+    uint32_t end_lane;
+    bool success;
+} wickr_scrypt_job_t;
+
+static void *__scrypt_job_run(void *arg)
+{
+    wickr_scrypt_job_t *job = arg;
+    
+    size_t v_len = SCRYPT_BLOCK_BYTES(job->r) * (size_t)job->N;
+    size_t xy_len = SCRYPT_BLOCK_BYTES(job->r) * 2;
+    
+    uint32_t *V = wickr_alloc(v_len);
+    uint32_t *XY = wickr_alloc(xy_len);
+    
+    if (!V || !XY) {
+        wickr_free(V);
+        wickr_free(XY);
+        job->success = false;
+        return NULL;
+    }
+    
+    for (uint32_t lane = job->first_lane; lane < job->end_lane; lane++) {
+        __scrypt_romix(&job->B[lane * SCRYPT_BLOCK_BYTES(job->r)], job->r, job->N, V, XY);
+    }
+    
+    /* The working memory is derived from the passphrase */
+    wickr_free_zero(V, v_len);
+    wickr_free_zero(XY, xy_len);
+    
+    job->success = true;
+    
+    return NULL;
+}
+
+static uint32_t __scrypt_thread_count(uint32_t p, uint32_t max_threads)
+{
+    uint32_t thread_count = max_threads;
+    
+    if (thread_count == 0) {
+        thread_count = wickr_thread_cpu_count();
+    }
+    
+    if (thread_count > SCRYPT_PARALLEL_MAX_THREADS) {
+        thread_count = SCRYPT_PARALLEL_MAX_THREADS;
+    }
+    
+    if (thread_count > p) {
+        thread_count = p;
+    }
+    
+    return thread_count;
+}
+
+static bool __scrypt_params_valid(uint64_t N, uint32_t r, uint32_t p, size_t output_len)
+{
+    /* N must be a power of 2 greater than 1 */
+    if (N < 2 || (N & (N - 1)) != 0) {
+        return false;
+    }
+    
+    if (r == 0 || p == 0 || output_len == 0) {
+        return false;
+    }
+    
+    /* Limits from RFC 7914, and the memory for a lane must be addressable */
+    if ((uint64_t)r * p >= (1 << 30)) {
+        return false;
+    }
+    
+    if (N > SIZE_MAX / SCRYPT_BLOCK_BYTES(r) || r > SIZE_MAX / 128 / p) {
+        return false;
+    }
+    
+    return true;
+}
+
+wickr_buffer_t *wickr_scrypt_parallel(const wickr_buffer_t *passphrase,
+                                      const wickr_buffer_t *salt,
+                                      uint64_t N,
+                                      uint32_t r,
+                                      uint32_t p,
+                                      uint32_t max_threads,
+                                      size_t output_len)
+{
+    if (!passphrase || !salt || !__scrypt_params_valid(N, r, p, output_len)) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *B = openssl_pbkdf2(passphrase, salt, 1, DIGEST_SHA_256, SCRYPT_BLOCK_BYTES(r) * p);
+    
+    if (!B) {
+        return NULL;
+    }
+    
+    uint32_t thread_count = __scrypt_thread_count(p, max_threads);
+    
+    wickr_scrypt_job_t jobs[SCRYPT_PARALLEL_MAX_THREADS];
+    wickr_thread_t threads[SCRYPT_PARALLEL_MAX_THREADS];
+    bool is_started[SCRYPT_PARALLEL_MAX_THREADS];
+    
+    uint32_t per_job = p / thread_count;
+    uint32_t remainder = p % thread_count;
+    uint32_t next_lane = 0;
+    
+    for (uint32_t i = 0; i < thread_count; i++) {
+        uint32_t lane_count = per_job + (i < remainder ? 1 : 0);
+    
+        jobs[i].B = B->bytes;
+        jobs[i].r = r;
+        jobs[i].N = N;
+        jobs[i].first_lane = next_lane;
+        jobs[i].end_lane = next_lane + lane_count;
+        jobs[i].success = false;
+    
+        next_lane += lane_count;
+    }
+    
+    /* Lanes are independent until the final PBKDF2, so each run of lanes is mixed on its own thread */
+    for (uint32_t i = 1; i < thread_count; i++) {
+        is_started[i] = wickr_thread_create(&threads[i], __scrypt_job_run, &jobs[i]);
+    }
+    
+    __scrypt_job_run(&jobs[0]);
+    
+    bool success = jobs[0].success;
+    
+    for (uint32_t i = 1; i < thread_count; i++) {
+        if (is_started[i]) {
+            wickr_thread_join(threads[i]);
+        }
+        else {
+            __scrypt_job_run(&jobs[i]);
+        }
+        success = success && jobs[i].success;
+    }
+    
+    wickr_buffer_t *hash = success ? openssl_pbkdf2(passphrase, B, 1, DIGEST_SHA_256, output_len) : NULL;
+    wickr_buffer_destroy_zero(&B);
+    
+    return hash;
+}
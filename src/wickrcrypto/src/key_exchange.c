@@ -1,9 +1,11 @@
 
 #include "key_exchange.h"
 #include "memory.h"
+#include "private/proto_arena_priv.h"
 #include "key_exchange.pb-c.h"
 #include "private/buffer_priv.h"
 #include "private/eckey_priv.h"
+#include "private/cipher_priv.h"
 
 #define EXCHANGE_ARRAY_TYPE_ID 2
 
@@ -89,21 +91,11 @@ static Wickr__Proto__KeyExchangeSet__Exchange *__wickr_key_exchange_to_proto(con
     wickr__proto__key_exchange_set__exchange__init(proto_exchange);
     proto_exchange->key_id = exchange->key_id;
     
-    wickr_buffer_t *exchange_data = wickr_cipher_result_serialize(exchange->exchange_ciphertext);
-    
-    if (!exchange_data) {
-        wickr_free(proto_exchange);
-        return NULL;
-    }
-    
-    if (!wickr_buffer_to_protobytes(&proto_exchange->exchange_data, exchange_data)) {
+    if (!wickr_cipher_result_to_protobytes(&proto_exchange->exchange_data, exchange->exchange_ciphertext)) {
         wickr_free(proto_exchange);
-        wickr_buffer_destroy(&exchange_data);
         return NULL;
     }
     
-    wickr_buffer_destroy(&exchange_data);
-    
     proto_exchange->identifier.data = exchange->exchange_id->bytes;
     proto_exchange->identifier.len = exchange->exchange_id->length;
     
@@ -116,9 +108,7 @@ static wickr_key_exchange_t *__wickr_key_exchange_create_with_proto(const Wickr_
         return NULL;
     }
     
-    wickr_buffer_t *exchange_bytes = wickr_buffer_from_protobytes(exchange_proto->exchange_data);
-    wickr_cipher_result_t *cipher_result = wickr_cipher_result_from_buffer(exchange_bytes);
-    wickr_buffer_destroy(&exchange_bytes);
+    wickr_cipher_result_t *cipher_result = wickr_cipher_result_from_protobytes(exchange_proto->exchange_data);
     
     if (!cipher_result) {
         return NULL;
@@ -156,6 +146,11 @@ bool wickr_exchange_array_set_item(wickr_exchange_array_t *array,
     return wickr_array_set_item(array, index, exchange, false);
 }
 
+bool wickr_exchange_array_push(wickr_exchange_array_t *array, wickr_key_exchange_t *exchange)
+{
+    return wickr_array_push(array, exchange, false);
+}
+
 wickr_key_exchange_t *wickr_exchange_array_fetch_item(wickr_exchange_array_t *array, uint32_t index)
 {
     return wickr_array_fetch_item(array, index, false);
@@ -409,16 +404,20 @@ wickr_key_exchange_set_t *wickr_key_exchange_set_create_from_buffer(const wickr_
         return NULL;
     }
     
-    Wickr__Proto__KeyExchangeSet *proto_exchange_set = wickr__proto__key_exchange_set__unpack(NULL,
+    wickr_proto_arena_t proto_arena;
+    wickr_proto_arena_init(&proto_arena);
+    
+    Wickr__Proto__KeyExchangeSet *proto_exchange_set = wickr__proto__key_exchange_set__unpack(&proto_arena.allocator,
                                                                                               buffer->length,
                                                                                               buffer->bytes);
     
     if (!proto_exchange_set) {
+        wickr_proto_arena_release(&proto_arena);
         return NULL;
     }
     
     wickr_key_exchange_set_t *exchange_set = __wickr_key_exchange_set_create_with_proto(proto_exchange_set, engine);
-    wickr__proto__key_exchange_set__free_unpacked(proto_exchange_set, NULL);
+    wickr_proto_arena_release(&proto_arena);
     
     return exchange_set;
 }
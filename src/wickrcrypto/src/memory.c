@@ -1,5 +1,7 @@
 
 #include "memory.h"
+#include "private/memory_priv.h"
+#include "private/threads_priv.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -7,12 +9,65 @@
 #include "Windows.h"
 #endif
 
+static void *__wickr_system_alloc(size_t len, void *user)
+{
+    return malloc(len);
+}
+
+static void *__wickr_system_alloc_zero(size_t len, void *user)
+{
+    return calloc(1, len);
+}
+
+static void __wickr_system_free(void *buf, void *user)
+{
+    free(buf);
+}
+
+static const wickr_allocator_t __wickr_system_allocator = {
+    __wickr_system_alloc,
+    __wickr_system_alloc_zero,
+    __wickr_system_free,
+    NULL
+};
+
+static wickr_allocator_t __wickr_allocator = {
+    __wickr_system_alloc,
+    __wickr_system_alloc_zero,
+    __wickr_system_free,
+    NULL
+};
+
+static WICKR_THREAD_LOCAL uint32_t __wickr_memory_tag = WICKR_MEMORY_TAG_DEFAULT;
+
+static void *__wickr_allocator_alloc_zero(const wickr_allocator_t *allocator, size_t len)
+{
+    if (allocator->alloc_zero) {
+        return allocator->alloc_zero(len, allocator->user);
+    }
+    
+    void *buf = allocator->alloc(len, allocator->user);
+    
+    if (buf) {
+        memset(buf, 0, len);
+    }
+    
+    return buf;
+}
+
 void *wickr_alloc(size_t len)
 {
     if (len == 0) {
         return NULL;
     }
-    return malloc(len);
+    
+    void *buf = wickr_arena_alloc_active(len, false);
+    
+    if (buf) {
+        return buf;
+    }
+    
+    return __wickr_allocator.alloc(len, __wickr_allocator.user);
 }
 
 void *wickr_alloc_zero(size_t len)
@@ -20,7 +75,14 @@ void *wickr_alloc_zero(size_t len)
     if (len == 0) {
         return NULL;
     }
-    return calloc(1, len);
+    
+    void *buf = wickr_arena_alloc_active(len, true);
+    
+    if (buf) {
+        return buf;
+    }
+    
+    return __wickr_allocator_alloc_zero(&__wickr_allocator, len);
 }
 
 void wickr_free(void *buf)
@@ -28,10 +90,29 @@ void wickr_free(void *buf)
     if (!buf) {
         return;
     }
-    free(buf);
+    
+    /* Both ownership checks return straight away while no secure heap has been reserved and no arena scope is open */
+    if (wickr_secure_heap_owns(buf)) {
+        wickr_secure_heap_free(buf);
+        return;
+    }
+    
+    /* Arena memory is released all at once when its scope ends */
+    if (wickr_arena_owns(buf)) {
+        return;
+    }
+    
+    __wickr_allocator.free(buf, __wickr_allocator.user);
 }
 
-void wickr_free_zero(void *buf, size_t len)
+/* explicit_bzero is declared by glibc 2.25+ in its default feature set, and by the BSDs */
+#if defined(__GLIBC__) && defined(__USE_MISC) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 25))
+#define WICKR_HAVE_EXPLICIT_BZERO 1
+#elif defined(__OpenBSD__) || defined(__FreeBSD__)
+#define WICKR_HAVE_EXPLICIT_BZERO 1
+#endif
+
+void wickr_secure_zero(void *buf, size_t len)
 {
     if (!buf || len == 0) {
         return;
@@ -41,15 +122,264 @@ void wickr_free_zero(void *buf, size_t len)
     if (memset_s(buf, (rsize_t)len, 0, (rsize_t)len) != 0) {
         abort();
     }
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 202311L
+    memset_explicit(buf, 0, len);
 #elif _WIN32
     SecureZeroMemory(buf, len);
+#elif defined(WICKR_HAVE_EXPLICIT_BZERO)
+    explicit_bzero(buf, len);
+#elif defined(__GNUC__)
+    /* memset runs at full vector width. The barrier tells the compiler 'buf' may still be read, so the store can not be dropped */
+    memset(buf, 0, len);
+    __asm__ __volatile__("" : : "r"(buf) : "memory");
 #else
-    volatile unsigned char *volatile volatile_buf = (volatile unsigned char * volatile) buf;
+    /* Clear a word at a time, with single bytes only for the unaligned head and tail */
+    volatile uint8_t *volatile volatile_bytes = (volatile uint8_t *volatile)buf;
     size_t i = 0;
     
+    while (i < len && ((uintptr_t)(buf) + i) % sizeof(uintptr_t) != 0) {
+        volatile_bytes[i++] = 0;
+    }
+    
+    volatile uintptr_t *volatile volatile_words = (volatile uintptr_t *volatile)((uint8_t *)buf + i);
+    size_t word_count = (len - i) / sizeof(uintptr_t);
+    
+    for (size_t w = 0; w < word_count; w++) {
+        volatile_words[w] = 0;
+    }
+    
+    i += word_count * sizeof(uintptr_t);
+    
     while (i < len) {
-        volatile_buf[i++] = 0;
+        volatile_bytes[i++] = 0;
     }
 #endif
+}
+
+void wickr_free_zero(void *buf, size_t len)
+{
+    if (!buf || len == 0) {
+        return;
+    }
+    
+    /* Secure heap chunks are zeroed in full when they are released */
+    if (wickr_secure_heap_owns(buf)) {
+        wickr_secure_heap_free(buf);
+        return;
+    }
+    
+    wickr_secure_zero(buf, len);
     wickr_free(buf);
 }
+
+bool wickr_set_allocator(const wickr_allocator_t *allocator)
+{
+    if (!allocator) {
+        __wickr_allocator = __wickr_system_allocator;
+        return true;
+    }
+    
+    if (!allocator->alloc || !allocator->free) {
+        return false;
+    }
+    
+    __wickr_allocator = *allocator;
+    
+    return true;
+}
+
+wickr_allocator_t wickr_get_allocator(void)
+{
+    return __wickr_allocator;
+}
+
+bool wickr_allocator_is_system(void)
+{
+    return __wickr_allocator.alloc == __wickr_system_alloc && __wickr_allocator.free == __wickr_system_free;
+}
+
+uint32_t wickr_memory_tag_set(uint32_t tag)
+{
+    uint32_t previous = __wickr_memory_tag;
+    __wickr_memory_tag = tag;
+    
+    return previous;
+}
+
+uint32_t wickr_memory_tag_get(void)
+{
+    return __wickr_memory_tag;
+}
+
+/* Every instrumented allocation is prefixed with its size and tag. 16 bytes keeps the returned memory aligned like malloc */
+#define INSTRUMENTED_HEADER_SIZE 16
+
+typedef struct wickr_instrumented_header {
+    size_t len;
+    uint32_t tag;
+} wickr_instrumented_header_t;
+
+struct wickr_instrumented_allocator {
+    wickr_allocator_t backing;
+    wickr_mutex_t lock;
+    wickr_memory_stats_t stats[WICKR_MEMORY_TAG_COUNT];
+};
+
+static void __wickr_instrumented_record_alloc(wickr_instrumented_allocator_t *allocator, uint32_t tag, size_t len)
+{
+    wickr_mutex_lock(&allocator->lock);
+    
+    wickr_memory_stats_t *stats = &allocator->stats[tag];
+    stats->live_bytes += len;
+    stats->live_allocations++;
+    stats->total_allocations++;
+    
+    if (stats->live_bytes > stats->peak_bytes) {
+        stats->peak_bytes = stats->live_bytes;
+    }
+    
+    if (stats->live_allocations > stats->peak_allocations) {
+        stats->peak_allocations = stats->live_allocations;
+    }
+    
+    wickr_mutex_unlock(&allocator->lock);
+}
+
+static void *__wickr_instrumented_finish_alloc(wickr_instrumented_allocator_t *allocator, uint8_t *base, size_t len)
+{
+    if (!base) {
+        return NULL;
+    }
+    
+    uint32_t tag = __wickr_memory_tag < WICKR_MEMORY_TAG_COUNT ? __wickr_memory_tag : WICKR_MEMORY_TAG_DEFAULT;
+    
+    wickr_instrumented_header_t header;
+    header.len = len;
+    header.tag = tag;
+    memcpy(base, &header, sizeof(header));
+    
+    __wickr_instrumented_record_alloc(allocator, tag, len);
+    
+    return base + INSTRUMENTED_HEADER_SIZE;
+}
+
+static void *__wickr_instrumented_alloc(size_t len, void *user)
+{
+    wickr_instrumented_allocator_t *allocator = user;
+    
+    if (len > SIZE_MAX - INSTRUMENTED_HEADER_SIZE) {
+        return NULL;
+    }
+    
+    uint8_t *base = allocator->backing.alloc(len + INSTRUMENTED_HEADER_SIZE, allocator->backing.user);
+    
+    return __wickr_instrumented_finish_alloc(allocator, base, len);
+}
+
+static void *__wickr_instrumented_alloc_zero(size_t len, void *user)
+{
+    wickr_instrumented_allocator_t *allocator = user;
+    
+    if (len > SIZE_MAX - INSTRUMENTED_HEADER_SIZE) {
+        return NULL;
+    }
+    
+    uint8_t *base = __wickr_allocator_alloc_zero(&allocator->backing, len + INSTRUMENTED_HEADER_SIZE);
+    
+    return __wickr_instrumented_finish_alloc(allocator, base, len);
+}
+
+static void __wickr_instrumented_free(void *buf, void *user)
+{
+    wickr_instrumented_allocator_t *allocator = user;
+    uint8_t *base = (uint8_t *)buf - INSTRUMENTED_HEADER_SIZE;
+    
+    wickr_instrumented_header_t header;
+    memcpy(&header, base, sizeof(header));
+    
+    wickr_mutex_lock(&allocator->lock);
+    allocator->stats[header.tag].live_bytes -= header.len;
+    allocator->stats[header.tag].live_allocations--;
+    wickr_mutex_unlock(&allocator->lock);
+    
+    allocator->backing.free(base, allocator->backing.user);
+}
+
+wickr_instrumented_allocator_t *wickr_instrumented_allocator_create(const wickr_allocator_t *backing)
+{
+    if (!backing) {
+        backing = &__wickr_system_allocator;
+    }
+    
+    if (!backing->alloc || !backing->free) {
+        return NULL;
+    }
+    
+    wickr_instrumented_allocator_t *allocator = __wickr_allocator_alloc_zero(backing, sizeof(wickr_instrumented_allocator_t));
+    
+    if (!allocator) {
+        return NULL;
+    }
+    
+    if (!wickr_mutex_init(&allocator->lock)) {
+        backing->free(allocator, backing->user);
+        return NULL;
+    }
+    
+    allocator->backing = *backing;
+    
+    return allocator;
+}
+
+wickr_allocator_t wickr_instrumented_allocator_get_hooks(wickr_instrumented_allocator_t *allocator)
+{
+    wickr_allocator_t hooks;
+    hooks.alloc = __wickr_instrumented_alloc;
+    hooks.alloc_zero = __wickr_instrumented_alloc_zero;
+    hooks.free = __wickr_instrumented_free;
+    hooks.user = allocator;
+    
+    return hooks;
+}
+
+bool wickr_instrumented_allocator_get_stats(wickr_instrumented_allocator_t *allocator, uint32_t tag, wickr_memory_stats_t *stats_out)
+{
+    if (!allocator || !stats_out || tag >= WICKR_MEMORY_TAG_COUNT) {
+        return false;
+    }
+    
+    wickr_mutex_lock(&allocator->lock);
+    *stats_out = allocator->stats[tag];
+    wickr_mutex_unlock(&allocator->lock);
+    
+    return true;
+}
+
+void wickr_instrumented_allocator_reset_peaks(wickr_instrumented_allocator_t *allocator)
+{
+    if (!allocator) {
+        return;
+    }
+    
+    wickr_mutex_lock(&allocator->lock);
+    
+    for (uint32_t i = 0; i < WICKR_MEMORY_TAG_COUNT; i++) {
+        allocator->stats[i].peak_bytes = allocator->stats[i].live_bytes;
+        allocator->stats[i].peak_allocations = allocator->stats[i].live_allocations;
+    }
+    
+    wickr_mutex_unlock(&allocator->lock);
+}
+
+void wickr_instrumented_allocator_destroy(wickr_instrumented_allocator_t **allocator)
+{
+    if (!allocator || !*allocator) {
+        return;
+    }
+    
+    wickr_allocator_t backing = (*allocator)->backing;
+    
+    wickr_mutex_destroy(&(*allocator)->lock);
+    backing.free(*allocator, backing.user);
+    *allocator = NULL;
+}
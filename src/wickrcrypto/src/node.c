@@ -3,6 +3,7 @@
 #include "private/node_priv.h"
 #include "private/identity_priv.h"
 #include "memory.h"
+#include "private/proto_arena_priv.h"
 
 #define NODE_ARRAY_TYPE_ID 1
 
@@ -82,7 +83,7 @@ wickr_node_t *wickr_node_copy(const wickr_node_t *source)
         return NULL;
     }
     
-    wickr_buffer_t *dev_id_copy = wickr_buffer_copy(source->dev_id);
+    wickr_buffer_t *dev_id_copy = wickr_buffer_share(source->dev_id);
     
     if (!dev_id_copy) {
         return NULL;
@@ -153,6 +154,11 @@ bool wickr_node_array_set_item(wickr_array_t *array, uint32_t index, wickr_node_
     return wickr_array_set_item(array, index, node, false);
 }
 
+bool wickr_node_array_push(wickr_node_array_t *array, wickr_node_t *node)
+{
+    return wickr_array_push(array, node, false);
+}
+
 wickr_node_t *wickr_node_array_fetch_item(const wickr_array_t *array, uint32_t index)
 {
     return wickr_array_fetch_item(array, index, false);
@@ -205,14 +211,18 @@ wickr_node_t *wickr_node_create_from_buffer(const wickr_buffer_t *buffer, const
         return NULL;
     }
     
-    Wickr__Proto__Node *proto_node = wickr__proto__node__unpack(NULL, buffer->length, buffer->bytes);
+    wickr_proto_arena_t proto_arena;
+    wickr_proto_arena_init(&proto_arena);
+    
+    Wickr__Proto__Node *proto_node = wickr__proto__node__unpack(&proto_arena.allocator, buffer->length, buffer->bytes);
     
     if (!proto_node) {
+        wickr_proto_arena_release(&proto_arena);
         return NULL;
     }
     
     wickr_node_t *return_node = wickr_node_create_from_proto(proto_node, engine);
-    wickr__proto__node__free_unpacked(proto_node, NULL);
+    wickr_proto_arena_release(&proto_arena);
     
     return return_node;
 }
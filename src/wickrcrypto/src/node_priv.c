@@ -65,7 +65,7 @@ wickr_node_t *wickr_node_create_from_proto(const Wickr__Proto__Node *proto, cons
         return NULL;
     }
     
-    wickr_buffer_t *dev_id = wickr_buffer_from_protobytes(proto->devid);
+    wickr_buffer_t *dev_id = wickr_buffer_shared_from_protobytes(proto->devid);
     
     if (!dev_id) {
         return NULL;
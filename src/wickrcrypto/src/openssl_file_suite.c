@@ -1,10 +1,13 @@
 #ifdef _WIN32
 #define _CRT_SECURE_NO_DEPRECATE
+#else
+#define _FILE_OFFSET_BITS 64
 #endif
 
 #include "openssl_suite.h"
 #include "openssl_file_suite.h"
 #include "memory.h"
+#include "private/threads_priv.h"
 
 #include <openssl/rand.h>
 #include <openssl/evp.h>
@@ -21,6 +24,26 @@
 #else
 #endif
 
+#if !defined(_WIN32)
+#define OPENSSL_FILE_MMAP_SUPPORTED 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#else
+#define OPENSSL_FILE_MMAP_SUPPORTED 0
+#endif
+
+/* The largest header of the non segmented format, cipher id | iv | auth tag */
+#define AES_FILE_HEADER_MAX_LEN 64
+
+/* The number of bytes passed to the cipher at a time from memory maps when digests are also calculated, so the digests read cached data */
+#define AES_FILE_DIGEST_CHUNK_SIZE (256 * 1024)
+
+#define OPENSSL_TREE_LEAF_PREFIX 0x00
+#define OPENSSL_TREE_NODE_PREFIX 0x01
+
 typedef struct AESFileOperation {
     char *tempPath;
     FILE *sourceHandle;
@@ -189,47 +212,2325 @@ static void freeFileOperation(AESFileOperation **operation) {
     }
 }
 
-bool openssl_aes256_file_encrypt(const wickr_cipher_key_t *key, const char *sourceFilePath, const char *destinationFilePath)
-{    
-    if (!key || !sourceFilePath || !destinationFilePath) {
+static const EVP_CIPHER *aesFileCipherMode(wickr_cipher_t cipher)
+{
+    switch (cipher.cipher_id) {
+        case CIPHER_ID_AES256_GCM:
+            return EVP_aes_256_gcm();
+        case CIPHER_ID_AES256_CTR:
+            return EVP_aes_256_ctr();
+        default:
+            return NULL;
+    }
+}
+
+#pragma mark - File Operation Digests
+
+static const EVP_MD *openssl_tree_node_digest(wickr_digest_t mode);
+static FILE *openssl_file_open(const char *path, const char *mode);
+static wickr_buffer_t *openssl_tree_reduce(const EVP_MD *md, uint8_t *nodes, uint64_t node_count);
+
+/*
+ An incremental digest of the data passing through a file operation. Tree digests are built a leaf at a time. A tree digest can
+ also defer its first 'deferredLength' bytes until it is finalized, which allows the header of an encrypted file to be hashed
+ after the auth tag is known. The body of the first leaf is held in memory until then
+ */
+typedef struct AESFileDigest {
+    wickr_digest_t mode;
+    const EVP_MD *md;
+    EVP_MD_CTX *ctx;
+    size_t deferredLength;
+    uint8_t *firstLeaf;
+    size_t firstLeafLength;
+    uint64_t position;
+    bool isLeafOpen;
+    uint8_t *leaves;
+    size_t leavesLength;
+    size_t leavesCapacity;
+} AESFileDigest;
+
+/*
+ The digests requested for a file operation. The header of an encrypted file is saved so it can be hashed at the end by a tree
+ digest. Other digests of an encrypted file can't defer the header, so they are calculated by reading the file back instead
+ */
+typedef struct AESFileDigests {
+    AESFileDigest *plain;
+    AESFileDigest *cipher;
+    AESFileDigest *readBack;
+    uint8_t header[AES_FILE_HEADER_MAX_LEN];
+    size_t headerLength;
+} AESFileDigests;
+
+static const EVP_MD *aesFileDigestMode(wickr_digest_t mode)
+{
+    if (mode.type == DIGEST_SHA2_TREE) {
+        return openssl_tree_node_digest(mode);
+    }
+    
+    switch (mode.digest_id) {
+        case DIGEST_ID_SHA256:
+            return EVP_sha256();
+        case DIGEST_ID_SHA384:
+            return EVP_sha384();
+        case DIGEST_ID_SHA512:
+            return EVP_sha512();
+        default:
+            return NULL;
+    }
+}
+
+static void aesFileDigestFree(AESFileDigest *digest)
+{
+    if (digest->ctx) {
+        EVP_MD_CTX_destroy(digest->ctx);
+    }
+    if (digest->firstLeaf) {
+        wickr_free(digest->firstLeaf);
+    }
+    if (digest->leaves) {
+        wickr_free(digest->leaves);
+    }
+    memset(digest, 0, sizeof(AESFileDigest));
+}
+
+/* Only tree digests can defer the start of their input */
+static bool aesFileDigestInit(AESFileDigest *digest, wickr_digest_t mode, size_t deferredLength)
+{
+    memset(digest, 0, sizeof(AESFileDigest));
+    
+    digest->mode = mode;
+    digest->md = aesFileDigestMode(mode);
+    
+    if (!digest->md || deferredLength >= DIGEST_TREE_LEAF_SIZE || (deferredLength > 0 && mode.type != DIGEST_SHA2_TREE)) {
         return false;
     }
     
-    AESFileOperation *fileOp = createFileOperation(sourceFilePath, destinationFilePath);
+    digest->deferredLength = deferredLength;
+    digest->position = deferredLength;
+    digest->ctx = EVP_MD_CTX_create();
     
-    if (!fileOp) {
+    if (!digest->ctx) {
         return false;
     }
     
-    bool result = openssl_encrypt_file(fileOp->sourceHandle, key, fileOp->destinationHandle);
-    if (result) {
-        result = aesFileOpMoveTempToDestination(fileOp);
+    if (mode.type != DIGEST_SHA2_TREE) {
+        if (1 != EVP_DigestInit_ex(digest->ctx, digest->md, NULL)) {
+            aesFileDigestFree(digest);
+            return false;
+        }
+        return true;
     }
     
-    freeFileOperation(&fileOp);
+    if (deferredLength > 0 && !(digest->firstLeaf = wickr_alloc(DIGEST_TREE_LEAF_SIZE - deferredLength))) {
+        aesFileDigestFree(digest);
+        return false;
+    }
+    
+    return true;
+}
+
+/* Add the hash of the open leaf to the list of leaves, or an empty slot for a deferred first leaf */
+static bool aesFileDigestCloseLeaf(AESFileDigest *digest)
+{
+    size_t digestLength = digest->mode.size;
+    
+    if (digest->leavesLength + digestLength > digest->leavesCapacity) {
+        size_t capacity = digest->leavesCapacity ? digest->leavesCapacity * 2 : 64 * digestLength;
+        uint8_t *leaves = wickr_alloc(capacity);
+        
+        if (!leaves) {
+            return false;
+        }
+        
+        if (digest->leaves) {
+            memcpy(leaves, digest->leaves, digest->leavesLength);
+            wickr_free(digest->leaves);
+        }
+        
+        digest->leaves = leaves;
+        digest->leavesCapacity = capacity;
+    }
+    
+    if (digest->isLeafOpen) {
+        if (1 != EVP_DigestFinal_ex(digest->ctx, digest->leaves + digest->leavesLength, NULL)) {
+            return false;
+        }
+        digest->isLeafOpen = false;
+    }
+    else {
+        memset(digest->leaves + digest->leavesLength, 0, digestLength);
+    }
+    
+    digest->leavesLength += digestLength;
+    
+    return true;
+}
+
+static bool aesFileDigestUpdate(AESFileDigest *digest, const uint8_t *bytes, size_t length)
+{
+    if (!digest) {
+        return true;
+    }
+    
+    if (digest->mode.type != DIGEST_SHA2_TREE) {
+        return 1 == EVP_DigestUpdate(digest->ctx, bytes, length);
+    }
+    
+    while (length > 0) {
+        size_t leafOffset = (size_t)(digest->position % DIGEST_TREE_LEAF_SIZE);
+        size_t count = DIGEST_TREE_LEAF_SIZE - leafOffset < length ? DIGEST_TREE_LEAF_SIZE - leafOffset : length;
+        
+        if (digest->deferredLength > 0 && digest->position < DIGEST_TREE_LEAF_SIZE) {
+            memcpy(digest->firstLeaf + digest->firstLeafLength, bytes, count);
+            digest->firstLeafLength += count;
+        }
+        else {
+            if (!digest->isLeafOpen) {
+                uint8_t prefix = OPENSSL_TREE_LEAF_PREFIX;
+                if (1 != EVP_DigestInit_ex(digest->ctx, digest->md, NULL) || 1 != EVP_DigestUpdate(digest->ctx, &prefix, 1)) {
+                    return false;
+                }
+                digest->isLeafOpen = true;
+            }
+            
+            if (1 != EVP_DigestUpdate(digest->ctx, bytes, count)) {
+                return false;
+            }
+        }
+        
+        digest->position += count;
+        bytes += count;
+        length -= count;
+        
+        if (digest->position % DIGEST_TREE_LEAF_SIZE == 0 && !aesFileDigestCloseLeaf(digest)) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+/* Finish the digest. 'deferred' must contain the 'deferredLength' bytes that were deferred by 'aesFileDigestInit' */
+static wickr_buffer_t *aesFileDigestFinal(AESFileDigest *digest, const uint8_t *deferred)
+{
+    if (digest->mode.type != DIGEST_SHA2_TREE) {
+        wickr_buffer_t *result = wickr_buffer_create_empty(digest->mode.size);
+        
+        if (result && 1 != EVP_DigestFinal_ex(digest->ctx, result->bytes, NULL)) {
+            wickr_buffer_destroy(&result);
+        }
+        
+        return result;
+    }
+    
+    /* Close a partial last leaf. Empty input is a single empty leaf */
+    if (digest->position == 0) {
+        uint8_t prefix = OPENSSL_TREE_LEAF_PREFIX;
+        if (1 != EVP_DigestInit_ex(digest->ctx, digest->md, NULL) || 1 != EVP_DigestUpdate(digest->ctx, &prefix, 1)) {
+            return NULL;
+        }
+        digest->isLeafOpen = true;
+    }
+    
+    if ((digest->position % DIGEST_TREE_LEAF_SIZE != 0 || digest->position == 0) && !aesFileDigestCloseLeaf(digest)) {
+        return NULL;
+    }
+    
+    if (digest->deferredLength > 0) {
+        uint8_t prefix = OPENSSL_TREE_LEAF_PREFIX;
+        
+        if (1 != EVP_DigestInit_ex(digest->ctx, digest->md, NULL) || 1 != EVP_DigestUpdate(digest->ctx, &prefix, 1) ||
+            1 != EVP_DigestUpdate(digest->ctx, deferred, digest->deferredLength) ||
+            1 != EVP_DigestUpdate(digest->ctx, digest->firstLeaf, digest->firstLeafLength) ||
+            1 != EVP_DigestFinal_ex(digest->ctx, digest->leaves, NULL)) {
+            return NULL;
+        }
+    }
+    
+    return openssl_tree_reduce(digest->md, digest->leaves, digest->leavesLength / digest->mode.size);
+}
+
+static bool aesFileDigestReadFile(AESFileDigest *digest, const char *path)
+{
+    FILE *handle = openssl_file_open(path, "rb");
+    uint8_t *buffer = wickr_alloc(AES_FILE_DIGEST_CHUNK_SIZE);
+    bool result = false;
+    
+    if (!handle || !buffer) {
+        goto process_done;
+    }
+    
+    for (;;) {
+        size_t bytesRead = fread(buffer, 1, AES_FILE_DIGEST_CHUNK_SIZE, handle);
+        
+        if (ferror(handle) || !aesFileDigestUpdate(digest, buffer, bytesRead)) {
+            goto process_done;
+        }
+        
+        if (bytesRead < AES_FILE_DIGEST_CHUNK_SIZE) {
+            break;
+        }
+    }
+    
+    result = true;
+    
+process_done:
+    if (handle) {
+        fclose(handle);
+    }
+    if (buffer) {
+        wickr_free(buffer);
+    }
     
     return result;
 }
 
-bool openssl_aes256_file_decrypt(const wickr_cipher_key_t *key, const char *sourceFilePath, const char *destinationFilePath, bool only_auth_ciphers)
+#pragma mark - Memory Mapped File Operations
+
+static uint64_t mmapThreshold = OPENSSL_FILE_MMAP_DEFAULT_THRESHOLD;
+
+void openssl_aes256_file_set_mmap_threshold(uint64_t threshold)
 {
-    if (!key || !sourceFilePath || !destinationFilePath) {
+    mmapThreshold = threshold;
+}
+
+uint64_t openssl_aes256_file_get_mmap_threshold(void)
+{
+    return mmapThreshold;
+}
+
+#if OPENSSL_FILE_MMAP_SUPPORTED
+
+typedef struct AESFileMapping {
+    uint8_t *source;
+    size_t sourceLength;
+    uint8_t *destination;
+    size_t destinationLength;
+} AESFileMapping;
+
+/* Returns true if the source file of an operation is large enough to be processed using memory maps */
+static bool aesFileOpShouldMap(AESFileOperation *operation, size_t *sourceLength)
+{
+    struct stat st;
+    
+    if (fstat(fileno(operation->sourceHandle), &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
         return false;
     }
     
-    AESFileOperation *fileOp = createFileOperation(sourceFilePath, destinationFilePath);
-    if (!fileOp) {
+    if ((uint64_t)st.st_size < mmapThreshold || (uint64_t)st.st_size > SIZE_MAX) {
         return false;
     }
     
-    bool result = openssl_decrypt_file(fileOp->sourceHandle, key, fileOp->destinationHandle, only_auth_ciphers);
-    if (result) {
-        result = aesFileOpMoveTempToDestination(fileOp);
+    *sourceLength = (size_t)st.st_size;
+    
+    return true;
+}
+
+static void aesFileOpUnmap(AESFileMapping *mapping)
+{
+    if (mapping->source) {
+        munmap(mapping->source, mapping->sourceLength);
+        mapping->source = NULL;
+    }
+    if (mapping->destination) {
+        munmap(mapping->destination, mapping->destinationLength);
+        mapping->destination = NULL;
+    }
+}
+
+/* Map the source file read only */
+static bool aesFileOpMapSource(AESFileOperation *operation, size_t sourceLength, AESFileMapping *mapping)
+{
+    memset(mapping, 0, sizeof(AESFileMapping));
+    
+    void *source = mmap(NULL, sourceLength, PROT_READ, MAP_SHARED, fileno(operation->sourceHandle), 0);
+    if (source == MAP_FAILED) {
+        return false;
+    }
+    
+    mapping->source = source;
+    mapping->sourceLength = sourceLength;
+    madvise(mapping->source, mapping->sourceLength, MADV_SEQUENTIAL);
+    
+    return true;
+}
+
+/*
+ Size the destination file to 'destinationLength' and map it for writing. If this fails, the stdio path writes exactly
+ 'destinationLength' bytes from the start of the file, so the size set here doesn't need to be undone
+ */
+static bool aesFileOpMapDestination(AESFileOperation *operation, size_t destinationLength, AESFileMapping *mapping)
+{
+    if (destinationLength == 0 || fflush(operation->destinationHandle) != 0) {
+        return false;
+    }
+    
+    int destinationFd = fileno(operation->destinationHandle);
+    
+    if (ftruncate(destinationFd, (off_t)destinationLength) != 0) {
+        return false;
+    }
+    
+#if defined(__linux__)
+    /* Reserve the blocks up front so running out of space fails here rather than with SIGBUS while writing to the map */
+    if (posix_fallocate(destinationFd, 0, (off_t)destinationLength) != 0) {
+        return false;
+    }
+#endif
+    
+    void *destination = mmap(NULL, destinationLength, PROT_READ | PROT_WRITE, MAP_SHARED, destinationFd, 0);
+    if (destination == MAP_FAILED) {
+        return false;
+    }
+    
+    mapping->destination = destination;
+    mapping->destinationLength = destinationLength;
+    madvise(mapping->destination, mapping->destinationLength, MADV_SEQUENTIAL);
+    
+    return true;
+}
+
+/*
+ Run the cipher over mapped memory in pieces, since OpenSSL takes lengths as an int. The input and output of each piece are
+ added to the digests right after the cipher, while they are still in the cache
+ */
+static bool aesFileCipherMapped(EVP_CIPHER_CTX *ctx, const uint8_t *input, size_t length, uint8_t *output,
+                                AESFileDigest *inputDigest, AESFileDigest *outputDigest)
+{
+    size_t offset = 0;
+    size_t chunkSize = inputDigest || outputDigest ? AES_FILE_DIGEST_CHUNK_SIZE : OPENSSL_FILE_MMAP_CHUNK_SIZE;
+    
+    while (offset < length) {
+        size_t chunk = length - offset;
+        if (chunk > chunkSize) {
+            chunk = chunkSize;
+        }
+        
+        int outLength = 0;
+        if (1 != EVP_CipherUpdate(ctx, output + offset, &outLength, input + offset, (int)chunk) || outLength != (int)chunk) {
+            return false;
+        }
+        
+        if (!aesFileDigestUpdate(inputDigest, input + offset, chunk) || !aesFileDigestUpdate(outputDigest, output + offset, chunk)) {
+            return false;
+        }
+        
+        offset += chunk;
+    }
+    
+    return true;
+}
+
+static bool aesFileOpEncryptMapped(AESFileOperation *operation, const wickr_cipher_key_t *key, size_t sourceLength,
+                                   AESFileDigests *digests, bool *didMap)
+{
+    bool result = false;
+    AESFileMapping mapping;
+    EVP_CIPHER_CTX *ctx = NULL;
+    wickr_buffer_t *serialized = NULL;
+    
+    const EVP_CIPHER *openssl_cipher = aesFileCipherMode(key->cipher);
+    if (!openssl_cipher || key->key_data->length != key->cipher.key_len) {
+        return false;
+    }
+    
+    wickr_buffer_t *iv = openssl_crypto_random(key->cipher.iv_len);
+    wickr_buffer_t *auth_tag = key->cipher.is_authenticated ? wickr_buffer_create_empty_zero(key->cipher.auth_tag_len) : NULL;
+    wickr_cipher_result_t *cipher_result = wickr_cipher_result_create(key->cipher, iv, NULL, auth_tag);
+    
+    if (!cipher_result) {
+        wickr_buffer_destroy(&iv);
+        wickr_buffer_destroy(&auth_tag);
+        return false;
+    }
+    
+    size_t headerLength = sizeof(uint8_t) + key->cipher.iv_len + key->cipher.auth_tag_len;
+    
+    if (sourceLength > SIZE_MAX - headerLength || !aesFileOpMapSource(operation, sourceLength, &mapping)) {
+        wickr_cipher_result_destroy(&cipher_result);
+        return false;
+    }
+    
+    if (!aesFileOpMapDestination(operation, sourceLength + headerLength, &mapping)) {
+        aesFileOpUnmap(&mapping);
+        wickr_cipher_result_destroy(&cipher_result);
+        return false;
+    }
+    
+    *didMap = true;
+    
+    ctx = EVP_CIPHER_CTX_new();
+    if (!ctx) {
+        goto process_done;
+    }
+    
+    if (1 != EVP_EncryptInit_ex(ctx, openssl_cipher, NULL, key->key_data->bytes, cipher_result->iv->bytes)) {
+        goto process_done;
+    }
+    
+    if (!aesFileCipherMapped(ctx, mapping.source, sourceLength, mapping.destination + headerLength,
+                             digests ? digests->plain : NULL, digests ? digests->cipher : NULL)) {
+        goto process_done;
+    }
+    
+    int finalLength = 0;
+    if (1 != EVP_EncryptFinal_ex(ctx, NULL, &finalLength) || finalLength != 0) {
+        goto process_done;
+    }
+    
+    if (cipher_result->cipher.is_authenticated &&
+        1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, cipher_result->cipher.auth_tag_len, cipher_result->auth_tag->bytes)) {
+        goto process_done;
+    }
+    
+    serialized = wickr_cipher_result_serialize(cipher_result);
+    if (!serialized || serialized->length != headerLength) {
+        goto process_done;
+    }
+    
+    memcpy(mapping.destination, serialized->bytes, headerLength);
+    
+    if (digests) {
+        memcpy(digests->header, serialized->bytes, headerLength);
+        digests->headerLength = headerLength;
+    }
+    
+    result = true;
+    
+process_done:
+    aesFileOpUnmap(&mapping);
+    wickr_buffer_destroy(&serialized);
+    wickr_cipher_result_destroy(&cipher_result);
+    if (ctx) {
+        EVP_CIPHER_CTX_free(ctx);
+    }
+    
+    return result;
+}
+
+static bool aesFileOpDecryptMapped(AESFileOperation *operation, const wickr_cipher_key_t *key, size_t sourceLength,
+                                   bool only_auth_ciphers, AESFileDigests *digests, bool *didMap)
+{
+    bool result = false;
+    AESFileMapping mapping;
+    EVP_CIPHER_CTX *ctx = NULL;
+    wickr_cipher_result_t *cipher_result = NULL;
+    
+    if (!aesFileOpMapSource(operation, sourceLength, &mapping)) {
+        return false;
+    }
+    
+    /* Invalid headers are left to the stdio path, which fails in the same way */
+    const wickr_cipher_t *mode = wickr_cipher_find(mapping.source[0]);
+    const EVP_CIPHER *openssl_cipher = mode ? aesFileCipherMode(*mode) : NULL;
+    size_t headerLength = mode ? sizeof(uint8_t) + mode->iv_len + mode->auth_tag_len : 0;
+    
+    if (!openssl_cipher || (only_auth_ciphers && !mode->is_authenticated) || mode->cipher_id != key->cipher.cipher_id ||
+        key->key_data->length != mode->key_len || sourceLength <= headerLength) {
+        aesFileOpUnmap(&mapping);
+        return false;
+    }
+    
+    if (!aesFileOpMapDestination(operation, sourceLength - headerLength, &mapping)) {
+        aesFileOpUnmap(&mapping);
+        return false;
+    }
+    
+    *didMap = true;
+    
+    wickr_buffer_t header = { .bytes = mapping.source, .length = headerLength };
+    cipher_result = wickr_cipher_result_from_buffer(&header);
+    ctx = EVP_CIPHER_CTX_new();
+    
+    if (!cipher_result || !ctx) {
+        goto process_done;
+    }
+    
+    if (1 != EVP_DecryptInit_ex(ctx, openssl_cipher, NULL, key->key_data->bytes, cipher_result->iv->bytes)) {
+        goto process_done;
+    }
+    
+    if (mode->is_authenticated &&
+        1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, mode->auth_tag_len, cipher_result->auth_tag->bytes)) {
+        goto process_done;
+    }
+    
+    if (digests && !aesFileDigestUpdate(digests->cipher, mapping.source, headerLength)) {
+        goto process_done;
+    }
+    
+    if (!aesFileCipherMapped(ctx, mapping.source + headerLength, sourceLength - headerLength, mapping.destination,
+                             digests ? digests->cipher : NULL, digests ? digests->plain : NULL)) {
+        goto process_done;
+    }
+    
+    int finalLength = 0;
+    result = 1 == EVP_DecryptFinal_ex(ctx, NULL, &finalLength) && finalLength == 0;
+    
+process_done:
+    aesFileOpUnmap(&mapping);
+    wickr_cipher_result_destroy(&cipher_result);
+    if (ctx) {
+        EVP_CIPHER_CTX_free(ctx);
     }
-    freeFileOperation(&fileOp);
     
     return result;
 }
 
+#endif
+
+#pragma mark - Pipelined File Operations
+
+static openssl_file_pipeline_config_t pipelineConfig = { false, OPENSSL_FILE_PIPELINE_DEFAULT_CHUNK_SIZE, OPENSSL_FILE_PIPELINE_DEFAULT_BUFFER_COUNT };
+
+bool openssl_aes256_file_set_pipeline_config(openssl_file_pipeline_config_t config)
+{
+    if (config.chunk_size == 0 || config.chunk_size > INT_MAX) {
+        return false;
+    }
+    
+    if (config.buffer_count < OPENSSL_FILE_PIPELINE_MIN_BUFFER_COUNT || config.buffer_count > OPENSSL_FILE_PIPELINE_MAX_BUFFER_COUNT) {
+        return false;
+    }
+    
+    pipelineConfig = config;
+    
+    return true;
+}
+
+openssl_file_pipeline_config_t openssl_aes256_file_get_pipeline_config(void)
+{
+    return pipelineConfig;
+}
+
+typedef struct AESFilePipelineSlot {
+    uint8_t *bytes;
+    size_t length;
+} AESFilePipelineSlot;
+
+/*
+ A bounded ring of buffers shared by a reader thread, the calling thread which runs the cipher in place, and a writer thread.
+ Each counter is the number of buffers that have completed a stage, so a buffer can be read into when it has been written out,
+ and the stages never get more than 'slotCount' buffers apart
+ */
+typedef struct AESFilePipeline {
+    FILE *source;
+    FILE *destination;
+    AESFilePipelineSlot *slots;
+    AESFileDigest *inputDigest;
+    AESFileDigest *outputDigest;
+    uint32_t slotCount;
+    size_t chunkSize;
+    uint64_t readCount;
+    uint64_t cryptCount;
+    uint64_t writeCount;
+    bool isReadDone;
+    bool isCryptDone;
+    bool isFailed;
+    wickr_mutex_t lock;
+    wickr_cond_t cond;
+} AESFilePipeline;
+
+static void aesFilePipelineFail(AESFilePipeline *pipeline)
+{
+    wickr_mutex_lock(&pipeline->lock);
+    pipeline->isFailed = true;
+    wickr_cond_broadcast(&pipeline->cond);
+    wickr_mutex_unlock(&pipeline->lock);
+}
+
+static void *aesFilePipelineRead(void *arg)
+{
+    AESFilePipeline *pipeline = arg;
+    
+    for (;;) {
+        wickr_mutex_lock(&pipeline->lock);
+        while (!pipeline->isFailed && pipeline->readCount - pipeline->writeCount == pipeline->slotCount) {
+            wickr_cond_wait(&pipeline->cond, &pipeline->lock);
+        }
+        bool isFailed = pipeline->isFailed;
+        AESFilePipelineSlot *slot = &pipeline->slots[pipeline->readCount % pipeline->slotCount];
+        wickr_mutex_unlock(&pipeline->lock);
+        
+        if (isFailed) {
+            return NULL;
+        }
+        
+        slot->length = fread(slot->bytes, 1, pipeline->chunkSize, pipeline->source);
+        bool isEOF = slot->length < pipeline->chunkSize;
+        
+        if (isEOF && ferror(pipeline->source)) {
+            aesFilePipelineFail(pipeline);
+            return NULL;
+        }
+        
+        wickr_mutex_lock(&pipeline->lock);
+        if (slot->length > 0) {
+            pipeline->readCount++;
+        }
+        pipeline->isReadDone = isEOF;
+        wickr_cond_broadcast(&pipeline->cond);
+        wickr_mutex_unlock(&pipeline->lock);
+        
+        if (isEOF) {
+            return NULL;
+        }
+    }
+}
+
+static void *aesFilePipelineWrite(void *arg)
+{
+    AESFilePipeline *pipeline = arg;
+    
+    for (;;) {
+        wickr_mutex_lock(&pipeline->lock);
+        while (!pipeline->isFailed && pipeline->writeCount == pipeline->cryptCount && !pipeline->isCryptDone) {
+            wickr_cond_wait(&pipeline->cond, &pipeline->lock);
+        }
+        bool isFinished = pipeline->isFailed || pipeline->writeCount == pipeline->cryptCount;
+        AESFilePipelineSlot *slot = &pipeline->slots[pipeline->writeCount % pipeline->slotCount];
+        wickr_mutex_unlock(&pipeline->lock);
+        
+        if (isFinished) {
+            return NULL;
+        }
+        
+        if (fwrite(slot->bytes, 1, slot->length, pipeline->destination) != slot->length) {
+            aesFilePipelineFail(pipeline);
+            return NULL;
+        }
+        
+        wickr_mutex_lock(&pipeline->lock);
+        pipeline->writeCount++;
+        wickr_cond_broadcast(&pipeline->cond);
+        wickr_mutex_unlock(&pipeline->lock);
+    }
+}
 
+static void aesFilePipelineCrypt(AESFilePipeline *pipeline, EVP_CIPHER_CTX *ctx)
+{
+    for (;;) {
+        wickr_mutex_lock(&pipeline->lock);
+        while (!pipeline->isFailed && pipeline->cryptCount == pipeline->readCount && !pipeline->isReadDone) {
+            wickr_cond_wait(&pipeline->cond, &pipeline->lock);
+        }
+        bool isFinished = pipeline->isFailed || pipeline->cryptCount == pipeline->readCount;
+        AESFilePipelineSlot *slot = &pipeline->slots[pipeline->cryptCount % pipeline->slotCount];
+        wickr_mutex_unlock(&pipeline->lock);
+        
+        if (isFinished) {
+            break;
+        }
+        
+        if (!aesFileDigestUpdate(pipeline->inputDigest, slot->bytes, slot->length)) {
+            aesFilePipelineFail(pipeline);
+            break;
+        }
+        
+        /* GCM and CTR modes don't buffer, so the cipher can run in place and outputs exactly as many bytes as it is given */
+        int outLength = 0;
+        if (1 != EVP_CipherUpdate(ctx, slot->bytes, &outLength, slot->bytes, (int)slot->length) || outLength != (int)slot->length) {
+            aesFilePipelineFail(pipeline);
+            break;
+        }
+        
+        if (!aesFileDigestUpdate(pipeline->outputDigest, slot->bytes, slot->length)) {
+            aesFilePipelineFail(pipeline);
+            break;
+        }
+        
+        wickr_mutex_lock(&pipeline->lock);
+        pipeline->cryptCount++;
+        wickr_cond_broadcast(&pipeline->cond);
+        wickr_mutex_unlock(&pipeline->lock);
+    }
+    
+    wickr_mutex_lock(&pipeline->lock);
+    pipeline->isCryptDone = true;
+    wickr_cond_broadcast(&pipeline->cond);
+    wickr_mutex_unlock(&pipeline->lock);
+}
 
+/* Stream the rest of 'source' through 'ctx' into 'destination', adding the input and output to the optional digests */
+static bool aesFilePipelineRun(FILE *source, FILE *destination, EVP_CIPHER_CTX *ctx, openssl_file_pipeline_config_t config,
+                               AESFileDigest *inputDigest, AESFileDigest *outputDigest)
+{
+    AESFilePipeline pipeline;
+    memset(&pipeline, 0, sizeof(AESFilePipeline));
+    
+    pipeline.source = source;
+    pipeline.destination = destination;
+    pipeline.inputDigest = inputDigest;
+    pipeline.outputDigest = outputDigest;
+    pipeline.slotCount = config.buffer_count;
+    pipeline.chunkSize = config.chunk_size;
+    pipeline.slots = wickr_alloc_zero(sizeof(AESFilePipelineSlot) * pipeline.slotCount);
+    
+    if (!pipeline.slots) {
+        return false;
+    }
+    
+    bool result = false;
+    bool isReaderStarted = false;
+    bool isWriterStarted = false;
+    wickr_thread_t reader;
+    wickr_thread_t writer;
+    
+    for (uint32_t i = 0; i < pipeline.slotCount; i++) {
+        if (!(pipeline.slots[i].bytes = wickr_alloc(pipeline.chunkSize))) {
+            goto process_done;
+        }
+    }
+    
+    if (!wickr_mutex_init(&pipeline.lock)) {
+        goto process_done;
+    }
+    
+    if (!wickr_cond_init(&pipeline.cond)) {
+        wickr_mutex_destroy(&pipeline.lock);
+        goto process_done;
+    }
+    
+    isReaderStarted = wickr_thread_create(&reader, aesFilePipelineRead, &pipeline);
+    isWriterStarted = isReaderStarted && wickr_thread_create(&writer, aesFilePipelineWrite, &pipeline);
+    
+    if (!isReaderStarted || !isWriterStarted) {
+        aesFilePipelineFail(&pipeline);
+    }
+    
+    aesFilePipelineCrypt(&pipeline, ctx);
+    
+    if (isReaderStarted) {
+        wickr_thread_join(reader);
+    }
+    if (isWriterStarted) {
+        wickr_thread_join(writer);
+    }
+    
+    result = !pipeline.isFailed && pipeline.writeCount == pipeline.readCount;
+    
+    wickr_cond_destroy(&pipeline.cond);
+    wickr_mutex_destroy(&pipeline.lock);
+    
+process_done:
+    for (uint32_t i = 0; i < pipeline.slotCount; i++) {
+        if (pipeline.slots[i].bytes) {
+            OPENSSL_cleanse(pipeline.slots[i].bytes, pipeline.chunkSize);
+            wickr_free(pipeline.slots[i].bytes);
+        }
+    }
+    wickr_free(pipeline.slots);
+    
+    return result;
+}
+
+static bool aesFileOpEncryptPipelined(AESFileOperation *operation, const wickr_cipher_key_t *key, openssl_file_pipeline_config_t config,
+                                      AESFileDigests *digests)
+{
+    const EVP_CIPHER *openssl_cipher = aesFileCipherMode(key->cipher);
+    if (!openssl_cipher || key->key_data->length != key->cipher.key_len) {
+        return false;
+    }
+    
+    bool result = false;
+    EVP_CIPHER_CTX *ctx = NULL;
+    wickr_buffer_t *serialized = NULL;
+    
+    wickr_buffer_t *iv = openssl_crypto_random(key->cipher.iv_len);
+    wickr_buffer_t *auth_tag = key->cipher.is_authenticated ? wickr_buffer_create_empty_zero(key->cipher.auth_tag_len) : NULL;
+    wickr_cipher_result_t *cipher_result = wickr_cipher_result_create(key->cipher, iv, NULL, auth_tag);
+    
+    if (!cipher_result) {
+        wickr_buffer_destroy(&iv);
+        wickr_buffer_destroy(&auth_tag);
+        return false;
+    }
+    
+    /* Write the header with an empty tag, and fill in the tag once the whole file has been processed */
+    serialized = wickr_cipher_result_serialize(cipher_result);
+    ctx = EVP_CIPHER_CTX_new();
+    
+    if (!serialized || !ctx || fwrite(serialized->bytes, 1, serialized->length, operation->destinationHandle) != serialized->length) {
+        goto process_done;
+    }
+    
+    if (1 != EVP_EncryptInit_ex(ctx, openssl_cipher, NULL, key->key_data->bytes, cipher_result->iv->bytes)) {
+        goto process_done;
+    }
+    
+    if (!aesFilePipelineRun(operation->sourceHandle, operation->destinationHandle, ctx, config,
+                            digests ? digests->plain : NULL, digests ? digests->cipher : NULL)) {
+        goto process_done;
+    }
+    
+    int finalLength = 0;
+    if (1 != EVP_EncryptFinal_ex(ctx, NULL, &finalLength) || finalLength != 0) {
+        goto process_done;
+    }
+    
+    if (cipher_result->cipher.is_authenticated &&
+        1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, cipher_result->cipher.auth_tag_len, cipher_result->auth_tag->bytes)) {
+        goto process_done;
+    }
+    
+    wickr_buffer_destroy(&serialized);
+    serialized = wickr_cipher_result_serialize(cipher_result);
+    
+    if (!serialized || serialized->length > AES_FILE_HEADER_MAX_LEN) {
+        goto process_done;
+    }
+    
+    if (digests) {
+        memcpy(digests->header, serialized->bytes, serialized->length);
+        digests->headerLength = serialized->length;
+    }
+    
+    rewind(operation->destinationHandle);
+    result = fwrite(serialized->bytes, 1, serialized->length, operation->destinationHandle) == serialized->length;
+    
+process_done:
+    wickr_buffer_destroy(&serialized);
+    wickr_cipher_result_destroy(&cipher_result);
+    if (ctx) {
+        EVP_CIPHER_CTX_free(ctx);
+    }
+    
+    return result;
+}
+
+static bool aesFileOpDecryptPipelined(AESFileOperation *operation, const wickr_cipher_key_t *key, bool only_auth_ciphers,
+                                      openssl_file_pipeline_config_t config, AESFileDigests *digests)
+{
+    uint8_t header[AES_FILE_HEADER_MAX_LEN];
+    
+    if (fread(header, 1, 1, operation->sourceHandle) != 1) {
+        return false;
+    }
+    
+    const wickr_cipher_t *mode = wickr_cipher_find(header[0]);
+    const EVP_CIPHER *openssl_cipher = mode ? aesFileCipherMode(*mode) : NULL;
+    
+    if (!openssl_cipher || (only_auth_ciphers && !mode->is_authenticated) || key->key_data->length != mode->key_len) {
+        return false;
+    }
+    
+    size_t headerLength = sizeof(uint8_t) + mode->iv_len + mode->auth_tag_len;
+    
+    if (headerLength > sizeof(header) || fread(header + 1, 1, headerLength - 1, operation->sourceHandle) != headerLength - 1) {
+        return false;
+    }
+    
+    bool result = false;
+    wickr_buffer_t headerBuffer = { .bytes = header, .length = headerLength };
+    wickr_cipher_result_t *cipher_result = wickr_cipher_result_from_buffer(&headerBuffer);
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    
+    if (!cipher_result || !ctx) {
+        goto process_done;
+    }
+    
+    if (1 != EVP_DecryptInit_ex(ctx, openssl_cipher, NULL, key->key_data->bytes, cipher_result->iv->bytes)) {
+        goto process_done;
+    }
+    
+    if (mode->is_authenticated &&
+        1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, mode->auth_tag_len, cipher_result->auth_tag->bytes)) {
+        goto process_done;
+    }
+    
+    if (digests && !aesFileDigestUpdate(digests->cipher, header, headerLength)) {
+        goto process_done;
+    }
+    
+    if (!aesFilePipelineRun(operation->sourceHandle, operation->destinationHandle, ctx, config,
+                            digests ? digests->cipher : NULL, digests ? digests->plain : NULL)) {
+        goto process_done;
+    }
+    
+    int finalLength = 0;
+    result = 1 == EVP_DecryptFinal_ex(ctx, NULL, &finalLength) && finalLength == 0;
+    
+process_done:
+    wickr_cipher_result_destroy(&cipher_result);
+    if (ctx) {
+        EVP_CIPHER_CTX_free(ctx);
+    }
+    
+    return result;
+}
+
+/*
+ Encrypt a file using the pipelined mode if it is enabled, otherwise memory maps if the file is large enough, otherwise stdio.
+ The stdio implementation can't calculate digests, so the pipelined mode replaces it when digests are requested
+ */
+static bool aesFileEncrypt(const wickr_cipher_key_t *key, const char *sourceFilePath, const char *destinationFilePath, AESFileDigests *digests)
+{
+    AESFileOperation *fileOp = createFileOperation(sourceFilePath, destinationFilePath);
+    
+    if (!fileOp) {
+        return false;
+    }
+    
+    bool result = false;
+    bool isProcessed = false;
+    openssl_file_pipeline_config_t config = pipelineConfig;
+    
+    if (config.enabled) {
+        result = aesFileOpEncryptPipelined(fileOp, key, config, digests);
+        isProcessed = true;
+    }
+    
+#if OPENSSL_FILE_MMAP_SUPPORTED
+    size_t sourceLength = 0;
+    if (!isProcessed && aesFileOpShouldMap(fileOp, &sourceLength)) {
+        result = aesFileOpEncryptMapped(fileOp, key, sourceLength, digests, &isProcessed);
+    }
+#endif
+    
+    /* Fall back to stdio for small files, or if the files can't be mapped */
+    if (!isProcessed && digests) {
+        result = aesFileOpEncryptPipelined(fileOp, key, config, digests);
+    }
+    else if (!isProcessed) {
+        result = openssl_encrypt_file(fileOp->sourceHandle, key, fileOp->destinationHandle);
+    }
+    
+    /* The output is read back before it is moved into place, while it is likely to still be cached */
+    if (result && digests && digests->readBack) {
+        result = fflush(fileOp->destinationHandle) == 0 && aesFileDigestReadFile(digests->readBack, fileOp->tempPath);
+    }
+    
+    if (result) {
+        result = aesFileOpMoveTempToDestination(fileOp);
+    }
+    
+    freeFileOperation(&fileOp);
+    
+    return result;
+}
+
+static bool aesFileDecrypt(const wickr_cipher_key_t *key, const char *sourceFilePath, const char *destinationFilePath, bool only_auth_ciphers,
+                           AESFileDigests *digests)
+{
+    AESFileOperation *fileOp = createFileOperation(sourceFilePath, destinationFilePath);
+    if (!fileOp) {
+        return false;
+    }
+    
+    bool result = false;
+    bool isProcessed = false;
+    openssl_file_pipeline_config_t config = pipelineConfig;
+    
+    if (config.enabled) {
+        result = aesFileOpDecryptPipelined(fileOp, key, only_auth_ciphers, config, digests);
+        isProcessed = true;
+    }
+    
+#if OPENSSL_FILE_MMAP_SUPPORTED
+    size_t sourceLength = 0;
+    if (!isProcessed && aesFileOpShouldMap(fileOp, &sourceLength)) {
+        result = aesFileOpDecryptMapped(fileOp, key, sourceLength, only_auth_ciphers, digests, &isProcessed);
+    }
+#endif
+    
+    /* Fall back to stdio for small files, or if the files can't be mapped */
+    if (!isProcessed && digests) {
+        result = aesFileOpDecryptPipelined(fileOp, key, only_auth_ciphers, config, digests);
+    }
+    else if (!isProcessed) {
+        result = openssl_decrypt_file(fileOp->sourceHandle, key, fileOp->destinationHandle, only_auth_ciphers);
+    }
+    
+    if (result) {
+        result = aesFileOpMoveTempToDestination(fileOp);
+    }
+    freeFileOperation(&fileOp);
+    
+    return result;
+}
+
+bool openssl_aes256_file_encrypt(const wickr_cipher_key_t *key, const char *sourceFilePath, const char *destinationFilePath)
+{    
+    if (!key || !sourceFilePath || !destinationFilePath) {
+        return false;
+    }
+    
+    return aesFileEncrypt(key, sourceFilePath, destinationFilePath, NULL);
+}
+
+bool openssl_aes256_file_decrypt(const wickr_cipher_key_t *key, const char *sourceFilePath, const char *destinationFilePath, bool only_auth_ciphers)
+{
+    if (!key || !sourceFilePath || !destinationFilePath) {
+        return false;
+    }
+    
+    /* Files in the segmented format are always authenticated, so they are accepted regardless of only_auth_ciphers */
+    uint64_t segmented_length = 0;
+    if (openssl_aes256_file_segmented_length(sourceFilePath, &segmented_length)) {
+        return openssl_aes256_file_decrypt_segmented(key, sourceFilePath, destinationFilePath,
+                                                     OPENSSL_FILE_SEGMENTED_DEFAULT_THREADS);
+    }
+    
+    return aesFileDecrypt(key, sourceFilePath, destinationFilePath, only_auth_ciphers, NULL);
+}
+
+bool openssl_aes256_file_encrypt_digest(const wickr_cipher_key_t *key,
+                                        const char *sourceFilePath,
+                                        const char *destinationFilePath,
+                                        wickr_digest_t digest_mode,
+                                        wickr_buffer_t **plaintext_digest,
+                                        wickr_buffer_t **ciphertext_digest)
+{
+    if (!key || !sourceFilePath || !destinationFilePath || (!plaintext_digest && !ciphertext_digest)) {
+        return false;
+    }
+    
+    AESFileDigest plain;
+    AESFileDigest cipher;
+    AESFileDigests digests;
+    memset(&plain, 0, sizeof(AESFileDigest));
+    memset(&cipher, 0, sizeof(AESFileDigest));
+    memset(&digests, 0, sizeof(AESFileDigests));
+    
+    bool result = false;
+    bool isTree = digest_mode.type == DIGEST_SHA2_TREE;
+    size_t headerLength = sizeof(uint8_t) + key->cipher.iv_len + key->cipher.auth_tag_len;
+    wickr_buffer_t *plainResult = NULL;
+    wickr_buffer_t *cipherResult = NULL;
+    
+    if (plaintext_digest) {
+        if (!aesFileDigestInit(&plain, digest_mode, 0)) {
+            goto process_done;
+        }
+        digests.plain = &plain;
+    }
+    
+    if (ciphertext_digest) {
+        if (!aesFileDigestInit(&cipher, digest_mode, isTree ? headerLength : 0)) {
+            goto process_done;
+        }
+        if (isTree) {
+            digests.cipher = &cipher;
+        }
+        else {
+            digests.readBack = &cipher;
+        }
+    }
+    
+    if (!aesFileEncrypt(key, sourceFilePath, destinationFilePath, &digests)) {
+        goto process_done;
+    }
+    
+    if (plaintext_digest && !(plainResult = aesFileDigestFinal(&plain, NULL))) {
+        goto process_done;
+    }
+    
+    if (ciphertext_digest) {
+        if (isTree && digests.headerLength != headerLength) {
+            goto process_done;
+        }
+        if (!(cipherResult = aesFileDigestFinal(&cipher, digests.header))) {
+            goto process_done;
+        }
+    }
+    
+    if (plaintext_digest) {
+        *plaintext_digest = plainResult;
+        plainResult = NULL;
+    }
+    
+    if (ciphertext_digest) {
+        *ciphertext_digest = cipherResult;
+        cipherResult = NULL;
+    }
+    
+    result = true;
+    
+process_done:
+    wickr_buffer_destroy(&plainResult);
+    wickr_buffer_destroy(&cipherResult);
+    aesFileDigestFree(&plain);
+    aesFileDigestFree(&cipher);
+    
+    return result;
+}
+
+bool openssl_aes256_file_decrypt_digest(const wickr_cipher_key_t *key,
+                                        const char *sourceFilePath,
+                                        const char *destinationFilePath,
+                                        bool only_auth_ciphers,
+                                        wickr_digest_t digest_mode,
+                                        wickr_buffer_t **plaintext_digest,
+                                        wickr_buffer_t **ciphertext_digest)
+{
+    if (!key || !sourceFilePath || !destinationFilePath || (!plaintext_digest && !ciphertext_digest)) {
+        return false;
+    }
+    
+    /* The segmented format is processed by independent threads, so it can't feed a single digest */
+    uint64_t segmented_length = 0;
+    if (openssl_aes256_file_segmented_length(sourceFilePath, &segmented_length)) {
+        return false;
+    }
+    
+    AESFileDigest plain;
+    AESFileDigest cipher;
+    AESFileDigests digests;
+    memset(&plain, 0, sizeof(AESFileDigest));
+    memset(&cipher, 0, sizeof(AESFileDigest));
+    memset(&digests, 0, sizeof(AESFileDigests));
+    
+    bool result = false;
+    wickr_buffer_t *plainResult = NULL;
+    wickr_buffer_t *cipherResult = NULL;
+    
+    if (plaintext_digest) {
+        if (!aesFileDigestInit(&plain, digest_mode, 0)) {
+            goto process_done;
+        }
+        digests.plain = &plain;
+    }
+    
+    if (ciphertext_digest) {
+        if (!aesFileDigestInit(&cipher, digest_mode, 0)) {
+            goto process_done;
+        }
+        digests.cipher = &cipher;
+    }
+    
+    if (!aesFileDecrypt(key, sourceFilePath, destinationFilePath, only_auth_ciphers, &digests)) {
+        goto process_done;
+    }
+    
+    if (plaintext_digest && !(plainResult = aesFileDigestFinal(&plain, NULL))) {
+        goto process_done;
+    }
+    
+    if (ciphertext_digest && !(cipherResult = aesFileDigestFinal(&cipher, NULL))) {
+        goto process_done;
+    }
+    
+    if (plaintext_digest) {
+        *plaintext_digest = plainResult;
+        plainResult = NULL;
+    }
+    
+    if (ciphertext_digest) {
+        *ciphertext_digest = cipherResult;
+        cipherResult = NULL;
+    }
+    
+    result = true;
+    
+process_done:
+    wickr_buffer_destroy(&plainResult);
+    wickr_buffer_destroy(&cipherResult);
+    aesFileDigestFree(&plain);
+    aesFileDigestFree(&cipher);
+    
+    return result;
+}
+
+
+
+#pragma mark - Segmented File Format
+
+typedef struct openssl_segmented_header {
+    wickr_cipher_t cipher;
+    uint32_t segment_size;
+    uint64_t plaintext_length;
+    uint64_t segment_count;
+    uint8_t bytes[OPENSSL_FILE_SEGMENTED_HEADER_MAX_LEN];
+    size_t length;
+} openssl_segmented_header_t;
+
+typedef struct openssl_segmented_job {
+    const openssl_segmented_header_t *header;
+    const wickr_cipher_key_t *key;
+    const char *source;
+    const char *destination;
+    uint64_t first_segment;
+    uint64_t end_segment;
+    bool is_encrypt;
+    bool success;
+} openssl_segmented_job_t;
+
+static FILE *openssl_file_open(const char *path, const char *mode)
+{
+    FILE *handle = NULL;
+    
+#if defined(_WIN32)
+    wchar_t wMode[4] = { 0 };
+    mbstowcs(wMode, mode, 3);
+    if (windowsOpenFile(&handle, (char *)path, wMode) != 0) {
+        return NULL;
+    }
+#else
+    handle = fopen(path, mode);
+#endif
+    
+    return handle;
+}
+
+static bool openssl_file_seek(FILE *handle, uint64_t offset)
+{
+#if defined(_WIN32)
+    return _fseeki64(handle, (__int64)offset, SEEK_SET) == 0;
+#else
+    return fseeko(handle, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static bool openssl_file_length(FILE *handle, uint64_t *length)
+{
+#if defined(_WIN32)
+    if (_fseeki64(handle, 0, SEEK_END) != 0) {
+        return false;
+    }
+    __int64 position = _ftelli64(handle);
+#else
+    if (fseeko(handle, 0, SEEK_END) != 0) {
+        return false;
+    }
+    off_t position = ftello(handle);
+#endif
+    
+    if (position < 0) {
+        return false;
+    }
+    
+    *length = (uint64_t)position;
+    
+    return openssl_file_seek(handle, 0);
+}
+
+static void openssl_segmented_write_uint(uint8_t *bytes, uint64_t value, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        bytes[length - 1 - i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint64_t openssl_segmented_read_uint(const uint8_t *bytes, size_t length)
+{
+    uint64_t value = 0;
+    
+    for (size_t i = 0; i < length; i++) {
+        value = (value << 8) | bytes[i];
+    }
+    
+    return value;
+}
+
+static uint64_t openssl_segmented_count(uint64_t plaintext_length, uint32_t segment_size)
+{
+    /* An empty file is still represented by a single segment so that it can be authenticated */
+    if (plaintext_length == 0) {
+        return 1;
+    }
+    
+    return (plaintext_length / segment_size) + (plaintext_length % segment_size ? 1 : 0);
+}
+
+/* Segment sizes and file lengths are limited so that offsets into the encrypted file can't overflow */
+static bool openssl_segmented_header_is_valid(const openssl_segmented_header_t *header)
+{
+    /* Segments are always authenticated, AES256-GCM is currently the only supported cipher */
+    if (header->cipher.cipher_id != CIPHER_ID_AES256_GCM || header->cipher.iv_len < sizeof(uint64_t)) {
+        return false;
+    }
+    
+    if (header->segment_size < OPENSSL_FILE_SEGMENTED_MIN_SEGMENT_SIZE ||
+        header->segment_size > OPENSSL_FILE_SEGMENTED_MAX_SEGMENT_SIZE) {
+        return false;
+    }
+    
+    return header->plaintext_length <= OPENSSL_FILE_SEGMENTED_MAX_LENGTH;
+}
+
+static bool openssl_segmented_header_init(openssl_segmented_header_t *header,
+                                          wickr_cipher_t cipher,
+                                          uint32_t segment_size,
+                                          uint64_t plaintext_length,
+                                          const uint8_t *nonce)
+{
+    header->cipher = cipher;
+    header->segment_size = segment_size;
+    header->plaintext_length = plaintext_length;
+    
+    if (!openssl_segmented_header_is_valid(header)) {
+        return false;
+    }
+    
+    header->segment_count = openssl_segmented_count(plaintext_length, segment_size);
+    
+    /* magic | version | cipher id | segment size | plaintext length | file nonce */
+    uint8_t *pos = header->bytes;
+    memcpy(pos, OPENSSL_FILE_SEGMENTED_MAGIC, OPENSSL_FILE_SEGMENTED_MAGIC_LEN);
+    pos += OPENSSL_FILE_SEGMENTED_MAGIC_LEN;
+    *pos++ = OPENSSL_FILE_SEGMENTED_VERSION;
+    *pos++ = cipher.cipher_id;
+    openssl_segmented_write_uint(pos, segment_size, sizeof(uint32_t));
+    pos += sizeof(uint32_t);
+    openssl_segmented_write_uint(pos, plaintext_length, sizeof(uint64_t));
+    pos += sizeof(uint64_t);
+    memcpy(pos, nonce, cipher.iv_len);
+    pos += cipher.iv_len;
+    
+    header->length = (size_t)(pos - header->bytes);
+    
+    return true;
+}
+
+static bool openssl_segmented_header_read(FILE *handle, openssl_segmented_header_t *header)
+{
+    uint8_t fixed[OPENSSL_FILE_SEGMENTED_HEADER_FIXED_LEN];
+    
+    if (fread(fixed, 1, sizeof(fixed), handle) != sizeof(fixed)) {
+        return false;
+    }
+    
+    if (memcmp(fixed, OPENSSL_FILE_SEGMENTED_MAGIC, OPENSSL_FILE_SEGMENTED_MAGIC_LEN) != 0) {
+        return false;
+    }
+    
+    const uint8_t *pos = fixed + OPENSSL_FILE_SEGMENTED_MAGIC_LEN;
+    
+    if (*pos++ != OPENSSL_FILE_SEGMENTED_VERSION) {
+        return false;
+    }
+    
+    const wickr_cipher_t *cipher = wickr_cipher_find(*pos++);
+    
+    if (!cipher) {
+        return false;
+    }
+    
+    uint32_t segment_size = (uint32_t)openssl_segmented_read_uint(pos, sizeof(uint32_t));
+    pos += sizeof(uint32_t);
+    uint64_t plaintext_length = openssl_segmented_read_uint(pos, sizeof(uint64_t));
+    
+    if (cipher->iv_len > OPENSSL_FILE_SEGMENTED_HEADER_MAX_LEN - OPENSSL_FILE_SEGMENTED_HEADER_FIXED_LEN) {
+        return false;
+    }
+    
+    uint8_t nonce[OPENSSL_FILE_SEGMENTED_HEADER_MAX_LEN - OPENSSL_FILE_SEGMENTED_HEADER_FIXED_LEN];
+    
+    if (fread(nonce, 1, cipher->iv_len, handle) != cipher->iv_len) {
+        return false;
+    }
+    
+    return openssl_segmented_header_init(header, *cipher, segment_size, plaintext_length, nonce);
+}
+
+static uint64_t openssl_segmented_plaintext_offset(const openssl_segmented_header_t *header, uint64_t segment)
+{
+    return segment * header->segment_size;
+}
+
+static size_t openssl_segmented_plaintext_len(const openssl_segmented_header_t *header, uint64_t segment)
+{
+    uint64_t remaining = header->plaintext_length - openssl_segmented_plaintext_offset(header, segment);
+    return (size_t)(remaining < header->segment_size ? remaining : header->segment_size);
+}
+
+static uint64_t openssl_segmented_cipher_offset(const openssl_segmented_header_t *header, uint64_t segment)
+{
+    return header->length + segment * ((uint64_t)header->segment_size + header->cipher.auth_tag_len);
+}
+
+static uint64_t openssl_segmented_file_length(const openssl_segmented_header_t *header)
+{
+    return openssl_segmented_cipher_offset(header, header->segment_count - 1) +
+           openssl_segmented_plaintext_len(header, header->segment_count - 1) + header->cipher.auth_tag_len;
+}
+
+/*
+ Encrypt or decrypt a single segment. The nonce is the file nonce with the segment index xored into its last 8 bytes,
+ and the header is authenticated along with the segment index. Since the header contains the plaintext length, the number of
+ segments in the file is authenticated by every segment, and truncating, extending or reordering segments fails to decrypt
+ */
+static bool openssl_segmented_crypt(EVP_CIPHER_CTX *ctx,
+                                    const openssl_segmented_header_t *header,
+                                    const wickr_cipher_key_t *key,
+                                    uint64_t segment,
+                                    bool is_encrypt,
+                                    const uint8_t *input,
+                                    size_t input_len,
+                                    uint8_t *output,
+                                    uint8_t *tag)
+{
+    if (key->key_data->length != header->cipher.key_len) {
+        return false;
+    }
+    
+    size_t nonce_len = header->cipher.iv_len;
+    uint8_t nonce[OPENSSL_FILE_SEGMENTED_HEADER_MAX_LEN];
+    memcpy(nonce, header->bytes + header->length - nonce_len, nonce_len);
+    
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+        nonce[nonce_len - 1 - i] ^= (uint8_t)(segment >> (8 * i));
+    }
+    
+    uint8_t segment_bytes[sizeof(uint64_t)];
+    openssl_segmented_write_uint(segment_bytes, segment, sizeof(segment_bytes));
+    
+    int out_len = 0;
+    int final_len = 0;
+    
+    if (1 != EVP_CipherInit_ex(ctx, EVP_aes_256_gcm(), NULL, NULL, NULL, is_encrypt ? 1 : 0)) {
+        return false;
+    }
+    
+    if (1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, (int)nonce_len, NULL)) {
+        return false;
+    }
+    
+    if (1 != EVP_CipherInit_ex(ctx, NULL, NULL, key->key_data->bytes, nonce, is_encrypt ? 1 : 0)) {
+        return false;
+    }
+    
+    if (1 != EVP_CipherUpdate(ctx, NULL, &out_len, header->bytes, (int)header->length) ||
+        1 != EVP_CipherUpdate(ctx, NULL, &out_len, segment_bytes, sizeof(segment_bytes))) {
+        return false;
+    }
+    
+    if (input_len > 0 && 1 != EVP_CipherUpdate(ctx, output, &out_len, input, (int)input_len)) {
+        return false;
+    }
+    
+    if (!is_encrypt && 1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, header->cipher.auth_tag_len, tag)) {
+        return false;
+    }
+    
+    if (1 != EVP_CipherFinal_ex(ctx, output + (input_len > 0 ? out_len : 0), &final_len)) {
+        return false;
+    }
+    
+    if (is_encrypt && 1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, header->cipher.auth_tag_len, tag)) {
+        return false;
+    }
+    
+    return true;
+}
+
+/* Process a contiguous run of segments using independent file handles, so that jobs can run in parallel */
+static void *openssl_segmented_job_run(void *arg)
+{
+    openssl_segmented_job_t *job = arg;
+    const openssl_segmented_header_t *header = job->header;
+    
+    job->success = false;
+    
+    size_t tag_len = header->cipher.auth_tag_len;
+    size_t buffer_len = header->segment_size + tag_len;
+    
+    FILE *source = openssl_file_open(job->source, "rb");
+    FILE *destination = openssl_file_open(job->destination, "r+b");
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    uint8_t *input = wickr_alloc(buffer_len);
+    uint8_t *output = wickr_alloc(buffer_len);
+    
+    if (!source || !destination || !ctx || !input || !output) {
+        goto process_done;
+    }
+    
+    uint64_t read_offset = job->is_encrypt ? openssl_segmented_plaintext_offset(header, job->first_segment) :
+                                             openssl_segmented_cipher_offset(header, job->first_segment);
+    uint64_t write_offset = job->is_encrypt ? openssl_segmented_cipher_offset(header, job->first_segment) :
+                                              openssl_segmented_plaintext_offset(header, job->first_segment);
+    
+    if (!openssl_file_seek(source, read_offset) || !openssl_file_seek(destination, write_offset)) {
+        goto process_done;
+    }
+    
+    for (uint64_t segment = job->first_segment; segment < job->end_segment; segment++) {
+        size_t plain_len = openssl_segmented_plaintext_len(header, segment);
+        
+        if (job->is_encrypt) {
+            if (fread(input, 1, plain_len, source) != plain_len) {
+                goto process_done;
+            }
+            
+            if (!openssl_segmented_crypt(ctx, header, job->key, segment, true, input, plain_len, output, output + plain_len)) {
+                goto process_done;
+            }
+            
+            if (fwrite(output, 1, plain_len + tag_len, destination) != plain_len + tag_len) {
+                goto process_done;
+            }
+        }
+        else {
+            if (fread(input, 1, plain_len + tag_len, source) != plain_len + tag_len) {
+                goto process_done;
+            }
+            
+            if (!openssl_segmented_crypt(ctx, header, job->key, segment, false, input, plain_len, output, input + plain_len)) {
+                goto process_done;
+            }
+            
+            if (fwrite(output, 1, plain_len, destination) != plain_len) {
+                goto process_done;
+            }
+        }
+    }
+    
+    job->success = fflush(destination) == 0;
+    
+process_done:
+    if (source) {
+        fclose(source);
+    }
+    if (destination) {
+        fclose(destination);
+    }
+    if (ctx) {
+        EVP_CIPHER_CTX_free(ctx);
+    }
+    if (input) {
+        wickr_free(input);
+    }
+    if (output) {
+        OPENSSL_cleanse(output, buffer_len);
+        wickr_free(output);
+    }
+    
+    return NULL;
+}
+
+/* Split the segments of a file into contiguous runs and process each run on its own thread */
+static bool openssl_segmented_run_jobs(const openssl_segmented_header_t *header,
+                                       const wickr_cipher_key_t *key,
+                                       const char *source,
+                                       const char *destination,
+                                       uint32_t thread_count,
+                                       bool is_encrypt)
+{
+    if (thread_count == 0) {
+        thread_count = 1;
+    }
+    
+    if (thread_count > OPENSSL_FILE_SEGMENTED_MAX_THREADS) {
+        thread_count = OPENSSL_FILE_SEGMENTED_MAX_THREADS;
+    }
+    
+    if (thread_count > header->segment_count) {
+        thread_count = (uint32_t)header->segment_count;
+    }
+    
+    openssl_segmented_job_t jobs[OPENSSL_FILE_SEGMENTED_MAX_THREADS];
+    wickr_thread_t threads[OPENSSL_FILE_SEGMENTED_MAX_THREADS];
+    bool is_started[OPENSSL_FILE_SEGMENTED_MAX_THREADS];
+    
+    uint64_t per_job = header->segment_count / thread_count;
+    uint64_t remainder = header->segment_count % thread_count;
+    uint64_t next_segment = 0;
+    
+    for (uint32_t i = 0; i < thread_count; i++) {
+        uint64_t job_count = per_job + (i < remainder ? 1 : 0);
+        
+        jobs[i].header = header;
+        jobs[i].key = key;
+        jobs[i].source = source;
+        jobs[i].destination = destination;
+        jobs[i].first_segment = next_segment;
+        jobs[i].end_segment = next_segment + job_count;
+        jobs[i].is_encrypt = is_encrypt;
+        jobs[i].success = false;
+        
+        next_segment += job_count;
+    }
+    
+    /* The first job runs on the calling thread. If a thread can't be started its job runs on the calling thread as well */
+    for (uint32_t i = 1; i < thread_count; i++) {
+        is_started[i] = wickr_thread_create(&threads[i], openssl_segmented_job_run, &jobs[i]);
+    }
+    
+    openssl_segmented_job_run(&jobs[0]);
+    
+    bool success = jobs[0].success;
+    
+    for (uint32_t i = 1; i < thread_count; i++) {
+        if (is_started[i]) {
+            wickr_thread_join(threads[i]);
+        }
+        else {
+            openssl_segmented_job_run(&jobs[i]);
+        }
+        success = success && jobs[i].success;
+    }
+    
+    return success;
+}
+
+bool openssl_aes256_file_encrypt_segmented(const wickr_cipher_key_t *key,
+                                           const char *sourceFilePath,
+                                           const char *destinationFilePath,
+                                           uint32_t segment_size,
+                                           uint32_t thread_count)
+{
+    if (!key || !key->key_data || !sourceFilePath || !destinationFilePath) {
+        return false;
+    }
+    
+    AESFileOperation *fileOp = createFileOperation(sourceFilePath, destinationFilePath);
+    
+    if (!fileOp) {
+        return false;
+    }
+    
+    bool result = false;
+    uint64_t plaintext_length = 0;
+    openssl_segmented_header_t header;
+    
+    wickr_buffer_t *nonce = openssl_crypto_random(key->cipher.iv_len);
+    
+    if (!nonce || !openssl_file_length(fileOp->sourceHandle, &plaintext_length)) {
+        goto process_done;
+    }
+    
+    if (!openssl_segmented_header_init(&header, key->cipher, segment_size, plaintext_length, nonce->bytes)) {
+        goto process_done;
+    }
+    
+    /* Write the header, and close the handles so that each job can open its own */
+    if (fwrite(header.bytes, 1, header.length, fileOp->destinationHandle) != header.length) {
+        goto process_done;
+    }
+    
+    aesFileOpCloseSourceAndDestination(fileOp);
+    
+    result = openssl_segmented_run_jobs(&header, key, sourceFilePath, fileOp->tempPath, thread_count, true);
+    
+    if (result) {
+        result = aesFileOpMoveTempToDestination(fileOp);
+    }
+    
+process_done:
+    wickr_buffer_destroy(&nonce);
+    freeFileOperation(&fileOp);
+    
+    return result;
+}
+
+bool openssl_aes256_file_decrypt_segmented(const wickr_cipher_key_t *key,
+                                           const char *sourceFilePath,
+                                           const char *destinationFilePath,
+                                           uint32_t thread_count)
+{
+    if (!key || !key->key_data || !sourceFilePath || !destinationFilePath) {
+        return false;
+    }
+    
+    AESFileOperation *fileOp = createFileOperation(sourceFilePath, destinationFilePath);
+    
+    if (!fileOp) {
+        return false;
+    }
+    
+    bool result = false;
+    uint64_t file_length = 0;
+    openssl_segmented_header_t header;
+    
+    if (!openssl_file_length(fileOp->sourceHandle, &file_length) ||
+        !openssl_segmented_header_read(fileOp->sourceHandle, &header)) {
+        goto process_done;
+    }
+    
+    /* Trailing data can't be authenticated, so the file must be exactly the size described by the header */
+    if (header.cipher.cipher_id != key->cipher.cipher_id || file_length != openssl_segmented_file_length(&header)) {
+        goto process_done;
+    }
+    
+    aesFileOpCloseSourceAndDestination(fileOp);
+    
+    result = openssl_segmented_run_jobs(&header, key, sourceFilePath, fileOp->tempPath, thread_count, false);
+    
+    if (result) {
+        result = aesFileOpMoveTempToDestination(fileOp);
+    }
+    
+process_done:
+    freeFileOperation(&fileOp);
+    
+    return result;
+}
+
+bool openssl_aes256_file_segmented_length(const char *sourceFilePath, uint64_t *length)
+{
+    if (!sourceFilePath || !length) {
+        return false;
+    }
+    
+    FILE *source = openssl_file_open(sourceFilePath, "rb");
+    
+    if (!source) {
+        return false;
+    }
+    
+    openssl_segmented_header_t header;
+    bool result = openssl_segmented_header_read(source, &header);
+    
+    if (result) {
+        *length = header.plaintext_length;
+    }
+    
+    fclose(source);
+    
+    return result;
+}
+
+wickr_buffer_t *openssl_aes256_file_decrypt_range(const wickr_cipher_key_t *key,
+                                                  const char *sourceFilePath,
+                                                  uint64_t offset,
+                                                  uint64_t length)
+{
+    if (!key || !key->key_data || !sourceFilePath || length == 0) {
+        return NULL;
+    }
+    
+    FILE *source = openssl_file_open(sourceFilePath, "rb");
+    
+    if (!source) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *range = NULL;
+    EVP_CIPHER_CTX *ctx = NULL;
+    uint8_t *input = NULL;
+    uint8_t *output = NULL;
+    size_t buffer_len = 0;
+    openssl_segmented_header_t header;
+    
+    if (!openssl_segmented_header_read(source, &header) || header.cipher.cipher_id != key->cipher.cipher_id) {
+        goto process_error;
+    }
+    
+    /* Ranges that extend past the end of the file are truncated */
+    if (offset >= header.plaintext_length) {
+        goto process_error;
+    }
+    
+    if (length > header.plaintext_length - offset) {
+        length = header.plaintext_length - offset;
+    }
+    
+    if (length > MAX_BUFFER_SIZE) {
+        goto process_error;
+    }
+    
+    buffer_len = header.segment_size + header.cipher.auth_tag_len;
+    ctx = EVP_CIPHER_CTX_new();
+    input = wickr_alloc(buffer_len);
+    output = wickr_alloc(buffer_len);
+    range = wickr_buffer_create_empty((size_t)length);
+    
+    if (!ctx || !input || !output || !range) {
+        goto process_error;
+    }
+    
+    uint64_t first_segment = offset / header.segment_size;
+    uint64_t end_segment = (offset + length - 1) / header.segment_size + 1;
+    size_t copied = 0;
+    
+    if (!openssl_file_seek(source, openssl_segmented_cipher_offset(&header, first_segment))) {
+        goto process_error;
+    }
+    
+    /* Only the segments covering the range are read and authenticated */
+    for (uint64_t segment = first_segment; segment < end_segment; segment++) {
+        size_t plain_len = openssl_segmented_plaintext_len(&header, segment);
+        size_t tag_len = header.cipher.auth_tag_len;
+        
+        if (fread(input, 1, plain_len + tag_len, source) != plain_len + tag_len) {
+            goto process_error;
+        }
+        
+        if (!openssl_segmented_crypt(ctx, &header, key, segment, false, input, plain_len, output, input + plain_len)) {
+            goto process_error;
+        }
+        
+        uint64_t segment_offset = openssl_segmented_plaintext_offset(&header, segment);
+        size_t start = segment == first_segment ? (size_t)(offset - segment_offset) : 0;
+        size_t copy_len = plain_len - start;
+        
+        if (copy_len > range->length - copied) {
+            copy_len = range->length - copied;
+        }
+        
+        memcpy(range->bytes + copied, output + start, copy_len);
+        copied += copy_len;
+    }
+    
+    goto process_done;
+    
+process_error:
+    if (range) {
+        wickr_buffer_destroy_zero(&range);
+    }
+    
+process_done:
+    fclose(source);
+    
+    if (ctx) {
+        EVP_CIPHER_CTX_free(ctx);
+    }
+    if (input) {
+        wickr_free(input);
+    }
+    if (output) {
+        OPENSSL_cleanse(output, buffer_len);
+        wickr_free(output);
+    }
+    
+    return range;
+}
+
+#pragma mark - Tree Digests
+
+typedef struct openssl_tree_job {
+    const EVP_MD *md;
+    const uint8_t *bytes;
+    uint64_t length;
+    uint64_t first_leaf;
+    uint64_t end_leaf;
+    uint8_t *leaves;
+    bool success;
+} openssl_tree_job_t;
+
+static uint32_t treeDigestThreadCount = OPENSSL_TREE_DIGEST_DEFAULT_THREADS;
+
+void openssl_sha2_tree_set_thread_count(uint32_t thread_count)
+{
+    if (thread_count == 0) {
+        thread_count = 1;
+    }
+    
+    if (thread_count > OPENSSL_TREE_DIGEST_MAX_THREADS) {
+        thread_count = OPENSSL_TREE_DIGEST_MAX_THREADS;
+    }
+    
+    treeDigestThreadCount = thread_count;
+}
+
+uint32_t openssl_sha2_tree_get_thread_count(void)
+{
+    return treeDigestThreadCount;
+}
+
+/* The digest used to hash the leaves and nodes of a tree digest */
+static const EVP_MD *openssl_tree_node_digest(wickr_digest_t mode)
+{
+    if (mode.type != DIGEST_SHA2_TREE) {
+        return NULL;
+    }
+    
+    switch (mode.digest_id) {
+        case DIGEST_ID_SHA256_TREE:
+            return EVP_sha256();
+        case DIGEST_ID_SHA512_TREE:
+            return EVP_sha512();
+        default:
+            return NULL;
+    }
+}
+
+static uint64_t openssl_tree_leaf_count(uint64_t length)
+{
+    /* Empty input is hashed as a single empty leaf */
+    if (length == 0) {
+        return 1;
+    }
+    
+    return (length + DIGEST_TREE_LEAF_SIZE - 1) / DIGEST_TREE_LEAF_SIZE;
+}
+
+/* H(prefix | first | second), where 'second' is optional */
+static bool openssl_tree_hash(EVP_MD_CTX *ctx,
+                              const EVP_MD *md,
+                              uint8_t prefix,
+                              const uint8_t *first,
+                              size_t first_len,
+                              const uint8_t *second,
+                              size_t second_len,
+                              uint8_t *output)
+{
+    if (1 != EVP_DigestInit_ex(ctx, md, NULL) || 1 != EVP_DigestUpdate(ctx, &prefix, 1)) {
+        return false;
+    }
+    
+    if (first_len > 0 && 1 != EVP_DigestUpdate(ctx, first, first_len)) {
+        return false;
+    }
+    
+    if (second && 1 != EVP_DigestUpdate(ctx, second, second_len)) {
+        return false;
+    }
+    
+    return 1 == EVP_DigestFinal_ex(ctx, output, NULL);
+}
+
+static void *openssl_tree_job_run(void *arg)
+{
+    openssl_tree_job_t *job = arg;
+    size_t digest_len = (size_t)EVP_MD_size(job->md);
+    
+    job->success = false;
+    
+    EVP_MD_CTX *ctx = EVP_MD_CTX_create();
+    
+    if (!ctx) {
+        return NULL;
+    }
+    
+    for (uint64_t leaf = job->first_leaf; leaf < job->end_leaf; leaf++) {
+        uint64_t offset = leaf * DIGEST_TREE_LEAF_SIZE;
+        size_t leaf_len = (size_t)(job->length - offset < DIGEST_TREE_LEAF_SIZE ? job->length - offset : DIGEST_TREE_LEAF_SIZE);
+        
+        if (!openssl_tree_hash(ctx, job->md, OPENSSL_TREE_LEAF_PREFIX, job->bytes + offset, leaf_len, NULL, 0,
+                               job->leaves + leaf * digest_len)) {
+            EVP_MD_CTX_destroy(ctx);
+            return NULL;
+        }
+    }
+    
+    EVP_MD_CTX_destroy(ctx);
+    job->success = true;
+    
+    return NULL;
+}
+
+/* Hash every leaf of 'bytes' into 'leaves', splitting the leaves into contiguous runs that are each hashed on their own thread */
+static bool openssl_tree_hash_leaves(const EVP_MD *md, const uint8_t *bytes, uint64_t length, uint8_t *leaves)
+{
+    uint64_t leaf_count = openssl_tree_leaf_count(length);
+    uint32_t thread_count = treeDigestThreadCount;
+    
+    if (thread_count > leaf_count) {
+        thread_count = (uint32_t)leaf_count;
+    }
+    
+    openssl_tree_job_t jobs[OPENSSL_TREE_DIGEST_MAX_THREADS];
+    wickr_thread_t threads[OPENSSL_TREE_DIGEST_MAX_THREADS];
+    bool is_started[OPENSSL_TREE_DIGEST_MAX_THREADS];
+    
+    uint64_t per_job = leaf_count / thread_count;
+    uint64_t remainder = leaf_count % thread_count;
+    uint64_t next_leaf = 0;
+    
+    for (uint32_t i = 0; i < thread_count; i++) {
+        uint64_t job_count = per_job + (i < remainder ? 1 : 0);
+        
+        jobs[i].md = md;
+        jobs[i].bytes = bytes;
+        jobs[i].length = length;
+        jobs[i].first_leaf = next_leaf;
+        jobs[i].end_leaf = next_leaf + job_count;
+        jobs[i].leaves = leaves;
+        jobs[i].success = false;
+        
+        next_leaf += job_count;
+    }
+    
+    /* The first job runs on the calling thread. If a thread can't be started its job runs on the calling thread as well */
+    for (uint32_t i = 1; i < thread_count; i++) {
+        is_started[i] = wickr_thread_create(&threads[i], openssl_tree_job_run, &jobs[i]);
+    }
+    
+    openssl_tree_job_run(&jobs[0]);
+    
+    bool success = jobs[0].success;
+    
+    for (uint32_t i = 1; i < thread_count; i++) {
+        if (is_started[i]) {
+            wickr_thread_join(threads[i]);
+        }
+        else {
+            openssl_tree_job_run(&jobs[i]);
+        }
+        success = success && jobs[i].success;
+    }
+    
+    return success;
+}
+
+/* Reduce a level of nodes to the root of the tree in place */
+static wickr_buffer_t *openssl_tree_reduce(const EVP_MD *md, uint8_t *nodes, uint64_t node_count)
+{
+    size_t digest_len = (size_t)EVP_MD_size(md);
+    
+    EVP_MD_CTX *ctx = EVP_MD_CTX_create();
+    
+    if (!ctx) {
+        return NULL;
+    }
+    
+    while (node_count > 1) {
+        for (uint64_t i = 0; i + 1 < node_count; i += 2) {
+            if (!openssl_tree_hash(ctx, md, OPENSSL_TREE_NODE_PREFIX, nodes + i * digest_len, digest_len,
+                                   nodes + (i + 1) * digest_len, digest_len, nodes + (i / 2) * digest_len)) {
+                EVP_MD_CTX_destroy(ctx);
+                return NULL;
+            }
+        }
+        
+        /* A node without a pair is promoted unchanged */
+        if (node_count % 2 == 1) {
+            memmove(nodes + (node_count / 2) * digest_len, nodes + (node_count - 1) * digest_len, digest_len);
+        }
+        
+        node_count = (node_count + 1) / 2;
+    }
+    
+    EVP_MD_CTX_destroy(ctx);
+    
+    return wickr_buffer_create(nodes, digest_len);
+}
+
+static wickr_buffer_t *openssl_tree_leaves(const EVP_MD *md, const uint8_t *bytes, uint64_t length)
+{
+    uint64_t leaf_count = openssl_tree_leaf_count(length);
+    size_t digest_len = (size_t)EVP_MD_size(md);
+    
+    if (leaf_count > SIZE_MAX / digest_len) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *leaves = wickr_buffer_create_empty((size_t)leaf_count * digest_len);
+    
+    if (!leaves) {
+        return NULL;
+    }
+    
+    if (!openssl_tree_hash_leaves(md, bytes, length, leaves->bytes)) {
+        wickr_buffer_destroy(&leaves);
+        return NULL;
+    }
+    
+    return leaves;
+}
+
+/* Read a file in batches of one leaf per thread, hashing each batch in parallel */
+static wickr_buffer_t *openssl_tree_file_leaves_stdio(const EVP_MD *md, FILE *in_file)
+{
+    size_t digest_len = (size_t)EVP_MD_size(md);
+    size_t batch_len = (size_t)treeDigestThreadCount * DIGEST_TREE_LEAF_SIZE;
+    
+    uint8_t *batch = wickr_alloc(batch_len);
+    size_t leaves_capacity = 64 * digest_len;
+    size_t leaves_len = 0;
+    uint8_t *leaves = wickr_alloc(leaves_capacity);
+    
+    wickr_buffer_t *result = NULL;
+    
+    if (!batch || !leaves) {
+        goto process_done;
+    }
+    
+    for (;;) {
+        size_t batch_read = fread(batch, 1, batch_len, in_file);
+        
+        if (ferror(in_file)) {
+            goto process_done;
+        }
+        
+        /* Empty input is a single empty leaf, otherwise an empty read at the end adds nothing */
+        if (batch_read == 0 && leaves_len > 0) {
+            break;
+        }
+        
+        size_t batch_leaves_len = (size_t)openssl_tree_leaf_count(batch_read) * digest_len;
+        
+        if (leaves_len + batch_leaves_len > leaves_capacity) {
+            size_t new_capacity = leaves_capacity * 2 + batch_leaves_len;
+            uint8_t *new_leaves = wickr_alloc(new_capacity);
+            
+            if (!new_leaves) {
+                goto process_done;
+            }
+            
+            memcpy(new_leaves, leaves, leaves_len);
+            wickr_free(leaves);
+            leaves = new_leaves;
+            leaves_capacity = new_capacity;
+        }
+        
+        if (!openssl_tree_hash_leaves(md, batch, batch_read, leaves + leaves_len)) {
+            goto process_done;
+        }
+        
+        leaves_len += batch_leaves_len;
+        
+        if (batch_read < batch_len) {
+            break;
+        }
+    }
+    
+    result = wickr_buffer_create(leaves, leaves_len);
+    
+process_done:
+    if (batch) {
+        wickr_free(batch);
+    }
+    if (leaves) {
+        wickr_free(leaves);
+    }
+    
+    return result;
+}
+
+#if OPENSSL_FILE_MMAP_SUPPORTED
+
+/* Map a regular file and hash it from its current position. Returns false without changing the file if it can't be mapped */
+static bool openssl_tree_file_leaves_mapped(const EVP_MD *md, FILE *in_file, wickr_buffer_t **leaves)
+{
+    struct stat st;
+    
+    if (fstat(fileno(in_file), &st) != 0 || !S_ISREG(st.st_mode) || (uint64_t)st.st_size > SIZE_MAX) {
+        return false;
+    }
+    
+    off_t position = ftello(in_file);
+    
+    /* Files that fit in a single leaf can't be split across threads, so mapping them has no benefit */
+    if (position < 0 || st.st_size - position <= DIGEST_TREE_LEAF_SIZE) {
+        return false;
+    }
+    
+    void *bytes = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fileno(in_file), 0);
+    
+    if (bytes == MAP_FAILED) {
+        return false;
+    }
+    
+    *leaves = openssl_tree_leaves(md, (uint8_t *)bytes + position, (uint64_t)(st.st_size - position));
+    munmap(bytes, (size_t)st.st_size);
+    
+    /* Leave the file at its end, as if it had been read */
+    fseeko(in_file, 0, SEEK_END);
+    
+    return true;
+}
+
+#endif
+
+wickr_buffer_t *openssl_sha2_tree(const wickr_buffer_t *buffer, wickr_digest_t mode)
+{
+    const EVP_MD *md = openssl_tree_node_digest(mode);
+    
+    if (!buffer || !md) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *leaves = openssl_tree_leaves(md, buffer->bytes, buffer->length);
+    
+    if (!leaves) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *root = openssl_tree_reduce(md, leaves->bytes, leaves->length / mode.size);
+    wickr_buffer_destroy(&leaves);
+    
+    return root;
+}
+
+wickr_buffer_t *openssl_sha2_tree_file_leaves(FILE *in_file, wickr_digest_t mode)
+{
+    const EVP_MD *md = openssl_tree_node_digest(mode);
+    
+    if (!in_file || !md) {
+        return NULL;
+    }
+    
+#if OPENSSL_FILE_MMAP_SUPPORTED
+    wickr_buffer_t *leaves = NULL;
+    
+    if (openssl_tree_file_leaves_mapped(md, in_file, &leaves)) {
+        return leaves;
+    }
+#endif
+    
+    return openssl_tree_file_leaves_stdio(md, in_file);
+}
+
+wickr_buffer_t *openssl_sha2_tree_file(FILE *in_file, wickr_digest_t mode)
+{
+    wickr_buffer_t *leaves = openssl_sha2_tree_file_leaves(in_file, mode);
+    
+    if (!leaves) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *root = openssl_tree_reduce(openssl_tree_node_digest(mode), leaves->bytes, leaves->length / mode.size);
+    wickr_buffer_destroy(&leaves);
+    
+    return root;
+}
+
+wickr_buffer_t *openssl_sha2_tree_root(const wickr_buffer_t *leaves, wickr_digest_t mode)
+{
+    const EVP_MD *md = openssl_tree_node_digest(mode);
+    
+    if (!leaves || !md || leaves->length % mode.size != 0) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *nodes = wickr_buffer_copy(leaves);
+    
+    if (!nodes) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *root = openssl_tree_reduce(md, nodes->bytes, nodes->length / mode.size);
+    wickr_buffer_destroy(&nodes);
+    
+    return root;
+}
+
+bool openssl_sha2_tree_verify_chunk(const wickr_buffer_t *chunk,
+                                    uint64_t index,
+                                    const wickr_buffer_t *leaves,
+                                    const wickr_buffer_t *root,
+                                    wickr_digest_t mode)
+{
+    const EVP_MD *md = openssl_tree_node_digest(mode);
+    
+    if (!chunk || !leaves || !root || !md || leaves->length % mode.size != 0) {
+        return false;
+    }
+    
+    uint64_t leaf_count = leaves->length / mode.size;
+    
+    /* Every leaf except the last is full, so the length of the chunk must match its position */
+    if (index >= leaf_count || chunk->length > DIGEST_TREE_LEAF_SIZE ||
+        (index + 1 < leaf_count && chunk->length != DIGEST_TREE_LEAF_SIZE)) {
+        return false;
+    }
+    
+    wickr_buffer_t *computed_root = openssl_sha2_tree_root(leaves, mode);
+    
+    if (!computed_root) {
+        return false;
+    }
+    
+    bool is_valid = wickr_buffer_is_equal(computed_root, root, (wickr_buffer_compare_func)CRYPTO_memcmp);
+    wickr_buffer_destroy(&computed_root);
+    
+    if (!is_valid) {
+        return false;
+    }
+    
+    uint8_t leaf[EVP_MAX_MD_SIZE];
+    EVP_MD_CTX *ctx = EVP_MD_CTX_create();
+    
+    if (!ctx) {
+        return false;
+    }
+    
+    is_valid = openssl_tree_hash(ctx, md, OPENSSL_TREE_LEAF_PREFIX, chunk->bytes, chunk->length, NULL, 0, leaf) &&
+               CRYPTO_memcmp(leaf, leaves->bytes + index * mode.size, mode.size) == 0;
+    
+    EVP_MD_CTX_destroy(ctx);
+    
+    return is_valid;
+}
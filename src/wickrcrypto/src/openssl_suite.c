@@ -1,5 +1,6 @@
 
 #include "openssl_suite.h"
+#include "openssl_file_suite.h"
 #include "memory.h"
 
 #include <openssl/rand.h>
@@ -133,7 +134,8 @@ static EVP_PKEY *__openssl_evp_ec_key_from_buffer(EC_KEY *existing,
 static wickr_buffer_t *__openssl_ec_pub_key_to_buffer(wickr_ec_curve_t curve, EC_KEY *key)
 {
     size_t key_size = i2o_ECPublicKey(key, NULL);
-    wickr_buffer_t *pub_key_data = wickr_buffer_create_empty_zero(sizeof(uint8_t) + key_size);
+    /* Public keys are copied along with every identity that holds them, so they are kept in shared storage */
+    wickr_buffer_t *pub_key_data = wickr_buffer_create_empty_shared(sizeof(uint8_t) + key_size);
     
     if (!pub_key_data) {
         return NULL;
@@ -159,7 +161,7 @@ static wickr_buffer_t *__openssl_ec_pub_key_to_buffer(wickr_ec_curve_t curve, EC
 static wickr_buffer_t *__openssl_ec_pri_key_to_buffer(EC_KEY *key)
 {
     size_t key_size = i2d_ECPrivateKey(key, NULL);
-    wickr_buffer_t *pri_key_data = wickr_buffer_create_empty_zero(key_size);
+    wickr_buffer_t *pri_key_data = wickr_buffer_create_empty_secure(key_size);
     
     if (!pri_key_data) {
         return NULL;
@@ -383,12 +385,17 @@ wickr_buffer_t *openssl_crypto_random(size_t len)
 
 wickr_cipher_key_t *openssl_cipher_key_random(wickr_cipher_t cipher)
 {
-    wickr_buffer_t *key_material = openssl_crypto_random(cipher.key_len);
+    wickr_buffer_t *key_material = wickr_buffer_create_empty_secure(cipher.key_len);
     
     if (!key_material) {
         return NULL;
     }
     
+    if (1 != RAND_bytes(key_material->bytes, (int)cipher.key_len)) {
+        wickr_buffer_destroy(&key_material);
+        return NULL;
+    }
+    
     wickr_cipher_key_t *new_key = wickr_cipher_key_create(cipher, key_material);
     
     if (!new_key) {
@@ -617,6 +624,209 @@ process_error:
     return NULL;
 }
 
+struct wickr_cipher_stream {
+    wickr_cipher_t cipher;
+    EVP_CIPHER_CTX *cipher_ctx;
+    wickr_buffer_t *iv;
+    bool is_encrypt;
+    bool is_final;
+};
+
+static wickr_cipher_stream_t *__openssl_aes256_stream_init(wickr_cipher_t cipher,
+                                                           const wickr_buffer_t *aad,
+                                                           const wickr_cipher_key_t *key,
+                                                           const wickr_buffer_t *iv,
+                                                           const wickr_buffer_t *auth_tag,
+                                                           bool is_encrypt)
+{
+    /* AAD only works if the cipher supports authentication */
+    if (aad && !cipher.is_authenticated) {
+        return NULL;
+    }
+    
+    const EVP_CIPHER *openssl_cipher = __openssl_get_cipher_mode(cipher);
+    
+    if (!openssl_cipher || key->cipher.cipher_id != cipher.cipher_id || key->key_data->length != cipher.key_len) {
+        return NULL;
+    }
+    
+    if (iv->length != cipher.iv_len || (cipher.is_authenticated && !is_encrypt && (!auth_tag || auth_tag->length != cipher.auth_tag_len))) {
+        return NULL;
+    }
+    
+    if ((aad && aad->length > INT_MAX) || (auth_tag && auth_tag->length > INT_MAX)) {
+        return NULL;
+    }
+    
+    wickr_cipher_stream_t *stream = wickr_alloc_zero(sizeof(wickr_cipher_stream_t));
+    
+    if (!stream) {
+        return NULL;
+    }
+    
+    stream->cipher = cipher;
+    stream->is_encrypt = is_encrypt;
+    stream->iv = wickr_buffer_copy(iv);
+    stream->cipher_ctx = EVP_CIPHER_CTX_new();
+    
+    if (!stream->iv || !stream->cipher_ctx) {
+        goto process_error;
+    }
+    
+    if (1 != EVP_CipherInit_ex(stream->cipher_ctx, openssl_cipher, NULL, key->key_data->bytes, iv->bytes, is_encrypt ? 1 : 0)) {
+        goto process_error;
+    }
+    
+    /* The expected tag can be set up front, it is checked when the stream is finalized */
+    if (cipher.is_authenticated && !is_encrypt) {
+        if (1 != EVP_CIPHER_CTX_ctrl(stream->cipher_ctx, EVP_CTRL_GCM_SET_TAG, (int)auth_tag->length, auth_tag->bytes)) {
+            goto process_error;
+        }
+    }
+    
+    int temp_length = 0;
+    
+    if (aad && 1 != EVP_CipherUpdate(stream->cipher_ctx, NULL, &temp_length, aad->bytes, (int)aad->length)) {
+        goto process_error;
+    }
+    
+    return stream;
+    
+process_error:
+    openssl_aes256_stream_destroy(&stream);
+    return NULL;
+}
+
+wickr_cipher_stream_t *openssl_aes256_stream_encrypt_init(const wickr_buffer_t *aad,
+                                                          const wickr_cipher_key_t *key,
+                                                          const wickr_buffer_t *iv)
+{
+    if (!key) {
+        return NULL;
+    }
+    
+    /* If an IV is not passed in, generate a random one */
+    wickr_buffer_t *iv_f = iv ? wickr_buffer_copy(iv) : openssl_crypto_random(key->cipher.iv_len);
+    
+    if (!iv_f) {
+        return NULL;
+    }
+    
+    wickr_cipher_stream_t *stream = __openssl_aes256_stream_init(key->cipher, aad, key, iv_f, NULL, true);
+    wickr_buffer_destroy(&iv_f);
+    
+    return stream;
+}
+
+wickr_cipher_stream_t *openssl_aes256_stream_decrypt_init(const wickr_cipher_result_t *header,
+                                                          const wickr_buffer_t *aad,
+                                                          const wickr_cipher_key_t *key,
+                                                          bool only_auth_ciphers)
+{
+    if (!header || !header->iv || !key) {
+        return NULL;
+    }
+    
+    if (only_auth_ciphers && !header->cipher.is_authenticated) {
+        return NULL;
+    }
+    
+    return __openssl_aes256_stream_init(header->cipher, aad, key, header->iv, header->auth_tag, false);
+}
+
+wickr_buffer_t *openssl_aes256_stream_update(wickr_cipher_stream_t *stream, const wickr_buffer_t *input)
+{
+    if (!stream || !input || stream->is_final || input->length > INT_MAX) {
+        return NULL;
+    }
+    
+    /* Supported modes do not pad, so the output is always the same length as the input */
+    wickr_buffer_t *output = wickr_buffer_create_empty(input->length);
+    
+    if (!output) {
+        return NULL;
+    }
+    
+    int output_length = 0;
+    
+    if (1 != EVP_CipherUpdate(stream->cipher_ctx, output->bytes, &output_length, input->bytes, (int)input->length) ||
+        output_length != (int)input->length) {
+        wickr_buffer_destroy_zero(&output);
+        return NULL;
+    }
+    
+    return output;
+}
+
+wickr_cipher_result_t *openssl_aes256_stream_encrypt_final(wickr_cipher_stream_t *stream)
+{
+    if (!stream || !stream->is_encrypt || stream->is_final) {
+        return NULL;
+    }
+    
+    stream->is_final = true;
+    
+    int final_length = 0;
+    
+    if (1 != EVP_EncryptFinal_ex(stream->cipher_ctx, NULL, &final_length) || final_length != 0) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *auth_tag = NULL;
+    
+    /* Extract the tag from EVP if we are using AES_GCM mode */
+    if (stream->cipher.is_authenticated) {
+        auth_tag = wickr_buffer_create_empty(stream->cipher.auth_tag_len);
+        
+        if (!auth_tag) {
+            return NULL;
+        }
+        
+        if (1 != EVP_CIPHER_CTX_ctrl(stream->cipher_ctx, EVP_CTRL_GCM_GET_TAG, stream->cipher.auth_tag_len, auth_tag->bytes)) {
+            wickr_buffer_destroy(&auth_tag);
+            return NULL;
+        }
+    }
+    
+    wickr_buffer_t *iv = wickr_buffer_copy(stream->iv);
+    wickr_cipher_result_t *result = wickr_cipher_result_create(stream->cipher, iv, NULL, auth_tag);
+    
+    if (!result) {
+        wickr_buffer_destroy(&iv);
+        wickr_buffer_destroy(&auth_tag);
+    }
+    
+    return result;
+}
+
+bool openssl_aes256_stream_decrypt_final(wickr_cipher_stream_t *stream)
+{
+    if (!stream || stream->is_encrypt || stream->is_final) {
+        return false;
+    }
+    
+    stream->is_final = true;
+    
+    int final_length = 0;
+    
+    return 1 == EVP_DecryptFinal_ex(stream->cipher_ctx, NULL, &final_length) && final_length == 0;
+}
+
+void openssl_aes256_stream_destroy(wickr_cipher_stream_t **stream)
+{
+    if (!stream || !*stream) {
+        return;
+    }
+    
+    if ((*stream)->cipher_ctx) {
+        EVP_CIPHER_CTX_free((*stream)->cipher_ctx);
+    }
+    
+    wickr_buffer_destroy(&(*stream)->iv);
+    wickr_free(*stream);
+    *stream = NULL;
+}
+
 static bool __openssl_sha2_initialize_ctx(wickr_digest_t mode, EVP_MD_CTX *c)
 {
     const EVP_MD *digest = __openssl_get_digest_mode(mode);
@@ -639,6 +849,11 @@ wickr_buffer_t *openssl_sha2(const wickr_buffer_t *buffer, const wickr_buffer_t
         return NULL;
     }
     
+    /* Tree digests don't support a salt, since it would have no defined position in the tree */
+    if (mode.type == DIGEST_SHA2_TREE) {
+        return salt ? NULL : openssl_sha2_tree(buffer, mode);
+    }
+    
     EVP_MD_CTX *c = EVP_MD_CTX_create();
     
     if (!c) {
@@ -683,6 +898,10 @@ wickr_buffer_t *openssl_sha2_file(FILE *in_file, wickr_digest_t mode)
         return NULL;
     }
     
+    if (mode.type == DIGEST_SHA2_TREE) {
+        return openssl_sha2_tree_file(in_file, mode);
+    }
+    
     EVP_MD_CTX *c = EVP_MD_CTX_create();
     
     if (!c) {
@@ -733,6 +952,123 @@ wickr_buffer_t *openssl_sha2_file(FILE *in_file, wickr_digest_t mode)
     return hash_result;
 }
 
+struct wickr_digest_ctx {
+    wickr_digest_t mode;
+    EVP_MD_CTX *md_ctx;
+};
+
+wickr_digest_ctx_t *openssl_sha2_ctx_create(wickr_digest_t mode)
+{
+    EVP_MD_CTX *md_ctx = EVP_MD_CTX_create();
+    
+    if (!md_ctx) {
+        return NULL;
+    }
+    
+    if (!__openssl_sha2_initialize_ctx(mode, md_ctx)) {
+        EVP_MD_CTX_destroy(md_ctx);
+        return NULL;
+    }
+    
+    wickr_digest_ctx_t *ctx = wickr_alloc_zero(sizeof(wickr_digest_ctx_t));
+    
+    if (!ctx) {
+        EVP_MD_CTX_destroy(md_ctx);
+        return NULL;
+    }
+    
+    ctx->mode = mode;
+    ctx->md_ctx = md_ctx;
+    
+    return ctx;
+}
+
+bool openssl_sha2_ctx_update(wickr_digest_ctx_t *ctx, const wickr_buffer_t *buffer)
+{
+    if (!ctx || !buffer) {
+        return false;
+    }
+    
+    return 1 == EVP_DigestUpdate(ctx->md_ctx, buffer->bytes, buffer->length);
+}
+
+wickr_buffer_t *openssl_sha2_ctx_final(const wickr_digest_ctx_t *ctx)
+{
+    if (!ctx) {
+        return NULL;
+    }
+    
+    /* Finalize a copy of the state so that the caller can continue to add data to ctx */
+    EVP_MD_CTX *c = EVP_MD_CTX_create();
+    
+    if (!c) {
+        return NULL;
+    }
+    
+    if (1 != EVP_MD_CTX_copy_ex(c, ctx->md_ctx)) {
+        EVP_MD_CTX_destroy(c);
+        return NULL;
+    }
+    
+    wickr_buffer_t *hash_result = wickr_buffer_create_empty_zero(ctx->mode.size);
+    
+    if (!hash_result) {
+        EVP_MD_CTX_destroy(c);
+        return NULL;
+    }
+    
+    if (1 != EVP_DigestFinal_ex(c, hash_result->bytes, NULL)) {
+        wickr_buffer_destroy(&hash_result);
+        EVP_MD_CTX_destroy(c);
+        return NULL;
+    }
+    
+    EVP_MD_CTX_destroy(c);
+    
+    return hash_result;
+}
+
+wickr_digest_ctx_t *openssl_sha2_ctx_copy(const wickr_digest_ctx_t *ctx)
+{
+    if (!ctx) {
+        return NULL;
+    }
+    
+    EVP_MD_CTX *md_ctx = EVP_MD_CTX_create();
+    
+    if (!md_ctx) {
+        return NULL;
+    }
+    
+    if (1 != EVP_MD_CTX_copy_ex(md_ctx, ctx->md_ctx)) {
+        EVP_MD_CTX_destroy(md_ctx);
+        return NULL;
+    }
+    
+    wickr_digest_ctx_t *copy = wickr_alloc_zero(sizeof(wickr_digest_ctx_t));
+    
+    if (!copy) {
+        EVP_MD_CTX_destroy(md_ctx);
+        return NULL;
+    }
+    
+    copy->mode = ctx->mode;
+    copy->md_ctx = md_ctx;
+    
+    return copy;
+}
+
+void openssl_sha2_ctx_destroy(wickr_digest_ctx_t **ctx)
+{
+    if (!ctx || !*ctx) {
+        return;
+    }
+    
+    EVP_MD_CTX_destroy((*ctx)->md_ctx);
+    wickr_free(*ctx);
+    *ctx = NULL;
+}
+
 wickr_ec_key_t *openssl_ec_rand_key(wickr_ec_curve_t curve)
 {
     /* Find the proper curve */
@@ -1650,3 +1986,40 @@ wickr_buffer_t *openssl_hkdf(const wickr_buffer_t *input_key_material, const wic
     
     return out_buffer;
 }
+
+wickr_buffer_t *openssl_pbkdf2(const wickr_buffer_t *passphrase,
+                               const wickr_buffer_t *salt,
+                               uint32_t iterations,
+                               wickr_digest_t hash_mode,
+                               size_t output_len)
+{
+    if (!passphrase || !salt || iterations == 0 || output_len == 0) {
+        return NULL;
+    }
+    
+    if (passphrase->length > INT_MAX || salt->length > INT_MAX || iterations > INT_MAX || output_len > INT_MAX) {
+        return NULL;
+    }
+    
+    const EVP_MD *openssl_digest = __openssl_get_digest_mode(hash_mode);
+    
+    if (!openssl_digest) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *out_buffer = wickr_buffer_create_empty_zero(output_len);
+    
+    if (!out_buffer) {
+        return NULL;
+    }
+    
+    if (1 != PKCS5_PBKDF2_HMAC((const char *)passphrase->bytes, (int)passphrase->length,
+                               salt->bytes, (int)salt->length, (int)iterations,
+                               openssl_digest, (int)output_len, out_buffer->bytes))
+    {
+        wickr_buffer_destroy_zero(&out_buffer);
+        return NULL;
+    }
+    
+    return out_buffer;
+}
@@ -1,6 +1,7 @@
 
 #include "payload.h"
 #include "memory.h"
+#include "private/proto_arena_priv.h"
 #include "message.pb-c.h"
 
 wickr_payload_t *wickr_payload_create(wickr_packet_meta_t *meta, wickr_buffer_t *body)
@@ -112,9 +113,13 @@ wickr_payload_t *wickr_payload_create_from_buffer(const wickr_buffer_t *buffer)
         return NULL;
     }
     
-    Wickr__Proto__Payload *proto_payload = wickr__proto__payload__unpack(NULL, buffer->length, buffer->bytes);
+    wickr_proto_arena_t proto_arena;
+    wickr_proto_arena_init(&proto_arena);
+    
+    Wickr__Proto__Payload *proto_payload = wickr__proto__payload__unpack(&proto_arena.allocator, buffer->length, buffer->bytes);
     
     if (!proto_payload) {
+        wickr_proto_arena_release(&proto_arena);
         return NULL;
     }
     
@@ -128,7 +133,7 @@ wickr_payload_t *wickr_payload_create_from_buffer(const wickr_buffer_t *buffer)
     wickr_buffer_t *channel_tag = wickr_buffer_create(proto_meta->channel_tag.data, proto_meta->channel_tag.len);
     
     if (!channel_tag) {
-        wickr__proto__payload__free_unpacked(proto_payload, NULL);
+        wickr_proto_arena_release(&proto_arena);
         return NULL;
     }
     
@@ -138,12 +143,12 @@ wickr_payload_t *wickr_payload_create_from_buffer(const wickr_buffer_t *buffer)
     
     if (!meta) {
         wickr_buffer_destroy(&channel_tag);
-        wickr__proto__payload__free_unpacked(proto_payload, NULL);
+        wickr_proto_arena_release(&proto_arena);
         return NULL;
     }
     
     wickr_buffer_t *body = wickr_buffer_create(proto_payload->body.data, proto_payload->body.len);
-    wickr__proto__payload__free_unpacked(proto_payload, NULL);
+    wickr_proto_arena_release(&proto_arena);
     
     if (!body) {
         wickr_buffer_destroy(&channel_tag);
@@ -0,0 +1,127 @@
+
+#include "private/proto_arena_priv.h"
+#include "memory.h"
+
+#include <string.h>
+
+/* Proto arena allocations are aligned the same way as malloc on 64bit platforms */
+#define PROTO_ARENA_ALIGNMENT 16
+
+typedef struct wickr_proto_arena_block {
+    struct wickr_proto_arena_block *next;
+    size_t size;
+    size_t used;
+} wickr_proto_arena_block_t;
+
+/* Returns the aligned address inside [base + used, base + size) that fits 'len' bytes, and advances 'used' past it */
+static void *__wickr_proto_arena_bump(uint8_t *base, size_t size, size_t *used, size_t len)
+{
+    uintptr_t start = (uintptr_t)(base + *used);
+    size_t padding = (size_t)(-start & (PROTO_ARENA_ALIGNMENT - 1));
+    
+    if (padding > size - *used || len > size - *used - padding) {
+        return NULL;
+    }
+    
+    void *buf = base + *used + padding;
+    *used += padding + len;
+    
+    return buf;
+}
+
+static uint8_t *__wickr_proto_arena_block_data(wickr_proto_arena_block_t *block)
+{
+    return (uint8_t *)(block + 1);
+}
+
+static void *__wickr_proto_arena_alloc(void *allocator_data, size_t len)
+{
+    wickr_proto_arena_t *arena = allocator_data;
+    
+    void *buf = __wickr_proto_arena_bump(arena->stack, sizeof(arena->stack), &arena->stack_used, len);
+    
+    if (buf) {
+        return buf;
+    }
+    
+    wickr_proto_arena_block_t *head = arena->blocks;
+    
+    if (head) {
+        buf = __wickr_proto_arena_bump(__wickr_proto_arena_block_data(head), head->size, &head->used, len);
+    
+        if (buf) {
+            return buf;
+        }
+    }
+    
+    if (len > SIZE_MAX - sizeof(wickr_proto_arena_block_t) - PROTO_ARENA_ALIGNMENT) {
+        return NULL;
+    }
+    
+    /* Room for alignment padding is included, since wickr_alloc may hand out memory from an arena scope */
+    size_t block_size = len + PROTO_ARENA_ALIGNMENT;
+    
+    if (block_size < WICKR_PROTO_ARENA_BLOCK_SIZE) {
+        block_size = WICKR_PROTO_ARENA_BLOCK_SIZE;
+    }
+    
+    wickr_proto_arena_block_t *block = wickr_alloc(sizeof(wickr_proto_arena_block_t) + block_size);
+    
+    if (!block) {
+        return NULL;
+    }
+    
+    block->size = block_size;
+    block->used = 0;
+    
+    /* Oversized blocks go behind the current block, so the current block keeps serving small allocations */
+    if (head && block_size > WICKR_PROTO_ARENA_BLOCK_SIZE) {
+        block->next = head->next;
+        head->next = block;
+    }
+    else {
+        block->next = head;
+        arena->blocks = block;
+    }
+    
+    return __wickr_proto_arena_bump(__wickr_proto_arena_block_data(block), block->size, &block->used, len);
+}
+
+static void __wickr_proto_arena_free(void *allocator_data, void *pointer)
+{
+    /* Everything is released together by wickr_proto_arena_release */
+    (void)allocator_data;
+    (void)pointer;
+}
+
+void wickr_proto_arena_init(wickr_proto_arena_t *arena)
+{
+    if (!arena) {
+        return;
+    }
+    
+    arena->allocator.alloc = __wickr_proto_arena_alloc;
+    arena->allocator.free = __wickr_proto_arena_free;
+    arena->allocator.allocator_data = arena;
+    arena->blocks = NULL;
+    arena->stack_used = 0;
+}
+
+void wickr_proto_arena_release(wickr_proto_arena_t *arena)
+{
+    if (!arena) {
+        return;
+    }
+    
+    wickr_proto_arena_block_t *block = arena->blocks;
+    
+    while (block) {
+        wickr_proto_arena_block_t *next = block->next;
+        wickr_free_zero(block, sizeof(wickr_proto_arena_block_t) + block->used);
+        block = next;
+    }
+    
+    wickr_secure_zero(arena->stack, arena->stack_used);
+    arena->blocks = NULL;
+    arena->stack_used = 0;
+}
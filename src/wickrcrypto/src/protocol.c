@@ -1,6 +1,9 @@
 
 #include "protocol.h"
+#include "buffer_writer.h"
 #include "memory.h"
+#include "arena.h"
+#include "private/proto_arena_priv.h"
 #include "message.pb-c.h"
 #include "ecdh_cipher_ctx.h"
 
@@ -23,8 +26,16 @@ static wickr_buffer_t *__wickr_key_exchange_get_kdf_info(const wickr_identity_ch
         case 3:
         case 4:
         {
-            wickr_buffer_t *info_buffers[] = { sender->root->sig_key->pub_data, receiver->id_chain->root->sig_key->pub_data, receiver->dev_id };
-            return wickr_buffer_concat_multi(info_buffers, BUFFER_ARRAY_LEN(info_buffers));
+            const wickr_buffer_t *sender_root_key = sender->root->sig_key->pub_data;
+            const wickr_buffer_t *receiver_root_key = receiver->id_chain->root->sig_key->pub_data;
+            
+            wickr_buffer_writer_t writer;
+            wickr_buffer_writer_init(&writer, sender_root_key->length + receiver_root_key->length + receiver->dev_id->length);
+            wickr_buffer_writer_append_buffer(&writer, sender_root_key);
+            wickr_buffer_writer_append_buffer(&writer, receiver_root_key);
+            wickr_buffer_writer_append_buffer(&writer, receiver->dev_id);
+            
+            return wickr_buffer_writer_finish(&writer);
         }
             break;
         default:
@@ -256,40 +267,55 @@ wickr_packet_t *wickr_packet_create(uint8_t version, wickr_buffer_t *content, wi
     return new_packet;
 }
 
+/* Packet content is a protocol buffer message holding two length delimited fields, enc_header = 1 and enc_payload = 2 */
+#define PACKET_PROTO_ENC_HEADER_TAG 0x0A
+#define PACKET_PROTO_ENC_PAYLOAD_TAG 0x12
+
+static size_t __wickr_packet_proto_field_size(size_t len)
+{
+    return sizeof(uint8_t) + wickr_buffer_writer_varint_size(len) + len;
+}
+
+static bool __wickr_packet_proto_field_write(wickr_buffer_writer_t *writer, uint8_t tag, const wickr_cipher_result_t *result, size_t len)
+{
+    wickr_buffer_writer_append_u8(writer, tag);
+    wickr_buffer_writer_append_varint(writer, len);
+    
+    return wickr_cipher_result_serialize_into(result, writer);
+}
+
 wickr_packet_t *wickr_packet_create_with_components(const wickr_crypto_engine_t *engine, const wickr_cipher_result_t *enc_header, const wickr_cipher_result_t *enc_payload, const wickr_ec_key_t *signing_key, uint8_t version)
 {
     if (!engine || !enc_payload || !signing_key) {
         return NULL;
     }
     
-    Wickr__Proto__Packet proto_packet = WICKR__PROTO__PACKET__INIT;
-    
-    wickr_buffer_t *enc_header_bytes = wickr_cipher_result_serialize(enc_header);
+    size_t enc_header_len = wickr_cipher_result_serialized_size(enc_header);
+    size_t enc_payload_len = wickr_cipher_result_serialized_size(enc_payload);
     
-    if (!enc_header_bytes) {
+    if (enc_header_len == 0 || enc_payload_len == 0) {
         return NULL;
     }
     
-    wickr_buffer_t *enc_payload_bytes = wickr_cipher_result_serialize(enc_payload);
+    size_t packet_size = __wickr_packet_proto_field_size(enc_header_len) + __wickr_packet_proto_field_size(enc_payload_len);
     
-    proto_packet.enc_header.data = enc_header_bytes->bytes;
-    proto_packet.enc_header.len = enc_header_bytes->length;
-    proto_packet.enc_payload.data = enc_payload_bytes->bytes;
-    proto_packet.enc_payload.len = enc_payload_bytes->length;
-    
-    size_t packet_size = wickr__proto__packet__get_packed_size(&proto_packet);
-    
-    wickr_buffer_t *result_buffer = wickr_buffer_create_empty(packet_size);
+    /* Packet content is immutable once it is signed, so copies of the packet share it */
+    wickr_buffer_t *result_buffer = wickr_buffer_create_empty_shared(packet_size);
     
     if (!result_buffer) {
-        wickr_buffer_destroy(&enc_header_bytes);
-        wickr_buffer_destroy(&enc_payload_bytes);
         return NULL;
     }
     
-    wickr__proto__packet__pack(&proto_packet, result_buffer->bytes);
-    wickr_buffer_destroy(&enc_header_bytes);
-    wickr_buffer_destroy(&enc_payload_bytes);
+    /* The cipher results are serialized straight into the packet, producing the same bytes as packing a Wickr__Proto__Packet */
+    wickr_buffer_writer_t writer;
+    wickr_buffer_writer_init_fixed(&writer, result_buffer);
+    __wickr_packet_proto_field_write(&writer, PACKET_PROTO_ENC_HEADER_TAG, enc_header, enc_header_len);
+    __wickr_packet_proto_field_write(&writer, PACKET_PROTO_ENC_PAYLOAD_TAG, enc_payload, enc_payload_len);
+    
+    if (wickr_buffer_writer_finish_fixed(&writer) != packet_size) {
+        wickr_buffer_destroy(&result_buffer);
+        return NULL;
+    }
     
     wickr_digest_t digest_type = wickr_digest_matching_curve(signing_key->curve);
     wickr_ecdsa_result_t *signature = engine->wickr_crypto_engine_ec_sign(signing_key, result_buffer, digest_type);
@@ -349,8 +375,10 @@ wickr_packet_t *wickr_packet_create_from_buffer(const wickr_buffer_t *buffer)
     size_t signature_start = buffer->length - curve->signature_size;
     
     wickr_buffer_t sig_buffer;
-    sig_buffer.length = curve->signature_size;
-    sig_buffer.bytes = buffer->bytes + signature_start;
+    
+    if (!wickr_buffer_view(buffer, signature_start, curve->signature_size, &sig_buffer)) {
+        return NULL;
+    }
     
     wickr_digest_t digest = wickr_digest_matching_curve(*curve);
     
@@ -362,7 +390,8 @@ wickr_packet_t *wickr_packet_create_from_buffer(const wickr_buffer_t *buffer)
         return NULL;
     }
     
-    wickr_buffer_t *content_buffer = wickr_buffer_copy_section(buffer, PACKET_META_SIZE, buffer->length - curve->signature_size - PACKET_META_SIZE);
+    /* 'buffer' may be a view, so the content is copied into new shared storage rather than shared from it */
+    wickr_buffer_t *content_buffer = wickr_buffer_create_shared(buffer->bytes + PACKET_META_SIZE, buffer->length - curve->signature_size - PACKET_META_SIZE);
     
     if (!content_buffer) {
         wickr_ecdsa_result_destroy(&signature);
@@ -400,15 +429,15 @@ wickr_buffer_t *wickr_packet_serialize(const wickr_packet_t *packet)
         return NULL;
     }
     
-    wickr_buffer_t version_buffer = { sizeof(uint8_t), &version };
-    wickr_buffer_t meta_buffer = { sizeof(uint8_t), &meta_data };
-    
-    wickr_buffer_t *components[] = { &version_buffer, &meta_buffer, packet->content, sig_data };
-    
-    wickr_buffer_t *serialized_packet = wickr_buffer_concat_multi(components, BUFFER_ARRAY_LEN(components));
+    wickr_buffer_writer_t writer;
+    wickr_buffer_writer_init(&writer, PACKET_META_SIZE + packet->content->length + sig_data->length);
+    wickr_buffer_writer_append_u8(&writer, version);
+    wickr_buffer_writer_append_u8(&writer, meta_data);
+    wickr_buffer_writer_append_buffer(&writer, packet->content);
+    wickr_buffer_writer_append_buffer(&writer, sig_data);
     wickr_buffer_destroy(&sig_data);
     
-    return serialized_packet;
+    return wickr_buffer_writer_finish(&writer);
 }
 
 wickr_packet_t *wickr_packet_copy(const wickr_packet_t *source)
@@ -417,7 +446,7 @@ wickr_packet_t *wickr_packet_copy(const wickr_packet_t *source)
         return NULL;
     }
     
-    wickr_buffer_t *content_copy = wickr_buffer_copy(source->content);
+    wickr_buffer_t *content_copy = wickr_buffer_share(source->content);
     
     if (!content_copy) {
         return NULL;
@@ -458,7 +487,10 @@ static wickr_parse_result_t *__wickr_parse_result_create(wickr_key_exchange_set_
                                                          wickr_packet_signature_status sig_status,
                                                          wickr_decode_error error)
 {
+    /* Parse results are returned to callers of wickr_ctx, so they are never placed in an arena scope */
+    wickr_arena_t *arena = wickr_arena_suspend();
     wickr_parse_result_t *new_result = wickr_alloc_zero(sizeof(wickr_parse_result_t));
+    wickr_arena_resume(arena);
     
     if (!new_result) {
         return NULL;
@@ -519,8 +551,10 @@ void wickr_parse_result_destroy(wickr_parse_result_t **result)
 
 static wickr_decode_result_t *__wickr_decode_result_create(wickr_decode_error decode_error, wickr_payload_t *decrypted_payload, wickr_cipher_key_t *payload_key)
 {
-    
+    /* Decode results are returned to callers of wickr_ctx, so they are never placed in an arena scope */
+    wickr_arena_t *arena = wickr_arena_suspend();
     wickr_decode_result_t *result = wickr_alloc_zero(sizeof(wickr_decode_result_t));
+    wickr_arena_resume(arena);
     
     if (!result) {
         return NULL;
@@ -652,7 +686,11 @@ wickr_packet_t *wickr_packet_create_from_components(const wickr_crypto_engine_t
         return NULL;
     }
     
+    /* Only the packet itself outlives an arena scope the caller may have open, the exchanges and cipher results above do not */
+    wickr_arena_t *arena = wickr_arena_suspend();
     wickr_packet_t *packet = wickr_packet_create_with_components(engine, enc_header, enc_payload, sender_signing_identity->node->sig_key, version);
+    wickr_arena_resume(arena);
+    
     wickr_cipher_result_destroy(&enc_header);
     wickr_cipher_result_destroy(&enc_payload);
     
@@ -680,10 +718,14 @@ wickr_parse_result_t *wickr_parse_result_from_packet(const wickr_crypto_engine_t
         return wickr_parse_result_create_failure(PACKET_SIGNATURE_INVALID, ERROR_MAC_INVALID);
     }
     
-    Wickr__Proto__Packet *proto_packet = wickr__proto__packet__unpack(NULL, packet->content->length,
+    wickr_proto_arena_t proto_arena;
+    wickr_proto_arena_init(&proto_arena);
+    
+    Wickr__Proto__Packet *proto_packet = wickr__proto__packet__unpack(&proto_arena.allocator, packet->content->length,
                                                                       packet->content->bytes);
     
     if (!proto_packet) {
+        wickr_proto_arena_release(&proto_arena);
         return wickr_parse_result_create_failure(PACKET_SIGNATURE_VALID, ERROR_CORRUPT_PACKET);
     }
     
@@ -694,19 +736,38 @@ wickr_parse_result_t *wickr_parse_result_from_packet(const wickr_crypto_engine_t
     wickr_cipher_result_t *header_cipher_result = wickr_cipher_result_from_buffer(&temp_buffer);
     
     if (!header_cipher_result) {
-        wickr__proto__packet__free_unpacked(proto_packet, NULL);
+        wickr_proto_arena_release(&proto_arena);
         return wickr_parse_result_create_failure(PACKET_SIGNATURE_VALID, ERROR_CORRUPT_PACKET);
     }
     
     wickr_cipher_key_t *header_key = header_keygen_func(*engine, header_cipher_result->cipher, sender_signing_identity);
     
-    wickr_key_exchange_set_t *header = wickr_key_exchange_set_create_from_cipher(engine, header_cipher_result, header_key);
+    wickr_buffer_t *decrypted_header = NULL;
+    
+    if (header_key) {
+        decrypted_header = engine->wickr_crypto_engine_cipher_decrypt(header_cipher_result, NULL, header_key, true);
+    }
     
     wickr_cipher_key_destroy(&header_key);
     wickr_cipher_result_destroy(&header_cipher_result);
     
+    if (!decrypted_header) {
+        wickr_proto_arena_release(&proto_arena);
+        return wickr_parse_result_create_failure(PACKET_SIGNATURE_VALID, ERROR_CORRUPT_PACKET);
+    }
+    
+    /*
+     Everything from here on becomes part of the parse result, so it is built outside of any arena scope the caller has open.
+     Decrypting the header and verifying the signature above are the temporaries the arena is meant for
+     */
+    wickr_arena_t *arena = wickr_arena_suspend();
+    
+    wickr_key_exchange_set_t *header = wickr_key_exchange_set_create_from_buffer(engine, decrypted_header);
+    wickr_buffer_destroy(&decrypted_header);
+    
     if (!header) {
-        wickr__proto__packet__free_unpacked(proto_packet, NULL);
+        wickr_arena_resume(arena);
+        wickr_proto_arena_release(&proto_arena);
         return wickr_parse_result_create_failure(PACKET_SIGNATURE_VALID, ERROR_CORRUPT_PACKET);
     }
     
@@ -719,7 +780,8 @@ wickr_parse_result_t *wickr_parse_result_from_packet(const wickr_crypto_engine_t
         
         if (!key_exchange) {
             wickr_key_exchange_set_destroy(&header);
-            wickr__proto__packet__free_unpacked(proto_packet, NULL);
+            wickr_arena_resume(arena);
+            wickr_proto_arena_release(&proto_arena);
             return wickr_parse_result_create_failure(PACKET_SIGNATURE_VALID, ERROR_NODE_NOT_FOUND);
         }
     }
@@ -728,11 +790,12 @@ wickr_parse_result_t *wickr_parse_result_from_packet(const wickr_crypto_engine_t
     temp_buffer.length = proto_packet->enc_payload.len;
     
     wickr_cipher_result_t *payload_result = wickr_cipher_result_from_buffer(&temp_buffer);
-    wickr__proto__packet__free_unpacked(proto_packet, NULL);
+    wickr_proto_arena_release(&proto_arena);
     
     if (!payload_result) {
         wickr_key_exchange_destroy(&key_exchange);
         wickr_key_exchange_set_destroy(&header);
+        wickr_arena_resume(arena);
         return wickr_parse_result_create_failure(PACKET_SIGNATURE_VALID, ERROR_CORRUPT_PACKET);
     }
     
@@ -744,6 +807,8 @@ wickr_parse_result_t *wickr_parse_result_from_packet(const wickr_crypto_engine_t
         wickr_cipher_result_destroy(&payload_result);
     }
     
+    wickr_arena_resume(arena);
+    
     return final_result;
 }
 
@@ -768,22 +833,35 @@ wickr_decode_result_t *wickr_decode_result_from_parse_result(const wickr_packet_
     receiver_node.ephemeral_keypair = &receiver_key;
     receiver_node.id_chain = receiver_signing_identity;
     
-    wickr_cipher_key_t *cipher_key = wickr_key_exchange_derive_packet_key(engine,
-                                                                          sender_signing_identity,
-                                                                          &receiver_node,
-                                                                          parse_result->key_exchange_set->sender_pub,
-                                                                          parse_result->key_exchange,
-                                                                          NULL,
-                                                                          packet->version);
+    wickr_buffer_t *packet_key_buffer = wickr_key_exchange_derive_data(engine,
+                                                                       sender_signing_identity,
+                                                                       &receiver_node,
+                                                                       parse_result->key_exchange_set->sender_pub,
+                                                                       parse_result->key_exchange,
+                                                                       NULL,
+                                                                       packet->version);
+    
+    /* The key and payload are part of the decode result, so they are built outside of any arena scope the caller has open */
+    wickr_arena_t *arena = wickr_arena_suspend();
+    wickr_cipher_key_t *cipher_key = wickr_cipher_key_from_buffer(packet_key_buffer);
+    wickr_arena_resume(arena);
+    
+    wickr_buffer_destroy_zero(&packet_key_buffer);
     
     if (!cipher_key) {
         return wickr_decode_result_create_failure(ERROR_KEY_EXCHANGE_FAILED);
     }
     
-    wickr_payload_t *payload = wickr_payload_create_from_cipher(engine,
-                                                                parse_result->enc_payload,
-                                                                cipher_key);
+    wickr_buffer_t *decrypted_payload = engine->wickr_crypto_engine_cipher_decrypt(parse_result->enc_payload, NULL, cipher_key, true);
+    wickr_payload_t *payload = NULL;
     
+    if (decrypted_payload) {
+        arena = wickr_arena_suspend();
+        payload = wickr_payload_create_from_buffer(decrypted_payload);
+        wickr_arena_resume(arena);
+    
+        wickr_buffer_destroy_zero(&decrypted_payload);
+    }
     
     if (!payload) {
         wickr_cipher_key_destroy(&cipher_key);
@@ -1,6 +1,7 @@
 
 #include "root_keys.h"
 #include "memory.h"
+#include "private/proto_arena_priv.h"
 #include "storage.pb-c.h"
 #include "private/cipher_priv.h"
 #include "private/eckey_priv.h"
@@ -71,15 +72,19 @@ wickr_root_keys_t *wickr_root_keys_create_from_buffer(const wickr_crypto_engine_
         return NULL;
     }
     
-    Wickr__Proto__RootKeys *proto_keypair = wickr__proto__root_keys__unpack(NULL, buffer->length, buffer->bytes);
+    wickr_proto_arena_t proto_arena;
+    wickr_proto_arena_init(&proto_arena);
+    
+    Wickr__Proto__RootKeys *proto_keypair = wickr__proto__root_keys__unpack(&proto_arena.allocator, buffer->length, buffer->bytes);
     
     if (!proto_keypair) {
+        wickr_proto_arena_release(&proto_arena);
         return NULL;
     }
     
     if (!proto_keypair->has_node_storage_root || !proto_keypair->has_remote_storage_root ||
         proto_keypair->version > CURRENT_ROOT_KEY_VERSION) {
-        wickr__proto__root_keys__free_unpacked(proto_keypair, NULL);
+        wickr_proto_arena_release(&proto_arena);
         return NULL;
     }
     
@@ -90,7 +95,7 @@ wickr_root_keys_t *wickr_root_keys_create_from_buffer(const wickr_crypto_engine_
     wickr_cipher_key_t *node_storage_key = wickr_cipher_key_from_protobytes(proto_keypair->node_storage_root);
     
     if (!node_storage_key) {
-        wickr__proto__root_keys__free_unpacked(proto_keypair, NULL);
+        wickr_proto_arena_release(&proto_arena);
         return NULL;
     }
     
@@ -98,7 +103,7 @@ wickr_root_keys_t *wickr_root_keys_create_from_buffer(const wickr_crypto_engine_
     
     if (!node_storage_key) {
         wickr_cipher_key_destroy(&node_storage_key);
-        wickr__proto__root_keys__free_unpacked(proto_keypair, NULL);
+        wickr_proto_arena_release(&proto_arena);
         return NULL;
     }
     
@@ -107,12 +112,12 @@ wickr_root_keys_t *wickr_root_keys_create_from_buffer(const wickr_crypto_engine_
     if (!node_signature_root) {
         wickr_cipher_key_destroy(&remote_storage_key);
         wickr_cipher_key_destroy(&node_storage_key);
-        wickr__proto__root_keys__free_unpacked(proto_keypair, NULL);
+        wickr_proto_arena_release(&proto_arena);
         return NULL;
     }
     
     wickr_root_keys_t *root_keys = wickr_root_keys_create(node_signature_root, node_storage_key, remote_storage_key);
-    wickr__proto__root_keys__free_unpacked(proto_keypair, NULL);
+    wickr_proto_arena_release(&proto_arena);
     
     if (!root_keys) {
         wickr_cipher_key_destroy(&remote_storage_key);
@@ -209,7 +214,9 @@ wickr_storage_keys_t *wickr_root_keys_localize(const wickr_root_keys_t *keys, co
     }
     
     /* Create our local storage key by taking a hash of the node_storage_root with the system_salt as the salt */
-    wickr_buffer_t *local_dev_storage_key_material = engine->wickr_crypto_engine_digest(keys->node_storage_root->key_data, dev_info->system_salt, DIGEST_SHA_256);
+    wickr_buffer_t *local_dev_storage_digest = engine->wickr_crypto_engine_digest(keys->node_storage_root->key_data, dev_info->system_salt, DIGEST_SHA_256);
+    wickr_buffer_t *local_dev_storage_key_material = wickr_buffer_copy_secure(local_dev_storage_digest);
+    wickr_buffer_destroy_zero(&local_dev_storage_digest);
     
     if (!local_dev_storage_key_material) {
         wickr_cipher_key_destroy(&rsr_copy);
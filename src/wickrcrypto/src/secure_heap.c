@@ -0,0 +1,294 @@
+
+#include "secure_heap.h"
+#include "private/memory_priv.h"
+#include "private/threads_priv.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include "Windows.h"
+#define SECURE_HEAP_LOAD_BASE(heap) ((uint8_t *)InterlockedCompareExchangePointer((PVOID volatile *)&(heap)->base, NULL, NULL))
+#define SECURE_HEAP_STORE_BASE(heap, value) InterlockedExchangePointer((PVOID volatile *)&(heap)->base, value)
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#define SECURE_HEAP_LOAD_BASE(heap) __atomic_load_n(&(heap)->base, __ATOMIC_ACQUIRE)
+#define SECURE_HEAP_STORE_BASE(heap, value) __atomic_store_n(&(heap)->base, value, __ATOMIC_RELEASE)
+#endif
+
+/* Size classes are powers of 2 from 32 bytes up to WICKR_SECURE_HEAP_MAX_ALLOC */
+#define SECURE_HEAP_MIN_CLASS_SHIFT 5
+#define SECURE_HEAP_CLASS_COUNT 7
+#define SECURE_HEAP_CLASS_SIZE(size_class) ((size_t)1 << (SECURE_HEAP_MIN_CLASS_SHIFT + (size_class)))
+
+/* Each region is this many pages, preceded by a guard page */
+#define SECURE_HEAP_REGION_PAGES 4
+
+typedef struct wickr_secure_heap {
+    wickr_mutex_t lock;
+    uint8_t *base;
+    size_t reserved_size;
+    size_t page_size;
+    size_t region_size;
+    size_t region_count;
+    size_t next_region;
+    uint8_t *region_classes;
+    void *free_lists[SECURE_HEAP_CLASS_COUNT];
+    uint8_t *cursor[SECURE_HEAP_CLASS_COUNT];
+    uint8_t *cursor_end[SECURE_HEAP_CLASS_COUNT];
+    wickr_secure_heap_stats_t stats;
+} wickr_secure_heap_t;
+
+static wickr_secure_heap_t __wickr_secure_heap = { .lock = WICKR_MUTEX_INITIALIZER };
+static wickr_once_t __wickr_secure_heap_once = WICKR_ONCE_INIT;
+
+#ifdef _WIN32
+
+static size_t __wickr_secure_heap_page_size(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (size_t)info.dwPageSize;
+}
+
+static uint8_t *__wickr_secure_heap_reserve(size_t len)
+{
+    return VirtualAlloc(NULL, len, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+static bool __wickr_secure_heap_commit(uint8_t *pages, size_t len, bool *is_locked)
+{
+    if (!VirtualAlloc(pages, len, MEM_COMMIT, PAGE_READWRITE)) {
+        return false;
+    }
+    
+    *is_locked = VirtualLock(pages, len) != 0;
+    
+    return true;
+}
+
+#else
+
+static size_t __wickr_secure_heap_page_size(void)
+{
+    long page_size = sysconf(_SC_PAGESIZE);
+    return page_size > 0 ? (size_t)page_size : 4096;
+}
+
+static uint8_t *__wickr_secure_heap_reserve(size_t len)
+{
+    void *pages = mmap(NULL, len, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    return pages == MAP_FAILED ? NULL : pages;
+}
+
+static bool __wickr_secure_heap_commit(uint8_t *pages, size_t len, bool *is_locked)
+{
+    if (mprotect(pages, len, PROT_READ | PROT_WRITE) != 0) {
+        return false;
+    }
+
+#ifdef MADV_DONTDUMP
+    madvise(pages, len, MADV_DONTDUMP);
+#endif
+
+    *is_locked = mlock(pages, len) == 0;
+    
+    return true;
+}
+
+#endif
+
+static void __wickr_secure_heap_init(void)
+{
+    wickr_secure_heap_t *heap = &__wickr_secure_heap;
+    
+    heap->page_size = __wickr_secure_heap_page_size();
+    heap->region_size = heap->page_size * SECURE_HEAP_REGION_PAGES;
+    
+    /* Every region is preceded by a guard page, and one more guard page follows the last region */
+    size_t stride = heap->region_size + heap->page_size;
+    size_t region_count = WICKR_SECURE_HEAP_SIZE / stride;
+    
+    if (region_count == 0) {
+        return;
+    }
+    
+    /* Region metadata lives for the life of the process, so it comes straight from the system */
+    uint8_t *region_classes = calloc(region_count, sizeof(uint8_t));
+    
+    if (!region_classes) {
+        return;
+    }
+    
+    size_t reserved_size = region_count * stride + heap->page_size;
+    uint8_t *base = __wickr_secure_heap_reserve(reserved_size);
+    
+    if (!base) {
+        free(region_classes);
+        return;
+    }
+    
+    heap->reserved_size = reserved_size;
+    heap->region_count = region_count;
+    heap->region_classes = region_classes;
+    heap->stats.reserved_bytes = reserved_size;
+    heap->stats.is_locked = true;
+    
+    /* Published last, so a thread that sees the base without going through the once also sees the size of the reservation */
+    SECURE_HEAP_STORE_BASE(heap, base);
+}
+
+static uint8_t *__wickr_secure_heap_region_data(const wickr_secure_heap_t *heap, size_t region)
+{
+    return heap->base + region * (heap->region_size + heap->page_size) + heap->page_size;
+}
+
+static int __wickr_secure_heap_class(size_t len)
+{
+    for (int size_class = 0; size_class < SECURE_HEAP_CLASS_COUNT; size_class++) {
+        if (len <= SECURE_HEAP_CLASS_SIZE(size_class)) {
+            return size_class;
+        }
+    }
+    
+    return -1;
+}
+
+static bool __wickr_secure_heap_add_region(wickr_secure_heap_t *heap, int size_class)
+{
+    if (heap->next_region >= heap->region_count) {
+        return false;
+    }
+    
+    size_t region = heap->next_region;
+    uint8_t *data = __wickr_secure_heap_region_data(heap, region);
+    bool is_locked = false;
+    
+    if (!__wickr_secure_heap_commit(data, heap->region_size, &is_locked)) {
+        return false;
+    }
+    
+    heap->next_region++;
+    heap->region_classes[region] = (uint8_t)size_class;
+    heap->cursor[size_class] = data;
+    heap->cursor_end[size_class] = data + heap->region_size;
+    heap->stats.committed_bytes += heap->region_size;
+    heap->stats.is_locked = heap->stats.is_locked && is_locked;
+    
+    return true;
+}
+
+static void *__wickr_secure_heap_alloc(wickr_secure_heap_t *heap, int size_class)
+{
+    size_t chunk_size = SECURE_HEAP_CLASS_SIZE(size_class);
+    void *chunk = heap->free_lists[size_class];
+    
+    /* Free chunks are zeroed apart from the free list link in their first bytes */
+    if (chunk) {
+        memcpy(&heap->free_lists[size_class], chunk, sizeof(void *));
+        memset(chunk, 0, sizeof(void *));
+    }
+    else {
+        if (heap->cursor[size_class] == heap->cursor_end[size_class] && !__wickr_secure_heap_add_region(heap, size_class)) {
+            return NULL;
+        }
+    
+        chunk = heap->cursor[size_class];
+        heap->cursor[size_class] += chunk_size;
+    }
+    
+    heap->stats.live_bytes += chunk_size;
+    heap->stats.live_allocations++;
+    
+    return chunk;
+}
+
+void *wickr_secure_alloc(size_t len)
+{
+    if (len == 0) {
+        return NULL;
+    }
+    
+    wickr_once(&__wickr_secure_heap_once, __wickr_secure_heap_init);
+    
+    wickr_secure_heap_t *heap = &__wickr_secure_heap;
+    int size_class = __wickr_secure_heap_class(len);
+    void *chunk = NULL;
+    
+    wickr_mutex_lock(&heap->lock);
+    
+    if (heap->base && size_class >= 0) {
+        chunk = __wickr_secure_heap_alloc(heap, size_class);
+    }
+    
+    if (!chunk) {
+        heap->stats.fallback_allocations++;
+    }
+    
+    wickr_mutex_unlock(&heap->lock);
+    
+    return chunk ? chunk : wickr_alloc_zero(len);
+}
+
+bool wickr_secure_heap_owns(const void *buf)
+{
+    if (!buf) {
+        return false;
+    }
+    
+    /*
+     Memory can only belong to the heap once it has been reserved, so this doesn't trigger the reservation. The reservation never
+     moves once it is made, so it can be checked without taking the lock
+     */
+    const uint8_t *base = SECURE_HEAP_LOAD_BASE(&__wickr_secure_heap);
+    
+    return base && (const uint8_t *)buf >= base && (const uint8_t *)buf < base + __wickr_secure_heap.reserved_size;
+}
+
+void wickr_secure_heap_free(void *buf)
+{
+    wickr_secure_heap_t *heap = &__wickr_secure_heap;
+    
+    size_t stride = heap->region_size + heap->page_size;
+    size_t offset = (size_t)((uint8_t *)buf - heap->base);
+    size_t region = offset / stride;
+    size_t region_offset = offset % stride;
+    
+    wickr_mutex_lock(&heap->lock);
+    
+    /* A pointer into a guard page, an uncommitted region or the middle of a chunk means the heap is being misused */
+    if (region >= heap->next_region || region_offset < heap->page_size) {
+        abort();
+    }
+    
+    int size_class = heap->region_classes[region];
+    size_t chunk_size = SECURE_HEAP_CLASS_SIZE(size_class);
+    
+    if ((region_offset - heap->page_size) % chunk_size != 0) {
+        abort();
+    }
+    
+    wickr_secure_zero(buf, chunk_size);
+    memcpy(buf, &heap->free_lists[size_class], sizeof(void *));
+    heap->free_lists[size_class] = buf;
+    
+    heap->stats.live_bytes -= chunk_size;
+    heap->stats.live_allocations--;
+    
+    wickr_mutex_unlock(&heap->lock);
+}
+
+bool wickr_secure_heap_get_stats(wickr_secure_heap_stats_t *stats_out)
+{
+    if (!stats_out) {
+        return false;
+    }
+    
+    wickr_once(&__wickr_secure_heap_once, __wickr_secure_heap_init);
+    
+    wickr_mutex_lock(&__wickr_secure_heap.lock);
+    *stats_out = __wickr_secure_heap.stats;
+    wickr_mutex_unlock(&__wickr_secure_heap.lock);
+    
+    return true;
+}
@@ -1,6 +1,7 @@
 
 #include "private/storage_priv.h"
 #include "memory.h"
+#include "private/proto_arena_priv.h"
 #include "storage.pb-c.h"
 #include "private/cipher_priv.h"
 
@@ -78,11 +79,14 @@ wickr_storage_keys_t *wickr_storage_keys_create_from_buffer(const wickr_buffer_t
         return NULL;
     }
     
-    Wickr__Proto__StorageKeys *key_proto = wickr__proto__storage_keys__unpack(NULL, buffer->length,
+    wickr_proto_arena_t proto_arena;
+    wickr_proto_arena_init(&proto_arena);
+    
+    Wickr__Proto__StorageKeys *key_proto = wickr__proto__storage_keys__unpack(&proto_arena.allocator, buffer->length,
                                                                               buffer->bytes);
     
     wickr_storage_keys_t *storage_keys = wickr_storage_keys_create_from_proto(key_proto);
-    wickr__proto__storage_keys__free_unpacked(key_proto, NULL);
+    wickr_proto_arena_release(&proto_arena);
     
     return storage_keys;
 }
@@ -69,6 +69,7 @@ wickr_stream_ctx_t *wickr_stream_ctx_copy(const wickr_stream_ctx_t *ctx)
     stream_cipher->direction = ctx->direction;
     stream_cipher->iv_factory = iv_copy;
     stream_cipher->ref_count = 1;
+    stream_cipher->evolution_count = ctx->evolution_count;
     
     return stream_cipher;
 }
@@ -99,13 +100,13 @@ static wickr_stream_key_t *__wickr_stream_key_create_with_evo_buffer(wickr_strea
         return NULL;
     }
     
-    wickr_buffer_t *new_crypto_key = wickr_buffer_copy_section(evo_buffer, 0, DIGEST_SHA_512.size / 2);
+    wickr_buffer_t *new_crypto_key = wickr_buffer_copy_section_secure(evo_buffer, 0, DIGEST_SHA_512.size / 2);
     
     if (!new_crypto_key) {
         return NULL;
     }
     
-    wickr_buffer_t *new_evo_key = wickr_buffer_copy_section(evo_buffer, DIGEST_SHA_512.size / 2, DIGEST_SHA_512.size / 2);
+    wickr_buffer_t *new_evo_key = wickr_buffer_copy_section_secure(evo_buffer, DIGEST_SHA_512.size / 2, DIGEST_SHA_512.size / 2);
     
     if (!new_evo_key) {
         wickr_buffer_destroy(&new_crypto_key);
@@ -148,6 +149,7 @@ static bool __wickr_stream_ctx_evolove_key_material(wickr_stream_ctx_t *encoder,
         return true;
     }
     
+    uint64_t evolutions = seq_evo - curr_evo;
     wickr_stream_key_t *curr_key = wickr_stream_key_copy(encoder->key);
     
     if (!curr_key) {
@@ -179,6 +181,7 @@ static bool __wickr_stream_ctx_evolove_key_material(wickr_stream_ctx_t *encoder,
     
     wickr_stream_key_destroy(&encoder->key);
     encoder->key = curr_key;
+    encoder->evolution_count += evolutions;
     
     return true;
 }
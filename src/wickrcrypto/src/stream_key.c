@@ -8,6 +8,7 @@
 
 #include "private/stream_key_priv.h"
 #include "memory.h"
+#include "private/proto_arena_priv.h"
 
 wickr_stream_key_t *wickr_stream_key_create(wickr_cipher_key_t *cipher_key, wickr_buffer_t *evolution_key, uint32_t packets_per_evolution)
 {
@@ -73,7 +74,7 @@ wickr_stream_key_t *wickr_stream_key_copy(const wickr_stream_key_t *stream_key)
         return NULL;
     }
     
-    wickr_buffer_t *evo_key_copy = wickr_buffer_copy(stream_key->evolution_key);
+    wickr_buffer_t *evo_key_copy = wickr_buffer_copy_secure(stream_key->evolution_key);
     
     if (!evo_key_copy) {
         wickr_cipher_key_destroy(&key_copy);
@@ -135,14 +136,18 @@ wickr_stream_key_t *wickr_stream_key_create_from_buffer(const wickr_buffer_t *bu
         return NULL;
     }
     
-    Wickr__Proto__StreamKey *proto_key = wickr__proto__stream_key__unpack(NULL, buffer->length, buffer->bytes);
+    wickr_proto_arena_t proto_arena;
+    wickr_proto_arena_init(&proto_arena);
+    
+    Wickr__Proto__StreamKey *proto_key = wickr__proto__stream_key__unpack(&proto_arena.allocator, buffer->length, buffer->bytes);
     
     if (!proto_key) {
+        wickr_proto_arena_release(&proto_arena);
         return NULL;
     }
     
     wickr_stream_key_t *stream_key = wickr_stream_key_create_from_proto(proto_key);
-    wickr__proto__stream_key__free_unpacked(proto_key, NULL);
+    wickr_proto_arena_release(&proto_arena);
     
     return stream_key;
 }
@@ -2,6 +2,7 @@
 #include "private/stream_key_priv.h"
 #include "memory.h"
 #include "private/buffer_priv.h"
+#include "private/cipher_priv.h"
 
 void wickr_stream_key_proto_free(Wickr__Proto__StreamKey *proto_key)
 {
@@ -63,20 +64,19 @@ wickr_stream_key_t *wickr_stream_key_create_from_proto(const Wickr__Proto__Strea
         return NULL;
     }
     
-    wickr_buffer_t *key_buffer = wickr_buffer_create(proto->cipher_key.data, proto->cipher_key.len);
-    
-    if (!key_buffer) {
-        return NULL;
-    }
-    
-    wickr_cipher_key_t *cipher_key = wickr_cipher_key_from_buffer(key_buffer);
-    wickr_buffer_destroy(&key_buffer);
+    /* Key bytes are copied straight from the proto onto the secure heap */
+    wickr_cipher_key_t *cipher_key = wickr_cipher_key_from_protobytes(proto->cipher_key);
     
     if (!cipher_key) {
         return NULL;
     }
     
-    wickr_buffer_t *evo_key = wickr_buffer_create(proto->evolution_key.data, proto->evolution_key.len);
+    wickr_buffer_t evo_key_buffer = {
+        .bytes = proto->evolution_key.data,
+        .length = proto->evolution_key.len
+    };
+    
+    wickr_buffer_t *evo_key = wickr_buffer_copy_secure(&evo_key_buffer);
     
     if (!evo_key) {
         wickr_cipher_key_destroy(&cipher_key);
@@ -0,0 +1,192 @@
+
+#include "private/threads_priv.h"
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+
+#include <process.h>
+
+typedef struct wickr_thread_start {
+    wickr_thread_func func;
+    void *arg;
+} wickr_thread_start_t;
+
+/* _beginthreadex expects a different entry point signature, so the function and its argument are carried through this */
+static unsigned __stdcall __wickr_thread_entry(void *param)
+{
+    wickr_thread_start_t start = *(wickr_thread_start_t *)param;
+    free(param);
+    
+    start.func(start.arg);
+    
+    return 0;
+}
+
+bool wickr_thread_create(wickr_thread_t *thread, wickr_thread_func func, void *arg)
+{
+    if (!thread || !func) {
+        return false;
+    }
+    
+    /* Allocated with malloc so thread startup is never counted by allocator hooks */
+    wickr_thread_start_t *start = malloc(sizeof(wickr_thread_start_t));
+    
+    if (!start) {
+        return false;
+    }
+    
+    start->func = func;
+    start->arg = arg;
+    
+    uintptr_t handle = _beginthreadex(NULL, 0, __wickr_thread_entry, start, 0, NULL);
+    
+    if (handle == 0) {
+        free(start);
+        return false;
+    }
+    
+    *thread = (HANDLE)handle;
+    
+    return true;
+}
+
+void wickr_thread_join(wickr_thread_t thread)
+{
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+void wickr_thread_detach(wickr_thread_t thread)
+{
+    CloseHandle(thread);
+}
+
+uint32_t wickr_thread_cpu_count(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    
+    return info.dwNumberOfProcessors > 0 ? (uint32_t)info.dwNumberOfProcessors : 1;
+}
+
+uint64_t wickr_clock_monotonic_ns(void)
+{
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    
+    if (!QueryPerformanceFrequency(&frequency) || !QueryPerformanceCounter(&counter) || frequency.QuadPart <= 0) {
+        return 0;
+    }
+    
+    /* Split into whole seconds and the remainder so the conversion to nanoseconds can't overflow */
+    uint64_t ticks = (uint64_t)counter.QuadPart;
+    uint64_t hz = (uint64_t)frequency.QuadPart;
+    
+    return (ticks / hz) * 1000000000ULL + ((ticks % hz) * 1000000000ULL) / hz;
+}
+
+typedef struct wickr_once_func {
+    void (*init_func)(void);
+} wickr_once_func_t;
+
+static BOOL CALLBACK __wickr_once_callback(PINIT_ONCE once, PVOID param, PVOID *context)
+{
+    (void)once;
+    (void)context;
+    
+    ((wickr_once_func_t *)param)->init_func();
+    
+    return TRUE;
+}
+
+void wickr_once(wickr_once_t *once, void (*init_func)(void))
+{
+    wickr_once_func_t func = { .init_func = init_func };
+    InitOnceExecuteOnce(once, __wickr_once_callback, &func, NULL);
+}
+
+bool wickr_thread_key_create(wickr_thread_key_t *key, wickr_thread_key_destructor destructor)
+{
+    if (!key) {
+        return false;
+    }
+    
+    DWORD index = FlsAlloc(destructor);
+    
+    if (index == FLS_OUT_OF_INDEXES) {
+        return false;
+    }
+    
+    *key = index;
+    
+    return true;
+}
+
+bool wickr_thread_key_set(wickr_thread_key_t key, void *value)
+{
+    return FlsSetValue(key, value) != 0;
+}
+
+#else
+
+#include <time.h>
+#include <unistd.h>
+
+bool wickr_thread_create(wickr_thread_t *thread, wickr_thread_func func, void *arg)
+{
+    if (!thread || !func) {
+        return false;
+    }
+    
+    return pthread_create(thread, NULL, func, arg) == 0;
+}
+
+void wickr_thread_join(wickr_thread_t thread)
+{
+    pthread_join(thread, NULL);
+}
+
+void wickr_thread_detach(wickr_thread_t thread)
+{
+    pthread_detach(thread);
+}
+
+uint32_t wickr_thread_cpu_count(void)
+{
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    
+    return online > 0 ? (uint32_t)online : 1;
+}
+
+uint64_t wickr_clock_monotonic_ns(void)
+{
+    struct timespec now;
+    
+    if (clock_gettime(CLOCK_MONOTONIC, &now) != 0) {
+        return 0;
+    }
+    
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+void wickr_once(wickr_once_t *once, void (*init_func)(void))
+{
+    pthread_once(once, init_func);
+}
+
+bool wickr_thread_key_create(wickr_thread_key_t *key, wickr_thread_key_destructor destructor)
+{
+    if (!key) {
+        return false;
+    }
+    
+    return pthread_key_create(key, destructor) == 0;
+}
+
+bool wickr_thread_key_set(wickr_thread_key_t key, void *value)
+{
+    return pthread_setspecific(key, value) == 0;
+}
+
+#endif
@@ -7,6 +7,8 @@
 #include "transport_packet.h"
 #include "transport_error.h"
 #include "private/transport_priv.h"
+#include "private/transport_handshake_priv.h"
+#include "private/transport_stats_priv.h"
 #include "private/node_priv.h"
 #include "private/identity_priv.h"
 #include "private/ephemeral_keypair_priv.h"
@@ -29,6 +31,19 @@ static void __wickr_transport_ctx_set_error(wickr_transport_ctx_t *ctx, wickr_tr
     __wickr_transport_ctx_update_status(ctx, TRANSPORT_STATUS_ERROR);
 }
 
+static void __wickr_transport_ctx_set_handshake_error(wickr_transport_ctx_t *ctx, wickr_transport_error err)
+{
+    ctx->stats.handshakes_failed++;
+    __wickr_transport_ctx_set_error(ctx, err);
+}
+
+static void __wickr_transport_ctx_tx_handshake_buffer(wickr_transport_ctx_t *ctx, wickr_buffer_t *buffer)
+{
+    ctx->stats.handshake_tx_packets++;
+    ctx->stats.tx_wire_bytes += buffer->length;
+    ctx->callbacks.tx(ctx, buffer);
+}
+
 wickr_transport_ctx_t *wickr_transport_ctx_create(const wickr_crypto_engine_t engine,
                                                   wickr_identity_chain_t *local_identity,
                                                   wickr_identity_chain_t *remote_identity,
@@ -44,12 +59,21 @@ wickr_transport_ctx_t *wickr_transport_ctx_create(const wickr_crypto_engine_t en
         return NULL;
     }
     
+    /* Serialize the local identity up front so that each handshake can reuse it */
+    wickr_buffer_t *local_identity_data = wickr_identity_chain_serialize(local_identity);
+    
+    if (!local_identity_data) {
+        return NULL;
+    }
+    
     wickr_transport_ctx_t *ctx = wickr_alloc_zero(sizeof(wickr_transport_ctx_t));
     
     if (!ctx) {
+        wickr_buffer_destroy(&local_identity_data);
         return NULL;
     }
     
+    ctx->local_identity_data = local_identity_data;
     ctx->status = TRANSPORT_STATUS_NONE;
     ctx->engine = engine;
     ctx->local_identity = local_identity;
@@ -76,7 +100,7 @@ wickr_transport_ctx_t *wickr_transport_ctx_copy(const wickr_transport_ctx_t *ctx
     
     wickr_identity_chain_t *remote_copy = wickr_identity_chain_copy(ctx->remote_identity);
     
-    if (!remote_copy) {
+    if (!remote_copy && ctx->remote_identity) {
         wickr_identity_chain_destroy(&local_copy);
         return NULL;
     }
@@ -98,6 +122,21 @@ wickr_transport_ctx_t *wickr_transport_ctx_copy(const wickr_transport_ctx_t *ctx
         return NULL;
     }
     
+    wickr_cipher_key_t *ticket_key_copy = wickr_cipher_key_copy(ctx->ticket_key);
+    wickr_transport_resumption_t *resumption_copy = wickr_transport_resumption_copy(ctx->resumption);
+    wickr_buffer_t *local_identity_data_copy = wickr_buffer_copy(ctx->local_identity_data);
+    
+    if ((!ticket_key_copy && ctx->ticket_key) || (!resumption_copy && ctx->resumption) || !local_identity_data_copy) {
+        wickr_identity_chain_destroy(&local_copy);
+        wickr_identity_chain_destroy(&remote_copy);
+        wickr_stream_ctx_destroy(&tx_copy);
+        wickr_stream_ctx_destroy(&rx_copy);
+        wickr_cipher_key_destroy(&ticket_key_copy);
+        wickr_transport_resumption_destroy(&resumption_copy);
+        wickr_buffer_destroy(&local_identity_data_copy);
+        return NULL;
+    }
+    
     wickr_transport_ctx_t *copy = wickr_alloc_zero(sizeof(wickr_transport_ctx_t));
     
     if (!copy) {
@@ -105,11 +144,15 @@ wickr_transport_ctx_t *wickr_transport_ctx_copy(const wickr_transport_ctx_t *ctx
         wickr_identity_chain_destroy(&remote_copy);
         wickr_stream_ctx_destroy(&tx_copy);
         wickr_stream_ctx_destroy(&rx_copy);
+        wickr_cipher_key_destroy(&ticket_key_copy);
+        wickr_transport_resumption_destroy(&resumption_copy);
+        wickr_buffer_destroy(&local_identity_data_copy);
         return NULL;
     }
     
     copy->engine = ctx->engine;
     copy->local_identity = local_copy;
+    copy->local_identity_data = local_identity_data_copy;
     copy->remote_identity = remote_copy;
     copy->tx_stream = tx_copy;
     copy->rx_stream = rx_copy;
@@ -117,6 +160,11 @@ wickr_transport_ctx_t *wickr_transport_ctx_copy(const wickr_transport_ctx_t *ctx
     copy->callbacks = ctx->callbacks;
     copy->evo_count = ctx->evo_count;
     copy->user = ctx->user;
+    copy->ticket_key = ticket_key_copy;
+    copy->resumption = resumption_copy;
+    copy->stats = ctx->stats;
+    copy->handshake_flags = ctx->handshake_flags;
+    copy->session_flags = ctx->session_flags;
     
     return copy;
 }
@@ -128,28 +176,54 @@ void wickr_transport_ctx_destroy(wickr_transport_ctx_t **ctx)
     }
     
     wickr_identity_chain_destroy(&(*ctx)->local_identity);
+    wickr_buffer_destroy(&(*ctx)->local_identity_data);
     wickr_identity_chain_destroy(&(*ctx)->remote_identity);
     wickr_stream_ctx_destroy(&(*ctx)->tx_stream);
     wickr_stream_ctx_destroy(&(*ctx)->rx_stream);
     wickr_transport_handshake_destroy(&(*ctx)->pending_handshake);
+    wickr_cipher_key_destroy(&(*ctx)->ticket_key);
+    wickr_transport_resumption_destroy(&(*ctx)->resumption);
     
     wickr_free(*ctx);
     *ctx = NULL;
 }
 
-static wickr_buffer_t *__wickr_transport_ctx_decode_pkt(const wickr_transport_ctx_t *ctx, const wickr_transport_packet_t *pkt)
+static wickr_buffer_t *__wickr_transport_ctx_decode_pkt(wickr_transport_ctx_t *ctx, const wickr_transport_packet_t *pkt)
 {
     if (!ctx || !pkt) {
         return NULL;
     }
     
-    wickr_cipher_result_t *cipher_result = wickr_cipher_result_from_buffer(pkt->body);
+    /* Only accept the data packet format that was negotiated by the handshake */
+    bool is_compact = (ctx->session_flags & TRANSPORT_HANDSHAKE_FLAG_COMPACT_PACKETS) != 0;
+    wickr_transport_packet_payload_type expected_type = is_compact ? TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT_COMPACT : TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT;
+    
+    if (pkt->meta.body_type != expected_type) {
+        ctx->stats.rx_parse_failures++;
+        return NULL;
+    }
+    
+    wickr_cipher_result_t *cipher_result;
+    
+    if (is_compact) {
+        cipher_result = wickr_cipher_result_from_compact_buffer(pkt->body, ctx->rx_stream->key->cipher_key->cipher);
+    } else {
+        cipher_result = wickr_cipher_result_from_buffer(pkt->body);
+    }
     
     if (!cipher_result) {
+        ctx->stats.rx_parse_failures++;
         return NULL;
     }
     
     if (pkt->meta.mac_type != TRANSPORT_MAC_TYPE_AUTH_CIPHER) { /* Only allow authenticated ciphers */
+        ctx->stats.rx_mac_type_failures++;
+        wickr_cipher_result_destroy(&cipher_result);
+        return NULL;
+    }
+    
+    if (pkt->meta.body_meta.data.sequence_number <= ctx->rx_stream->last_seq) {
+        ctx->stats.rx_sequence_failures++;
         wickr_cipher_result_destroy(&cipher_result);
         return NULL;
     }
@@ -161,13 +235,20 @@ static wickr_buffer_t *__wickr_transport_ctx_decode_pkt(const wickr_transport_ct
         return NULL;
     }
     
+    uint64_t evolution_count = ctx->rx_stream->evolution_count;
     wickr_buffer_t *return_buffer = wickr_stream_ctx_decode(ctx->rx_stream, cipher_result, aad_buffer, pkt->meta.body_meta.data.sequence_number);
     wickr_cipher_result_destroy(&cipher_result);
     wickr_buffer_destroy(&aad_buffer);
     
+    ctx->stats.rx_evolutions += ctx->rx_stream->evolution_count - evolution_count;
+    
+    if (!return_buffer) {
+        ctx->stats.rx_decrypt_failures++;
+    }
+    
     return return_buffer;
 }
-static wickr_transport_packet_t *__wickr_transport_ctx_encode_pkt(const wickr_transport_ctx_t *ctx, const wickr_buffer_t *data)
+static wickr_transport_packet_t *__wickr_transport_ctx_encode_pkt(wickr_transport_ctx_t *ctx, const wickr_buffer_t *data)
 {
     if (!ctx || !data) {
         return NULL;
@@ -175,8 +256,15 @@ static wickr_transport_packet_t *__wickr_transport_ctx_encode_pkt(const wickr_tr
     
     uint64_t next_pkt_seq = ctx->tx_stream->last_seq + 1;
     
+    bool is_compact = (ctx->session_flags & TRANSPORT_HANDSHAKE_FLAG_COMPACT_PACKETS) != 0;
+    
     wickr_transport_packet_meta_t meta;
-    wickr_transport_packet_meta_initialize_data(&meta, next_pkt_seq, TRANSPORT_MAC_TYPE_AUTH_CIPHER);
+    
+    if (is_compact) {
+        wickr_transport_packet_meta_initialize_compact_data(&meta, next_pkt_seq, TRANSPORT_MAC_TYPE_AUTH_CIPHER);
+    } else {
+        wickr_transport_packet_meta_initialize_data(&meta, next_pkt_seq, TRANSPORT_MAC_TYPE_AUTH_CIPHER);
+    }
     
     wickr_buffer_t *aad_buffer = wickr_transport_packet_meta_serialize(&meta);
     
@@ -184,14 +272,17 @@ static wickr_transport_packet_t *__wickr_transport_ctx_encode_pkt(const wickr_tr
         return NULL;
     }
     
+    uint64_t evolution_count = ctx->tx_stream->evolution_count;
     wickr_cipher_result_t *cipher_result = wickr_stream_ctx_encode(ctx->tx_stream, data, aad_buffer, next_pkt_seq);
     wickr_buffer_destroy(&aad_buffer);
     
+    ctx->stats.tx_evolutions += ctx->tx_stream->evolution_count - evolution_count;
+    
     if (!cipher_result) {
         return NULL;
     }
     
-    wickr_buffer_t *serialized = wickr_cipher_result_serialize(cipher_result);
+    wickr_buffer_t *serialized = is_compact ? wickr_cipher_result_serialize_compact(cipher_result) : wickr_cipher_result_serialize(cipher_result);
     wickr_cipher_result_destroy(&cipher_result);
     
     if (!serialized) {
@@ -228,6 +319,13 @@ static bool __wickr_transport_ctx_finalize_handshake(wickr_transport_ctx_t *ctx)
     wickr_stream_key_t *rx_key = wickr_stream_key_copy(wickr_transport_handshake_res_get_remote_key(res));
     wickr_stream_ctx_t *rx_stream = wickr_stream_ctx_create(ctx->engine, rx_key, STREAM_DIRECTION_DECODE);
     
+    /* Cache resumption information so that it can be used to resume this session later */
+    if (wickr_transport_handshake_res_get_resumption(res)) {
+        wickr_transport_resumption_destroy(&ctx->resumption);
+        ctx->resumption = wickr_transport_resumption_copy(wickr_transport_handshake_res_get_resumption(res));
+    }
+    
+    uint64_t session_flags = wickr_transport_handshake_res_get_flags(res);
     wickr_transport_handshake_res_destroy(&res);
     
     if (!rx_stream) {
@@ -241,6 +339,8 @@ static bool __wickr_transport_ctx_finalize_handshake(wickr_transport_ctx_t *ctx)
     
     ctx->rx_stream = rx_stream;
     ctx->tx_stream = tx_stream;
+    ctx->session_flags = session_flags;
+    ctx->stats.handshakes_completed++;
     
     __wickr_transport_ctx_update_status(ctx, TRANSPORT_STATUS_ACTIVE);
     
@@ -259,7 +359,7 @@ static void __wickr_transport_validate_identity_complete(const wickr_transport_c
     }
     
     if (wickr_transport_handshake_get_status(_ctx->pending_handshake) == TRANSPORT_HANDSHAKE_STATUS_FAILED) {
-        __wickr_transport_ctx_set_error(_ctx, TRANSPORT_ERROR_HANDSHAKE_FAILED);
+        __wickr_transport_ctx_set_handshake_error(_ctx, TRANSPORT_ERROR_HANDSHAKE_FAILED);
         return;
     }
     
@@ -272,7 +372,7 @@ static void __wickr_transport_validate_identity_complete(const wickr_transport_c
             return;
         }
         
-        _ctx->callbacks.tx(ctx, volley_buffer);
+        __wickr_transport_ctx_tx_handshake_buffer(_ctx, volley_buffer);
     }
     
 }
@@ -285,7 +385,7 @@ static void __wickr_transport_handshake_identity_callback(const wickr_transport_
     ctx->callbacks.on_identity_verify(ctx, identity, __wickr_transport_validate_identity_complete);
 }
 
-static wickr_transport_handshake_t *__wickr_transport_ctx_create_handshake(const wickr_transport_ctx_t *ctx)
+static wickr_transport_handshake_t *__wickr_transport_ctx_create_handshake(wickr_transport_ctx_t *ctx)
 {
     wickr_identity_chain_t *local_copy = wickr_identity_chain_copy(ctx->local_identity);
     wickr_identity_chain_t *remote_copy = wickr_identity_chain_copy(ctx->remote_identity);
@@ -300,8 +400,28 @@ static wickr_transport_handshake_t *__wickr_transport_ctx_create_handshake(const
     if (!handshake) {
         wickr_identity_chain_destroy(&local_copy);
         wickr_identity_chain_destroy(&remote_copy);
+        return NULL;
+    }
+    
+    wickr_cipher_key_t *ticket_key_copy = wickr_cipher_key_copy(ctx->ticket_key);
+    wickr_transport_resumption_t *resumption_copy = wickr_transport_resumption_copy(ctx->resumption);
+    wickr_buffer_t *local_identity_data_copy = wickr_buffer_copy(ctx->local_identity_data);
+    
+    if ((!ticket_key_copy && ctx->ticket_key) || (!resumption_copy && ctx->resumption) || !local_identity_data_copy) {
+        wickr_cipher_key_destroy(&ticket_key_copy);
+        wickr_transport_resumption_destroy(&resumption_copy);
+        wickr_buffer_destroy(&local_identity_data_copy);
+        wickr_transport_handshake_destroy(&handshake);
+        return NULL;
     }
     
+    wickr_transport_handshake_set_ticket_key(handshake, ticket_key_copy);
+    wickr_transport_handshake_set_resumption(handshake, resumption_copy);
+    wickr_transport_handshake_set_local_identity_data(handshake, local_identity_data_copy);
+    wickr_transport_handshake_set_flags(handshake, ctx->handshake_flags);
+    wickr_transport_handshake_set_stats(handshake, &ctx->stats);
+    ctx->stats.handshakes_started++;
+    
     return handshake;
 }
 
@@ -324,7 +444,7 @@ void wickr_transport_ctx_start(wickr_transport_ctx_t *ctx)
     if (!handshake_start_packet ||
         wickr_transport_handshake_get_status(ctx->pending_handshake) == TRANSPORT_HANDSHAKE_STATUS_FAILED) {
         wickr_transport_handshake_destroy(&ctx->pending_handshake);
-        __wickr_transport_ctx_set_error(ctx, TRANSPORT_ERROR_START_HANDSHAKE_FAILED);
+        __wickr_transport_ctx_set_handshake_error(ctx, TRANSPORT_ERROR_START_HANDSHAKE_FAILED);
         return;
     }
     
@@ -338,7 +458,7 @@ void wickr_transport_ctx_start(wickr_transport_ctx_t *ctx)
     }
     
     __wickr_transport_ctx_update_status(ctx, TRANSPORT_STATUS_INITIAL_HANDSHAKE);
-    ctx->callbacks.tx(ctx, serialized_packet);
+    __wickr_transport_ctx_tx_handshake_buffer(ctx, serialized_packet);
 }
 
 void wickr_transport_ctx_process_tx_buffer(wickr_transport_ctx_t *ctx, const wickr_buffer_t *buffer)
@@ -348,9 +468,12 @@ void wickr_transport_ctx_process_tx_buffer(wickr_transport_ctx_t *ctx, const wic
         return;
     }
     
+    TRANSPORT_STATS_TIMER_START(encode_start);
+    
     wickr_transport_packet_t *tx_packet = __wickr_transport_ctx_encode_pkt(ctx, buffer);
     
     if (!tx_packet) {
+        ctx->stats.tx_encode_failures++;
         __wickr_transport_ctx_set_error(ctx, TRANSPORT_ERROR_PACKET_ENCODE_FAILED);
         return;
     }
@@ -363,6 +486,12 @@ void wickr_transport_ctx_process_tx_buffer(wickr_transport_ctx_t *ctx, const wic
         return;
     }
     
+    TRANSPORT_STATS_TIMER_RECORD(&ctx->stats.tx_packet_time, encode_start);
+    
+    ctx->stats.tx_packets++;
+    ctx->stats.tx_bytes += buffer->length;
+    ctx->stats.tx_wire_bytes += out_buffer->length;
+    
     /* Execute the callback to provide the buffer to the user */
     ctx->callbacks.tx(ctx, out_buffer);
 }
@@ -390,7 +519,7 @@ static void __wickr_transport_ctx_process_handshake_packet(wickr_transport_ctx_t
     }
     
     if (wickr_transport_handshake_get_status(ctx->pending_handshake) == TRANSPORT_HANDSHAKE_STATUS_FAILED) {
-        __wickr_transport_ctx_set_error(ctx, TRANSPORT_ERROR_PROCESS_HANDSHAKE_FAILED);
+        __wickr_transport_ctx_set_handshake_error(ctx, TRANSPORT_ERROR_PROCESS_HANDSHAKE_FAILED);
         return;
     }
     
@@ -403,7 +532,7 @@ static void __wickr_transport_ctx_process_handshake_packet(wickr_transport_ctx_t
             return;
         }
         
-        ctx->callbacks.tx(ctx, volley_buffer);
+        __wickr_transport_ctx_tx_handshake_buffer(ctx, volley_buffer);
     }
     
 }
@@ -424,9 +553,14 @@ void wickr_transport_ctx_process_rx_buffer(wickr_transport_ctx_t *ctx, const wic
         return;
     }
     
+    ctx->stats.rx_wire_bytes += buffer->length;
+    
+    TRANSPORT_STATS_TIMER_START(decode_start);
+    
     wickr_transport_packet_t *packet = wickr_transport_packet_create_from_buffer(buffer);
     
     if (!packet) {
+        ctx->stats.rx_parse_failures++;
         __wickr_transport_ctx_set_error(ctx, TRANSPORT_ERROR_INVALID_RXDATA);
         return;
     }
@@ -434,12 +568,17 @@ void wickr_transport_ctx_process_rx_buffer(wickr_transport_ctx_t *ctx, const wic
     wickr_buffer_t *return_buffer = NULL;
     
     if (__wickr_transport_ctx_can_process_handshake(ctx) && packet->meta.body_type == TRANSPORT_PAYLOAD_TYPE_HANDSHAKE) {
+        ctx->stats.handshake_rx_packets++;
         __wickr_transport_ctx_process_handshake_packet(ctx, packet);
     } else if (ctx->rx_stream) {
         return_buffer = __wickr_transport_ctx_decode_pkt(ctx, packet);
         
         if (!return_buffer) {
             __wickr_transport_ctx_set_error(ctx, TRANSPORT_ERROR_PACKET_DECODE_FAILED);
+        } else {
+            TRANSPORT_STATS_TIMER_RECORD(&ctx->stats.rx_packet_time, decode_start);
+            ctx->stats.rx_packets++;
+            ctx->stats.rx_bytes += return_buffer->length;
         }
     } else {
         __wickr_transport_ctx_set_error(ctx, TRANSPORT_ERROR_BAD_RX_STATE);
@@ -487,3 +626,56 @@ wickr_transport_error wickr_transport_ctx_get_last_error(const wickr_transport_c
 {
     return ctx ? ctx->err : TRANSPORT_ERROR_NONE;
 }
+
+wickr_transport_stats_t wickr_transport_ctx_get_stats(const wickr_transport_ctx_t *ctx)
+{
+    if (!ctx) {
+        wickr_transport_stats_t empty = { 0 };
+        return empty;
+    }
+    
+    return ctx->stats;
+}
+
+void wickr_transport_ctx_set_ticket_key(wickr_transport_ctx_t *ctx, wickr_cipher_key_t *ticket_key)
+{
+    if (!ctx) {
+        return;
+    }
+    
+    wickr_cipher_key_destroy(&ctx->ticket_key);
+    ctx->ticket_key = ticket_key;
+}
+
+void wickr_transport_ctx_set_resumption(wickr_transport_ctx_t *ctx, wickr_transport_resumption_t *resumption)
+{
+    if (!ctx) {
+        return;
+    }
+    
+    wickr_transport_resumption_destroy(&ctx->resumption);
+    ctx->resumption = resumption;
+}
+
+const wickr_transport_resumption_t *wickr_transport_ctx_get_resumption(const wickr_transport_ctx_t *ctx)
+{
+    return ctx ? ctx->resumption : NULL;
+}
+
+void wickr_transport_ctx_set_compact_packets(wickr_transport_ctx_t *ctx, bool enabled)
+{
+    if (!ctx) {
+        return;
+    }
+    
+    if (enabled) {
+        ctx->handshake_flags |= TRANSPORT_HANDSHAKE_FLAG_COMPACT_PACKETS;
+    } else {
+        ctx->handshake_flags &= ~TRANSPORT_HANDSHAKE_FLAG_COMPACT_PACKETS;
+    }
+}
+
+bool wickr_transport_ctx_uses_compact_packets(const wickr_transport_ctx_t *ctx)
+{
+    return ctx ? (ctx->session_flags & TRANSPORT_HANDSHAKE_FLAG_COMPACT_PACKETS) != 0 : false;
+}
@@ -1,6 +1,7 @@
 
 #include "transport_handshake.h"
 #include "memory.h"
+#include "private/proto_arena_priv.h"
 #include "private/transport_priv.h"
 #include "private/identity_priv.h"
 #include "private/transport_handshake_priv.h"
@@ -10,10 +11,15 @@
 #include "private/transport_root_key_priv.h"
 #include "private/buffer_priv.h"
 #include "transport_packet.h"
+#include "transport_resumption.h"
+#include "private/transport_resumption_priv.h"
+#include <time.h>
 
 struct wickr_transport_handshake_res_t {
     wickr_stream_key_t *local_key;
     wickr_stream_key_t *remote_key;
+    wickr_transport_resumption_t *resumption;
+    uint64_t flags;
 };
 
 wickr_transport_handshake_res_t *wickr_transport_handshake_res_create(wickr_stream_key_t *local_key,
@@ -55,8 +61,20 @@ wickr_transport_handshake_res_t *wickr_transport_handshake_res_copy(const wickr_
     if (!copy) {
         wickr_stream_key_destroy(&local_copy);
         wickr_stream_key_destroy(&remote_copy);
+        return NULL;
+    }
+    
+    if (res->resumption) {
+        copy->resumption = wickr_transport_resumption_copy(res->resumption);
+        
+        if (!copy->resumption) {
+            wickr_transport_handshake_res_destroy(&copy);
+            return NULL;
+        }
     }
     
+    copy->flags = res->flags;
+    
     return copy;
 }
 
@@ -68,6 +86,7 @@ void wickr_transport_handshake_res_destroy(wickr_transport_handshake_res_t **res
     
     wickr_stream_key_destroy(&(*res)->local_key);
     wickr_stream_key_destroy(&(*res)->remote_key);
+    wickr_transport_resumption_destroy(&(*res)->resumption);
     
     wickr_free(*res);
     *res = NULL;
@@ -83,15 +102,25 @@ const wickr_stream_key_t *wickr_transport_handshake_res_get_remote_key(const wic
     return res ? res->remote_key : NULL;
 }
 
+const wickr_transport_resumption_t *wickr_transport_handshake_res_get_resumption(const wickr_transport_handshake_res_t *res)
+{
+    return res ? res->resumption : NULL;
+}
+
+uint64_t wickr_transport_handshake_res_get_flags(const wickr_transport_handshake_res_t *res)
+{
+    return res ? res->flags : 0;
+}
+
 static wickr_transport_handshake_t *__wickr_transport_handshake_create(wickr_crypto_engine_t engine,
                                                                        wickr_identity_chain_t *local_identity,
                                                                        wickr_identity_chain_t *remote_identity,
-                                                                       wickr_array_t *packet_list,
+                                                                       wickr_digest_ctx_t *transcript,
                                                                        wickr_transport_handshake_identity_callback identity_callback,
                                                                        uint32_t evo_count,
                                                                        void *user)
 {
-    if (!local_identity || identity_callback == 0 || !packet_list || evo_count == 0) {
+    if (!local_identity || identity_callback == 0 || !transcript || evo_count == 0) {
         return NULL;
     }
     
@@ -108,9 +137,12 @@ static wickr_transport_handshake_t *__wickr_transport_handshake_create(wickr_cry
     handshake->local_identity = local_identity;
     handshake->remote_identity = remote_identity;
     handshake->identity_callback = identity_callback;
-    handshake->packet_list = packet_list;
+    handshake->transcript = transcript;
     handshake->evo_count = evo_count;
     handshake->status = TRANSPORT_HANDSHAKE_STATUS_UNKNOWN;
+#ifdef WICKR_TRANSPORT_STATS_TIMING
+    handshake->start_time_ns = wickr_clock_monotonic_ns();
+#endif
     
     return handshake;
 }
@@ -122,21 +154,18 @@ wickr_transport_handshake_t *wickr_transport_handshake_create(wickr_crypto_engin
                                                               uint32_t evo_count,
                                                               void *user)
 {
-    wickr_array_t *packet_list = wickr_array_new(2,
-                                                 0,
-                                                 (wickr_array_copy_func)wickr_buffer_copy,
-                                                 (wickr_array_destroy_func)wickr_buffer_destroy);
+    wickr_digest_ctx_t *transcript = engine.wickr_crypto_engine_digest_ctx_create(DIGEST_SHA_512);
     
-    if (!packet_list) {
+    if (!transcript) {
         return NULL;
     }
     
     wickr_transport_handshake_t *return_handshake = __wickr_transport_handshake_create(engine, local_identity,
-                                                                                       remote_identity, packet_list,
+                                                                                       remote_identity, transcript,
                                                                                        identity_callback, evo_count, user);
     
     if (!return_handshake) {
-        wickr_array_destroy(&packet_list, true);
+        engine.wickr_crypto_engine_digest_ctx_destroy(&transcript);
     }
     
     return return_handshake;
@@ -150,21 +179,21 @@ wickr_transport_handshake_t *wickr_transport_handshake_copy(const wickr_transpor
     
     wickr_identity_chain_t *local_copy = wickr_identity_chain_copy(handshake->local_identity);
     wickr_identity_chain_t *remote_copy = wickr_identity_chain_copy(handshake->remote_identity);
-    wickr_array_t *packet_list_copy = wickr_array_copy(handshake->packet_list, true);
+    wickr_digest_ctx_t *transcript_copy = handshake->engine.wickr_crypto_engine_digest_ctx_copy(handshake->transcript);
     
     if (!local_copy ||
         (!remote_copy && handshake->remote_identity) ||
-        !packet_list_copy) {
+        !transcript_copy) {
         wickr_identity_chain_destroy(&local_copy);
         wickr_identity_chain_destroy(&remote_copy);
-        wickr_array_destroy(&packet_list_copy, true);
+        handshake->engine.wickr_crypto_engine_digest_ctx_destroy(&transcript_copy);
         return NULL;
     }
     
     wickr_transport_handshake_t *copy = __wickr_transport_handshake_create(handshake->engine,
                                                                            local_copy,
                                                                            remote_copy,
-                                                                           packet_list_copy,
+                                                                           transcript_copy,
                                                                            handshake->identity_callback,
                                                                            handshake->evo_count,
                                                                            handshake->user);
@@ -172,10 +201,21 @@ wickr_transport_handshake_t *wickr_transport_handshake_copy(const wickr_transpor
     if (!copy) {
         wickr_identity_chain_destroy(&local_copy);
         wickr_identity_chain_destroy(&remote_copy);
-        wickr_array_destroy(&packet_list_copy, true);
+        handshake->engine.wickr_crypto_engine_digest_ctx_destroy(&transcript_copy);
+        return NULL;
+    }
+    
+    copy->transcript_len = handshake->transcript_len;
+    
+    wickr_buffer_t *local_identity_data_copy = wickr_buffer_copy(handshake->local_identity_data);
+    
+    if (handshake->local_identity_data && !local_identity_data_copy) {
+        wickr_transport_handshake_destroy(&copy);
         return NULL;
     }
     
+    copy->local_identity_data = local_identity_data_copy;
+    
     wickr_transport_root_key_t *root_key_copy = wickr_transport_root_key_copy(handshake->root_key);
     
     if (handshake->root_key && !root_key_copy) {
@@ -200,12 +240,37 @@ wickr_transport_handshake_t *wickr_transport_handshake_copy(const wickr_transpor
         return NULL;
     }
     
+    wickr_cipher_key_t *ticket_key_copy = wickr_cipher_key_copy(handshake->ticket_key);
+    wickr_transport_resumption_t *resumption_copy = wickr_transport_resumption_copy(handshake->resumption);
+    wickr_buffer_t *resumption_ticket_copy = wickr_buffer_copy(handshake->resumption_ticket);
+    
+    if ((handshake->ticket_key && !ticket_key_copy) ||
+        (handshake->resumption && !resumption_copy) ||
+        (handshake->resumption_ticket && !resumption_ticket_copy)) {
+        wickr_cipher_key_destroy(&ticket_key_copy);
+        wickr_transport_resumption_destroy(&resumption_copy);
+        wickr_buffer_destroy(&resumption_ticket_copy);
+        wickr_ec_key_destroy(&local_ephemeral_key_copy);
+        wickr_transport_root_key_destroy(&root_key_copy);
+        wickr_transport_handshake_destroy(&copy);
+        wickr_transport_packet_destroy(&transport_packet_copy);
+        return NULL;
+    }
+    
+    copy->ticket_key = ticket_key_copy;
+    copy->resumption = resumption_copy;
+    copy->resumption_ticket = resumption_ticket_copy;
     copy->local_ephemeral_key = local_ephemeral_key_copy;
     copy->pending_identity_verify_packet = transport_packet_copy;
     copy->root_key = root_key_copy;
     copy->status = handshake->status;
     copy->is_initiator = handshake->is_initiator;
     copy->protocol_version = handshake->protocol_version;
+    copy->local_flags = handshake->local_flags;
+    copy->remote_flags = handshake->remote_flags;
+#ifdef WICKR_TRANSPORT_STATS_TIMING
+    copy->start_time_ns = handshake->start_time_ns;
+#endif
     
     return copy;
 }
@@ -218,46 +283,147 @@ void wickr_transport_handshake_destroy(wickr_transport_handshake_t **handshake)
     
     wickr_identity_chain_destroy(&(*handshake)->local_identity);
     wickr_identity_chain_destroy(&(*handshake)->remote_identity);
-    wickr_array_destroy(&(*handshake)->packet_list, true);
+    (*handshake)->engine.wickr_crypto_engine_digest_ctx_destroy(&(*handshake)->transcript);
+    wickr_buffer_destroy(&(*handshake)->local_identity_data);
     wickr_ec_key_destroy(&(*handshake)->local_ephemeral_key);
     wickr_transport_root_key_destroy(&(*handshake)->root_key);
     wickr_transport_packet_destroy(&(*handshake)->pending_identity_verify_packet);
+    wickr_cipher_key_destroy(&(*handshake)->ticket_key);
+    wickr_transport_resumption_destroy(&(*handshake)->resumption);
+    wickr_buffer_destroy(&(*handshake)->resumption_ticket);
     
     wickr_free(*handshake);
     *handshake = NULL;
 }
 
+static bool __wickr_transport_handshake_record_packet(wickr_transport_handshake_t *handshake,
+                                                     const wickr_transport_packet_t *packet,
+                                                     uint8_t packet_num)
+{
+    /* The transcript is a running hash, so packets must be recorded in the order they appear in the handshake */
+    if (!packet->network_buffer || packet_num != handshake->transcript_len) {
+        return false;
+    }
+    
+    if (!handshake->engine.wickr_crypto_engine_digest_ctx_update(handshake->transcript, packet->network_buffer)) {
+        return false;
+    }
+    
+    handshake->transcript_len++;
+    
+    return true;
+}
+
+static bool __wickr_transport_handshake_reset_transcript(wickr_transport_handshake_t *handshake)
+{
+    wickr_digest_ctx_t *transcript = handshake->engine.wickr_crypto_engine_digest_ctx_create(DIGEST_SHA_512);
+    
+    if (!transcript) {
+        return false;
+    }
+    
+    handshake->engine.wickr_crypto_engine_digest_ctx_destroy(&handshake->transcript);
+    handshake->transcript = transcript;
+    handshake->transcript_len = 0;
+    
+    return true;
+}
+
 static wickr_transport_packet_t *__wickr_transport_handshake_build_signed_packet(wickr_transport_handshake_t *handshake,
                                                                                  const Wickr__Proto__HandshakeV1 *packet_proto,
                                                                                  uint8_t packet_num)
 {
     wickr_transport_packet_t *handshake_pkt = wickr_proto_handshake_to_packet(packet_proto);
     
+    if (handshake_pkt) {
+        handshake_pkt->meta.body_meta.handshake.flags = handshake->local_flags;
+    }
+    
     /* Sign the handshake packet */
     if (!handshake_pkt || !wickr_transport_packet_sign(handshake_pkt, &handshake->engine, handshake->local_identity)) {
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
         return NULL;
     }
     
-    /* Record this packet into the packet list for later use */
-    wickr_array_set_item(handshake->packet_list, packet_num, handshake_pkt->network_buffer, true); //TODO: Use hash builder instead of array
+    /* Record this packet into the transcript for later use */
+    if (!__wickr_transport_handshake_record_packet(handshake, handshake_pkt, packet_num)) {
+        wickr_transport_packet_destroy(&handshake_pkt);
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
     
     return handshake_pkt;
 }
 
-wickr_transport_packet_t *wickr_transport_handshake_start(wickr_transport_handshake_t *handshake)
+static wickr_transport_packet_t *__wickr_transport_handshake_build_unsigned_packet(wickr_transport_handshake_t *handshake,
+                                                                                   const Wickr__Proto__HandshakeV1 *packet_proto)
 {
-    if (!handshake) {
+    wickr_transport_packet_t *handshake_pkt = wickr_proto_handshake_to_packet(packet_proto);
+    
+    if (!handshake_pkt) {
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
         return NULL;
     }
     
-    if (handshake->status != TRANSPORT_HANDSHAKE_STATUS_UNKNOWN) {
+    handshake_pkt->meta.body_meta.handshake.flags = handshake->local_flags;
+    
+    /* Resumption packets are protected by knowledge of the resumption root key instead of a signature */
+    handshake_pkt->network_buffer = wickr_transport_packet_serialize(handshake_pkt);
+    
+    if (!handshake_pkt->network_buffer) {
+        wickr_transport_packet_destroy(&handshake_pkt);
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
         return NULL;
     }
     
-    handshake->is_initiator = true;
-    handshake->status = TRANSPORT_HANDSHAKE_STATUS_IN_PROGRESS;
+    return handshake_pkt;
+}
+
+static wickr_transport_packet_t *__wickr_transport_handshake_start_resume(wickr_transport_handshake_t *handshake)
+{
+    wickr_buffer_t *nonce = handshake->engine.wickr_crypto_engine_crypto_random(TRANSPORT_RESUMPTION_NONCE_LEN);
+    
+    if (!nonce) {
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
+    
+    Wickr__Proto__HandshakeV1__ResumeSeed *resume_seed = wickr_proto_handshake_resume_seed_create(handshake->resumption->ticket,
+                                                                                                   nonce);
+    wickr_buffer_destroy(&nonce);
+    
+    if (!resume_seed) {
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
+    
+    Wickr__Proto__HandshakeV1 *handshake_resume = wickr_proto_handshake_create_with_resume_seed(resume_seed);
+    
+    if (!handshake_resume) {
+        wickr_proto_handshake_resume_seed_free(resume_seed);
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
+    
+    wickr_transport_packet_t *handshake_pkt = __wickr_transport_handshake_build_unsigned_packet(handshake, handshake_resume);
+    wickr_proto_handshake_free(handshake_resume);
+    
+    /* Record this packet into the transcript for later use */
+    if (handshake_pkt && !__wickr_transport_handshake_record_packet(handshake, handshake_pkt, 0)) {
+        wickr_transport_packet_destroy(&handshake_pkt);
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+    }
+    
+    return handshake_pkt;
+}
+
+static wickr_transport_packet_t *__wickr_transport_handshake_start_full(wickr_transport_handshake_t *handshake)
+{
+    /* Discard anything recorded by a rejected resumption attempt */
+    if (handshake->transcript_len != 0 && !__wickr_transport_handshake_reset_transcript(handshake)) {
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
     
     /* Generate a new ephemeral key for the handshake */
     handshake->local_ephemeral_key = handshake->engine.wickr_crypto_engine_ec_rand_key(handshake->engine.default_curve);
@@ -299,11 +465,43 @@ wickr_transport_packet_t *wickr_transport_handshake_start(wickr_transport_handsh
     return handshake_pkt;
 }
 
+wickr_transport_packet_t *wickr_transport_handshake_start(wickr_transport_handshake_t *handshake)
+{
+    if (!handshake) {
+        return NULL;
+    }
+    
+    if (handshake->status != TRANSPORT_HANDSHAKE_STATUS_UNKNOWN) {
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
+    
+    handshake->is_initiator = true;
+    handshake->status = TRANSPORT_HANDSHAKE_STATUS_IN_PROGRESS;
+    
+    /* If a cached resumption is available, attempt to skip the key exchange */
+    if (handshake->resumption) {
+        return __wickr_transport_handshake_start_resume(handshake);
+    }
+    
+    return __wickr_transport_handshake_start_full(handshake);
+}
+
+static const wickr_buffer_t *__wickr_transport_handshake_local_identity_data(wickr_transport_handshake_t *handshake)
+{
+    /* The local identity is the same for every handshake, so it is only serialized once */
+    if (!handshake->local_identity_data) {
+        handshake->local_identity_data = wickr_identity_chain_serialize(handshake->local_identity);
+    }
+    
+    return handshake->local_identity_data;
+}
+
 static wickr_kdf_meta_t *__wickr_transport_handshake_kdf_meta_gen(wickr_transport_handshake_t *handshake,
                                                                   wickr_ec_key_t *local_ephemeral,
                                                                   wickr_ec_key_t *remote_ephemeral)
 {
-    wickr_buffer_t *local_identity_data = wickr_identity_chain_serialize(handshake->local_identity);
+    const wickr_buffer_t *local_identity_data = __wickr_transport_handshake_local_identity_data(handshake);
     
     if (!local_identity_data) {
         return NULL;
@@ -312,11 +510,10 @@ static wickr_kdf_meta_t *__wickr_transport_handshake_kdf_meta_gen(wickr_transpor
     wickr_buffer_t *remote_identity_data = wickr_identity_chain_serialize(handshake->remote_identity);
 
     if (!remote_identity_data) {
-        wickr_buffer_destroy(&local_identity_data);
         return NULL;
     }
     
-    wickr_buffer_t *components[4];
+    const wickr_buffer_t *components[4];
     
     if (handshake->is_initiator) {
         components[0] = local_identity_data;
@@ -330,18 +527,24 @@ static wickr_kdf_meta_t *__wickr_transport_handshake_kdf_meta_gen(wickr_transpor
         components[3] = local_ephemeral->pub_data;
     }
     
-    wickr_buffer_t *info_data = wickr_buffer_concat_multi(components, 4);
-    
-    wickr_buffer_destroy(&local_identity_data);
-    wickr_buffer_destroy(&remote_identity_data);
+    /* Reduce the size of info with a hash, because max length is 1024 for HKDF info */
+    wickr_digest_ctx_t *info_ctx = handshake->engine.wickr_crypto_engine_digest_ctx_create(DIGEST_SHA_512);
     
-    if (!info_data) {
+    if (!info_ctx) {
+        wickr_buffer_destroy(&remote_identity_data);
         return NULL;
     }
     
-    /* Reduce the size of info with a hash, because max length is 1024 for HKDF info */
-    wickr_buffer_t *hashed_info = handshake->engine.wickr_crypto_engine_digest(info_data, NULL, DIGEST_SHA_512);
-    wickr_buffer_destroy(&info_data);
+    bool update_success = true;
+    
+    for (int i = 0; i < 4 && update_success; i++) {
+        update_success = handshake->engine.wickr_crypto_engine_digest_ctx_update(info_ctx, components[i]);
+    }
+    
+    wickr_buffer_destroy(&remote_identity_data);
+    
+    wickr_buffer_t *hashed_info = update_success ? handshake->engine.wickr_crypto_engine_digest_ctx_final(info_ctx) : NULL;
+    handshake->engine.wickr_crypto_engine_digest_ctx_destroy(&info_ctx);
     
     if (!hashed_info) {
         return NULL;
@@ -350,7 +553,7 @@ static wickr_kdf_meta_t *__wickr_transport_handshake_kdf_meta_gen(wickr_transpor
     wickr_kdf_meta_t *kdf_meta = wickr_kdf_meta_create(KDF_HKDF_SHA512, NULL, hashed_info);
     
     if (!kdf_meta) {
-        wickr_buffer_destroy(&info_data);
+        wickr_buffer_destroy(&hashed_info);
     }
     
     return kdf_meta;
@@ -375,14 +578,11 @@ static bool __wickr_transport_handshake_process_remote_identity(wickr_transport_
 }
 
 static void __wickr_transport_handshake_process_response(wickr_transport_handshake_t *handshake,
-                                                         const wickr_transport_packet_t *packet)
+                                                         const wickr_transport_packet_t *packet,
+                                                         const Wickr__Proto__HandshakeV1 *handshake_data)
 {
-    /* Record this packet into the packet list for later use */
-    wickr_array_set_item(handshake->packet_list, 1, packet->network_buffer, true); //TODO: Use hash builder instead of array
-    
-    Wickr__Proto__HandshakeV1 *handshake_data = wickr_proto_handshake_from_packet(packet);
-    
-    if (!handshake_data) {
+    /* Record this packet into the transcript for later use */
+    if (!__wickr_transport_handshake_record_packet(handshake, packet, 1)) {
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
         return;
     }
@@ -391,13 +591,11 @@ static void __wickr_transport_handshake_process_response(wickr_transport_handsha
         !handshake_data->response->has_encrypted_response_data ||
         !handshake_data->response->has_ephemeral_pubkey) {
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         return;
     }
     
     if (!handshake->remote_identity && !handshake_data->response->id_chain) {
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         return;
     }
     
@@ -408,7 +606,6 @@ static void __wickr_transport_handshake_process_response(wickr_transport_handsha
     
     if (!encrypted_obj) {
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         return;
     }
     
@@ -417,7 +614,6 @@ static void __wickr_transport_handshake_process_response(wickr_transport_handsha
     if (!local_key_copy) {
         wickr_cipher_result_destroy(&encrypted_obj);
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         return;
     }
     
@@ -429,7 +625,6 @@ static void __wickr_transport_handshake_process_response(wickr_transport_handsha
         wickr_ec_key_destroy(&local_key_copy);
         wickr_cipher_result_destroy(&encrypted_obj);
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         return;
     }
     
@@ -442,21 +637,17 @@ static void __wickr_transport_handshake_process_response(wickr_transport_handsha
         wickr_ecdh_cipher_ctx_destroy(&cipher_ctx);
         wickr_cipher_result_destroy(&encrypted_obj);
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         return;
     }
     
     if (!__wickr_transport_handshake_process_remote_identity(handshake, packet, handshake_data->response->id_chain)) {
         wickr_ecdh_cipher_ctx_destroy(&cipher_ctx);
         wickr_cipher_result_destroy(&encrypted_obj);
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         wickr_ec_key_destroy(&remote_ephemeral_key);
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
         return;
     }
     
-    wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
-    
     wickr_kdf_meta_t *kdf_meta = __wickr_transport_handshake_kdf_meta_gen(handshake, handshake->local_ephemeral_key, remote_ephemeral_key);
     
     if (!kdf_meta) {
@@ -482,16 +673,27 @@ static void __wickr_transport_handshake_process_response(wickr_transport_handsha
         return;
     }
     
-    Wickr__Proto__HandshakeV1ResponseData *response_data = wickr_proto_handshake_response_data_from_buffer(response_buffer);
-    wickr_buffer_destroy(&response_buffer);
+    wickr_proto_arena_t proto_arena;
+    wickr_proto_arena_init(&proto_arena);
+    
+    Wickr__Proto__HandshakeV1ResponseData *response_data = wickr_proto_handshake_response_data_from_buffer(response_buffer,
+                                                                                                           &proto_arena.allocator);
+    wickr_buffer_destroy_zero(&response_buffer);
     
     if (!response_data || !response_data->root_key) {
+        wickr_proto_arena_release(&proto_arena);
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
         return;
     }
     
     handshake->root_key = wickr_transport_root_key_from_proto(response_data->root_key);
-    wickr__proto__handshake_v1_response_data__free_unpacked(response_data, NULL);
+    
+    /* Hold on to a resumption ticket if the responder issued one, it will be paired with a resumption key at finalization */
+    if (response_data->has_resumption_ticket) {
+        handshake->resumption_ticket = wickr_buffer_from_protobytes(response_data->resumption_ticket);
+    }
+    
+    wickr_proto_arena_release(&proto_arena);
     
     if (!handshake->root_key) {
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
@@ -503,23 +705,207 @@ static void __wickr_transport_handshake_process_response(wickr_transport_handsha
     }
 }
 
-static wickr_transport_packet_t *__wickr_transport_handshake_process_initial(wickr_transport_handshake_t *handshake,
-                                                                             const wickr_transport_packet_t *packet)
+static wickr_buffer_t *__wickr_transport_handshake_issue_ticket(const wickr_transport_handshake_t *handshake,
+                                                               const wickr_transport_root_key_t *root_key)
 {
-    /* Record this packet into the packet list for later use */
-    wickr_array_set_item(handshake->packet_list, 0, packet->network_buffer, true); //TODO: Use hash builder instead of array
+    if (!handshake->ticket_key || !handshake->remote_identity) {
+        return NULL;
+    }
+    
+    wickr_transport_root_key_t *resumption_key = wickr_transport_root_key_derive_resumption(root_key, &handshake->engine);
+    
+    if (!resumption_key) {
+        return NULL;
+    }
+    
+    uint64_t expiration = (uint64_t)time(NULL) + TRANSPORT_RESUMPTION_TICKET_LIFETIME;
+    
+    wickr_buffer_t *ticket = wickr_transport_resumption_ticket_seal(&handshake->engine,
+                                                                    handshake->ticket_key,
+                                                                    resumption_key,
+                                                                    handshake->remote_identity,
+                                                                    expiration);
+    
+    wickr_transport_root_key_destroy(&resumption_key);
     
-    Wickr__Proto__HandshakeV1 *handshake_data = wickr_proto_handshake_from_packet(packet);
+    return ticket;
+}
+
+static bool __wickr_transport_handshake_identity_matches(const wickr_identity_chain_t *a, const wickr_identity_chain_t *b)
+{
+    return wickr_buffer_is_equal(a->root->identifier, b->root->identifier, NULL) &&
+           wickr_buffer_is_equal(a->root->sig_key->pub_data, b->root->sig_key->pub_data, NULL) &&
+           wickr_buffer_is_equal(a->node->identifier, b->node->identifier, NULL);
+}
+
+static wickr_transport_packet_t *__wickr_transport_handshake_send_resume_response(wickr_transport_handshake_t *handshake,
+                                                                                  const wickr_buffer_t *nonce)
+{
+    bool accepted = nonce != NULL;
+    
+    Wickr__Proto__HandshakeV1__ResumeResponse *resume_response = wickr_proto_handshake_resume_response_create(accepted, nonce);
     
-    if (!handshake_data || !handshake_data->seed || !handshake_data->seed->has_ephemeral_pubkey
+    if (!resume_response) {
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
+    
+    Wickr__Proto__HandshakeV1 *handshake_return = wickr_proto_handshake_create_with_resume_response(resume_response);
+    
+    if (!handshake_return) {
+        wickr_proto_handshake_resume_response_free(resume_response);
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
+    
+    wickr_transport_packet_t *handshake_pkt = __wickr_transport_handshake_build_unsigned_packet(handshake, handshake_return);
+    wickr_proto_handshake_free(handshake_return);
+    
+    /* A rejection is not part of any transcript, the initiator will start over with a full handshake */
+    if (handshake_pkt && accepted && !__wickr_transport_handshake_record_packet(handshake, handshake_pkt, 1)) {
+        wickr_transport_packet_destroy(&handshake_pkt);
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+    }
+    
+    return handshake_pkt;
+}
+
+static wickr_transport_packet_t *__wickr_transport_handshake_process_resume_seed(wickr_transport_handshake_t *handshake,
+                                                                                 const wickr_transport_packet_t *packet,
+                                                                                 const Wickr__Proto__HandshakeV1 *handshake_data)
+{
+    const Wickr__Proto__HandshakeV1__ResumeSeed *resume_seed = handshake_data->resume_seed;
+    
+    if (!resume_seed || !resume_seed->has_ticket || !resume_seed->has_nonce ||
+        resume_seed->nonce.len != TRANSPORT_RESUMPTION_NONCE_LEN) {
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
+    
+    wickr_identity_chain_t *ticket_identity = NULL;
+    wickr_transport_root_key_t *resumption_key = NULL;
+    
+    if (handshake->ticket_key) {
+        wickr_buffer_t ticket = { .bytes = resume_seed->ticket.data, .length = resume_seed->ticket.len };
+        resumption_key = wickr_transport_resumption_ticket_open(&handshake->engine, handshake->ticket_key, &ticket,
+                                                                (uint64_t)time(NULL), &ticket_identity);
+    }
+    
+    /* A ticket issued to a different identity than the one we expect can't be used */
+    if (resumption_key && handshake->remote_identity &&
+        !__wickr_transport_handshake_identity_matches(handshake->remote_identity, ticket_identity)) {
+        wickr_transport_root_key_destroy(&resumption_key);
+    }
+    
+    /* Reject the resumption and remain in the unknown state so that the initiator can fall back to a full handshake */
+    if (!resumption_key) {
+        wickr_identity_chain_destroy(&ticket_identity);
+        return __wickr_transport_handshake_send_resume_response(handshake, NULL);
+    }
+    
+    /* The identity in the ticket was verified when the ticket was issued */
+    if (!handshake->remote_identity) {
+        handshake->remote_identity = ticket_identity;
+    } else {
+        wickr_identity_chain_destroy(&ticket_identity);
+    }
+    
+    wickr_buffer_t *nonce = handshake->engine.wickr_crypto_engine_crypto_random(TRANSPORT_RESUMPTION_NONCE_LEN);
+    
+    if (!nonce) {
+        wickr_transport_root_key_destroy(&resumption_key);
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
+    
+    /* Record this packet into the transcript for later use */
+    if (!__wickr_transport_handshake_record_packet(handshake, packet, 0)) {
+        wickr_buffer_destroy(&nonce);
+        wickr_transport_root_key_destroy(&resumption_key);
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
+    
+    wickr_transport_packet_t *handshake_pkt = __wickr_transport_handshake_send_resume_response(handshake, nonce);
+    wickr_buffer_destroy(&nonce);
+    
+    if (!handshake_pkt) {
+        wickr_transport_root_key_destroy(&resumption_key);
+        return NULL;
+    }
+    
+    handshake->root_key = resumption_key;
+    handshake->status = TRANSPORT_HANDSHAKE_STATUS_PENDING_FINALIZATION;
+    
+    if (handshake->stats) {
+        handshake->stats->handshakes_resumed++;
+    }
+    
+    return handshake_pkt;
+}
+
+static wickr_transport_packet_t *__wickr_transport_handshake_process_resume_response(wickr_transport_handshake_t *handshake,
+                                                                                     const wickr_transport_packet_t *packet,
+                                                                                     const Wickr__Proto__HandshakeV1 *handshake_data)
+{
+    const Wickr__Proto__HandshakeV1__ResumeResponse *resume_response = handshake_data->resume_response;
+    
+    if (!handshake->resumption || handshake->root_key ||
+        !resume_response || !resume_response->has_accepted) {
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
+    
+    /* The responder could not use our ticket, so discard it and start over with a full handshake */
+    if (!resume_response->accepted) {
+        wickr_transport_resumption_destroy(&handshake->resumption);
+        return __wickr_transport_handshake_start_full(handshake);
+    }
+    
+    if (!resume_response->has_nonce || resume_response->nonce.len != TRANSPORT_RESUMPTION_NONCE_LEN) {
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
+    
+    /* Record this packet into the transcript for later use */
+    if (!__wickr_transport_handshake_record_packet(handshake, packet, 1)) {
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
+    
+    handshake->root_key = wickr_transport_root_key_copy(handshake->resumption->root_key);
+    
+    if (!handshake->root_key) {
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
+    
+    handshake->status = TRANSPORT_HANDSHAKE_STATUS_PENDING_FINALIZATION;
+    
+    if (handshake->stats) {
+        handshake->stats->handshakes_resumed++;
+    }
+    
+    return NULL;
+}
+
+static wickr_transport_packet_t *__wickr_transport_handshake_process_initial(wickr_transport_handshake_t *handshake,
+                                                                             const wickr_transport_packet_t *packet,
+                                                                             const Wickr__Proto__HandshakeV1 *handshake_data)
+{
+    /* Record this packet into the transcript for later use */
+    if (!__wickr_transport_handshake_record_packet(handshake, packet, 0)) {
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
+    
+    if (!handshake_data->seed || !handshake_data->seed->has_ephemeral_pubkey
         || !handshake_data->seed->has_identity_required) {
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
         return NULL;
     }
     
     if (!__wickr_transport_handshake_process_remote_identity(handshake, packet, handshake_data->seed->id_chain)) {
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
         return NULL;
     }
@@ -529,7 +915,6 @@ static wickr_transport_packet_t *__wickr_transport_handshake_process_initial(wic
     /* Encrypt a response to the ephemeral key provided by the handshake seed */
     
     if (!key_data) {
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
         return NULL;
     }
@@ -538,7 +923,6 @@ static wickr_transport_packet_t *__wickr_transport_handshake_process_initial(wic
     wickr_buffer_destroy(&key_data);
     
     if (!ephemeral_key) {
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
         return NULL;
     }
@@ -546,7 +930,6 @@ static wickr_transport_packet_t *__wickr_transport_handshake_process_initial(wic
     wickr_ecdh_cipher_ctx_t *cipher_ctx = wickr_ecdh_cipher_ctx_create(handshake->engine, ephemeral_key->curve, handshake->engine.default_cipher);
     
     if (!cipher_ctx) {
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         wickr_ec_key_destroy(&ephemeral_key);
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
         return NULL;
@@ -558,15 +941,18 @@ static wickr_transport_packet_t *__wickr_transport_handshake_process_initial(wic
                                                                  handshake->evo_count, handshake->evo_count);
     
     if (!handshake->root_key) {
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
         return NULL;
     }
     
-    Wickr__Proto__HandshakeV1ResponseData *response_data = wickr_proto_handshake_response_data_create(handshake->root_key);
+    /* Issue a resumption ticket along with the root key so that the initiator can skip the key exchange next time */
+    wickr_buffer_t *resumption_ticket = __wickr_transport_handshake_issue_ticket(handshake, handshake->root_key);
+    
+    Wickr__Proto__HandshakeV1ResponseData *response_data = wickr_proto_handshake_response_data_create(handshake->root_key,
+                                                                                                      resumption_ticket);
+    wickr_buffer_destroy(&resumption_ticket);
     
     if (!response_data) {
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         wickr_ecdh_cipher_ctx_destroy(&cipher_ctx);
         wickr_ec_key_destroy(&ephemeral_key);
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
@@ -577,7 +963,6 @@ static wickr_transport_packet_t *__wickr_transport_handshake_process_initial(wic
     wickr_proto_handshake_response_data_free(response_data);
     
     if (!serialized_response_data) {
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         wickr_ecdh_cipher_ctx_destroy(&cipher_ctx);
         wickr_ec_key_destroy(&ephemeral_key);
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
@@ -592,7 +977,6 @@ static wickr_transport_packet_t *__wickr_transport_handshake_process_initial(wic
     wickr_ec_key_destroy(&ephemeral_key);
     
     if (!result) {
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         wickr_ecdh_cipher_ctx_destroy(&cipher_ctx);
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
         return NULL;
@@ -602,7 +986,6 @@ static wickr_transport_packet_t *__wickr_transport_handshake_process_initial(wic
     wickr_cipher_result_destroy(&result);
     
     if (!response_buffer) {
-        wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
         wickr_ecdh_cipher_ctx_destroy(&cipher_ctx);
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
         return NULL;
@@ -613,7 +996,6 @@ static wickr_transport_packet_t *__wickr_transport_handshake_process_initial(wic
     Wickr__Proto__HandshakeV1__Response *response = wickr_proto_handshake_response_create(cipher_ctx->local_key->pub_data,
                                                                                           response_buffer, response_identity);
     
-    wickr__proto__handshake_v1__free_unpacked(handshake_data, NULL);
     wickr_ecdh_cipher_ctx_destroy(&cipher_ctx);
     wickr_buffer_destroy(&response_buffer);
     
@@ -646,16 +1028,49 @@ static wickr_transport_packet_t *__wickr_transport_handshake_process_packet(wick
         return NULL;
     }
     
+    wickr_proto_arena_t proto_arena;
+    wickr_proto_arena_init(&proto_arena);
+    
+    Wickr__Proto__HandshakeV1 *handshake_data = wickr_proto_handshake_from_packet(packet, &proto_arena.allocator);
+    
+    if (!handshake_data) {
+        wickr_proto_arena_release(&proto_arena);
+        handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+        return NULL;
+    }
+    
+    /* Flags are bound to the transcript along with the rest of the packet, so they can't be altered in transit */
+    handshake->remote_flags = packet->meta.body_meta.handshake.flags;
+    
+    wickr_transport_packet_t *return_packet = NULL;
+    
     switch (handshake->status) {
         case TRANSPORT_HANDSHAKE_STATUS_UNKNOWN:
-            return __wickr_transport_handshake_process_initial(handshake, packet);
+            if (handshake_data->payload_case == WICKR__PROTO__HANDSHAKE_V1__PAYLOAD_SEED) {
+                return_packet = __wickr_transport_handshake_process_initial(handshake, packet, handshake_data);
+            } else if (handshake_data->payload_case == WICKR__PROTO__HANDSHAKE_V1__PAYLOAD_RESUME_SEED) {
+                return_packet = __wickr_transport_handshake_process_resume_seed(handshake, packet, handshake_data);
+            } else {
+                handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+            }
+            break;
         case TRANSPORT_HANDSHAKE_STATUS_IN_PROGRESS:
-            __wickr_transport_handshake_process_response(handshake, packet);
-            return NULL;
+            if (handshake_data->payload_case == WICKR__PROTO__HANDSHAKE_V1__PAYLOAD_RESPONSE) {
+                __wickr_transport_handshake_process_response(handshake, packet, handshake_data);
+            } else if (handshake_data->payload_case == WICKR__PROTO__HANDSHAKE_V1__PAYLOAD_RESUME_RESPONSE) {
+                return_packet = __wickr_transport_handshake_process_resume_response(handshake, packet, handshake_data);
+            } else {
+                handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
+            }
+            break;
         default:
             handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
-            return NULL;
+            break;
     }
+    
+    wickr_proto_arena_release(&proto_arena);
+    
+    return return_packet;
 }
 
 wickr_transport_packet_t *wickr_transport_handshake_verify_identity(const wickr_transport_handshake_t *handshake, bool is_valid)
@@ -748,15 +1163,12 @@ wickr_transport_handshake_res_t *wickr_transport_handshake_finalize(wickr_transp
         return NULL;
     }
     
-    wickr_buffer_t *transcript_data = wickr_buffer_concat(wickr_array_fetch_item(handshake->packet_list, 0, false), wickr_array_fetch_item(handshake->packet_list, 1, false));
-    
-    if (!transcript_data) {
+    if (handshake->transcript_len != 2) {
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
         return NULL;
     }
     
-    wickr_buffer_t *transcript_hash = handshake->engine.wickr_crypto_engine_digest(transcript_data, NULL, DIGEST_SHA_512);
-    wickr_buffer_destroy(&transcript_data);
+    wickr_buffer_t *transcript_hash = handshake->engine.wickr_crypto_engine_digest_ctx_final(handshake->transcript);
     
     if (!transcript_hash) {
         handshake->status = TRANSPORT_HANDSHAKE_STATUS_FAILED;
@@ -795,8 +1207,32 @@ wickr_transport_handshake_res_t *wickr_transport_handshake_finalize(wickr_transp
         return NULL;
     }
     
+    /* A resumed session keeps using its ticket, a full handshake pairs a newly issued ticket with a key derived from the root key */
+    if (handshake->resumption) {
+        result->resumption = wickr_transport_resumption_copy(handshake->resumption);
+    } else if (handshake->resumption_ticket) {
+        wickr_transport_root_key_t *resumption_key = wickr_transport_root_key_derive_resumption(handshake->root_key,
+                                                                                               &handshake->engine);
+        wickr_buffer_t *ticket_copy = wickr_buffer_copy(handshake->resumption_ticket);
+        
+        result->resumption = wickr_transport_resumption_create(ticket_copy, resumption_key);
+        
+        if (!result->resumption) {
+            wickr_transport_root_key_destroy(&resumption_key);
+            wickr_buffer_destroy(&ticket_copy);
+        }
+    }
+    
+    result->flags = handshake->local_flags & handshake->remote_flags;
     handshake->status = TRANSPORT_HANDSHAKE_STATUS_COMPLETE;
     
+#ifdef WICKR_TRANSPORT_STATS_TIMING
+    if (handshake->stats) {
+        wickr_transport_histogram_record(&handshake->stats->handshake_time,
+                                         wickr_clock_monotonic_ns() - handshake->start_time_ns);
+    }
+#endif
+    
     return result;
 }
 
@@ -827,3 +1263,52 @@ void wickr_transport_set_user_data(wickr_transport_handshake_t *handshake, void
     }
     handshake->user = user;
 }
+
+void wickr_transport_handshake_set_ticket_key(wickr_transport_handshake_t *handshake, wickr_cipher_key_t *ticket_key)
+{
+    if (!handshake) {
+        return;
+    }
+    
+    wickr_cipher_key_destroy(&handshake->ticket_key);
+    handshake->ticket_key = ticket_key;
+}
+
+void wickr_transport_handshake_set_resumption(wickr_transport_handshake_t *handshake, wickr_transport_resumption_t *resumption)
+{
+    if (!handshake) {
+        return;
+    }
+    
+    wickr_transport_resumption_destroy(&handshake->resumption);
+    handshake->resumption = resumption;
+}
+
+void wickr_transport_handshake_set_local_identity_data(wickr_transport_handshake_t *handshake,
+                                                       wickr_buffer_t *local_identity_data)
+{
+    if (!handshake) {
+        return;
+    }
+    
+    wickr_buffer_destroy(&handshake->local_identity_data);
+    handshake->local_identity_data = local_identity_data;
+}
+
+void wickr_transport_handshake_set_stats(wickr_transport_handshake_t *handshake, wickr_transport_stats_t *stats)
+{
+    if (!handshake) {
+        return;
+    }
+    
+    handshake->stats = stats;
+}
+
+void wickr_transport_handshake_set_flags(wickr_transport_handshake_t *handshake, uint64_t flags)
+{
+    if (!handshake) {
+        return;
+    }
+    
+    handshake->local_flags = flags;
+}
@@ -46,7 +46,8 @@ void wickr_proto_handshake_seed_free(Wickr__Proto__HandshakeV1__Seed *seed)
     wickr_free(seed);
 }
 
-Wickr__Proto__HandshakeV1ResponseData *wickr_proto_handshake_response_data_create(const wickr_transport_root_key_t *root_key)
+Wickr__Proto__HandshakeV1ResponseData *wickr_proto_handshake_response_data_create(const wickr_transport_root_key_t *root_key,
+                                                                                   const wickr_buffer_t *resumption_ticket)
 {
     if (!root_key) {
         return NULL;
@@ -68,6 +69,15 @@ Wickr__Proto__HandshakeV1ResponseData *wickr_proto_handshake_response_data_creat
     wickr__proto__handshake_v1_response_data__init(res_data);
     res_data->root_key = root_key_proto;
     
+    if (resumption_ticket) {
+        if (!wickr_buffer_to_protobytes(&res_data->resumption_ticket, resumption_ticket)) {
+            wickr_transport_root_key_proto_free(root_key_proto);
+            wickr_free(res_data);
+            return NULL;
+        }
+        res_data->has_resumption_ticket = true;
+    }
+    
     return res_data;
 }
 
@@ -88,13 +98,13 @@ wickr_buffer_t *wickr_proto_handshake_response_data_serialize(const Wickr__Proto
     return response_data_buffer;
 }
 
-Wickr__Proto__HandshakeV1ResponseData *wickr_proto_handshake_response_data_from_buffer(const wickr_buffer_t *buffer)
+Wickr__Proto__HandshakeV1ResponseData *wickr_proto_handshake_response_data_from_buffer(const wickr_buffer_t *buffer, ProtobufCAllocator *allocator)
 {
     if (!buffer) {
         return NULL;
     }
     
-    return wickr__proto__handshake_v1_response_data__unpack(NULL, buffer->length, buffer->bytes);
+    return wickr__proto__handshake_v1_response_data__unpack(allocator, buffer->length, buffer->bytes);
 }
 
 void wickr_proto_handshake_response_data_free(Wickr__Proto__HandshakeV1ResponseData *data)
@@ -104,6 +114,7 @@ void wickr_proto_handshake_response_data_free(Wickr__Proto__HandshakeV1ResponseD
     }
     
     wickr_transport_root_key_proto_free(data->root_key);
+    wickr_free(data->resumption_ticket.data);
     wickr_free(data);
 }
 
@@ -159,6 +170,89 @@ void wickr_proto_handshake_response_free(Wickr__Proto__HandshakeV1__Response *re
     wickr_free(response);
 }
 
+Wickr__Proto__HandshakeV1__ResumeSeed *wickr_proto_handshake_resume_seed_create(const wickr_buffer_t *ticket,
+                                                                                 const wickr_buffer_t *nonce)
+{
+    if (!ticket || !nonce) {
+        return NULL;
+    }
+    
+    Wickr__Proto__HandshakeV1__ResumeSeed *resume_seed = wickr_alloc_zero(sizeof(Wickr__Proto__HandshakeV1__ResumeSeed));
+    
+    if (!resume_seed) {
+        return NULL;
+    }
+    
+    wickr__proto__handshake_v1__resume_seed__init(resume_seed);
+    
+    if (!wickr_buffer_to_protobytes(&resume_seed->ticket, ticket)) {
+        wickr_free(resume_seed);
+        return NULL;
+    }
+    
+    if (!wickr_buffer_to_protobytes(&resume_seed->nonce, nonce)) {
+        wickr_free(resume_seed->ticket.data);
+        wickr_free(resume_seed);
+        return NULL;
+    }
+    
+    resume_seed->has_ticket = true;
+    resume_seed->has_nonce = true;
+    
+    return resume_seed;
+}
+
+void wickr_proto_handshake_resume_seed_free(Wickr__Proto__HandshakeV1__ResumeSeed *resume_seed)
+{
+    if (!resume_seed) {
+        return;
+    }
+    
+    wickr_free(resume_seed->ticket.data);
+    wickr_free(resume_seed->nonce.data);
+    wickr_free(resume_seed);
+}
+
+Wickr__Proto__HandshakeV1__ResumeResponse *wickr_proto_handshake_resume_response_create(bool accepted,
+                                                                                         const wickr_buffer_t *nonce)
+{
+    /* A nonce is only required if the resumption was accepted */
+    if (accepted && !nonce) {
+        return NULL;
+    }
+    
+    Wickr__Proto__HandshakeV1__ResumeResponse *resume_response = wickr_alloc_zero(sizeof(Wickr__Proto__HandshakeV1__ResumeResponse));
+    
+    if (!resume_response) {
+        return NULL;
+    }
+    
+    wickr__proto__handshake_v1__resume_response__init(resume_response);
+    
+    if (nonce) {
+        if (!wickr_buffer_to_protobytes(&resume_response->nonce, nonce)) {
+            wickr_free(resume_response);
+            return NULL;
+        }
+        resume_response->has_nonce = true;
+    }
+    
+    resume_response->accepted = accepted;
+    resume_response->has_accepted = true;
+    
+    return resume_response;
+}
+
+void wickr_proto_handshake_resume_response_free(Wickr__Proto__HandshakeV1__ResumeResponse *resume_response)
+{
+    if (!resume_response) {
+        return;
+    }
+    
+    wickr_free(resume_response->nonce.data);
+    wickr_free(resume_response);
+}
+
 Wickr__Proto__HandshakeV1 *wickr_proto_handshake_create_with_seed(Wickr__Proto__HandshakeV1__Seed *seed)
 {
     if (!seed) {
@@ -199,6 +293,46 @@ Wickr__Proto__HandshakeV1 *wickr_proto_handshake_create_with_response(Wickr__Pro
     return proto_handshake;
 }
 
+Wickr__Proto__HandshakeV1 *wickr_proto_handshake_create_with_resume_seed(Wickr__Proto__HandshakeV1__ResumeSeed *resume_seed)
+{
+    if (!resume_seed) {
+        return NULL;
+    }
+    
+    Wickr__Proto__HandshakeV1 *proto_handshake = wickr_alloc_zero(sizeof(Wickr__Proto__HandshakeV1));
+    
+    if (!proto_handshake) {
+        return NULL;
+    }
+    
+    wickr__proto__handshake_v1__init(proto_handshake);
+    
+    proto_handshake->payload_case = WICKR__PROTO__HANDSHAKE_V1__PAYLOAD_RESUME_SEED;
+    proto_handshake->resume_seed = resume_seed;
+    
+    return proto_handshake;
+}
+
+Wickr__Proto__HandshakeV1 *wickr_proto_handshake_create_with_resume_response(Wickr__Proto__HandshakeV1__ResumeResponse *resume_response)
+{
+    if (!resume_response) {
+        return NULL;
+    }
+    
+    Wickr__Proto__HandshakeV1 *proto_handshake = wickr_alloc_zero(sizeof(Wickr__Proto__HandshakeV1));
+    
+    if (!proto_handshake) {
+        return NULL;
+    }
+    
+    wickr__proto__handshake_v1__init(proto_handshake);
+    
+    proto_handshake->payload_case = WICKR__PROTO__HANDSHAKE_V1__PAYLOAD_RESUME_RESPONSE;
+    proto_handshake->resume_response = resume_response;
+    
+    return proto_handshake;
+}
+
 void wickr_proto_handshake_free(Wickr__Proto__HandshakeV1 *handshake)
 {
     if (!handshake) {
@@ -211,6 +345,13 @@ void wickr_proto_handshake_free(Wickr__Proto__HandshakeV1 *handshake)
             break;
         case WICKR__PROTO__HANDSHAKE_V1__PAYLOAD_RESPONSE:
             wickr_proto_handshake_response_free(handshake->response);
+            break;
+        case WICKR__PROTO__HANDSHAKE_V1__PAYLOAD_RESUME_SEED:
+            wickr_proto_handshake_resume_seed_free(handshake->resume_seed);
+            break;
+        case WICKR__PROTO__HANDSHAKE_V1__PAYLOAD_RESUME_RESPONSE:
+            wickr_proto_handshake_resume_response_free(handshake->resume_response);
+            break;
         default:
             break;
     }
@@ -237,22 +378,22 @@ wickr_buffer_t *wickr_proto_handshake_serialize(const Wickr__Proto__HandshakeV1
     return packed_buffer;
 }
 
-Wickr__Proto__HandshakeV1 *wickr_proto_handshake_from_buffer(const wickr_buffer_t *buffer)
+Wickr__Proto__HandshakeV1 *wickr_proto_handshake_from_buffer(const wickr_buffer_t *buffer, ProtobufCAllocator *allocator)
 {
     if (!buffer) {
         return NULL;
     }
     
-    return wickr__proto__handshake_v1__unpack(NULL, buffer->length, buffer->bytes);
+    return wickr__proto__handshake_v1__unpack(allocator, buffer->length, buffer->bytes);
 }
 
-Wickr__Proto__HandshakeV1 *wickr_proto_handshake_from_packet(const wickr_transport_packet_t *packet)
+Wickr__Proto__HandshakeV1 *wickr_proto_handshake_from_packet(const wickr_transport_packet_t *packet, ProtobufCAllocator *allocator)
 {
     if (!packet || packet->meta.body_type != TRANSPORT_PAYLOAD_TYPE_HANDSHAKE) {
         return NULL;
     }
     
-    return wickr_proto_handshake_from_buffer(packet->body);
+    return wickr_proto_handshake_from_buffer(packet->body, allocator);
 }
 
 wickr_transport_packet_t *wickr_proto_handshake_to_packet(const Wickr__Proto__HandshakeV1 *handshake)
@@ -1,8 +1,48 @@
 
 #include "transport_packet.h"
+#include "buffer_writer.h"
 #include "memory.h"
 #include <string.h>
 
+/* Fixed width values are little endian on the wire */
+static uint64_t __wickr_transport_u64le_read(const uint8_t *bytes)
+{
+    uint64_t value = 0;
+    
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+        value |= (uint64_t)bytes[i] << (8 * i);
+    }
+    
+    return value;
+}
+
+static int __wickr_transport_varint_read(const uint8_t *bytes, size_t len, uint64_t *value_out)
+{
+    uint64_t value = 0;
+    
+    for (size_t i = 0; i < len && i < BUFFER_WRITER_VARINT_MAX_LEN; i++) {
+        uint64_t part = bytes[i] & 0x7F;
+        
+        /* The 10th byte can only hold the top bit of a 64bit value */
+        if (i == BUFFER_WRITER_VARINT_MAX_LEN - 1 && bytes[i] > 1) {
+            return -1;
+        }
+        
+        value |= part << (7 * i);
+        
+        if (!(bytes[i] & 0x80)) {
+            /* Reject padded encodings so that each sequence number has exactly one representation */
+            if (i > 0 && bytes[i] == 0) {
+                return -1;
+            }
+            *value_out = value;
+            return (int)(i + 1);
+        }
+    }
+    
+    return -1;
+}
+
 void wickr_transport_packet_meta_initialize_handshake(wickr_transport_packet_meta_t *meta_out,
                                                       uint8_t protocol_version,
                                                       wickr_transport_packet_mac_type mac_type)
@@ -22,62 +62,67 @@ void wickr_transport_packet_meta_initialize_data(wickr_transport_packet_meta_t *
     meta_out->body_meta.data.sequence_number = sequence_number;
 }
 
-wickr_buffer_t *wickr_transport_packet_meta_serialize(const wickr_transport_packet_meta_t *meta)
+void wickr_transport_packet_meta_initialize_compact_data(wickr_transport_packet_meta_t *meta_out,
+                                                         uint64_t sequence_number,
+                                                         wickr_transport_packet_mac_type mac_type)
 {
-    if (!meta) {
-        return NULL;
+    meta_out->mac_type = mac_type;
+    meta_out->body_type = TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT_COMPACT;
+    meta_out->body_meta.data.sequence_number = sequence_number;
+}
+
+static size_t __wickr_transport_packet_meta_len(const wickr_transport_packet_meta_t *meta)
+{
+    switch (meta->body_type) {
+        case TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT:
+            return sizeof(uint8_t) /* body + mac type */ + sizeof(uint64_t); /* seq_number */
+        case TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT_COMPACT:
+            return sizeof(uint8_t) /* body + mac type */ + wickr_buffer_writer_varint_size(meta->body_meta.data.sequence_number);
+        case TRANSPORT_PAYLOAD_TYPE_HANDSHAKE:
+            return sizeof(uint8_t) /* body + mac type */ + sizeof(uint8_t) /* protocol version */ + sizeof(uint64_t); /* flags */
+        default:
+            return 0;
     }
-    
-    uint8_t length = 0;
+}
+
+static bool __wickr_transport_packet_meta_write(const wickr_transport_packet_meta_t *meta, wickr_buffer_writer_t *writer)
+{
+    wickr_buffer_writer_append_u8(writer, (((uint8_t)meta->body_type) << 4) | ((uint8_t)meta->mac_type));
     
     switch (meta->body_type) {
         case TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT:
-            length = sizeof(uint8_t) /* body + mac type */ + sizeof(uint64_t); /* seq_number */
-            break;
+            return wickr_buffer_writer_append_u64le(writer, meta->body_meta.data.sequence_number);
+        case TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT_COMPACT:
+            return wickr_buffer_writer_append_varint(writer, meta->body_meta.data.sequence_number);
         case TRANSPORT_PAYLOAD_TYPE_HANDSHAKE:
-            length = sizeof(uint8_t) /* body + mac type */ + sizeof(uint8_t) /* protocol version */ + sizeof(uint64_t); /* flags */
+            wickr_buffer_writer_append_u8(writer, meta->body_meta.handshake.protocol_version);
+            return wickr_buffer_writer_append_u64le(writer, meta->body_meta.handshake.flags);
         default:
-            break;
+            return false;
     }
-    
-    wickr_buffer_t *serialized = wickr_buffer_create_empty_zero(length);
-    
-    if (!serialized) {
+}
+
+wickr_buffer_t *wickr_transport_packet_meta_serialize(const wickr_transport_packet_meta_t *meta)
+{
+    if (!meta) {
         return NULL;
     }
     
-    size_t pos = 0;
+    size_t length = __wickr_transport_packet_meta_len(meta);
     
-    serialized->bytes[0] = (((uint8_t)meta->body_type) << 4) | ((uint8_t)meta->mac_type);
+    if (length == 0) {
+        return NULL;
+    }
     
-    pos += sizeof(uint8_t);
+    wickr_buffer_writer_t writer;
+    wickr_buffer_writer_init(&writer, length);
     
-    switch (meta->body_type) {
-        case TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT:
-            if (!wickr_buffer_modify_section(serialized, (uint8_t *)&meta->body_meta.data.sequence_number, pos, sizeof(uint64_t))) {
-                wickr_buffer_destroy(&serialized);
-                return NULL;
-            }
-            pos += sizeof(uint64_t);
-            break;
-        case TRANSPORT_PAYLOAD_TYPE_HANDSHAKE:
-            if (!wickr_buffer_modify_section(serialized, (uint8_t *)&meta->body_meta.handshake.protocol_version, pos, sizeof(uint8_t))) {
-                wickr_buffer_destroy(&serialized);
-                return NULL;
-            }
-            pos += sizeof(uint8_t);
-            if (!wickr_buffer_modify_section(serialized, (uint8_t *)&meta->body_meta.handshake.flags, pos, sizeof(uint64_t))) {
-                wickr_buffer_destroy(&serialized);
-                return NULL;
-            }
-            pos += sizeof(uint64_t);
-            break;
-        default:
-            wickr_buffer_destroy(&serialized);
-            return NULL;
+    if (!__wickr_transport_packet_meta_write(meta, &writer)) {
+        wickr_buffer_writer_release(&writer);
+        return NULL;
     }
     
-    return serialized;
+    return wickr_buffer_writer_finish(&writer);
 }
 
 int wickr_transport_packet_meta_initialize_buffer(wickr_transport_packet_meta_t *meta_out, const wickr_buffer_t *buffer)
@@ -102,10 +147,23 @@ int wickr_transport_packet_meta_initialize_buffer(wickr_transport_packet_meta_t
                 return -1;
             }
             
-            memcpy(&meta_out->body_meta.data.sequence_number, buffer->bytes + sizeof(uint8_t), sizeof(uint64_t));
+            meta_out->body_meta.data.sequence_number = __wickr_transport_u64le_read(buffer->bytes + sizeof(uint8_t));
             loc += sizeof(uint64_t);
             
             break;
+        case TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT_COMPACT:
+        {
+            int varint_len = __wickr_transport_varint_read(buffer->bytes + loc, buffer->length - loc,
+                                                           &meta_out->body_meta.data.sequence_number);
+            
+            if (varint_len <= 0) {
+                return -1;
+            }
+            
+            loc += varint_len;
+            
+            break;
+        }
         case TRANSPORT_PAYLOAD_TYPE_HANDSHAKE:
             
             if (buffer->length < (sizeof(uint8_t) * 2 + sizeof(uint64_t))) {
@@ -114,7 +172,7 @@ int wickr_transport_packet_meta_initialize_buffer(wickr_transport_packet_meta_t
             
             meta_out->body_meta.handshake.protocol_version = (uint8_t)buffer->bytes[sizeof(uint8_t)];
             loc += sizeof(uint8_t);
-            memcpy(&meta_out->body_meta.handshake.flags, buffer->bytes + sizeof(uint8_t) * 2, sizeof(uint64_t));
+            meta_out->body_meta.handshake.flags = __wickr_transport_u64le_read(buffer->bytes + sizeof(uint8_t) * 2);
             loc += sizeof(uint64_t);
             
             break;
@@ -195,17 +253,28 @@ wickr_buffer_t *wickr_transport_packet_serialize(const wickr_transport_packet_t
         return NULL;
     }
     
-    wickr_buffer_t *meta_buffer = wickr_transport_packet_meta_serialize(&pkt->meta);
+    size_t meta_len = __wickr_transport_packet_meta_len(&pkt->meta);
     
-    if (!meta_buffer) {
+    if (meta_len == 0 || !pkt->body) {
         return NULL;
     }
     
-    wickr_buffer_t *components[] = { meta_buffer, pkt->body, pkt->mac };
-    wickr_buffer_t *return_buffer = wickr_buffer_concat_multi(components, BUFFER_ARRAY_LEN(components));
-    wickr_buffer_destroy(&meta_buffer);
+    /* The meta data is written in place rather than serialized into a buffer of its own first */
+    wickr_buffer_writer_t writer;
+    wickr_buffer_writer_init(&writer, meta_len + pkt->body->length + (pkt->mac ? pkt->mac->length : 0));
         
-    return return_buffer;
+    if (!__wickr_transport_packet_meta_write(&pkt->meta, &writer)) {
+        wickr_buffer_writer_release(&writer);
+        return NULL;
+    }
+    
+    wickr_buffer_writer_append_buffer(&writer, pkt->body);
+    
+    if (pkt->mac) {
+        wickr_buffer_writer_append_buffer(&writer, pkt->mac);
+    }
+    
+    return wickr_buffer_writer_finish(&writer);
 }
 
 wickr_transport_packet_t *wickr_transport_packet_create_from_buffer(const wickr_buffer_t *buffer)
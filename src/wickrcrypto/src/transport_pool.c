@@ -0,0 +1,688 @@
+
+#include "transport_pool.h"
+#include "memory.h"
+#include "private/transport_priv.h"
+#include "private/threads_priv.h"
+
+#define TRANSPORT_POOL_INITIAL_BUCKETS 64
+
+typedef enum {
+    TRANSPORT_POOL_JOB_START,
+    TRANSPORT_POOL_JOB_TX,
+    TRANSPORT_POOL_JOB_RX
+} wickr_transport_pool_job_type;
+
+typedef struct wickr_transport_pool_job {
+    wickr_transport_pool_job_type type;
+    wickr_buffer_t *buffer;
+    struct wickr_transport_pool_job *next;
+} wickr_transport_pool_job_t;
+
+typedef struct wickr_transport_pool_conn {
+    uint64_t connection_id;
+    wickr_transport_pool_t *pool;
+    wickr_transport_ctx_t *ctx;
+    wickr_transport_status status;
+    wickr_transport_pool_job_t *job_head;
+    wickr_transport_pool_job_t *job_tail;
+    bool is_scheduled;
+    bool is_removed;
+    struct wickr_transport_pool_conn *bucket_next;
+    struct wickr_transport_pool_conn *ready_next;
+} wickr_transport_pool_conn_t;
+
+struct wickr_transport_pool {
+    wickr_transport_ctx_t *ctx_template;
+    wickr_transport_pool_callbacks_t callbacks;
+    void *user;
+    wickr_mutex_t lock;
+    wickr_cond_t work_cond;
+    wickr_cond_t idle_cond;
+    wickr_transport_pool_conn_t **buckets;
+    size_t bucket_count;
+    size_t connection_count;
+    wickr_transport_pool_conn_t *ready_head;
+    wickr_transport_pool_conn_t *ready_tail;
+    uint64_t pending_count;
+    wickr_transport_pool_stats_t stats;
+    wickr_thread_t *workers;
+    uint32_t worker_count;
+    bool is_shutdown;
+};
+
+/* Connection table */
+
+static size_t __wickr_transport_pool_bucket_idx(uint64_t connection_id, size_t bucket_count)
+{
+    /* Mix the bits of the id since connection ids are often sequential */
+    connection_id ^= connection_id >> 33;
+    connection_id *= 0xff51afd7ed558ccdULL;
+    connection_id ^= connection_id >> 33;
+    
+    return (size_t)(connection_id & (bucket_count - 1));
+}
+
+static wickr_transport_pool_conn_t *__wickr_transport_pool_find(const wickr_transport_pool_t *pool, uint64_t connection_id)
+{
+    wickr_transport_pool_conn_t *conn = pool->buckets[__wickr_transport_pool_bucket_idx(connection_id, pool->bucket_count)];
+    
+    while (conn && conn->connection_id != connection_id) {
+        conn = conn->bucket_next;
+    }
+    
+    return conn;
+}
+
+static bool __wickr_transport_pool_grow(wickr_transport_pool_t *pool)
+{
+    size_t new_count = pool->bucket_count * 2;
+    wickr_transport_pool_conn_t **new_buckets = wickr_alloc_zero(new_count * sizeof(wickr_transport_pool_conn_t *));
+    
+    if (!new_buckets) {
+        return false;
+    }
+    
+    for (size_t i = 0; i < pool->bucket_count; i++) {
+        wickr_transport_pool_conn_t *conn = pool->buckets[i];
+        
+        while (conn) {
+            wickr_transport_pool_conn_t *next = conn->bucket_next;
+            size_t idx = __wickr_transport_pool_bucket_idx(conn->connection_id, new_count);
+            conn->bucket_next = new_buckets[idx];
+            new_buckets[idx] = conn;
+            conn = next;
+        }
+    }
+    
+    wickr_free(pool->buckets);
+    pool->buckets = new_buckets;
+    pool->bucket_count = new_count;
+    
+    return true;
+}
+
+static void __wickr_transport_pool_unlink(wickr_transport_pool_t *pool, wickr_transport_pool_conn_t *conn)
+{
+    wickr_transport_pool_conn_t **current = &pool->buckets[__wickr_transport_pool_bucket_idx(conn->connection_id, pool->bucket_count)];
+    
+    while (*current && *current != conn) {
+        current = &(*current)->bucket_next;
+    }
+    
+    if (*current) {
+        *current = conn->bucket_next;
+        conn->bucket_next = NULL;
+        pool->connection_count--;
+    }
+}
+
+/* Jobs */
+
+static void __wickr_transport_pool_job_destroy(wickr_transport_pool_job_t **job)
+{
+    if (!job || !*job) {
+        return;
+    }
+    
+    wickr_buffer_destroy(&(*job)->buffer);
+    wickr_free(*job);
+    *job = NULL;
+}
+
+static void __wickr_transport_pool_conn_drop_jobs(wickr_transport_pool_t *pool, wickr_transport_pool_conn_t *conn)
+{
+    while (conn->job_head) {
+        wickr_transport_pool_job_t *job = conn->job_head;
+        conn->job_head = job->next;
+        __wickr_transport_pool_job_destroy(&job);
+        pool->pending_count--;
+    }
+    
+    conn->job_tail = NULL;
+}
+
+static void __wickr_transport_pool_conn_destroy(wickr_transport_pool_conn_t **conn)
+{
+    if (!conn || !*conn) {
+        return;
+    }
+    
+    wickr_transport_ctx_destroy(&(*conn)->ctx);
+    wickr_free(*conn);
+    *conn = NULL;
+}
+
+static void __wickr_transport_pool_push_ready(wickr_transport_pool_t *pool, wickr_transport_pool_conn_t *conn)
+{
+    conn->ready_next = NULL;
+    
+    if (pool->ready_tail) {
+        pool->ready_tail->ready_next = conn;
+    } else {
+        pool->ready_head = conn;
+    }
+    
+    pool->ready_tail = conn;
+    conn->is_scheduled = true;
+    
+    wickr_cond_signal(&pool->work_cond);
+}
+
+static wickr_transport_pool_conn_t *__wickr_transport_pool_pop_ready(wickr_transport_pool_t *pool)
+{
+    wickr_transport_pool_conn_t *conn = pool->ready_head;
+    
+    if (conn) {
+        pool->ready_head = conn->ready_next;
+        
+        if (!pool->ready_head) {
+            pool->ready_tail = NULL;
+        }
+        
+        conn->ready_next = NULL;
+    }
+    
+    return conn;
+}
+
+static bool __wickr_transport_pool_submit(wickr_transport_pool_t *pool,
+                                          uint64_t connection_id,
+                                          wickr_transport_pool_job_type type,
+                                          const wickr_buffer_t *buffer)
+{
+    if (!pool) {
+        return false;
+    }
+    
+    wickr_transport_pool_job_t *job = wickr_alloc_zero(sizeof(wickr_transport_pool_job_t));
+    
+    if (!job) {
+        return false;
+    }
+    
+    job->type = type;
+    
+    if (buffer) {
+        job->buffer = wickr_buffer_copy(buffer);
+        
+        if (!job->buffer) {
+            __wickr_transport_pool_job_destroy(&job);
+            return false;
+        }
+    }
+    
+    wickr_mutex_lock(&pool->lock);
+    
+    wickr_transport_pool_conn_t *conn = __wickr_transport_pool_find(pool, connection_id);
+    
+    if (!conn || pool->is_shutdown) {
+        if (type == TRANSPORT_POOL_JOB_RX) {
+            pool->stats.rx_dropped++;
+        }
+        wickr_mutex_unlock(&pool->lock);
+        __wickr_transport_pool_job_destroy(&job);
+        return false;
+    }
+    
+    if (conn->job_tail) {
+        conn->job_tail->next = job;
+    } else {
+        conn->job_head = job;
+    }
+    
+    conn->job_tail = job;
+    pool->pending_count++;
+    
+    /* A connection is only ever in the ready queue once, which keeps its work in order on a single worker */
+    if (!conn->is_scheduled) {
+        __wickr_transport_pool_push_ready(pool, conn);
+    }
+    
+    wickr_mutex_unlock(&pool->lock);
+    
+    return true;
+}
+
+/* Transport callbacks, called by a worker while it owns the connection */
+
+static void __wickr_transport_pool_tx(const wickr_transport_ctx_t *ctx, wickr_buffer_t *data)
+{
+    wickr_transport_pool_conn_t *conn = (wickr_transport_pool_conn_t *)wickr_transport_ctx_get_user_ctx(ctx);
+    wickr_transport_pool_t *pool = conn->pool;
+    
+    wickr_mutex_lock(&pool->lock);
+    pool->stats.tx_packets++;
+    pool->stats.tx_bytes += data->length;
+    wickr_mutex_unlock(&pool->lock);
+    
+    if (pool->callbacks.tx) {
+        pool->callbacks.tx(pool, conn->connection_id, data, pool->user);
+    } else {
+        wickr_buffer_destroy(&data);
+    }
+}
+
+static void __wickr_transport_pool_rx(const wickr_transport_ctx_t *ctx, wickr_buffer_t *data)
+{
+    wickr_transport_pool_conn_t *conn = (wickr_transport_pool_conn_t *)wickr_transport_ctx_get_user_ctx(ctx);
+    wickr_transport_pool_t *pool = conn->pool;
+    
+    wickr_mutex_lock(&pool->lock);
+    pool->stats.rx_packets++;
+    pool->stats.rx_bytes += data->length;
+    wickr_mutex_unlock(&pool->lock);
+    
+    if (pool->callbacks.rx) {
+        pool->callbacks.rx(pool, conn->connection_id, data, pool->user);
+    } else {
+        wickr_buffer_destroy(&data);
+    }
+}
+
+static void __wickr_transport_pool_on_state(const wickr_transport_ctx_t *ctx, wickr_transport_status status)
+{
+    wickr_transport_pool_conn_t *conn = (wickr_transport_pool_conn_t *)wickr_transport_ctx_get_user_ctx(ctx);
+    wickr_transport_pool_t *pool = conn->pool;
+    
+    wickr_mutex_lock(&pool->lock);
+    conn->status = status;
+    
+    if (status == TRANSPORT_STATUS_ACTIVE) {
+        pool->stats.handshakes_completed++;
+    } else if (status == TRANSPORT_STATUS_ERROR) {
+        pool->stats.errors++;
+    }
+    
+    wickr_mutex_unlock(&pool->lock);
+    
+    if (pool->callbacks.on_state) {
+        pool->callbacks.on_state(pool, conn->connection_id, status, pool->user);
+    }
+}
+
+static void __wickr_transport_pool_on_identity_verify(const wickr_transport_ctx_t *ctx,
+                                                      wickr_identity_chain_t *identity,
+                                                      wickr_transport_validate_identity_callback on_complete)
+{
+    wickr_transport_pool_conn_t *conn = (wickr_transport_pool_conn_t *)wickr_transport_ctx_get_user_ctx(ctx);
+    wickr_transport_pool_t *pool = conn->pool;
+    
+    bool is_valid = false;
+    
+    if (pool->callbacks.on_identity_verify) {
+        is_valid = pool->callbacks.on_identity_verify(pool, conn->connection_id, identity, pool->user);
+    } else {
+        wickr_identity_chain_destroy(&identity);
+    }
+    
+    on_complete(ctx, is_valid);
+}
+
+/* Workers */
+
+static void __wickr_transport_pool_run_job(wickr_transport_pool_conn_t *conn, const wickr_transport_pool_job_t *job)
+{
+    switch (job->type) {
+        case TRANSPORT_POOL_JOB_START:
+            wickr_transport_ctx_start(conn->ctx);
+            break;
+        case TRANSPORT_POOL_JOB_TX:
+            wickr_transport_ctx_process_tx_buffer(conn->ctx, job->buffer);
+            break;
+        case TRANSPORT_POOL_JOB_RX:
+            wickr_transport_ctx_process_rx_buffer(conn->ctx, job->buffer);
+            break;
+    }
+}
+
+static void *__wickr_transport_pool_worker(void *arg)
+{
+    wickr_transport_pool_t *pool = arg;
+    
+    wickr_mutex_lock(&pool->lock);
+    
+    for (;;) {
+        while (!pool->ready_head && !pool->is_shutdown) {
+            wickr_cond_wait(&pool->work_cond, &pool->lock);
+        }
+        
+        wickr_transport_pool_conn_t *conn = __wickr_transport_pool_pop_ready(pool);
+        
+        /* Remaining work is drained before shutting down */
+        if (!conn) {
+            break;
+        }
+        
+        /* The connection was removed while it was waiting in the ready queue */
+        if (conn->is_removed) {
+            wickr_mutex_unlock(&pool->lock);
+            __wickr_transport_pool_conn_destroy(&conn);
+            wickr_mutex_lock(&pool->lock);
+            continue;
+        }
+        
+        wickr_transport_pool_job_t *job = conn->job_head;
+        conn->job_head = job->next;
+        
+        if (!conn->job_head) {
+            conn->job_tail = NULL;
+        }
+        
+        wickr_mutex_unlock(&pool->lock);
+        
+        __wickr_transport_pool_run_job(conn, job);
+        __wickr_transport_pool_job_destroy(&job);
+        
+        wickr_mutex_lock(&pool->lock);
+        
+        pool->pending_count--;
+        conn->status = wickr_transport_ctx_get_status(conn->ctx);
+        
+        /* Process one job at a time per connection so that busy connections can't starve the others */
+        if (conn->is_removed) {
+            wickr_mutex_unlock(&pool->lock);
+            __wickr_transport_pool_conn_destroy(&conn);
+            wickr_mutex_lock(&pool->lock);
+        } else if (conn->job_head) {
+            __wickr_transport_pool_push_ready(pool, conn);
+        } else {
+            conn->is_scheduled = false;
+        }
+        
+        if (pool->pending_count == 0) {
+            wickr_cond_broadcast(&pool->idle_cond);
+        }
+    }
+    
+    wickr_mutex_unlock(&pool->lock);
+    
+    return NULL;
+}
+
+static void __wickr_transport_pool_stop_workers(wickr_transport_pool_t *pool, uint32_t started_count)
+{
+    wickr_mutex_lock(&pool->lock);
+    pool->is_shutdown = true;
+    wickr_cond_broadcast(&pool->work_cond);
+    wickr_mutex_unlock(&pool->lock);
+    
+    for (uint32_t i = 0; i < started_count; i++) {
+        wickr_thread_join(pool->workers[i]);
+    }
+}
+
+/* Public interface */
+
+wickr_transport_pool_t *wickr_transport_pool_create(const wickr_transport_ctx_t *ctx_template,
+                                                    uint32_t worker_count,
+                                                    wickr_transport_pool_callbacks_t callbacks,
+                                                    void *user)
+{
+    if (!ctx_template || ctx_template->status != TRANSPORT_STATUS_NONE ||
+        worker_count == 0 || worker_count > TRANSPORT_POOL_MAX_WORKERS) {
+        return NULL;
+    }
+    
+    wickr_transport_pool_t *pool = wickr_alloc_zero(sizeof(wickr_transport_pool_t));
+    
+    if (!pool) {
+        return NULL;
+    }
+    
+    pool->ctx_template = wickr_transport_ctx_copy(ctx_template);
+    pool->buckets = wickr_alloc_zero(TRANSPORT_POOL_INITIAL_BUCKETS * sizeof(wickr_transport_pool_conn_t *));
+    pool->workers = wickr_alloc_zero(worker_count * sizeof(wickr_thread_t));
+    
+    bool lock_ready = wickr_mutex_init(&pool->lock);
+    bool work_cond_ready = wickr_cond_init(&pool->work_cond);
+    bool idle_cond_ready = wickr_cond_init(&pool->idle_cond);
+    
+    if (!pool->ctx_template || !pool->buckets || !pool->workers ||
+        !lock_ready || !work_cond_ready || !idle_cond_ready) {
+        if (lock_ready) {
+            wickr_mutex_destroy(&pool->lock);
+        }
+        if (work_cond_ready) {
+            wickr_cond_destroy(&pool->work_cond);
+        }
+        if (idle_cond_ready) {
+            wickr_cond_destroy(&pool->idle_cond);
+        }
+        wickr_transport_ctx_destroy(&pool->ctx_template);
+        wickr_free(pool->buckets);
+        wickr_free(pool->workers);
+        wickr_free(pool);
+        return NULL;
+    }
+    
+    pool->ctx_template->callbacks = (wickr_transport_callbacks_t) {
+        __wickr_transport_pool_tx,
+        __wickr_transport_pool_rx,
+        __wickr_transport_pool_on_state,
+        __wickr_transport_pool_on_identity_verify
+    };
+    
+    pool->bucket_count = TRANSPORT_POOL_INITIAL_BUCKETS;
+    pool->callbacks = callbacks;
+    pool->user = user;
+    
+    for (uint32_t i = 0; i < worker_count; i++) {
+        if (!wickr_thread_create(&pool->workers[i], __wickr_transport_pool_worker, pool)) {
+            __wickr_transport_pool_stop_workers(pool, i);
+            pool->worker_count = 0;
+            wickr_transport_pool_destroy(&pool);
+            return NULL;
+        }
+        pool->worker_count++;
+    }
+    
+    return pool;
+}
+
+void wickr_transport_pool_destroy(wickr_transport_pool_t **pool)
+{
+    if (!pool || !*pool) {
+        return;
+    }
+    
+    __wickr_transport_pool_stop_workers(*pool, (*pool)->worker_count);
+    
+    for (size_t i = 0; i < (*pool)->bucket_count; i++) {
+        wickr_transport_pool_conn_t *conn = (*pool)->buckets[i];
+        
+        while (conn) {
+            wickr_transport_pool_conn_t *next = conn->bucket_next;
+            __wickr_transport_pool_conn_drop_jobs(*pool, conn);
+            __wickr_transport_pool_conn_destroy(&conn);
+            conn = next;
+        }
+    }
+    
+    wickr_mutex_destroy(&(*pool)->lock);
+    wickr_cond_destroy(&(*pool)->work_cond);
+    wickr_cond_destroy(&(*pool)->idle_cond);
+    
+    wickr_transport_ctx_destroy(&(*pool)->ctx_template);
+    wickr_free((*pool)->buckets);
+    wickr_free((*pool)->workers);
+    wickr_free(*pool);
+    *pool = NULL;
+}
+
+bool wickr_transport_pool_add_connection(wickr_transport_pool_t *pool,
+                                         uint64_t connection_id,
+                                         wickr_identity_chain_t *remote_identity)
+{
+    if (!pool) {
+        return false;
+    }
+    
+    wickr_transport_pool_conn_t *conn = wickr_alloc_zero(sizeof(wickr_transport_pool_conn_t));
+    
+    if (!conn) {
+        return false;
+    }
+    
+    conn->ctx = wickr_transport_ctx_copy(pool->ctx_template);
+    
+    if (!conn->ctx) {
+        wickr_free(conn);
+        return false;
+    }
+    
+    conn->pool = pool;
+    conn->connection_id = connection_id;
+    conn->status = TRANSPORT_STATUS_NONE;
+    wickr_transport_ctx_set_user_ctx(conn->ctx, conn);
+    
+    wickr_mutex_lock(&pool->lock);
+    
+    if (pool->is_shutdown || __wickr_transport_pool_find(pool, connection_id)) {
+        wickr_mutex_unlock(&pool->lock);
+        __wickr_transport_pool_conn_destroy(&conn);
+        return false;
+    }
+    
+    if (pool->connection_count >= pool->bucket_count && !__wickr_transport_pool_grow(pool)) {
+        wickr_mutex_unlock(&pool->lock);
+        __wickr_transport_pool_conn_destroy(&conn);
+        return false;
+    }
+    
+    /* Take ownership of the remote identity only once the connection is known to be added */
+    if (remote_identity) {
+        wickr_identity_chain_destroy(&conn->ctx->remote_identity);
+        conn->ctx->remote_identity = remote_identity;
+    }
+    
+    size_t idx = __wickr_transport_pool_bucket_idx(connection_id, pool->bucket_count);
+    conn->bucket_next = pool->buckets[idx];
+    pool->buckets[idx] = conn;
+    pool->connection_count++;
+    
+    wickr_mutex_unlock(&pool->lock);
+    
+    return true;
+}
+
+bool wickr_transport_pool_remove_connection(wickr_transport_pool_t *pool, uint64_t connection_id)
+{
+    if (!pool) {
+        return false;
+    }
+    
+    wickr_mutex_lock(&pool->lock);
+    
+    wickr_transport_pool_conn_t *conn = __wickr_transport_pool_find(pool, connection_id);
+    
+    if (!conn) {
+        wickr_mutex_unlock(&pool->lock);
+        return false;
+    }
+    
+    __wickr_transport_pool_unlink(pool, conn);
+    __wickr_transport_pool_conn_drop_jobs(pool, conn);
+    
+    if (pool->pending_count == 0) {
+        wickr_cond_broadcast(&pool->idle_cond);
+    }
+    
+    /* A worker that holds the connection is responsible for destroying it */
+    if (conn->is_scheduled) {
+        conn->is_removed = true;
+        conn = NULL;
+    }
+    
+    wickr_mutex_unlock(&pool->lock);
+    
+    __wickr_transport_pool_conn_destroy(&conn);
+    
+    return true;
+}
+
+bool wickr_transport_pool_start(wickr_transport_pool_t *pool, uint64_t connection_id)
+{
+    return __wickr_transport_pool_submit(pool, connection_id, TRANSPORT_POOL_JOB_START, NULL);
+}
+
+bool wickr_transport_pool_process_tx_buffer(wickr_transport_pool_t *pool, uint64_t connection_id, const wickr_buffer_t *buffer)
+{
+    if (!buffer) {
+        return false;
+    }
+    
+    return __wickr_transport_pool_submit(pool, connection_id, TRANSPORT_POOL_JOB_TX, buffer);
+}
+
+bool wickr_transport_pool_process_rx_buffer(wickr_transport_pool_t *pool, uint64_t connection_id, const wickr_buffer_t *buffer)
+{
+    if (!buffer) {
+        return false;
+    }
+    
+    return __wickr_transport_pool_submit(pool, connection_id, TRANSPORT_POOL_JOB_RX, buffer);
+}
+
+void wickr_transport_pool_flush(wickr_transport_pool_t *pool)
+{
+    if (!pool) {
+        return;
+    }
+    
+    wickr_mutex_lock(&pool->lock);
+    
+    while (pool->pending_count != 0) {
+        wickr_cond_wait(&pool->idle_cond, &pool->lock);
+    }
+    
+    wickr_mutex_unlock(&pool->lock);
+}
+
+wickr_transport_status wickr_transport_pool_get_status(const wickr_transport_pool_t *pool, uint64_t connection_id)
+{
+    if (!pool) {
+        return TRANSPORT_STATUS_ERROR;
+    }
+    
+    /* Remove const for locking */
+    wickr_transport_pool_t *_pool = (wickr_transport_pool_t *)pool;
+    
+    wickr_mutex_lock(&_pool->lock);
+    
+    wickr_transport_pool_conn_t *conn = __wickr_transport_pool_find(pool, connection_id);
+    wickr_transport_status status = conn ? conn->status : TRANSPORT_STATUS_ERROR;
+    
+    wickr_mutex_unlock(&_pool->lock);
+    
+    return status;
+}
+
+wickr_transport_pool_stats_t wickr_transport_pool_get_stats(const wickr_transport_pool_t *pool)
+{
+    wickr_transport_pool_stats_t stats = { 0 };
+    
+    if (!pool) {
+        return stats;
+    }
+    
+    /* Remove const for locking */
+    wickr_transport_pool_t *_pool = (wickr_transport_pool_t *)pool;
+    
+    wickr_mutex_lock(&_pool->lock);
+    
+    stats = pool->stats;
+    stats.connection_count = pool->connection_count;
+    stats.pending_count = pool->pending_count;
+    
+    for (size_t i = 0; i < pool->bucket_count; i++) {
+        for (wickr_transport_pool_conn_t *conn = pool->buckets[i]; conn; conn = conn->bucket_next) {
+            if (conn->status == TRANSPORT_STATUS_ACTIVE) {
+                stats.active_count++;
+            }
+        }
+    }
+    
+    wickr_mutex_unlock(&_pool->lock);
+    
+    return stats;
+}
@@ -0,0 +1,59 @@
+
+#include "transport_resumption.h"
+#include "memory.h"
+
+wickr_transport_resumption_t *wickr_transport_resumption_create(wickr_buffer_t *ticket,
+                                                                wickr_transport_root_key_t *root_key)
+{
+    if (!ticket || !root_key) {
+        return NULL;
+    }
+    
+    wickr_transport_resumption_t *resumption = wickr_alloc_zero(sizeof(wickr_transport_resumption_t));
+    
+    if (!resumption) {
+        return NULL;
+    }
+    
+    resumption->ticket = ticket;
+    resumption->root_key = root_key;
+    
+    return resumption;
+}
+
+wickr_transport_resumption_t *wickr_transport_resumption_copy(const wickr_transport_resumption_t *resumption)
+{
+    if (!resumption) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *ticket_copy = wickr_buffer_copy(resumption->ticket);
+    wickr_transport_root_key_t *root_key_copy = wickr_transport_root_key_copy(resumption->root_key);
+    
+    if (!ticket_copy || !root_key_copy) {
+        wickr_buffer_destroy(&ticket_copy);
+        wickr_transport_root_key_destroy(&root_key_copy);
+        return NULL;
+    }
+    
+    wickr_transport_resumption_t *copy = wickr_transport_resumption_create(ticket_copy, root_key_copy);
+    
+    if (!copy) {
+        wickr_buffer_destroy(&ticket_copy);
+        wickr_transport_root_key_destroy(&root_key_copy);
+    }
+    
+    return copy;
+}
+
+void wickr_transport_resumption_destroy(wickr_transport_resumption_t **resumption)
+{
+    if (!resumption || !*resumption) {
+        return;
+    }
+    
+    wickr_buffer_destroy(&(*resumption)->ticket);
+    wickr_transport_root_key_destroy(&(*resumption)->root_key);
+    wickr_free(*resumption);
+    *resumption = NULL;
+}
@@ -0,0 +1,128 @@
+
+#include "private/transport_resumption_priv.h"
+#include "private/transport_root_key_priv.h"
+#include "private/identity_priv.h"
+#include "memory.h"
+#include "private/proto_arena_priv.h"
+
+static wickr_buffer_t *__wickr_transport_resumption_ticket_serialize(const wickr_transport_root_key_t *root_key,
+                                                                     const wickr_identity_chain_t *id_chain,
+                                                                     uint64_t expiration)
+{
+    Wickr__Proto__TransportResumptionTicket ticket_proto = WICKR__PROTO__TRANSPORT_RESUMPTION_TICKET__INIT;
+    
+    ticket_proto.root_key = wickr_transport_root_key_to_proto(root_key);
+    
+    if (!ticket_proto.root_key) {
+        return NULL;
+    }
+    
+    ticket_proto.id_chain = wickr_identity_chain_to_proto(id_chain);
+    
+    if (!ticket_proto.id_chain) {
+        wickr_transport_root_key_proto_free(ticket_proto.root_key);
+        return NULL;
+    }
+    
+    ticket_proto.expiration = expiration;
+    ticket_proto.has_expiration = true;
+    
+    size_t packed_size = wickr__proto__transport_resumption_ticket__get_packed_size(&ticket_proto);
+    wickr_buffer_t *packed_buffer = wickr_buffer_create_empty_zero(packed_size);
+    
+    if (packed_buffer) {
+        wickr__proto__transport_resumption_ticket__pack(&ticket_proto, packed_buffer->bytes);
+    }
+    
+    wickr_transport_root_key_proto_free(ticket_proto.root_key);
+    wickr_identity_chain_proto_free(ticket_proto.id_chain);
+    
+    return packed_buffer;
+}
+
+wickr_buffer_t *wickr_transport_resumption_ticket_seal(const wickr_crypto_engine_t *engine,
+                                                       const wickr_cipher_key_t *ticket_key,
+                                                       const wickr_transport_root_key_t *root_key,
+                                                       const wickr_identity_chain_t *id_chain,
+                                                       uint64_t expiration)
+{
+    if (!engine || !ticket_key || !root_key || !id_chain) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *ticket_data = __wickr_transport_resumption_ticket_serialize(root_key, id_chain, expiration);
+    
+    if (!ticket_data) {
+        return NULL;
+    }
+    
+    /* The ticket is only ever opened by the party that sealed it, so the key never has to leave the responder */
+    wickr_cipher_result_t *encrypted_ticket = engine->wickr_crypto_engine_cipher_encrypt(ticket_data, NULL, ticket_key, NULL);
+    wickr_buffer_destroy_zero(&ticket_data);
+    
+    if (!encrypted_ticket) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *ticket = wickr_cipher_result_serialize(encrypted_ticket);
+    wickr_cipher_result_destroy(&encrypted_ticket);
+    
+    return ticket;
+}
+
+wickr_transport_root_key_t *wickr_transport_resumption_ticket_open(const wickr_crypto_engine_t *engine,
+                                                                   const wickr_cipher_key_t *ticket_key,
+                                                                   const wickr_buffer_t *ticket,
+                                                                   uint64_t current_time,
+                                                                   wickr_identity_chain_t **id_chain)
+{
+    if (!engine || !ticket_key || !ticket || !id_chain) {
+        return NULL;
+    }
+    
+    wickr_cipher_result_t *encrypted_ticket = wickr_cipher_result_from_buffer(ticket);
+    
+    if (!encrypted_ticket) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *ticket_data = engine->wickr_crypto_engine_cipher_decrypt(encrypted_ticket, NULL, ticket_key, true);
+    wickr_cipher_result_destroy(&encrypted_ticket);
+    
+    if (!ticket_data) {
+        return NULL;
+    }
+    
+    wickr_proto_arena_t proto_arena;
+    wickr_proto_arena_init(&proto_arena);
+    
+    Wickr__Proto__TransportResumptionTicket *ticket_proto = wickr__proto__transport_resumption_ticket__unpack(&proto_arena.allocator,
+                                                                                                            ticket_data->length,
+                                                                                                            ticket_data->bytes);
+    wickr_buffer_destroy_zero(&ticket_data);
+    
+    if (!ticket_proto) {
+        wickr_proto_arena_release(&proto_arena);
+        return NULL;
+    }
+    
+    if (!ticket_proto->has_expiration || ticket_proto->expiration < current_time) {
+        wickr_proto_arena_release(&proto_arena);
+        return NULL;
+    }
+    
+    wickr_transport_root_key_t *root_key = wickr_transport_root_key_from_proto(ticket_proto->root_key);
+    wickr_identity_chain_t *ticket_identity = wickr_identity_chain_create_from_proto(ticket_proto->id_chain, engine);
+    
+    wickr_proto_arena_release(&proto_arena);
+    
+    if (!root_key || !ticket_identity) {
+        wickr_transport_root_key_destroy(&root_key);
+        wickr_identity_chain_destroy(&ticket_identity);
+        return NULL;
+    }
+    
+    *id_chain = ticket_identity;
+    
+    return root_key;
+}
@@ -101,7 +101,7 @@ wickr_stream_key_t *wickr_transport_root_key_to_stream_key(const wickr_transport
         return NULL;
     }
     
-    wickr_buffer_t *cipher_key_data = wickr_buffer_copy_section(raw_key_material->hash, 0, root_key->cipher.key_len);
+    wickr_buffer_t *cipher_key_data = wickr_buffer_copy_section_secure(raw_key_material->hash, 0, root_key->cipher.key_len);
     wickr_cipher_key_t *cipher_key = wickr_cipher_key_create(root_key->cipher, cipher_key_data);
     
     if (!cipher_key) {
@@ -109,7 +109,7 @@ wickr_stream_key_t *wickr_transport_root_key_to_stream_key(const wickr_transport
         return NULL;
     }
     
-    wickr_buffer_t *evo_key = wickr_buffer_copy_section(raw_key_material->hash, root_key->cipher.key_len, root_key->cipher.key_len);
+    wickr_buffer_t *evo_key = wickr_buffer_copy_section_secure(raw_key_material->hash, root_key->cipher.key_len, root_key->cipher.key_len);
     wickr_kdf_result_destroy(&raw_key_material);
     
     wickr_stream_key_t *stream_key = NULL;
@@ -128,3 +128,43 @@ wickr_stream_key_t *wickr_transport_root_key_to_stream_key(const wickr_transport
     return stream_key;
     
 }
+
+wickr_transport_root_key_t *wickr_transport_root_key_derive_resumption(const wickr_transport_root_key_t *root_key,
+                                                                       const wickr_crypto_engine_t *engine)
+{
+    if (!root_key || !engine) {
+        return NULL;
+    }
+    
+    wickr_buffer_t resumption_info = { .bytes = (uint8_t *)"resumption", .length = 10 };
+    
+    wickr_kdf_meta_t kdf_meta = { .algo = KDF_HKDF_SHA512, .salt = NULL, .info = &resumption_info };
+    wickr_kdf_result_t *raw_key_material = engine->wickr_crypto_kdf_meta(&kdf_meta, root_key->secret);
+    
+    if (!raw_key_material) {
+        return NULL;
+    }
+    
+    if (raw_key_material->hash->length < root_key->cipher.key_len) {
+        wickr_kdf_result_destroy(&raw_key_material);
+        return NULL;
+    }
+    
+    wickr_buffer_t *secret = wickr_buffer_copy_section(raw_key_material->hash, 0, root_key->cipher.key_len);
+    wickr_kdf_result_destroy(&raw_key_material);
+    
+    if (!secret) {
+        return NULL;
+    }
+    
+    wickr_transport_root_key_t *resumption_key = wickr_transport_root_key_create(secret,
+                                                                                 root_key->cipher,
+                                                                                 root_key->packets_per_evo_send,
+                                                                                 root_key->packets_per_evo_recv);
+    
+    if (!resumption_key) {
+        wickr_buffer_destroy_zero(&secret);
+    }
+    
+    return resumption_key;
+}
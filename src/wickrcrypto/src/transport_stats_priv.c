@@ -0,0 +1,34 @@
+
+#include "private/transport_stats_priv.h"
+
+#ifdef WICKR_TRANSPORT_STATS_TIMING
+
+void wickr_transport_histogram_record(wickr_transport_histogram_t *histogram, uint64_t duration_ns)
+{
+    if (!histogram) {
+        return;
+    }
+    
+    /* Find floor(log2(duration_ns)) to select the bucket */
+    uint8_t bucket = 0;
+    uint64_t remaining = duration_ns;
+    
+    while (remaining > 1 && bucket < TRANSPORT_STATS_HISTOGRAM_BUCKETS - 1) {
+        remaining >>= 1;
+        bucket++;
+    }
+    
+    if (histogram->count == 0 || duration_ns < histogram->min_ns) {
+        histogram->min_ns = duration_ns;
+    }
+    
+    if (duration_ns > histogram->max_ns) {
+        histogram->max_ns = duration_ns;
+    }
+    
+    histogram->count++;
+    histogram->total_ns += duration_ns;
+    histogram->buckets[bucket]++;
+}
+
+#endif
@@ -1,6 +1,8 @@
 
 #include "wickr_ctx.h"
 #include "memory.h"
+#include "private/proto_arena_priv.h"
+#include "arena.h"
 #include "private/identity_priv.h"
 #include "private/storage_priv.h"
 
@@ -581,16 +583,24 @@ wickr_ctx_t *wickr_ctx_create_from_buffer(const wickr_crypto_engine_t engine,
         return NULL;
     }
     
-    Wickr__Proto__Ctx *ctx_proto = wickr__proto__ctx__unpack(NULL, buffer->length,
+    wickr_proto_arena_t proto_arena;
+    wickr_proto_arena_init(&proto_arena);
+    
+    Wickr__Proto__Ctx *ctx_proto = wickr__proto__ctx__unpack(&proto_arena.allocator, buffer->length,
                                                              buffer->bytes);
     
     wickr_ctx_t *ctx = __wickr_ctx_create_from_proto(engine, dev_info, ctx_proto);
-    wickr__proto__ctx__free_unpacked(ctx_proto, NULL);
+    wickr_proto_arena_release(&proto_arena);
     
     return ctx;
 }
 
 wickr_buffer_t *wickr_ctx_export(const wickr_ctx_t *ctx, const wickr_buffer_t *passphrase)
+{
+    return wickr_ctx_export_with_kdf(ctx, KDF_SCRYPT_2_17, passphrase);
+}
+
+wickr_buffer_t *wickr_ctx_export_with_kdf(const wickr_ctx_t *ctx, wickr_kdf_algo_t algo, const wickr_buffer_t *passphrase)
 {
     if (!ctx || !passphrase) {
         return NULL;
@@ -602,7 +612,7 @@ wickr_buffer_t *wickr_ctx_export(const wickr_ctx_t *ctx, const wickr_buffer_t *p
         return NULL;
     }
     
-    wickr_buffer_t *protected = wickr_crypto_engine_kdf_cipher(&ctx->engine, KDF_SCRYPT_2_17, ctx->engine.default_cipher, serialized_ctx, passphrase);
+    wickr_buffer_t *protected = wickr_crypto_engine_kdf_cipher(&ctx->engine, algo, ctx->engine.default_cipher, serialized_ctx, passphrase);
     wickr_buffer_destroy_zero(&serialized_ctx);
     
     return protected;
@@ -631,6 +641,11 @@ wickr_ctx_t *wickr_ctx_import(const wickr_crypto_engine_t engine,
 
 /* Exports storage keys for a context using a password + KDF function */
 wickr_buffer_t *wickr_ctx_export_storage_keys(const wickr_ctx_t *ctx, const wickr_buffer_t *passphrase)
+{
+    return wickr_ctx_export_storage_keys_with_kdf(ctx, KDF_SCRYPT_2_17, passphrase);
+}
+
+wickr_buffer_t *wickr_ctx_export_storage_keys_with_kdf(const wickr_ctx_t *ctx, wickr_kdf_algo_t algo, const wickr_buffer_t *passphrase)
 {
     if (!ctx || !passphrase) {
         return NULL;
@@ -642,7 +657,7 @@ wickr_buffer_t *wickr_ctx_export_storage_keys(const wickr_ctx_t *ctx, const wick
         return NULL;
     }
     
-    wickr_buffer_t *protected = wickr_crypto_engine_kdf_cipher(&ctx->engine, KDF_SCRYPT_2_17, ctx->engine.default_cipher, serialized_storage_keys, passphrase);
+    wickr_buffer_t *protected = wickr_crypto_engine_kdf_cipher(&ctx->engine, algo, ctx->engine.default_cipher, serialized_storage_keys, passphrase);
     wickr_buffer_destroy_zero(&serialized_storage_keys);
     
     return protected;
@@ -748,14 +763,20 @@ void wickr_ctx_packet_destroy(wickr_ctx_packet_t **packet)
     *packet = NULL;
 }
 
+/*
+ When the caller wraps a packet operation in an arena scope, the temporaries of the operation live in the arena. The objects that
+ make up the result are built with the arena suspended instead, so they outlive the scope without being copied out of it
+ */
 wickr_encoder_result_t *wickr_ctx_encode_packet(const wickr_ctx_t *ctx, const wickr_payload_t *payload, const wickr_node_array_t *nodes)
 {
     if (!ctx || !payload || !nodes) {
         return NULL;
     }
     
-    /* Generate a random key to encode the payload for this packet */
+    /* Generate a random key to encode the payload for this packet, it is returned as part of the result */
+    wickr_arena_t *arena = wickr_arena_suspend();
     wickr_cipher_key_t *rnd_payload_key = ctx->engine.wickr_crypto_engine_cipher_key_random(ctx->engine.default_cipher);
+    wickr_arena_resume(arena);
     
     if (!rnd_payload_key) {
         return NULL;
@@ -774,7 +795,9 @@ wickr_encoder_result_t *wickr_ctx_encode_packet(const wickr_ctx_t *ctx, const wi
     
     wickr_ec_key_destroy(&rnd_exchange_key);
     
+    arena = wickr_arena_suspend();
     wickr_encoder_result_t *ctx_encode = wickr_encoder_result_create(rnd_payload_key, generated_packet);
+    wickr_arena_resume(arena);
     
     if (!ctx_encode) {
         wickr_cipher_key_destroy(&rnd_payload_key);
@@ -791,7 +814,9 @@ static wickr_ctx_packet_t *__wickr_ctx_read_packet(const wickr_ctx_t *ctx, const
         return NULL;
     }
     
+    wickr_arena_t *arena = wickr_arena_suspend();
     wickr_packet_t *packet = wickr_packet_create_from_buffer(packet_buffer);
+    wickr_arena_resume(arena);
     
     if (!packet) {
         return NULL;
@@ -807,7 +832,10 @@ static wickr_ctx_packet_t *__wickr_ctx_read_packet(const wickr_ctx_t *ctx, const
         return NULL;
     }
     
+    arena = wickr_arena_suspend();
     wickr_identity_chain_t *chain_copy = wickr_identity_chain_copy(sender);
+    wickr_ctx_packet_t *ctx_packet = chain_copy ? wickr_ctx_packet_create(packet, chain_copy, result) : NULL;
+    wickr_arena_resume(arena);
     
     if (!chain_copy) {
         wickr_packet_destroy(&packet);
@@ -815,8 +843,6 @@ static wickr_ctx_packet_t *__wickr_ctx_read_packet(const wickr_ctx_t *ctx, const
         return NULL;
     }
     
-    wickr_ctx_packet_t *ctx_packet = wickr_ctx_packet_create(packet, chain_copy, result);
-    
     if (!ctx_packet) {
         wickr_identity_chain_destroy(&chain_copy);
         wickr_packet_destroy(&packet);
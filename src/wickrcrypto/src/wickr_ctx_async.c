@@ -0,0 +1,523 @@
+
+#include "wickr_ctx_async.h"
+#include "memory.h"
+#include "private/threads_priv.h"
+
+typedef enum {
+    ASYNC_OP_EXPORT,
+    ASYNC_OP_EXPORT_STORAGE_KEYS,
+    ASYNC_OP_IMPORT,
+    ASYNC_OP_GEN_WITH_PASSPHRASE
+} wickr_async_op_type;
+
+struct wickr_async_op {
+    wickr_async_op_type type;
+    wickr_mutex_t lock;
+    wickr_cond_t done_cond;
+    uint32_t ref_count;
+    wickr_async_status status;
+    bool is_cancelled;
+    bool is_complete;
+    wickr_crypto_engine_t engine;
+    wickr_ctx_t *ctx;
+    wickr_dev_info_t *dev_info;
+    wickr_buffer_t *exported;
+    wickr_buffer_t *passphrase;
+    wickr_buffer_t *recovery_data;
+    wickr_buffer_t *identifier;
+    void *result;
+    wickr_ctx_async_buffer_func on_buffer;
+    wickr_ctx_async_ctx_func on_ctx;
+    wickr_ctx_async_gen_func on_gen;
+    void *user;
+};
+
+/* Internal executor, a single lazily started worker thread that runs operations in submission order */
+
+typedef struct wickr_async_job {
+    wickr_async_work_func func;
+    void *work;
+    struct wickr_async_job *next;
+} wickr_async_job_t;
+
+static wickr_mutex_t __wickr_async_worker_lock = WICKR_MUTEX_INITIALIZER;
+static wickr_cond_t __wickr_async_worker_cond = WICKR_COND_INITIALIZER;
+static wickr_async_job_t *__wickr_async_job_head = NULL;
+static wickr_async_job_t *__wickr_async_job_tail = NULL;
+static bool __wickr_async_worker_started = false;
+
+static void *__wickr_async_worker(void *arg)
+{
+    wickr_mutex_lock(&__wickr_async_worker_lock);
+    
+    for (;;) {
+        while (!__wickr_async_job_head) {
+            wickr_cond_wait(&__wickr_async_worker_cond, &__wickr_async_worker_lock);
+        }
+    
+        wickr_async_job_t *job = __wickr_async_job_head;
+        __wickr_async_job_head = job->next;
+    
+        if (!__wickr_async_job_head) {
+            __wickr_async_job_tail = NULL;
+        }
+    
+        wickr_mutex_unlock(&__wickr_async_worker_lock);
+    
+        job->func(job->work);
+        wickr_free(job);
+    
+        wickr_mutex_lock(&__wickr_async_worker_lock);
+    }
+    
+    return NULL;
+}
+
+static bool __wickr_async_worker_submit(wickr_async_work_func func, void *work, void *user)
+{
+    wickr_async_job_t *job = wickr_alloc_zero(sizeof(wickr_async_job_t));
+    
+    if (!job) {
+        return false;
+    }
+    
+    job->func = func;
+    job->work = work;
+    
+    wickr_mutex_lock(&__wickr_async_worker_lock);
+    
+    /* The worker lives for the remainder of the process once started */
+    if (!__wickr_async_worker_started) {
+        wickr_thread_t thread;
+    
+        if (!wickr_thread_create(&thread, __wickr_async_worker, NULL)) {
+            wickr_mutex_unlock(&__wickr_async_worker_lock);
+            wickr_free(job);
+            return false;
+        }
+    
+        wickr_thread_detach(thread);
+        __wickr_async_worker_started = true;
+    }
+    
+    if (__wickr_async_job_tail) {
+        __wickr_async_job_tail->next = job;
+    } else {
+        __wickr_async_job_head = job;
+    }
+    
+    __wickr_async_job_tail = job;
+    
+    wickr_cond_signal(&__wickr_async_worker_cond);
+    wickr_mutex_unlock(&__wickr_async_worker_lock);
+    
+    return true;
+}
+
+/* Operations */
+
+static void __wickr_async_op_destroy_result(wickr_async_op_type type, void **result)
+{
+    if (!*result) {
+        return;
+    }
+    
+    switch (type) {
+        case ASYNC_OP_EXPORT:
+        case ASYNC_OP_EXPORT_STORAGE_KEYS:
+            wickr_buffer_destroy((wickr_buffer_t **)result);
+            break;
+        case ASYNC_OP_IMPORT:
+            wickr_ctx_destroy((wickr_ctx_t **)result);
+            break;
+        case ASYNC_OP_GEN_WITH_PASSPHRASE:
+            wickr_ctx_gen_result_destroy((wickr_ctx_gen_result_t **)result);
+            break;
+    }
+}
+
+/* Inputs are released as soon as the work is done so that key material doesn't outlive the operation */
+static void __wickr_async_op_destroy_inputs(wickr_async_op_t *op)
+{
+    wickr_ctx_destroy(&op->ctx);
+    wickr_dev_info_destroy(&op->dev_info);
+    wickr_buffer_destroy_zero(&op->exported);
+    wickr_buffer_destroy_zero(&op->passphrase);
+    wickr_buffer_destroy_zero(&op->recovery_data);
+    wickr_buffer_destroy(&op->identifier);
+}
+
+static void __wickr_async_op_release(wickr_async_op_t *op)
+{
+    wickr_mutex_lock(&op->lock);
+    uint32_t ref_count = --op->ref_count;
+    wickr_mutex_unlock(&op->lock);
+    
+    if (ref_count > 0) {
+        return;
+    }
+    
+    __wickr_async_op_destroy_inputs(op);
+    __wickr_async_op_destroy_result(op->type, &op->result);
+    wickr_cond_destroy(&op->done_cond);
+    wickr_mutex_destroy(&op->lock);
+    wickr_free(op);
+}
+
+static wickr_async_op_t *__wickr_async_op_create(wickr_async_op_type type, const wickr_crypto_engine_t engine, void *user)
+{
+    wickr_async_op_t *op = wickr_alloc_zero(sizeof(wickr_async_op_t));
+    
+    if (!op) {
+        return NULL;
+    }
+    
+    if (!wickr_mutex_init(&op->lock)) {
+        wickr_free(op);
+        return NULL;
+    }
+    
+    if (!wickr_cond_init(&op->done_cond)) {
+        wickr_mutex_destroy(&op->lock);
+        wickr_free(op);
+        return NULL;
+    }
+    
+    op->type = type;
+    op->engine = engine;
+    op->status = ASYNC_STATUS_PENDING;
+    op->user = user;
+    
+    /* One reference for the caller and one for the executor */
+    op->ref_count = 2;
+    
+    return op;
+}
+
+static void *__wickr_async_op_perform(wickr_async_op_t *op)
+{
+    switch (op->type) {
+        case ASYNC_OP_EXPORT:
+            return wickr_ctx_export(op->ctx, op->passphrase);
+        case ASYNC_OP_EXPORT_STORAGE_KEYS:
+            return wickr_ctx_export_storage_keys(op->ctx, op->passphrase);
+        case ASYNC_OP_IMPORT:
+        {
+            wickr_ctx_t *ctx = wickr_ctx_import(op->engine, op->dev_info, op->exported, op->passphrase);
+    
+            /* The imported context takes ownership of the device info */
+            if (ctx) {
+                op->dev_info = NULL;
+            }
+    
+            return ctx;
+        }
+        case ASYNC_OP_GEN_WITH_PASSPHRASE:
+            return wickr_ctx_gen_with_passphrase(op->engine, op->dev_info, op->exported,
+                                                 op->passphrase, op->recovery_data, op->identifier);
+    }
+    
+    return NULL;
+}
+
+static void __wickr_async_op_notify(wickr_async_op_t *op, wickr_async_status status, void *result)
+{
+    switch (op->type) {
+        case ASYNC_OP_EXPORT:
+        case ASYNC_OP_EXPORT_STORAGE_KEYS:
+            op->on_buffer(status, result, op->user);
+            break;
+        case ASYNC_OP_IMPORT:
+            op->on_ctx(status, result, op->user);
+            break;
+        case ASYNC_OP_GEN_WITH_PASSPHRASE:
+            op->on_gen(status, result, op->user);
+            break;
+    }
+}
+
+static bool __wickr_async_op_has_callback(const wickr_async_op_t *op)
+{
+    return op->on_buffer || op->on_ctx || op->on_gen;
+}
+
+static void __wickr_async_op_run(void *work)
+{
+    wickr_async_op_t *op = work;
+    void *result = NULL;
+    
+    wickr_mutex_lock(&op->lock);
+    bool should_run = !op->is_cancelled;
+    op->status = should_run ? ASYNC_STATUS_RUNNING : ASYNC_STATUS_CANCELLED;
+    wickr_mutex_unlock(&op->lock);
+    
+    if (should_run) {
+        result = __wickr_async_op_perform(op);
+    }
+    
+    __wickr_async_op_destroy_inputs(op);
+    
+    wickr_mutex_lock(&op->lock);
+    
+    /* A cancellation that arrives while the KDF is running discards the result */
+    if (op->is_cancelled) {
+        __wickr_async_op_destroy_result(op->type, &result);
+        op->status = ASYNC_STATUS_CANCELLED;
+    } else {
+        op->status = result ? ASYNC_STATUS_SUCCESS : ASYNC_STATUS_FAILED;
+    }
+    
+    wickr_async_status status = op->status;
+    bool has_callback = __wickr_async_op_has_callback(op);
+    
+    if (!has_callback) {
+        op->result = result;
+    }
+    
+    wickr_mutex_unlock(&op->lock);
+    
+    if (has_callback) {
+        __wickr_async_op_notify(op, status, result);
+    }
+    
+    wickr_mutex_lock(&op->lock);
+    op->is_complete = true;
+    wickr_cond_broadcast(&op->done_cond);
+    wickr_mutex_unlock(&op->lock);
+    
+    __wickr_async_op_release(op);
+}
+
+static wickr_async_op_t *__wickr_async_op_submit(wickr_async_op_t *op, const wickr_async_executor_t *executor)
+{
+    bool did_submit;
+    
+    if (executor && executor->submit) {
+        did_submit = executor->submit(__wickr_async_op_run, op, executor->user);
+    } else {
+        did_submit = __wickr_async_worker_submit(__wickr_async_op_run, op, NULL);
+    }
+    
+    if (!did_submit) {
+        op->ref_count = 1;
+        __wickr_async_op_release(op);
+        return NULL;
+    }
+    
+    return op;
+}
+
+/* Public interface */
+
+static wickr_async_op_t *__wickr_ctx_export_async(wickr_async_op_type type,
+                                                  const wickr_ctx_t *ctx,
+                                                  const wickr_buffer_t *passphrase,
+                                                  const wickr_async_executor_t *executor,
+                                                  wickr_ctx_async_buffer_func on_complete,
+                                                  void *user)
+{
+    if (!ctx || !passphrase) {
+        return NULL;
+    }
+    
+    wickr_async_op_t *op = __wickr_async_op_create(type, ctx->engine, user);
+    
+    if (!op) {
+        return NULL;
+    }
+    
+    op->on_buffer = on_complete;
+    op->ctx = wickr_ctx_copy(ctx);
+    op->passphrase = wickr_buffer_copy(passphrase);
+    
+    if (!op->ctx || !op->passphrase) {
+        op->ref_count = 1;
+        __wickr_async_op_release(op);
+        return NULL;
+    }
+    
+    return __wickr_async_op_submit(op, executor);
+}
+
+wickr_async_op_t *wickr_ctx_export_async(const wickr_ctx_t *ctx,
+                                         const wickr_buffer_t *passphrase,
+                                         const wickr_async_executor_t *executor,
+                                         wickr_ctx_async_buffer_func on_complete,
+                                         void *user)
+{
+    return __wickr_ctx_export_async(ASYNC_OP_EXPORT, ctx, passphrase, executor, on_complete, user);
+}
+
+wickr_async_op_t *wickr_ctx_export_storage_keys_async(const wickr_ctx_t *ctx,
+                                                      const wickr_buffer_t *passphrase,
+                                                      const wickr_async_executor_t *executor,
+                                                      wickr_ctx_async_buffer_func on_complete,
+                                                      void *user)
+{
+    return __wickr_ctx_export_async(ASYNC_OP_EXPORT_STORAGE_KEYS, ctx, passphrase, executor, on_complete, user);
+}
+
+wickr_async_op_t *wickr_ctx_import_async(const wickr_crypto_engine_t engine,
+                                         const wickr_dev_info_t *dev_info,
+                                         const wickr_buffer_t *exported,
+                                         const wickr_buffer_t *passphrase,
+                                         const wickr_async_executor_t *executor,
+                                         wickr_ctx_async_ctx_func on_complete,
+                                         void *user)
+{
+    if (!dev_info || !exported || !passphrase) {
+        return NULL;
+    }
+    
+    wickr_async_op_t *op = __wickr_async_op_create(ASYNC_OP_IMPORT, engine, user);
+    
+    if (!op) {
+        return NULL;
+    }
+    
+    op->on_ctx = on_complete;
+    op->dev_info = wickr_dev_info_copy(dev_info);
+    op->exported = wickr_buffer_copy(exported);
+    op->passphrase = wickr_buffer_copy(passphrase);
+    
+    if (!op->dev_info || !op->exported || !op->passphrase) {
+        op->ref_count = 1;
+        __wickr_async_op_release(op);
+        return NULL;
+    }
+    
+    return __wickr_async_op_submit(op, executor);
+}
+
+wickr_async_op_t *wickr_ctx_gen_with_passphrase_async(const wickr_crypto_engine_t engine,
+                                                      const wickr_dev_info_t *dev_info,
+                                                      const wickr_buffer_t *exported_recovery_key,
+                                                      const wickr_buffer_t *passphrase,
+                                                      const wickr_buffer_t *recovery_data,
+                                                      const wickr_buffer_t *identifier,
+                                                      const wickr_async_executor_t *executor,
+                                                      wickr_ctx_async_gen_func on_complete,
+                                                      void *user)
+{
+    if (!dev_info || !exported_recovery_key || !passphrase || !recovery_data || !identifier) {
+        return NULL;
+    }
+    
+    wickr_async_op_t *op = __wickr_async_op_create(ASYNC_OP_GEN_WITH_PASSPHRASE, engine, user);
+    
+    if (!op) {
+        return NULL;
+    }
+    
+    op->on_gen = on_complete;
+    op->dev_info = wickr_dev_info_copy(dev_info);
+    op->exported = wickr_buffer_copy(exported_recovery_key);
+    op->passphrase = wickr_buffer_copy(passphrase);
+    op->recovery_data = wickr_buffer_copy(recovery_data);
+    op->identifier = wickr_buffer_copy(identifier);
+    
+    if (!op->dev_info || !op->exported || !op->passphrase || !op->recovery_data || !op->identifier) {
+        op->ref_count = 1;
+        __wickr_async_op_release(op);
+        return NULL;
+    }
+    
+    return __wickr_async_op_submit(op, executor);
+}
+
+bool wickr_async_op_cancel(wickr_async_op_t *op)
+{
+    if (!op) {
+        return false;
+    }
+    
+    wickr_mutex_lock(&op->lock);
+    
+    bool did_cancel = op->status == ASYNC_STATUS_PENDING || op->status == ASYNC_STATUS_RUNNING;
+    
+    if (did_cancel) {
+        op->is_cancelled = true;
+    }
+    
+    wickr_mutex_unlock(&op->lock);
+    
+    return did_cancel;
+}
+
+wickr_async_status wickr_async_op_wait(wickr_async_op_t *op)
+{
+    if (!op) {
+        return ASYNC_STATUS_FAILED;
+    }
+    
+    wickr_mutex_lock(&op->lock);
+    
+    while (!op->is_complete) {
+        wickr_cond_wait(&op->done_cond, &op->lock);
+    }
+    
+    wickr_async_status status = op->status;
+    wickr_mutex_unlock(&op->lock);
+    
+    return status;
+}
+
+wickr_async_status wickr_async_op_get_status(const wickr_async_op_t *op)
+{
+    if (!op) {
+        return ASYNC_STATUS_FAILED;
+    }
+    
+    wickr_async_op_t *mutable_op = (wickr_async_op_t *)op;
+    
+    wickr_mutex_lock(&mutable_op->lock);
+    wickr_async_status status = mutable_op->status;
+    wickr_mutex_unlock(&mutable_op->lock);
+    
+    return status;
+}
+
+static void *__wickr_async_op_take(wickr_async_op_t *op, wickr_async_op_type type, wickr_async_op_type alt_type)
+{
+    if (!op) {
+        return NULL;
+    }
+    
+    void *result = NULL;
+    
+    wickr_mutex_lock(&op->lock);
+    
+    if (op->type == type || op->type == alt_type) {
+        result = op->result;
+        op->result = NULL;
+    }
+    
+    wickr_mutex_unlock(&op->lock);
+    
+    return result;
+}
+
+wickr_buffer_t *wickr_async_op_take_buffer(wickr_async_op_t *op)
+{
+    return __wickr_async_op_take(op, ASYNC_OP_EXPORT, ASYNC_OP_EXPORT_STORAGE_KEYS);
+}
+
+wickr_ctx_t *wickr_async_op_take_ctx(wickr_async_op_t *op)
+{
+    return __wickr_async_op_take(op, ASYNC_OP_IMPORT, ASYNC_OP_IMPORT);
+}
+
+wickr_ctx_gen_result_t *wickr_async_op_take_gen_result(wickr_async_op_t *op)
+{
+    return __wickr_async_op_take(op, ASYNC_OP_GEN_WITH_PASSPHRASE, ASYNC_OP_GEN_WITH_PASSPHRASE);
+}
+
+void wickr_async_op_destroy(wickr_async_op_t **op)
+{
+    if (!op || !*op) {
+        return;
+    }
+    
+    __wickr_async_op_release(*op);
+    *op = NULL;
+}
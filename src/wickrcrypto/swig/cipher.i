@@ -15,6 +15,8 @@
 %ignore wickr_cipher_key_destroy;
 %ignore wickr_cipher_result_serialize;
 %ignore wickr_cipher_result_from_buffer;
+%ignore wickr_cipher_result_serialize_compact;
+%ignore wickr_cipher_result_from_compact_buffer;
 %ignore wickr_cipher_key_serialize;
 %ignore wickr_cipher_key_from_buffer;
 %ignore wickr_cipher_result_is_valid;
@@ -22,4 +22,10 @@
   static const wickr_digest_t *sha512() {
       return &DIGEST_SHA_512;
   }
+  static const wickr_digest_t *sha256Tree() {
+      return &DIGEST_SHA_256_TREE;
+  }
+  static const wickr_digest_t *sha512Tree() {
+      return &DIGEST_SHA_512_TREE;
+  }
 }
@@ -46,6 +46,7 @@
 %rename(ContextParseResult) wickr_ctx_packet;
 %rename(ContextDecodeResult) wickr_decode_result;
 %rename(ContextGenResult) wickr_ctx_gen_result;
+%rename(AsyncOperation) wickr_async_op;
 %rename(EphemeralInfo) wickr_ephemeral_info;
 %rename(Fingerprint) wickr_fingerprint;
 
@@ -62,6 +63,7 @@
 %rename (CurveID) wickr_ec_curve_id;
 %rename (KDFAlgoID) wickr_kdf_algo_id;
 %rename (KDFID) wickr_kdf_id;
+%rename (AsyncStatus) wickr_async_status;
 
 %rename (ECDHCipherContext) wickr_ecdh_cipher_ctx;
 %rename (EncoderResult) wickr_encoder_result;
@@ -69,6 +71,7 @@
 %rename (TransportCtx) wickr_transport_ctx;
 %rename (TransportStatus) wickr_transport_status;
 %rename (TransportError) wickr_transport_error;
+%rename (TransportStats) wickr_transport_stats;
 %rename (TransportPayloadType) wickr_transport_payload_type;
 
 %rename("%(lowercamelcase)s", %$isfunction) "";
@@ -115,5 +118,6 @@
 %include payload.i
 %include packet_meta.i
 %include wickr_ctx.i
+%include wickr_ctx_async.i
 %include transport.i
 #endif
\ No newline at end of file
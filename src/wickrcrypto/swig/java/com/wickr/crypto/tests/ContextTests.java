@@ -230,4 +230,28 @@ public class ContextTests
 		assertArrayEquals(restoredContext.getIdChain().getRoot().getIdentifier(), identifier);
 
 	}
+
+	@Test
+	public void testContextExportAsync() throws UnsupportedEncodingException {
+
+		byte[] password = "password".getBytes("UTF8");
+
+		//Export on the library worker thread and collect the result from the operation
+		AsyncOperation exportOp = ctx.exportPassphraseAsync(password);
+		assertNotNull(exportOp);
+		assertEquals(exportOp.waitUntilComplete(), AsyncStatus.ASYNC_STATUS_SUCCESS);
+
+		byte[] exportedContext = exportOp.takeBuffer();
+		assertNotNull(exportedContext);
+		assertNull(exportOp.takeBuffer());
+
+		AsyncOperation importOp = Context.importFromBufferAsync(devinfo, exportedContext, password);
+		assertNotNull(importOp);
+		assertEquals(importOp.waitUntilComplete(), AsyncStatus.ASYNC_STATUS_SUCCESS);
+
+		Context restoredContext = importOp.takeCtx();
+		assertNotNull(restoredContext);
+		assertArrayEquals(restoredContext.getIdChain().getRoot().getIdentifier(), identifier);
+
+	}
 }
\ No newline at end of file
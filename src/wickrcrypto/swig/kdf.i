@@ -28,6 +28,7 @@
 %ignore wickr_kdf_result_destroy;
 %ignore wickr_perform_kdf;
 %ignore wickr_perform_kdf_meta;
+%ignore wickr_kdf_calibrate;
 
 %nodefaultctor wickr_kdf_algo;
 %nodefaultdtor wickr_kdf_algo;
@@ -49,6 +50,21 @@
   static const wickr_kdf_algo_t *scrypt_20() {
       return &KDF_SCRYPT_2_20;
   }
+  static const wickr_kdf_algo_t *scrypt_17_p4() {
+      return &KDF_SCRYPT_2_17_P4;
+  }
+  static const wickr_kdf_algo_t *scrypt_18_p4() {
+      return &KDF_SCRYPT_2_18_P4;
+  }
+  static const wickr_kdf_algo_t *argon2id_16() {
+      return &KDF_ARGON2ID_2_16;
+  }
+  static const wickr_kdf_algo_t *argon2id_18() {
+      return &KDF_ARGON2ID_2_18;
+  }
+  static const wickr_kdf_algo_t *argon2id_20() {
+      return &KDF_ARGON2ID_2_20;
+  }
   static const wickr_kdf_algo_t *bcrypt_15() {
       return &KDF_BCRYPT_15;
   }
@@ -61,6 +77,9 @@
   static const wickr_kdf_algo_t *hkdf_sha512() {
       return &KDF_HKDF_SHA512;
   }
+  static const wickr_kdf_algo_t *calibrate(uint32_t target_ms, uint64_t max_memory) {
+      return wickr_kdf_calibrate(target_ms, max_memory);
+  }
 }
 
 %extend struct wickr_kdf_meta{
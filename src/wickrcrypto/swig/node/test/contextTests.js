@@ -212,4 +212,41 @@ describe ("Context Tests", function() {
 
     })
 
+    it("can be exported and imported asynchronously", function(done) {
+
+        this.timeout(15000)
+
+        var password = Buffer.from('password')
+
+        //Export on the library worker thread, the callback is delivered on the event loop
+        var exportOp = ctx.exportPassphraseAsync(password, function(status, exportedContext) {
+            expect(status).to.eql(wickrcrypto.ASYNC_STATUS_SUCCESS)
+            expect(exportedContext).to.be.a("object")
+
+            var importOp = wickrcrypto.Context.importFromBufferAsync(devinfo, exportedContext, password, function(status, restoredContext) {
+                expect(status).to.eql(wickrcrypto.ASYNC_STATUS_SUCCESS)
+                expect(restoredContext).to.be.a("object")
+                expect(restoredContext.idChain.root.identifier).to.eql(identifier)
+                done()
+            })
+
+            expect(importOp).to.be.a("object")
+        })
+
+        expect(exportOp).to.be.a("object")
+    })
+
+    it("can cancel an asynchronous export", function(done) {
+
+        this.timeout(15000)
+
+        var exportOp = ctx.exportPassphraseAsync(Buffer.from('password'), function(status, exportedContext) {
+            expect(status).to.eql(wickrcrypto.ASYNC_STATUS_CANCELLED)
+            expect(exportedContext).to.be(null)
+            done()
+        })
+
+        expect(exportOp.cancel()).to.be(true)
+    })
+
 })
\ No newline at end of file
@@ -27,6 +27,7 @@
 %ignore wickr_transport_ctx_get_user_ctx;
 %ignore wickr_transport_ctx_set_user_ctx;
 %ignore wickr_transport_ctx_get_last_error;
+%ignore wickr_transport_ctx_get_stats;
 
 %nodefaultctor wickr_transport_ctx;
 %nodefaultdtor wickr_transport_ctx;
@@ -35,6 +36,7 @@ struct wickr_transport_ctx { };
 
 %include "wickrcrypto/transport_ctx.h"
 %include "wickrcrypto/transport_error.h"
+%include "wickrcrypto/transport_stats.h"
 
 %extend struct wickr_transport_ctx {
 
@@ -70,6 +72,7 @@ struct wickr_transport_ctx { };
   void process_rx_buffer(const wickr_buffer_t *buffer);
   wickr_transport_status get_status();
   wickr_transport_error get_last_error();
+  wickr_transport_stats_t get_stats();
 
 };
 
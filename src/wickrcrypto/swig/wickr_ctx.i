@@ -41,6 +41,7 @@
 %ignore wickr_ctx_copy;
 %ignore wickr_ctx_destroy;
 %ignore wickr_ctx_export_storage_keys;
+%ignore wickr_ctx_export_storage_keys_with_kdf;
 %ignore wickr_ctx_import_storage_keys;
 %ignore wickr_ctx_cipher_local;
 %ignore wickr_ctx_decipher_local;
@@ -55,6 +56,7 @@
 %ignore wickr_ctx_decode_packet;
 %ignore wickr_ctx_serialize;
 %ignore wickr_ctx_export;
+%ignore wickr_ctx_export_with_kdf;
 %ignore wickr_ctx_import;
 %ignore wickr_ctx_create_from_buffer;
 %ignore wickr_key_exchange_create_with_packet_key;
@@ -118,9 +120,15 @@
     %newobject from_buffer;
     %newobject export;
     %newobject import_from_buffer;
+    %newobject export_passphrase_with_kdf;
+    %newobject export_storage_keys_with_kdf;
 
 	wickr_buffer_t *export_storage_keys(const wickr_buffer_t *passphrase);
 
+    wickr_buffer_t *export_storage_keys_with_kdf(wickr_kdf_algo_t algo, const wickr_buffer_t *passphrase) {
+        return wickr_ctx_export_storage_keys_with_kdf($self, algo, passphrase);
+    }
+
 	static wickr_storage_keys_t *import_storage(const wickr_buffer_t *exported, const wickr_buffer_t *passphrase) {
 		const wickr_crypto_engine_t engine = wickr_crypto_engine_get_default();
 		return wickr_ctx_import_storage_keys(engine, exported, passphrase);
@@ -181,6 +189,10 @@
         return wickr_ctx_export($self, passphrase);
     }
 
+    wickr_buffer_t *export_passphrase_with_kdf(wickr_kdf_algo_t algo, const wickr_buffer_t *passphrase) {
+        return wickr_ctx_export_with_kdf($self, algo, passphrase);
+    }
+
 	wickr_cipher_result_t *cipher_local(const wickr_buffer_t *plaintext);
 	wickr_buffer_t *decipher_local(const wickr_cipher_result_t *cipher_text);
 	wickr_cipher_result_t *cipher_remote(const wickr_buffer_t *plaintext);
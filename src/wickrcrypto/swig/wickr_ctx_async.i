@@ -0,0 +1,129 @@
+%module wickr_ctx_async
+
+%include wickr_ctx.i
+
+%{
+#include <wickrcrypto/wickr_ctx_async.h>
+%}
+
+#if defined(SWIGJAVASCRIPT)
+
+%include "wickr_ctx_async_js.i"
+
+#else
+
+/* Languages without a completion callback bridge collect results from the operation handle instead */
+
+%typemap(in, numinputs=0) (wickr_ctx_async_buffer_func on_complete, void *user),
+                          (wickr_ctx_async_ctx_func on_complete, void *user),
+                          (wickr_ctx_async_gen_func on_complete, void *user)
+%{
+    $1 = NULL;
+    $2 = NULL;
+%}
+
+%{
+static void WickrAsyncSubmitFailed(void *user)
+{
+}
+%}
+
+#endif
+
+%immutable;
+
+%ignore wickr_async_executor;
+%ignore wickr_ctx_export_async;
+%ignore wickr_ctx_import_async;
+%ignore wickr_ctx_export_storage_keys_async;
+%ignore wickr_ctx_gen_with_passphrase_async;
+%ignore wickr_async_op_cancel;
+%ignore wickr_async_op_wait;
+%ignore wickr_async_op_get_status;
+%ignore wickr_async_op_take_buffer;
+%ignore wickr_async_op_take_ctx;
+%ignore wickr_async_op_take_gen_result;
+%ignore wickr_async_op_destroy;
+
+%nodefaultctor wickr_async_op;
+%nodefaultdtor wickr_async_op;
+
+struct wickr_async_op { };
+
+%include "wickrcrypto/wickr_ctx_async.h"
+
+%extend struct wickr_async_op {
+
+    ~wickr_async_op() {
+        wickr_async_op_destroy(&$self);
+    }
+
+    %newobject take_buffer;
+    %newobject take_ctx;
+    %newobject take_gen_result;
+
+    bool cancel();
+    wickr_async_status get_status();
+
+    wickr_async_status wait_until_complete() {
+        return wickr_async_op_wait($self);
+    }
+
+    wickr_buffer_t *take_buffer();
+    wickr_ctx_t *take_ctx();
+    wickr_ctx_gen_result_t *take_gen_result();
+};
+
+%extend struct wickr_ctx {
+
+    %newobject export_passphrase_async;
+    %newobject export_storage_keys_async;
+    %newobject import_from_buffer_async;
+
+    wickr_async_op_t *export_passphrase_async(const wickr_buffer_t *passphrase, wickr_ctx_async_buffer_func on_complete, void *user) {
+        wickr_async_op_t *op = wickr_ctx_export_async($self, passphrase, NULL, on_complete, user);
+
+        if (!op) {
+            WickrAsyncSubmitFailed(user);
+        }
+
+        return op;
+    }
+
+    wickr_async_op_t *export_storage_keys_async(const wickr_buffer_t *passphrase, wickr_ctx_async_buffer_func on_complete, void *user) {
+        wickr_async_op_t *op = wickr_ctx_export_storage_keys_async($self, passphrase, NULL, on_complete, user);
+
+        if (!op) {
+            WickrAsyncSubmitFailed(user);
+        }
+
+        return op;
+    }
+
+    static wickr_async_op_t *import_from_buffer_async(wickr_dev_info_t *dev_info, const wickr_buffer_t *exported, const wickr_buffer_t *passphrase, wickr_ctx_async_ctx_func on_complete, void *user) {
+        const wickr_crypto_engine_t engine = wickr_crypto_engine_get_default();
+        wickr_async_op_t *op = wickr_ctx_import_async(engine, dev_info, exported, passphrase, NULL, on_complete, user);
+
+        if (!op) {
+            WickrAsyncSubmitFailed(user);
+        }
+
+        return op;
+    }
+};
+
+%extend struct wickr_ctx_gen_result {
+
+    %newobject gen_with_passphrase_async;
+
+    static wickr_async_op_t *gen_with_passphrase_async(wickr_dev_info_t *dev_info, wickr_buffer_t *exported_recovery_key, wickr_buffer_t *passphrase, wickr_buffer_t *recovery_data, wickr_buffer_t *identifier, wickr_ctx_async_gen_func on_complete, void *user) {
+        const wickr_crypto_engine_t engine = wickr_crypto_engine_get_default();
+        wickr_async_op_t *op = wickr_ctx_gen_with_passphrase_async(engine, dev_info, exported_recovery_key, passphrase, recovery_data, identifier, NULL, on_complete, user);
+
+        if (!op) {
+            WickrAsyncSubmitFailed(user);
+        }
+
+        return op;
+    }
+};
@@ -0,0 +1,133 @@
+%{
+#include <uv.h>
+
+/*
+ Completion callbacks for async operations fire on the worker thread, where calling into v8 is not allowed. The result is handed
+ to the event loop with a uv_async_t, and the JS function is called from there with (status, result)
+ */
+struct WickrAsyncCompletion {
+    uv_async_t handle;
+    v8::Persistent<v8::Function> callback;
+    swig_type_info *result_type;
+    wickr_async_status status;
+    void *result;
+};
+
+static void WickrAsyncCompletionClosed(uv_handle_t *handle)
+{
+    WickrAsyncCompletion *completion = (WickrAsyncCompletion *)handle->data;
+    completion->callback.Reset();
+    delete completion;
+}
+
+static void WickrAsyncCompletionDeliver(uv_async_t *handle)
+{
+    WickrAsyncCompletion *completion = (WickrAsyncCompletion *)handle->data;
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope scope(isolate);
+
+    v8::Local<v8::Value> result = v8::Null(isolate);
+
+    if (completion->result && !completion->result_type) {
+        wickr_buffer_t *buffer = (wickr_buffer_t *)completion->result;
+        result = node::Buffer::Copy(isolate, (const char *)buffer->bytes, buffer->length).ToLocalChecked();
+        wickr_buffer_destroy(&buffer);
+    } else if (completion->result) {
+        result = SWIG_NewPointerObj(completion->result, completion->result_type, SWIG_POINTER_OWN | 0);
+    }
+
+    v8::Local<v8::Function> callback = v8::Local<v8::Function>::New(isolate, completion->callback);
+    v8::Local<v8::Value> argv[] = {
+        v8::Number::New(isolate, (double)completion->status),
+        result
+    };
+
+    if (callback->Call(isolate->GetCurrentContext(), v8::Null(isolate), 2, argv).IsEmpty()) {
+        printf("(wickr-crypto-c) Warning: Async completion callback threw an exception\n");
+    }
+
+    uv_close((uv_handle_t *)&completion->handle, WickrAsyncCompletionClosed);
+}
+
+static WickrAsyncCompletion *WickrAsyncCompletionCreate(v8::Local<v8::Value> input, swig_type_info *result_type)
+{
+    if (!input->IsFunction()) {
+        return NULL;
+    }
+
+    WickrAsyncCompletion *completion = new WickrAsyncCompletion();
+    completion->result_type = result_type;
+    completion->status = ASYNC_STATUS_PENDING;
+    completion->result = NULL;
+    completion->handle.data = completion;
+    completion->callback.Reset(v8::Isolate::GetCurrent(), v8::Local<v8::Function>::Cast(input));
+
+    if (uv_async_init(uv_default_loop(), &completion->handle, WickrAsyncCompletionDeliver) != 0) {
+        completion->callback.Reset();
+        delete completion;
+        return NULL;
+    }
+
+    return completion;
+}
+
+static void WickrAsyncSubmitFailed(void *user)
+{
+    WickrAsyncCompletion *completion = (WickrAsyncCompletion *)user;
+    uv_close((uv_handle_t *)&completion->handle, WickrAsyncCompletionClosed);
+}
+
+static void WickrAsyncCompletionPost(void *user, wickr_async_status status, void *result)
+{
+    WickrAsyncCompletion *completion = (WickrAsyncCompletion *)user;
+    completion->status = status;
+    completion->result = result;
+    uv_async_send(&completion->handle);
+}
+
+static void WickrAsyncBufferComplete(wickr_async_status status, wickr_buffer_t *result, void *user)
+{
+    WickrAsyncCompletionPost(user, status, result);
+}
+
+static void WickrAsyncCtxComplete(wickr_async_status status, wickr_ctx_t *result, void *user)
+{
+    WickrAsyncCompletionPost(user, status, result);
+}
+
+static void WickrAsyncGenComplete(wickr_async_status status, wickr_ctx_gen_result_t *result, void *user)
+{
+    WickrAsyncCompletionPost(user, status, result);
+}
+
+%}
+
+%typemap(in) (wickr_ctx_async_buffer_func on_complete, void *user)
+%{
+    $1 = &WickrAsyncBufferComplete;
+    $2 = WickrAsyncCompletionCreate($input, NULL);
+
+    if (!$2) {
+        SWIG_exception_fail(SWIG_TypeError, "Expected a completion function");
+    }
+%}
+
+%typemap(in) (wickr_ctx_async_ctx_func on_complete, void *user)
+%{
+    $1 = &WickrAsyncCtxComplete;
+    $2 = WickrAsyncCompletionCreate($input, SWIGTYPE_p_wickr_ctx);
+
+    if (!$2) {
+        SWIG_exception_fail(SWIG_TypeError, "Expected a completion function");
+    }
+%}
+
+%typemap(in) (wickr_ctx_async_gen_func on_complete, void *user)
+%{
+    $1 = &WickrAsyncGenComplete;
+    $2 = WickrAsyncCompletionCreate($input, SWIGTYPE_p_wickr_ctx_gen_result);
+
+    if (!$2) {
+        SWIG_exception_fail(SWIG_TypeError, "Expected a completion function");
+    }
+%}
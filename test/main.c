@@ -11,6 +11,10 @@
 #include "test_context.h"
 #include "test_node.h"
 #include "test_buffer.h"
+#include "test_buffer_writer.h"
+#include "test_memory.h"
+#include "test_arena.h"
+#include "test_secure_heap.h"
 #include "test_stream_cipher.h"
 #include "test_transport_ctx.h"
 #include "test_identity.h"
@@ -28,6 +32,7 @@
 #include "test_transport_packet.h"
 #include "test_transport_handshake.h"
 #include "test_transport_root_key.h"
+#include "test_transport_pool.h"
 #include "openssl_suite.h"
 
 #ifdef FIPS
@@ -40,7 +45,16 @@ static const char *ci_flag = "--ci";
 
 void run_primitive_tests(CSpecOutputStruct *output)
 {
+    CSpec_Run(DESCRIPTION(wickr_allocator), output);
+    CSpec_Run(DESCRIPTION(wickr_instrumented_allocator), output);
+    CSpec_Run(DESCRIPTION(wickr_secure_zero), output);
+    CSpec_Run(DESCRIPTION(wickr_arena), output);
+    CSpec_Run(DESCRIPTION(wickr_proto_arena), output);
+    CSpec_Run(DESCRIPTION(wickr_secure_heap), output);
     CSpec_Run(DESCRIPTION(wickr_buffer_tests), output);
+    CSpec_Run(DESCRIPTION(wickr_buffer_shared), output);
+    CSpec_Run(DESCRIPTION(wickr_buffer_cache), output);
+    CSpec_Run(DESCRIPTION(wickr_buffer_writer), output);
     CSpec_Run(DESCRIPTION(node_tests), output);
     CSpec_Run(DESCRIPTION(wickr_fingerprint), output);
     CSpec_Run(DESCRIPTION(wickr_fingerprint_generation), output);
@@ -50,6 +64,8 @@ void run_primitive_tests(CSpecOutputStruct *output)
     CSpec_Run(DESCRIPTION(ephemeral_keypair), output);
     CSpec_Run(DESCRIPTION(an_array_of_items), output);
     CSpec_Run(DESCRIPTION(a_zero_length_array), output);
+    CSpec_Run(DESCRIPTION(a_growable_array), output);
+    CSpec_Run(DESCRIPTION(an_inline_array), output);
     CSpec_Run(DESCRIPTION(wickr_ec_key), output);
     CSpec_Run(DESCRIPTION(cipher_result), output);
     CSpec_Run(DESCRIPTION(getBase64FromData), output);
@@ -69,9 +85,15 @@ void run_crypto_engine_tests(CSpecOutputStruct *output)
 {
     CSpec_Run(DESCRIPTION(encodePlainFile), output);
     CSpec_Run(DESCRIPTION(decodeCipherFile), output);
+    CSpec_Run(DESCRIPTION(mappedFile), output);
+    CSpec_Run(DESCRIPTION(pipelinedFile), output);
+    CSpec_Run(DESCRIPTION(segmentedFile), output);
+    CSpec_Run(DESCRIPTION(treeDigest), output);
+    CSpec_Run(DESCRIPTION(digestFile), output);
     CSpec_Run(DESCRIPTION(openssl_crypto_random), output);
     CSpec_Run(DESCRIPTION(openssl_cipher_key_random), output);
     CSpec_Run(DESCRIPTION(openssl_cipher_ctr), output);
+    CSpec_Run(DESCRIPTION(openssl_cipher_stream), output);
     CSpec_Run(DESCRIPTION(openssl_cipher_gcm), output);
     CSpec_Run(DESCRIPTION(openssl_ec_sign_verify), output);
     CSpec_Run(DESCRIPTION(openssl_ec_key_management), output);
@@ -105,8 +127,11 @@ void run_transport_tests(CSpecOutputStruct *output)
     CSpec_Run(DESCRIPTION(wickr_transport_packet_meta), output);
     CSpec_Run(DESCRIPTION(wickr_transport_packet), output);
     CSpec_Run(DESCRIPTION(wickr_transport_handshake), output);
+    CSpec_Run(DESCRIPTION(wickr_transport_handshake_resumption), output);
+    CSpec_Run(DESCRIPTION(wickr_transport_handshake_flags), output);
     CSpec_Run(DESCRIPTION(wickr_transport_handshake_res), output);
     CSpec_Run(DESCRIPTION(wickr_transport_ctx), output);
+    CSpec_Run(DESCRIPTION(wickr_transport_pool), output);
 }
 
 void run_messaging_protocol_tests(CSpecOutputStruct *output)
@@ -123,11 +148,15 @@ void run_context_api_tests(CSpecOutputStruct *output)
     CSpec_Run(DESCRIPTION(wickr_ctx_generate), output);
     CSpec_Run(DESCRIPTION(wickr_ctx_send_pkt), output);
     CSpec_Run(DESCRIPTION(wickr_ctx_functions), output);
+    CSpec_Run(DESCRIPTION(wickr_ctx_async), output);
 }
 
 void run_kdf_tests(CSpecOutputStruct *output)
 {
     CSpec_Run(DESCRIPTION(wickr_perform_kdf), output);
+    CSpec_Run(DESCRIPTION(wickr_scrypt_parallel), output);
+    CSpec_Run(DESCRIPTION(wickr_argon2id), output);
+    CSpec_Run(DESCRIPTION(wickr_kdf_calibrate), output);
     CSpec_Run(DESCRIPTION(wickr_crypto_engine_kdf), output);
 }
 
@@ -0,0 +1,279 @@
+#include "cspec.h"
+#include "test_arena.h"
+#include "arena.h"
+#include "memory.h"
+#include "buffer.h"
+#include "private/proto_arena_priv.h"
+#include "stream.pb-c.h"
+#include <string.h>
+
+DESCRIBE(wickr_arena, "arena.c: wickr_arena")
+{
+    IT("should only allow one open scope per arena")
+    {
+        wickr_arena_t *arena = wickr_arena_create(0);
+        SHOULD_NOT_BE_NULL(arena);
+        
+        SHOULD_BE_FALSE(wickr_arena_is_active());
+        SHOULD_BE_FALSE(wickr_arena_end(arena));
+        SHOULD_BE_NULL(wickr_arena_suspend());
+        
+        SHOULD_BE_TRUE(wickr_arena_begin(arena));
+        SHOULD_BE_TRUE(wickr_arena_is_active());
+        SHOULD_BE_FALSE(wickr_arena_begin(arena));
+        
+        SHOULD_BE_TRUE(wickr_arena_end(arena));
+        SHOULD_BE_FALSE(wickr_arena_is_active());
+        SHOULD_BE_FALSE(wickr_arena_begin(NULL));
+        SHOULD_BE_FALSE(wickr_arena_end(NULL));
+        
+        wickr_arena_destroy(&arena);
+        SHOULD_BE_NULL(arena);
+    }
+    END_IT
+    
+    IT("should serve allocations from the arena while a scope is open")
+    {
+        wickr_arena_t *arena = wickr_arena_create(1024);
+        SHOULD_NOT_BE_NULL(arena);
+        SHOULD_EQUAL(wickr_arena_get_used(arena), 0);
+        
+        SHOULD_BE_TRUE(wickr_arena_begin(arena));
+        
+        uint8_t *first = wickr_alloc(10);
+        uint8_t *second = wickr_alloc_zero(100);
+        SHOULD_NOT_BE_NULL(first);
+        SHOULD_NOT_BE_NULL(second);
+        
+        /* Allocations are bumped from the same block and keep malloc alignment */
+        SHOULD_EQUAL((uintptr_t)first % 16, 0);
+        SHOULD_EQUAL((uintptr_t)second % 16, 0);
+        SHOULD_EQUAL(second - first, 16);
+        SHOULD_EQUAL(wickr_arena_get_used(arena), 16 + 112);
+        
+        uint8_t expected[100];
+        memset(expected, 0, sizeof(expected));
+        SHOULD_BE_TRUE(memcmp(second, expected, sizeof(expected)) == 0);
+        
+        /* Freeing arena memory is deferred to the end of the scope */
+        memset(first, 0xaa, 10);
+        wickr_free(first);
+        SHOULD_EQUAL(first[0], 0xaa);
+        
+        /* Allocations larger than a block still succeed */
+        uint8_t *large = wickr_alloc_zero(4096);
+        SHOULD_NOT_BE_NULL(large);
+        SHOULD_EQUAL(large[4095], 0);
+        wickr_free_zero(large, 4096);
+        
+        uint8_t *after_large = wickr_alloc(16);
+        SHOULD_EQUAL(after_large - first, 128);
+        
+        SHOULD_BE_TRUE(wickr_arena_end(arena));
+        SHOULD_EQUAL(wickr_arena_get_used(arena), 0);
+        
+        wickr_arena_destroy(&arena);
+    }
+    END_IT
+    
+    IT("should zero and reuse memory when a scope ends")
+    {
+        wickr_arena_t *arena = wickr_arena_create(256);
+        
+        SHOULD_BE_TRUE(wickr_arena_begin(arena));
+        uint8_t *buf = wickr_alloc(64);
+        memset(buf, 0x55, 64);
+        SHOULD_BE_TRUE(wickr_arena_end(arena));
+        
+        /* The first block is retained by the arena, so its contents can be inspected */
+        uint8_t expected[64];
+        memset(expected, 0, sizeof(expected));
+        SHOULD_BE_TRUE(memcmp(buf, expected, sizeof(expected)) == 0);
+        
+        SHOULD_BE_TRUE(wickr_arena_begin(arena));
+        SHOULD_BE_TRUE(wickr_alloc(64) == buf);
+        SHOULD_BE_TRUE(wickr_arena_end(arena));
+        
+        wickr_arena_destroy(&arena);
+    }
+    END_IT
+    
+    IT("should allocate normally while suspended")
+    {
+        wickr_arena_t *arena = wickr_arena_create(0);
+        SHOULD_BE_TRUE(wickr_arena_begin(arena));
+        
+        wickr_buffer_t *scratch = wickr_buffer_create((uint8_t *)"scratch", 7);
+        size_t used = wickr_arena_get_used(arena);
+        SHOULD_BE_TRUE(used > 0);
+        
+        wickr_arena_t *suspended = wickr_arena_suspend();
+        SHOULD_BE_TRUE(suspended == arena);
+        SHOULD_BE_FALSE(wickr_arena_is_active());
+        SHOULD_BE_NULL(wickr_arena_suspend());
+        
+        wickr_buffer_t *kept = wickr_buffer_copy(scratch);
+        SHOULD_EQUAL(wickr_arena_get_used(arena), used);
+        
+        /* Arena memory can still be released while suspended */
+        wickr_buffer_destroy(&scratch);
+        
+        wickr_arena_resume(suspended);
+        SHOULD_BE_TRUE(wickr_arena_is_active());
+        SHOULD_BE_TRUE(wickr_arena_end(arena));
+        
+        SHOULD_EQUAL(kept->length, 7);
+        SHOULD_BE_TRUE(memcmp(kept->bytes, "scratch", 7) == 0);
+        
+        wickr_buffer_destroy(&kept);
+        wickr_arena_destroy(&arena);
+    }
+    END_IT
+    
+    IT("should support nested scopes")
+    {
+        wickr_arena_t *outer = wickr_arena_create(0);
+        wickr_arena_t *inner = wickr_arena_create(0);
+        
+        SHOULD_BE_TRUE(wickr_arena_begin(outer));
+        void *outer_buf = wickr_alloc(32);
+        
+        SHOULD_BE_TRUE(wickr_arena_begin(inner));
+        void *inner_buf = wickr_alloc(32);
+        SHOULD_EQUAL(wickr_arena_get_used(inner), 32);
+        SHOULD_EQUAL(wickr_arena_get_used(outer), 32);
+        
+        /* Outer arena memory freed from an inner scope is still recognized */
+        wickr_free(outer_buf);
+        wickr_free(inner_buf);
+        
+        /* Scopes must be closed innermost first */
+        SHOULD_BE_FALSE(wickr_arena_end(outer));
+        SHOULD_BE_TRUE(wickr_arena_end(inner));
+        SHOULD_BE_TRUE(wickr_arena_is_active());
+        SHOULD_BE_TRUE(wickr_arena_end(outer));
+        SHOULD_BE_FALSE(wickr_arena_is_active());
+        
+        wickr_arena_destroy(&inner);
+        wickr_arena_destroy(&outer);
+    }
+    END_IT
+}
+END_DESCRIBE
+
+static wickr_buffer_t *__test_stream_key_proto_pack(size_t user_data_len)
+{
+    uint8_t cipher_key[32];
+    memset(cipher_key, 0x11, sizeof(cipher_key));
+    
+    uint8_t *user_data = malloc(user_data_len);
+    memset(user_data, 0x22, user_data_len);
+    
+    Wickr__Proto__StreamKey proto_key = WICKR__PROTO__STREAM_KEY__INIT;
+    proto_key.has_cipher_key = true;
+    proto_key.cipher_key.data = cipher_key;
+    proto_key.cipher_key.len = sizeof(cipher_key);
+    proto_key.has_packets_per_evo = true;
+    proto_key.packets_per_evo = 64;
+    proto_key.has_user_data = true;
+    proto_key.user_data.data = user_data;
+    proto_key.user_data.len = user_data_len;
+    
+    wickr_buffer_t *packed = wickr_buffer_create_empty(wickr__proto__stream_key__get_packed_size(&proto_key));
+    wickr__proto__stream_key__pack(&proto_key, packed->bytes);
+    free(user_data);
+    
+    return packed;
+}
+
+DESCRIBE(wickr_proto_arena, "proto_arena_priv.c: wickr_proto_arena")
+{
+    IT("should unpack a small message without allocating")
+    {
+        wickr_buffer_t *packed = __test_stream_key_proto_pack(64);
+        
+        wickr_instrumented_allocator_t *instrumented = wickr_instrumented_allocator_create(NULL);
+        wickr_allocator_t hooks = wickr_instrumented_allocator_get_hooks(instrumented);
+        SHOULD_BE_TRUE(wickr_set_allocator(&hooks));
+        
+        wickr_proto_arena_t proto_arena;
+        wickr_proto_arena_init(&proto_arena);
+        
+        Wickr__Proto__StreamKey *proto_key = wickr__proto__stream_key__unpack(&proto_arena.allocator, packed->length, packed->bytes);
+        SHOULD_NOT_BE_NULL(proto_key);
+        SHOULD_EQUAL(proto_key->packets_per_evo, 64);
+        SHOULD_EQUAL(proto_key->user_data.len, 64);
+        SHOULD_EQUAL(proto_key->user_data.data[63], 0x22);
+        
+        /* The message and its bytes fields live in the inline stack space */
+        SHOULD_BE_TRUE((uint8_t *)proto_key >= proto_arena.stack &&
+                       (uint8_t *)proto_key < proto_arena.stack + sizeof(proto_arena.stack));
+        SHOULD_EQUAL((uintptr_t)proto_key % 8, 0);
+        
+        wickr_memory_stats_t stats;
+        SHOULD_BE_TRUE(wickr_instrumented_allocator_get_stats(instrumented, WICKR_MEMORY_TAG_DEFAULT, &stats));
+        SHOULD_EQUAL(stats.total_allocations, 0);
+        
+        size_t used = proto_arena.stack_used;
+        wickr_proto_arena_release(&proto_arena);
+        SHOULD_EQUAL(proto_arena.stack_used, 0);
+        
+        uint8_t zero[sizeof(proto_arena.stack)] = { 0 };
+        SHOULD_BE_TRUE(memcmp(proto_arena.stack, zero, used) == 0);
+        
+        SHOULD_BE_TRUE(wickr_set_allocator(NULL));
+        wickr_instrumented_allocator_destroy(&instrumented);
+        wickr_buffer_destroy(&packed);
+    }
+    END_IT
+    
+    IT("should spill large messages into blocks that are released together")
+    {
+        wickr_buffer_t *packed = __test_stream_key_proto_pack(20000);
+        
+        wickr_instrumented_allocator_t *instrumented = wickr_instrumented_allocator_create(NULL);
+        wickr_allocator_t hooks = wickr_instrumented_allocator_get_hooks(instrumented);
+        SHOULD_BE_TRUE(wickr_set_allocator(&hooks));
+        
+        wickr_proto_arena_t proto_arena;
+        wickr_proto_arena_init(&proto_arena);
+        
+        for (int i = 0; i < 2; i++) {
+            Wickr__Proto__StreamKey *proto_key = wickr__proto__stream_key__unpack(&proto_arena.allocator, packed->length, packed->bytes);
+            SHOULD_NOT_BE_NULL(proto_key);
+            SHOULD_EQUAL(proto_key->user_data.len, 20000);
+            SHOULD_EQUAL(proto_key->user_data.data[19999], 0x22);
+            SHOULD_EQUAL(proto_key->cipher_key.data[0], 0x11);
+            
+            wickr_memory_stats_t stats;
+            wickr_instrumented_allocator_get_stats(instrumented, WICKR_MEMORY_TAG_DEFAULT, &stats);
+            SHOULD_BE_TRUE(stats.live_allocations > 0);
+            
+            wickr_proto_arena_release(&proto_arena);
+            
+            wickr_instrumented_allocator_get_stats(instrumented, WICKR_MEMORY_TAG_DEFAULT, &stats);
+            SHOULD_EQUAL(stats.live_allocations, 0);
+        }
+        
+        SHOULD_BE_TRUE(wickr_set_allocator(NULL));
+        wickr_instrumented_allocator_destroy(&instrumented);
+        wickr_buffer_destroy(&packed);
+    }
+    END_IT
+    
+    IT("should release the partial result of a failed unpack")
+    {
+        wickr_buffer_t *packed = __test_stream_key_proto_pack(20000);
+        
+        wickr_proto_arena_t proto_arena;
+        wickr_proto_arena_init(&proto_arena);
+        
+        SHOULD_BE_NULL(wickr__proto__stream_key__unpack(&proto_arena.allocator, packed->length - 1, packed->bytes));
+        wickr_proto_arena_release(&proto_arena);
+        SHOULD_BE_NULL(proto_arena.blocks);
+        
+        wickr_buffer_destroy(&packed);
+    }
+    END_IT
+}
+END_DESCRIBE
@@ -0,0 +1,10 @@
+#ifndef test_arena_h
+#define test_arena_h
+
+#include <stdio.h>
+#include "cspec.h"
+
+DEFINE_DESCRIPTION(wickr_arena)
+DEFINE_DESCRIPTION(wickr_proto_arena)
+
+#endif /* test_arena_h */
@@ -8,6 +8,7 @@
 
 #include "test_array.h"
 #include "array.h"
+#include "memory.h"
 #include <string.h>
 
 struct foo {
@@ -206,3 +207,186 @@ DESCRIBE(an_array_of_items, "an array of items")
     
 }
 END_DESCRIBE
+
+static int compare_foo(const void *a, const void *b)
+{
+    const foo_t *foo_a = a;
+    const foo_t *foo_b = b;
+    
+    return memcmp(foo_a->bar, foo_b->bar, 16);
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t value_a = *(const uint32_t *)a;
+    uint32_t value_b = *(const uint32_t *)b;
+    
+    return value_a < value_b ? -1 : value_a > value_b;
+}
+
+DESCRIBE(a_growable_array, "a wickr_array_t that grows")
+{
+    wickr_array_t *test_array = wickr_array_new(0, 0, (wickr_array_copy_func)copy_foo, (wickr_array_destroy_func)destroy_foo);
+    SHOULD_NOT_BE_NULL(test_array);
+    
+    IT("grows as items are pushed onto it")
+    {
+        for (int i = 0; i < 10; i++) {
+            foo_t *one_foo = create_foo(false, malloc(16));
+            memset(one_foo->bar, 10 - i, 16);
+            SHOULD_BE_TRUE(wickr_array_push(test_array, one_foo, false));
+        }
+        
+        SHOULD_EQUAL(wickr_array_get_item_count(test_array), 10);
+        SHOULD_BE_TRUE(wickr_array_get_capacity(test_array) >= 10);
+        
+        foo_t *last_foo = wickr_array_fetch_item(test_array, 9, false);
+        SHOULD_EQUAL(last_foo->bar[0], 1);
+    }
+    END_IT
+    
+    IT("can reserve space without changing the item count")
+    {
+        SHOULD_BE_TRUE(wickr_array_reserve(test_array, 100));
+        SHOULD_EQUAL(wickr_array_get_capacity(test_array), 100);
+        SHOULD_EQUAL(wickr_array_get_item_count(test_array), 10);
+        SHOULD_BE_NULL(wickr_array_fetch_item(test_array, 10, false));
+        
+        foo_t *first_foo = wickr_array_fetch_item(test_array, 0, false);
+        SHOULD_EQUAL(first_foo->bar[0], 10);
+    }
+    END_IT
+    
+    IT("can be sorted and searched")
+    {
+        SHOULD_BE_TRUE(wickr_array_sort(test_array, compare_foo));
+        
+        for (uint32_t i = 0; i < wickr_array_get_item_count(test_array); i++) {
+            foo_t *one_foo = wickr_array_fetch_item(test_array, i, false);
+            SHOULD_EQUAL(one_foo->bar[0], i + 1);
+        }
+        
+        char key_bar[16];
+        memset(key_bar, 7, sizeof(key_bar));
+        foo_t key = { false, key_bar };
+        
+        uint32_t index = 0;
+        SHOULD_BE_TRUE(wickr_array_search(test_array, &key, compare_foo, &index));
+        SHOULD_EQUAL(index, 6);
+        
+        memset(key_bar, 11, sizeof(key_bar));
+        SHOULD_BE_FALSE(wickr_array_search(test_array, &key, compare_foo, &index));
+    }
+    END_IT
+    
+    IT("can remove items while keeping the order of the rest")
+    {
+        SHOULD_BE_TRUE(wickr_array_remove(test_array, 0, true));
+        SHOULD_BE_FALSE(wickr_array_remove(test_array, 9, true));
+        SHOULD_EQUAL(wickr_array_get_item_count(test_array), 9);
+        
+        for (uint32_t i = 0; i < wickr_array_get_item_count(test_array); i++) {
+            foo_t *one_foo = wickr_array_fetch_item(test_array, i, false);
+            SHOULD_EQUAL(one_foo->bar[0], i + 2);
+        }
+    }
+    END_IT
+    
+    IT("can be deep copied after growing")
+    {
+        wickr_array_t *copy_array = wickr_array_copy(test_array, true);
+        SHOULD_NOT_BE_NULL(copy_array);
+        SHOULD_EQUAL(wickr_array_get_item_count(copy_array), 9);
+        
+        foo_t *copy_foo = wickr_array_fetch_item(copy_array, 8, false);
+        SHOULD_BE_TRUE(copy_foo->copy);
+        SHOULD_EQUAL(copy_foo->bar[0], 10);
+        
+        wickr_array_destroy(&copy_array, true);
+    }
+    END_IT
+    
+    wickr_array_destroy(&test_array, true);
+}
+END_DESCRIBE
+
+DESCRIBE(an_inline_array, "a wickr_array_t that stores items by value")
+{
+    IT("can't be created with a zero item size")
+    {
+        SHOULD_BE_NULL(wickr_array_new_inline(1, 0, 0));
+    }
+    END_IT
+    
+    wickr_array_t *test_array = wickr_array_new_inline(2, 0, sizeof(uint32_t));
+    SHOULD_NOT_BE_NULL(test_array);
+    
+    IT("starts with zeroed items")
+    {
+        uint32_t *item = wickr_array_fetch_item(test_array, 1, false);
+        SHOULD_NOT_BE_NULL(item);
+        SHOULD_EQUAL(*item, 0);
+    }
+    END_IT
+    
+    IT("stores copies of the items that are set and pushed")
+    {
+        uint32_t value = 42;
+        SHOULD_BE_TRUE(wickr_array_set_item(test_array, 0, &value, false));
+        
+        for (uint32_t i = 0; i < 100; i++) {
+            value = (i * 37) % 101;
+            SHOULD_BE_TRUE(wickr_array_push(test_array, &value, false));
+        }
+        
+        value = 0;
+        SHOULD_EQUAL(wickr_array_get_item_count(test_array), 102);
+        SHOULD_EQUAL(*(uint32_t *)wickr_array_fetch_item(test_array, 0, false), 42);
+        SHOULD_EQUAL(*(uint32_t *)wickr_array_fetch_item(test_array, 3, false), 37);
+        
+        /* Items are stored contiguously */
+        uint8_t *first = wickr_array_fetch_item(test_array, 0, false);
+        uint8_t *second = wickr_array_fetch_item(test_array, 1, false);
+        SHOULD_EQUAL(second - first, sizeof(uint32_t));
+        
+        uint32_t *item_copy = wickr_array_fetch_item(test_array, 0, true);
+        SHOULD_NOT_EQUAL(item_copy, first);
+        SHOULD_EQUAL(*item_copy, 42);
+        wickr_free(item_copy);
+    }
+    END_IT
+    
+    IT("can be sorted and searched")
+    {
+        SHOULD_BE_TRUE(wickr_array_sort(test_array, compare_u32));
+        
+        for (uint32_t i = 1; i < wickr_array_get_item_count(test_array); i++) {
+            uint32_t *previous = wickr_array_fetch_item(test_array, i - 1, false);
+            uint32_t *current = wickr_array_fetch_item(test_array, i, false);
+            SHOULD_BE_TRUE(*previous <= *current);
+        }
+        
+        uint32_t key = 42;
+        uint32_t index = 0;
+        SHOULD_BE_TRUE(wickr_array_search(test_array, &key, compare_u32, &index));
+        SHOULD_EQUAL(*(uint32_t *)wickr_array_fetch_item(test_array, index, false), 42);
+        
+        key = 1000;
+        SHOULD_BE_FALSE(wickr_array_search(test_array, &key, compare_u32, NULL));
+    }
+    END_IT
+    
+    IT("can be copied")
+    {
+        wickr_array_t *copy_array = wickr_array_copy(test_array, true);
+        SHOULD_NOT_BE_NULL(copy_array);
+        SHOULD_EQUAL(wickr_array_get_item_count(copy_array), wickr_array_get_item_count(test_array));
+        SHOULD_EQUAL(*(uint32_t *)wickr_array_fetch_item(copy_array, 101, false),
+                     *(uint32_t *)wickr_array_fetch_item(test_array, 101, false));
+        wickr_array_destroy(&copy_array, true);
+    }
+    END_IT
+    
+    wickr_array_destroy(&test_array, true);
+}
+END_DESCRIBE
@@ -7,5 +7,7 @@
 
 DEFINE_DESCRIPTION(a_zero_length_array)
 DEFINE_DESCRIPTION(an_array_of_items);
+DEFINE_DESCRIPTION(a_growable_array)
+DEFINE_DESCRIPTION(an_inline_array)
 
 #endif /* test_array_h */
@@ -1,6 +1,7 @@
 #include "cspec.h"
 #include "test_buffer.h"
 #include "buffer.h"
+#include "memory.h"
 #include <string.h>
 
 int opposite_compare_func(const volatile void *p1, const volatile void *p2, size_t len)
@@ -52,7 +53,7 @@ DESCRIBE(wickr_buffer_tests, "buffer.c")
         SHOULD_BE_NULL(wickr_buffer_create_empty_zero(SIZE_MAX));
         SHOULD_BE_NULL(wickr_buffer_create_empty_zero(MAX_BUFFER_SIZE + 1));
         SHOULD_BE_NULL(wickr_buffer_create_empty(0));
-
+    
         wickr_buffer_t *test_buffer = wickr_buffer_create_empty_zero(1024);
         SHOULD_EQUAL(test_buffer->length, 1024);
         SHOULD_NOT_BE_NULL(test_buffer->bytes);
@@ -199,3 +200,271 @@ DESCRIBE(wickr_buffer_tests, "buffer.c")
     
 }
 END_DESCRIBE
+
+DESCRIBE(wickr_buffer_shared, "buffer.c")
+{
+    const char *test_str = "wickrcrypto shared buffer";
+    
+    IT("should provide views into an existing buffer without copying")
+    {
+        wickr_buffer_t *source = wickr_buffer_create((uint8_t *)test_str, strlen(test_str));
+        wickr_buffer_t view;
+        
+        SHOULD_BE_FALSE(wickr_buffer_view(NULL, 0, 1, &view));
+        SHOULD_BE_FALSE(wickr_buffer_view(source, 0, 1, NULL));
+        SHOULD_BE_FALSE(wickr_buffer_view(source, 0, 0, &view));
+        SHOULD_BE_FALSE(wickr_buffer_view(source, source->length, 1, &view));
+        SHOULD_BE_FALSE(wickr_buffer_view(source, 1, source->length, &view));
+        
+        SHOULD_BE_TRUE(wickr_buffer_view(source, 12, 6, &view));
+        SHOULD_EQUAL(view.bytes, source->bytes + 12);
+        SHOULD_EQUAL(view.length, 6);
+        SHOULD_BE_TRUE(memcmp(view.bytes, "shared", 6) == 0);
+        
+        wickr_buffer_destroy(&source);
+    }
+    END_IT
+    
+    IT("should share storage between copies in constant time")
+    {
+        SHOULD_BE_NULL(wickr_buffer_create_shared(NULL, 1));
+        SHOULD_BE_NULL(wickr_buffer_create_shared((uint8_t *)test_str, 0));
+        SHOULD_BE_NULL(wickr_buffer_share(NULL));
+        
+        wickr_buffer_t *shared = wickr_buffer_create_shared((uint8_t *)test_str, strlen(test_str));
+        SHOULD_NOT_BE_NULL(shared);
+        SHOULD_BE_FALSE(wickr_buffer_is_shared(shared));
+        
+        wickr_buffer_t *reference = wickr_buffer_share(shared);
+        SHOULD_NOT_BE_NULL(reference);
+        SHOULD_NOT_EQUAL(reference, shared);
+        SHOULD_EQUAL(reference->bytes, shared->bytes);
+        SHOULD_BE_TRUE(wickr_buffer_is_shared(shared));
+        SHOULD_BE_TRUE(wickr_buffer_is_shared(reference));
+        
+        /* The storage outlives the buffer it was created with */
+        wickr_buffer_destroy(&shared);
+        SHOULD_BE_NULL(shared);
+        SHOULD_BE_FALSE(wickr_buffer_is_shared(reference));
+        SHOULD_EQUAL(reference->length, strlen(test_str));
+        SHOULD_BE_TRUE(memcmp(reference->bytes, test_str, strlen(test_str)) == 0);
+        
+        wickr_buffer_destroy_zero(&reference);
+        SHOULD_BE_NULL(reference);
+    }
+    END_IT
+    
+    IT("should share a section of existing storage")
+    {
+        wickr_buffer_t *shared = wickr_buffer_create_shared((uint8_t *)test_str, strlen(test_str));
+        
+        SHOULD_BE_NULL(wickr_buffer_share_section(shared, 0, 0));
+        SHOULD_BE_NULL(wickr_buffer_share_section(shared, shared->length, 1));
+        
+        wickr_buffer_t *section = wickr_buffer_share_section(shared, 12, 6);
+        SHOULD_EQUAL(section->bytes, shared->bytes + 12);
+        SHOULD_EQUAL(section->length, 6);
+        SHOULD_BE_TRUE(wickr_buffer_is_shared(shared));
+        
+        wickr_buffer_destroy(&shared);
+        SHOULD_BE_TRUE(memcmp(section->bytes, "shared", 6) == 0);
+        
+        wickr_buffer_destroy(&section);
+    }
+    END_IT
+    
+    IT("should copy buffers that are not shared into shared storage")
+    {
+        wickr_buffer_t *owned = wickr_buffer_create((uint8_t *)test_str, strlen(test_str));
+        wickr_buffer_t *shared = wickr_buffer_share(owned);
+        
+        SHOULD_NOT_BE_NULL(shared);
+        SHOULD_NOT_EQUAL(shared->bytes, owned->bytes);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(shared, owned, NULL));
+        
+        wickr_buffer_t *reference = wickr_buffer_share(shared);
+        SHOULD_EQUAL(reference->bytes, shared->bytes);
+        
+        wickr_buffer_destroy(&owned);
+        wickr_buffer_destroy(&shared);
+        wickr_buffer_destroy(&reference);
+    }
+    END_IT
+    
+    IT("should tell buffers apart after their bytes have been advanced")
+    {
+        /* An owned buffer whose bytes no longer follow its header is still copied, not mistaken for a shared one */
+        wickr_buffer_t *owned = wickr_buffer_create((uint8_t *)test_str, strlen(test_str));
+        owned->bytes += 4;
+        owned->length -= 4;
+        
+        wickr_buffer_t *shared = wickr_buffer_share(owned);
+        SHOULD_NOT_BE_NULL(shared);
+        SHOULD_NOT_EQUAL(shared->bytes, owned->bytes);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(shared, owned, NULL));
+        SHOULD_BE_FALSE(wickr_buffer_is_shared(owned));
+        
+        /* A shared buffer whose bytes were advanced still refers to its storage */
+        shared->bytes += 2;
+        shared->length -= 2;
+        
+        wickr_buffer_t *reference = wickr_buffer_share(shared);
+        SHOULD_EQUAL(reference->bytes, shared->bytes);
+        SHOULD_BE_TRUE(wickr_buffer_is_shared(shared));
+        
+        wickr_buffer_destroy_zero(&owned);
+        wickr_buffer_destroy(&shared);
+        wickr_buffer_destroy(&reference);
+    }
+    END_IT
+    
+    IT("should copy on write when a shared buffer is made unique")
+    {
+        SHOULD_BE_FALSE(wickr_buffer_make_unique(NULL));
+        
+        wickr_buffer_t *shared = wickr_buffer_create_shared((uint8_t *)test_str, strlen(test_str));
+        wickr_buffer_t *original = shared;
+        
+        /* A buffer with a single reference is already unique */
+        SHOULD_BE_TRUE(wickr_buffer_make_unique(&shared));
+        SHOULD_EQUAL(shared, original);
+        
+        wickr_buffer_t *reference = wickr_buffer_share(shared);
+        SHOULD_BE_TRUE(wickr_buffer_make_unique(&reference));
+        SHOULD_NOT_EQUAL(reference->bytes, shared->bytes);
+        SHOULD_BE_FALSE(wickr_buffer_is_shared(shared));
+        
+        SHOULD_BE_TRUE(wickr_buffer_modify_section(reference, (uint8_t *)"******", 12, 6));
+        SHOULD_BE_TRUE(memcmp(shared->bytes, test_str, strlen(test_str)) == 0);
+        SHOULD_BE_TRUE(memcmp(reference->bytes + 12, "******", 6) == 0);
+        
+        wickr_buffer_destroy(&shared);
+        wickr_buffer_destroy(&reference);
+    }
+    END_IT
+}
+END_DESCRIBE
+
+DESCRIBE(wickr_buffer_cache, "buffer.c: small buffer cache")
+{
+#ifndef WICKR_DISABLE_BUFFER_CACHE
+    IT("should recycle small buffers as zeroed buffers of the same size class")
+    {
+        wickr_buffer_cache_flush();
+        
+        wickr_buffer_cache_stats_t before;
+        SHOULD_BE_TRUE(wickr_buffer_cache_get_stats(&before));
+        
+        wickr_buffer_t *buffer = wickr_buffer_create_empty(32);
+        SHOULD_NOT_BE_NULL(buffer);
+        memset(buffer->bytes, 0xaa, buffer->length);
+        
+        const wickr_buffer_t *recycled_location = buffer;
+        wickr_buffer_destroy(&buffer);
+        
+        wickr_buffer_t *reused = wickr_buffer_create_empty(20);
+        SHOULD_EQUAL(reused, recycled_location);
+        SHOULD_EQUAL(reused->length, 20);
+        
+        uint8_t expected[20] = { 0 };
+        SHOULD_BE_TRUE(memcmp(reused->bytes, expected, sizeof(expected)) == 0);
+        
+        wickr_buffer_cache_stats_t after;
+        SHOULD_BE_TRUE(wickr_buffer_cache_get_stats(&after));
+        SHOULD_EQUAL(after.misses, before.misses + 1);
+        SHOULD_EQUAL(after.recycled, before.recycled + 1);
+        SHOULD_EQUAL(after.hits, before.hits + 1);
+        
+        wickr_buffer_destroy_zero(&reused);
+        wickr_buffer_cache_flush();
+    }
+    END_IT
+    
+    IT("should recycle a buffer by the size it was created with")
+    {
+        wickr_buffer_cache_flush();
+        
+        wickr_buffer_t *buffer = wickr_buffer_create_empty_zero(12);
+        const wickr_buffer_t *recycled_location = buffer;
+        
+        /* A larger length must not move the buffer into a size class its storage can't hold */
+        buffer->length = 100;
+        wickr_buffer_destroy(&buffer);
+        
+        wickr_buffer_t *large = wickr_buffer_create_empty(100);
+        SHOULD_NOT_EQUAL(large, recycled_location);
+        
+        wickr_buffer_t *small = wickr_buffer_create_empty(16);
+        SHOULD_EQUAL(small, recycled_location);
+        
+        wickr_buffer_destroy(&large);
+        wickr_buffer_destroy(&small);
+        wickr_buffer_cache_flush();
+    }
+    END_IT
+    
+    IT("should free buffers beyond the limit of a size class")
+    {
+        wickr_buffer_cache_flush();
+        
+        wickr_buffer_cache_stats_t before;
+        wickr_buffer_cache_get_stats(&before);
+        
+        wickr_buffer_t *buffers[40];
+        
+        for (int i = 0; i < 40; i++) {
+            buffers[i] = wickr_buffer_create_empty(64);
+        }
+        
+        for (int i = 0; i < 40; i++) {
+            wickr_buffer_destroy(&buffers[i]);
+        }
+        
+        wickr_buffer_cache_stats_t after;
+        wickr_buffer_cache_get_stats(&after);
+        SHOULD_EQUAL(after.misses - before.misses, 40);
+        SHOULD_EQUAL(after.recycled - before.recycled + after.evictions - before.evictions, 40);
+        SHOULD_BE_TRUE(after.evictions > before.evictions);
+        
+        wickr_buffer_cache_flush();
+    }
+    END_IT
+    
+    IT("should not cache large buffers or buffers from a custom allocator")
+    {
+        wickr_buffer_cache_stats_t before;
+        wickr_buffer_cache_get_stats(&before);
+        
+        wickr_buffer_t *large = wickr_buffer_create_empty(4096);
+        wickr_buffer_destroy(&large);
+        
+        wickr_instrumented_allocator_t *instrumented = wickr_instrumented_allocator_create(NULL);
+        wickr_allocator_t hooks = wickr_instrumented_allocator_get_hooks(instrumented);
+        SHOULD_BE_TRUE(wickr_set_allocator(&hooks));
+        
+        wickr_buffer_t *small = wickr_buffer_create_empty(32);
+        
+        wickr_memory_stats_t memory_stats;
+        SHOULD_BE_TRUE(wickr_instrumented_allocator_get_stats(instrumented, WICKR_MEMORY_TAG_DEFAULT, &memory_stats));
+        SHOULD_EQUAL(memory_stats.live_allocations, 1);
+        
+        wickr_buffer_destroy(&small);
+        SHOULD_BE_TRUE(wickr_set_allocator(NULL));
+        wickr_instrumented_allocator_destroy(&instrumented);
+        
+        wickr_buffer_cache_stats_t after;
+        wickr_buffer_cache_get_stats(&after);
+        SHOULD_EQUAL(after.hits, before.hits);
+        SHOULD_EQUAL(after.misses, before.misses);
+        SHOULD_EQUAL(after.recycled, before.recycled);
+    }
+    END_IT
+#endif
+    
+    IT("should provide counters for the calling thread")
+    {
+        SHOULD_BE_FALSE(wickr_buffer_cache_get_stats(NULL));
+    }
+    END_IT
+}
+END_DESCRIBE
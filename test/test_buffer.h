@@ -6,5 +6,7 @@
 #include "cspec.h"
 
 DEFINE_DESCRIPTION(wickr_buffer_tests)
+DEFINE_DESCRIPTION(wickr_buffer_shared)
+DEFINE_DESCRIPTION(wickr_buffer_cache)
 
 #endif /* test_buffer_h */
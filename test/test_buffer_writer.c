@@ -0,0 +1,134 @@
+#include "cspec.h"
+#include "test_buffer_writer.h"
+#include "buffer_writer.h"
+#include <string.h>
+
+DESCRIBE(wickr_buffer_writer, "buffer_writer.c: wickr_buffer_writer")
+{
+    const char *test_str = "wickrcrypto";
+    wickr_buffer_t test_buffer = { strlen(test_str), (uint8_t *)test_str };
+    
+    IT("should build a buffer out of appended pieces")
+    {
+        wickr_buffer_writer_t writer;
+        SHOULD_BE_TRUE(wickr_buffer_writer_init(&writer, 0));
+        
+        SHOULD_BE_TRUE(wickr_buffer_writer_append_u8(&writer, 0xAB));
+        SHOULD_BE_TRUE(wickr_buffer_writer_append_buffer(&writer, &test_buffer));
+        SHOULD_BE_TRUE(wickr_buffer_writer_append_u64le(&writer, 0x0102030405060708));
+        SHOULD_BE_TRUE(wickr_buffer_writer_append(&writer, (uint8_t *)test_str, 5));
+        
+        wickr_buffer_t *result = wickr_buffer_writer_finish(&writer);
+        SHOULD_NOT_BE_NULL(result);
+        SHOULD_EQUAL(result->length, 1 + strlen(test_str) + 8 + 5);
+        
+        const uint8_t expected_u64[] = { 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01 };
+        
+        SHOULD_EQUAL(result->bytes[0], 0xAB);
+        SHOULD_BE_TRUE(memcmp(result->bytes + 1, test_str, strlen(test_str)) == 0);
+        SHOULD_BE_TRUE(memcmp(result->bytes + 1 + strlen(test_str), expected_u64, sizeof(expected_u64)) == 0);
+        SHOULD_BE_TRUE(memcmp(result->bytes + 1 + strlen(test_str) + 8, "wickr", 5) == 0);
+        
+        wickr_buffer_destroy(&result);
+    }
+    END_IT
+    
+    IT("should grow past its reserved capacity")
+    {
+        wickr_buffer_writer_t writer;
+        SHOULD_BE_TRUE(wickr_buffer_writer_init(&writer, 4));
+        
+        for (int i = 0; i < 1000; i++) {
+            SHOULD_BE_TRUE(wickr_buffer_writer_append_u8(&writer, (uint8_t)i));
+        }
+        
+        wickr_buffer_t *result = wickr_buffer_writer_finish(&writer);
+        SHOULD_NOT_BE_NULL(result);
+        SHOULD_EQUAL(result->length, 1000);
+        
+        for (int i = 0; i < 1000; i++) {
+            SHOULD_EQUAL(result->bytes[i], (uint8_t)i);
+        }
+        
+        wickr_buffer_destroy(&result);
+    }
+    END_IT
+    
+    IT("should fail every later append once an append fails")
+    {
+        wickr_buffer_writer_t writer;
+        SHOULD_BE_TRUE(wickr_buffer_writer_init(&writer, 0));
+        
+        SHOULD_BE_TRUE(wickr_buffer_writer_append_buffer(&writer, &test_buffer));
+        SHOULD_BE_FALSE(wickr_buffer_writer_append_buffer(&writer, NULL));
+        SHOULD_BE_FALSE(wickr_buffer_writer_append_buffer(&writer, &test_buffer));
+        SHOULD_BE_FALSE(wickr_buffer_writer_reserve(&writer, 1));
+        SHOULD_BE_NULL(wickr_buffer_writer_finish(&writer));
+        
+        /* Nothing appended is not a valid buffer */
+        SHOULD_BE_TRUE(wickr_buffer_writer_init(&writer, 16));
+        SHOULD_BE_NULL(wickr_buffer_writer_finish(&writer));
+        
+        SHOULD_BE_FALSE(wickr_buffer_writer_init(&writer, SIZE_MAX));
+        SHOULD_BE_FALSE(wickr_buffer_writer_append_u8(&writer, 0));
+        SHOULD_BE_NULL(wickr_buffer_writer_finish(&writer));
+    }
+    END_IT
+    
+    IT("should write into a caller provided buffer without growing it")
+    {
+        wickr_buffer_t *destination = wickr_buffer_create_empty_zero(strlen(test_str) + 1);
+        
+        wickr_buffer_writer_t writer;
+        wickr_buffer_writer_init_fixed(&writer, destination);
+        
+        SHOULD_BE_TRUE(wickr_buffer_writer_append_u8(&writer, 1));
+        SHOULD_BE_TRUE(wickr_buffer_writer_append_buffer(&writer, &test_buffer));
+        SHOULD_BE_NULL(wickr_buffer_writer_finish(&writer));
+        SHOULD_EQUAL(wickr_buffer_writer_finish_fixed(&writer), destination->length);
+        
+        SHOULD_EQUAL(destination->bytes[0], 1);
+        SHOULD_BE_TRUE(memcmp(destination->bytes + 1, test_str, strlen(test_str)) == 0);
+        
+        /* The destination is full */
+        wickr_buffer_writer_init_fixed(&writer, destination);
+        SHOULD_BE_TRUE(wickr_buffer_writer_append_buffer(&writer, &test_buffer));
+        SHOULD_BE_FALSE(wickr_buffer_writer_append_u64le(&writer, 0));
+        SHOULD_EQUAL(wickr_buffer_writer_finish_fixed(&writer), 0);
+        
+        wickr_buffer_writer_release(&writer);
+        SHOULD_EQUAL(destination->length, strlen(test_str) + 1);
+        
+        wickr_buffer_destroy(&destination);
+    }
+    END_IT
+    
+    IT("should append base 128 varints")
+    {
+        uint64_t values[] = { 0, 127, 128, 300, UINT64_MAX };
+        size_t sizes[] = { 1, 1, 2, 2, 10 };
+        
+        wickr_buffer_writer_t writer;
+        wickr_buffer_writer_init(&writer, 0);
+        
+        size_t total_size = 0;
+        
+        for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+            SHOULD_EQUAL(wickr_buffer_writer_varint_size(values[i]), sizes[i]);
+            SHOULD_BE_TRUE(wickr_buffer_writer_append_varint(&writer, values[i]));
+            total_size += sizes[i];
+        }
+        
+        wickr_buffer_t *result = wickr_buffer_writer_finish(&writer);
+        SHOULD_NOT_BE_NULL(result);
+        SHOULD_EQUAL(result->length, total_size);
+        
+        uint8_t expected_start[] = { 0x00, 0x7F, 0x80, 0x01, 0xAC, 0x02, 0xFF };
+        SHOULD_BE_TRUE(memcmp(result->bytes, expected_start, sizeof(expected_start)) == 0);
+        SHOULD_EQUAL(result->bytes[result->length - 1], 0x01);
+        
+        wickr_buffer_destroy(&result);
+    }
+    END_IT
+}
+END_DESCRIBE
@@ -0,0 +1,9 @@
+#ifndef test_buffer_writer_h
+#define test_buffer_writer_h
+
+#include <stdio.h>
+#include "cspec.h"
+
+DEFINE_DESCRIPTION(wickr_buffer_writer)
+
+#endif /* test_buffer_writer_h */
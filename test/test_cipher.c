@@ -107,6 +107,73 @@ DESCRIBE(cipher_result, "cipher: cipher_result")
         wickr_cipher_result_destroy(&cipher_result);
     }
     END_IT
+    
+    IT( "wickr_cipher_result_serialize_compact omits the cipher id and can be restored with a known cipher" )
+    {
+        wickr_buffer_t *iv = openssl_crypto_random(CIPHER_AES256_GCM.iv_len);
+        wickr_buffer_t *auth_tag = openssl_crypto_random(CIPHER_AES256_GCM.auth_tag_len);
+        wickr_buffer_t *cipher_text = openssl_crypto_random(40);
+        wickr_cipher_result_t *cipher_result = wickr_cipher_result_create(CIPHER_AES256_GCM, iv, cipher_text, auth_tag);
+        
+        wickr_buffer_t *serialized = wickr_cipher_result_serialize(cipher_result);
+        wickr_buffer_t *compact = wickr_cipher_result_serialize_compact(cipher_result);
+        SHOULD_NOT_BE_NULL(compact);
+        SHOULD_EQUAL(compact->length, serialized->length - sizeof(uint8_t));
+        SHOULD_EQUAL(memcmp(compact->bytes, serialized->bytes + sizeof(uint8_t), compact->length), 0);
+        
+        wickr_cipher_result_t *restored = wickr_cipher_result_from_compact_buffer(compact, CIPHER_AES256_GCM);
+        SHOULD_NOT_BE_NULL(restored);
+        SHOULD_EQUAL(restored->cipher.cipher_id, CIPHER_ID_AES256_GCM);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(restored->iv, iv, NULL));
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(restored->auth_tag, auth_tag, NULL));
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(restored->cipher_text, cipher_text, NULL));
+        
+        /* A buffer too short to hold the iv and tag of the cipher is rejected */
+        wickr_buffer_t short_buffer = { CIPHER_AES256_GCM.iv_len, compact->bytes };
+        SHOULD_BE_NULL(wickr_cipher_result_from_compact_buffer(&short_buffer, CIPHER_AES256_GCM));
+        SHOULD_BE_NULL(wickr_cipher_result_from_compact_buffer(NULL, CIPHER_AES256_GCM));
+        SHOULD_BE_NULL(wickr_cipher_result_serialize_compact(NULL));
+        
+        wickr_cipher_result_destroy(&restored);
+        wickr_buffer_destroy(&compact);
+        wickr_buffer_destroy(&serialized);
+        wickr_cipher_result_destroy(&cipher_result);
+    }
+    END_IT
+    
+    IT( "wickr_cipher_result_serialize_into writes the same bytes as wickr_cipher_result_serialize" )
+    {
+        wickr_buffer_t *iv = openssl_crypto_random(CIPHER_AES256_GCM.iv_len);
+        wickr_buffer_t *auth_tag = openssl_crypto_random(CIPHER_AES256_GCM.auth_tag_len);
+        wickr_buffer_t *cipher_text = openssl_crypto_random(40);
+        wickr_cipher_result_t *cipher_result = wickr_cipher_result_create(CIPHER_AES256_GCM, iv, cipher_text, auth_tag);
+        
+        wickr_buffer_t *serialized = wickr_cipher_result_serialize(cipher_result);
+        SHOULD_EQUAL(wickr_cipher_result_serialized_size(cipher_result), serialized->length);
+        SHOULD_EQUAL(wickr_cipher_result_serialized_size(NULL), 0);
+        
+        /* Serialize behind a prefix, as when filling a field of a larger structure */
+        wickr_buffer_t *destination = wickr_buffer_create_empty_zero(serialized->length + 1);
+        wickr_buffer_writer_t writer;
+        wickr_buffer_writer_init_fixed(&writer, destination);
+        wickr_buffer_writer_append_u8(&writer, 0xFF);
+        
+        SHOULD_BE_TRUE(wickr_cipher_result_serialize_into(cipher_result, &writer));
+        SHOULD_EQUAL(wickr_buffer_writer_finish_fixed(&writer), destination->length);
+        SHOULD_EQUAL(memcmp(destination->bytes + 1, serialized->bytes, serialized->length), 0);
+        
+        /* Running out of room fails the write */
+        wickr_buffer_writer_init_fixed(&writer, destination);
+        wickr_buffer_writer_append_u8(&writer, 0xFF);
+        wickr_buffer_writer_append_u8(&writer, 0xFF);
+        SHOULD_BE_FALSE(wickr_cipher_result_serialize_into(cipher_result, &writer));
+        SHOULD_BE_FALSE(wickr_cipher_result_serialize_into(NULL, &writer));
+        
+        wickr_buffer_destroy(&destination);
+        wickr_buffer_destroy(&serialized);
+        wickr_cipher_result_destroy(&cipher_result);
+    }
+    END_IT
 
 }
 END_DESCRIBE
@@ -3,7 +3,9 @@
 #include "externs.h"
 #include "crypto_engine.h"
 #include "wickr_ctx.h"
+#include "wickr_ctx_async.h"
 #include "encoder_result.h"
+#include "arena.h"
 
 #include <string.h>
 
@@ -17,7 +19,7 @@
 DESCRIBE(wickr_ctx_generate, "wickr_ctx: test generation")
 {
     initTest();
-
+    
     wickr_ctx_gen_result_t *result;
     
     char *systemName = "SYSTEM_NAME_FOR_CONTEXT_TEST";
@@ -31,7 +33,7 @@ DESCRIBE(wickr_ctx_generate, "wickr_ctx: test generation")
         SHOULD_NOT_BE_NULL(result = wickr_ctx_gen_new(engine, devInfo, rand_id))
     }
     END_IT
-
+    
     IT("should be able to make a copy of itself")
     {
         wickr_ctx_gen_result_t *copyResult;
@@ -58,7 +60,7 @@ DESCRIBE(wickr_ctx_generate, "wickr_ctx: test generation")
         SHOULD_BE_TRUE(wickr_buffer_is_equal(root_key_result->root_keys->node_storage_root->key_data, keys->node_storage_root->key_data, NULL));
         SHOULD_BE_TRUE(wickr_buffer_is_equal(root_key_result->root_keys->remote_storage_root->key_data, keys->remote_storage_root->key_data, NULL));
         SHOULD_BE_TRUE(wickr_buffer_is_equal(root_key_result->root_keys->node_signature_root->pri_data, keys->node_signature_root->pri_data, NULL));
-
+    
         wickr_ctx_gen_result_destroy(&root_key_result);
         wickr_root_keys_destroy(&keys);
         
@@ -77,7 +79,7 @@ DESCRIBE(wickr_ctx_generate, "wickr_ctx: test generation")
         
         SHOULD_BE_TRUE(wickr_buffer_is_equal(sig_key_result->root_keys->node_signature_root->pri_data, sig_key->pri_data, NULL));
         SHOULD_BE_TRUE(wickr_buffer_is_equal(sig_key_result->root_keys->node_signature_root->pub_data, sig_key->pub_data, NULL));
-
+    
         wickr_ctx_gen_result_destroy(&sig_key_result);
         wickr_ec_key_destroy(&sig_key);
     }
@@ -257,7 +259,7 @@ DESCRIBE(wickr_ctx_functions, "wickr_ctx: general functions")
     
     wickr_ctx_gen_result_t *ctx_res = NULL;
     SHOULD_NOT_BE_NULL(ctx_res = wickr_ctx_gen_new(engine, devInfo, rand_id))
-
+    
     wickr_ctx_t *ctx = ctx_res->ctx;
     
     IT("can be serialized and deserialized")
@@ -294,6 +296,29 @@ DESCRIBE(wickr_ctx_functions, "wickr_ctx: general functions")
     }
     END_IT
     
+    IT("can be exported and imported with a specific kdf")
+    {
+        wickr_buffer_t *test_passphrase = engine.wickr_crypto_engine_crypto_random(32);
+        
+        SHOULD_BE_NULL(wickr_ctx_export_with_kdf(ctx, KDF_BCRYPT_15, test_passphrase));
+        
+        wickr_buffer_t *serialized = wickr_ctx_export_with_kdf(ctx, KDF_ARGON2ID_2_16, test_passphrase);
+        SHOULD_NOT_BE_NULL(serialized);
+        SHOULD_EQUAL(serialized->bytes[0], KDF_ID_ARGON2ID_16);
+        
+        wickr_ctx_t *deserialized = wickr_ctx_import(engine,
+                                                     wickr_dev_info_copy(devInfo),
+                                                     serialized,
+                                                     test_passphrase);
+        
+        wickr_ctx_verify_equal(ctx, deserialized);
+        
+        wickr_buffer_destroy(&serialized);
+        wickr_ctx_destroy(&deserialized);
+        wickr_buffer_destroy(&test_passphrase);
+    }
+    END_IT
+    
     IT("should be able to export storage keys with a passphrase")
     {
         wickr_buffer_t *rand_pass = engine.wickr_crypto_engine_crypto_random(IDENTIFIER_LEN);
@@ -315,6 +340,25 @@ DESCRIBE(wickr_ctx_functions, "wickr_ctx: general functions")
     }
     END_IT
     
+    IT("should be able to export storage keys with a specific kdf")
+    {
+        wickr_buffer_t *rand_pass = engine.wickr_crypto_engine_crypto_random(IDENTIFIER_LEN);
+        
+        wickr_buffer_t *exported = wickr_ctx_export_storage_keys_with_kdf(ctx, KDF_ARGON2ID_2_16, rand_pass);
+        SHOULD_NOT_BE_NULL(exported);
+        
+        wickr_storage_keys_t *imported = wickr_ctx_import_storage_keys(engine, exported, rand_pass);
+        
+        SHOULD_NOT_BE_NULL(imported);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(imported->local->key_data, ctx->storage_keys->local->key_data, NULL));
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(imported->remote->key_data, ctx->storage_keys->remote->key_data, NULL));
+        
+        wickr_buffer_destroy(&rand_pass);
+        wickr_buffer_destroy(&exported);
+        wickr_storage_keys_destroy(&imported);
+    }
+    END_IT
+    
     IT("should be able to encrypt local data with random IVs")
     {
         __test_cipher_method(ctx, 10000, 1000, wickr_ctx_cipher_local, wickr_ctx_decipher_local);
@@ -424,7 +468,7 @@ DESCRIBE(wickr_ctx_send_pkt, "wickr_ctx: test sending packet")
     char *nameUser1 = "alice@wickr.com";
     char *nameDev1User1 = "alice:DEVICE1";
     wickr_buffer_t *devBufUser1 = wickr_buffer_create((uint8_t *)nameDev1User1, strlen(nameDev1User1));
-
+    
     wickr_node_t *nodeUser1 = createUserNode(nameUser1, devBufUser1);
     wickr_ctx_t *ctxUser1 = createContext(nodeUser1);
     
@@ -454,7 +498,7 @@ DESCRIBE(wickr_ctx_send_pkt, "wickr_ctx: test sending packet")
     char *body = "Hello World!";
     wickr_buffer_t *bodyData = wickr_buffer_create((uint8_t*)body, strlen(body));
     wickr_payload_t *payload = wickr_payload_create(metaData, bodyData);
-
+    
     wickr_encoder_result_t *encodePkt = NULL;
     
     IT("should encode packets")
@@ -552,7 +596,7 @@ DESCRIBE(wickr_ctx_send_pkt, "wickr_ctx: test sending packet")
         wickr_buffer_destroy(&packet_buffer);
     }
     END_IT
-
+    
     IT("should parse packets for decoding")
     {
         __test_packet_decode(ctxUser1, ctxUser2, nodeUser2, encodePkt, bodyData, channelTag, contentType, ephemeralData);
@@ -571,6 +615,49 @@ DESCRIBE(wickr_ctx_send_pkt, "wickr_ctx: test sending packet")
     }
     END_IT
     
+    IT("should return packets that outlive an arena scope")
+    {
+        ctxUser1->pkt_enc_version = CURRENT_PACKET_VERSION;
+        
+        wickr_arena_t *arena = wickr_arena_create(0);
+        SHOULD_NOT_BE_NULL(arena);
+        SHOULD_BE_TRUE(wickr_arena_begin(arena));
+        
+        SHOULD_NOT_BE_NULL(encodePkt = wickr_ctx_encode_packet(ctxUser1, payload, recipients));
+        SHOULD_BE_TRUE(wickr_arena_get_used(arena) > 0);
+        
+        /* Buffers the caller wants to keep are allocated with the arena suspended */
+        wickr_arena_t *suspended = wickr_arena_suspend();
+        SHOULD_BE_TRUE(suspended == arena);
+        wickr_buffer_t *packet_buffer = wickr_packet_serialize(encodePkt->packet);
+        wickr_arena_resume(suspended);
+        
+        wickr_ctx_packet_t *inPacket = wickr_ctx_parse_packet(ctxUser2, packet_buffer, ctxUser1->id_chain);
+        SHOULD_NOT_BE_NULL(inPacket);
+        
+        wickr_decode_result_t *decodeResult = wickr_ctx_decode_packet(ctxUser2, inPacket, nodeUser2->ephemeral_keypair->ec_key);
+        SHOULD_NOT_BE_NULL(decodeResult);
+        
+        SHOULD_BE_TRUE(wickr_arena_end(arena));
+        
+        /* Everything returned by the ctx functions must still be intact once the arena has been zeroed */
+        SHOULD_EQUAL(decodeResult->err, E_SUCCESS);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(bodyData, decodeResult->decrypted_payload->body, NULL));
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(channelTag, decodeResult->decrypted_payload->meta->channel_tag, NULL));
+        SHOULD_EQUAL(inPacket->parse_result->signature_status, PACKET_SIGNATURE_VALID);
+        
+        wickr_buffer_t *reserialized = wickr_packet_serialize(encodePkt->packet);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(packet_buffer, reserialized, NULL));
+        
+        wickr_buffer_destroy(&reserialized);
+        wickr_decode_result_destroy(&decodeResult);
+        wickr_ctx_packet_destroy(&inPacket);
+        wickr_buffer_destroy(&packet_buffer);
+        wickr_encoder_result_destroy(&encodePkt);
+        wickr_arena_destroy(&arena);
+    }
+    END_IT
+    
     wickr_node_array_destroy(&recipients);
     wickr_node_destroy(&nodeUser1);
     wickr_node_destroy(&nodeUser2);
@@ -580,3 +667,275 @@ DESCRIBE(wickr_ctx_send_pkt, "wickr_ctx: test sending packet")
 
 }
 END_DESCRIBE
+
+typedef struct {
+    int call_count;
+    wickr_async_status status;
+    void *result;
+} test_async_completion_t;
+
+static void __test_async_buffer_complete(wickr_async_status status, wickr_buffer_t *result, void *user)
+{
+    test_async_completion_t *completion = user;
+    completion->call_count++;
+    completion->status = status;
+    completion->result = result;
+}
+
+static void __test_async_ctx_complete(wickr_async_status status, wickr_ctx_t *result, void *user)
+{
+    test_async_completion_t *completion = user;
+    completion->call_count++;
+    completion->status = status;
+    completion->result = result;
+}
+
+static void __test_async_gen_complete(wickr_async_status status, wickr_ctx_gen_result_t *result, void *user)
+{
+    test_async_completion_t *completion = user;
+    completion->call_count++;
+    completion->status = status;
+    completion->result = result;
+}
+
+/* An executor that holds on to submitted work so tests can control when it runs */
+typedef struct {
+    wickr_async_work_func func;
+    void *work;
+    bool should_accept;
+} test_async_executor_t;
+
+static bool __test_async_executor_submit(wickr_async_work_func func, void *work, void *user)
+{
+    test_async_executor_t *executor = user;
+    
+    if (!executor->should_accept) {
+        return false;
+    }
+    
+    executor->func = func;
+    executor->work = work;
+    
+    return true;
+}
+
+DESCRIBE(wickr_ctx_async, "wickr_ctx: asynchronous operations")
+{
+    initTest();
+    
+    char *systemName = "SYSTEM_NAME_FOR_CONTEXT_TEST";
+    wickr_buffer_t *devBuf = wickr_buffer_create((uint8_t *)systemName, strlen(systemName));
+    wickr_dev_info_t *devInfo = createDevInfo(devBuf);
+    
+    wickr_buffer_t *rand_id = engine.wickr_crypto_engine_crypto_random(IDENTIFIER_LEN);
+    wickr_buffer_t *passphrase = engine.wickr_crypto_engine_crypto_random(32);
+    
+    wickr_ctx_gen_result_t *ctx_res = NULL;
+    SHOULD_NOT_BE_NULL(ctx_res = wickr_ctx_gen_new(engine, devInfo, rand_id))
+    
+    wickr_ctx_t *ctx = ctx_res->ctx;
+    
+    IT("should fail to start with invalid inputs")
+    {
+        SHOULD_BE_NULL(wickr_ctx_export_async(NULL, passphrase, NULL, NULL, NULL));
+        SHOULD_BE_NULL(wickr_ctx_export_async(ctx, NULL, NULL, NULL, NULL));
+        SHOULD_BE_NULL(wickr_ctx_export_storage_keys_async(NULL, passphrase, NULL, NULL, NULL));
+        SHOULD_BE_NULL(wickr_ctx_import_async(engine, NULL, passphrase, passphrase, NULL, NULL, NULL));
+        SHOULD_BE_NULL(wickr_ctx_import_async(engine, devInfo, NULL, passphrase, NULL, NULL, NULL));
+        SHOULD_BE_NULL(wickr_ctx_import_async(engine, devInfo, passphrase, NULL, NULL, NULL, NULL));
+        SHOULD_BE_NULL(wickr_ctx_gen_with_passphrase_async(engine, devInfo, NULL, passphrase, passphrase, rand_id, NULL, NULL, NULL));
+        SHOULD_EQUAL(wickr_async_op_wait(NULL), ASYNC_STATUS_FAILED);
+        SHOULD_BE_FALSE(wickr_async_op_cancel(NULL));
+    }
+    END_IT
+    
+    wickr_buffer_t *exported = NULL;
+    
+    IT("can export on the internal worker thread with a completion callback")
+    {
+        test_async_completion_t completion = { 0 };
+        
+        wickr_async_op_t *op = wickr_ctx_export_async(ctx, passphrase, NULL, __test_async_buffer_complete, &completion);
+        SHOULD_NOT_BE_NULL(op);
+        
+        SHOULD_EQUAL(wickr_async_op_wait(op), ASYNC_STATUS_SUCCESS);
+        SHOULD_EQUAL(wickr_async_op_get_status(op), ASYNC_STATUS_SUCCESS);
+        SHOULD_EQUAL(completion.call_count, 1);
+        SHOULD_EQUAL(completion.status, ASYNC_STATUS_SUCCESS);
+        SHOULD_NOT_BE_NULL(completion.result);
+        
+        /* Results delivered to a callback are not held by the operation */
+        SHOULD_BE_NULL(wickr_async_op_take_buffer(op));
+        SHOULD_BE_FALSE(wickr_async_op_cancel(op));
+        
+        exported = completion.result;
+        
+        wickr_ctx_t *imported = wickr_ctx_import(engine, wickr_dev_info_copy(devInfo), exported, passphrase);
+        wickr_ctx_verify_equal(ctx, imported);
+        
+        wickr_ctx_destroy(&imported);
+        wickr_async_op_destroy(&op);
+        SHOULD_BE_NULL(op);
+    }
+    END_IT
+    
+    IT("can import and hold the result until it is taken")
+    {
+        wickr_async_op_t *op = wickr_ctx_import_async(engine, devInfo, exported, passphrase, NULL, NULL, NULL);
+        SHOULD_NOT_BE_NULL(op);
+        
+        SHOULD_EQUAL(wickr_async_op_wait(op), ASYNC_STATUS_SUCCESS);
+        SHOULD_BE_NULL(wickr_async_op_take_buffer(op));
+        SHOULD_BE_NULL(wickr_async_op_take_gen_result(op));
+        
+        wickr_ctx_t *imported = wickr_async_op_take_ctx(op);
+        wickr_ctx_verify_equal(ctx, imported);
+        SHOULD_BE_NULL(wickr_async_op_take_ctx(op));
+        
+        wickr_ctx_destroy(&imported);
+        wickr_async_op_destroy(&op);
+    }
+    END_IT
+    
+    IT("should report a failure to import with the wrong passphrase")
+    {
+        test_async_completion_t completion = { 0 };
+        wickr_buffer_t *wrong_passphrase = engine.wickr_crypto_engine_crypto_random(32);
+        
+        wickr_async_op_t *op = wickr_ctx_import_async(engine, devInfo, exported, wrong_passphrase, NULL,
+                                                      __test_async_ctx_complete, &completion);
+        SHOULD_NOT_BE_NULL(op);
+        
+        SHOULD_EQUAL(wickr_async_op_wait(op), ASYNC_STATUS_FAILED);
+        SHOULD_EQUAL(completion.call_count, 1);
+        SHOULD_EQUAL(completion.status, ASYNC_STATUS_FAILED);
+        SHOULD_BE_NULL(completion.result);
+        
+        wickr_buffer_destroy(&wrong_passphrase);
+        wickr_async_op_destroy(&op);
+    }
+    END_IT
+    
+    IT("can export storage keys")
+    {
+        wickr_async_op_t *op = wickr_ctx_export_storage_keys_async(ctx, passphrase, NULL, NULL, NULL);
+        SHOULD_NOT_BE_NULL(op);
+        
+        SHOULD_EQUAL(wickr_async_op_wait(op), ASYNC_STATUS_SUCCESS);
+        
+        wickr_buffer_t *exported_keys = wickr_async_op_take_buffer(op);
+        SHOULD_NOT_BE_NULL(exported_keys);
+        
+        wickr_storage_keys_t *imported = wickr_ctx_import_storage_keys(engine, exported_keys, passphrase);
+        SHOULD_NOT_BE_NULL(imported);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(imported->local->key_data, ctx->storage_keys->local->key_data, NULL));
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(imported->remote->key_data, ctx->storage_keys->remote->key_data, NULL));
+        
+        wickr_storage_keys_destroy(&imported);
+        wickr_buffer_destroy(&exported_keys);
+        wickr_async_op_destroy(&op);
+    }
+    END_IT
+    
+    IT("can generate with a passphrase")
+    {
+        test_async_completion_t completion = { 0 };
+        wickr_buffer_t *recovery = wickr_ctx_gen_result_make_recovery(ctx_res);
+        wickr_buffer_t *exported_recovery_key = wickr_ctx_gen_export_recovery_key_passphrase(ctx_res, passphrase);
+        
+        wickr_async_op_t *op = wickr_ctx_gen_with_passphrase_async(engine, devInfo, exported_recovery_key, passphrase,
+                                                                   recovery, rand_id, NULL,
+                                                                   __test_async_gen_complete, &completion);
+        SHOULD_NOT_BE_NULL(op);
+        
+        SHOULD_EQUAL(wickr_async_op_wait(op), ASYNC_STATUS_SUCCESS);
+        SHOULD_EQUAL(completion.call_count, 1);
+        
+        wickr_ctx_gen_result_t *gen_result = completion.result;
+        SHOULD_NOT_BE_NULL(gen_result);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(gen_result->root_keys->node_signature_root->pri_data,
+                                             ctx_res->root_keys->node_signature_root->pri_data, NULL));
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(gen_result->recovery_key->key_data,
+                                             ctx_res->recovery_key->key_data, NULL));
+        
+        wickr_ctx_gen_result_destroy(&gen_result);
+        wickr_buffer_destroy(&recovery);
+        wickr_buffer_destroy(&exported_recovery_key);
+        wickr_async_op_destroy(&op);
+    }
+    END_IT
+    
+    IT("can run on a caller supplied executor")
+    {
+        test_async_executor_t test_executor = { .should_accept = false };
+        wickr_async_executor_t executor = { .submit = __test_async_executor_submit, .user = &test_executor };
+        test_async_completion_t completion = { 0 };
+        
+        /* A rejected submission never calls back */
+        SHOULD_BE_NULL(wickr_ctx_export_async(ctx, passphrase, &executor, __test_async_buffer_complete, &completion));
+        SHOULD_EQUAL(completion.call_count, 0);
+        
+        test_executor.should_accept = true;
+        
+        wickr_async_op_t *op = wickr_ctx_export_async(ctx, passphrase, &executor, __test_async_buffer_complete, &completion);
+        SHOULD_NOT_BE_NULL(op);
+        SHOULD_EQUAL(wickr_async_op_get_status(op), ASYNC_STATUS_PENDING);
+        SHOULD_EQUAL(completion.call_count, 0);
+        
+        test_executor.func(test_executor.work);
+        
+        SHOULD_EQUAL(wickr_async_op_wait(op), ASYNC_STATUS_SUCCESS);
+        SHOULD_EQUAL(completion.call_count, 1);
+        SHOULD_NOT_BE_NULL(completion.result);
+        
+        wickr_buffer_t *result = completion.result;
+        wickr_buffer_destroy(&result);
+        wickr_async_op_destroy(&op);
+    }
+    END_IT
+    
+    IT("can be cancelled before it runs")
+    {
+        test_async_executor_t test_executor = { .should_accept = true };
+        wickr_async_executor_t executor = { .submit = __test_async_executor_submit, .user = &test_executor };
+        test_async_completion_t completion = { 0 };
+        
+        wickr_async_op_t *op = wickr_ctx_import_async(engine, devInfo, exported, passphrase, &executor,
+                                                      __test_async_ctx_complete, &completion);
+        SHOULD_NOT_BE_NULL(op);
+        
+        SHOULD_BE_TRUE(wickr_async_op_cancel(op));
+        
+        /* The caller may release its handle before the executor gets to the work */
+        wickr_async_op_destroy(&op);
+        
+        test_executor.func(test_executor.work);
+        
+        SHOULD_EQUAL(completion.call_count, 1);
+        SHOULD_EQUAL(completion.status, ASYNC_STATUS_CANCELLED);
+        SHOULD_BE_NULL(completion.result);
+    }
+    END_IT
+    
+    IT("should not deliver a result once it has been cancelled")
+    {
+        wickr_async_op_t *op = wickr_ctx_export_async(ctx, passphrase, NULL, NULL, NULL);
+        SHOULD_NOT_BE_NULL(op);
+        
+        SHOULD_BE_TRUE(wickr_async_op_cancel(op));
+        SHOULD_EQUAL(wickr_async_op_wait(op), ASYNC_STATUS_CANCELLED);
+        SHOULD_BE_NULL(wickr_async_op_take_buffer(op));
+        SHOULD_BE_FALSE(wickr_async_op_cancel(op));
+        
+        wickr_async_op_destroy(&op);
+    }
+    END_IT
+    
+    wickr_buffer_destroy(&exported);
+    wickr_buffer_destroy(&passphrase);
+    wickr_buffer_destroy(&rand_id);
+    wickr_dev_info_destroy(&devInfo);
+    wickr_buffer_destroy(&devBuf);
+    wickr_ctx_gen_result_destroy(&ctx_res);
+}
+END_DESCRIBE
@@ -8,5 +8,6 @@
 DEFINE_DESCRIPTION(wickr_ctx_generate)
 DEFINE_DESCRIPTION(wickr_ctx_send_pkt)
 DEFINE_DESCRIPTION(wickr_ctx_functions);
+DEFINE_DESCRIPTION(wickr_ctx_async)
 
 #endif /* test_context_h */
@@ -89,7 +89,23 @@ DESCRIBE(identity, "identity tests")
         SHOULD_BE_TRUE(wickr_buffer_is_equal(copy->signature->sig_data, test_identity->signature->sig_data, NULL));
         SHOULD_EQUAL(copy->type, test_identity->type);
         
+        /* Once the immutable fields are in shared storage further copies reference them instead of copying */
+        wickr_identity_t *second_copy = wickr_identity_copy(copy);
+        SHOULD_NOT_BE_NULL(second_copy);
+        SHOULD_EQUAL(second_copy->identifier->bytes, copy->identifier->bytes);
+        SHOULD_EQUAL(second_copy->sig_key->pub_data->bytes, copy->sig_key->pub_data->bytes);
+        SHOULD_EQUAL(second_copy->signature->sig_data->bytes, copy->signature->sig_data->bytes);
+        
+        /* Shared bytes are made unique before they are written to, so the write can't reach the other copies */
+        SHOULD_BE_TRUE(wickr_buffer_make_unique(&second_copy->identifier));
+        SHOULD_NOT_EQUAL(second_copy->identifier->bytes, copy->identifier->bytes);
+        second_copy->identifier->bytes[0] ^= 0xff;
+        SHOULD_BE_FALSE(wickr_buffer_is_equal(second_copy->identifier, copy->identifier, NULL));
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(copy->identifier, test_identity->identifier, NULL));
+        
         wickr_identity_destroy(&copy);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(second_copy->signature->sig_data, test_identity->signature->sig_data, NULL));
+        wickr_identity_destroy(&second_copy);
     }
     END_IT
     
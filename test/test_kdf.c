@@ -1,6 +1,7 @@
 
 #include "test_kdf.h"
 #include "kdf.h"
+#include "private/kdf_priv.h"
 #include <string.h>
 #include <stdio.h>
 #include "util.h"
@@ -149,7 +150,7 @@ DESCRIBE(wickr_perform_kdf, "kdf.c: wickr_perform_kdf, wickr_perform_kdf_meta")
 {
     char *test_bcrypt_salt = "qqM9HeaGheyCy99QtDm0kO";
     
-    kdf_test_vector_t test_vectors[8] =
+    kdf_test_vector_t test_vectors[13] =
     {
         { KDF_SCRYPT_2_17,
             "KDF_SCRIPT_2_17",
@@ -179,6 +180,41 @@ DESCRIBE(wickr_perform_kdf, "kdf.c: wickr_perform_kdf, wickr_perform_kdf_meta")
             hex_char_to_buffer("70617373776f7264"),
             hex_char_to_buffer("f77171051a2b7bd32a377cb81c83a40d2ee1965e9a77978ec29cd06196707097")
         },
+        { KDF_SCRYPT_2_17_P4,
+            "KDF_SCRIPT_2_17_P4",
+            hex_char_to_buffer("31323334353637383930616263646566"),
+            NULL,
+            hex_char_to_buffer("70617373776f7264"),
+            hex_char_to_buffer("e39fc52674b9b1ca1da5eef17a4358a3798a947190420a84afa026f1820962fc")
+        },
+        { KDF_SCRYPT_2_18_P4,
+            "KDF_SCRIPT_2_18_P4",
+            hex_char_to_buffer("31323334353637383930616263646566"),
+            NULL,
+            hex_char_to_buffer("70617373776f7264"),
+            hex_char_to_buffer("d46309ab0e55c9121c49f2c8da7c3848ee7d8c61c22be7738eb044db376aee38")
+        },
+        { KDF_ARGON2ID_2_16,
+            "KDF_ARGON2ID_2_16",
+            hex_char_to_buffer("31323334353637383930616263646566"),
+            NULL,
+            hex_char_to_buffer("70617373776f7264"),
+            hex_char_to_buffer("3d36f5fa274ab9fff682925890ba19141ee0d436531ba727cda39cd3881b0eed")
+        },
+        { KDF_ARGON2ID_2_18,
+            "KDF_ARGON2ID_2_18",
+            hex_char_to_buffer("31323334353637383930616263646566"),
+            NULL,
+            hex_char_to_buffer("70617373776f7264"),
+            hex_char_to_buffer("73a0647aa3d54b23cafff346b95445e0cc528944bf132a556f55562a16a60b28")
+        },
+        { KDF_ARGON2ID_2_20,
+            "KDF_ARGON2ID_2_20",
+            hex_char_to_buffer("31323334353637383930616263646566"),
+            NULL,
+            hex_char_to_buffer("70617373776f7264"),
+            hex_char_to_buffer("e061c28273be1814ae82a6b9b46ff7ffc005057652c905b6faad2184a34a4ef2")
+        },
         { KDF_BCRYPT_15,
             "KDF_BCRYPT_15",
             wickr_buffer_create((uint8_t *)test_bcrypt_salt, strlen(test_bcrypt_salt)) ,
@@ -210,7 +246,7 @@ DESCRIBE(wickr_perform_kdf, "kdf.c: wickr_perform_kdf, wickr_perform_kdf_meta")
     };
     
     
-    for (int i = 0; i < 8; i++) {
+    for (int i = 0; i < 13; i++) {
         
         char it_statement[1024];
         sprintf( it_statement, "should calculare proper hashes given specific known metadata: %s", test_vectors[i].algo_name );
@@ -321,10 +357,153 @@ DESCRIBE(wickr_perform_kdf, "kdf.c: wickr_perform_kdf, wickr_perform_kdf_meta")
 }
 END_DESCRIBE
 
+DESCRIBE(wickr_scrypt_parallel, "kdf_scrypt.c: wickr_scrypt_parallel")
+{
+    IT("should match the RFC 7914 test vectors")
+    {
+        wickr_buffer_t empty = { 0, NULL };
+        wickr_buffer_t *expected = hex_char_to_buffer("77d6576238657b203b19ca42c18a0497f16b4844e3074ae8dfdffa3fede21442fcd0069ded0948f8326a753a0fc81f17e8d3e0fb2e0d3628cf35e20c38d18906");
+        wickr_buffer_t *hash = wickr_scrypt_parallel(&empty, &empty, 16, 1, 1, 0, 64);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(hash, expected, NULL));
+        wickr_buffer_destroy(&hash);
+        wickr_buffer_destroy(&expected);
+        
+        wickr_buffer_t *passphrase = wickr_buffer_create((uint8_t *)"pleaseletmein", 13);
+        wickr_buffer_t *salt = wickr_buffer_create((uint8_t *)"SodiumChloride", 14);
+        expected = hex_char_to_buffer("7023bdcb3afd7348461c06cd81fd38ebfda8fbba904f8e3ea9b543f6545da1f2d5432955613f0fcf62d49705242a9af9e61e85dc0d651e40dfcf017b45575887");
+        hash = wickr_scrypt_parallel(passphrase, salt, 16384, 8, 1, 0, 64);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(hash, expected, NULL));
+        
+        wickr_buffer_destroy(&hash);
+        wickr_buffer_destroy(&expected);
+        wickr_buffer_destroy(&passphrase);
+        wickr_buffer_destroy(&salt);
+    }
+    END_IT
+    
+    IT("should produce the same output regardless of how many threads compute the lanes")
+    {
+        wickr_buffer_t *passphrase = wickr_buffer_create((uint8_t *)"password", 8);
+        wickr_buffer_t *salt = wickr_buffer_create((uint8_t *)"NaCl", 4);
+        wickr_buffer_t *expected = hex_char_to_buffer("fdbabe1c9d3472007856e7190d01e9fe7c6ad7cbc8237830e77376634b3731622eaf30d92e22a3886ff109279d9830dac727afb94a83ee6d8360cbdfa2cc0640");
+        
+        uint32_t thread_counts[] = { 0, 1, 3, 16, SCRYPT_PARALLEL_MAX_THREADS + 1 };
+        
+        for (int i = 0; i < sizeof(thread_counts) / sizeof(uint32_t); i++) {
+            wickr_buffer_t *hash = wickr_scrypt_parallel(passphrase, salt, 1024, 8, 16, thread_counts[i], 64);
+            SHOULD_BE_TRUE(wickr_buffer_is_equal(hash, expected, NULL));
+            wickr_buffer_destroy(&hash);
+        }
+        
+        wickr_buffer_destroy(&expected);
+        wickr_buffer_destroy(&passphrase);
+        wickr_buffer_destroy(&salt);
+    }
+    END_IT
+    
+    IT("should fail with invalid parameters")
+    {
+        SHOULD_BE_NULL(wickr_scrypt_parallel(NULL, &one_byte_buffer, 16, 1, 1, 0, 32));
+        SHOULD_BE_NULL(wickr_scrypt_parallel(&one_byte_buffer, NULL, 16, 1, 1, 0, 32));
+        SHOULD_BE_NULL(wickr_scrypt_parallel(&one_byte_buffer, &one_byte_buffer, 1, 1, 1, 0, 32));
+        SHOULD_BE_NULL(wickr_scrypt_parallel(&one_byte_buffer, &one_byte_buffer, 24, 1, 1, 0, 32));
+        SHOULD_BE_NULL(wickr_scrypt_parallel(&one_byte_buffer, &one_byte_buffer, 16, 0, 1, 0, 32));
+        SHOULD_BE_NULL(wickr_scrypt_parallel(&one_byte_buffer, &one_byte_buffer, 16, 1, 0, 0, 32));
+        SHOULD_BE_NULL(wickr_scrypt_parallel(&one_byte_buffer, &one_byte_buffer, 16, 1, 1, 0, 0));
+    }
+    END_IT
+}
+END_DESCRIBE
+
+DESCRIBE(wickr_argon2id, "kdf_argon2.c: wickr_argon2id")
+{
+    IT("should match the reference implementation")
+    {
+        wickr_buffer_t *passphrase = wickr_buffer_create((uint8_t *)"password", 8);
+        wickr_buffer_t *salt = wickr_buffer_create((uint8_t *)"somesalt", 8);
+        
+        /* Output longer than one BLAKE2b digest exercises the variable length hash */
+        wickr_buffer_t *expected = hex_char_to_buffer("a3dfe94d62f4d7a751361173214dfd875d84586b6919f6300e516ad41865d38625bdde3f34a46ba693bbfb6a29dae538a394f414aa62d7193d334949ac6c01410ea4cace0aa082b51861d2bd185ea16ef74e39500c4af127e87ba8f639463bed52fe0252");
+        wickr_buffer_t *hash = wickr_argon2id(passphrase, salt, 32, 3, 1, 0, 100);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(hash, expected, NULL));
+        
+        wickr_buffer_destroy(&hash);
+        wickr_buffer_destroy(&expected);
+        wickr_buffer_destroy(&passphrase);
+        wickr_buffer_destroy(&salt);
+    }
+    END_IT
+    
+    IT("should produce the same output regardless of how many threads fill the lanes")
+    {
+        wickr_buffer_t *passphrase = wickr_buffer_create((uint8_t *)"password", 8);
+        wickr_buffer_t *salt = wickr_buffer_create((uint8_t *)"somesalt", 8);
+        wickr_buffer_t *expected = hex_char_to_buffer("a292d6bf594dbd17778c812b5bb16dea794640e1e1e0a5aeb4f27d8425e328eff3c776b98e9c20668a9662502d2d98f9221378015a3100d2ae2956a26298c2f8");
+        
+        uint32_t thread_counts[] = { 0, 1, 3, 16, ARGON2_PARALLEL_MAX_THREADS + 1 };
+        
+        for (int i = 0; i < sizeof(thread_counts) / sizeof(uint32_t); i++) {
+            wickr_buffer_t *hash = wickr_argon2id(passphrase, salt, 128, 2, 16, thread_counts[i], 64);
+            SHOULD_BE_TRUE(wickr_buffer_is_equal(hash, expected, NULL));
+            wickr_buffer_destroy(&hash);
+        }
+        
+        wickr_buffer_destroy(&expected);
+        wickr_buffer_destroy(&passphrase);
+        wickr_buffer_destroy(&salt);
+    }
+    END_IT
+    
+    IT("should fail with invalid parameters")
+    {
+        wickr_buffer_t *salt = wickr_buffer_create((uint8_t *)"somesalt", 8);
+        
+        SHOULD_BE_NULL(wickr_argon2id(NULL, salt, 32, 1, 1, 0, 32));
+        SHOULD_BE_NULL(wickr_argon2id(&one_byte_buffer, NULL, 32, 1, 1, 0, 32));
+        SHOULD_BE_NULL(wickr_argon2id(&one_byte_buffer, &one_byte_buffer, 32, 1, 1, 0, 32));
+        SHOULD_BE_NULL(wickr_argon2id(&one_byte_buffer, salt, 31, 1, 4, 0, 32));
+        SHOULD_BE_NULL(wickr_argon2id(&one_byte_buffer, salt, 32, 0, 1, 0, 32));
+        SHOULD_BE_NULL(wickr_argon2id(&one_byte_buffer, salt, 32, 1, 0, 0, 32));
+        SHOULD_BE_NULL(wickr_argon2id(&one_byte_buffer, salt, 32, 1, 1, 0, 3));
+        
+        wickr_buffer_destroy(&salt);
+    }
+    END_IT
+}
+END_DESCRIBE
+
+DESCRIBE(wickr_kdf_calibrate, "kdf.c: wickr_kdf_calibrate")
+{
+    IT("should fail if no mode fits in the memory budget")
+    {
+        SHOULD_BE_NULL(wickr_kdf_calibrate(UINT32_MAX, 32 * 1024 * 1024));
+    }
+    END_IT
+    
+    IT("should fail if no mode meets the latency target")
+    {
+        SHOULD_BE_NULL(wickr_kdf_calibrate(0, 128 * 1024 * 1024));
+    }
+    END_IT
+    
+    IT("should choose the strongest mode that fits in the memory budget")
+    {
+        const wickr_kdf_algo_t *algo = wickr_kdf_calibrate(UINT32_MAX, 64 * 1024 * 1024);
+        SHOULD_NOT_BE_NULL(algo);
+        SHOULD_EQUAL(algo->kdf_id, KDF_ID_ARGON2ID_16);
+        
+        algo = wickr_kdf_calibrate(UINT32_MAX, 128 * 1024 * 1024);
+        SHOULD_NOT_BE_NULL(algo);
+        SHOULD_EQUAL(algo->kdf_id, KDF_ID_SCRYPT_17);
+    }
+    END_IT
+}
+END_DESCRIBE
+
 DESCRIBE(wickr_crypto_engine_kdf, "wickr_crypto_engine.c : wickr_crypto_engine_kdf_cipher / decipher")
 {
     
-    wickr_kdf_algo_t kdf_algos_to_test[4] = { KDF_SCRYPT_2_17, KDF_SCRYPT_2_18, KDF_SCRYPT_2_19, KDF_SCRYPT_2_20 };
+    wickr_kdf_algo_t kdf_algos_to_test[5] = { KDF_SCRYPT_2_17, KDF_SCRYPT_2_18, KDF_SCRYPT_2_19, KDF_SCRYPT_2_20, KDF_ARGON2ID_2_16 };
     wickr_cipher_t ciphers_to_test[1] = { CIPHER_AES256_GCM };
     
     const wickr_crypto_engine_t default_engine = wickr_crypto_engine_get_default();
@@ -364,7 +543,7 @@ DESCRIBE(wickr_crypto_engine_kdf, "wickr_crypto_engine.c : wickr_crypto_engine_k
     }
     END_IT
     
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < 5; i++) {
         
         for (int j = 0; j < 1; j++) {
             
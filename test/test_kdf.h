@@ -8,6 +8,9 @@
 DEFINE_DESCRIPTION(wickr_kdf_meta);
 DEFINE_DESCRIPTION(wickr_kdf_result);
 DEFINE_DESCRIPTION(wickr_perform_kdf);
+DEFINE_DESCRIPTION(wickr_scrypt_parallel);
+DEFINE_DESCRIPTION(wickr_argon2id);
+DEFINE_DESCRIPTION(wickr_kdf_calibrate);
 DEFINE_DESCRIPTION(wickr_crypto_engine_kdf);
 
 #endif /* test_kdf_h */
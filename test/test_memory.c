@@ -0,0 +1,216 @@
+#include "cspec.h"
+#include "test_memory.h"
+#include "memory.h"
+#include "buffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int alloc_count;
+    int free_count;
+} counting_allocator_t;
+
+static void *counting_alloc(size_t len, void *user)
+{
+    counting_allocator_t *counter = user;
+    counter->alloc_count++;
+    
+    /* Fill new memory so the zeroing fallback can be observed */
+    void *buf = malloc(len);
+    memset(buf, 0xaa, len);
+    
+    return buf;
+}
+
+static void counting_free(void *buf, void *user)
+{
+    counting_allocator_t *counter = user;
+    counter->free_count++;
+    free(buf);
+}
+
+DESCRIBE(wickr_allocator, "memory.c: wickr_set_allocator")
+{
+    IT("should reject allocators that are missing required functions")
+    {
+        wickr_allocator_t allocator = { NULL, NULL, counting_free, NULL };
+        SHOULD_BE_FALSE(wickr_set_allocator(&allocator));
+        
+        allocator.alloc = counting_alloc;
+        allocator.free = NULL;
+        SHOULD_BE_FALSE(wickr_set_allocator(&allocator));
+        
+        SHOULD_BE_TRUE(wickr_get_allocator().alloc != counting_alloc);
+    }
+    END_IT
+    
+    IT("should route library allocations through a custom allocator")
+    {
+        counting_allocator_t counter = { 0, 0 };
+        wickr_allocator_t allocator = { counting_alloc, NULL, counting_free, &counter };
+        
+        SHOULD_BE_TRUE(wickr_set_allocator(&allocator));
+        SHOULD_BE_TRUE(wickr_get_allocator().user == &counter);
+        
+        uint8_t *zeroed = wickr_alloc_zero(64);
+        SHOULD_NOT_BE_NULL(zeroed);
+        
+        uint8_t expected[64];
+        memset(expected, 0, sizeof(expected));
+        SHOULD_BE_TRUE(memcmp(zeroed, expected, sizeof(expected)) == 0);
+        wickr_free_zero(zeroed, 64);
+        
+        wickr_buffer_t *buffer = wickr_buffer_create_empty(32);
+        SHOULD_NOT_BE_NULL(buffer);
+        wickr_buffer_destroy(&buffer);
+        
+        SHOULD_BE_TRUE(wickr_set_allocator(NULL));
+        
+        SHOULD_BE_TRUE(counter.alloc_count > 1);
+        SHOULD_EQUAL(counter.alloc_count, counter.free_count);
+        
+        /* The system allocator is back in use */
+        void *after = wickr_alloc(16);
+        wickr_free(after);
+        SHOULD_EQUAL(counter.alloc_count, counter.free_count);
+    }
+    END_IT
+}
+END_DESCRIBE
+
+DESCRIBE(wickr_instrumented_allocator, "memory.c: wickr_instrumented_allocator")
+{
+    IT("should not be created with an invalid backing allocator")
+    {
+        wickr_allocator_t allocator = { NULL, NULL, NULL, NULL };
+        SHOULD_BE_NULL(wickr_instrumented_allocator_create(&allocator));
+    }
+    END_IT
+    
+    IT("should track live and peak usage per tag")
+    {
+        wickr_instrumented_allocator_t *instrumented = wickr_instrumented_allocator_create(NULL);
+        SHOULD_NOT_BE_NULL(instrumented);
+        
+        wickr_allocator_t hooks = wickr_instrumented_allocator_get_hooks(instrumented);
+        SHOULD_BE_TRUE(wickr_set_allocator(&hooks));
+        
+        uint32_t previous_tag = wickr_memory_tag_set(3);
+        SHOULD_EQUAL(wickr_memory_tag_get(), 3);
+        
+        void *first = wickr_alloc(100);
+        void *second = wickr_alloc_zero(50);
+        wickr_free(first);
+        
+        /* Out of range tags are accounted under the default tag */
+        wickr_memory_tag_set(WICKR_MEMORY_TAG_COUNT);
+        void *untagged = wickr_alloc(10);
+        
+        wickr_memory_tag_set(previous_tag);
+        
+        wickr_memory_stats_t stats;
+        SHOULD_BE_TRUE(wickr_instrumented_allocator_get_stats(instrumented, 3, &stats));
+        SHOULD_EQUAL(stats.live_bytes, 50);
+        SHOULD_EQUAL(stats.live_allocations, 1);
+        SHOULD_EQUAL(stats.peak_bytes, 150);
+        SHOULD_EQUAL(stats.peak_allocations, 2);
+        SHOULD_EQUAL(stats.total_allocations, 2);
+        
+        SHOULD_BE_TRUE(wickr_instrumented_allocator_get_stats(instrumented, WICKR_MEMORY_TAG_DEFAULT, &stats));
+        SHOULD_EQUAL(stats.live_bytes, 10);
+        SHOULD_EQUAL(stats.live_allocations, 1);
+        
+        SHOULD_BE_FALSE(wickr_instrumented_allocator_get_stats(instrumented, WICKR_MEMORY_TAG_COUNT, &stats));
+        
+        /* Frees are accounted to the tag of the allocation, not the current tag of the thread */
+        wickr_free(second);
+        wickr_free(untagged);
+        
+        wickr_instrumented_allocator_reset_peaks(instrumented);
+        
+        SHOULD_BE_TRUE(wickr_instrumented_allocator_get_stats(instrumented, 3, &stats));
+        SHOULD_EQUAL(stats.live_bytes, 0);
+        SHOULD_EQUAL(stats.peak_bytes, 0);
+        SHOULD_EQUAL(stats.peak_allocations, 0);
+        SHOULD_EQUAL(stats.total_allocations, 2);
+        
+        SHOULD_BE_TRUE(wickr_set_allocator(NULL));
+        wickr_instrumented_allocator_destroy(&instrumented);
+        SHOULD_BE_NULL(instrumented);
+    }
+    END_IT
+    
+    IT("should allocate through its backing allocator")
+    {
+        counting_allocator_t counter = { 0, 0 };
+        wickr_allocator_t backing = { counting_alloc, NULL, counting_free, &counter };
+        
+        wickr_instrumented_allocator_t *instrumented = wickr_instrumented_allocator_create(&backing);
+        SHOULD_NOT_BE_NULL(instrumented);
+        
+        wickr_allocator_t hooks = wickr_instrumented_allocator_get_hooks(instrumented);
+        SHOULD_BE_TRUE(wickr_set_allocator(&hooks));
+        
+        wickr_buffer_t *buffer = wickr_buffer_create_empty_zero(128);
+        SHOULD_NOT_BE_NULL(buffer);
+        
+        uint8_t expected[128];
+        memset(expected, 0, sizeof(expected));
+        SHOULD_BE_TRUE(memcmp(buffer->bytes, expected, sizeof(expected)) == 0);
+        
+        wickr_memory_stats_t stats;
+        SHOULD_BE_TRUE(wickr_instrumented_allocator_get_stats(instrumented, WICKR_MEMORY_TAG_DEFAULT, &stats));
+        SHOULD_BE_TRUE(stats.live_bytes >= 128);
+        
+        wickr_buffer_destroy(&buffer);
+        
+        SHOULD_BE_TRUE(wickr_instrumented_allocator_get_stats(instrumented, WICKR_MEMORY_TAG_DEFAULT, &stats));
+        SHOULD_EQUAL(stats.live_bytes, 0);
+        SHOULD_EQUAL(stats.live_allocations, 0);
+        
+        SHOULD_BE_TRUE(wickr_set_allocator(NULL));
+        wickr_instrumented_allocator_destroy(&instrumented);
+        
+        /* The instrumented allocator itself is allocated by its backing allocator */
+        SHOULD_EQUAL(counter.alloc_count, counter.free_count);
+    }
+    END_IT
+}
+END_DESCRIBE
+
+DESCRIBE(wickr_secure_zero, "memory.c: wickr_secure_zero")
+{
+    IT("should zero every byte of unaligned ranges")
+    {
+        uint8_t buf[96];
+        uint8_t expected[96];
+        memset(expected, 0, sizeof(expected));
+        
+        /* Cover combinations of unaligned heads and partial word tails */
+        for (size_t start = 0; start < 9; start++) {
+            for (size_t len = 1; len < 80; len += 7) {
+                memset(buf, 0xaa, sizeof(buf));
+                wickr_secure_zero(buf + start, len);
+                
+                SHOULD_BE_TRUE(memcmp(buf + start, expected, len) == 0);
+                
+                for (size_t i = 0; i < start; i++) {
+                    SHOULD_EQUAL(buf[i], 0xaa);
+                }
+                
+                SHOULD_EQUAL(buf[start + len], 0xaa);
+            }
+        }
+    }
+    END_IT
+    
+    IT("should ignore empty input")
+    {
+        uint8_t value = 0xaa;
+        wickr_secure_zero(NULL, 16);
+        wickr_secure_zero(&value, 0);
+        SHOULD_EQUAL(value, 0xaa);
+    }
+    END_IT
+}
+END_DESCRIBE
@@ -0,0 +1,11 @@
+#ifndef test_memory_h
+#define test_memory_h
+
+#include <stdio.h>
+#include "cspec.h"
+
+DEFINE_DESCRIPTION(wickr_allocator)
+DEFINE_DESCRIPTION(wickr_instrumented_allocator)
+DEFINE_DESCRIPTION(wickr_secure_zero)
+
+#endif /* test_memory_h */
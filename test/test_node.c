@@ -211,6 +211,20 @@ DESCRIBE(node_tests, "node.c")
     }
     END_IT
     
+    IT("can be pushed onto a node array")
+    {
+        wickr_node_array_t *node_array = wickr_node_array_new(0);
+        SHOULD_NOT_BE_NULL(node_array);
+        
+        SHOULD_BE_TRUE(wickr_node_array_push(node_array, node));
+        SHOULD_BE_TRUE(wickr_node_array_push(node_array, node));
+        SHOULD_EQUAL(wickr_array_get_item_count(node_array), 2);
+        SHOULD_EQUAL(wickr_node_array_fetch_item(node_array, 1), node);
+        
+        wickr_node_array_destroy(&node_array);
+    }
+    END_IT
+    
     IT("can be seralized / deserialized")
     {
         wickr_buffer_t *serialized = wickr_node_serialize(node);
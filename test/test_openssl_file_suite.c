@@ -179,3 +179,851 @@ DESCRIBE(decodeCipherFile, "openssl_file_suite: decodeCipherFile")
     remove(testDecryptedFileName);
 }
 END_DESCRIBE
+
+static void writeTestFile(const char *path, const wickr_buffer_t *data)
+{
+    FILE *handle = fopen(path, "wb");
+    
+    if (data) {
+        fwrite(data->bytes, data->length, 1, handle);
+    }
+    
+    fclose(handle);
+}
+
+static wickr_buffer_t *readTestFile(const char *path)
+{
+    struct stat st;
+    
+    if (stat(path, &st) != 0 || st.st_size == 0) {
+        return NULL;
+    }
+    
+    wickr_buffer_t *data = wickr_buffer_create_empty_zero(st.st_size);
+    FILE *handle = fopen(path, "rb");
+    size_t count = fread(data->bytes, 1, data->length, handle);
+    fclose(handle);
+    
+    if (count != data->length) {
+        wickr_buffer_destroy(&data);
+    }
+    
+    return data;
+}
+
+static long fileSize(const char *path)
+{
+    struct stat st;
+    
+    if (stat(path, &st) != 0) {
+        return -1;
+    }
+    
+    return (long)st.st_size;
+}
+
+DESCRIBE(mappedFile, "openssl_file_suite: memory mapped files")
+{
+    char *testPlaintextFileName = "test_mapped.data";
+    char *testCipherFileName = "test_mapped.enc";
+    char *testDecryptedFileName = "decrypted_test_mapped.data";
+    
+    const wickr_crypto_engine_t engine = wickr_crypto_engine_get_default();
+    uint64_t defaultThreshold = openssl_aes256_file_get_mmap_threshold();
+    
+    IT( "has a default threshold" )
+    {
+        SHOULD_EQUAL(defaultThreshold, OPENSSL_FILE_MMAP_DEFAULT_THRESHOLD);
+    }
+    END_IT
+    
+    IT( "is compatible with the stdio implementation" )
+    {
+        wickr_cipher_t ciphers[] = { CIPHER_AES256_GCM, CIPHER_AES256_CTR };
+        size_t sizes[] = { 0, 1, 4096, 100000 };
+        
+        for (int c = 0; c < sizeof(ciphers) / sizeof(wickr_cipher_t); c++) {
+            wickr_cipher_key_t *cipherKey = engine.wickr_crypto_engine_cipher_key_random(ciphers[c]);
+            
+            for (int i = 0; i < sizeof(sizes) / sizeof(size_t); i++) {
+                wickr_buffer_t *testData = sizes[i] ? openssl_crypto_random(sizes[i]) : NULL;
+                writeTestFile(testPlaintextFileName, testData);
+                
+                /* Encrypt with one implementation and decrypt with the other */
+                for (int mapEncrypt = 0; mapEncrypt < 2; mapEncrypt++) {
+                    openssl_aes256_file_set_mmap_threshold(mapEncrypt ? 0 : UINT64_MAX);
+                    SHOULD_BE_TRUE(openssl_aes256_file_encrypt(cipherKey, testPlaintextFileName, testCipherFileName));
+                    SHOULD_EQUAL(fileSize(testCipherFileName),
+                                 (long)(sizes[i] + 1 + ciphers[c].iv_len + ciphers[c].auth_tag_len));
+                    
+                    openssl_aes256_file_set_mmap_threshold(mapEncrypt ? UINT64_MAX : 0);
+                    SHOULD_BE_TRUE(openssl_aes256_file_decrypt(cipherKey, testCipherFileName, testDecryptedFileName, false));
+                    
+                    wickr_buffer_t *decrypted = readTestFile(testDecryptedFileName);
+                    
+                    if (testData) {
+                        SHOULD_BE_TRUE(wickr_buffer_is_equal(decrypted, testData, NULL));
+                    }
+                    else {
+                        SHOULD_BE_NULL(decrypted);
+                    }
+                    
+                    wickr_buffer_destroy(&decrypted);
+                    remove(testDecryptedFileName);
+                }
+                
+                wickr_buffer_destroy(&testData);
+            }
+            
+            wickr_cipher_key_destroy(&cipherKey);
+        }
+    }
+    END_IT
+    
+    IT( "fails to decrypt modified files" )
+    {
+        openssl_aes256_file_set_mmap_threshold(0);
+        
+        wickr_cipher_key_t *cipherKey = engine.wickr_crypto_engine_cipher_key_random(CIPHER_AES256_GCM);
+        wickr_cipher_key_t *ctrKey = engine.wickr_crypto_engine_cipher_key_random(CIPHER_AES256_CTR);
+        wickr_buffer_t *testData = openssl_crypto_random(100000);
+        writeTestFile(testPlaintextFileName, testData);
+        
+        SHOULD_BE_TRUE(openssl_aes256_file_encrypt(cipherKey, testPlaintextFileName, testCipherFileName));
+        
+        wickr_buffer_t *encrypted = readTestFile(testCipherFileName);
+        encrypted->bytes[encrypted->length - 1] ^= 0x1;
+        writeTestFile(testCipherFileName, encrypted);
+        
+        SHOULD_BE_FALSE(openssl_aes256_file_decrypt(cipherKey, testCipherFileName, testDecryptedFileName, true));
+        SHOULD_EQUAL(fileSize(testDecryptedFileName), -1);
+        
+        /* Unauthenticated ciphers can be rejected */
+        SHOULD_BE_TRUE(openssl_aes256_file_encrypt(ctrKey, testPlaintextFileName, testCipherFileName));
+        SHOULD_BE_FALSE(openssl_aes256_file_decrypt(ctrKey, testCipherFileName, testDecryptedFileName, true));
+        SHOULD_EQUAL(fileSize(testDecryptedFileName), -1);
+        
+        wickr_buffer_destroy(&encrypted);
+        wickr_buffer_destroy(&testData);
+        wickr_cipher_key_destroy(&cipherKey);
+        wickr_cipher_key_destroy(&ctrKey);
+    }
+    END_IT
+    
+    openssl_aes256_file_set_mmap_threshold(defaultThreshold);
+    remove(testPlaintextFileName);
+    remove(testCipherFileName);
+    remove(testDecryptedFileName);
+}
+END_DESCRIBE
+
+DESCRIBE(pipelinedFile, "openssl_file_suite: pipelined files")
+{
+    char *testPlaintextFileName = "test_pipelined.data";
+    char *testCipherFileName = "test_pipelined.enc";
+    char *testDecryptedFileName = "decrypted_test_pipelined.data";
+    
+    const wickr_crypto_engine_t engine = wickr_crypto_engine_get_default();
+    openssl_file_pipeline_config_t defaultConfig = openssl_aes256_file_get_pipeline_config();
+    uint64_t defaultThreshold = openssl_aes256_file_get_mmap_threshold();
+    
+    IT( "is disabled by default and validates its configuration" )
+    {
+        SHOULD_BE_FALSE(defaultConfig.enabled);
+        SHOULD_EQUAL(defaultConfig.chunk_size, OPENSSL_FILE_PIPELINE_DEFAULT_CHUNK_SIZE);
+        SHOULD_EQUAL(defaultConfig.buffer_count, OPENSSL_FILE_PIPELINE_DEFAULT_BUFFER_COUNT);
+        
+        openssl_file_pipeline_config_t invalid[] = {
+            { true, 0, OPENSSL_FILE_PIPELINE_DEFAULT_BUFFER_COUNT },
+            { true, (size_t)INT_MAX + 1, OPENSSL_FILE_PIPELINE_DEFAULT_BUFFER_COUNT },
+            { true, 4096, OPENSSL_FILE_PIPELINE_MIN_BUFFER_COUNT - 1 },
+            { true, 4096, OPENSSL_FILE_PIPELINE_MAX_BUFFER_COUNT + 1 }
+        };
+        
+        for (int i = 0; i < sizeof(invalid) / sizeof(openssl_file_pipeline_config_t); i++) {
+            SHOULD_BE_FALSE(openssl_aes256_file_set_pipeline_config(invalid[i]));
+        }
+        
+        SHOULD_BE_FALSE(openssl_aes256_file_get_pipeline_config().enabled);
+    }
+    END_IT
+    
+    IT( "is compatible with the stdio implementation" )
+    {
+        openssl_file_pipeline_config_t configs[] = {
+            { true, 1, OPENSSL_FILE_PIPELINE_MIN_BUFFER_COUNT },
+            { true, 4093, OPENSSL_FILE_PIPELINE_DEFAULT_BUFFER_COUNT },
+            { true, OPENSSL_FILE_PIPELINE_DEFAULT_CHUNK_SIZE, OPENSSL_FILE_PIPELINE_MAX_BUFFER_COUNT }
+        };
+        size_t sizes[] = { 0, 1, 4093, 100000 };
+        wickr_cipher_t ciphers[] = { CIPHER_AES256_GCM, CIPHER_AES256_CTR };
+        openssl_file_pipeline_config_t disabled = defaultConfig;
+        disabled.enabled = false;
+        
+        /* Compare against the stdio implementation only */
+        openssl_aes256_file_set_mmap_threshold(UINT64_MAX);
+        
+        for (int c = 0; c < sizeof(ciphers) / sizeof(wickr_cipher_t); c++) {
+            wickr_cipher_key_t *cipherKey = engine.wickr_crypto_engine_cipher_key_random(ciphers[c]);
+            
+            for (int i = 0; i < sizeof(sizes) / sizeof(size_t); i++) {
+                wickr_buffer_t *testData = sizes[i] ? openssl_crypto_random(sizes[i]) : NULL;
+                writeTestFile(testPlaintextFileName, testData);
+                
+                for (int j = 0; j < sizeof(configs) / sizeof(openssl_file_pipeline_config_t); j++) {
+                    for (int pipelineEncrypt = 0; pipelineEncrypt < 2; pipelineEncrypt++) {
+                        SHOULD_BE_TRUE(openssl_aes256_file_set_pipeline_config(pipelineEncrypt ? configs[j] : disabled));
+                        SHOULD_BE_TRUE(engine.wickr_crypto_engine_encrypt_file(cipherKey, testPlaintextFileName, testCipherFileName));
+                        
+                        SHOULD_BE_TRUE(openssl_aes256_file_set_pipeline_config(pipelineEncrypt ? disabled : configs[j]));
+                        SHOULD_BE_TRUE(engine.wickr_crypto_engine_decrypt_file(cipherKey, testCipherFileName, testDecryptedFileName, false));
+                        
+                        wickr_buffer_t *decrypted = readTestFile(testDecryptedFileName);
+                        
+                        if (testData) {
+                            SHOULD_BE_TRUE(wickr_buffer_is_equal(decrypted, testData, NULL));
+                        }
+                        else {
+                            SHOULD_BE_NULL(decrypted);
+                        }
+                        
+                        wickr_buffer_destroy(&decrypted);
+                        remove(testDecryptedFileName);
+                    }
+                }
+                
+                /* Output is byte compatible with memory based encryption */
+                if (testData) {
+                    SHOULD_BE_TRUE(openssl_aes256_file_set_pipeline_config(configs[1]));
+                    SHOULD_BE_TRUE(openssl_aes256_file_encrypt(cipherKey, testPlaintextFileName, testCipherFileName));
+                    
+                    wickr_buffer_t *encrypted = readTestFile(testCipherFileName);
+                    wickr_cipher_result_t *cipher_result = wickr_cipher_result_from_buffer(encrypted);
+                    wickr_buffer_t *decrypted = engine.wickr_crypto_engine_cipher_decrypt(cipher_result, NULL, cipherKey, false);
+                    SHOULD_BE_TRUE(wickr_buffer_is_equal(decrypted, testData, NULL));
+                    
+                    wickr_buffer_destroy(&decrypted);
+                    wickr_cipher_result_destroy(&cipher_result);
+                    wickr_buffer_destroy(&encrypted);
+                }
+                
+                wickr_buffer_destroy(&testData);
+            }
+            
+            wickr_cipher_key_destroy(&cipherKey);
+        }
+    }
+    END_IT
+    
+    IT( "fails to decrypt modified files" )
+    {
+        openssl_file_pipeline_config_t config = { true, 4096, OPENSSL_FILE_PIPELINE_DEFAULT_BUFFER_COUNT };
+        SHOULD_BE_TRUE(openssl_aes256_file_set_pipeline_config(config));
+        
+        wickr_cipher_key_t *cipherKey = engine.wickr_crypto_engine_cipher_key_random(CIPHER_AES256_GCM);
+        wickr_buffer_t *testData = openssl_crypto_random(100000);
+        writeTestFile(testPlaintextFileName, testData);
+        
+        SHOULD_BE_TRUE(openssl_aes256_file_encrypt(cipherKey, testPlaintextFileName, testCipherFileName));
+        
+        wickr_buffer_t *encrypted = readTestFile(testCipherFileName);
+        encrypted->bytes[encrypted->length / 2] ^= 0x1;
+        writeTestFile(testCipherFileName, encrypted);
+        
+        SHOULD_BE_FALSE(openssl_aes256_file_decrypt(cipherKey, testCipherFileName, testDecryptedFileName, true));
+        SHOULD_EQUAL(fileSize(testDecryptedFileName), -1);
+        
+        wickr_buffer_destroy(&encrypted);
+        wickr_buffer_destroy(&testData);
+        wickr_cipher_key_destroy(&cipherKey);
+    }
+    END_IT
+    
+    openssl_aes256_file_set_pipeline_config(defaultConfig);
+    openssl_aes256_file_set_mmap_threshold(defaultThreshold);
+    remove(testPlaintextFileName);
+    remove(testCipherFileName);
+    remove(testDecryptedFileName);
+}
+END_DESCRIBE
+
+#define SEGMENT_SIZE 4096
+
+DESCRIBE(segmentedFile, "openssl_file_suite: segmented file format")
+{
+    char *testPlaintextFileName = "test_segmented.data";
+    char *testCipherFileName = "test_segmented.enc";
+    char *testDecryptedFileName = "decrypted_test_segmented.data";
+    
+    const wickr_crypto_engine_t engine = wickr_crypto_engine_get_default();
+    wickr_cipher_key_t *cipherKey = engine.wickr_crypto_engine_cipher_key_random(CIPHER_AES256_GCM);
+    
+    size_t headerSize = OPENSSL_FILE_SEGMENTED_HEADER_FIXED_LEN + CIPHER_AES256_GCM.iv_len;
+    
+    IT( "can encrypt and decrypt files of various sizes with multiple threads" )
+    {
+        size_t sizes[] = { 0, 1, SEGMENT_SIZE - 1, SEGMENT_SIZE, SEGMENT_SIZE + 1, SEGMENT_SIZE * 37 + 123 };
+        uint32_t threads[] = { 0, 1, 3, 8 };
+        
+        for (int i = 0; i < sizeof(sizes) / sizeof(size_t); i++) {
+            wickr_buffer_t *testData = sizes[i] ? openssl_crypto_random(sizes[i]) : NULL;
+            writeTestFile(testPlaintextFileName, testData);
+            
+            size_t segmentCount = sizes[i] == 0 ? 1 : (sizes[i] + SEGMENT_SIZE - 1) / SEGMENT_SIZE;
+            long expectedSize = (long)(headerSize + sizes[i] + segmentCount * CIPHER_AES256_GCM.auth_tag_len);
+            
+            for (int j = 0; j < sizeof(threads) / sizeof(uint32_t); j++) {
+                SHOULD_BE_TRUE(openssl_aes256_file_encrypt_segmented(cipherKey, testPlaintextFileName, testCipherFileName,
+                                                                     SEGMENT_SIZE, threads[j]));
+                SHOULD_EQUAL(fileSize(testCipherFileName), expectedSize);
+                
+                uint64_t length = 0;
+                SHOULD_BE_TRUE(openssl_aes256_file_segmented_length(testCipherFileName, &length));
+                SHOULD_EQUAL(length, sizes[i]);
+                
+                SHOULD_BE_TRUE(openssl_aes256_file_decrypt_segmented(cipherKey, testCipherFileName, testDecryptedFileName,
+                                                                     threads[(j + 1) % 4]));
+                SHOULD_EQUAL(fileSize(testDecryptedFileName), sizes[i]);
+                
+                wickr_buffer_t *decrypted = readTestFile(testDecryptedFileName);
+                
+                if (testData) {
+                    SHOULD_BE_TRUE(wickr_buffer_is_equal(decrypted, testData, NULL));
+                }
+                else {
+                    SHOULD_BE_NULL(decrypted);
+                }
+                
+                wickr_buffer_destroy(&decrypted);
+                remove(testDecryptedFileName);
+            }
+            
+            wickr_buffer_destroy(&testData);
+        }
+        
+        /* The legacy file decryption function detects the segmented format */
+        wickr_buffer_t *testData = openssl_crypto_random(SEGMENT_SIZE * 3);
+        writeTestFile(testPlaintextFileName, testData);
+        
+        SHOULD_BE_TRUE(openssl_aes256_file_encrypt_segmented(cipherKey, testPlaintextFileName, testCipherFileName,
+                                                             SEGMENT_SIZE, 2));
+        SHOULD_BE_TRUE(engine.wickr_crypto_engine_decrypt_file(cipherKey, testCipherFileName, testDecryptedFileName, true));
+        
+        wickr_buffer_t *decrypted = readTestFile(testDecryptedFileName);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(decrypted, testData, NULL));
+        
+        /* Legacy files are not in the segmented format */
+        SHOULD_BE_TRUE(openssl_aes256_file_encrypt(cipherKey, testPlaintextFileName, testCipherFileName));
+        uint64_t length = 0;
+        SHOULD_BE_FALSE(openssl_aes256_file_segmented_length(testCipherFileName, &length));
+        SHOULD_BE_FALSE(openssl_aes256_file_decrypt_segmented(cipherKey, testCipherFileName, testDecryptedFileName, 1));
+        
+        wickr_buffer_destroy(&decrypted);
+        wickr_buffer_destroy(&testData);
+        remove(testDecryptedFileName);
+    }
+    END_IT
+    
+    IT( "fails to encrypt with invalid parameters" )
+    {
+        wickr_buffer_t *testData = openssl_crypto_random(SEGMENT_SIZE);
+        writeTestFile(testPlaintextFileName, testData);
+        remove(testCipherFileName);
+        
+        wickr_cipher_key_t *ctrKey = engine.wickr_crypto_engine_cipher_key_random(CIPHER_AES256_CTR);
+        
+        SHOULD_BE_FALSE(openssl_aes256_file_encrypt_segmented(NULL, testPlaintextFileName, testCipherFileName, SEGMENT_SIZE, 1));
+        SHOULD_BE_FALSE(openssl_aes256_file_encrypt_segmented(cipherKey, NULL, testCipherFileName, SEGMENT_SIZE, 1));
+        SHOULD_BE_FALSE(openssl_aes256_file_encrypt_segmented(cipherKey, testPlaintextFileName, NULL, SEGMENT_SIZE, 1));
+        SHOULD_BE_FALSE(openssl_aes256_file_encrypt_segmented(ctrKey, testPlaintextFileName, testCipherFileName, SEGMENT_SIZE, 1));
+        SHOULD_BE_FALSE(openssl_aes256_file_encrypt_segmented(cipherKey, testPlaintextFileName, testCipherFileName,
+                                                              OPENSSL_FILE_SEGMENTED_MIN_SEGMENT_SIZE - 1, 1));
+        SHOULD_BE_FALSE(openssl_aes256_file_encrypt_segmented(cipherKey, testPlaintextFileName, testCipherFileName,
+                                                              OPENSSL_FILE_SEGMENTED_MAX_SEGMENT_SIZE + 1, 1));
+        SHOULD_EQUAL(fileSize(testCipherFileName), -1);
+        
+        wickr_cipher_key_destroy(&ctrKey);
+        wickr_buffer_destroy(&testData);
+    }
+    END_IT
+    
+    IT( "fails to decrypt a file that has been modified" )
+    {
+        wickr_buffer_t *testData = openssl_crypto_random(SEGMENT_SIZE * 4 + 10);
+        writeTestFile(testPlaintextFileName, testData);
+        
+        SHOULD_BE_TRUE(openssl_aes256_file_encrypt_segmented(cipherKey, testPlaintextFileName, testCipherFileName,
+                                                             SEGMENT_SIZE, 4));
+        
+        wickr_buffer_t *encrypted = readTestFile(testCipherFileName);
+        
+        /* Wrong key */
+        wickr_cipher_key_t *wrongKey = engine.wickr_crypto_engine_cipher_key_random(CIPHER_AES256_GCM);
+        SHOULD_BE_FALSE(openssl_aes256_file_decrypt_segmented(wrongKey, testCipherFileName, testDecryptedFileName, 4));
+        SHOULD_BE_NULL(openssl_aes256_file_decrypt_range(wrongKey, testCipherFileName, 0, 10));
+        wickr_cipher_key_destroy(&wrongKey);
+        
+        /* Modify a byte in the header, the first segment and the last segment */
+        size_t modifiedOffsets[] = { OPENSSL_FILE_SEGMENTED_MAGIC_LEN + 5, headerSize + 1, encrypted->length - 1 };
+        
+        for (int i = 0; i < sizeof(modifiedOffsets) / sizeof(size_t); i++) {
+            wickr_buffer_t *modified = wickr_buffer_copy(encrypted);
+            modified->bytes[modifiedOffsets[i]] ^= 0x1;
+            writeTestFile(testCipherFileName, modified);
+            
+            SHOULD_BE_FALSE(openssl_aes256_file_decrypt_segmented(cipherKey, testCipherFileName, testDecryptedFileName, 2));
+            SHOULD_EQUAL(fileSize(testDecryptedFileName), -1);
+            wickr_buffer_destroy(&modified);
+        }
+        
+        /* Drop the last segment, and add trailing data */
+        wickr_buffer_t truncated = { .bytes = encrypted->bytes, .length = encrypted->length - 10 - CIPHER_AES256_GCM.auth_tag_len };
+        writeTestFile(testCipherFileName, &truncated);
+        SHOULD_BE_FALSE(openssl_aes256_file_decrypt_segmented(cipherKey, testCipherFileName, testDecryptedFileName, 2));
+        
+        wickr_buffer_t *extended = wickr_buffer_concat(encrypted, encrypted);
+        writeTestFile(testCipherFileName, extended);
+        SHOULD_BE_FALSE(openssl_aes256_file_decrypt_segmented(cipherKey, testCipherFileName, testDecryptedFileName, 2));
+        SHOULD_EQUAL(fileSize(testDecryptedFileName), -1);
+        
+        /* Swap the first two segments */
+        wickr_buffer_t *swapped = wickr_buffer_copy(encrypted);
+        size_t segmentLen = SEGMENT_SIZE + CIPHER_AES256_GCM.auth_tag_len;
+        memcpy(swapped->bytes + headerSize, encrypted->bytes + headerSize + segmentLen, segmentLen);
+        memcpy(swapped->bytes + headerSize + segmentLen, encrypted->bytes + headerSize, segmentLen);
+        writeTestFile(testCipherFileName, swapped);
+        SHOULD_BE_FALSE(openssl_aes256_file_decrypt_segmented(cipherKey, testCipherFileName, testDecryptedFileName, 1));
+        SHOULD_BE_NULL(openssl_aes256_file_decrypt_range(cipherKey, testCipherFileName, 0, 10));
+        
+        wickr_buffer_destroy(&swapped);
+        wickr_buffer_destroy(&extended);
+        wickr_buffer_destroy(&encrypted);
+        wickr_buffer_destroy(&testData);
+    }
+    END_IT
+    
+    IT( "can decrypt ranges of a file" )
+    {
+        size_t dataSize = SEGMENT_SIZE * 10 + 500;
+        wickr_buffer_t *testData = openssl_crypto_random(dataSize);
+        writeTestFile(testPlaintextFileName, testData);
+        
+        SHOULD_BE_TRUE(openssl_aes256_file_encrypt_segmented(cipherKey, testPlaintextFileName, testCipherFileName,
+                                                             SEGMENT_SIZE, 3));
+        
+        uint64_t ranges[][2] = {
+            { 0, 1 },
+            { 0, SEGMENT_SIZE },
+            { SEGMENT_SIZE - 1, 2 },
+            { SEGMENT_SIZE * 2 + 7, SEGMENT_SIZE * 5 },
+            { dataSize - 1, 1 },
+            { 0, dataSize }
+        };
+        
+        for (int i = 0; i < sizeof(ranges) / sizeof(ranges[0]); i++) {
+            wickr_buffer_t *range = openssl_aes256_file_decrypt_range(cipherKey, testCipherFileName, ranges[i][0], ranges[i][1]);
+            SHOULD_NOT_BE_NULL(range);
+            SHOULD_EQUAL(range->length, ranges[i][1]);
+            SHOULD_EQUAL(memcmp(range->bytes, testData->bytes + ranges[i][0], range->length), 0);
+            wickr_buffer_destroy(&range);
+        }
+        
+        /* Ranges past the end of the file are truncated */
+        wickr_buffer_t *range = openssl_aes256_file_decrypt_range(cipherKey, testCipherFileName, dataSize - 10, 100);
+        SHOULD_NOT_BE_NULL(range);
+        SHOULD_EQUAL(range->length, 10);
+        SHOULD_EQUAL(memcmp(range->bytes, testData->bytes + dataSize - 10, range->length), 0);
+        wickr_buffer_destroy(&range);
+        
+        SHOULD_BE_NULL(openssl_aes256_file_decrypt_range(cipherKey, testCipherFileName, dataSize, 1));
+        SHOULD_BE_NULL(openssl_aes256_file_decrypt_range(cipherKey, testCipherFileName, 0, 0));
+        SHOULD_BE_NULL(openssl_aes256_file_decrypt_range(NULL, testCipherFileName, 0, 1));
+        SHOULD_BE_NULL(openssl_aes256_file_decrypt_range(cipherKey, NULL, 0, 1));
+        
+        /* Modifying a segment outside of the range does not prevent decryption of the range */
+        wickr_buffer_t *encrypted = readTestFile(testCipherFileName);
+        encrypted->bytes[encrypted->length - 1] ^= 0x1;
+        writeTestFile(testCipherFileName, encrypted);
+        
+        range = openssl_aes256_file_decrypt_range(cipherKey, testCipherFileName, 0, SEGMENT_SIZE);
+        SHOULD_NOT_BE_NULL(range);
+        wickr_buffer_destroy(&range);
+        SHOULD_BE_NULL(openssl_aes256_file_decrypt_range(cipherKey, testCipherFileName, dataSize - 1, 1));
+        
+        wickr_buffer_destroy(&encrypted);
+        wickr_buffer_destroy(&testData);
+    }
+    END_IT
+    
+    wickr_cipher_key_destroy(&cipherKey);
+    remove(testPlaintextFileName);
+    remove(testCipherFileName);
+    remove(testDecryptedFileName);
+}
+END_DESCRIBE
+
+/* H(prefix | first | second) calculated with the plain SHA2 digest */
+static wickr_buffer_t *treeNodeHash(uint8_t prefix, const wickr_buffer_t *first, const wickr_buffer_t *second, wickr_digest_t digest)
+{
+    wickr_buffer_t prefix_buffer = { .bytes = &prefix, .length = 1 };
+    wickr_buffer_t *input = second ? wickr_buffer_concat(first, second) : wickr_buffer_copy(first);
+    wickr_buffer_t *prefixed = wickr_buffer_concat(&prefix_buffer, input);
+    wickr_buffer_t *hash = openssl_sha2(prefixed, NULL, digest);
+    
+    wickr_buffer_destroy(&input);
+    wickr_buffer_destroy(&prefixed);
+    
+    return hash;
+}
+
+DESCRIBE(treeDigest, "openssl_file_suite: tree digests")
+{
+    char *testFileName = "test_tree.data";
+    size_t dataSize = DIGEST_TREE_LEAF_SIZE * 2 + 1000;
+    wickr_buffer_t *testData = openssl_crypto_random(dataSize);
+    writeTestFile(testFileName, testData);
+    
+    const wickr_crypto_engine_t engine = wickr_crypto_engine_get_default();
+    
+    /* Build the expected tree of 3 leaves by hand, the last leaf is promoted to the second level */
+    wickr_buffer_t chunks[3] = {
+        { .bytes = testData->bytes, .length = DIGEST_TREE_LEAF_SIZE },
+        { .bytes = testData->bytes + DIGEST_TREE_LEAF_SIZE, .length = DIGEST_TREE_LEAF_SIZE },
+        { .bytes = testData->bytes + DIGEST_TREE_LEAF_SIZE * 2, .length = 1000 }
+    };
+    
+    wickr_buffer_t *expectedLeaves[3];
+    
+    for (int i = 0; i < 3; i++) {
+        expectedLeaves[i] = treeNodeHash(0x00, &chunks[i], NULL, DIGEST_SHA_256);
+    }
+    
+    wickr_buffer_t *expectedNode = treeNodeHash(0x01, expectedLeaves[0], expectedLeaves[1], DIGEST_SHA_256);
+    wickr_buffer_t *expectedRoot = treeNodeHash(0x01, expectedNode, expectedLeaves[2], DIGEST_SHA_256);
+    
+    IT("should be found by identifier")
+    {
+        const wickr_digest_t *digest = wickr_digest_find_with_id(DIGEST_ID_SHA256_TREE);
+        SHOULD_NOT_BE_NULL(digest);
+        SHOULD_EQUAL(digest->type, DIGEST_SHA2_TREE);
+        SHOULD_EQUAL(digest->size, SHA256_DIGEST_SIZE);
+        
+        digest = wickr_digest_find_with_id(DIGEST_ID_SHA512_TREE);
+        SHOULD_NOT_BE_NULL(digest);
+        SHOULD_EQUAL(digest->type, DIGEST_SHA2_TREE);
+        SHOULD_EQUAL(digest->size, SHA512_DIGEST_SIZE);
+    }
+    END_IT
+    
+    IT("should calculate the root of the tree of a buffer")
+    {
+        SHOULD_BE_NULL(openssl_sha2_tree(NULL, DIGEST_SHA_256_TREE));
+        SHOULD_BE_NULL(openssl_sha2_tree(testData, DIGEST_SHA_256));
+        
+        wickr_buffer_t *root = openssl_sha2_tree(testData, DIGEST_SHA_256_TREE);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(root, expectedRoot, NULL));
+        wickr_buffer_destroy(&root);
+        
+        /* The engine digest function supports tree digests without a salt */
+        root = engine.wickr_crypto_engine_digest(testData, NULL, DIGEST_SHA_256_TREE);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(root, expectedRoot, NULL));
+        SHOULD_BE_NULL(engine.wickr_crypto_engine_digest(testData, testData, DIGEST_SHA_256_TREE));
+        
+        /* The tree digest is not the same as the plain digest */
+        wickr_buffer_t *plain = engine.wickr_crypto_engine_digest(testData, NULL, DIGEST_SHA_256);
+        SHOULD_BE_FALSE(wickr_buffer_is_equal(root, plain, NULL));
+        wickr_buffer_destroy(&plain);
+        wickr_buffer_destroy(&root);
+        
+        /* Input that fits in a single leaf is the hash of that leaf */
+        root = openssl_sha2_tree(&chunks[2], DIGEST_SHA_256_TREE);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(root, expectedLeaves[2], NULL));
+        wickr_buffer_destroy(&root);
+        
+        root = openssl_sha2_tree(testData, DIGEST_SHA_512_TREE);
+        SHOULD_EQUAL(root->length, SHA512_DIGEST_SIZE);
+        wickr_buffer_destroy(&root);
+    }
+    END_IT
+    
+    IT("should calculate the same root with any number of threads")
+    {
+        uint32_t threadCounts[] = { 1, 2, 3, OPENSSL_TREE_DIGEST_MAX_THREADS };
+        
+        for (int i = 0; i < sizeof(threadCounts) / sizeof(uint32_t); i++) {
+            openssl_sha2_tree_set_thread_count(threadCounts[i]);
+            SHOULD_EQUAL(openssl_sha2_tree_get_thread_count(), threadCounts[i]);
+            
+            wickr_buffer_t *root = openssl_sha2_tree(testData, DIGEST_SHA_256_TREE);
+            SHOULD_BE_TRUE(wickr_buffer_is_equal(root, expectedRoot, NULL));
+            wickr_buffer_destroy(&root);
+            
+            FILE *handle = fopen(testFileName, "rb");
+            root = openssl_sha2_tree_file(handle, DIGEST_SHA_256_TREE);
+            SHOULD_BE_TRUE(wickr_buffer_is_equal(root, expectedRoot, NULL));
+            SHOULD_BE_TRUE(feof(handle) || fgetc(handle) == EOF);
+            wickr_buffer_destroy(&root);
+            fclose(handle);
+        }
+        
+        openssl_sha2_tree_set_thread_count(0);
+        SHOULD_EQUAL(openssl_sha2_tree_get_thread_count(), 1);
+        openssl_sha2_tree_set_thread_count(OPENSSL_TREE_DIGEST_MAX_THREADS + 1);
+        SHOULD_EQUAL(openssl_sha2_tree_get_thread_count(), OPENSSL_TREE_DIGEST_MAX_THREADS);
+        openssl_sha2_tree_set_thread_count(OPENSSL_TREE_DIGEST_DEFAULT_THREADS);
+    }
+    END_IT
+    
+    IT("should calculate the root of the tree of a file from its current position")
+    {
+        SHOULD_BE_NULL(openssl_sha2_tree_file(NULL, DIGEST_SHA_256_TREE));
+        
+        FILE *handle = fopen(testFileName, "rb");
+        SHOULD_BE_NULL(openssl_sha2_tree_file(handle, DIGEST_SHA_384));
+        
+        wickr_buffer_t *root = engine.wickr_crypto_engine_digest_file(handle, DIGEST_SHA_256_TREE);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(root, expectedRoot, NULL));
+        wickr_buffer_destroy(&root);
+        
+        /* A tail that fits in one leaf is read with stdio */
+        fseek(handle, DIGEST_TREE_LEAF_SIZE * 2, SEEK_SET);
+        root = engine.wickr_crypto_engine_digest_file(handle, DIGEST_SHA_256_TREE);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(root, expectedLeaves[2], NULL));
+        wickr_buffer_destroy(&root);
+        fclose(handle);
+        
+#if !defined(_WIN32)
+        /* Streams that can't be mapped are hashed in batches with stdio */
+        handle = fmemopen(testData->bytes, testData->length, "rb");
+        root = openssl_sha2_tree_file(handle, DIGEST_SHA_256_TREE);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(root, expectedRoot, NULL));
+        wickr_buffer_destroy(&root);
+        fclose(handle);
+#endif
+        
+        /* An empty file is a single empty leaf */
+        writeTestFile(testFileName, NULL);
+        handle = fopen(testFileName, "rb");
+        root = openssl_sha2_tree_file(handle, DIGEST_SHA_256_TREE);
+        fclose(handle);
+        
+        uint8_t emptyLeaf = 0x00;
+        wickr_buffer_t emptyLeafBuffer = { .bytes = &emptyLeaf, .length = 1 };
+        wickr_buffer_t *expectedEmpty = openssl_sha2(&emptyLeafBuffer, NULL, DIGEST_SHA_256);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(root, expectedEmpty, NULL));
+        
+        wickr_buffer_destroy(&expectedEmpty);
+        wickr_buffer_destroy(&root);
+        writeTestFile(testFileName, testData);
+    }
+    END_IT
+    
+    IT("should verify individual chunks against the root")
+    {
+        FILE *handle = fopen(testFileName, "rb");
+        wickr_buffer_t *leaves = openssl_sha2_tree_file_leaves(handle, DIGEST_SHA_256_TREE);
+        fclose(handle);
+        
+        SHOULD_NOT_BE_NULL(leaves);
+        SHOULD_EQUAL(leaves->length, SHA256_DIGEST_SIZE * 3);
+        
+        for (int i = 0; i < 3; i++) {
+            wickr_buffer_t leaf = { .bytes = leaves->bytes + i * SHA256_DIGEST_SIZE, .length = SHA256_DIGEST_SIZE };
+            SHOULD_BE_TRUE(wickr_buffer_is_equal(&leaf, expectedLeaves[i], NULL));
+            SHOULD_BE_TRUE(openssl_sha2_tree_verify_chunk(&chunks[i], i, leaves, expectedRoot, DIGEST_SHA_256_TREE));
+        }
+        
+        wickr_buffer_t *root = openssl_sha2_tree_root(leaves, DIGEST_SHA_256_TREE);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(root, expectedRoot, NULL));
+        wickr_buffer_destroy(&root);
+        
+        wickr_buffer_t truncatedLeaves = { .bytes = leaves->bytes, .length = leaves->length - 1 };
+        SHOULD_BE_NULL(openssl_sha2_tree_root(&truncatedLeaves, DIGEST_SHA_256_TREE));
+        SHOULD_BE_NULL(openssl_sha2_tree_root(leaves, DIGEST_SHA_256));
+        
+        /* Chunks in the wrong position or with the wrong length fail */
+        SHOULD_BE_FALSE(openssl_sha2_tree_verify_chunk(&chunks[0], 1, leaves, expectedRoot, DIGEST_SHA_256_TREE));
+        SHOULD_BE_FALSE(openssl_sha2_tree_verify_chunk(&chunks[2], 3, leaves, expectedRoot, DIGEST_SHA_256_TREE));
+        SHOULD_BE_FALSE(openssl_sha2_tree_verify_chunk(&chunks[2], 1, leaves, expectedRoot, DIGEST_SHA_256_TREE));
+        SHOULD_BE_FALSE(openssl_sha2_tree_verify_chunk(NULL, 0, leaves, expectedRoot, DIGEST_SHA_256_TREE));
+        
+        /* A modified chunk fails */
+        wickr_buffer_t *modified = wickr_buffer_copy(&chunks[1]);
+        modified->bytes[100] ^= 0x1;
+        SHOULD_BE_FALSE(openssl_sha2_tree_verify_chunk(modified, 1, leaves, expectedRoot, DIGEST_SHA_256_TREE));
+        wickr_buffer_destroy(&modified);
+        
+        /* Leaves that don't match the root fail, even if the chunk matches its leaf */
+        leaves->bytes[0] ^= 0x1;
+        SHOULD_BE_FALSE(openssl_sha2_tree_verify_chunk(&chunks[1], 1, leaves, expectedRoot, DIGEST_SHA_256_TREE));
+        
+        wickr_buffer_destroy(&leaves);
+    }
+    END_IT
+    
+    for (int i = 0; i < 3; i++) {
+        wickr_buffer_destroy(&expectedLeaves[i]);
+    }
+    wickr_buffer_destroy(&expectedNode);
+    wickr_buffer_destroy(&expectedRoot);
+    wickr_buffer_destroy(&testData);
+    remove(testFileName);
+}
+END_DESCRIBE
+
+static wickr_buffer_t *digestTestFile(const char *path, wickr_digest_t mode)
+{
+    const wickr_crypto_engine_t engine = wickr_crypto_engine_get_default();
+    FILE *handle = fopen(path, "rb");
+    wickr_buffer_t *digest = engine.wickr_crypto_engine_digest_file(handle, mode);
+    fclose(handle);
+    
+    return digest;
+}
+
+DESCRIBE(digestFile, "openssl_file_suite: encryption and decryption with digests")
+{
+    char *testPlaintextFileName = "test_digest.data";
+    char *testCipherFileName = "test_digest.enc";
+    char *testDecryptedFileName = "test_digest.dec";
+    
+    const wickr_crypto_engine_t engine = wickr_crypto_engine_get_default();
+    wickr_cipher_key_t *cipherKey = engine.wickr_crypto_engine_cipher_key_random(CIPHER_AES256_GCM);
+    uint64_t defaultThreshold = openssl_aes256_file_get_mmap_threshold();
+    openssl_file_pipeline_config_t defaultPipeline = openssl_aes256_file_get_pipeline_config();
+    
+    IT("should fail if required inputs are missing")
+    {
+        wickr_buffer_t *testData = openssl_crypto_random(1000);
+        writeTestFile(testPlaintextFileName, testData);
+        wickr_buffer_t *plainDigest = NULL;
+        wickr_digest_t invalidDigest = { DIGEST_SHA2, 0, 0 };
+        
+        SHOULD_BE_FALSE(openssl_aes256_file_encrypt_digest(NULL, testPlaintextFileName, testCipherFileName, DIGEST_SHA_256, &plainDigest, NULL));
+        SHOULD_BE_FALSE(openssl_aes256_file_encrypt_digest(cipherKey, NULL, testCipherFileName, DIGEST_SHA_256, &plainDigest, NULL));
+        SHOULD_BE_FALSE(openssl_aes256_file_encrypt_digest(cipherKey, testPlaintextFileName, NULL, DIGEST_SHA_256, &plainDigest, NULL));
+        SHOULD_BE_FALSE(openssl_aes256_file_encrypt_digest(cipherKey, testPlaintextFileName, testCipherFileName, DIGEST_SHA_256, NULL, NULL));
+        SHOULD_BE_FALSE(openssl_aes256_file_encrypt_digest(cipherKey, testPlaintextFileName, testCipherFileName, invalidDigest, &plainDigest, NULL));
+        SHOULD_BE_FALSE(openssl_aes256_file_decrypt_digest(cipherKey, testCipherFileName, testDecryptedFileName, true, DIGEST_SHA_256, NULL, NULL));
+        SHOULD_BE_NULL(plainDigest);
+        SHOULD_EQUAL(fileSize(testCipherFileName), -1);
+        
+        wickr_buffer_destroy(&testData);
+    }
+    END_IT
+    
+    IT("should calculate the same digests as hashing the files separately")
+    {
+        size_t dataSizes[] = { 1000, DIGEST_TREE_LEAF_SIZE * 2 + 1000 };
+        wickr_digest_t modes[] = { DIGEST_SHA_256, DIGEST_SHA_512, DIGEST_SHA_256_TREE };
+        
+        for (int s = 0; s < sizeof(dataSizes) / sizeof(size_t); s++) {
+            wickr_buffer_t *testData = openssl_crypto_random(dataSizes[s]);
+            writeTestFile(testPlaintextFileName, testData);
+            
+            /* 0 is the pipelined replacement for stdio, 1 is memory mapped and 2 is the pipelined mode */
+            for (int path = 0; path < 3; path++) {
+                openssl_file_pipeline_config_t pipeline = defaultPipeline;
+                pipeline.enabled = path == 2;
+                pipeline.chunk_size = 100000;
+                openssl_aes256_file_set_pipeline_config(pipeline);
+                openssl_aes256_file_set_mmap_threshold(path == 1 ? 0 : UINT64_MAX);
+                
+                for (int m = 0; m < sizeof(modes) / sizeof(wickr_digest_t); m++) {
+                    wickr_buffer_t *plainDigest = NULL;
+                    wickr_buffer_t *cipherDigest = NULL;
+                    
+                    SHOULD_BE_TRUE(engine.wickr_crypto_engine_encrypt_file_digest(cipherKey, testPlaintextFileName, testCipherFileName,
+                                                                                  modes[m], &plainDigest, &cipherDigest));
+                    
+                    wickr_buffer_t *expectedPlain = digestTestFile(testPlaintextFileName, modes[m]);
+                    wickr_buffer_t *expectedCipher = digestTestFile(testCipherFileName, modes[m]);
+                    
+                    SHOULD_BE_TRUE(wickr_buffer_is_equal(plainDigest, expectedPlain, NULL));
+                    SHOULD_BE_TRUE(wickr_buffer_is_equal(cipherDigest, expectedCipher, NULL));
+                    wickr_buffer_destroy(&plainDigest);
+                    wickr_buffer_destroy(&cipherDigest);
+                    
+                    SHOULD_BE_TRUE(engine.wickr_crypto_engine_decrypt_file_digest(cipherKey, testCipherFileName, testDecryptedFileName,
+                                                                                  true, modes[m], &plainDigest, &cipherDigest));
+                    
+                    SHOULD_BE_TRUE(wickr_buffer_is_equal(plainDigest, expectedPlain, NULL));
+                    SHOULD_BE_TRUE(wickr_buffer_is_equal(cipherDigest, expectedCipher, NULL));
+                    
+                    wickr_buffer_t *decrypted = readTestFile(testDecryptedFileName);
+                    SHOULD_BE_TRUE(wickr_buffer_is_equal(decrypted, testData, NULL));
+                    
+                    wickr_buffer_destroy(&decrypted);
+                    wickr_buffer_destroy(&plainDigest);
+                    wickr_buffer_destroy(&cipherDigest);
+                    wickr_buffer_destroy(&expectedPlain);
+                    wickr_buffer_destroy(&expectedCipher);
+                    remove(testCipherFileName);
+                    remove(testDecryptedFileName);
+                }
+            }
+            
+            wickr_buffer_destroy(&testData);
+        }
+        
+        openssl_aes256_file_set_mmap_threshold(defaultThreshold);
+        openssl_aes256_file_set_pipeline_config(defaultPipeline);
+    }
+    END_IT
+    
+    IT("should calculate only the requested digests")
+    {
+        wickr_buffer_t *testData = openssl_crypto_random(50000);
+        writeTestFile(testPlaintextFileName, testData);
+        
+        wickr_buffer_t *cipherDigest = NULL;
+        SHOULD_BE_TRUE(openssl_aes256_file_encrypt_digest(cipherKey, testPlaintextFileName, testCipherFileName, DIGEST_SHA_384, NULL, &cipherDigest));
+        
+        wickr_buffer_t *expectedCipher = digestTestFile(testCipherFileName, DIGEST_SHA_384);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(cipherDigest, expectedCipher, NULL));
+        
+        wickr_buffer_t *plainDigest = NULL;
+        SHOULD_BE_TRUE(openssl_aes256_file_decrypt_digest(cipherKey, testCipherFileName, testDecryptedFileName, true, DIGEST_SHA_384, &plainDigest, NULL));
+        
+        wickr_buffer_t *expectedPlain = openssl_sha2(testData, NULL, DIGEST_SHA_384);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(plainDigest, expectedPlain, NULL));
+        
+        wickr_buffer_destroy(&cipherDigest);
+        wickr_buffer_destroy(&expectedCipher);
+        wickr_buffer_destroy(&plainDigest);
+        wickr_buffer_destroy(&expectedPlain);
+        wickr_buffer_destroy(&testData);
+    }
+    END_IT
+    
+    IT("should not return digests if decryption fails")
+    {
+        wickr_buffer_t *encrypted = readTestFile(testCipherFileName);
+        encrypted->bytes[encrypted->length - 1] ^= 0x1;
+        writeTestFile(testCipherFileName, encrypted);
+        remove(testDecryptedFileName);
+        
+        wickr_buffer_t *plainDigest = NULL;
+        wickr_buffer_t *cipherDigest = NULL;
+        SHOULD_BE_FALSE(openssl_aes256_file_decrypt_digest(cipherKey, testCipherFileName, testDecryptedFileName, true, DIGEST_SHA_256,
+                                                           &plainDigest, &cipherDigest));
+        SHOULD_BE_NULL(plainDigest);
+        SHOULD_BE_NULL(cipherDigest);
+        SHOULD_EQUAL(fileSize(testDecryptedFileName), -1);
+        
+        /* Segmented files are not supported */
+        SHOULD_BE_TRUE(openssl_aes256_file_encrypt_segmented(cipherKey, testPlaintextFileName, testCipherFileName,
+                                                             OPENSSL_FILE_SEGMENTED_DEFAULT_SEGMENT_SIZE, 1));
+        SHOULD_BE_FALSE(openssl_aes256_file_decrypt_digest(cipherKey, testCipherFileName, testDecryptedFileName, true, DIGEST_SHA_256,
+                                                           &plainDigest, &cipherDigest));
+        
+        wickr_buffer_destroy(&encrypted);
+    }
+    END_IT
+    
+    wickr_cipher_key_destroy(&cipherKey);
+    remove(testPlaintextFileName);
+    remove(testCipherFileName);
+    remove(testDecryptedFileName);
+}
+END_DESCRIBE
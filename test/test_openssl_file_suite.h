@@ -2,3 +2,8 @@
 
 DEFINE_DESCRIPTION(encodePlainFile)
 DEFINE_DESCRIPTION(decodeCipherFile)
+DEFINE_DESCRIPTION(segmentedFile)
+DEFINE_DESCRIPTION(mappedFile)
+DEFINE_DESCRIPTION(pipelinedFile)
+DEFINE_DESCRIPTION(treeDigest)
+DEFINE_DESCRIPTION(digestFile)
@@ -334,6 +334,171 @@ DESCRIBE(openssl_cipher_gcm, "openssl_suite: openssl_aes256_encrypt(gcm), openss
 }
 END_DESCRIBE
 
+static wickr_buffer_t *test_stream_apply(wickr_cipher_stream_t *stream, const wickr_buffer_t *input, size_t chunk_size)
+{
+    wickr_buffer_t *output = NULL;
+    
+    for (size_t offset = 0; offset < input->length; offset += chunk_size) {
+        size_t length = input->length - offset < chunk_size ? input->length - offset : chunk_size;
+        wickr_buffer_t chunk = { .bytes = input->bytes + offset, .length = length };
+        
+        wickr_buffer_t *chunk_output = openssl_aes256_stream_update(stream, &chunk);
+        
+        if (!chunk_output) {
+            wickr_buffer_destroy(&output);
+            return NULL;
+        }
+        
+        if (!output) {
+            output = chunk_output;
+            continue;
+        }
+        
+        wickr_buffer_t *joined = wickr_buffer_concat(output, chunk_output);
+        wickr_buffer_destroy(&output);
+        wickr_buffer_destroy(&chunk_output);
+        output = joined;
+    }
+    
+    return output;
+}
+
+DESCRIBE(openssl_cipher_stream, "openssl_suite: openssl_aes256_stream")
+{
+    wickr_buffer_t *test_plaintext = openssl_crypto_random(100000);
+    wickr_buffer_t *test_aad = hex_char_to_buffer("feedfacedeadbeeffeedfacedeadbeefabaddad2");
+    wickr_cipher_key_t *gcm_key = openssl_cipher_key_random(CIPHER_AES256_GCM);
+    wickr_cipher_key_t *ctr_key = openssl_cipher_key_random(CIPHER_AES256_CTR);
+    
+    IT("should fail if required inputs are missing")
+    {
+        SHOULD_BE_NULL(openssl_aes256_stream_encrypt_init(NULL, NULL, NULL));
+        SHOULD_BE_NULL(openssl_aes256_stream_encrypt_init(test_aad, ctr_key, NULL));
+        SHOULD_BE_NULL(openssl_aes256_stream_decrypt_init(NULL, NULL, gcm_key, false));
+        SHOULD_BE_NULL(openssl_aes256_stream_update(NULL, test_plaintext));
+        SHOULD_BE_NULL(openssl_aes256_stream_encrypt_final(NULL));
+        SHOULD_BE_FALSE(openssl_aes256_stream_decrypt_final(NULL));
+        
+        wickr_buffer_t *bad_iv = openssl_crypto_random(CIPHER_AES256_GCM.iv_len + 1);
+        SHOULD_BE_NULL(openssl_aes256_stream_encrypt_init(NULL, gcm_key, bad_iv));
+        wickr_buffer_destroy(&bad_iv);
+        
+        /* Decryption of an authenticated cipher requires a tag */
+        wickr_cipher_result_t header = { .cipher = CIPHER_AES256_GCM, .iv = openssl_crypto_random(CIPHER_AES256_GCM.iv_len) };
+        SHOULD_BE_NULL(openssl_aes256_stream_decrypt_init(&header, NULL, gcm_key, false));
+        
+        header.auth_tag = openssl_crypto_random(CIPHER_AES256_GCM.auth_tag_len - 1);
+        SHOULD_BE_NULL(openssl_aes256_stream_decrypt_init(&header, NULL, gcm_key, false));
+        
+        wickr_buffer_destroy(&header.iv);
+        wickr_buffer_destroy(&header.auth_tag);
+    }
+    END_IT
+    
+    IT("should produce the same output as a single buffer encryption")
+    {
+        wickr_cipher_key_t *keys[] = { gcm_key, ctr_key };
+        size_t chunk_sizes[] = { 1, 15, 4096, 100000 };
+        
+        for (int k = 0; k < 2; k++) {
+            wickr_buffer_t *aad = keys[k]->cipher.is_authenticated ? test_aad : NULL;
+            wickr_buffer_t *iv = openssl_crypto_random(keys[k]->cipher.iv_len);
+            
+            wickr_cipher_result_t *expected = openssl_aes256_encrypt(test_plaintext, aad, keys[k], iv);
+            wickr_buffer_t *expected_serialized = wickr_cipher_result_serialize(expected);
+            
+            for (int i = 0; i < sizeof(chunk_sizes) / sizeof(size_t); i++) {
+                wickr_cipher_stream_t *stream = openssl_aes256_stream_encrypt_init(aad, keys[k], iv);
+                SHOULD_NOT_BE_NULL(stream);
+                
+                wickr_buffer_t *cipher_text = test_stream_apply(stream, test_plaintext, chunk_sizes[i]);
+                wickr_cipher_result_t *header = openssl_aes256_stream_encrypt_final(stream);
+                SHOULD_NOT_BE_NULL(header);
+                SHOULD_BE_NULL(header->cipher_text);
+                
+                /* The stream can't be used after it is finalized */
+                SHOULD_BE_NULL(openssl_aes256_stream_update(stream, test_plaintext));
+                SHOULD_BE_NULL(openssl_aes256_stream_encrypt_final(stream));
+                SHOULD_BE_FALSE(openssl_aes256_stream_decrypt_final(stream));
+                
+                wickr_buffer_t *header_serialized = wickr_cipher_result_serialize(header);
+                wickr_buffer_t *serialized = wickr_buffer_concat(header_serialized, cipher_text);
+                SHOULD_BE_TRUE(wickr_buffer_is_equal(serialized, expected_serialized, NULL));
+                
+                wickr_buffer_destroy(&serialized);
+                wickr_buffer_destroy(&header_serialized);
+                wickr_cipher_result_destroy(&header);
+                wickr_buffer_destroy(&cipher_text);
+                openssl_aes256_stream_destroy(&stream);
+                SHOULD_BE_NULL(stream);
+            }
+            
+            wickr_buffer_destroy(&expected_serialized);
+            wickr_cipher_result_destroy(&expected);
+            wickr_buffer_destroy(&iv);
+        }
+    }
+    END_IT
+    
+    IT("should decrypt a single buffer encryption and verify its tag")
+    {
+        wickr_cipher_result_t *encrypted = openssl_aes256_encrypt(test_plaintext, test_aad, gcm_key, NULL);
+        
+        wickr_cipher_stream_t *stream = openssl_aes256_stream_decrypt_init(encrypted, test_aad, gcm_key, true);
+        SHOULD_NOT_BE_NULL(stream);
+        
+        /* A decryption stream can't be finalized as an encryption stream */
+        SHOULD_BE_NULL(openssl_aes256_stream_encrypt_final(stream));
+        
+        wickr_buffer_t *decrypted = test_stream_apply(stream, encrypted->cipher_text, 1000);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(decrypted, test_plaintext, NULL));
+        SHOULD_BE_TRUE(openssl_aes256_stream_decrypt_final(stream));
+        wickr_buffer_destroy(&decrypted);
+        openssl_aes256_stream_destroy(&stream);
+        
+        /* Modified ciphertext or the wrong AAD fails when the stream is finalized */
+        encrypted->cipher_text->bytes[500] ^= 0x1;
+        stream = openssl_aes256_stream_decrypt_init(encrypted, test_aad, gcm_key, true);
+        decrypted = test_stream_apply(stream, encrypted->cipher_text, 1000);
+        SHOULD_NOT_BE_NULL(decrypted);
+        SHOULD_BE_FALSE(openssl_aes256_stream_decrypt_final(stream));
+        wickr_buffer_destroy(&decrypted);
+        openssl_aes256_stream_destroy(&stream);
+        encrypted->cipher_text->bytes[500] ^= 0x1;
+        
+        stream = openssl_aes256_stream_decrypt_init(encrypted, NULL, gcm_key, true);
+        decrypted = test_stream_apply(stream, encrypted->cipher_text, 1000);
+        SHOULD_BE_FALSE(openssl_aes256_stream_decrypt_final(stream));
+        wickr_buffer_destroy(&decrypted);
+        openssl_aes256_stream_destroy(&stream);
+        
+        /* The wrong key type is rejected */
+        SHOULD_BE_NULL(openssl_aes256_stream_decrypt_init(encrypted, test_aad, ctr_key, false));
+        
+        wickr_cipher_result_destroy(&encrypted);
+        
+        /* Unauthenticated modes can be rejected */
+        encrypted = openssl_aes256_encrypt(test_plaintext, NULL, ctr_key, NULL);
+        SHOULD_BE_NULL(openssl_aes256_stream_decrypt_init(encrypted, NULL, ctr_key, true));
+        
+        stream = openssl_aes256_stream_decrypt_init(encrypted, NULL, ctr_key, false);
+        decrypted = test_stream_apply(stream, encrypted->cipher_text, 333);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(decrypted, test_plaintext, NULL));
+        SHOULD_BE_TRUE(openssl_aes256_stream_decrypt_final(stream));
+        
+        wickr_buffer_destroy(&decrypted);
+        openssl_aes256_stream_destroy(&stream);
+        wickr_cipher_result_destroy(&encrypted);
+    }
+    END_IT
+    
+    wickr_buffer_destroy(&test_plaintext);
+    wickr_buffer_destroy(&test_aad);
+    wickr_cipher_key_destroy(&gcm_key);
+    wickr_cipher_key_destroy(&ctr_key);
+}
+END_DESCRIBE
+
 DESCRIBE(openssl_ec_key_management, "openssl_suite: openssl_ec_rand_key, openssl_ec_key_import")
 {
     wickr_ec_key_t *one_key = NULL;
@@ -511,10 +676,53 @@ void sha_2_test(wickr_buffer_t *expected_output, const char *sample_message, wic
         wickr_buffer_t input_salt = { half_message, (uint8_t *)sample_message + half_message };
         
         wickr_buffer_t *hash = openssl_sha2(&input_message, &input_salt, digest);
-        
+
         SHOULD_BE_TRUE(wickr_buffer_is_equal(hash, expected_output, NULL));
-        
+
+        wickr_buffer_destroy(&hash);
+    }
+    END_IT
+
+    IT("should produce the same hash incrementally")
+    {
+        SHOULD_BE_FALSE(openssl_sha2_ctx_update(NULL, NULL));
+        SHOULD_BE_NULL(openssl_sha2_ctx_final(NULL));
+        SHOULD_BE_NULL(openssl_sha2_ctx_copy(NULL));
+
+        uint8_t half_message = strlen(sample_message) / 2;
+
+        wickr_buffer_t first_half = { half_message, (uint8_t *)sample_message };
+        wickr_buffer_t second_half = { strlen(sample_message) - half_message, (uint8_t *)sample_message + half_message };
+
+        wickr_digest_ctx_t *ctx = openssl_sha2_ctx_create(digest);
+        SHOULD_NOT_BE_NULL(ctx);
+
+        SHOULD_BE_TRUE(openssl_sha2_ctx_update(ctx, &first_half));
+
+        /* Taking an intermediate hash should not disturb the running state */
+        wickr_buffer_t *partial_hash = openssl_sha2_ctx_final(ctx);
+        wickr_buffer_t *expected_partial_hash = openssl_sha2(&first_half, NULL, digest);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(partial_hash, expected_partial_hash, NULL));
+
+        wickr_digest_ctx_t *copy = openssl_sha2_ctx_copy(ctx);
+        SHOULD_NOT_BE_NULL(copy);
+
+        SHOULD_BE_TRUE(openssl_sha2_ctx_update(ctx, &second_half));
+        SHOULD_BE_TRUE(openssl_sha2_ctx_update(copy, &second_half));
+
+        wickr_buffer_t *hash = openssl_sha2_ctx_final(ctx);
+        wickr_buffer_t *copy_hash = openssl_sha2_ctx_final(copy);
+
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(hash, expected_output, NULL));
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(copy_hash, expected_output, NULL));
+
+        wickr_buffer_destroy(&partial_hash);
+        wickr_buffer_destroy(&expected_partial_hash);
         wickr_buffer_destroy(&hash);
+        wickr_buffer_destroy(&copy_hash);
+        openssl_sha2_ctx_destroy(&copy);
+        openssl_sha2_ctx_destroy(&ctx);
+        SHOULD_BE_NULL(ctx);
     }
     END_IT
 }
@@ -6,6 +6,7 @@ wickr_buffer_t *hex_char_to_buffer(const char *hex);
 DEFINE_DESCRIPTION(openssl_crypto_random)
 DEFINE_DESCRIPTION(openssl_cipher_gcm)
 DEFINE_DESCRIPTION(openssl_cipher_ctr)
+DEFINE_DESCRIPTION(openssl_cipher_stream)
 DEFINE_DESCRIPTION(openssl_cipher_key_random)
 DEFINE_DESCRIPTION(openssl_ec_sign_verify)
 DEFINE_DESCRIPTION(openssl_ec_key_management);
@@ -5,6 +5,7 @@
 #include "cipher.h"
 #include "externs.h"
 #include "util.h"
+#include "message.pb-c.h"
 
 #include <limits.h>
 #include <string.h>
@@ -495,6 +496,20 @@ DESCRIBE(wickr_packet_create_from_components, "protocol: wickr_packet_create_fro
     wickr_cipher_key_destroy(&payloadKey);
     wickr_node_array_destroy(&recipients);
     
+    IT( "should hold the same content protobuf-c packs for its fields" )
+    {
+        Wickr__Proto__Packet *proto_packet = wickr__proto__packet__unpack(NULL, pkt->content->length, pkt->content->bytes);
+        SHOULD_NOT_BE_NULL(proto_packet);
+        
+        wickr_buffer_t *repacked = wickr_buffer_create_empty(wickr__proto__packet__get_packed_size(proto_packet));
+        wickr__proto__packet__pack(proto_packet, repacked->bytes);
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(repacked, pkt->content, NULL));
+        
+        wickr_buffer_destroy(&repacked);
+        wickr__proto__packet__free_unpacked(proto_packet, NULL);
+    }
+    END_IT
+    
     IT( "should be able to be serialized")
     {
         SHOULD_BE_NULL(wickr_packet_serialize(NULL));
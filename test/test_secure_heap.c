@@ -0,0 +1,129 @@
+#include "cspec.h"
+#include "test_secure_heap.h"
+#include "secure_heap.h"
+#include "memory.h"
+#include "buffer.h"
+#include "cipher.h"
+#include "eckey.h"
+#include "crypto_engine.h"
+#include <string.h>
+
+DESCRIBE(wickr_secure_heap, "secure_heap.c: wickr_secure_alloc")
+{
+    wickr_crypto_engine_t engine = wickr_crypto_engine_get_default();
+    
+    IT("should reserve address space for the heap")
+    {
+        wickr_secure_heap_stats_t stats;
+        SHOULD_BE_FALSE(wickr_secure_heap_get_stats(NULL));
+        SHOULD_BE_TRUE(wickr_secure_heap_get_stats(&stats));
+        SHOULD_BE_TRUE(stats.reserved_bytes > 0);
+        SHOULD_BE_TRUE(stats.committed_bytes <= stats.reserved_bytes);
+        
+        SHOULD_BE_NULL(wickr_secure_alloc(0));
+        SHOULD_BE_FALSE(wickr_secure_heap_owns(NULL));
+    }
+    END_IT
+    
+    IT("should allocate zeroed chunks and reuse them after they are freed")
+    {
+        wickr_secure_heap_stats_t before;
+        SHOULD_BE_TRUE(wickr_secure_heap_get_stats(&before));
+        
+        uint8_t *chunk = wickr_secure_alloc(48);
+        SHOULD_NOT_BE_NULL(chunk);
+        SHOULD_BE_TRUE(wickr_secure_heap_owns(chunk));
+        
+        uint8_t expected[48];
+        memset(expected, 0, sizeof(expected));
+        SHOULD_BE_TRUE(memcmp(chunk, expected, sizeof(expected)) == 0);
+        
+        wickr_secure_heap_stats_t during;
+        SHOULD_BE_TRUE(wickr_secure_heap_get_stats(&during));
+        SHOULD_EQUAL(during.live_allocations, before.live_allocations + 1);
+        SHOULD_EQUAL(during.live_bytes, before.live_bytes + 64);
+        
+        memset(chunk, 0xaa, 48);
+        wickr_free(chunk);
+        
+        /* The most recently freed chunk of a size class is handed out first, and it must come back zeroed */
+        uint8_t *reused = wickr_secure_alloc(60);
+        SHOULD_BE_TRUE(reused == chunk);
+        SHOULD_BE_TRUE(memcmp(reused, expected, sizeof(expected)) == 0);
+        
+        wickr_free_zero(reused, 60);
+        
+        wickr_secure_heap_stats_t after;
+        SHOULD_BE_TRUE(wickr_secure_heap_get_stats(&after));
+        SHOULD_EQUAL(after.live_allocations, before.live_allocations);
+        SHOULD_EQUAL(after.live_bytes, before.live_bytes);
+    }
+    END_IT
+    
+    IT("should fall back to the regular heap for large allocations")
+    {
+        wickr_secure_heap_stats_t before;
+        SHOULD_BE_TRUE(wickr_secure_heap_get_stats(&before));
+        
+        uint8_t *large = wickr_secure_alloc(WICKR_SECURE_HEAP_MAX_ALLOC + 1);
+        SHOULD_NOT_BE_NULL(large);
+        SHOULD_BE_FALSE(wickr_secure_heap_owns(large));
+        SHOULD_EQUAL(large[WICKR_SECURE_HEAP_MAX_ALLOC], 0);
+        
+        wickr_secure_heap_stats_t after;
+        SHOULD_BE_TRUE(wickr_secure_heap_get_stats(&after));
+        SHOULD_EQUAL(after.fallback_allocations, before.fallback_allocations + 1);
+        
+        wickr_free(large);
+    }
+    END_IT
+    
+    IT("should create buffers on the secure heap")
+    {
+        wickr_buffer_t *source = engine.wickr_crypto_engine_crypto_random(32);
+        
+        wickr_buffer_t *copy = wickr_buffer_copy_secure(source);
+        SHOULD_NOT_BE_NULL(copy);
+        SHOULD_BE_TRUE(wickr_secure_heap_owns(copy));
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(source, copy, NULL));
+        
+        wickr_buffer_t *section = wickr_buffer_copy_section_secure(source, 8, 16);
+        SHOULD_NOT_BE_NULL(section);
+        SHOULD_BE_TRUE(wickr_secure_heap_owns(section));
+        SHOULD_BE_TRUE(memcmp(section->bytes, source->bytes + 8, 16) == 0);
+        
+        SHOULD_BE_NULL(wickr_buffer_copy_section_secure(source, 24, 16));
+        SHOULD_BE_NULL(wickr_buffer_copy_secure(NULL));
+        SHOULD_BE_NULL(wickr_buffer_create_empty_secure(0));
+        
+        wickr_buffer_destroy_zero(&copy);
+        wickr_buffer_destroy(&section);
+        wickr_buffer_destroy(&source);
+    }
+    END_IT
+    
+    IT("should hold key material created by the crypto engine")
+    {
+        wickr_cipher_key_t *cipher_key = engine.wickr_crypto_engine_cipher_key_random(CIPHER_AES256_GCM);
+        SHOULD_NOT_BE_NULL(cipher_key);
+        SHOULD_BE_TRUE(wickr_secure_heap_owns(cipher_key->key_data));
+        
+        wickr_cipher_key_t *cipher_key_copy = wickr_cipher_key_copy(cipher_key);
+        SHOULD_BE_TRUE(wickr_secure_heap_owns(cipher_key_copy->key_data));
+        
+        wickr_ec_key_t *ec_key = engine.wickr_crypto_engine_ec_rand_key(EC_CURVE_NIST_P521);
+        SHOULD_NOT_BE_NULL(ec_key);
+        SHOULD_BE_TRUE(wickr_secure_heap_owns(ec_key->pri_data));
+        SHOULD_BE_FALSE(wickr_secure_heap_owns(ec_key->pub_data));
+        
+        wickr_ec_key_t *ec_key_copy = wickr_ec_key_copy(ec_key);
+        SHOULD_BE_TRUE(wickr_secure_heap_owns(ec_key_copy->pri_data));
+        
+        wickr_cipher_key_destroy(&cipher_key);
+        wickr_cipher_key_destroy(&cipher_key_copy);
+        wickr_ec_key_destroy(&ec_key);
+        wickr_ec_key_destroy(&ec_key_copy);
+    }
+    END_IT
+}
+END_DESCRIBE
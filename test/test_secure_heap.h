@@ -0,0 +1,9 @@
+#ifndef test_secure_heap_h
+#define test_secure_heap_h
+
+#include <stdio.h>
+#include "cspec.h"
+
+DEFINE_DESCRIPTION(wickr_secure_heap)
+
+#endif /* test_secure_heap_h */
@@ -798,6 +798,208 @@ DESCRIBE(wickr_transport_ctx, "Wickr Transport Context")
     
     reset_callback_data();
     
+    IT("can negotiate compact data packets")
+    {
+        wickr_identity_chain_t *alice_identity = createIdentityChain("alice");
+        wickr_identity_chain_t *bob_identity = createIdentityChain("bob");
+        
+        wickr_transport_ctx_t *test_transport_alice = wickr_transport_ctx_create(test_engine,
+                                                                                 alice_identity,
+                                                                                 bob_identity, 64,
+                                                                                 alice_callbacks, NULL);
+        
+        wickr_transport_ctx_t *test_transport_bob = wickr_transport_ctx_create(test_engine,
+                                                                               wickr_identity_chain_copy(bob_identity),
+                                                                               wickr_identity_chain_copy(alice_identity),
+                                                                               64, bob_callbacks, NULL);
+        
+        /* Only one side enabling compact packets keeps the standard format */
+        wickr_transport_ctx_set_compact_packets(test_transport_alice, true);
+        
+        wickr_transport_ctx_t *standard_alice = wickr_transport_ctx_copy(test_transport_alice);
+        wickr_transport_ctx_t *standard_bob = wickr_transport_ctx_copy(test_transport_bob);
+        
+        wickr_transport_ctx_set_compact_packets(test_transport_bob, true);
+        
+        wickr_transport_ctx_start(standard_alice);
+        wickr_transport_ctx_process_rx_buffer(standard_bob, alice_last_tx);
+        wickr_transport_ctx_process_rx_buffer(standard_alice, bob_last_tx);
+        reset_callback_data();
+        
+        SHOULD_EQUAL(wickr_transport_ctx_get_status(standard_alice), TRANSPORT_STATUS_ACTIVE);
+        SHOULD_BE_FALSE(wickr_transport_ctx_uses_compact_packets(standard_alice));
+        SHOULD_BE_FALSE(wickr_transport_ctx_uses_compact_packets(standard_bob));
+        
+        /* Both sides enabled */
+        wickr_transport_ctx_start(test_transport_alice);
+        wickr_transport_ctx_process_rx_buffer(test_transport_bob, alice_last_tx);
+        wickr_transport_ctx_process_rx_buffer(test_transport_alice, bob_last_tx);
+        reset_callback_data();
+        
+        SHOULD_EQUAL(wickr_transport_ctx_get_status(test_transport_alice), TRANSPORT_STATUS_ACTIVE);
+        SHOULD_BE_TRUE(wickr_transport_ctx_uses_compact_packets(test_transport_alice));
+        SHOULD_BE_TRUE(wickr_transport_ctx_uses_compact_packets(test_transport_bob));
+        SHOULD_BE_FALSE(wickr_transport_ctx_uses_compact_packets(NULL));
+        
+        /* Send voice sized frames, crossing into 2 byte sequence numbers */
+        wickr_buffer_t *frame = test_engine.wickr_crypto_engine_crypto_random(40);
+        
+        for (int i = 1; i <= 130; i++) {
+            wickr_transport_ctx_process_tx_buffer(standard_alice, frame);
+            size_t standard_length = alice_last_tx->length;
+            wickr_buffer_destroy(&alice_last_tx);
+            
+            wickr_transport_ctx_process_tx_buffer(test_transport_alice, frame);
+            SHOULD_NOT_BE_NULL(alice_last_tx);
+            SHOULD_EQUAL(alice_last_tx->length, standard_length - (i < 128 ? 8 : 7));
+            
+            wickr_transport_ctx_process_rx_buffer(test_transport_bob, alice_last_tx);
+            SHOULD_EQUAL(wickr_transport_ctx_get_status(test_transport_bob), TRANSPORT_STATUS_ACTIVE);
+            SHOULD_BE_TRUE(wickr_buffer_is_equal(bob_last_rx, frame, NULL));
+            
+            reset_callback_data();
+        }
+        
+        /* A standard format packet is not accepted by a compact session */
+        wickr_transport_ctx_process_tx_buffer(standard_alice, frame);
+        wickr_transport_ctx_process_rx_buffer(test_transport_bob, alice_last_tx);
+        SHOULD_EQUAL(wickr_transport_ctx_get_status(test_transport_bob), TRANSPORT_STATUS_ERROR);
+        SHOULD_EQUAL(bob_last_error, TRANSPORT_ERROR_PACKET_DECODE_FAILED);
+        
+        /* Cleanup */
+        wickr_buffer_destroy(&frame);
+        wickr_transport_ctx_destroy(&standard_alice);
+        wickr_transport_ctx_destroy(&standard_bob);
+        wickr_transport_ctx_destroy(&test_transport_alice);
+        wickr_transport_ctx_destroy(&test_transport_bob);
+    }
+    END_IT
+    
+    reset_callback_data();
+    
+    IT("will collect statistics about handshakes and packets")
+    {
+        wickr_transport_stats_t empty_stats = wickr_transport_ctx_get_stats(NULL);
+        SHOULD_EQUAL(empty_stats.tx_packets, 0);
+        SHOULD_EQUAL(empty_stats.handshakes_started, 0);
+        
+        wickr_identity_chain_t *alice_identity = createIdentityChain("alice");
+        wickr_identity_chain_t *bob_identity = createIdentityChain("bob");
+        
+        wickr_transport_ctx_t *test_transport_alice = wickr_transport_ctx_create(test_engine,
+                                                                                 alice_identity,
+                                                                                 bob_identity, 16,
+                                                                                 alice_callbacks, NULL);
+        
+        wickr_transport_ctx_t *test_transport_bob = wickr_transport_ctx_create(test_engine,
+                                                                               wickr_identity_chain_copy(bob_identity),
+                                                                               wickr_identity_chain_copy(alice_identity),
+                                                                               16, bob_callbacks, NULL);
+        
+        wickr_transport_stats_t alice_stats = wickr_transport_ctx_get_stats(test_transport_alice);
+        SHOULD_EQUAL(alice_stats.handshakes_started, 0);
+        SHOULD_EQUAL(alice_stats.tx_wire_bytes, 0);
+        
+        /* Establish the connection */
+        wickr_transport_ctx_start(test_transport_alice);
+        size_t handshake_tx_len = alice_last_tx->length;
+        wickr_transport_ctx_process_rx_buffer(test_transport_bob, alice_last_tx);
+        size_t handshake_rx_len = bob_last_tx->length;
+        wickr_transport_ctx_process_rx_buffer(test_transport_alice, bob_last_tx);
+        
+        alice_stats = wickr_transport_ctx_get_stats(test_transport_alice);
+        wickr_transport_stats_t bob_stats = wickr_transport_ctx_get_stats(test_transport_bob);
+        
+        SHOULD_EQUAL(alice_stats.handshakes_started, 1);
+        SHOULD_EQUAL(alice_stats.handshakes_completed, 1);
+        SHOULD_EQUAL(alice_stats.handshakes_resumed, 0);
+        SHOULD_EQUAL(alice_stats.handshakes_failed, 0);
+        SHOULD_EQUAL(alice_stats.handshake_tx_packets, 1);
+        SHOULD_EQUAL(alice_stats.handshake_rx_packets, 1);
+        SHOULD_EQUAL(alice_stats.tx_wire_bytes, handshake_tx_len);
+        SHOULD_EQUAL(alice_stats.rx_wire_bytes, handshake_rx_len);
+        SHOULD_EQUAL(bob_stats.handshakes_started, 1);
+        SHOULD_EQUAL(bob_stats.handshakes_completed, 1);
+        SHOULD_EQUAL(bob_stats.handshake_tx_packets, 1);
+        SHOULD_EQUAL(bob_stats.handshake_rx_packets, 1);
+        SHOULD_EQUAL(bob_stats.tx_wire_bytes, handshake_rx_len);
+        SHOULD_EQUAL(bob_stats.rx_wire_bytes, handshake_tx_len);
+        
+        reset_callback_data();
+        
+        /* Send enough packets to force an evolution */
+        uint64_t wire_bytes = 0;
+        wickr_buffer_t *first_packet = NULL;
+        
+        for (int i = 0; i < 17; i++) {
+            wickr_buffer_t *alice_data = test_engine.wickr_crypto_engine_crypto_random(32);
+            wickr_transport_ctx_process_tx_buffer(test_transport_alice, alice_data);
+            wickr_buffer_destroy(&alice_data);
+            
+            wire_bytes += alice_last_tx->length;
+            wickr_transport_ctx_process_rx_buffer(test_transport_bob, alice_last_tx);
+            
+            if (!first_packet) {
+                first_packet = wickr_buffer_copy(alice_last_tx);
+            }
+            
+            reset_callback_data();
+        }
+        
+        alice_stats = wickr_transport_ctx_get_stats(test_transport_alice);
+        bob_stats = wickr_transport_ctx_get_stats(test_transport_bob);
+        
+        SHOULD_EQUAL(alice_stats.tx_packets, 17);
+        SHOULD_EQUAL(alice_stats.tx_bytes, 17 * 32);
+        SHOULD_EQUAL(alice_stats.tx_wire_bytes, handshake_tx_len + wire_bytes);
+        SHOULD_EQUAL(alice_stats.tx_evolutions, 1);
+        SHOULD_EQUAL(alice_stats.tx_evolutions, test_transport_alice->tx_stream->evolution_count);
+        SHOULD_EQUAL(alice_stats.tx_encode_failures, 0);
+        SHOULD_EQUAL(bob_stats.rx_packets, 17);
+        SHOULD_EQUAL(bob_stats.rx_bytes, 17 * 32);
+        SHOULD_EQUAL(bob_stats.rx_wire_bytes, handshake_tx_len + wire_bytes);
+        SHOULD_EQUAL(bob_stats.rx_evolutions, 1);
+        SHOULD_EQUAL(bob_stats.rx_decrypt_failures, 0);
+        SHOULD_EQUAL(bob_stats.rx_sequence_failures, 0);
+        
+#ifdef WICKR_TRANSPORT_STATS_TIMING
+        SHOULD_EQUAL(alice_stats.handshake_time.count, 1);
+        SHOULD_EQUAL(bob_stats.handshake_time.count, 1);
+        SHOULD_EQUAL(alice_stats.tx_packet_time.count, 17);
+        SHOULD_EQUAL(bob_stats.rx_packet_time.count, 17);
+        SHOULD_BE_TRUE(alice_stats.tx_packet_time.min_ns <= alice_stats.tx_packet_time.max_ns);
+        
+        uint64_t bucket_total = 0;
+        for (int i = 0; i < TRANSPORT_STATS_HISTOGRAM_BUCKETS; i++) {
+            bucket_total += bob_stats.rx_packet_time.buckets[i];
+        }
+        SHOULD_EQUAL(bucket_total, 17);
+#endif
+        
+        /* A replayed packet is counted as a sequence failure */
+        wickr_transport_ctx_process_rx_buffer(test_transport_bob, first_packet);
+        wickr_buffer_destroy(&first_packet);
+        
+        bob_stats = wickr_transport_ctx_get_stats(test_transport_bob);
+        SHOULD_EQUAL(wickr_transport_ctx_get_status(test_transport_bob), TRANSPORT_STATUS_ERROR);
+        SHOULD_EQUAL(bob_stats.rx_sequence_failures, 1);
+        SHOULD_EQUAL(bob_stats.rx_decrypt_failures, 0);
+        SHOULD_EQUAL(bob_stats.rx_packets, 17);
+        
+        /* Copies carry their statistics with them */
+        wickr_transport_ctx_t *alice_copy = wickr_transport_ctx_copy(test_transport_alice);
+        wickr_transport_stats_t copy_stats = wickr_transport_ctx_get_stats(alice_copy);
+        SHOULD_EQUAL(memcmp(&copy_stats, &alice_stats, sizeof(wickr_transport_stats_t)), 0);
+        
+        /* Cleanup */
+        wickr_transport_ctx_destroy(&alice_copy);
+        wickr_transport_ctx_destroy(&test_transport_alice);
+        wickr_transport_ctx_destroy(&test_transport_bob);
+    }
+    END_IT
+    
+    reset_callback_data();
+    
     IT("can be destroyed")
     {
         wickr_transport_ctx_t *test_transport = wickr_transport_ctx_create(test_engine,
@@ -130,6 +130,30 @@ void verify_handshake_packet(wickr_transport_packet_t *packet, wickr_identity_ch
     SHOULD_EQUAL(packet->meta.body_meta.handshake.protocol_version, 1);
 }
 
+void verify_handshake_transcript(wickr_transport_handshake_t *handshake, wickr_transport_packet_t **packets, uint8_t count)
+{
+    SHOULD_EQUAL(handshake->transcript_len, count);
+    
+    /* The transcript is a running hash, so it should match a hash of the packets in the order they were recorded */
+    wickr_buffer_t *network_buffers[count];
+    
+    for (uint8_t i = 0; i < count; i++) {
+        network_buffers[i] = packets[i]->network_buffer;
+    }
+    
+    wickr_buffer_t *expected_input = wickr_buffer_concat_multi(network_buffers, count);
+    SHOULD_NOT_BE_NULL(expected_input);
+    
+    wickr_buffer_t *expected = test_engine.wickr_crypto_engine_digest(expected_input, NULL, DIGEST_SHA_512);
+    wickr_buffer_t *actual = test_engine.wickr_crypto_engine_digest_ctx_final(handshake->transcript);
+    
+    SHOULD_BE_TRUE(wickr_buffer_is_equal(expected, actual, NULL));
+    
+    wickr_buffer_destroy(&expected_input);
+    wickr_buffer_destroy(&expected);
+    wickr_buffer_destroy(&actual);
+}
+
 DESCRIBE(wickr_transport_handshake, "Wickr Transport Handshake")
 {
     reset_handshake_test_data();
@@ -292,7 +316,7 @@ DESCRIBE(wickr_transport_handshake, "Wickr Transport Handshake")
         SHOULD_BE_NULL(last_identity_callback_identity);
         
         /* The handshake should have recorded the packet internally */
-        SHOULD_NOT_BE_NULL(wickr_array_fetch_item(test_handshake->packet_list, 0, false));
+        verify_handshake_transcript(test_handshake, (wickr_transport_packet_t *[]) { start_packet }, 1);
         SHOULD_EQUAL(test_handshake->is_initiator, true);
     }
     END_IT
@@ -448,8 +472,7 @@ DESCRIBE(wickr_transport_handshake, "Wickr Transport Handshake")
         SHOULD_NOT_BE_NULL(test_receive_handshake->root_key);
         
         /* The handshake should have recorded both packets internally */
-        SHOULD_NOT_BE_NULL(wickr_array_fetch_item(test_receive_handshake->packet_list, 0, false));
-        SHOULD_NOT_BE_NULL(wickr_array_fetch_item(test_receive_handshake->packet_list, 1, false));
+        verify_handshake_transcript(test_receive_handshake, (wickr_transport_packet_t *[]) { start_packet, return_packet }, 2);
         
         /* Verify the identity callback did not get called because the remote identity was configured */
         SHOULD_BE_NULL(last_user_data);
@@ -487,8 +510,9 @@ DESCRIBE(wickr_transport_handshake, "Wickr Transport Handshake")
         SHOULD_EQUAL(wickr_transport_handshake_get_status(test_receive_handshake),
                      TRANSPORT_HANDSHAKE_STATUS_PENDING_VERIFICATION);
         
-        /* The handshake should have recorded the packet internally */
-        SHOULD_NOT_BE_NULL(wickr_array_fetch_item(test_receive_handshake->packet_list, 0, false));
+        /* The handshake should have recorded the packet and the response it holds until the identity is verified */
+        verify_handshake_transcript(test_receive_handshake,
+                                    (wickr_transport_packet_t *[]) { start_packet, test_receive_handshake->pending_identity_verify_packet }, 2);
         
         /* Verify the identity callback was called because the remote identity was not set */
         SHOULD_BE_TRUE(wickr_buffer_is_equal(test_receive_handshake->remote_identity->node->identifier,
@@ -513,7 +537,6 @@ DESCRIBE(wickr_transport_handshake, "Wickr Transport Handshake")
     }
     END_IT
     
-    wickr_transport_packet_destroy(&start_packet);
     wickr_transport_packet_t *return_packet = NULL;
     
     wickr_transport_handshake_t *test_identity_failure_handshake = wickr_transport_handshake_copy(test_receive_handshake);
@@ -532,7 +555,7 @@ DESCRIBE(wickr_transport_handshake, "Wickr Transport Handshake")
         SHOULD_NOT_BE_NULL(test_receive_handshake->root_key);
         
         /* The handshake should have recorded the return packet internally */
-        SHOULD_NOT_BE_NULL(wickr_array_fetch_item(test_receive_handshake->packet_list, 1, false));
+        verify_handshake_transcript(test_receive_handshake, (wickr_transport_packet_t *[]) { start_packet, return_packet }, 2);
     }
     END_IT
     
@@ -574,7 +597,7 @@ DESCRIBE(wickr_transport_handshake, "Wickr Transport Handshake")
         SHOULD_BE_NULL(last_identity_callback_identity);
         
         /* The handshake should have recorded the packet internally */
-        SHOULD_NOT_BE_NULL(wickr_array_fetch_item(test_receive_handshake->packet_list, 1, false));
+        verify_handshake_transcript(test_handshake, (wickr_transport_packet_t *[]) { start_packet, return_packet }, 2);
     }
     END_IT
     
@@ -670,7 +693,8 @@ DESCRIBE(wickr_transport_handshake, "Wickr Transport Handshake")
         SHOULD_EQUAL(wickr_transport_handshake_get_status(test_identity_handshake), TRANSPORT_HANDSHAKE_STATUS_PENDING_VERIFICATION);
         
         /* The handshake should have recorded the packet internally */
-        SHOULD_NOT_BE_NULL(wickr_array_fetch_item(test_identity_handshake->packet_list, 1, false));
+        verify_handshake_transcript(test_identity_handshake,
+                                    (wickr_transport_packet_t *[]) { identity_start_packet, identity_return_packet }, 2);
         
         /* Verify the identity callback was called because the remote identity was not set */
         SHOULD_BE_TRUE(wickr_buffer_is_equal(test_identity_handshake_receive->remote_identity->node->identifier,
@@ -838,3 +862,338 @@ DESCRIBE(wickr_transport_handshake, "Wickr Transport Handshake")
 }
 END_DESCRIBE
 
+
+static void test_resumption_run_handshake(wickr_transport_handshake_t *alice,
+                                          wickr_transport_handshake_t *bob,
+                                          wickr_transport_handshake_res_t **alice_result,
+                                          wickr_transport_handshake_res_t **bob_result)
+{
+    wickr_transport_packet_t *start_packet = wickr_transport_handshake_start(alice);
+    SHOULD_NOT_BE_NULL(start_packet);
+    
+    wickr_transport_packet_t *return_packet = wickr_transport_handshake_process(bob, start_packet);
+    wickr_transport_packet_destroy(&start_packet);
+    SHOULD_NOT_BE_NULL(return_packet);
+    
+    SHOULD_BE_NULL(wickr_transport_handshake_process(alice, return_packet));
+    wickr_transport_packet_destroy(&return_packet);
+    
+    *alice_result = wickr_transport_handshake_finalize(alice);
+    *bob_result = wickr_transport_handshake_finalize(bob);
+    
+    SHOULD_NOT_BE_NULL(*alice_result);
+    SHOULD_NOT_BE_NULL(*bob_result);
+}
+
+static wickr_transport_handshake_t *test_resumption_create_handshake(wickr_identity_chain_t *local,
+                                                                     wickr_identity_chain_t *remote,
+                                                                     const wickr_cipher_key_t *ticket_key,
+                                                                     const wickr_transport_resumption_t *resumption)
+{
+    wickr_transport_handshake_t *handshake = wickr_transport_handshake_create(test_engine,
+                                                                              wickr_identity_chain_copy(local),
+                                                                              wickr_identity_chain_copy(remote),
+                                                                              test_handshake_identity_callback,
+                                                                              42,
+                                                                              NULL);
+    SHOULD_NOT_BE_NULL(handshake);
+    
+    wickr_transport_handshake_set_ticket_key(handshake, wickr_cipher_key_copy(ticket_key));
+    wickr_transport_handshake_set_resumption(handshake, wickr_transport_resumption_copy(resumption));
+    
+    return handshake;
+}
+
+DESCRIBE(wickr_transport_handshake_resumption, "Wickr Transport Handshake Resumption")
+{
+    test_engine = wickr_crypto_engine_get_default();
+    wickr_identity_chain_t *alice_identity = createIdentityChain("alice");
+    wickr_identity_chain_t *bob_identity = createIdentityChain("bob");
+    
+    wickr_cipher_key_t *ticket_key = test_engine.wickr_crypto_engine_cipher_key_random(test_engine.default_cipher);
+    wickr_transport_resumption_t *resumption = NULL;
+    wickr_transport_handshake_res_t *full_alice_result = NULL;
+    
+    IT("will issue a resumption ticket to the initiator if the responder has a ticket key")
+    {
+        wickr_transport_handshake_t *alice = test_resumption_create_handshake(alice_identity, bob_identity, NULL, NULL);
+        wickr_transport_handshake_t *bob = test_resumption_create_handshake(bob_identity, alice_identity, ticket_key, NULL);
+        
+        wickr_transport_handshake_res_t *bob_result = NULL;
+        test_resumption_run_handshake(alice, bob, &full_alice_result, &bob_result);
+        
+        SHOULD_NOT_BE_NULL(wickr_transport_handshake_res_get_resumption(full_alice_result));
+        SHOULD_BE_NULL(wickr_transport_handshake_res_get_resumption(bob_result));
+        
+        resumption = wickr_transport_resumption_copy(wickr_transport_handshake_res_get_resumption(full_alice_result));
+        SHOULD_NOT_BE_NULL(resumption);
+        
+        /* The resumption key must not be the same as the key that was used for the full handshake */
+        SHOULD_BE_FALSE(wickr_buffer_is_equal(resumption->root_key->secret, alice->root_key->secret, NULL));
+        
+        wickr_transport_handshake_res_t *copy = wickr_transport_handshake_res_copy(full_alice_result);
+        SHOULD_NOT_BE_NULL(wickr_transport_handshake_res_get_resumption(copy));
+        SHOULD_BE_TRUE(wickr_buffer_is_equal(wickr_transport_handshake_res_get_resumption(copy)->ticket, resumption->ticket, NULL));
+        
+        wickr_transport_handshake_res_destroy(&copy);
+        wickr_transport_handshake_res_destroy(&bob_result);
+        wickr_transport_handshake_destroy(&alice);
+        wickr_transport_handshake_destroy(&bob);
+    }
+    END_IT
+    
+    IT("will not issue a resumption ticket if the responder has no ticket key")
+    {
+        wickr_transport_handshake_t *alice = test_resumption_create_handshake(alice_identity, bob_identity, NULL, NULL);
+        wickr_transport_handshake_t *bob = test_resumption_create_handshake(bob_identity, alice_identity, NULL, NULL);
+        
+        wickr_transport_handshake_res_t *alice_result = NULL;
+        wickr_transport_handshake_res_t *bob_result = NULL;
+        test_resumption_run_handshake(alice, bob, &alice_result, &bob_result);
+        
+        SHOULD_BE_NULL(wickr_transport_handshake_res_get_resumption(alice_result));
+        
+        wickr_transport_handshake_res_destroy(&alice_result);
+        wickr_transport_handshake_res_destroy(&bob_result);
+        wickr_transport_handshake_destroy(&alice);
+        wickr_transport_handshake_destroy(&bob);
+    }
+    END_IT
+    
+    IT("can resume a session without a key exchange")
+    {
+        wickr_transport_handshake_t *alice = test_resumption_create_handshake(alice_identity, bob_identity, NULL, resumption);
+        wickr_transport_handshake_t *bob = test_resumption_create_handshake(bob_identity, alice_identity, ticket_key, NULL);
+        
+        wickr_transport_packet_t *start_packet = wickr_transport_handshake_start(alice);
+        SHOULD_NOT_BE_NULL(start_packet);
+        SHOULD_EQUAL(start_packet->meta.mac_type, TRANSPORT_MAC_TYPE_NONE);
+        SHOULD_BE_NULL(alice->local_ephemeral_key);
+        SHOULD_EQUAL(wickr_transport_handshake_get_status(alice), TRANSPORT_HANDSHAKE_STATUS_IN_PROGRESS);
+        
+        wickr_transport_packet_t *return_packet = wickr_transport_handshake_process(bob, start_packet);
+        wickr_transport_packet_destroy(&start_packet);
+        SHOULD_NOT_BE_NULL(return_packet);
+        SHOULD_EQUAL(return_packet->meta.mac_type, TRANSPORT_MAC_TYPE_NONE);
+        SHOULD_EQUAL(wickr_transport_handshake_get_status(bob), TRANSPORT_HANDSHAKE_STATUS_PENDING_FINALIZATION);
+        
+        SHOULD_BE_NULL(wickr_transport_handshake_process(alice, return_packet));
+        wickr_transport_packet_destroy(&return_packet);
+        SHOULD_EQUAL(wickr_transport_handshake_get_status(alice), TRANSPORT_HANDSHAKE_STATUS_PENDING_FINALIZATION);
+        
+        wickr_transport_handshake_res_t *alice_result = wickr_transport_handshake_finalize(alice);
+        wickr_transport_handshake_res_t *bob_result = wickr_transport_handshake_finalize(bob);
+        
+        SHOULD_BE_TRUE(wickr_stream_key_is_equal(wickr_transport_handshake_res_get_local_key(alice_result),
+                                                 wickr_transport_handshake_res_get_remote_key(bob_result)));
+        SHOULD_BE_TRUE(wickr_stream_key_is_equal(wickr_transport_handshake_res_get_remote_key(alice_result),
+                                                 wickr_transport_handshake_res_get_local_key(bob_result)));
+        
+        /* The resumed session must use fresh keys */
+        SHOULD_BE_FALSE(wickr_stream_key_is_equal(wickr_transport_handshake_res_get_local_key(alice_result),
+                                                  wickr_transport_handshake_res_get_local_key(full_alice_result)));
+        
+        /* The ticket remains available for the next resumption */
+        SHOULD_NOT_BE_NULL(wickr_transport_handshake_res_get_resumption(alice_result));
+        
+        wickr_transport_handshake_res_destroy(&alice_result);
+        wickr_transport_handshake_res_destroy(&bob_result);
+        wickr_transport_handshake_destroy(&alice);
+        wickr_transport_handshake_destroy(&bob);
+    }
+    END_IT
+    
+    IT("will fall back to a full handshake if the responder can't open the ticket")
+    {
+        wickr_cipher_key_t *other_ticket_key = test_engine.wickr_crypto_engine_cipher_key_random(test_engine.default_cipher);
+        
+        wickr_transport_handshake_t *alice = test_resumption_create_handshake(alice_identity, bob_identity, NULL, resumption);
+        wickr_transport_handshake_t *bob = test_resumption_create_handshake(bob_identity, alice_identity, other_ticket_key, NULL);
+        
+        wickr_transport_packet_t *start_packet = wickr_transport_handshake_start(alice);
+        SHOULD_NOT_BE_NULL(start_packet);
+        
+        wickr_transport_packet_t *reject_packet = wickr_transport_handshake_process(bob, start_packet);
+        wickr_transport_packet_destroy(&start_packet);
+        SHOULD_NOT_BE_NULL(reject_packet);
+        SHOULD_EQUAL(wickr_transport_handshake_get_status(bob), TRANSPORT_HANDSHAKE_STATUS_UNKNOWN);
+        
+        /* Alice should respond with a signed seed for a full handshake */
+        wickr_transport_packet_t *seed_packet = wickr_transport_handshake_process(alice, reject_packet);
+        wickr_transport_packet_destroy(&reject_packet);
+        SHOULD_NOT_BE_NULL(seed_packet);
+        verify_handshake_packet(seed_packet, alice_identity);
+        SHOULD_BE_NULL(alice->resumption);
+        
+        wickr_transport_packet_t *return_packet = wickr_transport_handshake_process(bob, seed_packet);
+        wickr_transport_packet_destroy(&seed_packet);
+        SHOULD_NOT_BE_NULL(return_packet);
+        
+        SHOULD_BE_NULL(wickr_transport_handshake_process(alice, return_packet));
+        wickr_transport_packet_destroy(&return_packet);
+        
+        wickr_transport_handshake_res_t *alice_result = wickr_transport_handshake_finalize(alice);
+        wickr_transport_handshake_res_t *bob_result = wickr_transport_handshake_finalize(bob);
+        
+        SHOULD_BE_TRUE(wickr_stream_key_is_equal(wickr_transport_handshake_res_get_local_key(alice_result),
+                                                 wickr_transport_handshake_res_get_remote_key(bob_result)));
+        
+        /* A new ticket was issued under the new ticket key */
+        const wickr_transport_resumption_t *new_resumption = wickr_transport_handshake_res_get_resumption(alice_result);
+        SHOULD_NOT_BE_NULL(new_resumption);
+        SHOULD_BE_FALSE(wickr_buffer_is_equal(new_resumption->ticket, resumption->ticket, NULL));
+        
+        wickr_cipher_key_destroy(&other_ticket_key);
+        wickr_transport_handshake_res_destroy(&alice_result);
+        wickr_transport_handshake_res_destroy(&bob_result);
+        wickr_transport_handshake_destroy(&alice);
+        wickr_transport_handshake_destroy(&bob);
+    }
+    END_IT
+    
+    IT("will reject a ticket that was issued to a different identity")
+    {
+        wickr_identity_chain_t *charlie = createIdentityChain("charlie");
+        SHOULD_NOT_BE_NULL(charlie);
+        
+        wickr_transport_handshake_t *alice = test_resumption_create_handshake(alice_identity, bob_identity, NULL, resumption);
+        wickr_transport_handshake_t *bob = test_resumption_create_handshake(bob_identity, charlie, ticket_key, NULL);
+        
+        wickr_transport_packet_t *start_packet = wickr_transport_handshake_start(alice);
+        wickr_transport_packet_t *reject_packet = wickr_transport_handshake_process(bob, start_packet);
+        wickr_transport_packet_destroy(&start_packet);
+        
+        SHOULD_NOT_BE_NULL(reject_packet);
+        SHOULD_EQUAL(wickr_transport_handshake_get_status(bob), TRANSPORT_HANDSHAKE_STATUS_UNKNOWN);
+        SHOULD_BE_NULL(bob->root_key);
+        
+        wickr_transport_packet_destroy(&reject_packet);
+        wickr_identity_chain_destroy(&charlie);
+        wickr_transport_handshake_destroy(&alice);
+        wickr_transport_handshake_destroy(&bob);
+    }
+    END_IT
+    
+    IT("will reject a ticket that has been modified")
+    {
+        wickr_transport_resumption_t *modified = wickr_transport_resumption_copy(resumption);
+        modified->ticket->bytes[modified->ticket->length - 1] ^= 0x1;
+        
+        wickr_transport_handshake_t *alice = test_resumption_create_handshake(alice_identity, bob_identity, NULL, modified);
+        wickr_transport_handshake_t *bob = test_resumption_create_handshake(bob_identity, alice_identity, ticket_key, NULL);
+        
+        wickr_transport_packet_t *start_packet = wickr_transport_handshake_start(alice);
+        wickr_transport_packet_t *reject_packet = wickr_transport_handshake_process(bob, start_packet);
+        wickr_transport_packet_destroy(&start_packet);
+        
+        SHOULD_NOT_BE_NULL(reject_packet);
+        SHOULD_EQUAL(wickr_transport_handshake_get_status(bob), TRANSPORT_HANDSHAKE_STATUS_UNKNOWN);
+        
+        wickr_transport_packet_destroy(&reject_packet);
+        wickr_transport_resumption_destroy(&modified);
+        wickr_transport_handshake_destroy(&alice);
+        wickr_transport_handshake_destroy(&bob);
+    }
+    END_IT
+    
+    wickr_transport_handshake_res_destroy(&full_alice_result);
+    wickr_transport_resumption_destroy(&resumption);
+    wickr_cipher_key_destroy(&ticket_key);
+    wickr_identity_chain_destroy(&alice_identity);
+    wickr_identity_chain_destroy(&bob_identity);
+    wickr_identity_chain_destroy(&last_identity_callback_identity);
+}
+END_DESCRIBE
+
+DESCRIBE(wickr_transport_handshake_flags, "Wickr Transport Handshake Flags")
+{
+    test_engine = wickr_crypto_engine_get_default();
+    wickr_identity_chain_t *alice_identity = createIdentityChain("alice");
+    wickr_identity_chain_t *bob_identity = createIdentityChain("bob");
+    
+    IT("will negotiate flags that are advertised by both parties")
+    {
+        wickr_transport_handshake_t *alice = test_resumption_create_handshake(alice_identity, bob_identity, NULL, NULL);
+        wickr_transport_handshake_t *bob = test_resumption_create_handshake(bob_identity, alice_identity, NULL, NULL);
+        
+        wickr_transport_handshake_set_flags(alice, TRANSPORT_HANDSHAKE_FLAG_COMPACT_PACKETS | 0x8);
+        wickr_transport_handshake_set_flags(bob, TRANSPORT_HANDSHAKE_FLAG_COMPACT_PACKETS);
+        
+        wickr_transport_packet_t *start_packet = wickr_transport_handshake_start(alice);
+        SHOULD_EQUAL(start_packet->meta.body_meta.handshake.flags, TRANSPORT_HANDSHAKE_FLAG_COMPACT_PACKETS | 0x8);
+        
+        wickr_transport_packet_t *return_packet = wickr_transport_handshake_process(bob, start_packet);
+        wickr_transport_packet_destroy(&start_packet);
+        SHOULD_EQUAL(return_packet->meta.body_meta.handshake.flags, TRANSPORT_HANDSHAKE_FLAG_COMPACT_PACKETS);
+        
+        SHOULD_BE_NULL(wickr_transport_handshake_process(alice, return_packet));
+        wickr_transport_packet_destroy(&return_packet);
+        
+        wickr_transport_handshake_res_t *alice_result = wickr_transport_handshake_finalize(alice);
+        wickr_transport_handshake_res_t *bob_result = wickr_transport_handshake_finalize(bob);
+        
+        SHOULD_EQUAL(wickr_transport_handshake_res_get_flags(alice_result), TRANSPORT_HANDSHAKE_FLAG_COMPACT_PACKETS);
+        SHOULD_EQUAL(wickr_transport_handshake_res_get_flags(bob_result), TRANSPORT_HANDSHAKE_FLAG_COMPACT_PACKETS);
+        
+        wickr_transport_handshake_res_t *copy = wickr_transport_handshake_res_copy(alice_result);
+        SHOULD_EQUAL(wickr_transport_handshake_res_get_flags(copy), TRANSPORT_HANDSHAKE_FLAG_COMPACT_PACKETS);
+        
+        wickr_transport_handshake_res_destroy(&copy);
+        wickr_transport_handshake_res_destroy(&alice_result);
+        wickr_transport_handshake_res_destroy(&bob_result);
+        wickr_transport_handshake_destroy(&alice);
+        wickr_transport_handshake_destroy(&bob);
+    }
+    END_IT
+    
+    IT("will not enable a flag that only one party advertised")
+    {
+        wickr_transport_handshake_t *alice = test_resumption_create_handshake(alice_identity, bob_identity, NULL, NULL);
+        wickr_transport_handshake_t *bob = test_resumption_create_handshake(bob_identity, alice_identity, NULL, NULL);
+        
+        wickr_transport_handshake_set_flags(alice, TRANSPORT_HANDSHAKE_FLAG_COMPACT_PACKETS);
+        
+        wickr_transport_handshake_res_t *alice_result = NULL;
+        wickr_transport_handshake_res_t *bob_result = NULL;
+        test_resumption_run_handshake(alice, bob, &alice_result, &bob_result);
+        
+        SHOULD_EQUAL(wickr_transport_handshake_res_get_flags(alice_result), 0);
+        SHOULD_EQUAL(wickr_transport_handshake_res_get_flags(bob_result), 0);
+        SHOULD_EQUAL(wickr_transport_handshake_res_get_flags(NULL), 0);
+        
+        wickr_transport_handshake_res_destroy(&alice_result);
+        wickr_transport_handshake_res_destroy(&bob_result);
+        wickr_transport_handshake_destroy(&alice);
+        wickr_transport_handshake_destroy(&bob);
+    }
+    END_IT
+    
+    IT("will fail if the advertised flags are modified in transit")
+    {
+        wickr_transport_handshake_t *alice = test_resumption_create_handshake(alice_identity, bob_identity, NULL, NULL);
+        wickr_transport_handshake_t *bob = test_resumption_create_handshake(bob_identity, alice_identity, NULL, NULL);
+        
+        wickr_transport_handshake_set_flags(alice, TRANSPORT_HANDSHAKE_FLAG_COMPACT_PACKETS);
+        wickr_transport_handshake_set_flags(bob, TRANSPORT_HANDSHAKE_FLAG_COMPACT_PACKETS);
+        
+        wickr_transport_packet_t *start_packet = wickr_transport_handshake_start(alice);
+        
+        /* Strip the flag while keeping the original signature */
+        start_packet->meta.body_meta.handshake.flags = 0;
+        wickr_buffer_destroy(&start_packet->network_buffer);
+        start_packet->network_buffer = wickr_transport_packet_serialize(start_packet);
+        
+        SHOULD_BE_NULL(wickr_transport_handshake_process(bob, start_packet));
+        SHOULD_EQUAL(wickr_transport_handshake_get_status(bob), TRANSPORT_HANDSHAKE_STATUS_FAILED);
+        
+        wickr_transport_packet_destroy(&start_packet);
+        wickr_transport_handshake_destroy(&alice);
+        wickr_transport_handshake_destroy(&bob);
+    }
+    END_IT
+    
+    wickr_identity_chain_destroy(&alice_identity);
+    wickr_identity_chain_destroy(&bob_identity);
+    wickr_identity_chain_destroy(&last_identity_callback_identity);
+}
+END_DESCRIBE
@@ -6,5 +6,7 @@
 
 DEFINE_DESCRIPTION(wickr_transport_handshake_res)
 DEFINE_DESCRIPTION(wickr_transport_handshake)
+DEFINE_DESCRIPTION(wickr_transport_handshake_resumption)
+DEFINE_DESCRIPTION(wickr_transport_handshake_flags)
 
 #endif /* test_transport_handshake_h */
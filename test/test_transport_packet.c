@@ -14,6 +14,7 @@ bool wickr_transport_packet_meta_is_equal(wickr_transport_packet_meta_t a, wickr
             return a.body_meta.handshake.flags == a.body_meta.handshake.flags ||
                 a.body_meta.handshake.protocol_version == b.body_meta.handshake.protocol_version;
         case TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT:
+        case TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT_COMPACT:
             return a.body_meta.data.sequence_number == b.body_meta.data.sequence_number;
     }
 }
@@ -114,6 +115,60 @@ DESCRIBE(wickr_transport_packet_meta, "Wickr Transport Packet Metadata")
         wickr_buffer_destroy(&serialized_test_data_meta);
     }
     END_IT
+    
+    IT("can be serialized and restored in the compact format")
+    {
+        uint64_t test_sequence_numbers[] = { 0, 1, 127, 128, 300, 16383, 16384, UINT32_MAX, UINT64_MAX };
+        size_t expected_lengths[] = { 2, 2, 2, 3, 3, 3, 4, 6, 11 };
+        
+        for (int i = 0; i < sizeof(test_sequence_numbers) / sizeof(uint64_t); i++) {
+            wickr_transport_packet_meta_t compact_meta;
+            wickr_transport_packet_meta_initialize_compact_data(&compact_meta, test_sequence_numbers[i], TRANSPORT_MAC_TYPE_AUTH_CIPHER);
+            SHOULD_EQUAL(compact_meta.body_type, TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT_COMPACT);
+            SHOULD_EQUAL(compact_meta.mac_type, TRANSPORT_MAC_TYPE_AUTH_CIPHER);
+            
+            wickr_buffer_t *serialized = wickr_transport_packet_meta_serialize(&compact_meta);
+            SHOULD_NOT_BE_NULL(serialized);
+            SHOULD_EQUAL(serialized->length, expected_lengths[i]);
+            
+            wickr_transport_packet_meta_t restored_meta;
+            int processed_length = wickr_transport_packet_meta_initialize_buffer(&restored_meta, serialized);
+            SHOULD_EQUAL(processed_length, serialized->length);
+            SHOULD_BE_TRUE(wickr_transport_packet_meta_is_equal(restored_meta, compact_meta));
+            
+            /* A truncated sequence number can't be parsed */
+            if (serialized->length > 2) {
+                serialized->length--;
+                SHOULD_BE_TRUE(wickr_transport_packet_meta_initialize_buffer(&restored_meta, serialized) < 0);
+            }
+            
+            wickr_buffer_destroy(&serialized);
+        }
+    }
+    END_IT
+    
+    IT("will reject compact sequence numbers that are not minimally encoded")
+    {
+        wickr_transport_packet_meta_t restored_meta;
+        uint8_t header = (TRANSPORT_PAYLOAD_TYPE_CIPHERTEXT_COMPACT << 4) | TRANSPORT_MAC_TYPE_AUTH_CIPHER;
+        
+        /* 1 encoded with a padding byte */
+        uint8_t padded[] = { header, 0x81, 0x00 };
+        wickr_buffer_t padded_buffer = { sizeof(padded), padded };
+        SHOULD_BE_TRUE(wickr_transport_packet_meta_initialize_buffer(&restored_meta, &padded_buffer) < 0);
+        
+        /* A value that overflows 64 bits */
+        uint8_t overflow[] = { header, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x02 };
+        wickr_buffer_t overflow_buffer = { sizeof(overflow), overflow };
+        SHOULD_BE_TRUE(wickr_transport_packet_meta_initialize_buffer(&restored_meta, &overflow_buffer) < 0);
+        
+        /* The canonical encoding of 1 is accepted */
+        uint8_t canonical[] = { header, 0x01 };
+        wickr_buffer_t canonical_buffer = { sizeof(canonical), canonical };
+        SHOULD_EQUAL(wickr_transport_packet_meta_initialize_buffer(&restored_meta, &canonical_buffer), 2);
+        SHOULD_EQUAL(restored_meta.body_meta.data.sequence_number, 1);
+    }
+    END_IT
 }
 END_DESCRIBE
 
@@ -0,0 +1,262 @@
+
+#include "test_transport_pool.h"
+#include "transport_pool.h"
+#include "externs.h"
+#include <string.h>
+
+#define TEST_POOL_CONNECTION_COUNT 16
+#define TEST_POOL_MESSAGE_COUNT 50
+#define TEST_POOL_WORKER_COUNT 4
+
+/* Loopback routing between a client and a server pool */
+
+wickr_transport_pool_t *test_client_pool = NULL;
+wickr_transport_pool_t *test_server_pool = NULL;
+
+uint32_t test_server_rx_count[TEST_POOL_CONNECTION_COUNT];
+bool test_server_rx_in_order[TEST_POOL_CONNECTION_COUNT];
+uint32_t test_client_rx_count[TEST_POOL_CONNECTION_COUNT];
+
+static void test_pool_tx(const wickr_transport_pool_t *pool, uint64_t connection_id, wickr_buffer_t *data, void *user)
+{
+    wickr_transport_pool_t *destination = pool == test_client_pool ? test_server_pool : test_client_pool;
+    wickr_transport_pool_process_rx_buffer(destination, connection_id, data);
+    wickr_buffer_destroy(&data);
+}
+
+static void test_pool_rx(const wickr_transport_pool_t *pool, uint64_t connection_id, wickr_buffer_t *data, void *user)
+{
+    if (connection_id < TEST_POOL_CONNECTION_COUNT && data->length == sizeof(uint32_t)) {
+        uint32_t message_idx;
+        memcpy(&message_idx, data->bytes, sizeof(uint32_t));
+        
+        if (pool == test_server_pool) {
+            if (message_idx != test_server_rx_count[connection_id]) {
+                test_server_rx_in_order[connection_id] = false;
+            }
+            test_server_rx_count[connection_id]++;
+        } else {
+            test_client_rx_count[connection_id]++;
+        }
+    }
+    
+    wickr_buffer_destroy(&data);
+}
+
+static bool test_pool_validate_identity(const wickr_transport_pool_t *pool, uint64_t connection_id,
+                                        wickr_identity_chain_t *identity, void *user)
+{
+    wickr_identity_chain_destroy(&identity);
+    return true;
+}
+
+static void test_pool_reset_loopback_data()
+{
+    for (int i = 0; i < TEST_POOL_CONNECTION_COUNT; i++) {
+        test_server_rx_count[i] = 0;
+        test_server_rx_in_order[i] = true;
+        test_client_rx_count[i] = 0;
+    }
+}
+
+static void test_pool_settle()
+{
+    /* Work flows back and forth between the pools, so flush until neither has any left */
+    for (int i = 0; i < 100; i++) {
+        wickr_transport_pool_flush(test_client_pool);
+        wickr_transport_pool_flush(test_server_pool);
+        
+        if (wickr_transport_pool_get_stats(test_client_pool).pending_count == 0 &&
+            wickr_transport_pool_get_stats(test_server_pool).pending_count == 0) {
+            return;
+        }
+    }
+}
+
+DESCRIBE(wickr_transport_pool, "wickr_transport_pool")
+{
+    wickr_crypto_engine_t test_engine = wickr_crypto_engine_get_default();
+    
+    wickr_identity_chain_t *client_identity = createIdentityChain("client");
+    wickr_identity_chain_t *server_identity = createIdentityChain("server");
+    
+    wickr_transport_callbacks_t empty_callbacks = { NULL, NULL, NULL, NULL };
+    wickr_transport_pool_callbacks_t pool_callbacks = { test_pool_tx, test_pool_rx, NULL, test_pool_validate_identity };
+    
+    wickr_transport_ctx_t *client_template = wickr_transport_ctx_create(test_engine, wickr_identity_chain_copy(client_identity),
+                                                                        NULL, 0, empty_callbacks, NULL);
+    wickr_transport_ctx_t *server_template = wickr_transport_ctx_create(test_engine, wickr_identity_chain_copy(server_identity),
+                                                                        NULL, 0, empty_callbacks, NULL);
+    
+    IT("can't be created with invalid inputs")
+    {
+        SHOULD_BE_NULL(wickr_transport_pool_create(NULL, 1, pool_callbacks, NULL));
+        SHOULD_BE_NULL(wickr_transport_pool_create(client_template, 0, pool_callbacks, NULL));
+        SHOULD_BE_NULL(wickr_transport_pool_create(client_template, TRANSPORT_POOL_MAX_WORKERS + 1, pool_callbacks, NULL));
+    }
+    END_IT
+    
+    IT("can add and remove connections")
+    {
+        wickr_transport_pool_t *pool = wickr_transport_pool_create(client_template, 2, pool_callbacks, NULL);
+        SHOULD_NOT_BE_NULL(pool);
+        
+        SHOULD_BE_FALSE(wickr_transport_pool_add_connection(NULL, 1, NULL));
+        
+        /* Add enough connections to grow the connection table */
+        for (uint64_t i = 0; i < 200; i++) {
+            SHOULD_BE_TRUE(wickr_transport_pool_add_connection(pool, i * 7919, NULL));
+        }
+        
+        SHOULD_BE_FALSE(wickr_transport_pool_add_connection(pool, 7919, NULL));
+        SHOULD_EQUAL(wickr_transport_pool_get_stats(pool).connection_count, 200);
+        SHOULD_EQUAL(wickr_transport_pool_get_status(pool, 7919), TRANSPORT_STATUS_NONE);
+        
+        SHOULD_BE_TRUE(wickr_transport_pool_remove_connection(pool, 7919));
+        SHOULD_BE_FALSE(wickr_transport_pool_remove_connection(pool, 7919));
+        SHOULD_EQUAL(wickr_transport_pool_get_stats(pool).connection_count, 199);
+        SHOULD_EQUAL(wickr_transport_pool_get_status(pool, 7919), TRANSPORT_STATUS_ERROR);
+        
+        wickr_transport_pool_destroy(&pool);
+        SHOULD_BE_NULL(pool);
+    }
+    END_IT
+    
+    IT("will drop buffers for connections that are not in the pool")
+    {
+        wickr_transport_pool_t *pool = wickr_transport_pool_create(server_template, 1, pool_callbacks, NULL);
+        wickr_buffer_t *buffer = test_engine.wickr_crypto_engine_crypto_random(32);
+        
+        SHOULD_BE_FALSE(wickr_transport_pool_process_rx_buffer(pool, 42, buffer));
+        SHOULD_BE_FALSE(wickr_transport_pool_process_tx_buffer(pool, 42, buffer));
+        SHOULD_BE_FALSE(wickr_transport_pool_start(pool, 42));
+        SHOULD_EQUAL(wickr_transport_pool_get_stats(pool).rx_dropped, 1);
+        
+        wickr_buffer_destroy(&buffer);
+        wickr_transport_pool_destroy(&pool);
+    }
+    END_IT
+    
+    IT("can establish many connections over a loopback pair")
+    {
+        test_pool_reset_loopback_data();
+        
+        test_client_pool = wickr_transport_pool_create(client_template, TEST_POOL_WORKER_COUNT, pool_callbacks, NULL);
+        test_server_pool = wickr_transport_pool_create(server_template, TEST_POOL_WORKER_COUNT, pool_callbacks, NULL);
+        
+        SHOULD_NOT_BE_NULL(test_client_pool);
+        SHOULD_NOT_BE_NULL(test_server_pool);
+        
+        for (uint64_t i = 0; i < TEST_POOL_CONNECTION_COUNT; i++) {
+            SHOULD_BE_TRUE(wickr_transport_pool_add_connection(test_client_pool, i, wickr_identity_chain_copy(server_identity)));
+            SHOULD_BE_TRUE(wickr_transport_pool_add_connection(test_server_pool, i, NULL));
+        }
+        
+        for (uint64_t i = 0; i < TEST_POOL_CONNECTION_COUNT; i++) {
+            SHOULD_BE_TRUE(wickr_transport_pool_start(test_client_pool, i));
+        }
+        
+        test_pool_settle();
+        
+        for (uint64_t i = 0; i < TEST_POOL_CONNECTION_COUNT; i++) {
+            SHOULD_EQUAL(wickr_transport_pool_get_status(test_client_pool, i), TRANSPORT_STATUS_ACTIVE);
+            SHOULD_EQUAL(wickr_transport_pool_get_status(test_server_pool, i), TRANSPORT_STATUS_ACTIVE);
+        }
+        
+        wickr_transport_pool_stats_t server_stats = wickr_transport_pool_get_stats(test_server_pool);
+        SHOULD_EQUAL(server_stats.connection_count, TEST_POOL_CONNECTION_COUNT);
+        SHOULD_EQUAL(server_stats.active_count, TEST_POOL_CONNECTION_COUNT);
+        SHOULD_EQUAL(server_stats.handshakes_completed, TEST_POOL_CONNECTION_COUNT);
+        SHOULD_EQUAL(server_stats.errors, 0);
+    }
+    END_IT
+    
+    IT("will process packets for each connection in order")
+    {
+        /* Interleave packets across connections so that the workers have to pick them up in parallel */
+        for (uint32_t msg = 0; msg < TEST_POOL_MESSAGE_COUNT; msg++) {
+            for (uint64_t i = 0; i < TEST_POOL_CONNECTION_COUNT; i++) {
+                wickr_buffer_t buffer = { sizeof(uint32_t), (uint8_t *)&msg };
+                SHOULD_BE_TRUE(wickr_transport_pool_process_tx_buffer(test_client_pool, i, &buffer));
+            }
+        }
+        
+        test_pool_settle();
+        
+        for (uint64_t i = 0; i < TEST_POOL_CONNECTION_COUNT; i++) {
+            SHOULD_EQUAL(test_server_rx_count[i], TEST_POOL_MESSAGE_COUNT);
+            SHOULD_BE_TRUE(test_server_rx_in_order[i]);
+        }
+        
+        wickr_transport_pool_stats_t server_stats = wickr_transport_pool_get_stats(test_server_pool);
+        SHOULD_EQUAL(server_stats.rx_packets, TEST_POOL_CONNECTION_COUNT * TEST_POOL_MESSAGE_COUNT);
+        SHOULD_EQUAL(server_stats.rx_bytes, TEST_POOL_CONNECTION_COUNT * TEST_POOL_MESSAGE_COUNT * sizeof(uint32_t));
+        
+        wickr_transport_pool_stats_t client_stats = wickr_transport_pool_get_stats(test_client_pool);
+        SHOULD_BE_TRUE(client_stats.tx_packets > TEST_POOL_CONNECTION_COUNT * TEST_POOL_MESSAGE_COUNT);
+        SHOULD_EQUAL(client_stats.pending_count, 0);
+    }
+    END_IT
+    
+    IT("can remove connections with pending work")
+    {
+        uint64_t server_tx_before = wickr_transport_pool_get_stats(test_server_pool).tx_packets;
+        uint32_t client_rx_before = test_client_rx_count[0];
+        
+        for (uint32_t msg = 0; msg < TEST_POOL_MESSAGE_COUNT; msg++) {
+            wickr_buffer_t buffer = { sizeof(uint32_t), (uint8_t *)&msg };
+            wickr_transport_pool_process_tx_buffer(test_server_pool, 0, &buffer);
+        }
+        
+        SHOULD_BE_TRUE(wickr_transport_pool_remove_connection(test_server_pool, 0));
+        
+        /* Queued work is dropped, so only a job a worker had already started can still be pending */
+        SHOULD_BE_TRUE(wickr_transport_pool_get_stats(test_server_pool).pending_count <= 1);
+        
+        test_pool_settle();
+        
+        wickr_transport_pool_stats_t server_stats = wickr_transport_pool_get_stats(test_server_pool);
+        SHOULD_EQUAL(server_stats.connection_count, TEST_POOL_CONNECTION_COUNT - 1);
+        SHOULD_EQUAL(server_stats.pending_count, 0);
+        
+        /* Every packet the server sent for the connection before it was removed still reaches the client */
+        SHOULD_EQUAL(test_client_rx_count[0] - client_rx_before, server_stats.tx_packets - server_tx_before);
+    }
+    END_IT
+    
+    IT("can be destroyed")
+    {
+        wickr_transport_pool_destroy(&test_client_pool);
+        wickr_transport_pool_destroy(&test_server_pool);
+        SHOULD_BE_NULL(test_client_pool);
+        SHOULD_BE_NULL(test_server_pool);
+    }
+    END_IT
+    
+    IT("will fail connections if identities can't be verified")
+    {
+        wickr_transport_pool_callbacks_t no_verify_callbacks = { test_pool_tx, test_pool_rx, NULL, NULL };
+        
+        test_client_pool = wickr_transport_pool_create(client_template, 1, pool_callbacks, NULL);
+        test_server_pool = wickr_transport_pool_create(server_template, 1, no_verify_callbacks, NULL);
+        
+        SHOULD_BE_TRUE(wickr_transport_pool_add_connection(test_client_pool, 1, wickr_identity_chain_copy(server_identity)));
+        SHOULD_BE_TRUE(wickr_transport_pool_add_connection(test_server_pool, 1, NULL));
+        SHOULD_BE_TRUE(wickr_transport_pool_start(test_client_pool, 1));
+        
+        test_pool_settle();
+        
+        SHOULD_EQUAL(wickr_transport_pool_get_status(test_server_pool, 1), TRANSPORT_STATUS_ERROR);
+        SHOULD_EQUAL(wickr_transport_pool_get_stats(test_server_pool).errors, 1);
+        
+        wickr_transport_pool_destroy(&test_client_pool);
+        wickr_transport_pool_destroy(&test_server_pool);
+    }
+    END_IT
+    
+    wickr_transport_ctx_destroy(&client_template);
+    wickr_transport_ctx_destroy(&server_template);
+    wickr_identity_chain_destroy(&client_identity);
+    wickr_identity_chain_destroy(&server_identity);
+}
+END_DESCRIBE
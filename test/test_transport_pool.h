@@ -0,0 +1,8 @@
+#ifndef test_transport_pool_h
+#define test_transport_pool_h
+
+#include "cspec.h"
+
+DEFINE_DESCRIPTION(wickr_transport_pool)
+
+#endif /* test_transport_pool_h */
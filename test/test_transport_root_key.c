@@ -167,6 +167,28 @@ DESCRIBE(wickr_transport_root_key, "Wickr Transport Root Key")
     }
     END_IT
     
+    IT("can derive a resumption root key")
+    {
+        SHOULD_BE_NULL(wickr_transport_root_key_derive_resumption(NULL, &test_engine));
+        SHOULD_BE_NULL(wickr_transport_root_key_derive_resumption(test_root_key, NULL));
+
+        wickr_transport_root_key_t *resumption_key = wickr_transport_root_key_derive_resumption(test_root_key, &test_engine);
+        SHOULD_NOT_BE_NULL(resumption_key);
+        SHOULD_EQUAL(resumption_key->secret->length, test_root_key->secret->length);
+        SHOULD_BE_FALSE(wickr_buffer_is_equal(resumption_key->secret, test_root_key->secret, NULL));
+        SHOULD_EQUAL(memcmp(&test_root_key->cipher, &resumption_key->cipher, sizeof(wickr_cipher_t)), 0);
+        SHOULD_EQUAL(test_root_key->packets_per_evo_send, resumption_key->packets_per_evo_send);
+        SHOULD_EQUAL(test_root_key->packets_per_evo_recv, resumption_key->packets_per_evo_recv);
+
+        /* Derivation is deterministic */
+        wickr_transport_root_key_t *resumption_key_2 = wickr_transport_root_key_derive_resumption(test_root_key, &test_engine);
+        SHOULD_BE_TRUE(wickr_transport_root_key_is_equal(resumption_key, resumption_key_2));
+
+        wickr_transport_root_key_destroy(&resumption_key);
+        wickr_transport_root_key_destroy(&resumption_key_2);
+    }
+    END_IT
+
     IT("can be destroyed")
     {
         wickr_transport_root_key_destroy(&test_root_key);